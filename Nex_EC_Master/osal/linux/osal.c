@@ -8,6 +8,9 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <osal.h>
 
 #define USECS_PER_SEC     1000000
@@ -37,10 +40,10 @@ int osal_gettimeofday(struct timeval *tv, struct timezone *tz)
    return return_value;
 }
 
-ec_timet osal_current_time(void)
+nex_timet osal_current_time(void)
 {
    struct timeval current_time;
-   ec_timet return_value;
+   nex_timet return_value;
 
    osal_gettimeofday(&current_time, 0);
    return_value.sec = current_time.tv_sec;
@@ -48,7 +51,7 @@ ec_timet osal_current_time(void)
    return return_value;
 }
 
-void osal_time_diff(ec_timet *start, ec_timet *end, ec_timet *diff)
+void osal_time_diff(nex_timet *start, nex_timet *end, nex_timet *diff)
 {
    if (end->usec < start->usec) {
       diff->sec = end->sec - start->sec - 1;
@@ -142,3 +145,92 @@ int osal_thread_create_rt(void *thandle, int stacksize, void *func, void *param)
 
    return 1;
 }
+
+/* POSIX shared memory names start with a slash */
+static void osal_shm_name(osal_shmt *shm, const char *name)
+{
+   if (name[0] == '/')
+   {
+      strncpy(shm->name, name, sizeof(shm->name) - 1);
+   }
+   else
+   {
+      shm->name[0] = '/';
+      strncpy(&shm->name[1], name, sizeof(shm->name) - 2);
+   }
+}
+
+void *osal_shm_create(osal_shmt *shm, const char *name, uint32 size)
+{
+   void *addr;
+   int fd;
+
+   memset(shm, 0, sizeof(*shm));
+   osal_shm_name(shm, name);
+   fd = shm_open(shm->name, O_CREAT | O_RDWR, 0666);
+   if (fd < 0)
+   {
+      return NULL;
+   }
+   if (ftruncate(fd, size) < 0)
+   {
+      close(fd);
+      shm_unlink(shm->name);
+      return NULL;
+   }
+   addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   close(fd);
+   if (addr == MAP_FAILED)
+   {
+      shm_unlink(shm->name);
+      return NULL;
+   }
+   shm->addr = addr;
+   shm->size = size;
+   shm->owner = TRUE;
+   return addr;
+}
+
+void *osal_shm_open(osal_shmt *shm, const char *name)
+{
+   struct stat st;
+   void *addr;
+   int fd;
+
+   memset(shm, 0, sizeof(*shm));
+   osal_shm_name(shm, name);
+   fd = shm_open(shm->name, O_RDWR, 0);
+   if (fd < 0)
+   {
+      return NULL;
+   }
+   /* map all of it, the creator decided the size */
+   if ((fstat(fd, &st) < 0) || (st.st_size <= 0))
+   {
+      close(fd);
+      return NULL;
+   }
+   addr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   close(fd);
+   if (addr == MAP_FAILED)
+   {
+      return NULL;
+   }
+   shm->addr = addr;
+   shm->size = (uint32)st.st_size;
+   return addr;
+}
+
+void osal_shm_close(osal_shmt *shm)
+{
+   if (shm->addr)
+   {
+      munmap(shm->addr, shm->size);
+      shm->addr = NULL;
+   }
+   if (shm->owner)
+   {
+      shm_unlink(shm->name);
+      shm->owner = FALSE;
+   }
+}
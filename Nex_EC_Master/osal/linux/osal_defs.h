@@ -21,6 +21,8 @@ extern "C"
 #define OSAL_THREAD_HANDLE pthread_t *
 #define OSAL_THREAD_FUNC void
 #define OSAL_THREAD_FUNC_RT void
+/* full memory barrier, orders accesses to memory shared with other processes */
+#define OSAL_MB() __sync_synchronize()
 
 #ifdef __cplusplus
 }
@@ -40,6 +40,16 @@ typedef struct osal_timer
     nex_timet stop_time;
 } osal_timert;
 
+/** shared memory between processes, see osal_shm_create */
+typedef struct osal_shm
+{
+    void *addr;         /*< Mapped address */
+    uint32 size;        /*< Mapped size in bytes */
+    void *handle;       /*< OS handle of the mapping */
+    boolean owner;      /*< Created by this process, removed by osal_shm_close */
+    char name[64];
+} osal_shmt;
+
 void osal_timer_start(osal_timert * self, uint32 timeout_us);
 boolean osal_timer_is_expired(osal_timert * self);
 int osal_usleep(uint32 usec);
@@ -47,6 +57,10 @@ nex_timet osal_current_time(void);
 void osal_time_diff(nex_timet *start, nex_timet *end, nex_timet *diff);
 int osal_thread_create(void *thandle, int stacksize, void *func, void *param);
 int osal_thread_create_rt(void *thandle, int stacksize, void *func, void *param);
+/* shared memory, available on hosted systems only */
+void *osal_shm_create(osal_shmt *shm, const char *name, uint32 size);
+void *osal_shm_open(osal_shmt *shm, const char *name);
+void osal_shm_close(osal_shmt *shm);
 
 #ifdef __cplusplus
 }
@@ -4,22 +4,25 @@
  */
 
 #include <winsock2.h>
+#include <string.h>
 #include <osal.h>
 #include "osal_win32.h"
 
-static int64_t sysfrequency;
-static double qpc2usec;
+/* set once by the first caller, qpc2usec is valid before sysfrequency is set */
+static volatile int64_t sysfrequency;
+static volatile double qpc2usec;
 
 #define USECS_PER_SEC     1000000
 
 int osal_gettimeofday (struct timeval *tv, struct timezone *tz)
 {
-   int64_t wintime, usecs;
+   int64_t wintime, usecs, freq;
    if(!sysfrequency)
    {
       timeBeginPeriod(1);
-      QueryPerformanceFrequency((LARGE_INTEGER *)&sysfrequency);
-      qpc2usec = 1000000.0 / sysfrequency;
+      QueryPerformanceFrequency((LARGE_INTEGER *)&freq);
+      qpc2usec = 1000000.0 / freq;
+      sysfrequency = freq;
    }
    QueryPerformanceCounter((LARGE_INTEGER *)&wintime);
    usecs = (int64_t)((double)wintime * qpc2usec);
@@ -123,3 +126,63 @@ int osal_thread_create_rt(void **thandle, int stacksize, void *func, void *param
    }
    return ret;
 }
+
+void *osal_shm_create(osal_shmt *shm, const char *name, uint32 size)
+{
+   memset(shm, 0, sizeof(*shm));
+   shm->handle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, size, name);
+   if(!shm->handle)
+   {
+      return NULL;
+   }
+   shm->addr = MapViewOfFile(shm->handle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+   if(!shm->addr)
+   {
+      CloseHandle(shm->handle);
+      shm->handle = NULL;
+      return NULL;
+   }
+   shm->size = size;
+   shm->owner = TRUE;
+   strncpy(shm->name, name, sizeof(shm->name) - 1);
+   return shm->addr;
+}
+
+void *osal_shm_open(osal_shmt *shm, const char *name)
+{
+   MEMORY_BASIC_INFORMATION info;
+
+   memset(shm, 0, sizeof(*shm));
+   shm->handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+   if(!shm->handle)
+   {
+      return NULL;
+   }
+   /* map all of it, the creator decided the size */
+   shm->addr = MapViewOfFile(shm->handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+   if(!shm->addr)
+   {
+      CloseHandle(shm->handle);
+      shm->handle = NULL;
+      return NULL;
+   }
+   VirtualQuery(shm->addr, &info, sizeof(info));
+   shm->size = (uint32)info.RegionSize;
+   strncpy(shm->name, name, sizeof(shm->name) - 1);
+   return shm->addr;
+}
+
+void osal_shm_close(osal_shmt *shm)
+{
+   /* the mapping is removed by Windows when the last handle is closed */
+   if(shm->addr)
+   {
+      UnmapViewOfFile(shm->addr);
+      shm->addr = NULL;
+   }
+   if(shm->handle)
+   {
+      CloseHandle(shm->handle);
+      shm->handle = NULL;
+   }
+}
@@ -20,6 +20,8 @@ extern "C"
 #define OSAL_THREAD_HANDLE HANDLE
 #define OSAL_THREAD_FUNC void
 #define OSAL_THREAD_FUNC_RT void
+/* full memory barrier, orders accesses to memory shared with other processes */
+#define OSAL_MB() MemoryBarrier()
 
 #ifdef __cplusplus
 }
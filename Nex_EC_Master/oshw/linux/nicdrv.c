@@ -72,12 +72,12 @@ const uint16 secMAC[3] = { 0x0404, 0x0404, 0x0404 };
 /** second MAC word is used for identification */
 #define RX_SEC secMAC[1]
 
-static void ecx_clear_rxbufstat(int *rxbufstat)
+static void nexx_clear_rxbufstat(int *rxbufstat)
 {
    int i;
-   for(i = 0; i < EC_MAXBUF; i++)
+   for(i = 0; i < NEX_MAXBUF; i++)
    {
-      rxbufstat[i] = EC_BUF_EMPTY;
+      rxbufstat[i] = NEX_BUF_EMPTY;
    }
 }
 
@@ -87,7 +87,7 @@ static void ecx_clear_rxbufstat(int *rxbufstat)
  * @param[in] secondary   = if >0 then use secondary stack instead of primary
  * @return >0 if succeeded
  */
-int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
+int nexx_setupnic(nexx_portt *port, const char *ifname, int secondary)
 {
    int i;
    int r, rval, ifindex;
@@ -114,7 +114,7 @@ int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
          port->redport->stack.rxbuf       = &(port->redport->rxbuf);
          port->redport->stack.rxbufstat   = &(port->redport->rxbufstat);
          port->redport->stack.rxsa        = &(port->redport->rxsa);
-         ecx_clear_rxbufstat(&(port->redport->rxbufstat[0]));
+         nexx_clear_rxbufstat(&(port->redport->rxbufstat[0]));
       }
       else
       {
@@ -139,7 +139,7 @@ int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
       port->stack.rxbuf       = &(port->rxbuf);
       port->stack.rxbufstat   = &(port->rxbufstat);
       port->stack.rxsa        = &(port->rxsa);
-      ecx_clear_rxbufstat(&(port->rxbufstat[0]));
+      nexx_clear_rxbufstat(&(port->rxbufstat[0]));
       psock = &(port->sockhandle);
    }
    /* we use RAW packet socket, with packet type ETH_P_ECAT */
@@ -168,12 +168,12 @@ int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
    sll.sll_protocol = htons(ETH_P_ECAT);
    r = bind(*psock, (struct sockaddr *)&sll, sizeof(sll));
    /* setup ethernet headers in tx buffers so we don't have to repeat it */
-   for (i = 0; i < EC_MAXBUF; i++)
+   for (i = 0; i < NEX_MAXBUF; i++)
    {
-      ec_setupheader(&(port->txbuf[i]));
-      port->rxbufstat[i] = EC_BUF_EMPTY;
+      nex_setupheader(&(port->txbuf[i]));
+      port->rxbufstat[i] = NEX_BUF_EMPTY;
    }
-   ec_setupheader(&(port->txbuf2));
+   nex_setupheader(&(port->txbuf2));
    if (r == 0) rval = 1;
 
    return rval;
@@ -183,7 +183,7 @@ int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
  * @param[in] port        = port context struct
  * @return 0
  */
-int ecx_closenic(ecx_portt *port)
+int nexx_closenic(nexx_portt *port)
 {
    if (port->sockhandle >= 0)
       close(port->sockhandle);
@@ -198,9 +198,9 @@ int ecx_closenic(ecx_portt *port)
  * Ethertype is always ETH_P_ECAT.
  * @param[out] p = buffer
  */
-void ec_setupheader(void *p)
+void nex_setupheader(void *p)
 {
-   ec_etherheadert *bp;
+   nex_etherheadert *bp;
    bp = p;
    bp->da0 = htons(0xffff);
    bp->da1 = htons(0xffff);
@@ -215,7 +215,7 @@ void ec_setupheader(void *p)
  * @param[in] port        = port context struct
  * @return new index.
  */
-int ecx_getindex(ecx_portt *port)
+int nexx_getindex(nexx_portt *port)
 {
    int idx;
    int cnt;
@@ -224,24 +224,33 @@ int ecx_getindex(ecx_portt *port)
 
    idx = port->lastidx + 1;
    /* index can't be larger than buffer array */
-   if (idx >= EC_MAXBUF)
+   if (idx >= NEX_MAXBUF)
    {
       idx = 0;
    }
    cnt = 0;
-   /* try to find unused index */
-   while ((port->rxbufstat[idx] != EC_BUF_EMPTY) && (cnt < EC_MAXBUF))
+   /* try to find unused index, the indexes of group partitions are never used */
+   while (((port->rxbufstat[idx] != NEX_BUF_EMPTY) || port->idxreserved[idx]) && (cnt < NEX_MAXBUF))
    {
       idx++;
       cnt++;
-      if (idx >= EC_MAXBUF)
+      if (idx >= NEX_MAXBUF)
       {
          idx = 0;
       }
    }
-   port->rxbufstat[idx] = EC_BUF_ALLOC;
+   /* all busy, reuse an index but not one of a group partition */
+   while (port->idxreserved[idx])
+   {
+      idx++;
+      if (idx >= NEX_MAXBUF)
+      {
+         idx = 0;
+      }
+   }
+   port->rxbufstat[idx] = NEX_BUF_ALLOC;
    if (port->redstate != ECT_RED_NONE)
-      port->redport->rxbufstat[idx] = EC_BUF_ALLOC;
+      port->redport->rxbufstat[idx] = NEX_BUF_ALLOC;
    port->lastidx = idx;
 
    pthread_mutex_unlock( &(port->getindex_mutex) );
@@ -254,7 +263,7 @@ int ecx_getindex(ecx_portt *port)
  * @param[in] idx      = index in buffer array
  * @param[in] bufstat  = status to set
  */
-void ecx_setbufstat(ecx_portt *port, int idx, int bufstat)
+void nexx_setbufstat(nexx_portt *port, int idx, int bufstat)
 {
    port->rxbufstat[idx] = bufstat;
    if (port->redstate != ECT_RED_NONE)
@@ -267,10 +276,10 @@ void ecx_setbufstat(ecx_portt *port, int idx, int bufstat)
  * @param[in] stacknumber  = 0=Primary 1=Secondary stack
  * @return socket send result
  */
-int ecx_outframe(ecx_portt *port, int idx, int stacknumber)
+int nexx_outframe(nexx_portt *port, int idx, int stacknumber)
 {
    int lp, rval;
-   ec_stackT *stack;
+   nex_stackT *stack;
 
    if (!stacknumber)
    {
@@ -281,11 +290,11 @@ int ecx_outframe(ecx_portt *port, int idx, int stacknumber)
       stack = &(port->redport->stack);
    }
    lp = (*stack->txbuflength)[idx];
-   (*stack->rxbufstat)[idx] = EC_BUF_TX;
+   (*stack->rxbufstat)[idx] = NEX_BUF_TX;
    rval = send(*stack->sock, (*stack->txbuf)[idx], lp, 0);
    if (rval == -1)
    {
-      (*stack->rxbufstat)[idx] = EC_BUF_EMPTY;
+      (*stack->rxbufstat)[idx] = NEX_BUF_EMPTY;
    }
 
    return rval;
@@ -296,32 +305,32 @@ int ecx_outframe(ecx_portt *port, int idx, int stacknumber)
  * @param[in] idx = index in tx buffer array
  * @return socket send result
  */
-int ecx_outframe_red(ecx_portt *port, int idx)
+int nexx_outframe_red(nexx_portt *port, int idx)
 {
-   ec_comt *datagramP;
-   ec_etherheadert *ehp;
+   nex_comt *datagramP;
+   nex_etherheadert *ehp;
    int rval;
 
-   ehp = (ec_etherheadert *)&(port->txbuf[idx]);
+   ehp = (nex_etherheadert *)&(port->txbuf[idx]);
    /* rewrite MAC source address 1 to primary */
    ehp->sa1 = htons(priMAC[1]);
    /* transmit over primary socket*/
-   rval = ecx_outframe(port, idx, 0);
+   rval = nexx_outframe(port, idx, 0);
    if (port->redstate != ECT_RED_NONE)
    {
       pthread_mutex_lock( &(port->tx_mutex) );
-      ehp = (ec_etherheadert *)&(port->txbuf2);
+      ehp = (nex_etherheadert *)&(port->txbuf2);
       /* use dummy frame for secondary socket transmit (BRD) */
-      datagramP = (ec_comt*)&(port->txbuf2[ETH_HEADERSIZE]);
+      datagramP = (nex_comt*)&(port->txbuf2[ETH_HEADERSIZE]);
       /* write index to frame */
       datagramP->index = idx;
       /* rewrite MAC source address 1 to secondary */
       ehp->sa1 = htons(secMAC[1]);
       /* transmit over secondary socket */
-      port->redport->rxbufstat[idx] = EC_BUF_TX;
+      port->redport->rxbufstat[idx] = NEX_BUF_TX;
       if (send(port->redport->sockhandle, &(port->txbuf2), port->txbuflength2 , 0) == -1)
       {
-         port->redport->rxbufstat[idx] = EC_BUF_EMPTY;
+         port->redport->rxbufstat[idx] = NEX_BUF_EMPTY;
       }
       pthread_mutex_unlock( &(port->tx_mutex) );
    }
@@ -334,10 +343,10 @@ int ecx_outframe_red(ecx_portt *port, int idx)
  * @param[in] stacknumber = 0=primary 1=secondary stack
  * @return >0 if frame is available and read
  */
-static int ecx_recvpkt(ecx_portt *port, int stacknumber)
+static int nexx_recvpkt(nexx_portt *port, int stacknumber)
 {
    int lp, bytesrx;
-   ec_stackT *stack;
+   nex_stackT *stack;
 
    if (!stacknumber)
    {
@@ -358,8 +367,8 @@ static int ecx_recvpkt(ecx_portt *port, int stacknumber)
  * read frame with transmitted frame. To compensate for received frames that
  * are out-of-order all frames are stored in their respective indexed buffer.
  * If a frame was placed in the buffer previously, the function retreives it
- * from that buffer index without calling ec_recvpkt. If the requested index
- * is not already in the buffer it calls ec_recvpkt to fetch it. There are
+ * from that buffer index without calling nex_recvpkt. If the requested index
+ * is not already in the buffer it calls nex_recvpkt to fetch it. There are
  * three options now, 1 no frame read, so exit. 2 frame read but other
  * than requested index, store in buffer and exit. 3 frame read with matching
  * index, store in buffer, set completed flag in buffer status and exit.
@@ -368,17 +377,17 @@ static int ecx_recvpkt(ecx_portt *port, int stacknumber)
  * @param[in] idx         = requested index of frame
  * @param[in] stacknumber = 0=primary 1=secondary stack
  * @return Workcounter if a frame is found with corresponding index, otherwise
- * EC_NOFRAME or EC_OTHERFRAME.
+ * NEX_NOFRAME or NEX_OTHERFRAME.
  */
-int ecx_inframe(ecx_portt *port, int idx, int stacknumber)
+int nexx_inframe(nexx_portt *port, int idx, int stacknumber)
 {
    uint16  l;
    int     rval;
    int     idxf;
-   ec_etherheadert *ehp;
-   ec_comt *ecp;
-   ec_stackT *stack;
-   ec_bufT *rxbuf;
+   nex_etherheadert *ehp;
+   nex_comt *ecp;
+   nex_stackT *stack;
+   nex_bufT *rxbuf;
 
    if (!stacknumber)
    {
@@ -388,29 +397,30 @@ int ecx_inframe(ecx_portt *port, int idx, int stacknumber)
    {
       stack = &(port->redport->stack);
    }
-   rval = EC_NOFRAME;
+   rval = NEX_NOFRAME;
    rxbuf = &(*stack->rxbuf)[idx];
    /* check if requested index is already in buffer ? */
-   if ((idx < EC_MAXBUF) && ((*stack->rxbufstat)[idx] == EC_BUF_RCVD))
+   if ((idx < NEX_MAXBUF) && ((*stack->rxbufstat)[idx] == NEX_BUF_RCVD))
    {
       l = (*rxbuf)[0] + ((uint16)((*rxbuf)[1] & 0x0f) << 8);
       /* return WKC */
       rval = ((*rxbuf)[l] + ((uint16)(*rxbuf)[l + 1] << 8));
       /* mark as completed */
-      (*stack->rxbufstat)[idx] = EC_BUF_COMPLETE;
+      (*stack->rxbufstat)[idx] = NEX_BUF_COMPLETE;
    }
-   else
+   /* another thread reads the socket and puts the frame in its buffer by index,
+    * do not wait for it but check the buffer again on the next call */
+   else if (pthread_mutex_trylock(&(port->rx_mutex)) == 0)
    {
-      pthread_mutex_lock(&(port->rx_mutex));
       /* non blocking call to retrieve frame from socket */
-      if (ecx_recvpkt(port, stacknumber))
+      if (nexx_recvpkt(port, stacknumber))
       {
-         rval = EC_OTHERFRAME;
-         ehp =(ec_etherheadert*)(stack->tempbuf);
+         rval = NEX_OTHERFRAME;
+         ehp =(nex_etherheadert*)(stack->tempbuf);
          /* check if it is an EtherCAT frame */
          if (ehp->etype == htons(ETH_P_ECAT))
          {
-            ecp =(ec_comt*)(&(*stack->tempbuf)[ETH_HEADERSIZE]);
+            ecp =(nex_comt*)(&(*stack->tempbuf)[ETH_HEADERSIZE]);
             l = etohs(ecp->elength) & 0x0fff;
             idxf = ecp->index;
             /* found index equals reqested index ? */
@@ -421,21 +431,23 @@ int ecx_inframe(ecx_portt *port, int idx, int stacknumber)
                /* return WKC */
                rval = ((*rxbuf)[l] + ((uint16)((*rxbuf)[l + 1]) << 8));
                /* mark as completed */
-               (*stack->rxbufstat)[idx] = EC_BUF_COMPLETE;
+               (*stack->rxbufstat)[idx] = NEX_BUF_COMPLETE;
                /* store MAC source word 1 for redundant routing info */
                (*stack->rxsa)[idx] = ntohs(ehp->sa1);
             }
             else
             {
                /* check if index exist and someone is waiting for it */
-               if (idxf < EC_MAXBUF && (*stack->rxbufstat)[idxf] == EC_BUF_TX)
+               if (idxf < NEX_MAXBUF && (*stack->rxbufstat)[idxf] == NEX_BUF_TX)
                {
                   rxbuf = &(*stack->rxbuf)[idxf];
                   /* put it in the buffer array (strip ethernet header) */
                   memcpy(rxbuf, &(*stack->tempbuf)[ETH_HEADERSIZE], (*stack->txbuflength)[idxf] - ETH_HEADERSIZE);
-                  /* mark as received */
-                  (*stack->rxbufstat)[idxf] = EC_BUF_RCVD;
                   (*stack->rxsa)[idxf] = ntohs(ehp->sa1);
+                  /* the thread waiting for it reads the buffer without the lock */
+                  OSAL_MB();
+                  /* mark as received */
+                  (*stack->rxbufstat)[idxf] = NEX_BUF_RCVD;
                }
                else
                {
@@ -462,13 +474,13 @@ int ecx_inframe(ecx_portt *port, int idx, int stacknumber)
  * @param[in] idx = requested index of frame
  * @param[in] timer = absolute timeout time
  * @return Workcounter if a frame is found with corresponding index, otherwise
- * EC_NOFRAME.
+ * NEX_NOFRAME.
  */
-static int ecx_waitinframe_red(ecx_portt *port, int idx, osal_timert *timer)
+static int nexx_waitinframe_red(nexx_portt *port, int idx, osal_timert *timer)
 {
    osal_timert timer2;
-   int wkc  = EC_NOFRAME;
-   int wkc2 = EC_NOFRAME;
+   int wkc  = NEX_NOFRAME;
+   int wkc2 = NEX_NOFRAME;
    int primrx, secrx;
 
    /* if not in redundant mode then always assume secondary is OK */
@@ -477,26 +489,26 @@ static int ecx_waitinframe_red(ecx_portt *port, int idx, osal_timert *timer)
    do
    {
       /* only read frame if not already in */
-      if (wkc <= EC_NOFRAME)
-         wkc  = ecx_inframe(port, idx, 0);
+      if (wkc <= NEX_NOFRAME)
+         wkc  = nexx_inframe(port, idx, 0);
       /* only try secondary if in redundant mode */
       if (port->redstate != ECT_RED_NONE)
       {
          /* only read frame if not already in */
-         if (wkc2 <= EC_NOFRAME)
-            wkc2 = ecx_inframe(port, idx, 1);
+         if (wkc2 <= NEX_NOFRAME)
+            wkc2 = nexx_inframe(port, idx, 1);
       }
    /* wait for both frames to arrive or timeout */
-   } while (((wkc <= EC_NOFRAME) || (wkc2 <= EC_NOFRAME)) && !osal_timer_is_expired(timer));
+   } while (((wkc <= NEX_NOFRAME) || (wkc2 <= NEX_NOFRAME)) && !osal_timer_is_expired(timer));
    /* only do redundant functions when in redundant mode */
    if (port->redstate != ECT_RED_NONE)
    {
       /* primrx if the reveived MAC source on primary socket */
       primrx = 0;
-      if (wkc > EC_NOFRAME) primrx = port->rxsa[idx];
+      if (wkc > NEX_NOFRAME) primrx = port->rxsa[idx];
       /* secrx if the reveived MAC source on psecondary socket */
       secrx = 0;
-      if (wkc2 > EC_NOFRAME) secrx = port->redport->rxsa[idx];
+      if (wkc2 > NEX_NOFRAME) secrx = port->redport->rxsa[idx];
 
       /* primary socket got secondary frame and secondary socket got primary frame */
       /* normal situation in redundant mode */
@@ -519,15 +531,15 @@ static int ecx_waitinframe_red(ecx_portt *port, int idx, osal_timert *timer)
             /* copy primary rx to tx buffer */
             memcpy(&(port->txbuf[idx][ETH_HEADERSIZE]), &(port->rxbuf[idx]), port->txbuflength[idx] - ETH_HEADERSIZE);
          }
-         osal_timer_start (&timer2, EC_TIMEOUTRET);
+         osal_timer_start (&timer2, NEX_TIMEOUTRET);
          /* resend secondary tx */
-         ecx_outframe(port, idx, 1);
+         nexx_outframe(port, idx, 1);
          do
          {
             /* retrieve frame */
-            wkc2 = ecx_inframe(port, idx, 1);
-         } while ((wkc2 <= EC_NOFRAME) && !osal_timer_is_expired(&timer2));
-         if (wkc2 > EC_NOFRAME)
+            wkc2 = nexx_inframe(port, idx, 1);
+         } while ((wkc2 <= NEX_NOFRAME) && !osal_timer_is_expired(&timer2));
+         if (wkc2 > NEX_NOFRAME)
          {
             /* copy secondary result to primary rx buffer */
             memcpy(&(port->rxbuf[idx]), &(port->redport->rxbuf[idx]), port->txbuflength[idx] - ETH_HEADERSIZE);
@@ -536,28 +548,28 @@ static int ecx_waitinframe_red(ecx_portt *port, int idx, osal_timert *timer)
       }
    }
 
-   /* return WKC or EC_NOFRAME */
+   /* return WKC or NEX_NOFRAME */
    return wkc;
 }
 
-/** Blocking receive frame function. Calls ec_waitinframe_red().
+/** Blocking receive frame function. Calls nex_waitinframe_red().
  * @param[in] port        = port context struct
  * @param[in] idx       = requested index of frame
  * @param[in] timeout   = timeout in us
  * @return Workcounter if a frame is found with corresponding index, otherwise
- * EC_NOFRAME.
+ * NEX_NOFRAME.
  */
-int ecx_waitinframe(ecx_portt *port, int idx, int timeout)
+int nexx_waitinframe(nexx_portt *port, int idx, int timeout)
 {
    int wkc;
    osal_timert timer;
 
    osal_timer_start (&timer, timeout);
-   wkc = ecx_waitinframe_red(port, idx, &timer);
+   wkc = nexx_waitinframe_red(port, idx, &timer);
    /* if nothing received, clear buffer index status so it can be used again */
-   if (wkc <= EC_NOFRAME)
+   if (wkc <= NEX_NOFRAME)
    {
-      ecx_setbufstat(port, idx, EC_BUF_EMPTY);
+      nexx_setbufstat(port, idx, NEX_BUF_EMPTY);
    }
 
    return wkc;
@@ -568,88 +580,88 @@ int ecx_waitinframe(ecx_portt *port, int idx, int timeout)
  * for an answer and returns the workcounter. The function retries if time is
  * left and the result is WKC=0 or no frame received.
  *
- * The function calls ec_outframe_red() and ec_waitinframe_red().
+ * The function calls nex_outframe_red() and nex_waitinframe_red().
  *
  * @param[in] port        = port context struct
  * @param[in] idx      = index of frame
  * @param[in] timeout  = timeout in us
- * @return Workcounter or EC_NOFRAME
+ * @return Workcounter or NEX_NOFRAME
  */
-int ecx_srconfirm(ecx_portt *port, int idx, int timeout)
+int nexx_srconfirm(nexx_portt *port, int idx, int timeout)
 {
-   int wkc = EC_NOFRAME;
+   int wkc = NEX_NOFRAME;
    osal_timert timer1, timer2;
 
    osal_timer_start (&timer1, timeout);
    do
    {
       /* tx frame on primary and if in redundant mode a dummy on secondary */
-      ecx_outframe_red(port, idx);
-      if (timeout < EC_TIMEOUTRET)
+      nexx_outframe_red(port, idx);
+      if (timeout < NEX_TIMEOUTRET)
       {
          osal_timer_start (&timer2, timeout);
       }
       else
       {
          /* normally use partial timout for rx */
-         osal_timer_start (&timer2, EC_TIMEOUTRET);
+         osal_timer_start (&timer2, NEX_TIMEOUTRET);
       }
       /* get frame from primary or if in redundant mode possibly from secondary */
-      wkc = ecx_waitinframe_red(port, idx, &timer2);
+      wkc = nexx_waitinframe_red(port, idx, &timer2);
    /* wait for answer with WKC>=0 or otherwise retry until timeout */
-   } while ((wkc <= EC_NOFRAME) && !osal_timer_is_expired (&timer1));
+   } while ((wkc <= NEX_NOFRAME) && !osal_timer_is_expired (&timer1));
    /* if nothing received, clear buffer index status so it can be used again */
-   if (wkc <= EC_NOFRAME)
+   if (wkc <= NEX_NOFRAME)
    {
-      ecx_setbufstat(port, idx, EC_BUF_EMPTY);
+      nexx_setbufstat(port, idx, NEX_BUF_EMPTY);
    }
 
    return wkc;
 }
 
-#ifdef EC_VER1
-int ec_setupnic(const char *ifname, int secondary)
+#ifdef NEX_VER1
+int nex_setupnic(const char *ifname, int secondary)
 {
-   return ecx_setupnic(&ecx_port, ifname, secondary);
+   return nexx_setupnic(&nexx_port, ifname, secondary);
 }
 
-int ec_closenic(void)
+int nex_closenic(void)
 {
-   return ecx_closenic(&ecx_port);
+   return nexx_closenic(&nexx_port);
 }
 
-int ec_getindex(void)
+int nex_getindex(void)
 {
-   return ecx_getindex(&ecx_port);
+   return nexx_getindex(&nexx_port);
 }
 
-void ec_setbufstat(int idx, int bufstat)
+void nex_setbufstat(int idx, int bufstat)
 {
-   ecx_setbufstat(&ecx_port, idx, bufstat);
+   nexx_setbufstat(&nexx_port, idx, bufstat);
 }
 
-int ec_outframe(int idx, int stacknumber)
+int nex_outframe(int idx, int stacknumber)
 {
-   return ecx_outframe(&ecx_port, idx, stacknumber);
+   return nexx_outframe(&nexx_port, idx, stacknumber);
 }
 
-int ec_outframe_red(int idx)
+int nex_outframe_red(int idx)
 {
-   return ecx_outframe_red(&ecx_port, idx);
+   return nexx_outframe_red(&nexx_port, idx);
 }
 
-int ec_inframe(int idx, int stacknumber)
+int nex_inframe(int idx, int stacknumber)
 {
-   return ecx_inframe(&ecx_port, idx, stacknumber);
+   return nexx_inframe(&nexx_port, idx, stacknumber);
 }
 
-int ec_waitinframe(int idx, int timeout)
+int nex_waitinframe(int idx, int timeout)
 {
-   return ecx_waitinframe(&ecx_port, idx, timeout);
+   return nexx_waitinframe(&nexx_port, idx, timeout);
 }
 
-int ec_srconfirm(int idx, int timeout)
+int nex_srconfirm(int idx, int timeout)
 {
-   return ecx_srconfirm(&ecx_port, idx, timeout);
+   return nexx_srconfirm(&nexx_port, idx, timeout);
 }
 #endif
@@ -24,94 +24,97 @@ typedef struct
    /** socket connection used */
    int         *sock;
    /** tx buffer */
-   ec_bufT     (*txbuf)[EC_MAXBUF];
+   nex_bufT     (*txbuf)[NEX_MAXBUF];
    /** tx buffer lengths */
-   int         (*txbuflength)[EC_MAXBUF];
+   int         (*txbuflength)[NEX_MAXBUF];
    /** temporary receive buffer */
-   ec_bufT     *tempbuf;
+   nex_bufT     *tempbuf;
    /** rx buffers */
-   ec_bufT     (*rxbuf)[EC_MAXBUF];
+   nex_bufT     (*rxbuf)[NEX_MAXBUF];
    /** rx buffer status fields */
-   int         (*rxbufstat)[EC_MAXBUF];
+   int         (*rxbufstat)[NEX_MAXBUF];
    /** received MAC source address (middle word) */
-   int         (*rxsa)[EC_MAXBUF];
-} ec_stackT;
+   int         (*rxsa)[NEX_MAXBUF];
+} nex_stackT;
 
 /** pointer structure to buffers for redundant port */
 typedef struct
 {
-   ec_stackT   stack;
+   nex_stackT   stack;
    int         sockhandle;
    /** rx buffers */
-   ec_bufT rxbuf[EC_MAXBUF];
+   nex_bufT rxbuf[NEX_MAXBUF];
    /** rx buffer status */
-   int rxbufstat[EC_MAXBUF];
+   int rxbufstat[NEX_MAXBUF];
    /** rx MAC source address */
-   int rxsa[EC_MAXBUF];
+   int rxsa[NEX_MAXBUF];
    /** temporary rx buffer */
-   ec_bufT tempinbuf;
-} ecx_redportt;
+   nex_bufT tempinbuf;
+} nexx_redportt;
 
 /** pointer structure to buffers, vars and mutexes for port instantiation */
 typedef struct
 {
-   ec_stackT   stack;
+   nex_stackT   stack;
    int         sockhandle;
    /** rx buffers */
-   ec_bufT rxbuf[EC_MAXBUF];
+   nex_bufT rxbuf[NEX_MAXBUF];
    /** rx buffer status */
-   int rxbufstat[EC_MAXBUF];
+   int rxbufstat[NEX_MAXBUF];
    /** rx MAC source address */
-   int rxsa[EC_MAXBUF];
+   int rxsa[NEX_MAXBUF];
    /** temporary rx buffer */
-   ec_bufT tempinbuf;
+   nex_bufT tempinbuf;
    /** temporary rx buffer status */
    int tempinbufs;
    /** transmit buffers */
-   ec_bufT txbuf[EC_MAXBUF];
+   nex_bufT txbuf[NEX_MAXBUF];
    /** transmit buffer lenghts */
-   int txbuflength[EC_MAXBUF];
+   int txbuflength[NEX_MAXBUF];
    /** temporary tx buffer */
-   ec_bufT txbuf2;
+   nex_bufT txbuf2;
    /** temporary tx buffer length */
    int txbuflength2;
    /** last used frame index */
    int lastidx;
+   /** frame indexes owned by the index partition of a group, never given
+    * out by nexx_getindex */
+   uint8 idxreserved[NEX_MAXBUF];
    /** current redundancy state */
    int redstate;
    /** pointer to redundancy port and buffers */
-   ecx_redportt *redport;
+   nexx_redportt *redport;
    pthread_mutex_t getindex_mutex;
    pthread_mutex_t tx_mutex;
    pthread_mutex_t rx_mutex;
-} ecx_portt;
+} nexx_portt;
 
 extern const uint16 priMAC[3];
 extern const uint16 secMAC[3];
 
-#ifdef EC_VER1
-extern ecx_portt     ecx_port;
-extern ecx_redportt  ecx_redport;
+#ifdef NEX_VER1
+extern nexx_portt     nexx_port;
+extern nexx_redportt  nexx_redport;
 
-int ec_setupnic(const char * ifname, int secondary);
-int ec_closenic(void);
-void ec_setbufstat(int idx, int bufstat);
-int ec_getindex(void);
-int ec_outframe(int idx, int sock);
-int ec_outframe_red(int idx);
-int ec_waitinframe(int idx, int timeout);
-int ec_srconfirm(int idx,int timeout);
+int nex_setupnic(const char * ifname, int secondary);
+int nex_closenic(void);
+void nex_setbufstat(int idx, int bufstat);
+int nex_getindex(void);
+int nex_outframe(int idx, int sock);
+int nex_outframe_red(int idx);
+int nex_waitinframe(int idx, int timeout);
+int nex_srconfirm(int idx,int timeout);
 #endif
 
-void ec_setupheader(void *p);
-int ecx_setupnic(ecx_portt *port, const char * ifname, int secondary);
-int ecx_closenic(ecx_portt *port);
-void ecx_setbufstat(ecx_portt *port, int idx, int bufstat);
-int ecx_getindex(ecx_portt *port);
-int ecx_outframe(ecx_portt *port, int idx, int sock);
-int ecx_outframe_red(ecx_portt *port, int idx);
-int ecx_waitinframe(ecx_portt *port, int idx, int timeout);
-int ecx_srconfirm(ecx_portt *port, int idx,int timeout);
+void nex_setupheader(void *p);
+int nexx_setupnic(nexx_portt *port, const char * ifname, int secondary);
+int nexx_closenic(nexx_portt *port);
+void nexx_setbufstat(nexx_portt *port, int idx, int bufstat);
+int nexx_getindex(nexx_portt *port);
+int nexx_outframe(nexx_portt *port, int idx, int sock);
+int nexx_outframe_red(nexx_portt *port, int idx);
+int nexx_waitinframe(nexx_portt *port, int idx, int timeout);
+int nexx_srconfirm(nexx_portt *port, int idx,int timeout);
 
 #ifdef __cplusplus
 }
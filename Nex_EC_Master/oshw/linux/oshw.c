@@ -39,14 +39,14 @@ uint16 oshw_ntohs(uint16 network)
 /** Create list over available network adapters.
  * @return First element in linked list of adapters
  */
-ec_adaptert * oshw_find_adapters(void)
+nex_adaptert * oshw_find_adapters(void)
 {
    int i;
    int string_len;
    struct if_nameindex *ids;
-   ec_adaptert * adapter;
-   ec_adaptert * prev_adapter;
-   ec_adaptert * ret_adapter = NULL;
+   nex_adaptert * adapter;
+   nex_adaptert * prev_adapter;
+   nex_adaptert * ret_adapter = NULL;
 
 
    /* Iterate all devices and create a local copy holding the name and
@@ -56,7 +56,7 @@ ec_adaptert * oshw_find_adapters(void)
    ids = if_nameindex ();
    for(i = 0; ids[i].if_index != 0; i++)
    {
-      adapter = (ec_adaptert *)malloc(sizeof(ec_adaptert));
+      adapter = (nex_adaptert *)malloc(sizeof(nex_adaptert));
       /* If we got more than one adapter save link list pointer to previous
        * adapter.
        * Else save as pointer to return.
@@ -76,9 +76,9 @@ ec_adaptert * oshw_find_adapters(void)
       if (ids[i].if_name)
       {
           string_len = strlen(ids[i].if_name);
-          if (string_len > (EC_MAXLEN_ADAPTERNAME - 1))
+          if (string_len > (NEX_MAXLEN_ADAPTERNAME - 1))
           {
-             string_len = EC_MAXLEN_ADAPTERNAME - 1;
+             string_len = NEX_MAXLEN_ADAPTERNAME - 1;
           }
           strncpy(adapter->name, ids[i].if_name,string_len);
           adapter->name[string_len] = '\0';
@@ -101,11 +101,11 @@ ec_adaptert * oshw_find_adapters(void)
 
 /** Free memory allocated memory used by adapter collection.
  * @param[in] adapter = First element in linked list of adapters
- * EC_NOFRAME.
+ * NEX_NOFRAME.
  */
-void oshw_free_adapters(ec_adaptert * adapter)
+void oshw_free_adapters(nex_adaptert * adapter)
 {
-   ec_adaptert * next_adapter;
+   nex_adaptert * next_adapter;
    /* Iterate the linked list and free all elemnts holding
     * adapter information
     */
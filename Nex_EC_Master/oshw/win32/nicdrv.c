@@ -70,8 +70,6 @@ const uint16 secMAC[3] = { 0x0404, 0x0404, 0x0404 };
 /** second MAC word is used for identification */
 #define RX_SEC secMAC[1]
 
-static char errbuf[PCAP_ERRBUF_SIZE];
-
 static void nexx_clear_rxbufstat(int *rxbufstat)
 {
    int i;
@@ -91,6 +89,7 @@ int nexx_setupnic(nexx_portt *port, const char *ifname, int secondary)
 {
    int i, rval;
    pcap_t **psock;
+   char errbuf[PCAP_ERRBUF_SIZE];
 
    rval = 0;
    if (secondary)
@@ -216,8 +215,8 @@ int nexx_getindex(nexx_portt *port)
       idx = 0;
    }
    cnt = 0;
-   /* try to find unused index */
-   while ((port->rxbufstat[idx] != NEX_BUF_EMPTY) && (cnt < NEX_MAXBUF))
+   /* try to find unused index, the indexes of group partitions are never used */
+   while (((port->rxbufstat[idx] != NEX_BUF_EMPTY) || port->idxreserved[idx]) && (cnt < NEX_MAXBUF))
    {
       idx++;
       cnt++;
@@ -226,6 +225,15 @@ int nexx_getindex(nexx_portt *port)
          idx = 0;
       }
    }
+   /* all busy, reuse an index but not one of a group partition */
+   while (port->idxreserved[idx])
+   {
+      idx++;
+      if (idx >= NEX_MAXBUF)
+      {
+         idx = 0;
+      }
+   }
    port->rxbufstat[idx] = NEX_BUF_ALLOC;
    if (port->redstate != ECT_RED_NONE)
       port->redport->rxbufstat[idx] = NEX_BUF_ALLOC;
@@ -400,9 +408,10 @@ int nexx_inframe(nexx_portt *port, int idx, int stacknumber)
       /* mark as completed */
       (*stack->rxbufstat)[idx] = NEX_BUF_COMPLETE;
    }
-   else
+   /* another thread reads the socket and puts the frame in its buffer by index,
+    * do not wait for it but check the buffer again on the next call */
+   else if (TryEnterCriticalSection(&(port->rx_mutex)))
    {
-      EnterCriticalSection(&(port->rx_mutex));
       /* non blocking call to retrieve frame from socket */
       if (nexx_recvpkt(port, stacknumber))
       {
@@ -434,9 +443,11 @@ int nexx_inframe(nexx_portt *port, int idx, int stacknumber)
                   rxbuf = &(*stack->rxbuf)[idxf];
                   /* put it in the buffer array (strip ethernet header) */
                   memcpy(rxbuf, &(*stack->tempbuf)[ETH_HEADERSIZE], (*stack->txbuflength)[idxf] - ETH_HEADERSIZE);
+                  (*stack->rxsa)[idxf] = ntohs(ehp->sa1);
+                  /* the thread waiting for it reads the buffer without the lock */
+                  MemoryBarrier();
                   /* mark as received */
                   (*stack->rxbufstat)[idxf] = NEX_BUF_RCVD;
-                  (*stack->rxsa)[idxf] = ntohs(ehp->sa1);
                }
                else
                {
@@ -80,6 +80,9 @@ typedef struct
    int txbuflength2;
    /** last used frame index */
    int lastidx;
+   /** frame indexes owned by the index partition of a group, never given
+    * out by nexx_getindex */
+   uint8 idxreserved[NEX_MAXBUF];
    /** current redundancy state */
    int redstate;
    /** pointer to redundancy port and buffers */
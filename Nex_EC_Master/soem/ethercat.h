@@ -18,7 +18,13 @@
 #include "ethercatdc.h"
 #include "ethercatcoe.h"
 #include "ethercatfoe.h"
+#include "ethercateoe.h"
 #include "ethercatsoe.h"
+#include "ethercatgw.h"
+#include "ethercatshm.h"
+#include "ethercatrec.h"
+#include "ethercatovs.h"
+#include "ethercatbitio.h"
 #include "ethercatconfig.h"
 #include "ethercatprint.h"
 #include "osal.h"
@@ -0,0 +1,497 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Header only C++17 layer over the nexx_ API.
+ *
+ * nex::Port owns the NIC, nex::Master owns a complete context with its own
+ * slave list, group list and error list, nex::Group is a view on one group of
+ * a master. All three are move-only, the destructors close the NIC. Functions
+ * that can fail return nex::result, which holds the value or the first error
+ * the call pushed to the error list of the master. The global EcatError and
+ * error list are not used. The cyclic methods of Group are inline forwarders
+ * to the nexx_ functions, they do not allocate and are not virtual.
+ */
+
+#ifndef _ethercat_hpp_
+#define _ethercat_hpp_
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#if defined(__has_include)
+#if __has_include(<span>) && (__cplusplus > 201703L)
+#include <span>
+#endif
+#endif
+
+#include "ethercat.h"
+
+namespace nex
+{
+
+#if defined(__cpp_lib_span)
+template <typename T>
+using span = std::span<T>;
+#else
+/** view over contiguous memory, std::span where available */
+template <typename T>
+class span
+{
+public:
+   constexpr span() noexcept : data_(nullptr), size_(0) {}
+   constexpr span(T *data, std::size_t size) noexcept : data_(data), size_(size) {}
+   template <typename U, std::size_t N>
+   constexpr span(U (&arr)[N]) noexcept : data_(arr), size_(N) {}
+   template <typename U, typename = std::enable_if_t<std::is_convertible<U (*)[], T (*)[]>::value>>
+   constexpr span(const span<U> &other) noexcept : data_(other.data()), size_(other.size()) {}
+
+   constexpr T *data() const noexcept { return data_; }
+   constexpr std::size_t size() const noexcept { return size_; }
+   constexpr std::size_t size_bytes() const noexcept { return size_ * sizeof(T); }
+   constexpr bool empty() const noexcept { return size_ == 0; }
+   constexpr T *begin() const noexcept { return data_; }
+   constexpr T *end() const noexcept { return data_ + size_; }
+   constexpr T &operator[](std::size_t i) const noexcept { return data_[i]; }
+   constexpr span subspan(std::size_t offset, std::size_t count) const noexcept
+   {
+      return span(data_ + offset, count);
+   }
+
+private:
+   T *data_;
+   std::size_t size_;
+};
+#endif
+
+/** error of a failed call */
+struct error
+{
+   /** return value of the C function, f.e. working counter 0 or NEX_NOFRAME */
+   int code;
+   /** TRUE if detail holds the first entry the call pushed to the error list */
+   bool has_detail;
+   nex_errort detail;
+
+   /** readable text of the error */
+   const char *message() const noexcept
+   {
+      if (has_detail)
+      {
+         switch (detail.Etype)
+         {
+            case NEX_ERR_TYPE_SDO_ERROR:
+            case NEX_ERR_TYPE_SDOINFO_ERROR:
+               return nex_sdoerror2string((uint32)detail.AbortCode);
+            case NEX_ERR_TYPE_SOE_ERROR:
+               return nex_soeerror2string(detail.ErrorCode);
+            default:
+               break;
+         }
+      }
+      return (code == NEX_NOFRAME) ? "no frame" : "no response";
+   }
+};
+
+/** value of a successful call or its error, in the manner of std::expected */
+template <typename T>
+class result
+{
+public:
+   result(const T &value) : v_(std::in_place_index<0>, value) {}
+   result(T &&value) : v_(std::in_place_index<0>, std::move(value)) {}
+   result(const nex::error &err) : v_(std::in_place_index<1>, err) {}
+
+   bool has_value() const noexcept { return v_.index() == 0; }
+   explicit operator bool() const noexcept { return has_value(); }
+   T &value() & { return std::get<0>(v_); }
+   const T &value() const & { return std::get<0>(v_); }
+   T &&value() && { return std::get<0>(std::move(v_)); }
+   T value_or(T alt) const { return has_value() ? std::get<0>(v_) : alt; }
+   T &operator*() & { return std::get<0>(v_); }
+   T &&operator*() && { return std::get<0>(std::move(v_)); }
+   T *operator->() { return &std::get<0>(v_); }
+   const nex::error &error() const { return std::get<1>(v_); }
+
+private:
+   std::variant<T, nex::error> v_;
+};
+
+template <>
+class result<void>
+{
+public:
+   result() : ok_(true), err_() {}
+   result(const nex::error &err) : ok_(false), err_(err) {}
+
+   bool has_value() const noexcept { return ok_; }
+   explicit operator bool() const noexcept { return ok_; }
+   const nex::error &error() const { return err_; }
+
+private:
+   bool ok_;
+   nex::error err_;
+};
+
+/** network interface, closed when the object is destroyed */
+class Port
+{
+public:
+   /** open NIC, with if2name for redundant mode */
+   static result<Port> open(const char *ifname, const char *if2name = nullptr)
+   {
+      Port p;
+      nexx_contextt ctx;
+      int rval;
+
+      std::memset(&ctx, 0, sizeof(ctx));
+      ctx.port = &p.s_->port;
+      if (if2name)
+      {
+         rval = nexx_init_redundant(&ctx, &p.s_->redport, ifname, const_cast<char *>(if2name));
+      }
+      else
+      {
+         rval = nexx_init(&ctx, ifname);
+      }
+      if (rval <= 0)
+      {
+         return nex::error{ rval, false, nex_errort() };
+      }
+      p.open_ = true;
+      return result<Port>(std::move(p));
+   }
+
+   Port(Port &&other) noexcept : s_(std::move(other.s_)), open_(other.open_) { other.open_ = false; }
+   Port &operator=(Port &&other) noexcept
+   {
+      if (this != &other)
+      {
+         close();
+         s_ = std::move(other.s_);
+         open_ = other.open_;
+         other.open_ = false;
+      }
+      return *this;
+   }
+   Port(const Port &) = delete;
+   Port &operator=(const Port &) = delete;
+   ~Port() { close(); }
+
+   void close() noexcept
+   {
+      if (open_)
+      {
+         nexx_closenic(&s_->port);
+         open_ = false;
+      }
+   }
+   bool is_open() const noexcept { return open_; }
+   nexx_portt *get() noexcept { return &s_->port; }
+
+private:
+   /* the port holds pointers to itself, it stays at one place on the heap */
+   struct storage
+   {
+      nexx_portt port;
+      nexx_redportt redport;
+   };
+
+   Port() : s_(new storage()), open_(false) {}
+
+   std::unique_ptr<storage> s_;
+   bool open_;
+
+   friend class Master;
+};
+
+/** one group of a master, valid as long as the master exists */
+class Group
+{
+public:
+   Group(Group &&other) noexcept : ctx_(other.ctx_), group_(other.group_) { other.ctx_ = nullptr; }
+   Group &operator=(Group &&other) noexcept
+   {
+      ctx_ = other.ctx_;
+      group_ = other.group_;
+      other.ctx_ = nullptr;
+      return *this;
+   }
+   Group(const Group &) = delete;
+   Group &operator=(const Group &) = delete;
+
+   uint8 id() const noexcept { return group_; }
+   span<uint8> outputs() const noexcept
+   {
+      nex_groupt *g = &ctx_->grouplist[group_];
+      return span<uint8>(g->outputs, g->Obytes);
+   }
+   span<const uint8> inputs() const noexcept
+   {
+      nex_groupt *g = &ctx_->grouplist[group_];
+      return span<const uint8>(g->inputs, g->Ibytes);
+   }
+   int expected_wkc() const noexcept
+   {
+      nex_groupt *g = &ctx_->grouplist[group_];
+      return (g->outputsWKC * 2) + g->inputsWKC;
+   }
+   int send() noexcept { return nexx_send_processdata_group(ctx_, group_); }
+   int send_overlap() noexcept { return nexx_send_overlap_processdata_group(ctx_, group_); }
+   int receive(int timeout = NEX_TIMEOUTRET) noexcept { return nexx_receive_processdata_group(ctx_, group_, timeout); }
+   /** send and receive, returns working counter */
+   int exchange(int timeout = NEX_TIMEOUTRET) noexcept
+   {
+      send();
+      return receive(timeout);
+   }
+
+private:
+   Group(nexx_contextt *ctx, uint8 group) noexcept : ctx_(ctx), group_(group) {}
+
+   nexx_contextt *ctx_;
+   uint8 group_;
+
+   friend class Master;
+};
+
+/** EtherCAT master with a context of its own */
+class Master
+{
+public:
+   explicit Master(Port &&port) : port_(std::move(port)), s_(new storage())
+   {
+      nexx_contextt *c = &s_->ctx;
+
+      c->port = port_.get();
+      c->slavelist = &s_->slave[0];
+      c->slavecount = &s_->slavecount;
+      c->maxslave = NEX_MAXSLAVE;
+      c->grouplist = &s_->group[0];
+      c->maxgroup = NEX_MAXGROUP;
+      c->esibuf = &s_->esibuf[0];
+      c->esimap = &s_->esimap[0];
+      c->elist = &s_->elist;
+      c->idxstack = &s_->idxstack;
+      c->ecaterror = &s_->ecaterror;
+      c->DCtime = &s_->DCtime;
+      c->SMcommtype = &s_->SMcommtype[0];
+      c->PDOassign = &s_->PDOassign[0];
+      c->PDOdesc = &s_->PDOdesc[0];
+      c->eepSM = &s_->eepSM;
+      c->eepFMMU = &s_->eepFMMU;
+      s_->emcylist.toelist = TRUE;
+      c->emcylist = &s_->emcylist;
+      c->SoEcache = &s_->SoEcache;
+   }
+
+   Master(Master &&other) noexcept = default;
+   Master &operator=(Master &&other) noexcept
+   {
+      if (this != &other)
+      {
+         close();
+         port_ = std::move(other.port_);
+         s_ = std::move(other.s_);
+      }
+      return *this;
+   }
+   Master(const Master &) = delete;
+   Master &operator=(const Master &) = delete;
+   ~Master() { close(); }
+
+   /** close the NIC, done by the destructor as well */
+   void close() noexcept
+   {
+      if (s_ && port_.is_open())
+      {
+         nexx_close(&s_->ctx);
+         port_.open_ = false;
+      }
+   }
+
+   /** context for the nexx_ functions not covered here */
+   nexx_contextt *context() noexcept { return &s_->ctx; }
+   int slavecount() const noexcept { return s_->slavecount; }
+   /** slaves 1 to slavecount */
+   span<nex_slavet> slaves() noexcept { return span<nex_slavet>(&s_->slave[1], s_->slavecount); }
+   /** slave 0 is the master, used for group state requests */
+   nex_slavet &slave(uint16 slave) noexcept { return s_->slave[slave]; }
+   Group group(uint8 group = 0) noexcept { return Group(&s_->ctx, group); }
+   /** DC time of last process data exchange */
+   int64 dctime() const noexcept { return s_->DCtime; }
+
+   /** enumerate and initialise slaves, returns slave count */
+   result<int> config_init()
+   {
+      int16 mark = s_->elist.head;
+      int wkc = nexx_config_init(&s_->ctx);
+      if (wkc <= 0)
+      {
+         return take_error(wkc, mark);
+      }
+      return wkc;
+   }
+   /** map process data of group, returns bytes used. The size of iomap is not
+    * checked, the mapping points the slaves into it as far as their process
+    * data needs. The caller must give a span at least as large as the IOmap
+    * of the group, f.e. the size config_map returned for the same slaves. */
+   result<int> config_map(span<uint8> iomap, uint8 group = 0)
+   {
+      int16 mark = s_->elist.head;
+      int size = nexx_config_map_group(&s_->ctx, iomap.data(), group);
+      if (size < 0)
+      {
+         return take_error(size, mark);
+      }
+      return size;
+   }
+   /** map process data of group with overlapping outputs and inputs, same
+    * contract for the size of iomap as config_map */
+   result<int> config_overlap_map(span<uint8> iomap, uint8 group = 0)
+   {
+      int16 mark = s_->elist.head;
+      int size = nexx_config_overlap_map_group(&s_->ctx, iomap.data(), group);
+      if (size < 0)
+      {
+         return take_error(size, mark);
+      }
+      return size;
+   }
+   bool configdc() { return nexx_configdc(&s_->ctx) != FALSE; }
+
+   int readstate() { return nexx_readstate(&s_->ctx); }
+   /** request state of slave, slave 0 is all slaves */
+   result<void> writestate(uint16 slave, uint16 state)
+   {
+      int16 mark = s_->elist.head;
+      int wkc;
+
+      s_->slave[slave].state = state;
+      wkc = nexx_writestate(&s_->ctx, slave);
+      if (wkc <= 0)
+      {
+         return take_error(wkc, mark);
+      }
+      return result<void>();
+   }
+   /** wait for state of slave, returns the state reached */
+   uint16 statecheck(uint16 slave, uint16 state, int timeout = NEX_TIMEOUTSTATE)
+   {
+      return nexx_statecheck(&s_->ctx, slave, state, timeout);
+   }
+
+   /** read object of trivially copyable type */
+   template <typename T>
+   result<T> sdo_read(uint16 slave, uint16 index, uint8 subindex, bool ca = false, int timeout = NEX_TIMEOUTRXM)
+   {
+      static_assert(std::is_trivially_copyable<T>::value, "sdo_read needs a trivially copyable type");
+      T value;
+      int16 mark = s_->elist.head;
+      int size = sizeof(T);
+      int wkc;
+
+      std::memset(&value, 0, sizeof(T));
+      wkc = nexx_SDOread(&s_->ctx, slave, index, subindex, ca ? TRUE : FALSE, &size, &value, timeout);
+      if (wkc <= 0)
+      {
+         return take_error(wkc, mark);
+      }
+      return value;
+   }
+   /** read object into buffer, returns bytes read */
+   result<int> sdo_read(uint16 slave, uint16 index, uint8 subindex, span<uint8> buf, bool ca = false,
+                        int timeout = NEX_TIMEOUTRXM)
+   {
+      int16 mark = s_->elist.head;
+      int size = (int)buf.size();
+      int wkc = nexx_SDOread(&s_->ctx, slave, index, subindex, ca ? TRUE : FALSE, &size, buf.data(), timeout);
+      if (wkc <= 0)
+      {
+         return take_error(wkc, mark);
+      }
+      return size;
+   }
+   template <typename T>
+   result<void> sdo_write(uint16 slave, uint16 index, uint8 subindex, const T &value, bool ca = false,
+                          int timeout = NEX_TIMEOUTRXM)
+   {
+      static_assert(std::is_trivially_copyable<T>::value, "sdo_write needs a trivially copyable type");
+      T copy = value;
+      int16 mark = s_->elist.head;
+      int wkc = nexx_SDOwrite(&s_->ctx, slave, index, subindex, ca ? TRUE : FALSE, sizeof(T), &copy, timeout);
+      if (wkc <= 0)
+      {
+         return take_error(wkc, mark);
+      }
+      return result<void>();
+   }
+   result<void> sdo_write(uint16 slave, uint16 index, uint8 subindex, span<const uint8> buf, bool ca = false,
+                          int timeout = NEX_TIMEOUTRXM)
+   {
+      int16 mark = s_->elist.head;
+      int wkc = nexx_SDOwrite(&s_->ctx, slave, index, subindex, ca ? TRUE : FALSE, (int)buf.size(),
+                              const_cast<uint8 *>(buf.data()), timeout);
+      if (wkc <= 0)
+      {
+         return take_error(wkc, mark);
+      }
+      return result<void>();
+   }
+
+   /** pop next entry of the error list, f.e. emergencies received in the cycle */
+   bool pop_error(nex_errort &err) noexcept { return nexx_poperror(&s_->ctx, &err) != FALSE; }
+
+private:
+   struct storage
+   {
+      nexx_contextt    ctx;
+      nex_slavet       slave[NEX_MAXSLAVE];
+      int              slavecount;
+      nex_groupt       group[NEX_MAXGROUP];
+      uint8            esibuf[NEX_MAXEEPBUF];
+      uint32           esimap[NEX_MAXEEPBITMAP];
+      nex_eringt       elist;
+      nex_idxstackT    idxstack;
+      boolean          ecaterror;
+      int64            DCtime;
+      nex_SMcommtypet  SMcommtype[NEX_MAX_MAPT];
+      nex_PDOassignt   PDOassign[NEX_MAX_MAPT];
+      nex_PDOdesct     PDOdesc[NEX_MAX_MAPT];
+      nex_eepromSMt    eepSM;
+      nex_eepromFMMUt  eepFMMU;
+      nex_emcylistt    emcylist;
+      nex_SoEcachet    SoEcache;
+   };
+
+   /* first error the failed call pushed, its errors are removed from the list,
+      earlier entries stay for pop_error */
+   nex::error take_error(int code, int16 mark) noexcept
+   {
+      nex::error err;
+
+      err.code = code;
+      err.has_detail = (s_->elist.head != mark);
+      if (err.has_detail)
+      {
+         err.detail = s_->elist.Error[mark];
+         s_->elist.head = mark;
+         s_->ecaterror = (s_->elist.head != s_->elist.tail) ? TRUE : FALSE;
+      }
+      return err;
+   }
+
+   Port port_;
+   std::unique_ptr<storage> s_;
+};
+
+} // namespace nex
+
+#endif
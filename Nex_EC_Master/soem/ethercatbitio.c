@@ -0,0 +1,352 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Bit I/O module.
+ *
+ * Digital slaves are packed bit by bit into the process image, several of
+ * them share a byte. A plan compiled with nexx_bitio_compile lists the input
+ * and output bits of the selected slaves as runs. nexx_bitio_expand copies
+ * the inputs to a byte per bit array with 0 or 1, nexx_bitio_pack copies a
+ * byte per bit array back to the outputs, any non zero byte is a 1. Whole
+ * bytes are handled by AVX2, BMI2 (PDEP/PEXT), SSE2 or NEON kernels when the
+ * target is built for it, else by a portable 64 bit kernel.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "osal.h"
+#include "oshw.h"
+#include "ethercattype.h"
+#include "ethercatbase.h"
+#include "ethercatmain.h"
+#include "ethercatbitio.h"
+
+#if defined(__AVX2__) || defined(__BMI2__)
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define NEX_BITIO_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define NEX_BITIO_NEON
+#include <arm_neon.h>
+#endif
+
+#define NEX_BITIO_LSB   0x0101010101010101ULL
+#define NEX_BITIO_MSB   0x8080808080808080ULL
+
+/** Add bits of slave to runs, merged with the last run if adjacent.
+ *
+ * @param[in]  run        = runs
+ * @param[in,out] nrun    = number of runs
+ * @param[in]  src        = first byte of bits
+ * @param[in]  startbit   = first bit in src
+ * @param[in]  bits       = bits
+ * @param[in]  index      = first element in array
+ */
+static void nexx_bitio_addrun(nex_bitiorunt *run, int *nrun, uint8 *src, uint8 startbit, uint32 bits, uint32 index)
+{
+   nex_bitiorunt *last;
+   uint32 end;
+
+   if (*nrun)
+   {
+      last = &run[*nrun - 1];
+      end = last->startbit + last->bits;
+      if (((last->src + (end >> 3)) == src) && ((end & 7) == startbit) &&
+          ((last->index + last->bits) == index))
+      {
+         last->bits += bits;
+         return;
+      }
+   }
+   run[*nrun].src = src;
+   run[*nrun].startbit = startbit;
+   run[*nrun].bits = bits;
+   run[*nrun].index = index;
+   (*nrun)++;
+}
+
+/** Compile bit I/O plan of the slaves of a group. Call it after the process
+ * data is mapped.
+ *
+ * @param[in]  context    = context struct
+ * @param[out] plan       = bit I/O plan
+ * @param[in]  group      = group number, 0 for all slaves
+ * @param[in]  maxbits    = only slaves with up to maxbits inputs or outputs, 0 for any
+ * @return elements of input and output arrays together
+ */
+int nexx_bitio_compile(nexx_contextt *context, nex_bitiot *plan, uint8 group, uint16 maxbits)
+{
+   nex_slavet *sl;
+   int slave;
+
+   memset(plan, 0, sizeof(*plan));
+   for (slave = 0; slave < NEX_MAXSLAVE; slave++)
+   {
+      plan->iindex[slave] = -1;
+      plan->oindex[slave] = -1;
+   }
+   for (slave = 1; (slave <= *(context->slavecount)) && (slave < NEX_MAXSLAVE); slave++)
+   {
+      sl = &context->slavelist[slave];
+      if (group && (sl->group != group))
+      {
+         continue;
+      }
+      if (sl->inputs && sl->Ibits && (!maxbits || (sl->Ibits <= maxbits)))
+      {
+         plan->iindex[slave] = (int32)plan->ninputs;
+         nexx_bitio_addrun(plan->irun, &plan->nirun, sl->inputs, sl->Istartbit, sl->Ibits, plan->ninputs);
+         plan->ninputs += sl->Ibits;
+      }
+      if (sl->outputs && sl->Obits && (!maxbits || (sl->Obits <= maxbits)))
+      {
+         plan->oindex[slave] = (int32)plan->noutputs;
+         nexx_bitio_addrun(plan->orun, &plan->norun, sl->outputs, sl->Ostartbit, sl->Obits, plan->noutputs);
+         plan->noutputs += sl->Obits;
+      }
+   }
+
+   return (int)(plan->ninputs + plan->noutputs);
+}
+
+/** Expand whole bytes to a byte per bit.
+ *
+ * @param[in]  src        = packed bits
+ * @param[out] dst        = 8 bytes per byte of src
+ * @param[in]  nbytes     = bytes of src
+ */
+static void nexx_bitio_expandbytes(const uint8 *src, uint8 *dst, uint32 nbytes)
+{
+   uint64 x;
+   uint32 i = 0;
+
+#if defined(__AVX2__)
+   {
+      /* byte k of the word to lanes 8k to 8k+7, then test one bit per lane */
+      const __m256i shuf = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                            2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+      const __m256i bit = _mm256_set1_epi64x((int64)0x8040201008040201ULL);
+      const __m256i one = _mm256_set1_epi8(1);
+      int32 w;
+      __m256i v;
+
+      for (; (i + 4) <= nbytes; i += 4)
+      {
+         memcpy(&w, src + i, 4);
+         v = _mm256_shuffle_epi8(_mm256_set1_epi32(w), shuf);
+         v = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(v, bit), bit), one);
+         _mm256_storeu_si256((__m256i *)(dst + (i * 8)), v);
+      }
+   }
+#elif defined(NEX_BITIO_NEON)
+   {
+      static const uint8 bits[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+      const uint8x16_t bit = vld1q_u8(bits);
+      uint8x16_t v;
+
+      for (; (i + 2) <= nbytes; i += 2)
+      {
+         v = vcombine_u8(vdup_n_u8(src[i]), vdup_n_u8(src[i + 1]));
+         v = vandq_u8(vtstq_u8(v, bit), vdupq_n_u8(1));
+         vst1q_u8(dst + (i * 8), v);
+      }
+   }
+#endif
+   for (; i < nbytes; i++)
+   {
+#if defined(__BMI2__)
+      x = _pdep_u64(src[i], NEX_BITIO_LSB);
+#else
+      /* spread 8 bits to bit 0 of 8 bytes */
+      x = src[i];
+      x = (x | (x << 28)) & 0x0000000F0000000FULL;
+      x = (x | (x << 14)) & 0x0003000300030003ULL;
+      x = (x | (x << 7)) & NEX_BITIO_LSB;
+#endif
+      x = htoell(x);
+      memcpy(dst + (i * 8), &x, 8);
+   }
+}
+
+/** Pack a byte per bit to whole bytes.
+ *
+ * @param[in]  src        = 8 bytes per byte of dst, non zero is 1
+ * @param[out] dst        = packed bits
+ * @param[in]  nbytes     = bytes of dst
+ */
+static void nexx_bitio_packbytes(const uint8 *src, uint8 *dst, uint32 nbytes)
+{
+   uint64 x;
+   uint32 i = 0;
+
+#if defined(__AVX2__)
+   {
+      const __m256i zero = _mm256_setzero_si256();
+      uint32 m;
+
+      for (; (i + 4) <= nbytes; i += 4)
+      {
+         m = ~(uint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(src + (i * 8))), zero));
+         m = htoel(m);
+         memcpy(dst + i, &m, 4);
+      }
+   }
+#elif defined(NEX_BITIO_SSE2)
+   {
+      const __m128i zero = _mm_setzero_si128();
+      uint16 m;
+
+      for (; (i + 2) <= nbytes; i += 2)
+      {
+         m = (uint16)~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(src + (i * 8))), zero));
+         m = htoes(m);
+         memcpy(dst + i, &m, 2);
+      }
+   }
+#elif defined(NEX_BITIO_NEON)
+   {
+      static const uint8 bits[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+      const uint8x8_t bit = vld1_u8(bits);
+
+      for (; i < nbytes; i++)
+      {
+         dst[i] = vaddv_u8(vand_u8(vtst_u8(vld1_u8(src + (i * 8)), vdup_n_u8(0xff)), bit));
+      }
+   }
+#endif
+   for (; i < nbytes; i++)
+   {
+      memcpy(&x, src + (i * 8), 8);
+      x = etohll(x);
+      /* bit 7 of every non zero byte */
+      x = (((x & ~NEX_BITIO_MSB) + ~NEX_BITIO_MSB) | x) & NEX_BITIO_MSB;
+#if defined(__BMI2__)
+      dst[i] = (uint8)_pext_u64(x, NEX_BITIO_MSB);
+#else
+      /* gather bit 7 of byte k to bit 56 + k */
+      dst[i] = (uint8)(((x >> 7) * 0x0102040810204080ULL) >> 56);
+#endif
+   }
+}
+
+/** Expand inputs of the plan to the input array, call it after receiving the
+ * process data.
+ *
+ * @param[in]  plan       = bit I/O plan
+ * @param[out] in         = input array, plan->ninputs bytes of 0 or 1
+ */
+void nexx_bitio_expand(const nex_bitiot *plan, uint8 *in)
+{
+   const nex_bitiorunt *run;
+   const uint8 *s;
+   uint8 *d;
+   uint32 n, nbytes;
+   int r, bit;
+
+   for (r = 0; r < plan->nirun; r++)
+   {
+      run = &plan->irun[r];
+      s = run->src;
+      bit = run->startbit;
+      n = run->bits;
+      d = in + run->index;
+      /* bits up to the first byte boundary */
+      while (n && bit)
+      {
+         *d++ = (uint8)((*s >> bit) & 1);
+         n--;
+         if (++bit == 8)
+         {
+            bit = 0;
+            s++;
+         }
+      }
+      nbytes = n >> 3;
+      nexx_bitio_expandbytes(s, d, nbytes);
+      s += nbytes;
+      d += nbytes * 8;
+      for (n &= 7; n; n--, bit++)
+      {
+         *d++ = (uint8)((*s >> bit) & 1);
+      }
+   }
+}
+
+/** Pack the output array to the outputs of the plan, call it before sending
+ * the process data. Bits of other slaves in shared bytes are kept.
+ *
+ * @param[in]  plan       = bit I/O plan
+ * @param[in]  out        = output array, plan->noutputs bytes, non zero is 1
+ */
+void nexx_bitio_pack(const nex_bitiot *plan, const uint8 *out)
+{
+   const nex_bitiorunt *run;
+   const uint8 *s;
+   uint8 *d;
+   uint32 n, nbytes;
+   int r, bit;
+
+   for (r = 0; r < plan->norun; r++)
+   {
+      run = &plan->orun[r];
+      s = out + run->index;
+      bit = run->startbit;
+      n = run->bits;
+      d = run->src;
+      while (n && bit)
+      {
+         *d = (uint8)(*s++ ? (*d | (1 << bit)) : (*d & ~(1 << bit)));
+         n--;
+         if (++bit == 8)
+         {
+            bit = 0;
+            d++;
+         }
+      }
+      nbytes = n >> 3;
+      nexx_bitio_packbytes(s, d, nbytes);
+      s += nbytes * 8;
+      d += nbytes;
+      for (n &= 7; n; n--, bit++)
+      {
+         *d = (uint8)(*s++ ? (*d | (1 << bit)) : (*d & ~(1 << bit)));
+      }
+   }
+}
+
+/** Name of the kernels this module is built with.
+ *
+ * @return expand and pack kernel
+ */
+const char *nexx_bitio_kernel(void)
+{
+#if defined(__AVX2__) && defined(__BMI2__)
+   return "AVX2+BMI2";
+#elif defined(__AVX2__)
+   return "AVX2";
+#elif defined(__BMI2__) && defined(NEX_BITIO_SSE2)
+   return "BMI2 expand, SSE2 pack";
+#elif defined(__BMI2__)
+   return "BMI2";
+#elif defined(NEX_BITIO_SSE2)
+   return "64 bit expand, SSE2 pack";
+#elif defined(NEX_BITIO_NEON)
+   return "NEON";
+#else
+   return "64 bit";
+#endif
+}
+
+#ifdef NEX_VER1
+int nex_bitio_compile(nex_bitiot *plan, uint8 group, uint16 maxbits)
+{
+   return nexx_bitio_compile(&nexx_context, plan, group, maxbits);
+}
+#endif
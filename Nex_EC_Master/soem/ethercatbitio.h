@@ -0,0 +1,60 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Headerfile for ethercatbitio.c
+ */
+
+#ifndef _ethercatbitio_
+#define _ethercatbitio_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** contiguous bits in the process image and their first element in the array */
+typedef struct
+{
+   uint8   *src;
+   uint8   startbit;
+   uint32  bits;
+   uint32  index;
+} nex_bitiorunt;
+
+/** Compiled bit I/O plan. The inputs of the selected slaves are expanded to
+ * a byte per bit array, the outputs are packed from a byte per bit array.
+ * Slaves that are adjacent in the process image are merged to one run.
+ */
+typedef struct
+{
+   nex_bitiorunt irun[NEX_MAXSLAVE];
+   int     nirun;
+   /** elements of the input array */
+   uint32  ninputs;
+   nex_bitiorunt orun[NEX_MAXSLAVE];
+   int     norun;
+   /** elements of the output array */
+   uint32  noutputs;
+   /** first element of slave in the arrays, -1 if not in the plan */
+   int32   iindex[NEX_MAXSLAVE];
+   int32   oindex[NEX_MAXSLAVE];
+} nex_bitiot;
+
+#ifdef NEX_VER1
+int nex_bitio_compile(nex_bitiot *plan, uint8 group, uint16 maxbits);
+#endif
+
+int nexx_bitio_compile(nexx_contextt *context, nex_bitiot *plan, uint8 group, uint16 maxbits);
+void nexx_bitio_expand(const nex_bitiot *plan, uint8 *in);
+void nexx_bitio_pack(const nex_bitiot *plan, const uint8 *out);
+const char *nexx_bitio_kernel(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
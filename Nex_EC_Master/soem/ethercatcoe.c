@@ -55,6 +55,11 @@ typedef struct PACKED
 } nex_SDOservicet;
 PACKED_END
 
+/** bytes in front of segment data, mailbox header, CoE header and SDO command */
+#define NEX_SDO_SEGHEADER     9
+/** SDO abort code, data cannot be transferred or stored to the application */
+#define NEX_SDO_ABORT_STORE   0x08000020
+
 /** Report SDO error.
  *
  * @param[in]  context    = context struct
@@ -334,7 +339,7 @@ int nexx_SDOwrite(nexx_contextt *context, uint16 Slave, uint16 Index, uint8 SubI
    int wkc, maxdata;
    nex_mbxbuft MbxIn, MbxOut;
    uint8 cnt, toggle;
-   uint16 framedatasize;
+   int framedatasize;
    boolean  NotLast;
    uint8 *hp;
 
@@ -538,180 +543,1162 @@ int nexx_SDOwrite(nexx_contextt *context, uint16 Slave, uint16 Index, uint8 SubI
    return wkc;
 }
 
-/** CoE RxPDO write, blocking.
- *
- * A RxPDO download request is issued.
+/** Fill header of SDO request, a new mailbox counter is used for every request.
  *
- * @param[in]  context       = context struct
- * @param[in]  Slave         = Slave number
- * @param[in]  RxPDOnumber   = Related RxPDO number
- * @param[in]  psize         = Size in bytes of PDO buffer.
- * @param[out] p             = Pointer to PDO buffer
- * @return Workcounter from last slave response
+ * @param[in]  context    = context struct
+ * @param[in]  Slave      = Slave number
+ * @param[out] SDOp       = SDO request
+ * @param[in]  length     = mailbox data length
  */
-int nexx_RxPDO(nexx_contextt *context, uint16 Slave, uint16 RxPDOnumber, int psize, void *p)
+static void nexx_SDOheader(nexx_contextt *context, uint16 Slave, nex_SDOt *SDOp, uint16 length)
 {
-   nex_SDOt *SDOp;
-   int wkc, maxdata;
-   nex_mbxbuft MbxIn, MbxOut;
    uint8 cnt;
-   uint16 framedatasize;
 
-   nex_clearmbx(&MbxIn);
-   /* Empty slave out mailbox if something is in. Timout set to 0 */
-   wkc = nexx_mbxreceive(context, Slave, (nex_mbxbuft *)&MbxIn, 0);
-   nex_clearmbx(&MbxOut);
-   SDOp = (nex_SDOt *)&MbxOut;
-   maxdata = context->slavelist[Slave].mbx_l - 0x08; /* data section=mailbox size - 6 mbx - 2 CoE */
-   framedatasize = psize;
-   if (framedatasize > maxdata)
-   {
-      framedatasize = maxdata;  /*  limit transfer */
-   }
-   SDOp->MbxHeader.length = htoes(0x02 + framedatasize);
+   SDOp->MbxHeader.length = htoes(length);
    SDOp->MbxHeader.address = htoes(0x0000);
    SDOp->MbxHeader.priority = 0x00;
-   /* get new mailbox counter, used for session handle */
    cnt = nex_nextmbxcnt(context->slavelist[Slave].mbx_cnt);
    context->slavelist[Slave].mbx_cnt = cnt;
    SDOp->MbxHeader.mbxtype = ECT_MBXT_COE + (cnt << 4); /* CoE */
-   SDOp->CANOpen = htoes((RxPDOnumber & 0x01ff) + (ECT_COES_RXPDO << 12)); /* number 9bits service upper 4 bits */
-   /* copy PDO data to mailbox */
-   memcpy(&SDOp->Command, p, framedatasize);
-   /* send mailbox RxPDO request to slave */
-   wkc = nexx_mbxsend(context, Slave, (nex_mbxbuft *)&MbxOut, NEX_TIMEOUTTXM);
+   SDOp->CANOpen = htoes(0x000 + (ECT_COES_SDOREQ << 12)); /* number 9bits service upper 4 bits (SDO request) */
+}
 
-   return wkc;
+/** Abort SDO transfer in slave and report it.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  Slave      = Slave number
+ * @param[in]  Index      = Index of transfer
+ * @param[in]  SubIndex   = Subindex of transfer
+ * @param[in]  AbortCode  = Abortcode sent to slave
+ */
+static void nexx_SDOabort(nexx_contextt *context, uint16 Slave, uint16 Index, uint8 SubIndex, int32 AbortCode)
+{
+   nex_SDOt *SDOp;
+   nex_mbxbuft MbxOut;
+
+   SDOp = (nex_SDOt *)&MbxOut;
+   nexx_SDOheader(context, Slave, SDOp, 0x000a);
+   SDOp->Command = ECT_SDO_ABORT;
+   SDOp->Index = htoes(Index);
+   SDOp->SubIndex = SubIndex;
+   SDOp->ldata[0] = htoel(AbortCode);
+   nexx_mbxsend(context, Slave, &MbxOut, NEX_TIMEOUTTXM);
+   nexx_packeterror(context, Slave, Index, SubIndex, 3); /*  data container too small for type */
 }
 
-/** CoE TxPDO read remote request, blocking.
+/** Finish SDO stream statistics.
  *
- * A RxPDO download request is issued.
+ * @param[in]  start      = start time of transfer
+ * @param[out] stat       = transfer statistics
+ */
+static void nexx_SDOstat(nex_timet *start, nex_SDOstatt *stat)
+{
+   nex_timet stop, diff;
+
+   stop = osal_current_time();
+   osal_time_diff(start, &stop, &diff);
+   stat->elapsed = diff.sec * 1000000 + diff.usec;
+   stat->throughput = 0;
+   if (stat->elapsed)
+   {
+      stat->throughput = (uint32)(((int64)stat->bytes * 1000000) / stat->elapsed);
+   }
+}
+
+/** Segmented SDO upload to hook or parameter buffer, see nexx_SDOread_stream
+ * and nexx_SDOread_direct. Without hook, segments that lie completely within
+ * the object are read by the mailbox datagram straight into the parameter
+ * buffer. The bytes the segment header overlaps are saved and restored.
  *
- * @param[in]  context       = context struct
- * @param[in]  slave         = Slave number
- * @param[in]  TxPDOnumber   = Related TxPDO number
- * @param[in,out] psize      = Size in bytes of PDO buffer, returns bytes read from PDO.
- * @param[out] p             = Pointer to PDO buffer
- * @param[in]  timeout       = Timeout in us, standard is NEX_TIMEOUTRXM
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number
+ * @param[in]  index      = Index to read
+ * @param[in]  subindex   = Subindex to read, must be 0 or 1 if CA is used.
+ * @param[in]  CA         = FALSE = single subindex. TRUE = Complete Access, all subindexes read.
+ * @param[in]  hook       = stores received data, NULL to use parameter buffer
+ * @param[in]  arg        = user argument of hook
+ * @param[in,out] psize   = Size in bytes of parameter buffer, returns bytes read from SDO.
+ * @param[out] p          = Pointer to parameter buffer
+ * @param[out] stat       = transfer statistics, may be NULL
+ * @param[in]  timeout    = Timeout per mailbox cycle in us, standard is NEX_TIMEOUTRXM
  * @return Workcounter from last slave response
  */
-int nexx_TxPDO(nexx_contextt *context, uint16 slave, uint16 TxPDOnumber , int *psize, void *p, int timeout)
+static int nexx_SDOupload(nexx_contextt *context, uint16 slave, uint16 index, uint8 subindex,
+                          boolean CA, nex_SDOstreamhookt hook, void *arg, int *psize, uint8 *p,
+                          nex_SDOstatt *stat, int timeout)
 {
-   nex_SDOt *SDOp, *aSDOp;
-   int wkc;
+   nex_SDOt *SDOp, *aSDOp, *rSDOp;
    nex_mbxbuft MbxIn, MbxOut;
-   uint8 cnt;
-   uint16 framedatasize;
+   nex_SDOstatt lstat;
+   nex_timet start;
+   uint8 save[NEX_SDO_SEGHEADER];
+   uint8 *data, *hp;
+   int wkc, n, mbxl;
+   int32 SDOlen, abort;
+   uint8 toggle, command;
+   boolean NotLast, inplace;
 
-   nex_clearmbx(&MbxIn);
+   if (!stat)
+   {
+      stat = &lstat;
+   }
+   memset(stat, 0, sizeof(*stat));
+   start = osal_current_time();
    /* Empty slave out mailbox if something is in. Timout set to 0 */
-   wkc = nexx_mbxreceive(context, slave, (nex_mbxbuft *)&MbxIn, 0);
-   nex_clearmbx(&MbxOut);
+   wkc = nexx_mbxreceive(context, slave, &MbxIn, 0);
    aSDOp = (nex_SDOt *)&MbxIn;
    SDOp = (nex_SDOt *)&MbxOut;
-   SDOp->MbxHeader.length = htoes(0x02);
-   SDOp->MbxHeader.address = htoes(0x0000);
-   SDOp->MbxHeader.priority = 0x00;
-   /* get new mailbox counter, used for session handle */
-   cnt = nex_nextmbxcnt(context->slavelist[slave].mbx_cnt);
-   context->slavelist[slave].mbx_cnt = cnt;
-   SDOp->MbxHeader.mbxtype = ECT_MBXT_COE + (cnt << 4); /* CoE */
-   SDOp->CANOpen = htoes((TxPDOnumber & 0x01ff) + (ECT_COES_TXPDO_RR << 12)); /* number 9bits service upper 4 bits */
-   wkc = nexx_mbxsend(context, slave, (nex_mbxbuft *)&MbxOut, NEX_TIMEOUTTXM);
+   mbxl = context->slavelist[slave].mbx_rl;
+   if (CA && (subindex > 1))
+   {
+      subindex = 1;
+   }
+   nexx_SDOheader(context, slave, SDOp, 0x000a);
+   SDOp->Command = CA ? ECT_SDO_UP_REQ_CA : ECT_SDO_UP_REQ;
+   SDOp->Index = htoes(index);
+   SDOp->SubIndex = subindex;
+   SDOp->ldata[0] = 0;
+   /* send CoE request to slave */
+   wkc = nexx_mbxsend(context, slave, &MbxOut, NEX_TIMEOUTTXM);
    if (wkc > 0)
    {
-      /* clean mailboxbuffer */
-      nex_clearmbx(&MbxIn);
-      /* read slave response */
-      wkc = nexx_mbxreceive(context, slave, (nex_mbxbuft *)&MbxIn, timeout);
-      if (wkc > 0) /* succeeded to read slave response ? */
+      wkc = nexx_mbxpoll(context, slave, &MbxIn, timeout);
+   }
+   if (wkc <= 0)
+   {
+      nexx_SDOstat(&start, stat);
+      return wkc;
+   }
+   /* slave response should be CoE, SDO response and the correct index */
+   if (((aSDOp->MbxHeader.mbxtype & 0x0f) != ECT_MBXT_COE) ||
+       ((etohs(aSDOp->CANOpen) >> 12) != ECT_COES_SDORES) ||
+        (aSDOp->Index != SDOp->Index))
+   {
+      if (aSDOp->Command == ECT_SDO_ABORT) /* SDO abort frame received */
       {
-         /* slave response should be CoE, TxPDO */
-         if (((aSDOp->MbxHeader.mbxtype & 0x0f) == ECT_MBXT_COE) &&
-             ((etohs(aSDOp->CANOpen) >> 12) == ECT_COES_TXPDO))
+         nexx_SDOerror(context, slave, index, subindex, etohl(aSDOp->ldata[0]));
+      }
+      else
+      {
+         nexx_packeterror(context, slave, index, subindex, 1); /* Unexpected frame returned */
+      }
+      nexx_SDOstat(&start, stat);
+      return 0;
+   }
+   if ((aSDOp->Command & 0x02) > 0)
+   {
+      /* expedited frame response */
+      n = 4 - ((aSDOp->Command >> 2) & 0x03);
+      SDOlen = n;
+      data = &aSDOp->bdata[0];
+   }
+   else
+   {
+      /* normal frame response */
+      SDOlen = etohl(aSDOp->ldata[0]);
+      n = etohs(aSDOp->MbxHeader.length) - 10;
+      if (n > SDOlen)
+      {
+         n = SDOlen;
+      }
+      data = &aSDOp->bdata[4];
+   }
+   NotLast = (n < SDOlen);
+   stat->size = SDOlen;
+   if (!hook && (SDOlen > *psize))
+   {
+      nexx_packeterror(context, slave, index, subindex, 3); /*  data container too small for type */
+      nexx_SDOstat(&start, stat);
+      return 0;
+   }
+   hp = p;
+   toggle = 0x00;
+   while (wkc > 0)
+   {
+      if (NotLast)
+      {
+         /* slave consumed the previous request before responding, ask for the
+            next segment before this one is stored */
+         nexx_SDOheader(context, slave, SDOp, 0x000a);
+         SDOp->Command = ECT_SDO_SEG_UP_REQ + toggle; /* segment upload request */
+         wkc = nexx_mbxwrite(context, slave, &MbxOut, NEX_TIMEOUTTXM);
+         toggle = toggle ^ 0x10; /* toggle bit for segment request */
+      }
+      if (hook)
+      {
+         if (hook(arg, data, n) != n)
          {
-            /* TxPDO response */
-            framedatasize = (aSDOp->MbxHeader.length - 2);
-            if (*psize >= framedatasize) /* parameter buffer big enough ? */
-            {
-               /* copy parameter in parameter buffer */
-               memcpy(p, &aSDOp->Command, framedatasize);
-               /* return the real parameter size */
-               *psize = framedatasize;
-            }
-            /* parameter buffer too small */
-            else
+            nexx_SDOabort(context, slave, index, subindex, NEX_SDO_ABORT_STORE);
+            wkc = 0;
+            break;
+         }
+      }
+      else if (data != hp)
+      {
+         memcpy(hp, data, n);
+      }
+      hp += n;
+      stat->bytes += n;
+      stat->segments++;
+      if (!NotLast || (wkc <= 0))
+      {
+         break;
+      }
+      /* read segment in place if the whole mailbox fits within the object */
+      inplace = !hook && ((hp - p) >= NEX_SDO_SEGHEADER) &&
+                (((hp - p) - NEX_SDO_SEGHEADER + mbxl) <= SDOlen);
+      if (inplace)
+      {
+         rSDOp = (nex_SDOt *)(hp - NEX_SDO_SEGHEADER);
+         memcpy(save, rSDOp, NEX_SDO_SEGHEADER);
+      }
+      else
+      {
+         rSDOp = aSDOp;
+      }
+      wkc = nexx_mbxpoll(context, slave, (nex_mbxbuft *)rSDOp, timeout);
+      /* take header and abort code before restoring the overlapped data */
+      command = rSDOp->Command;
+      n = etohs(rSDOp->MbxHeader.length) - 3;
+      abort = etohl(rSDOp->ldata[0]);
+      if ((wkc > 0) &&
+          ((rSDOp->MbxHeader.mbxtype & 0x0f) == ECT_MBXT_COE) &&
+          ((etohs(rSDOp->CANOpen) >> 12) == ECT_COES_SDORES) &&
+          ((command & 0xe0) == 0x00))
+      {
+         if ((command & 0x01) > 0)
+         { /* last segment */
+            NotLast = FALSE;
+            if (n == 7)
             {
-               wkc = 0;
-               nexx_packeterror(context, slave, 0, 0, 3); /*  data container too small for type */
+               /* substract unused bytes from frame */
+               n = n - ((command & 0x0e) >> 1);
             }
          }
-         /* other slave response */
-         else
+         if (!hook && ((hp - p) + n > *psize))
          {
-            if ((aSDOp->Command) == ECT_SDO_ABORT) /* SDO abort frame received */
-            {
-               nexx_SDOerror(context, slave, 0, 0, etohl(aSDOp->ldata[0]));
-            }
-            else
-            {
-               nexx_packeterror(context, slave, 0, 0, 1); /* Unexpected frame returned */
-            }
+            nexx_packeterror(context, slave, index, subindex, 3); /*  data container too small for type */
             wkc = 0;
          }
+         data = (uint8 *)&rSDOp->Index;
+         if (inplace)
+         {
+            stat->inplace++;
+         }
+      }
+      else if (wkc > 0)
+      {
+         if (command == ECT_SDO_ABORT) /* SDO abort frame received */
+         {
+            nexx_SDOerror(context, slave, index, subindex, abort);
+         }
+         else
+         {
+            nexx_packeterror(context, slave, index, subindex, 1); /* Unexpected frame returned */
+         }
+         wkc = 0;
+      }
+      if (inplace)
+      {
+         memcpy(rSDOp, save, NEX_SDO_SEGHEADER);
       }
    }
+   if (!hook && (wkc > 0))
+   {
+      *psize = (int)(hp - p);
+   }
+   nexx_SDOstat(&start, stat);
 
    return wkc;
 }
 
-/** Read PDO assign structure
- * @param[in]  context       = context struct
- * @param[in]  Slave         = Slave number
- * @param[in]  PDOassign     = PDO assign object
- * @return total bitlength of PDO assign
+/** CoE SDO read streamed to hook, blocking. Single subindex or Complete Access.
+ *
+ * For objects larger than available memory. Every segment is passed to the hook
+ * straight from the mailbox buffer, after the request for the next segment is
+ * sent, so the slave prepares it while the hook stores the data. Responses are
+ * detected with nexx_mbxpoll. If the hook fails the transfer is aborted.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number
+ * @param[in]  index      = Index to read
+ * @param[in]  subindex   = Subindex to read, must be 0 or 1 if CA is used.
+ * @param[in]  CA         = FALSE = single subindex. TRUE = Complete Access, all subindexes read.
+ * @param[in]  hook       = stores received data, f.e. nexx_FOEstream_fwrite
+ * @param[in]  arg        = user argument of hook
+ * @param[out] stat       = transfer statistics, may be NULL
+ * @param[in]  timeout    = Timeout per mailbox cycle in us, standard is NEX_TIMEOUTRXM
+ * @return Workcounter from last slave response
  */
-int nexx_readPDOassign(nexx_contextt *context, uint16 Slave, uint16 PDOassign)
+int nexx_SDOread_stream(nexx_contextt *context, uint16 slave, uint16 index, uint8 subindex,
+                        boolean CA, nex_SDOstreamhookt hook, void *arg, nex_SDOstatt *stat, int timeout)
 {
-   uint16 idxloop, nidx, subidxloop, rdat, idx, subidx;
-   uint8 subcnt;
-   int wkc, bsize = 0, rdl;
-   int32 rdat2;
+   return nexx_SDOupload(context, slave, index, subindex, CA, hook, arg, NULL, NULL, stat, timeout);
+}
 
-   rdl = sizeof(rdat); rdat = 0;
-   /* read PDO assign subindex 0 ( = number of PDO's) */
-   wkc = nexx_SDOread(context, Slave, PDOassign, 0x00, FALSE, &rdl, &rdat, NEX_TIMEOUTRXM);
-   rdat = etohs(rdat);
-   /* positive result from slave ? */
-   if ((wkc > 0) && (rdat > 0))
+/** CoE SDO read into parameter buffer, blocking. Same as nexx_SDOread but for
+ * large segmented objects. Segments are read by the mailbox datagram directly
+ * into the parameter buffer and the next segment is requested without checking
+ * the slave mailbox first. Only the buffer range of the object is written.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number
+ * @param[in]  index      = Index to read
+ * @param[in]  subindex   = Subindex to read, must be 0 or 1 if CA is used.
+ * @param[in]  CA         = FALSE = single subindex. TRUE = Complete Access, all subindexes read.
+ * @param[in,out] psize   = Size in bytes of parameter buffer, returns bytes read from SDO.
+ * @param[out] p          = Pointer to parameter buffer
+ * @param[out] stat       = transfer statistics, may be NULL
+ * @param[in]  timeout    = Timeout per mailbox cycle in us, standard is NEX_TIMEOUTRXM
+ * @return Workcounter from last slave response
+ */
+int nexx_SDOread_direct(nexx_contextt *context, uint16 slave, uint16 index, uint8 subindex,
+                        boolean CA, int *psize, void *p, nex_SDOstatt *stat, int timeout)
+{
+   return nexx_SDOupload(context, slave, index, subindex, CA, NULL, NULL, psize, p, stat, timeout);
+}
+
+/** CoE SDO write streamed from hook, blocking. Single subindex or Complete Access.
+ *
+ * For objects larger than available memory, the total size must be known. The hook
+ * fills the segments directly in the mailbox buffer. The next segment is read from
+ * the hook while the slave processes the current one, and sent as soon as the slave
+ * responds. Responses are detected with nexx_mbxpoll. If the hook fails the transfer
+ * is aborted.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  Slave      = Slave number
+ * @param[in]  Index      = Index to write
+ * @param[in]  SubIndex   = Subindex to write, must be 0 or 1 if CA is used.
+ * @param[in]  CA         = FALSE = single subindex. TRUE = Complete Access, all subindexes written.
+ * @param[in]  psize      = Size in bytes of object
+ * @param[in]  hook       = supplies data to send, f.e. nexx_FOEstream_fread
+ * @param[in]  arg        = user argument of hook
+ * @param[out] stat       = transfer statistics, may be NULL
+ * @param[in]  Timeout    = Timeout per mailbox cycle in us, standard is NEX_TIMEOUTRXM
+ * @return Workcounter from last slave response
+ */
+int nexx_SDOwrite_stream(nexx_contextt *context, uint16 Slave, uint16 Index, uint8 SubIndex,
+                         boolean CA, int psize, nex_SDOstreamhookt hook, void *arg,
+                         nex_SDOstatt *stat, int Timeout)
+{
+   nex_SDOt *SDOp[2], *aSDOp;
+   nex_mbxbuft MbxIn, MbxOut[2];
+   nex_SDOstatt lstat;
+   nex_timet start;
+   uint8 small[4];
+   int wkc, maxdata, remaining;
+   int framedatasize[2];
+   int sent, next;
+   uint8 toggle;
+   boolean hookerror;
+
+   if (!stat)
    {
-      /* number of available sub indexes */
-      nidx = rdat;
-      bsize = 0;
-      /* read all PDO's */
-      for (idxloop = 1; idxloop <= nidx; idxloop++)
+      stat = &lstat;
+   }
+   memset(stat, 0, sizeof(*stat));
+   start = osal_current_time();
+   stat->size = psize;
+   /* if small data use expedited transfer */
+   if ((psize <= 4) && !CA)
+   {
+      wkc = 0;
+      if (hook(arg, small, psize) != psize)
       {
-         rdl = sizeof(rdat); rdat = 0;
-         /* read PDO assign */
-         wkc = nexx_SDOread(context, Slave, PDOassign, (uint8)idxloop, FALSE, &rdl, &rdat, NEX_TIMEOUTRXM);
-         /* result is index of PDO */
-         idx = etohl(rdat);
-         if (idx > 0)
+         nexx_packeterror(context, Slave, Index, SubIndex, 3); /*  data container too small for type */
+      }
+      else
+      {
+         wkc = nexx_SDOwrite(context, Slave, Index, SubIndex, CA, psize, small, Timeout);
+         if (wkc > 0)
          {
-            rdl = sizeof(subcnt); subcnt = 0;
-            /* read number of subindexes of PDO */
-            wkc = nexx_SDOread(context, Slave,idx, 0x00, FALSE, &rdl, &subcnt, NEX_TIMEOUTRXM);
-            subidx = subcnt;
-            /* for each subindex */
-            for (subidxloop = 1; subidxloop <= subidx; subidxloop++)
-            {
-               rdl = sizeof(rdat2); rdat2 = 0;
-               /* read SDO that is mapped in PDO */
-               wkc = nexx_SDOread(context, Slave, idx, (uint8)subidxloop, FALSE, &rdl, &rdat2, NEX_TIMEOUTRXM);
-               rdat2 = etohl(rdat2);
-               /* extract bitlength of SDO */
-               if (LO_BYTE(rdat2) < 0xff)
+            stat->bytes = psize;
+            stat->segments = 1;
+         }
+      }
+      nexx_SDOstat(&start, stat);
+      return wkc;
+   }
+   /* Empty slave out mailbox if something is in. Timout set to 0 */
+   wkc = nexx_mbxreceive(context, Slave, &MbxIn, 0);
+   aSDOp = (nex_SDOt *)&MbxIn;
+   SDOp[0] = (nex_SDOt *)&MbxOut[0];
+   SDOp[1] = (nex_SDOt *)&MbxOut[1];
+   maxdata = context->slavelist[Slave].mbx_l - 0x10; /* data section=mailbox size - 6 mbx - 2 CoE - 8 sdo req */
+   if (CA && (SubIndex > 1))
+   {
+      SubIndex = 1;
+   }
+   sent = 0;
+   framedatasize[sent] = psize;
+   if (framedatasize[sent] > maxdata)
+   {
+      framedatasize[sent] = maxdata;  /*  segmented transfer needed  */
+   }
+   if (hook(arg, &SDOp[sent]->bdata[4], framedatasize[sent]) != framedatasize[sent])
+   {
+      nexx_packeterror(context, Slave, Index, SubIndex, 3); /*  data container too small for type */
+      nexx_SDOstat(&start, stat);
+      return 0;
+   }
+   nexx_SDOheader(context, Slave, SDOp[sent], (uint16)(0x0a + framedatasize[sent]));
+   SDOp[sent]->Command = CA ? ECT_SDO_DOWN_INIT_CA : ECT_SDO_DOWN_INIT;
+   SDOp[sent]->Index = htoes(Index);
+   SDOp[sent]->SubIndex = SubIndex;
+   SDOp[sent]->ldata[0] = htoel(psize);
+   remaining = psize - framedatasize[sent];
+   /* send mailbox SDO download request to slave */
+   wkc = nexx_mbxsend(context, Slave, &MbxOut[sent], NEX_TIMEOUTTXM);
+   next = 1;
+   maxdata += 7;
+   toggle = 0;
+   hookerror = FALSE;
+   while (wkc > 0)
+   {
+      /* read next segment while slave processes this one */
+      if (remaining)
+      {
+         framedatasize[next] = remaining;
+         if (framedatasize[next] > maxdata)
+         {
+            framedatasize[next] = maxdata;  /*  more segments needed  */
+         }
+         hookerror = (hook(arg, &SDOp[next]->Index, framedatasize[next]) != framedatasize[next]);
+      }
+      wkc = nexx_mbxpoll(context, Slave, &MbxIn, Timeout);
+      if (wkc <= 0)
+      {
+         break;
+      }
+      /* response should be CoE, SDO response, initiate or segment download response */
+      if (((aSDOp->MbxHeader.mbxtype & 0x0f) != ECT_MBXT_COE) ||
+          ((etohs(aSDOp->CANOpen) >> 12) != ECT_COES_SDORES) ||
+          (stat->segments ? ((aSDOp->Command & 0xe0) != 0x20) :
+                            ((aSDOp->Command != 0x60) ||
+                             (aSDOp->Index != htoes(Index)) || (aSDOp->SubIndex != SubIndex))))
+      {
+         if (aSDOp->Command == ECT_SDO_ABORT) /* SDO abort frame received */
+         {
+            nexx_SDOerror(context, Slave, Index, SubIndex, etohl(aSDOp->ldata[0]));
+         }
+         else
+         {
+            nexx_packeterror(context, Slave, Index, SubIndex, 1); /* Unexpected frame returned */
+         }
+         wkc = 0;
+         break;
+      }
+      stat->bytes += framedatasize[sent];
+      stat->segments++;
+      if (!remaining)
+      {
+         break;
+      }
+      if (hookerror)
+      {
+         nexx_SDOabort(context, Slave, Index, SubIndex, NEX_SDO_ABORT_STORE);
+         wkc = 0;
+         break;
+      }
+      remaining -= framedatasize[next];
+      if (!remaining && (framedatasize[next] < 7))
+      {
+         nexx_SDOheader(context, Slave, SDOp[next], 0x0a); /* minimum size */
+         SDOp[next]->Command = 0x01 + ((7 - framedatasize[next]) << 1); /* last segment reduced octets */
+      }
+      else
+      {
+         nexx_SDOheader(context, Slave, SDOp[next], (uint16)(framedatasize[next] + 3)); /* data + 2 CoE + 1 SDO */
+         SDOp[next]->Command = remaining ? 0x00 : 0x01; /* segments follow or last segment */
+      }
+      SDOp[next]->Command = SDOp[next]->Command + toggle; /* add toggle bit to command byte */
+      toggle = toggle ^ 0x10; /* toggle bit for segment request */
+      sent = next;
+      next ^= 1;
+      /* slave consumed the previous segment before responding to it */
+      wkc = nexx_mbxwrite(context, Slave, &MbxOut[sent], NEX_TIMEOUTTXM);
+   }
+   nexx_SDOstat(&start, stat);
+
+   return wkc;
+}
+
+/** Initialise SDO poll list.
+ *
+ * @param[out] poll       = SDO poll list
+ * @param[in]  timeout    = slave response timeout in us, f.e. NEX_TIMEOUTRXM
+ */
+void nexx_SDOpoll_init(nex_SDOpollt *poll, int timeout)
+{
+   int i;
+
+   memset(poll, 0, sizeof(*poll));
+   poll->timeout = timeout;
+   for (i = 0; i < NEX_SDOPOLL_MAXREQ; i++)
+   {
+      poll->req[i].group = -1;
+   }
+}
+
+/** Register entry in SDO poll list. Call before nexx_SDOpoll_start.
+ *
+ * @param[in]  poll       = SDO poll list
+ * @param[in]  slave      = Slave number
+ * @param[in]  index      = Index to read
+ * @param[in]  subindex   = Subindex to read
+ * @param[in]  size       = Size of value in bytes, max NEX_SDOPOLL_MAXDATA
+ * @param[in]  period     = Poll period in us
+ * @return handle of entry, -1 if list is full or size is invalid
+ */
+int nexx_SDOpoll_add(nex_SDOpollt *poll, uint16 slave, uint16 index, uint8 subindex, int size, uint32 period)
+{
+   nex_SDOpollentryt *e;
+
+   if ((poll->nentry >= NEX_SDOPOLL_MAX) || (size <= 0) || (size > NEX_SDOPOLL_MAXDATA) || !period)
+   {
+      return -1;
+   }
+   e = &poll->entry[poll->nentry];
+   memset(e, 0, sizeof(*e));
+   e->slave = slave;
+   e->index = index;
+   e->subindex = subindex;
+   e->size = (uint8)size;
+   e->period = period;
+
+   return poll->nentry++;
+}
+
+/** Microseconds since nexx_SDOpoll_start, wraps after 71 minutes.
+ *
+ * @param[in]  poll       = SDO poll list
+ * @return time in us
+ */
+static uint32 nexx_SDOpoll_now(nex_SDOpollt *poll)
+{
+   nex_timet now, diff;
+
+   now = osal_current_time();
+   osal_time_diff(&poll->start, &now, &diff);
+   return (uint32)(diff.sec * 1000000 + diff.usec);
+}
+
+/** Build transactions and schedule of SDO poll list. Entries of one slave with
+ * identical period form a group that is read in one burst. Consecutive subindexes
+ * of an object starting at subindex 1 are read with one Complete Access upload if
+ * the slave supports it. The response holds all subindexes of the object, if it
+ * does not fit in one mailbox the entries are read one by one instead. Groups
+ * with identical period are spread evenly over the period, in batches of
+ * NEX_SDOPOLL_MAXREQ groups that share frames.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  poll       = SDO poll list
+ * @return number of transactions per cycle of all periods
+ */
+int nexx_SDOpoll_start(nexx_contextt *context, nex_SDOpollt *poll)
+{
+   nex_SDOpollentryt *e, *f;
+   nex_SDOpollgroupt *g;
+   nex_SDOpolltxt *tx;
+   uint8 grouped[NEX_SDOPOLL_MAX];
+   int i, j, k, ng, nb, total, maxca;
+   boolean found;
+
+   memset(grouped, 0, sizeof(grouped));
+   poll->ntx = 0;
+   poll->ngroup = 0;
+   k = 0;
+   for (i = 0; i < poll->nentry; i++)
+   {
+      e = &poll->entry[i];
+      if (grouped[i])
+      {
+         continue;
+      }
+      g = &poll->group[poll->ngroup++];
+      g->slave = e->slave;
+      g->period = e->period;
+      g->firsttx = (uint16)poll->ntx;
+      g->cur = 0;
+      g->req = -1;
+      maxca = 0;
+      if (context->slavelist[e->slave].CoEdetails & ECT_COEDET_SDOCA)
+      {
+         /* Complete Access response must fit in one mailbox */
+         maxca = context->slavelist[e->slave].mbx_rl - 0x10;
+      }
+      for (j = i; j < poll->nentry; j++)
+      {
+         e = &poll->entry[j];
+         if (grouped[j] || (e->slave != g->slave) || (e->period != g->period))
+         {
+            continue;
+         }
+         tx = &poll->tx[poll->ntx++];
+         tx->index = e->index;
+         tx->subindex = e->subindex;
+         tx->CA = FALSE;
+         tx->first = (uint16)k;
+         tx->n = 1;
+         tx->part = 0;
+         poll->order[k++] = (uint16)j;
+         grouped[j] = 1;
+         total = e->size;
+         /* collect following subindexes of the object */
+         found = (e->subindex == 1) && (maxca > 0);
+         while (found)
+         {
+            found = FALSE;
+            for (f = e; (f < &poll->entry[poll->nentry]) && !found; f++)
+            {
+               if (!grouped[f - poll->entry] && (f->slave == g->slave) && (f->period == g->period) &&
+                   (f->index == tx->index) && (f->subindex == (tx->subindex + tx->n)) &&
+                   ((total + f->size) <= maxca))
+               {
+                  found = TRUE;
+                  total += f->size;
+                  tx->CA = TRUE;
+                  tx->n++;
+                  poll->order[k++] = (uint16)(f - poll->entry);
+                  grouped[f - poll->entry] = 1;
+               }
+            }
+         }
+      }
+      g->ntx = (uint16)(poll->ntx - g->firsttx);
+   }
+   /* spread groups of identical period evenly over the period */
+   for (i = 0; i < poll->ngroup; i++)
+   {
+      ng = 0;
+      k = 0;
+      for (j = 0; j < poll->ngroup; j++)
+      {
+         if (poll->group[j].period == poll->group[i].period)
+         {
+            if (j < i)
+            {
+               k++;
+            }
+            ng++;
+         }
+      }
+      nb = (ng + NEX_SDOPOLL_MAXREQ - 1) / NEX_SDOPOLL_MAXREQ;
+      poll->group[i].due = (uint32)(((uint64)poll->group[i].period * (k / NEX_SDOPOLL_MAXREQ)) / nb);
+   }
+   poll->next = 0;
+   poll->start = osal_current_time();
+
+   return poll->ntx;
+}
+
+/** Publish value or abort code of poll entry.
+ *
+ * @param[in]  e          = poll entry
+ * @param[in]  data       = value, NULL to keep last value
+ * @param[in]  size       = size of value
+ * @param[in]  abortcode  = abort code of read
+ */
+static void nexx_SDOpoll_publish(nex_SDOpollentryt *e, uint8 *data, int size, int32 abortcode)
+{
+   nex_timet now;
+   int i;
+
+   /* odd sequence while updating, readers retry */
+   e->seq++;
+   OSAL_MB();
+   if (data)
+   {
+      for (i = 0; i < size; i++)
+      {
+         e->data[i] = data[i];
+      }
+      e->length = (uint8)size;
+      now = osal_current_time();
+      e->time.sec = now.sec;
+      e->time.usec = now.usec;
+      e->updates++;
+   }
+   e->abortcode = abortcode;
+   OSAL_MB();
+   e->seq++;
+}
+
+/** Handle response of SDO poll request.
+ *
+ * @param[in]  poll       = SDO poll list
+ * @param[in]  r          = request with response
+ * @return TRUE if response belongs to request, FALSE to keep waiting
+ */
+static boolean nexx_SDOpoll_response(nex_SDOpollt *poll, nex_SDOpollreqt *r)
+{
+   nex_SDOt *aSDOp;
+   nex_SDOpollgroupt *g;
+   nex_SDOpolltxt *tx;
+   nex_SDOpollentryt *e;
+   uint8 *data;
+   int i, n, size, offset, first, count;
+   int32 SDOlen;
+
+   aSDOp = (nex_SDOt *)&r->mbx;
+   g = &poll->group[r->group];
+   tx = &poll->tx[g->firsttx + g->cur];
+   /* entries answered by this response */
+   first = tx->CA ? 0 : tx->part;
+   count = tx->CA ? tx->n : 1;
+   /* late response of an earlier request or other service */
+   if (((aSDOp->MbxHeader.mbxtype & 0x0f) != ECT_MBXT_COE) ||
+       ((etohs(aSDOp->CANOpen) >> 12) != ECT_COES_SDORES) ||
+       (etohs(aSDOp->Index) != tx->index) ||
+       (aSDOp->SubIndex != poll->entry[poll->order[tx->first + first]].subindex))
+   {
+      return FALSE;
+   }
+   poll->stat.responses++;
+   if (aSDOp->Command == ECT_SDO_ABORT) /* SDO abort frame received */
+   {
+      poll->stat.aborts++;
+      for (i = first; i < (first + count); i++)
+      {
+         nexx_SDOpoll_publish(&poll->entry[poll->order[tx->first + i]], NULL, 0, etohl(aSDOp->ldata[0]));
+      }
+      return TRUE;
+   }
+   if ((aSDOp->Command & 0x02) > 0)
+   {
+      /* expedited frame response */
+      n = 4 - ((aSDOp->Command >> 2) & 0x03);
+      data = &aSDOp->bdata[0];
+   }
+   else
+   {
+      /* normal frame response, segmented transfers are not used */
+      SDOlen = etohl(aSDOp->ldata[0]);
+      n = etohs(aSDOp->MbxHeader.length) - 10;
+      if (SDOlen > n)
+      {
+         poll->stat.errors++;
+         if (tx->CA)
+         {
+            /* object is larger than a mailbox, read the entries one by one from now on */
+            tx->CA = FALSE;
+            tx->part = 0;
+         }
+         return TRUE;
+      }
+      n = SDOlen;
+      data = &aSDOp->bdata[4];
+   }
+   offset = 0;
+   for (i = first; i < (first + count); i++)
+   {
+      e = &poll->entry[poll->order[tx->first + i]];
+      size = e->size;
+      if (!tx->CA && (n < size))
+      {
+         size = n;
+      }
+      if ((offset + size) > n)
+      {
+         poll->stat.errors++;
+         break;
+      }
+      nexx_SDOpoll_publish(e, data + offset, size, 0);
+      offset += size;
+   }
+
+   return TRUE;
+}
+
+/** Finish transaction of group, a burst ends after its last transaction.
+ *
+ * @param[in]  poll       = SDO poll list
+ * @param[in]  g          = group
+ * @param[in]  now        = time in us since start
+ */
+static void nexx_SDOpoll_done(nex_SDOpollt *poll, nex_SDOpollgroupt *g, uint32 now)
+{
+   nex_SDOpolltxt *tx;
+   uint32 missed;
+
+   g->req = -1;
+   tx = &poll->tx[g->firsttx + g->cur];
+   if (!tx->CA && (++tx->part < tx->n))
+   {
+      return;
+   }
+   tx->part = 0;
+   if (++g->cur < g->ntx)
+   {
+      return;
+   }
+   g->cur = 0;
+   g->due += g->period;
+   if ((int32)(now - g->due) >= 0)
+   {
+      /* skip missed bursts, keep the phase */
+      missed = (now - g->due) / g->period + 1;
+      g->due += missed * g->period;
+      poll->stat.late++;
+   }
+}
+
+/** Move SDO poll list forward, non blocking. Responses of all requests in transfer
+ * are read in shared frames and published, then due transactions are written in
+ * shared frames, at most one per slave. Call it periodically from the thread that
+ * does the other mailbox traffic, f.e. in the spare time of the cycle.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  poll       = SDO poll list
+ * @param[in]  maxreq     = budget, max requests written per call
+ * @return number of messages moved
+ */
+int nexx_SDOpoll(nexx_contextt *context, nex_SDOpollt *poll, int maxreq)
+{
+   nex_datagramt lst[NEX_SDOPOLL_MAXREQ];
+   uint16 sllst[NEX_SDOPOLL_MAXREQ];
+   int rli[NEX_SDOPOLL_MAXREQ];
+   nex_SDOpollreqt *r;
+   nex_SDOpollgroupt *g;
+   nex_SDOpolltxt *tx;
+   nex_SDOt *SDOp;
+   uint32 now;
+   int i, j, k, n, moved, slot;
+   boolean busy;
+
+   now = nexx_SDOpoll_now(poll);
+   moved = 0;
+   n = 0;
+   for (i = 0; i < NEX_SDOPOLL_MAXREQ; i++)
+   {
+      r = &poll->req[i];
+      if (r->group < 0)
+      {
+         continue;
+      }
+      if (osal_timer_is_expired(&r->timer))
+      {
+         poll->stat.timeouts++;
+         nexx_SDOpoll_done(poll, &poll->group[r->group], now);
+         r->group = -1;
+      }
+      else
+      {
+         sllst[n] = poll->group[r->group].slave;
+         lst[n].data = &r->mbx;
+         rli[n++] = i;
+      }
+   }
+   if (n)
+   {
+      nexx_mbxpoll_multi(context, n, sllst, lst, NEX_TIMEOUTRET3);
+      for (i = 0; i < n; i++)
+      {
+         r = &poll->req[rli[i]];
+         if ((lst[i].wkc > 0) && nexx_SDOpoll_response(poll, r))
+         {
+            moved++;
+            nexx_SDOpoll_done(poll, &poll->group[r->group], now);
+            r->group = -1;
+         }
+      }
+   }
+   n = 0;
+   for (k = 0; (k < poll->ngroup) && (n < maxreq) && (n < NEX_SDOPOLL_MAXREQ); k++)
+   {
+      /* start with a different group every call to share the budget */
+      i = (poll->next + k) % poll->ngroup;
+      g = &poll->group[i];
+      if ((g->req >= 0) || ((int32)(now - g->due) < 0))
+      {
+         continue;
+      }
+      busy = FALSE;
+      slot = -1;
+      for (j = 0; j < NEX_SDOPOLL_MAXREQ; j++)
+      {
+         if (poll->req[j].group < 0)
+         {
+            if (slot < 0)
+            {
+               slot = j;
+            }
+         }
+         else if (poll->group[poll->req[j].group].slave == g->slave)
+         {
+            busy = TRUE;
+         }
+      }
+      if (slot < 0)
+      {
+         break;
+      }
+      if (busy)
+      {
+         continue;
+      }
+      r = &poll->req[slot];
+      r->group = i;
+      g->req = (int16)slot;
+      tx = &poll->tx[g->firsttx + g->cur];
+      SDOp = (nex_SDOt *)&r->mbx;
+      nexx_SDOheader(context, g->slave, SDOp, 0x000a);
+      SDOp->Command = tx->CA ? ECT_SDO_UP_REQ_CA : ECT_SDO_UP_REQ;
+      SDOp->Index = htoes(tx->index);
+      SDOp->SubIndex = tx->CA ? tx->subindex : poll->entry[poll->order[tx->first + tx->part]].subindex;
+      SDOp->ldata[0] = 0;
+      sllst[n] = g->slave;
+      lst[n].data = &r->mbx;
+      rli[n++] = slot;
+   }
+   if (poll->ngroup)
+   {
+      poll->next = (poll->next + 1) % poll->ngroup;
+   }
+   if (n)
+   {
+      nexx_mbxwrite_multi(context, n, sllst, lst, NEX_TIMEOUTRET3);
+      for (i = 0; i < n; i++)
+      {
+         r = &poll->req[rli[i]];
+         g = &poll->group[r->group];
+         if ((lst[i].wkc > 0) || (lst[i].wkc == NEX_NOFRAME))
+         {
+            /* after a lost frame the request is probably in the slave, wait for
+               the response or the timeout */
+            osal_timer_start(&r->timer, poll->timeout);
+            poll->stat.requests++;
+            if (poll->tx[g->firsttx + g->cur].CA)
+            {
+               poll->stat.careads++;
+            }
+            moved++;
+         }
+         else
+         {
+            /* mailbox still full, try again next poll */
+            g->req = -1;
+            r->group = -1;
+         }
+      }
+   }
+
+   return moved;
+}
+
+/** Read last value of SDO poll entry, lock free. Can be called from any thread,
+ * retries while the poller updates the value.
+ *
+ * @param[in]  poll       = SDO poll list
+ * @param[in]  handle     = handle from nexx_SDOpoll_add
+ * @param[out] p          = value, size of entry
+ * @param[out] time       = time of value, may be NULL
+ * @return bytes of value, 0 if not read yet
+ */
+int nexx_SDOpoll_get(nex_SDOpollt *poll, int handle, void *p, nex_timet *time)
+{
+   nex_SDOpollentryt *e;
+   uint32 seq;
+   uint8 *bp;
+   int i, length;
+
+   e = &poll->entry[handle];
+   bp = (uint8 *)p;
+   do
+   {
+      seq = e->seq;
+      OSAL_MB();
+      length = e->length;
+      for (i = 0; i < length; i++)
+      {
+         bp[i] = e->data[i];
+      }
+      if (time)
+      {
+         time->sec = e->time.sec;
+         time->usec = e->time.usec;
+      }
+      OSAL_MB();
+   } while ((seq & 1) || (seq != e->seq));
+
+   return length;
+}
+
+/** CoE RxPDO write, blocking.
+ *
+ * A RxPDO download request is issued.
+ *
+ * @param[in]  context       = context struct
+ * @param[in]  Slave         = Slave number
+ * @param[in]  RxPDOnumber   = Related RxPDO number
+ * @param[in]  psize         = Size in bytes of PDO buffer.
+ * @param[out] p             = Pointer to PDO buffer
+ * @return Workcounter from last slave response
+ */
+int nexx_RxPDO(nexx_contextt *context, uint16 Slave, uint16 RxPDOnumber, int psize, void *p)
+{
+   nex_SDOt *SDOp;
+   int wkc, maxdata;
+   nex_mbxbuft MbxIn, MbxOut;
+   uint8 cnt;
+   uint16 framedatasize;
+
+   nex_clearmbx(&MbxIn);
+   /* Empty slave out mailbox if something is in. Timout set to 0 */
+   wkc = nexx_mbxreceive(context, Slave, (nex_mbxbuft *)&MbxIn, 0);
+   nex_clearmbx(&MbxOut);
+   SDOp = (nex_SDOt *)&MbxOut;
+   maxdata = context->slavelist[Slave].mbx_l - 0x08; /* data section=mailbox size - 6 mbx - 2 CoE */
+   framedatasize = psize;
+   if (framedatasize > maxdata)
+   {
+      framedatasize = maxdata;  /*  limit transfer */
+   }
+   SDOp->MbxHeader.length = htoes(0x02 + framedatasize);
+   SDOp->MbxHeader.address = htoes(0x0000);
+   SDOp->MbxHeader.priority = 0x00;
+   /* get new mailbox counter, used for session handle */
+   cnt = nex_nextmbxcnt(context->slavelist[Slave].mbx_cnt);
+   context->slavelist[Slave].mbx_cnt = cnt;
+   SDOp->MbxHeader.mbxtype = ECT_MBXT_COE + (cnt << 4); /* CoE */
+   SDOp->CANOpen = htoes((RxPDOnumber & 0x01ff) + (ECT_COES_RXPDO << 12)); /* number 9bits service upper 4 bits */
+   /* copy PDO data to mailbox */
+   memcpy(&SDOp->Command, p, framedatasize);
+   /* send mailbox RxPDO request to slave */
+   wkc = nexx_mbxsend(context, Slave, (nex_mbxbuft *)&MbxOut, NEX_TIMEOUTTXM);
+
+   return wkc;
+}
+
+/** CoE TxPDO read remote request, blocking.
+ *
+ * A RxPDO download request is issued.
+ *
+ * @param[in]  context       = context struct
+ * @param[in]  slave         = Slave number
+ * @param[in]  TxPDOnumber   = Related TxPDO number
+ * @param[in,out] psize      = Size in bytes of PDO buffer, returns bytes read from PDO.
+ * @param[out] p             = Pointer to PDO buffer
+ * @param[in]  timeout       = Timeout in us, standard is NEX_TIMEOUTRXM
+ * @return Workcounter from last slave response
+ */
+int nexx_TxPDO(nexx_contextt *context, uint16 slave, uint16 TxPDOnumber , int *psize, void *p, int timeout)
+{
+   nex_SDOt *SDOp, *aSDOp;
+   int wkc;
+   nex_mbxbuft MbxIn, MbxOut;
+   uint8 cnt;
+   uint16 framedatasize;
+
+   nex_clearmbx(&MbxIn);
+   /* Empty slave out mailbox if something is in. Timout set to 0 */
+   wkc = nexx_mbxreceive(context, slave, (nex_mbxbuft *)&MbxIn, 0);
+   nex_clearmbx(&MbxOut);
+   aSDOp = (nex_SDOt *)&MbxIn;
+   SDOp = (nex_SDOt *)&MbxOut;
+   SDOp->MbxHeader.length = htoes(0x02);
+   SDOp->MbxHeader.address = htoes(0x0000);
+   SDOp->MbxHeader.priority = 0x00;
+   /* get new mailbox counter, used for session handle */
+   cnt = nex_nextmbxcnt(context->slavelist[slave].mbx_cnt);
+   context->slavelist[slave].mbx_cnt = cnt;
+   SDOp->MbxHeader.mbxtype = ECT_MBXT_COE + (cnt << 4); /* CoE */
+   SDOp->CANOpen = htoes((TxPDOnumber & 0x01ff) + (ECT_COES_TXPDO_RR << 12)); /* number 9bits service upper 4 bits */
+   wkc = nexx_mbxsend(context, slave, (nex_mbxbuft *)&MbxOut, NEX_TIMEOUTTXM);
+   if (wkc > 0)
+   {
+      /* clean mailboxbuffer */
+      nex_clearmbx(&MbxIn);
+      /* read slave response */
+      wkc = nexx_mbxreceive(context, slave, (nex_mbxbuft *)&MbxIn, timeout);
+      if (wkc > 0) /* succeeded to read slave response ? */
+      {
+         /* slave response should be CoE, TxPDO */
+         if (((aSDOp->MbxHeader.mbxtype & 0x0f) == ECT_MBXT_COE) &&
+             ((etohs(aSDOp->CANOpen) >> 12) == ECT_COES_TXPDO))
+         {
+            /* TxPDO response */
+            framedatasize = (aSDOp->MbxHeader.length - 2);
+            if (*psize >= framedatasize) /* parameter buffer big enough ? */
+            {
+               /* copy parameter in parameter buffer */
+               memcpy(p, &aSDOp->Command, framedatasize);
+               /* return the real parameter size */
+               *psize = framedatasize;
+            }
+            /* parameter buffer too small */
+            else
+            {
+               wkc = 0;
+               nexx_packeterror(context, slave, 0, 0, 3); /*  data container too small for type */
+            }
+         }
+         /* other slave response */
+         else
+         {
+            if ((aSDOp->Command) == ECT_SDO_ABORT) /* SDO abort frame received */
+            {
+               nexx_SDOerror(context, slave, 0, 0, etohl(aSDOp->ldata[0]));
+            }
+            else
+            {
+               nexx_packeterror(context, slave, 0, 0, 1); /* Unexpected frame returned */
+            }
+            wkc = 0;
+         }
+      }
+   }
+
+   return wkc;
+}
+
+/** Read PDO assign structure
+ * @param[in]  context       = context struct
+ * @param[in]  Slave         = Slave number
+ * @param[in]  PDOassign     = PDO assign object
+ * @return total bitlength of PDO assign
+ */
+int nexx_readPDOassign(nexx_contextt *context, uint16 Slave, uint16 PDOassign)
+{
+   uint16 idxloop, nidx, subidxloop, rdat, idx, subidx;
+   uint8 subcnt;
+   int wkc, bsize = 0, rdl;
+   int32 rdat2;
+
+   rdl = sizeof(rdat); rdat = 0;
+   /* read PDO assign subindex 0 ( = number of PDO's) */
+   wkc = nexx_SDOread(context, Slave, PDOassign, 0x00, FALSE, &rdl, &rdat, NEX_TIMEOUTRXM);
+   rdat = etohs(rdat);
+   /* positive result from slave ? */
+   if ((wkc > 0) && (rdat > 0))
+   {
+      /* number of available sub indexes */
+      nidx = rdat;
+      bsize = 0;
+      /* read all PDO's */
+      for (idxloop = 1; idxloop <= nidx; idxloop++)
+      {
+         rdl = sizeof(rdat); rdat = 0;
+         /* read PDO assign */
+         wkc = nexx_SDOread(context, Slave, PDOassign, (uint8)idxloop, FALSE, &rdl, &rdat, NEX_TIMEOUTRXM);
+         /* result is index of PDO */
+         idx = etohl(rdat);
+         if (idx > 0)
+         {
+            rdl = sizeof(subcnt); subcnt = 0;
+            /* read number of subindexes of PDO */
+            wkc = nexx_SDOread(context, Slave,idx, 0x00, FALSE, &rdl, &subcnt, NEX_TIMEOUTRXM);
+            subidx = subcnt;
+            /* for each subindex */
+            for (subidxloop = 1; subidxloop <= subidx; subidxloop++)
+            {
+               rdl = sizeof(rdat2); rdat2 = 0;
+               /* read SDO that is mapped in PDO */
+               wkc = nexx_SDOread(context, Slave, idx, (uint8)subidxloop, FALSE, &rdl, &rdat2, NEX_TIMEOUTRXM);
+               rdat2 = etohl(rdat2);
+               /* extract bitlength of SDO */
+               if (LO_BYTE(rdat2) < 0xff)
                {
                   bsize += LO_BYTE(rdat2);
                }
@@ -1102,9 +2089,79 @@ int nexx_readODlist(nexx_contextt *context, uint16 Slave, nex_ODlistt *pODlist)
          }
          x++;
       }
-      while ((x <= 128) && !stop);
+      while ((x <= 128) && !stop);
+   }
+   return wkc;
+}
+
+/** Prepare SDO info get object description request.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  Slave      = Slave number
+ * @param[in]  Index      = Index of object
+ * @param[out] MbxOut     = mailbox with request
+ */
+static void nexx_ODdescrequest(nexx_contextt *context, uint16 Slave, uint16 Index, nex_mbxbuft *MbxOut)
+{
+   nex_SDOservicet *SDOp;
+   uint8 cnt;
+
+   nex_clearmbx(MbxOut);
+   SDOp = (nex_SDOservicet*)MbxOut;
+   SDOp->MbxHeader.length = htoes(0x0008);
+   SDOp->MbxHeader.address = htoes(0x0000);
+   SDOp->MbxHeader.priority = 0x00;
+   /* Get new mailbox counter value */
+   cnt = nex_nextmbxcnt(context->slavelist[Slave].mbx_cnt);
+   context->slavelist[Slave].mbx_cnt = cnt;
+   SDOp->MbxHeader.mbxtype = ECT_MBXT_COE + (cnt << 4); /* CoE */
+   SDOp->CANOpen = htoes(0x000 + (ECT_COES_SDOINFO << 12)); /* number 9bits service upper 4 bits */
+   SDOp->Opcode = ECT_GET_OD_REQ; /* get object description request */
+   SDOp->Reserved = 0;
+   SDOp->Fragments = 0; /* fragments left */
+   SDOp->wdata[0] = htoes(Index); /* Data of Index */
+}
+
+/** Parse SDO info get object description response into ODlist.
+ *
+ * @param[in]  context       = context struct
+ * @param[in]  MbxIn         = mailbox with response
+ * @param[in]  Item          = Item number in ODlist.
+ * @param[in,out] pODlist    = referencing Object Description list.
+ * @return 1 if description is valid, 0 on error response.
+ */
+static int nexx_ODdescresponse(nexx_contextt *context, nex_mbxbuft *MbxIn, uint16 Item, nex_ODlistt *pODlist)
+{
+   nex_SDOservicet *aSDOp;
+   uint16 n;
+
+   aSDOp = (nex_SDOservicet*)MbxIn;
+   if (((aSDOp->MbxHeader.mbxtype & 0x0f) == ECT_MBXT_COE) &&
+       ((aSDOp->Opcode & 0x7f) == ECT_GET_OD_RES))
+   {
+      n = (etohs(aSDOp->MbxHeader.length) - 12); /* length of string(name of object) */
+      if (n > NEX_MAXNAME)
+      {
+         n = NEX_MAXNAME; /* max chars */
+      }
+      pODlist->DataType[Item] = etohs(aSDOp->wdata[1]);
+      pODlist->ObjectCode[Item] = aSDOp->bdata[5];
+      pODlist->MaxSub[Item] = aSDOp->bdata[4];
+
+      memcpy(pODlist->Name[Item], &aSDOp->bdata[6], n);
+      pODlist->Name[Item][n] = 0x00; /* String terminator */
+      return 1;
    }
-   return wkc;
+   /* got unexpected response from slave */
+   if (((aSDOp->Opcode & 0x7f) == ECT_SDOINFO_ERROR)) /* SDO info error received */
+   {
+      nexx_SDOinfoerror(context, pODlist->Slave, pODlist->Index[Item], 0, etohl(aSDOp->ldata[0]));
+   }
+   else
+   {
+      nexx_packeterror(context, pODlist->Slave, pODlist->Index[Item], 0, 1); /* Unexpected frame returned */
+   }
+   return 0;
 }
 
 /** CoE read Object Description. Adds textual description to object indexes.
@@ -1116,11 +2173,9 @@ int nexx_readODlist(nexx_contextt *context, uint16 Slave, nex_ODlistt *pODlist)
  */
 int nexx_readODdescription(nexx_contextt *context, uint16 Item, nex_ODlistt *pODlist)
 {
-   nex_SDOservicet *SDOp, *aSDOp;
    int wkc;
-   uint16  n, Slave;
+   uint16 Slave;
    nex_mbxbuft MbxIn, MbxOut;
-   uint8 cnt;
 
    Slave = pODlist->Slave;
    pODlist->DataType[Item] = 0;
@@ -1130,10 +2185,41 @@ int nexx_readODdescription(nexx_contextt *context, uint16 Item, nex_ODlistt *pOD
    nex_clearmbx(&MbxIn);
    /* clear pending out mailbox in slave if available. Timeout is set to 0 */
    wkc = nexx_mbxreceive(context, Slave, &MbxIn, 0);
-   nex_clearmbx(&MbxOut);
-   aSDOp = (nex_SDOservicet*)&MbxIn;
-   SDOp = (nex_SDOservicet*)&MbxOut;
-   SDOp->MbxHeader.length = htoes(0x0008);
+   nexx_ODdescrequest(context, Slave, pODlist->Index[Item], &MbxOut);
+   /* send get object description request to slave */
+   wkc = nexx_mbxsend(context, Slave, &MbxOut, NEX_TIMEOUTTXM);
+   /* mailbox placed in slave ? */
+   if (wkc > 0)
+   {
+      nex_clearmbx(&MbxIn);
+      /* read slave response */
+      wkc = nexx_mbxreceive(context, Slave, &MbxIn, NEX_TIMEOUTRXM);
+      /* got response ? */
+      if ((wkc > 0) && !nexx_ODdescresponse(context, &MbxIn, Item, pODlist))
+      {
+         wkc = 0;
+      }
+   }
+
+   return wkc;
+}
+
+/** Prepare SDO info get object entry description request.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  Slave      = Slave number
+ * @param[in]  Index      = Index of object
+ * @param[in]  SubI       = Subindex of entry
+ * @param[out] MbxOut     = mailbox with request
+ */
+static void nexx_OErequest(nexx_contextt *context, uint16 Slave, uint16 Index, uint8 SubI, nex_mbxbuft *MbxOut)
+{
+   nex_SDOservicet *SDOp;
+   uint8 cnt;
+
+   nex_clearmbx(MbxOut);
+   SDOp = (nex_SDOservicet*)MbxOut;
+   SDOp->MbxHeader.length = htoes(0x000a);
    SDOp->MbxHeader.address = htoes(0x0000);
    SDOp->MbxHeader.priority = 0x00;
    /* Get new mailbox counter value */
@@ -1141,11 +2227,101 @@ int nexx_readODdescription(nexx_contextt *context, uint16 Item, nex_ODlistt *pOD
    context->slavelist[Slave].mbx_cnt = cnt;
    SDOp->MbxHeader.mbxtype = ECT_MBXT_COE + (cnt << 4); /* CoE */
    SDOp->CANOpen = htoes(0x000 + (ECT_COES_SDOINFO << 12)); /* number 9bits service upper 4 bits */
-   SDOp->Opcode = ECT_GET_OD_REQ; /* get object description request */
+   SDOp->Opcode = ECT_GET_OE_REQ; /* get object entry description request */
    SDOp->Reserved = 0;
-   SDOp->Fragments = 0; /* fragments left */
-   SDOp->wdata[0] = htoes(pODlist->Index[Item]); /* Data of Index */
-   /* send get object description request to slave */
+   SDOp->Fragments = 0;      /* fragments left */
+   SDOp->wdata[0] = htoes(Index);      /* Index */
+   SDOp->bdata[2] = SubI;       /* SubIndex */
+   SDOp->bdata[3] = 1 + 2 + 4; /* get access rights, object category, PDO */
+}
+
+/** Parse SDO info get object entry description response.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  Slave      = Slave number
+ * @param[in]  Index      = Index of object
+ * @param[in]  SubI       = Subindex of entry
+ * @param[in]  MbxIn      = mailbox with response
+ * @param[out] pOE        = resulting object entry
+ * @return 1 if entry is valid, 0 on error response.
+ */
+static int nexx_OEresponse(nexx_contextt *context, uint16 Slave, uint16 Index, uint8 SubI,
+                           nex_mbxbuft *MbxIn, nex_ODcacheOEt *pOE)
+{
+   nex_SDOservicet *aSDOp;
+   int16 n;
+
+   aSDOp = (nex_SDOservicet*)MbxIn;
+   if (((aSDOp->MbxHeader.mbxtype & 0x0f) == ECT_MBXT_COE) &&
+       ((aSDOp->Opcode &  0x7f) == ECT_GET_OE_RES))
+   {
+      n = (etohs(aSDOp->MbxHeader.length) - 16); /* length of string(name of object) */
+      if (n > NEX_MAXNAME)
+      {
+         n = NEX_MAXNAME; /* max string length */
+      }
+      if (n < 0 )
+      {
+         n = 0;
+      }
+      pOE->Valid = TRUE;
+      pOE->ValueInfo = aSDOp->bdata[3];
+      pOE->DataType = etohs(aSDOp->wdata[2]);
+      pOE->BitLength = etohs(aSDOp->wdata[3]);
+      pOE->ObjAccess = etohs(aSDOp->wdata[4]);
+
+      memcpy(pOE->Name, &aSDOp->wdata[5], n);
+      pOE->Name[n] = 0x00; /* string terminator */
+      return 1;
+   }
+   /* got unexpected response from slave */
+   if (((aSDOp->Opcode & 0x7f) == ECT_SDOINFO_ERROR)) /* SDO info error received */
+   {
+      nexx_SDOinfoerror(context, Slave, Index, SubI, etohl(aSDOp->ldata[0]));
+   }
+   else
+   {
+      nexx_packeterror(context, Slave, Index, SubI, 1); /* Unexpected frame returned */
+   }
+   return 0;
+}
+
+/** Copy object entry to subindex of object entry list */
+static void nexx_OEcopy(nex_ODcacheOEt *pOE, uint8 SubI, nex_OElistt *pOElist)
+{
+   pOElist->Entries++;
+   pOElist->ValueInfo[SubI] = pOE->ValueInfo;
+   pOElist->DataType[SubI] = pOE->DataType;
+   pOElist->BitLength[SubI] = pOE->BitLength;
+   pOElist->ObjAccess[SubI] = pOE->ObjAccess;
+   strcpy(pOElist->Name[SubI], pOE->Name);
+}
+
+/** CoE read SDO service object entry, single subindex.
+ * Used in nex_readOE().
+ *
+ * @param[in]  context       = context struct
+ * @param[in] Item           = Item in ODlist.
+ * @param[in] SubI           = Subindex of item in ODlist.
+ * @param[in] pODlist        = Object description list for reference.
+ * @param[out] pOElist       = resulting object entry structure.
+ * @return Workcounter of slave response.
+ */
+int nexx_readOEsingle(nexx_contextt *context, uint16 Item, uint8 SubI, nex_ODlistt *pODlist, nex_OElistt *pOElist)
+{
+   int wkc;
+   uint16 Index, Slave;
+   nex_mbxbuft MbxIn, MbxOut;
+   nex_ODcacheOEt OE;
+
+   wkc = 0;
+   Slave = pODlist->Slave;
+   Index = pODlist->Index[Item];
+   nex_clearmbx(&MbxIn);
+   /* clear pending out mailbox in slave if available. Timeout is set to 0 */
+   wkc = nexx_mbxreceive(context, Slave, &MbxIn, 0);
+   nexx_OErequest(context, Slave, Index, SubI, &MbxOut);
+   /* send get object entry description request to slave */
    wkc = nexx_mbxsend(context, Slave, &MbxOut, NEX_TIMEOUTTXM);
    /* mailbox placed in slave ? */
    if (wkc > 0)
@@ -1156,158 +2332,688 @@ int nexx_readODdescription(nexx_contextt *context, uint16 Item, nex_ODlistt *pOD
       /* got response ? */
       if (wkc > 0)
       {
-         if (((aSDOp->MbxHeader.mbxtype & 0x0f) == ECT_MBXT_COE) &&
-             ((aSDOp->Opcode & 0x7f) == ECT_GET_OD_RES))
+         if (nexx_OEresponse(context, Slave, Index, SubI, &MbxIn, &OE))
+         {
+            nexx_OEcopy(&OE, SubI, pOElist);
+         }
+         else
+         {
+            wkc = 0;
+         }
+      }
+   }
+
+   return wkc;
+}
+
+/** CoE read SDO service object entry.
+ *
+ * @param[in] context        = context struct
+ * @param[in] Item           = Item in ODlist.
+ * @param[in] pODlist        = Object description list for reference.
+ * @param[out] pOElist       = resulting object entry structure.
+ * @return Workcounter of slave response.
+ */
+int nexx_readOE(nexx_contextt *context, uint16 Item, nex_ODlistt *pODlist, nex_OElistt *pOElist)
+{
+   uint16 SubCount;
+   int wkc;
+   uint8 SubI;
+
+   wkc = 0;
+   pOElist->Entries = 0;
+   SubI = pODlist->MaxSub[Item];
+   /* for each entry found in ODlist */
+   for (SubCount = 0; SubCount <= SubI; SubCount++)
+   {
+      /* read subindex of entry */
+      wkc = nexx_readOEsingle(context, Item, (uint8)SubCount, pODlist, pOElist);
+   }
+
+   return wkc;
+}
+
+/** max number of lost responses before an OD cache fetch of a slave is aborted */
+#define NEX_ODCACHE_MAXLOST  3
+/** OD cache file identifier and version */
+#define NEX_ODCACHE_MAGIC    0x444f584eU
+#define NEX_ODCACHE_VERSION  1
+
+/** OD cache fetch job, one slave per identity */
+typedef struct
+{
+   uint16  slave;
+   nex_ODcachetypet *type;
+   /** TRUE if job is finished */
+   boolean done;
+   /** TRUE if request is placed in slave mailbox */
+   boolean busy;
+   /** TRUE if stale response may be in slave mailbox */
+   boolean flush;
+   /** TRUE if object entries are read, otherwise object descriptions */
+   boolean OEphase;
+   /** read object entries after descriptions */
+   boolean withOE;
+   uint16  item;
+   uint8   sub;
+   uint8   lost;
+} nex_ODcachejobt;
+
+/** Check that a mailbox answers the current request of a fetch job. A
+ * response to a request that was lost before can arrive late, it names
+ * another object or subindex.
+ *
+ * @param[in]  job        = fetch job
+ * @param[in]  MbxIn      = mailbox read from slave
+ * @return TRUE if the mailbox is the response to the current request.
+ */
+static boolean nexx_ODcache_matches(nex_ODcachejobt *job, nex_mbxbuft *MbxIn)
+{
+   nex_SDOservicet *aSDOp;
+   uint8 opcode;
+
+   aSDOp = (nex_SDOservicet*)MbxIn;
+   opcode = aSDOp->Opcode & 0x7f;
+   if (((aSDOp->MbxHeader.mbxtype & 0x0f) != ECT_MBXT_COE) || (opcode == ECT_SDOINFO_ERROR))
+   {
+      return TRUE;
+   }
+   if (etohs(aSDOp->wdata[0]) != job->type->ODlist.Index[job->item])
+   {
+      return FALSE;
+   }
+   if (job->OEphase)
+   {
+      return (opcode == ECT_GET_OE_RES) && (aSDOp->bdata[2] == job->sub);
+   }
+   return (opcode == ECT_GET_OD_RES);
+}
+
+/** Initialise OD cache.
+ *
+ * @param[out] cache      = OD cache
+ * @param[in]  OEpool     = storage for object entries, NULL if only object descriptions are cached
+ * @param[in]  OEpoolsize = number of entries in OEpool
+ */
+void nexx_ODcache_init(nex_ODcachet *cache, nex_ODcacheOEt *OEpool, int32 OEpoolsize)
+{
+   memset(cache, 0, sizeof(*cache));
+   cache->OEpool = OEpool;
+   cache->OEpoolsize = OEpool ? OEpoolsize : 0;
+}
+
+/** Lookup identity in OD cache, including identities not yet fetched.
+ *
+ * @param[in]  cache      = OD cache
+ * @param[in]  man        = manufacturer from SII
+ * @param[in]  id         = ID from SII
+ * @param[in]  rev        = revision from SII
+ * @return cache entry or NULL if not present.
+ */
+static nex_ODcachetypet *nexx_ODcache_lookup(nex_ODcachet *cache, uint32 man, uint32 id, uint32 rev)
+{
+   int i;
+
+   for (i = 0; i < cache->ntype; i++)
+   {
+      if ((cache->type[i].eep_man == man) &&
+          (cache->type[i].eep_id == id) &&
+          (cache->type[i].eep_rev == rev))
+      {
+         return &cache->type[i];
+      }
+   }
+   return NULL;
+}
+
+/** Find cached object dictionary of slave by its identity.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  cache      = OD cache
+ * @param[in]  Slave      = Slave number
+ * @return cache entry or NULL if not cached.
+ */
+nex_ODcachetypet *nexx_ODcache_find(nexx_contextt *context, nex_ODcachet *cache, uint16 Slave)
+{
+   nex_slavet *slave;
+   nex_ODcachetypet *type;
+
+   slave = &context->slavelist[Slave];
+   type = nexx_ODcache_lookup(cache, slave->eep_man, slave->eep_id, slave->eep_rev);
+   if (type && type->state)
+   {
+      return type;
+   }
+   return NULL;
+}
+
+/** Reserve object entries of all objects of job in OE pool.
+ *
+ * @param[in]  cache      = OD cache
+ * @param[in]  type       = cache entry
+ * @return TRUE if pool has room.
+ */
+static boolean nexx_ODcache_reserve(nex_ODcachet *cache, nex_ODcachetypet *type)
+{
+   int32 total;
+   uint16 i;
+
+   total = 0;
+   for (i = 0; i < type->ODlist.Entries; i++)
+   {
+      total += type->ODlist.MaxSub[i] + 1;
+   }
+   if ((cache->OEused + total) > cache->OEpoolsize)
+   {
+      return FALSE;
+   }
+   for (i = 0; i < type->ODlist.Entries; i++)
+   {
+      type->OEoffset[i] = cache->OEused;
+      cache->OEused += type->ODlist.MaxSub[i] + 1;
+   }
+   memset(&cache->OEpool[type->OEoffset[0]], 0, total * sizeof(nex_ODcacheOEt));
+   return TRUE;
+}
+
+/** Advance job to next request, update cache state at end of a phase.
+ *
+ * @param[in]  cache      = OD cache
+ * @param[in,out] job     = fetch job
+ */
+static void nexx_ODcache_advance(nex_ODcachet *cache, nex_ODcachejobt *job)
+{
+   nex_ODcachetypet *type = job->type;
+
+   if (job->OEphase)
+   {
+      if (++job->sub <= type->ODlist.MaxSub[job->item])
+      {
+         return;
+      }
+      job->sub = 0;
+   }
+   if (++job->item < type->ODlist.Entries)
+   {
+      return;
+   }
+   if (job->OEphase)
+   {
+      type->state = NEX_ODCACHE_OE;
+      job->done = TRUE;
+      return;
+   }
+   type->state = NEX_ODCACHE_OD;
+   job->item = 0;
+   job->sub = 0;
+   job->OEphase = TRUE;
+   job->done = !job->withOE || !type->ODlist.Entries || !nexx_ODcache_reserve(cache, type);
+}
+
+/** Fetch object dictionaries into OD cache. One slave of every identity is read,
+ * requests to different slaves are placed in their mailboxes before the responses
+ * are collected so the slaves process them in parallel.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  cache      = OD cache
+ * @param[in]  only       = Slave number to fetch, 0 = all CoE slaves
+ * @param[in]  withOE     = TRUE to read object entries as well
+ * @return number of identities fetched.
+ */
+static int nexx_ODcache_run(nexx_contextt *context, nex_ODcachet *cache, uint16 only, boolean withOE)
+{
+   nex_ODcachejobt job[NEX_ODCACHE_MAXTYPE];
+   nex_ODcachejobt *jp;
+   nex_ODcachetypet *type;
+   nex_slavet *slave;
+   nex_mbxbuft MbxIn, MbxOut;
+   nex_ODcacheOEt *pOE;
+   int njob, j, wkc, active, fetched;
+   uint16 Slave, Index;
+
+   njob = 0;
+   for (Slave = 1; Slave <= *(context->slavecount); Slave++)
+   {
+      slave = &context->slavelist[Slave];
+      if ((only && (Slave != only)) ||
+          (!only && !(slave->mbx_proto & ECT_MBXPROT_COE)) ||
+          (!slave->eep_man && !slave->eep_id))
+      {
+         continue;
+      }
+      type = nexx_ODcache_lookup(cache, slave->eep_man, slave->eep_id, slave->eep_rev);
+      if (type)
+      {
+         if ((type->state == NEX_ODCACHE_OE) || ((type->state == NEX_ODCACHE_OD) && !withOE))
+         {
+            continue;
+         }
+         for (j = 0; (j < njob) && (job[j].type != type); j++);
+         if (j < njob)
+         {
+            continue;
+         }
+      }
+      else if (cache->ntype < NEX_ODCACHE_MAXTYPE)
+      {
+         type = &cache->type[cache->ntype++];
+         memset(type, 0, sizeof(*type));
+         type->eep_man = slave->eep_man;
+         type->eep_id = slave->eep_id;
+         type->eep_rev = slave->eep_rev;
+      }
+      else
+      {
+         continue;
+      }
+      jp = &job[njob++];
+      memset(jp, 0, sizeof(*jp));
+      jp->slave = Slave;
+      jp->type = type;
+      jp->withOE = withOE;
+   }
+   fetched = 0;
+   /* object list of every identity, resume with object entries if descriptions are cached */
+   for (j = 0; j < njob; j++)
+   {
+      jp = &job[j];
+      if (jp->type->state == NEX_ODCACHE_OD)
+      {
+         jp->OEphase = TRUE;
+         jp->done = !jp->type->ODlist.Entries || !nexx_ODcache_reserve(cache, jp->type);
+         continue;
+      }
+      wkc = nexx_readODlist(context, jp->slave, &jp->type->ODlist);
+      cache->requests++;
+      if (wkc <= 0)
+      {
+         jp->done = TRUE;
+      }
+      else if (!jp->type->ODlist.Entries)
+      {
+         jp->type->state = NEX_ODCACHE_OE;
+         jp->done = TRUE;
+      }
+   }
+   do
+   {
+      active = 0;
+      /* place next request of every job in its slave mailbox */
+      for (j = 0; j < njob; j++)
+      {
+         jp = &job[j];
+         if (jp->done)
+         {
+            continue;
+         }
+         if (jp->flush)
+         {
+            nex_clearmbx(&MbxIn);
+            nexx_mbxreceive(context, jp->slave, &MbxIn, 0);
+            jp->flush = FALSE;
+         }
+         Index = jp->type->ODlist.Index[jp->item];
+         if (jp->OEphase)
          {
-            n = (etohs(aSDOp->MbxHeader.length) - 12); /* length of string(name of object) */
-            if (n > NEX_MAXNAME)
-            {
-               n = NEX_MAXNAME; /* max chars */
-            }
-            pODlist->DataType[Item] = etohs(aSDOp->wdata[1]);
-            pODlist->ObjectCode[Item] = aSDOp->bdata[5];
-            pODlist->MaxSub[Item] = aSDOp->bdata[4];
-
-            strncpy(pODlist->Name[Item] , (char *)&aSDOp->bdata[6], n);
-            pODlist->Name[Item][n] = 0x00; /* String terminator */
+            nexx_OErequest(context, jp->slave, Index, jp->sub, &MbxOut);
+         }
+         else
+         {
+            nexx_ODdescrequest(context, jp->slave, Index, &MbxOut);
+         }
+         wkc = nexx_mbxsend(context, jp->slave, &MbxOut, NEX_TIMEOUTTXM);
+         if (wkc > 0)
+         {
+            jp->busy = TRUE;
+            cache->requests++;
          }
-         /* got unexpected response from slave */
          else
          {
-            if (((aSDOp->Opcode & 0x7f) == ECT_SDOINFO_ERROR)) /* SDO info error received */
+            jp->done = TRUE;
+         }
+      }
+      /* collect responses, the other slaves keep working on theirs meanwhile */
+      for (j = 0; j < njob; j++)
+      {
+         jp = &job[j];
+         if (!jp->busy)
+         {
+            continue;
+         }
+         jp->busy = FALSE;
+         type = jp->type;
+         nex_clearmbx(&MbxIn);
+         wkc = nexx_mbxreceive(context, jp->slave, &MbxIn, NEX_TIMEOUTRXM);
+         if ((wkc > 0) && !nexx_ODcache_matches(jp, &MbxIn))
+         {
+            /* late response to a lost request, the current one is still pending */
+            wkc = 0;
+         }
+         if (wkc > 0)
+         {
+            jp->lost = 0;
+            if (jp->OEphase)
             {
-               nexx_SDOinfoerror(context, Slave,pODlist->Index[Item], 0, etohl(aSDOp->ldata[0]));
+               pOE = &cache->OEpool[type->OEoffset[jp->item] + jp->sub];
+               nexx_OEresponse(context, jp->slave, type->ODlist.Index[jp->item], jp->sub, &MbxIn, pOE);
             }
             else
             {
-               nexx_packeterror(context, Slave,pODlist->Index[Item], 0, 1); /* Unexpected frame returned */
+               type->ODlist.Slave = jp->slave;
+               nexx_ODdescresponse(context, &MbxIn, jp->item, &type->ODlist);
             }
-            wkc = 0;
+         }
+         else if (++jp->lost > NEX_ODCACHE_MAXLOST)
+         {
+            /* state is left at the last complete phase */
+            jp->done = TRUE;
+            continue;
+         }
+         else
+         {
+            /* ask again for the same item, a phase is only complete with all responses */
+            jp->flush = TRUE;
+            active++;
+            continue;
+         }
+         nexx_ODcache_advance(cache, jp);
+         if (!jp->done)
+         {
+            active++;
          }
       }
+   } while (active);
+   for (j = 0; j < njob; j++)
+   {
+      if (job[j].type->state)
+      {
+         fetched++;
+      }
    }
 
-   return wkc;
+   return fetched;
 }
 
-/** CoE read SDO service object entry, single subindex.
- * Used in nex_readOE().
+/** Fetch object dictionaries of all CoE slaves into OD cache. Slaves with
+ * identical identity are read only once.
  *
- * @param[in]  context       = context struct
- * @param[in] Item           = Item in ODlist.
- * @param[in] SubI           = Subindex of item in ODlist.
- * @param[in] pODlist        = Object description list for reference.
- * @param[out] pOElist       = resulting object entry structure.
- * @return Workcounter of slave response.
+ * @param[in]  context    = context struct
+ * @param[in]  cache      = OD cache
+ * @param[in]  withOE     = TRUE to read object entries as well
+ * @return number of identities fetched.
  */
-int nexx_readOEsingle(nexx_contextt *context, uint16 Item, uint8 SubI, nex_ODlistt *pODlist, nex_OElistt *pOElist)
+int nexx_ODcache_fetch(nexx_contextt *context, nex_ODcachet *cache, boolean withOE)
 {
-   nex_SDOservicet *SDOp, *aSDOp;
-   int wkc;
-   uint16 Index, Slave;
-   int16 n;
-   nex_mbxbuft MbxIn, MbxOut;
-   uint8 cnt;
+   return nexx_ODcache_run(context, cache, 0, withOE);
+}
 
-   wkc = 0;
-   Slave = pODlist->Slave;
-   Index = pODlist->Index[Item];
-   nex_clearmbx(&MbxIn);
-   /* clear pending out mailbox in slave if available. Timeout is set to 0 */
-   wkc = nexx_mbxreceive(context, Slave, &MbxIn, 0);
-   nex_clearmbx(&MbxOut);
-   aSDOp = (nex_SDOservicet*)&MbxIn;
-   SDOp = (nex_SDOservicet*)&MbxOut;
-   SDOp->MbxHeader.length = htoes(0x000a);
-   SDOp->MbxHeader.address = htoes(0x0000);
-   SDOp->MbxHeader.priority = 0x00;
-   /* Get new mailbox counter value */
-   cnt = nex_nextmbxcnt(context->slavelist[Slave].mbx_cnt);
-   context->slavelist[Slave].mbx_cnt = cnt;
-   SDOp->MbxHeader.mbxtype = ECT_MBXT_COE + (cnt << 4); /* CoE */
-   SDOp->CANOpen = htoes(0x000 + (ECT_COES_SDOINFO << 12)); /* number 9bits service upper 4 bits */
-   SDOp->Opcode = ECT_GET_OE_REQ; /* get object entry description request */
-   SDOp->Reserved = 0;
-   SDOp->Fragments = 0;      /* fragments left */
-   SDOp->wdata[0] = htoes(Index);      /* Index */
-   SDOp->bdata[2] = SubI;       /* SubIndex */
-   SDOp->bdata[3] = 1 + 2 + 4; /* get access rights, object category, PDO */
-   /* send get object entry description request to slave */
-   wkc = nexx_mbxsend(context, Slave, &MbxOut, NEX_TIMEOUTTXM);
-   /* mailbox placed in slave ? */
-   if (wkc > 0)
+/** CoE read Object Description list including descriptions, from OD cache.
+ * The object dictionary is fetched if the slave identity is not cached.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  cache      = OD cache
+ * @param[in]  Slave      = Slave number.
+ * @param[out] pODlist    = resulting Object Description list.
+ * @return 1 on success, 0 if the object dictionary could not be read.
+ */
+int nexx_ODcache_readODlist(nexx_contextt *context, nex_ODcachet *cache, uint16 Slave, nex_ODlistt *pODlist)
+{
+   nex_ODcachetypet *type;
+   uint16 n, i;
+
+   type = nexx_ODcache_find(context, cache, Slave);
+   if (type)
    {
-      nex_clearmbx(&MbxIn);
-      /* read slave response */
-      wkc = nexx_mbxreceive(context, Slave, &MbxIn, NEX_TIMEOUTRXM);
-      /* got response ? */
-      if (wkc > 0)
+      cache->hits++;
+   }
+   else
+   {
+      cache->misses++;
+      nexx_ODcache_run(context, cache, Slave, FALSE);
+      type = nexx_ODcache_find(context, cache, Slave);
+   }
+   if (!type)
+   {
+      /* identity unknown or cache full, read from slave */
+      if (nexx_readODlist(context, Slave, pODlist) <= 0)
       {
-         if (((aSDOp->MbxHeader.mbxtype & 0x0f) == ECT_MBXT_COE) &&
-             ((aSDOp->Opcode &  0x7f) == ECT_GET_OE_RES))
-         {
-            pOElist->Entries++;
-            n = (etohs(aSDOp->MbxHeader.length) - 16); /* length of string(name of object) */
-            if (n > NEX_MAXNAME)
-            {
-               n = NEX_MAXNAME; /* max string length */
-            }
-            if (n < 0 )
-            {
-               n = 0;
-            }
-            pOElist->ValueInfo[SubI] = aSDOp->bdata[3];
-            pOElist->DataType[SubI] = etohs(aSDOp->wdata[2]);
-            pOElist->BitLength[SubI] = etohs(aSDOp->wdata[3]);
-            pOElist->ObjAccess[SubI] = etohs(aSDOp->wdata[4]);
+         return 0;
+      }
+      for (i = 0; i < pODlist->Entries; i++)
+      {
+         nexx_readODdescription(context, i, pODlist);
+      }
+      return 1;
+   }
+   n = type->ODlist.Entries;
+   pODlist->Slave = Slave;
+   pODlist->Entries = n;
+   memcpy(pODlist->Index, type->ODlist.Index, n * sizeof(uint16));
+   memcpy(pODlist->DataType, type->ODlist.DataType, n * sizeof(uint16));
+   memcpy(pODlist->ObjectCode, type->ODlist.ObjectCode, n);
+   memcpy(pODlist->MaxSub, type->ODlist.MaxSub, n);
+   memcpy(pODlist->Name, type->ODlist.Name, n * sizeof(pODlist->Name[0]));
 
-            strncpy(pOElist->Name[SubI] , (char *)&aSDOp->wdata[5], n);
-            pOElist->Name[SubI][n] = 0x00; /* string terminator */
-         }
-         /* got unexpected response from slave */
-         else
+   return 1;
+}
+
+/** CoE read SDO service object entry, from OD cache. Falls back to reading
+ * from the slave if the entries can not be cached.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  cache      = OD cache
+ * @param[in]  Item       = Item in ODlist.
+ * @param[in]  pODlist    = Object description list for reference.
+ * @param[out] pOElist    = resulting object entry structure.
+ * @return 1 or workcounter of slave response, 0 on error.
+ */
+int nexx_ODcache_readOE(nexx_contextt *context, nex_ODcachet *cache, uint16 Item, nex_ODlistt *pODlist, nex_OElistt *pOElist)
+{
+   nex_ODcachetypet *type;
+   nex_ODcacheOEt *pOE;
+   uint16 SubI;
+
+   type = nexx_ODcache_find(context, cache, pODlist->Slave);
+   if (type && (type->state == NEX_ODCACHE_OE))
+   {
+      cache->hits++;
+   }
+   else
+   {
+      cache->misses++;
+      nexx_ODcache_run(context, cache, pODlist->Slave, TRUE);
+      type = nexx_ODcache_find(context, cache, pODlist->Slave);
+   }
+   if (!type || (type->state != NEX_ODCACHE_OE) ||
+       (Item >= type->ODlist.Entries) || (type->ODlist.Index[Item] != pODlist->Index[Item]))
+   {
+      return nexx_readOE(context, Item, pODlist, pOElist);
+   }
+   pOElist->Entries = 0;
+   pOE = &cache->OEpool[type->OEoffset[Item]];
+   for (SubI = 0; SubI <= type->ODlist.MaxSub[Item]; SubI++, pOE++)
+   {
+      if (pOE->Valid)
+      {
+         nexx_OEcopy(pOE, (uint8)SubI, pOElist);
+      }
+   }
+
+   return 1;
+}
+
+/** Save OD cache to file. The file is only valid for a build with identical
+ * structure layout, it is checked by nexx_ODcache_load.
+ *
+ * @param[in]  cache      = OD cache
+ * @param[in]  filename   = file to write
+ * @return number of identities saved, -1 on file error.
+ */
+int nexx_ODcache_save(nex_ODcachet *cache, const char *filename)
+{
+   FILE *fp;
+   uint32 header[4];
+   int32 range[2];
+   nex_ODcachetypet *type;
+   int i, saved, ok;
+   uint16 n;
+
+   fp = fopen(filename, "wb");
+   if (!fp)
+   {
+      return -1;
+   }
+   header[0] = NEX_ODCACHE_MAGIC;
+   header[1] = NEX_ODCACHE_VERSION;
+   header[2] = sizeof(nex_ODcachetypet);
+   header[3] = sizeof(nex_ODcacheOEt);
+   ok = (fwrite(header, sizeof(header), 1, fp) == 1);
+   saved = 0;
+   for (i = 0; ok && (i < cache->ntype); i++)
+   {
+      type = &cache->type[i];
+      if (!type->state)
+      {
+         continue;
+      }
+      /* object entries of one identity are stored contiguous */
+      range[0] = 0;
+      range[1] = 0;
+      if ((type->state == NEX_ODCACHE_OE) && type->ODlist.Entries)
+      {
+         n = type->ODlist.Entries - 1;
+         range[0] = type->OEoffset[0];
+         range[1] = type->OEoffset[n] + type->ODlist.MaxSub[n] + 1 - range[0];
+      }
+      ok = (fwrite(type, sizeof(*type), 1, fp) == 1) &&
+           (fwrite(range, sizeof(range), 1, fp) == 1) &&
+           (fwrite(&cache->OEpool[range[0]], sizeof(nex_ODcacheOEt), range[1], fp) == (size_t)range[1]);
+      saved++;
+   }
+   if (fclose(fp) || !ok)
+   {
+      return -1;
+   }
+
+   return saved;
+}
+
+/** Check an identity read from an OD cache file. The object list must fit in
+ * its arrays and the object entries of every object must lie in the range of
+ * entries stored with it.
+ *
+ * @param[in,out] type    = cache entry read from file
+ * @param[in]  range      = first entry in pool of saved cache and number of entries
+ * @return TRUE if consistent.
+ */
+static boolean nexx_ODcache_valid(nex_ODcachetypet *type, const int32 *range)
+{
+   uint16 j;
+
+   if (((type->state != NEX_ODCACHE_OD) && (type->state != NEX_ODCACHE_OE)) ||
+       (type->ODlist.Entries > NEX_MAXODLIST) ||
+       (range[0] < 0) || (range[1] < 0))
+   {
+      return FALSE;
+   }
+   if ((type->state == NEX_ODCACHE_OE) && type->ODlist.Entries)
+   {
+      for (j = 0; j < type->ODlist.Entries; j++)
+      {
+         if ((type->OEoffset[j] < range[0]) ||
+             ((type->OEoffset[j] - range[0]) > (range[1] - (type->ODlist.MaxSub[j] + 1))))
          {
-            if (((aSDOp->Opcode & 0x7f) == ECT_SDOINFO_ERROR)) /* SDO info error received */
-            {
-               nexx_SDOinfoerror(context, Slave, Index, SubI, etohl(aSDOp->ldata[0]));
-            }
-            else
-            {
-               nexx_packeterror(context, Slave, Index, SubI, 1); /* Unexpected frame returned */
-            }
-            wkc = 0;
+            return FALSE;
          }
       }
    }
-
-   return wkc;
+   else if (range[1])
+   {
+      return FALSE;
+   }
+   /* names are terminated by the reader, not trusted from the file */
+   for (j = 0; j < type->ODlist.Entries; j++)
+   {
+      type->ODlist.Name[j][NEX_MAXNAME] = 0;
+   }
+   return TRUE;
 }
 
-/** CoE read SDO service object entry.
+/** Load OD cache from file written by nexx_ODcache_save. Identities already
+ * in the cache are kept, identities that do not fit are skipped. Loading stops
+ * at the first identity that is not consistent.
  *
- * @param[in] context        = context struct
- * @param[in] Item           = Item in ODlist.
- * @param[in] pODlist        = Object description list for reference.
- * @param[out] pOElist       = resulting object entry structure.
- * @return Workcounter of slave response.
+ * @param[in,out] cache   = OD cache
+ * @param[in]  filename   = file to read
+ * @return number of identities loaded, -1 on file error or incompatible file.
  */
-int nexx_readOE(nexx_contextt *context, uint16 Item, nex_ODlistt *pODlist, nex_OElistt *pOElist)
+int nexx_ODcache_load(nex_ODcachet *cache, const char *filename)
 {
-   uint16 SubCount;
-   int wkc;
-   uint8 SubI;
+   FILE *fp;
+   uint32 header[4];
+   int32 range[2];
+   nex_ODcachetypet *type;
+   int32 i;
+   uint16 j;
+   int loaded;
 
-   wkc = 0;
-   pOElist->Entries = 0;
-   SubI = pODlist->MaxSub[Item];
-   /* for each entry found in ODlist */
-   for (SubCount = 0; SubCount <= SubI; SubCount++)
+   fp = fopen(filename, "rb");
+   if (!fp)
    {
-      /* read subindex of entry */
-      wkc = nexx_readOEsingle(context, Item, (uint8)SubCount, pODlist, pOElist);
+      return -1;
+   }
+   if ((fread(header, sizeof(header), 1, fp) != 1) ||
+       (header[0] != NEX_ODCACHE_MAGIC) ||
+       (header[1] != NEX_ODCACHE_VERSION) ||
+       (header[2] != sizeof(nex_ODcachetypet)) ||
+       (header[3] != sizeof(nex_ODcacheOEt)))
+   {
+      fclose(fp);
+      return -1;
+   }
+   loaded = 0;
+   while (cache->ntype < NEX_ODCACHE_MAXTYPE)
+   {
+      type = &cache->type[cache->ntype];
+      if ((fread(type, sizeof(*type), 1, fp) != 1) ||
+          (fread(range, sizeof(range), 1, fp) != 1) ||
+          !nexx_ODcache_valid(type, range))
+      {
+         break;
+      }
+      if (nexx_ODcache_lookup(cache, type->eep_man, type->eep_id, type->eep_rev) ||
+          ((cache->OEused + range[1]) > cache->OEpoolsize))
+      {
+         /* already cached or no room for entries, skip */
+         if (fseek(fp, range[1] * (long)sizeof(nex_ODcacheOEt), SEEK_CUR))
+         {
+            break;
+         }
+         continue;
+      }
+      if (fread(&cache->OEpool[cache->OEused], sizeof(nex_ODcacheOEt), range[1], fp) != (size_t)range[1])
+      {
+         break;
+      }
+      for (i = 0; i < range[1]; i++)
+      {
+         cache->OEpool[cache->OEused + i].Name[NEX_MAXNAME] = 0;
+      }
+      if (range[1])
+      {
+         /* rebase object entries to their new place in pool */
+         for (j = 0; j < type->ODlist.Entries; j++)
+         {
+            type->OEoffset[j] += cache->OEused - range[0];
+         }
+      }
+      cache->OEused += range[1];
+      cache->ntype++;
+      loaded++;
    }
+   fclose(fp);
 
-   return wkc;
+   return loaded;
 }
 
 #ifdef NEX_VER1
@@ -1370,6 +3076,87 @@ int nex_SDOwrite(uint16 Slave, uint16 Index, uint8 SubIndex,
    return nexx_SDOwrite(&nexx_context, Slave, Index, SubIndex, CA, psize, p, Timeout);
 }
 
+/** CoE SDO read streamed to hook, blocking.
+ *
+ * @param[in]  slave      = Slave number
+ * @param[in]  index      = Index to read
+ * @param[in]  subindex   = Subindex to read, must be 0 or 1 if CA is used.
+ * @param[in]  CA         = FALSE = single subindex. TRUE = Complete Access, all subindexes read.
+ * @param[in]  hook       = stores received data, f.e. nexx_FOEstream_fwrite
+ * @param[in]  arg        = user argument of hook
+ * @param[out] stat       = transfer statistics, may be NULL
+ * @param[in]  timeout    = Timeout per mailbox cycle in us, standard is NEX_TIMEOUTRXM
+ * @return Workcounter from last slave response
+ * @see nexx_SDOread_stream
+ */
+int nex_SDOread_stream(uint16 slave, uint16 index, uint8 subindex, boolean CA,
+                       nex_SDOstreamhookt hook, void *arg, nex_SDOstatt *stat, int timeout)
+{
+   return nexx_SDOread_stream(&nexx_context, slave, index, subindex, CA, hook, arg, stat, timeout);
+}
+
+/** CoE SDO read directly into parameter buffer, blocking.
+ *
+ * @param[in]  slave      = Slave number
+ * @param[in]  index      = Index to read
+ * @param[in]  subindex   = Subindex to read, must be 0 or 1 if CA is used.
+ * @param[in]  CA         = FALSE = single subindex. TRUE = Complete Access, all subindexes read.
+ * @param[in,out] psize   = Size in bytes of parameter buffer, returns bytes read from SDO.
+ * @param[out] p          = Pointer to parameter buffer
+ * @param[out] stat       = transfer statistics, may be NULL
+ * @param[in]  timeout    = Timeout per mailbox cycle in us, standard is NEX_TIMEOUTRXM
+ * @return Workcounter from last slave response
+ * @see nexx_SDOread_direct
+ */
+int nex_SDOread_direct(uint16 slave, uint16 index, uint8 subindex, boolean CA,
+                       int *psize, void *p, nex_SDOstatt *stat, int timeout)
+{
+   return nexx_SDOread_direct(&nexx_context, slave, index, subindex, CA, psize, p, stat, timeout);
+}
+
+/** CoE SDO write streamed from hook, blocking.
+ *
+ * @param[in]  Slave      = Slave number
+ * @param[in]  Index      = Index to write
+ * @param[in]  SubIndex   = Subindex to write, must be 0 or 1 if CA is used.
+ * @param[in]  CA         = FALSE = single subindex. TRUE = Complete Access, all subindexes written.
+ * @param[in]  psize      = Size in bytes of object
+ * @param[in]  hook       = supplies data to send, f.e. nexx_FOEstream_fread
+ * @param[in]  arg        = user argument of hook
+ * @param[out] stat       = transfer statistics, may be NULL
+ * @param[in]  Timeout    = Timeout per mailbox cycle in us, standard is NEX_TIMEOUTRXM
+ * @return Workcounter from last slave response
+ * @see nexx_SDOwrite_stream
+ */
+int nex_SDOwrite_stream(uint16 Slave, uint16 Index, uint8 SubIndex, boolean CA, int psize,
+                        nex_SDOstreamhookt hook, void *arg, nex_SDOstatt *stat, int Timeout)
+{
+   return nexx_SDOwrite_stream(&nexx_context, Slave, Index, SubIndex, CA, psize, hook, arg, stat, Timeout);
+}
+
+/** Build transactions and schedule of SDO poll list.
+ *
+ * @param[in]  poll       = SDO poll list
+ * @return number of transactions per cycle of all periods
+ * @see nexx_SDOpoll_start
+ */
+int nex_SDOpoll_start(nex_SDOpollt *poll)
+{
+   return nexx_SDOpoll_start(&nexx_context, poll);
+}
+
+/** Move SDO poll list forward, non blocking.
+ *
+ * @param[in]  poll       = SDO poll list
+ * @param[in]  maxreq     = budget, max requests written per call
+ * @return number of messages moved
+ * @see nexx_SDOpoll
+ */
+int nex_SDOpoll(nex_SDOpollt *poll, int maxreq)
+{
+   return nexx_SDOpoll(&nexx_context, poll, maxreq);
+}
+
 /** CoE RxPDO write, blocking.
  *
  * A RxPDO download request is issued.
@@ -1502,4 +3289,43 @@ int nex_readOE(uint16 Item, nex_ODlistt *pODlist, nex_OElistt *pOElist)
 {
    return nexx_readOE(&nexx_context, Item, pODlist, pOElist);
 }
+
+/** Fetch object dictionaries of all CoE slaves into OD cache.
+ *
+ * @param[in]  cache      = OD cache
+ * @param[in]  withOE     = TRUE to read object entries as well
+ * @return number of identities fetched.
+ * @see nexx_ODcache_fetch
+ */
+int nex_ODcache_fetch(nex_ODcachet *cache, boolean withOE)
+{
+   return nexx_ODcache_fetch(&nexx_context, cache, withOE);
+}
+
+/** CoE read Object Description list including descriptions, from OD cache.
+ *
+ * @param[in]  cache      = OD cache
+ * @param[in]  Slave      = Slave number.
+ * @param[out] pODlist    = resulting Object Description list.
+ * @return 1 on success, 0 if the object dictionary could not be read.
+ * @see nexx_ODcache_readODlist
+ */
+int nex_ODcache_readODlist(nex_ODcachet *cache, uint16 Slave, nex_ODlistt *pODlist)
+{
+   return nexx_ODcache_readODlist(&nexx_context, cache, Slave, pODlist);
+}
+
+/** CoE read SDO service object entry, from OD cache.
+ *
+ * @param[in]  cache      = OD cache
+ * @param[in]  Item       = Item in ODlist.
+ * @param[in]  pODlist    = Object description list for reference.
+ * @param[out] pOElist    = resulting object entry structure.
+ * @return 1 or workcounter of slave response, 0 on error.
+ * @see nexx_ODcache_readOE
+ */
+int nex_ODcache_readOE(nex_ODcachet *cache, uint16 Item, nex_ODlistt *pODlist, nex_OElistt *pOElist)
+{
+   return nexx_ODcache_readOE(&nexx_context, cache, Item, pODlist, pOElist);
+}
 #endif
@@ -58,12 +58,209 @@ typedef struct
    char   Name[NEX_MAXOELIST][NEX_MAXNAME+1];
 } nex_OElistt;
 
+/** max number of distinct slave identities in OD cache */
+#define NEX_ODCACHE_MAXTYPE  8
+/** OD cache state of identity, object list and descriptions read */
+#define NEX_ODCACHE_OD       1
+/** OD cache state of identity, object entries read as well */
+#define NEX_ODCACHE_OE       2
+
+/** cached object entry of one subindex */
+typedef struct
+{
+   /** TRUE if slave returned the entry */
+   uint8  Valid;
+   uint8  ValueInfo;
+   uint16 DataType;
+   uint16 BitLength;
+   uint16 ObjAccess;
+   char   Name[NEX_MAXNAME+1];
+} nex_ODcacheOEt;
+
+/** cached object dictionary of one slave identity */
+typedef struct
+{
+   /** identity from SII */
+   uint32  eep_man;
+   uint32  eep_id;
+   uint32  eep_rev;
+   /** 0 = unused, NEX_ODCACHE_OD or NEX_ODCACHE_OE */
+   uint8   state;
+   /** object list including descriptions */
+   nex_ODlistt ODlist;
+   /** start of object entries of each object in OE pool */
+   int32   OEoffset[NEX_MAXODLIST];
+} nex_ODcachetypet;
+
+/** object dictionary cache, shared by all slaves with identical identity.
+ * Object entries are stored in a pool supplied by the user.
+ */
+typedef struct
+{
+   /** number of used identities */
+   int     ntype;
+   nex_ODcachetypet type[NEX_ODCACHE_MAXTYPE];
+   /** object entry pool */
+   nex_ODcacheOEt *OEpool;
+   /** size of pool in entries */
+   int32   OEpoolsize;
+   /** used entries of pool */
+   int32   OEused;
+   /** statistics, cache hits and slave round trips */
+   uint32  hits;
+   uint32  misses;
+   uint32  requests;
+} nex_ODcachet;
+
+/** SDO stream hook, stores received data or supplies data to send.
+ * Returns number of bytes handled, anything but size aborts the transfer.
+ */
+typedef int (*nex_SDOstreamhookt)(void *arg, void *buf, int size);
+
+/** SDO stream transfer statistics */
+typedef struct
+{
+   /** size of object */
+   uint32  size;
+   /** bytes transferred */
+   uint32  bytes;
+   /** mailbox messages with data */
+   uint32  segments;
+   /** segments read directly into the parameter buffer */
+   uint32  inplace;
+   /** duration of transfer in us */
+   uint32  elapsed;
+   /** bytes per second */
+   uint32  throughput;
+} nex_SDOstatt;
+
+/** max entries in SDO poll list */
+#define NEX_SDOPOLL_MAX       2048
+/** max size of polled value in bytes */
+#define NEX_SDOPOLL_MAXDATA   8
+/** max number of SDO poll requests in transfer, one per slave */
+#define NEX_SDOPOLL_MAXREQ    32
+
+/** polled SDO entry with its last value. The value is published with a
+ *  sequence counter, odd while the poller updates it, so readers in other
+ *  threads never block the poller, see nexx_SDOpoll_get.
+ */
+typedef struct
+{
+   uint16  slave;
+   uint16  index;
+   uint8   subindex;
+   /** size of value in bytes */
+   uint8   size;
+   /** poll period in us */
+   uint32  period;
+   /** sequence counter, odd while value is updated */
+   volatile uint32 seq;
+   /** number of values read */
+   volatile uint32 updates;
+   /** abort code of last read, 0 if it succeeded */
+   volatile int32  abortcode;
+   /** bytes of last value, 0 if not read yet */
+   volatile uint8  length;
+   volatile uint8  data[NEX_SDOPOLL_MAXDATA];
+   /** time of last value */
+   volatile nex_timet time;
+} nex_SDOpollentryt;
+
+/** SDO upload of one or more poll entries, Complete Access for consecutive
+ *  subindexes. Without Complete Access the entries are read one by one.
+ */
+typedef struct
+{
+   uint16  index;
+   uint8   subindex;
+   uint8   CA;
+   /** first entry in order list */
+   uint16  first;
+   /** number of entries */
+   uint16  n;
+   /** entry read next without Complete Access */
+   uint16  part;
+} nex_SDOpolltxt;
+
+/** all entries of one slave with identical period, read in one burst */
+typedef struct
+{
+   uint16  slave;
+   uint32  period;
+   /** first transaction and number of transactions */
+   uint16  firsttx;
+   uint16  ntx;
+   /** transaction of current burst */
+   uint16  cur;
+   /** request slot in transfer, -1 if none */
+   int16   req;
+   /** next burst in us since nexx_SDOpoll_start */
+   uint32  due;
+} nex_SDOpollgroupt;
+
+/** SDO poll request in transfer */
+typedef struct
+{
+   /** group, -1 if slot is free */
+   int     group;
+   osal_timert timer;
+   /** request, replaced by the response */
+   nex_mbxbuft mbx;
+} nex_SDOpollreqt;
+
+/** SDO poll statistics */
+typedef struct
+{
+   uint32  requests;
+   uint32  responses;
+   /** transactions with Complete Access */
+   uint32  careads;
+   /** abort responses of slaves */
+   uint32  aborts;
+   /** requests without slave response */
+   uint32  timeouts;
+   /** responses that could not be used, f.e. segmented */
+   uint32  errors;
+   /** bursts started more than one period late */
+   uint32  late;
+} nex_SDOpollstatt;
+
+/** SDO poll list, reads registered entries periodically within an acyclic budget */
+typedef struct
+{
+   /** response timeout in us */
+   int     timeout;
+   int     nentry;
+   int     ntx;
+   int     ngroup;
+   /** group to check first on next poll */
+   int     next;
+   /** time base of due times */
+   nex_timet start;
+   nex_SDOpollentryt entry[NEX_SDOPOLL_MAX];
+   /** entries ordered by transaction */
+   uint16  order[NEX_SDOPOLL_MAX];
+   nex_SDOpolltxt tx[NEX_SDOPOLL_MAX];
+   nex_SDOpollgroupt group[NEX_SDOPOLL_MAX];
+   nex_SDOpollreqt req[NEX_SDOPOLL_MAXREQ];
+   nex_SDOpollstatt stat;
+} nex_SDOpollt;
+
 #ifdef NEX_VER1
 void nex_SDOerror(uint16 Slave, uint16 Index, uint8 SubIdx, int32 AbortCode);
 int nex_SDOread(uint16 slave, uint16 index, uint8 subindex,
                       boolean CA, int *psize, void *p, int timeout);
 int nex_SDOwrite(uint16 Slave, uint16 Index, uint8 SubIndex,
     boolean CA, int psize, void *p, int Timeout);
+int nex_SDOread_stream(uint16 slave, uint16 index, uint8 subindex, boolean CA,
+                       nex_SDOstreamhookt hook, void *arg, nex_SDOstatt *stat, int timeout);
+int nex_SDOread_direct(uint16 slave, uint16 index, uint8 subindex, boolean CA,
+                       int *psize, void *p, nex_SDOstatt *stat, int timeout);
+int nex_SDOwrite_stream(uint16 Slave, uint16 Index, uint8 SubIndex, boolean CA, int psize,
+                        nex_SDOstreamhookt hook, void *arg, nex_SDOstatt *stat, int Timeout);
+int nex_SDOpoll_start(nex_SDOpollt *poll);
+int nex_SDOpoll(nex_SDOpollt *poll, int maxreq);
 int nex_RxPDO(uint16 Slave, uint16 RxPDOnumber , int psize, void *p);
 int nex_TxPDO(uint16 slave, uint16 TxPDOnumber , int *psize, void *p, int timeout);
 int nex_readPDOmap(uint16 Slave, int *Osize, int *Isize);
@@ -72,6 +269,9 @@ int nex_readODlist(uint16 Slave, nex_ODlistt *pODlist);
 int nex_readODdescription(uint16 Item, nex_ODlistt *pODlist);
 int nex_readOEsingle(uint16 Item, uint8 SubI, nex_ODlistt *pODlist, nex_OElistt *pOElist);
 int nex_readOE(uint16 Item, nex_ODlistt *pODlist, nex_OElistt *pOElist);
+int nex_ODcache_fetch(nex_ODcachet *cache, boolean withOE);
+int nex_ODcache_readODlist(nex_ODcachet *cache, uint16 Slave, nex_ODlistt *pODlist);
+int nex_ODcache_readOE(nex_ODcachet *cache, uint16 Item, nex_ODlistt *pODlist, nex_OElistt *pOElist);
 #endif
 
 void nexx_SDOerror(nexx_contextt *context, uint16 Slave, uint16 Index, uint8 SubIdx, int32 AbortCode);
@@ -79,6 +279,17 @@ int nexx_SDOread(nexx_contextt *context, uint16 slave, uint16 index, uint8 subin
                       boolean CA, int *psize, void *p, int timeout);
 int nexx_SDOwrite(nexx_contextt *context, uint16 Slave, uint16 Index, uint8 SubIndex,
     boolean CA, int psize, void *p, int Timeout);
+int nexx_SDOread_stream(nexx_contextt *context, uint16 slave, uint16 index, uint8 subindex, boolean CA,
+                        nex_SDOstreamhookt hook, void *arg, nex_SDOstatt *stat, int timeout);
+int nexx_SDOread_direct(nexx_contextt *context, uint16 slave, uint16 index, uint8 subindex, boolean CA,
+                        int *psize, void *p, nex_SDOstatt *stat, int timeout);
+int nexx_SDOwrite_stream(nexx_contextt *context, uint16 Slave, uint16 Index, uint8 SubIndex, boolean CA,
+                         int psize, nex_SDOstreamhookt hook, void *arg, nex_SDOstatt *stat, int Timeout);
+void nexx_SDOpoll_init(nex_SDOpollt *poll, int timeout);
+int nexx_SDOpoll_add(nex_SDOpollt *poll, uint16 slave, uint16 index, uint8 subindex, int size, uint32 period);
+int nexx_SDOpoll_start(nexx_contextt *context, nex_SDOpollt *poll);
+int nexx_SDOpoll(nexx_contextt *context, nex_SDOpollt *poll, int maxreq);
+int nexx_SDOpoll_get(nex_SDOpollt *poll, int handle, void *p, nex_timet *time);
 int nexx_RxPDO(nexx_contextt *context, uint16 Slave, uint16 RxPDOnumber , int psize, void *p);
 int nexx_TxPDO(nexx_contextt *context, uint16 slave, uint16 TxPDOnumber , int *psize, void *p, int timeout);
 int nexx_readPDOmap(nexx_contextt *context, uint16 Slave, int *Osize, int *Isize);
@@ -87,6 +298,13 @@ int nexx_readODlist(nexx_contextt *context, uint16 Slave, nex_ODlistt *pODlist);
 int nexx_readODdescription(nexx_contextt *context, uint16 Item, nex_ODlistt *pODlist);
 int nexx_readOEsingle(nexx_contextt *context, uint16 Item, uint8 SubI, nex_ODlistt *pODlist, nex_OElistt *pOElist);
 int nexx_readOE(nexx_contextt *context, uint16 Item, nex_ODlistt *pODlist, nex_OElistt *pOElist);
+void nexx_ODcache_init(nex_ODcachet *cache, nex_ODcacheOEt *OEpool, int32 OEpoolsize);
+nex_ODcachetypet *nexx_ODcache_find(nexx_contextt *context, nex_ODcachet *cache, uint16 Slave);
+int nexx_ODcache_fetch(nexx_contextt *context, nex_ODcachet *cache, boolean withOE);
+int nexx_ODcache_readODlist(nexx_contextt *context, nex_ODcachet *cache, uint16 Slave, nex_ODlistt *pODlist);
+int nexx_ODcache_readOE(nexx_contextt *context, nex_ODcachet *cache, uint16 Item, nex_ODlistt *pODlist, nex_OElistt *pOElist);
+int nexx_ODcache_save(nex_ODcachet *cache, const char *filename);
+int nexx_ODcache_load(nex_ODcachet *cache, const char *filename);
 
 #ifdef __cplusplus
 }
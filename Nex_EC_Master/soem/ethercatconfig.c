@@ -31,17 +31,16 @@
 #define NEX_PRINT(...) do {} while (0)
 #endif
 
+/** mapper thread job, the tables live on the stack of the configuring thread
+ *  so contexts can be configured in parallel */
 typedef struct
 {
    int thread_n;
-   int running;
+   volatile int running;
    nexx_contextt *context;
    uint16 slave;
 } nexx_mapt_t;
 
-nexx_mapt_t nexx_mapt[NEX_MAX_MAPT];
-OSAL_THREAD_HANDLE nexx_threadh[NEX_MAX_MAPT];
-
 #ifdef NEX_VER1
 /** Slave configuration structure */
 typedef const struct
@@ -111,6 +110,11 @@ void nexx_init_context(nexx_contextt *context)
 {
    int lp;
    *(context->slavecount) = 0;
+   /* return the index partitions of the groups to the port */
+   for(lp = 0; lp < context->maxgroup; lp++)
+   {
+      nexx_config_groupindex(context, (uint8)lp, 0, 0);
+   }
    /* clean nex_slave array */
    memset(context->slavelist, 0x00, sizeof(nex_slavet) * context->maxslave);
    memset(context->grouplist, 0x00, sizeof(nex_groupt) * context->maxgroup);
@@ -257,23 +261,162 @@ static int nexx_config_from_table(nexx_contextt *context, uint16 slave)
 }
 #endif*/
 
+/** size of the identity hash table, at most half full */
+#define NEX_IDHASHSIZE      (2 * NEX_MAXSLAVE)
+
+/* Link every slave to the first and the next slave with the same manufacturer,
+ * ID and revision. The identities go in an open addressing hash table, so this
+ * is linear in the number of slaves.
+ */
+static void nexx_index_identity(nexx_contextt *context)
+{
+   uint16 first[NEX_IDHASHSIZE];
+   uint16 last[NEX_IDHASHSIZE];
+   nex_slavet *sl, *fs;
+   uint32 h;
+   int slave;
+
+   memset(first, 0, sizeof(first));
+   for (slave = 1; slave <= *(context->slavecount); slave++)
+   {
+      sl = &(context->slavelist[slave]);
+      sl->sameid = 0;
+      sl->nextid = 0;
+      h = (sl->eep_man * 0x9e3779b1u) ^ (sl->eep_id * 0x85ebca77u) ^ (sl->eep_rev * 0xc2b2ae3du);
+      h = (h ^ (h >> 15)) % NEX_IDHASHSIZE;
+      while (first[h])
+      {
+         fs = &(context->slavelist[first[h]]);
+         if ((fs->eep_man == sl->eep_man) && (fs->eep_id == sl->eep_id) && (fs->eep_rev == sl->eep_rev))
+         {
+            break;
+         }
+         h = (h + 1) % NEX_IDHASHSIZE;
+      }
+      if (first[h])
+      {
+         sl->sameid = first[h];
+         context->slavelist[last[h]].nextid = (uint16)slave;
+      }
+      else
+      {
+         first[h] = (uint16)slave;
+      }
+      last[h] = (uint16)slave;
+   }
+}
+
+/** Build the topology tree from the number of open ports of every slave. The
+ * slaves are numbered in the order the frame passes them. The parent of a
+ * slave is the last slave before it with two or more links whose branches are
+ * not all closed by end points yet. The balance
+ * of split points and end points is kept as a running sum, and a stack of the
+ * candidate parents ordered by that sum makes this linear in the number of
+ * slaves. Sets parent, child, sibling and depth of every slave, the child of
+ * slave 0 is the first slave. Called by nexx_config_init.
+ * @param[in]  context        = context struct
+ * @return number of slaves in the tree
+ */
+int nexx_topology_build(nexx_contextt *context)
+{
+   uint16 stack[NEX_MAXSLAVE];
+   int32 balance[NEX_MAXSLAVE];
+   uint16 lastchild[NEX_MAXSLAVE];
+   nex_slavet *sl;
+   uint16 parent;
+   int32 sum;
+   int slave, sp;
+
+   sp = 0;
+   sum = 0;
+   context->slavelist[0].child = 0;
+   lastchild[0] = 0;
+   for (slave = 1; slave <= *(context->slavecount); slave++)
+   {
+      sl = &(context->slavelist[slave]);
+      sl->child = 0;
+      sl->sibling = 0;
+      lastchild[slave] = 0;
+      parent = 0; /* parent is master */
+      if (slave > 1)
+      {
+         /* candidates with all branches closed are never parents again */
+         while ((sp > 0) && (balance[sp - 1] > sum))
+         {
+            sp--;
+         }
+         parent = (sp > 0) ? stack[sp - 1] : 1;
+      }
+      sl->parent = parent;
+      sl->depth = parent ? (context->slavelist[parent].depth + 1) : 0;
+      if (lastchild[parent])
+      {
+         context->slavelist[lastchild[parent]].sibling = (uint16)slave;
+      }
+      else
+      {
+         context->slavelist[parent].child = (uint16)slave;
+      }
+      lastchild[parent] = (uint16)slave;
+      if (sl->topology > 1)
+      {
+         /* this slave is a parent whenever an earlier one with the same sum is */
+         while ((sp > 0) && (balance[sp - 1] >= sum))
+         {
+            sp--;
+         }
+         stack[sp] = (uint16)slave;
+         balance[sp] = sum;
+         sp++;
+      }
+      /* 1 link: end point, 3 links: split point, 4 links: cross point */
+      if (sl->topology == 1)
+      {
+         sum--;
+      }
+      else if (sl->topology > 2)
+      {
+         sum += sl->topology - 2;
+      }
+   }
+
+   return *(context->slavecount);
+}
+
+/** Walk a subtree of the topology in the order the frame passes the slaves.
+ * @param[in]  context        = context struct
+ * @param[in]  root           = root of the subtree, 0 for all slaves
+ * @param[in]  slave          = current slave, root to start
+ * @return next slave of the subtree, 0 at the end
+ */
+uint16 nexx_topology_next(nexx_contextt *context, uint16 root, uint16 slave)
+{
+   if (context->slavelist[slave].child)
+   {
+      return context->slavelist[slave].child;
+   }
+   while (slave && (slave != root))
+   {
+      if (context->slavelist[slave].sibling)
+      {
+         return context->slavelist[slave].sibling;
+      }
+      slave = context->slavelist[slave].parent;
+   }
+
+   return 0;
+}
+
 /* If slave has SII and same slave ID done before, use previous data.
  * This is safe because SII is constant for same slave ID.
  */
 static int nexx_lookup_prev_sii(nexx_contextt *context, uint16 slave)
 {
    int i, nSM;
+   i = context->slavelist[slave].sameid;
    if ((slave > 1) && (*(context->slavecount) > 0))
    {
-      i = 1;
-      while(((context->slavelist[i].eep_man != context->slavelist[slave].eep_man) ||
-             (context->slavelist[i].eep_id  != context->slavelist[slave].eep_id ) ||
-             (context->slavelist[i].eep_rev != context->slavelist[slave].eep_rev)) &&
-            (i < slave))
-      {
-         i++;
-      }
-      if(i < slave)
+      if((i > 0) && (i < slave))
       {
          context->slavelist[slave].CoEdetails = context->slavelist[i].CoEdetails;
          context->slavelist[slave].FoEdetails = context->slavelist[i].FoEdetails;
@@ -314,7 +457,7 @@ int nexx_config_init(nexx_contextt *context)
 {
    uint16 slave, ADPh, configadr, ssigen;
    uint16 topology, estat;
-   int16 topoc, slavec, aliasadr;
+   int16 aliasadr;
    uint8 b,h;
    uint8 SMc;
    uint32 eedat;
@@ -373,6 +516,7 @@ int nexx_config_init(nexx_contextt *context)
             etohl(nexx_readeeprom2(context, slave, NEX_TIMEOUTEEP)); /* revision */
          nexx_readeeprom1(context, slave, ECT_SII_RXMBXADR); /* write mailbox address + mailboxsize */
       }
+      nexx_index_identity(context);
       for (slave = 1; slave <= *(context->slavecount); slave++)
       {
          eedat = etohl(nexx_readeeprom2(context, slave, NEX_TIMEOUTEEP)); /* write mailbox address and mailboxsize */
@@ -438,37 +582,6 @@ int nexx_config_init(nexx_contextt *context)
          /* 2=2 links , one before and one after */
          /* 3=3 links , split point              */
          /* 4=4 links , cross point              */
-         /* search for parent */
-         context->slavelist[slave].parent = 0; /* parent is master */
-         if (slave > 1)
-         {
-            topoc = 0;
-            slavec = slave - 1;
-            do
-            {
-               topology = context->slavelist[slavec].topology;
-               if (topology == 1)
-               {
-                  topoc--; /* endpoint found */
-               }
-               if (topology == 3)
-               {
-                  topoc++; /* split found */
-               }
-               if (topology == 4)
-               {
-                  topoc += 2; /* cross found */
-               }
-               if (((topoc >= 0) && (topology > 1)) ||
-                   (slavec == 1)) /* parent found */
-               {
-                  context->slavelist[slave].parent = slavec;
-                  slavec = 1;
-               }
-               slavec--;
-            }
-            while (slavec > 0);
-         }
          (void)nexx_statecheck(context, slave, NEX_STATE_INIT,  NEX_TIMEOUTSTATE); //* check state change Init */
 
          /* set default mailbox configuration if slave has mailbox */
@@ -593,6 +706,8 @@ int nexx_config_init(nexx_contextt *context)
          /* request pre_op for slave */
          nexx_FPWRw(context->port, configadr, ECT_REG_ALCTL, htoes(NEX_STATE_PRE_OP | NEX_STATE_ACK) , NEX_TIMEOUTRET3); /* set preop status */
       }
+      /* parent of every slave from the topology */
+      nexx_topology_build(context);
    }
    return wkc;
 }
@@ -603,17 +718,10 @@ int nexx_config_init(nexx_contextt *context)
 static int nexx_lookup_mapping(nexx_contextt *context, uint16 slave, int *Osize, int *Isize)
 {
    int i, nSM;
+   i = context->slavelist[slave].sameid;
    if ((slave > 1) && (*(context->slavecount) > 0))
    {
-      i = 1;
-      while(((context->slavelist[i].eep_man != context->slavelist[slave].eep_man) ||
-             (context->slavelist[i].eep_id  != context->slavelist[slave].eep_id ) ||
-             (context->slavelist[i].eep_rev != context->slavelist[slave].eep_rev)) &&
-            (i < slave))
-      {
-         i++;
-      }
-      if(i < slave)
+      if((i > 0) && (i < slave))
       {
          for( nSM=0 ; nSM < NEX_MAXSM ; nSM++ )
          {
@@ -646,6 +754,10 @@ static int nexx_map_coe_soe(nexx_contextt *context, uint16 slave, int thread_n)
    {
       context->slavelist[slave].PO2SOconfig(slave);
    }
+   if(context->slavelist[slave].PO2SOconfigx) /* only if registered */
+   {
+      context->slavelist[slave].PO2SOconfigx(context, slave);
+   }
    /* if slave not found in configlist find IO mapping in slave self */
    if (!context->slavelist[slave].configindex)
    {
@@ -793,11 +905,11 @@ OSAL_THREAD_FUNC nexx_mapper_thread(void *param)
    maptp->running = 0;
 }
 
-static int nexx_find_mapt(void)
+static int nexx_find_mapt(nexx_mapt_t *mapt)
 {
    int p;
    p = 0;
-   while((p < NEX_MAX_MAPT) && nexx_mapt[p].running)
+   while((p < NEX_MAX_MAPT) && mapt[p].running)
    {
       p++;
    }
@@ -811,25 +923,27 @@ static int nexx_find_mapt(void)
    }
 }
 
-static int nexx_get_threadcount(void)
+static int nexx_get_threadcount(nexx_mapt_t *mapt)
 {
    int thrc, thrn;
    thrc = 0;
    for(thrn = 0 ; thrn < NEX_MAX_MAPT ; thrn++)
    {
-      thrc += nexx_mapt[thrn].running;
+      thrc += mapt[thrn].running;
    }
    return thrc;
 }
 
 static void nexx_config_find_mappings(nexx_contextt *context, uint8 group)
 {
+   nexx_mapt_t mapt[NEX_MAX_MAPT];
+   OSAL_THREAD_HANDLE threadh[NEX_MAX_MAPT];
    int thrn, thrc;
    uint16 slave;
 
    for (thrn = 0; thrn < NEX_MAX_MAPT; thrn++)
    {
-      nexx_mapt[thrn].running = 0;
+      mapt[thrn].running = 0;
    }
    /* find CoE and SoE mapping of slaves in multiple threads */
    for (slave = 1; slave <= *(context->slavecount); slave++)
@@ -844,23 +958,23 @@ static void nexx_config_find_mappings(nexx_contextt *context, uint8 group)
          else
          {
             /* multi-threaded version */
-            while ((thrn = nexx_find_mapt()) < 0)
+            while ((thrn = nexx_find_mapt(mapt)) < 0)
             {
                osal_usleep(1000);
             }
-            nexx_mapt[thrn].context = context;
-            nexx_mapt[thrn].slave = slave;
-            nexx_mapt[thrn].thread_n = thrn;
-            nexx_mapt[thrn].running = 1;
-            osal_thread_create(&(nexx_threadh[thrn]), 128000,
-               &nexx_mapper_thread, &(nexx_mapt[thrn]));
+            mapt[thrn].context = context;
+            mapt[thrn].slave = slave;
+            mapt[thrn].thread_n = thrn;
+            mapt[thrn].running = 1;
+            osal_thread_create(&(threadh[thrn]), 128000,
+               &nexx_mapper_thread, &(mapt[thrn]));
          }
       }
    }
    /* wait for all threads to finish */
    do
    {
-      thrc = nexx_get_threadcount();
+      thrc = nexx_get_threadcount(mapt);
       if (thrc)
       {
          osal_usleep(1000);
@@ -991,8 +1105,8 @@ static void nexx_config_create_input_mappings(nexx_contextt *context, void *pIOm
       }
       if (!context->slavelist[slave].inputs)
       {
-         context->slavelist[slave].inputs =
-            (uint8 *)(pIOmap)+etohl(context->slavelist[slave].FMMU[FMMUc].LogStart);
+         context->slavelist[slave].inputs = (uint8 *)(pIOmap) +
+            (etohl(context->slavelist[slave].FMMU[FMMUc].LogStart) - context->grouplist[group].logstartaddr);
          context->slavelist[slave].Istartbit =
             context->slavelist[slave].FMMU[FMMUc].LogStartbit;
          NEX_PRINT("    Inputs %p startbit %d\n",
@@ -1108,8 +1222,8 @@ static void nexx_config_create_output_mappings(nexx_contextt *context, void *pIO
       context->grouplist[group].outputsWKC++;
       if (!context->slavelist[slave].outputs)
       {
-         context->slavelist[slave].outputs =
-            (uint8 *)(pIOmap)+etohl(context->slavelist[slave].FMMU[FMMUc].LogStart);
+         context->slavelist[slave].outputs = (uint8 *)(pIOmap) +
+            (etohl(context->slavelist[slave].FMMU[FMMUc].LogStart) - context->grouplist[group].logstartaddr);
          context->slavelist[slave].Ostartbit =
             context->slavelist[slave].FMMU[FMMUc].LogStartbit;
          NEX_PRINT("    slave %d Outputs %p startbit %d\n",
@@ -1122,164 +1236,207 @@ static void nexx_config_create_output_mappings(nexx_contextt *context, void *pIO
    context->slavelist[slave].FMMUunused = FMMUc;
 }
 
+/* Add the bytes of a mapping to the IO segments of a group. A new segment is
+ * started if the bytes do not fit in the datagram of the current one, or if
+ * they need another command. Clears split if the segments ran out at a change
+ * of command, the group then can only use LRD/LWR for all slaves. Returns FALSE
+ * if the segments ran out and the bytes do not fit in the last one.
+ */
+static boolean nexx_config_add_segment(nex_groupt *grp, uint16 *currentsegment, uint32 *segmentsize,
+                                       uint32 diff, uint8 cmd, boolean *split)
+{
+   if (!diff)
+   {
+      return TRUE;
+   }
+   if (*segmentsize && (((*segmentsize + diff) > (NEX_MAXLRWDATA - NEX_FIRSTDCDATAGRAM)) ||
+                        (grp->IOsegmentcmd[*currentsegment] != cmd)))
+   {
+      if (*currentsegment < (NEX_MAXIOSEGMENTS - 1))
+      {
+         grp->IOsegment[*currentsegment] = *segmentsize;
+         (*currentsegment)++;
+         *segmentsize = 0;
+      }
+      else if ((*segmentsize + diff) > (NEX_MAXLRWDATA - NEX_FIRSTDCDATAGRAM))
+      {
+         return FALSE;
+      }
+      else
+      {
+         *split = FALSE;
+      }
+   }
+   if (!*segmentsize)
+   {
+      grp->IOsegmentcmd[*currentsegment] = cmd;
+   }
+   *segmentsize += diff;
+
+   return TRUE;
+}
+
+/* Program Eeprom control and request SAFE_OP for the slaves of a mapped group.
+ * Returns the number of slaves with blockLRW.
+ */
+static int nexx_config_group_safeop(nexx_contextt *context, uint8 group)
+{
+   uint16 slave, configadr;
+   int nblock = 0;
+
+   for (slave = 1; slave <= *(context->slavecount); slave++)
+   {
+      configadr = context->slavelist[slave].configadr;
+      if (!group || (group == context->slavelist[slave].group))
+      {
+         nexx_eeprom2pdi(context, slave); /* set Eeprom control to PDI */
+         nexx_FPWRw(context->port, configadr, ECT_REG_ALCTL, htoes(NEX_STATE_SAFE_OP) , NEX_TIMEOUTRET3); /* set safeop status */
+
+         if (context->slavelist[slave].blockLRW)
+         {
+            nblock++;
+         }
+         context->grouplist[group].Ebuscurrent += context->slavelist[slave].Ebuscurrent;
+      }
+   }
+
+   return nblock;
+}
+
 /** Map all PDOs in one group of slaves to IOmap with Outputs/Inputs
 * in sequential order (legacy SOEM way).
+* The outputs of slaves with blockLRW are mapped before the other outputs and
+* their inputs after the other inputs, in IO segments of their own. The
+* processdata then uses LWR and LRD for these segments and LRW for the rest.
 *
  *
  * @param[in]  context    = context struct
  * @param[out] pIOmap     = pointer to IOmap
  * @param[in]  group      = group to map, 0 = all groups
- * @return IOmap size
+ * @return IOmap size, 0 if the IO segments of the group ran out
  */
 int nexx_config_map_group(nexx_contextt *context, void *pIOmap, uint8 group)
 {
-   uint16 slave, configadr;
+   uint16 slave;
    uint8 BitPos;
    uint32 LogAddr = 0;
    uint32 oLogAddr = 0;
    uint32 diff;
    uint16 currentsegment = 0;
    uint32 segmentsize = 0;
+   boolean split = TRUE;
+   boolean fit = TRUE;
+   int pass, nblock;
+   uint8 cmd;
+   nex_groupt *grp;
 
    if ((*(context->slavecount) > 0) && (group < context->maxgroup))
    {
       NEX_PRINT("nex_config_map_group IOmap:%p group:%d\n", pIOmap, group);
+      grp = &(context->grouplist[group]);
       LogAddr = context->grouplist[group].logstartaddr;
       oLogAddr = LogAddr;
       BitPos = 0;
       context->grouplist[group].nsegments = 0;
       context->grouplist[group].outputsWKC = 0;
       context->grouplist[group].inputsWKC = 0;
+      memset(context->grouplist[group].IOsegmentcmd, 0, sizeof(context->grouplist[group].IOsegmentcmd));
 
       /* Find mappings and program syncmanagers */
       nexx_config_find_mappings(context, group);
 
-      /* do output mapping of slave and program FMMUs */
-      for (slave = 1; slave <= *(context->slavecount); slave++)
+      /* do output mapping of slave and program FMMUs, slaves with blockLRW first */
+      for (pass = 0; pass < 2; pass++)
       {
-         configadr = context->slavelist[slave].configadr;
-
-         if (!group || (group == context->slavelist[slave].group))
+         cmd = pass ? 0 : NEX_CMD_LWR;
+         for (slave = 1; slave <= *(context->slavecount); slave++)
          {
-            /* create output mapping */
-            if (context->slavelist[slave].Obits)
+            if ((!group || (group == context->slavelist[slave].group)) &&
+                ((context->slavelist[slave].blockLRW ? 0 : 1) == pass))
             {
-               nexx_config_create_output_mappings (context, pIOmap, group, slave, &LogAddr, &BitPos);
-               diff = LogAddr - oLogAddr;
-               oLogAddr = LogAddr;
-               if ((segmentsize + diff) > (NEX_MAXLRWDATA - NEX_FIRSTDCDATAGRAM))
+               /* create output mapping */
+               if (context->slavelist[slave].Obits)
                {
-                  context->grouplist[group].IOsegment[currentsegment] = segmentsize;
-                  if (currentsegment < (NEX_MAXIOSEGMENTS - 1))
-                  {
-                     currentsegment++;
-                     segmentsize = diff;
-                  }
-               }
-               else
-               {
-                  segmentsize += diff;
+                  nexx_config_create_output_mappings (context, pIOmap, group, slave, &LogAddr, &BitPos);
+                  diff = LogAddr - oLogAddr;
+                  oLogAddr = LogAddr;
+                  fit &= nexx_config_add_segment(grp, &currentsegment, &segmentsize, diff, cmd, &split);
                }
             }
          }
-      }
-      if (BitPos)
-      {
-         LogAddr++;
-         oLogAddr = LogAddr;
-         BitPos = 0;
-         if ((segmentsize + 1) > (NEX_MAXLRWDATA - NEX_FIRSTDCDATAGRAM))
+         if (BitPos)
          {
-            context->grouplist[group].IOsegment[currentsegment] = segmentsize;
-            if (currentsegment < (NEX_MAXIOSEGMENTS - 1))
-            {
-               currentsegment++;
-               segmentsize = 1;
-            }
-         }
-         else
-         {
-            segmentsize += 1;
+            LogAddr++;
+            oLogAddr = LogAddr;
+            BitPos = 0;
+            fit &= nexx_config_add_segment(grp, &currentsegment, &segmentsize, 1, cmd, &split);
          }
       }
       context->grouplist[group].outputs = pIOmap;
-      context->grouplist[group].Obytes = LogAddr;
+      context->grouplist[group].Obytes = LogAddr - context->grouplist[group].logstartaddr;
       context->grouplist[group].nsegments = currentsegment + 1;
       context->grouplist[group].Isegment = currentsegment;
       context->grouplist[group].Ioffset = segmentsize;
       if (!group)
       {
          context->slavelist[0].outputs = pIOmap;
-         context->slavelist[0].Obytes = LogAddr; /* store output bytes in master record */
+         context->slavelist[0].Obytes = LogAddr - context->grouplist[group].logstartaddr; /* store output bytes in master record */
       }
 
-      /* do input mapping of slave and program FMMUs */
-      for (slave = 1; slave <= *(context->slavecount); slave++)
+      /* do input mapping of slave and program FMMUs, slaves with blockLRW last */
+      for (pass = 0; pass < 2; pass++)
       {
-         configadr = context->slavelist[slave].configadr;
-         if (!group || (group == context->slavelist[slave].group))
+         cmd = pass ? NEX_CMD_LRD : 0;
+         for (slave = 1; slave <= *(context->slavecount); slave++)
          {
-            /* create input mapping */
-            if (context->slavelist[slave].Ibits)
+            if ((!group || (group == context->slavelist[slave].group)) &&
+                ((context->slavelist[slave].blockLRW ? 1 : 0) == pass))
             {
- 
-               nexx_config_create_input_mappings(context, pIOmap, group, slave, &LogAddr, &BitPos);
-               diff = LogAddr - oLogAddr;
-               oLogAddr = LogAddr;
-               if ((segmentsize + diff) > (NEX_MAXLRWDATA - NEX_FIRSTDCDATAGRAM))
-               {
-                  context->grouplist[group].IOsegment[currentsegment] = segmentsize;
-                  if (currentsegment < (NEX_MAXIOSEGMENTS - 1))
-                  {
-                     currentsegment++;
-                     segmentsize = diff;
-                  }
-               }
-               else
+               /* create input mapping */
+               if (context->slavelist[slave].Ibits)
                {
-                  segmentsize += diff;
+                  nexx_config_create_input_mappings(context, pIOmap, group, slave, &LogAddr, &BitPos);
+                  diff = LogAddr - oLogAddr;
+                  oLogAddr = LogAddr;
+                  fit &= nexx_config_add_segment(grp, &currentsegment, &segmentsize, diff, cmd, &split);
                }
             }
-
-            nexx_eeprom2pdi(context, slave); /* set Eeprom control to PDI */
-            nexx_FPWRw(context->port, configadr, ECT_REG_ALCTL, htoes(NEX_STATE_SAFE_OP) , NEX_TIMEOUTRET3); /* set safeop status */
-
-            if (context->slavelist[slave].blockLRW)
-            {
-               context->grouplist[group].blockLRW++;
-            }
-            context->grouplist[group].Ebuscurrent += context->slavelist[slave].Ebuscurrent;
-         }
-      }
-      if (BitPos)
-      {
-         LogAddr++;
-         oLogAddr = LogAddr;
-         BitPos = 0;
-         if ((segmentsize + 1) > (NEX_MAXLRWDATA - NEX_FIRSTDCDATAGRAM))
-         {
-            context->grouplist[group].IOsegment[currentsegment] = segmentsize;
-            if (currentsegment < (NEX_MAXIOSEGMENTS - 1))
-            {
-               currentsegment++;
-               segmentsize = 1;
-            }
          }
-         else
+         if (BitPos)
          {
-            segmentsize += 1;
+            LogAddr++;
+            oLogAddr = LogAddr;
+            BitPos = 0;
+            fit &= nexx_config_add_segment(grp, &currentsegment, &segmentsize, 1, cmd, &split);
          }
       }
       context->grouplist[group].IOsegment[currentsegment] = segmentsize;
       context->grouplist[group].nsegments = currentsegment + 1;
+      /* inputs start in the next segment if the last outputs are for LWR */
+      if ((context->grouplist[group].IOsegmentcmd[context->grouplist[group].Isegment] == NEX_CMD_LWR) &&
+          (context->grouplist[group].Isegment < currentsegment))
+      {
+         context->grouplist[group].Isegment++;
+         context->grouplist[group].Ioffset = 0;
+      }
       context->grouplist[group].inputs = (uint8 *)(pIOmap) + context->grouplist[group].Obytes;
-      context->grouplist[group].Ibytes = LogAddr - context->grouplist[group].Obytes;
+      context->grouplist[group].Ibytes = LogAddr - context->grouplist[group].logstartaddr - context->grouplist[group].Obytes;
       if (!group)
       {
          context->slavelist[0].inputs = (uint8 *)(pIOmap) + context->slavelist[0].Obytes;
-         context->slavelist[0].Ibytes = LogAddr - context->slavelist[0].Obytes; /* store input bytes in master record */
+         context->slavelist[0].Ibytes = LogAddr - context->grouplist[group].logstartaddr - context->slavelist[0].Obytes; /* store input bytes in master record */
       }
 
+      if (!fit)
+      {
+         nexx_packeterror(context, 0, 0, 0, 11); /* IO segments of group exhausted */
+         return 0;
+      }
+      nblock = nexx_config_group_safeop(context, group);
+      /* without segments of their own LRW is blocked for all slaves */
+      context->grouplist[group].blockLRW = split ? 0 : (uint8)nblock;
+      nexx_select_processdata(context, group, FALSE);
+
       NEX_PRINT("IOmapSize %d\n", LogAddr - context->grouplist[group].logstartaddr);
 
       return (LogAddr - context->grouplist[group].logstartaddr);
@@ -1290,15 +1447,18 @@ int nexx_config_map_group(nexx_contextt *context, void *pIOmap, uint8 group)
 
 /** Map all PDOs in one group of slaves to IOmap with Outputs/Inputs
  * overlapping. NOTE: Must use this for TI ESC when using LRW.
+ * Slaves with blockLRW are mapped after the others without overlap, first
+ * their outputs and then their inputs, in IO segments of their own for LWR
+ * and LRD.
  *
  * @param[in]  context    = context struct
  * @param[out] pIOmap     = pointer to IOmap
  * @param[in]  group      = group to map, 0 = all groups
- * @return IOmap size
+ * @return IOmap size, 0 if the IO segments of the group ran out
  */
 int nexx_config_overlap_map_group(nexx_contextt *context, void *pIOmap, uint8 group)
 {
-   uint16 slave, configadr;
+   uint16 slave;
    uint8 BitPos;
    uint32 mLogAddr = 0;
    uint32 siLogAddr = 0;
@@ -1307,10 +1467,15 @@ int nexx_config_overlap_map_group(nexx_contextt *context, void *pIOmap, uint8 gr
    uint32 diff;
    uint16 currentsegment = 0;
    uint32 segmentsize = 0;
+   boolean split = TRUE;
+   boolean fit = TRUE;
+   int nblock = 0;
+   nex_groupt *grp;
 
    if ((*(context->slavecount) > 0) && (group < context->maxgroup))
    {
       NEX_PRINT("nex_config_map_group IOmap:%p group:%d\n", pIOmap, group);
+      grp = &(context->grouplist[group]);
       mLogAddr = context->grouplist[group].logstartaddr;
       siLogAddr = mLogAddr;
       soLogAddr = mLogAddr;
@@ -1318,6 +1483,7 @@ int nexx_config_overlap_map_group(nexx_contextt *context, void *pIOmap, uint8 gr
       context->grouplist[group].nsegments = 0;
       context->grouplist[group].outputsWKC = 0;
       context->grouplist[group].inputsWKC = 0;
+      memset(context->grouplist[group].IOsegmentcmd, 0, sizeof(context->grouplist[group].IOsegmentcmd));
 
       /* Find mappings and program syncmanagers */
       nexx_config_find_mappings(context, group);
@@ -1325,11 +1491,15 @@ int nexx_config_overlap_map_group(nexx_contextt *context, void *pIOmap, uint8 gr
       /* do IO mapping of slave and program FMMUs */
       for (slave = 1; slave <= *(context->slavecount); slave++)
       {
-         configadr = context->slavelist[slave].configadr;
          siLogAddr = soLogAddr = mLogAddr;
 
          if (!group || (group == context->slavelist[slave].group))
          {
+            if (context->slavelist[slave].blockLRW)
+            {
+               nblock++;
+               continue;
+            }
             /* create output mapping */
             if (context->slavelist[slave].Obits)
             {
@@ -1358,30 +1528,48 @@ int nexx_config_overlap_map_group(nexx_contextt *context, void *pIOmap, uint8 gr
             tempLogAddr = (siLogAddr > soLogAddr) ?  siLogAddr : soLogAddr;
             diff = tempLogAddr - mLogAddr;
             mLogAddr = tempLogAddr;
+            fit &= nexx_config_add_segment(grp, &currentsegment, &segmentsize, diff, 0, &split);
+         }
+      }
 
-            if ((segmentsize + diff) > (NEX_MAXLRWDATA - NEX_FIRSTDCDATAGRAM))
+      /* slaves with blockLRW, outputs and then inputs */
+      if (nblock)
+      {
+         soLogAddr = mLogAddr;
+         for (slave = 1; slave <= *(context->slavecount); slave++)
+         {
+            if ((!group || (group == context->slavelist[slave].group)) && context->slavelist[slave].blockLRW &&
+                context->slavelist[slave].Obits)
             {
-               context->grouplist[group].IOsegment[currentsegment] = segmentsize;
-               if (currentsegment < (NEX_MAXIOSEGMENTS - 1))
+               nexx_config_create_output_mappings(context, pIOmap, group, 
+                  slave, &soLogAddr, &BitPos);
+               if (BitPos)
                {
-                  currentsegment++;
-                  segmentsize = diff;
+                  soLogAddr++;
+                  BitPos = 0;
                }
+               diff = soLogAddr - mLogAddr;
+               mLogAddr = soLogAddr;
+               fit &= nexx_config_add_segment(grp, &currentsegment, &segmentsize, diff, NEX_CMD_LWR, &split);
             }
-            else
-            {
-               segmentsize += diff;
-            }
-
-            nexx_eeprom2pdi(context, slave); /* set Eeprom control to PDI */
-            nexx_FPWRw(context->port, configadr, ECT_REG_ALCTL, htoes(NEX_STATE_SAFE_OP), NEX_TIMEOUTRET3); /* set safeop status */
-
-            if (context->slavelist[slave].blockLRW)
+         }
+         siLogAddr = mLogAddr;
+         for (slave = 1; slave <= *(context->slavecount); slave++)
+         {
+            if ((!group || (group == context->slavelist[slave].group)) && context->slavelist[slave].blockLRW &&
+                context->slavelist[slave].Ibits)
             {
-               context->grouplist[group].blockLRW++;
+               nexx_config_create_input_mappings(context, pIOmap, group, 
+                  slave, &siLogAddr, &BitPos);
+               if (BitPos)
+               {
+                  siLogAddr++;
+                  BitPos = 0;
+               }
+               diff = siLogAddr - mLogAddr;
+               mLogAddr = siLogAddr;
+               fit &= nexx_config_add_segment(grp, &currentsegment, &segmentsize, diff, NEX_CMD_LRD, &split);
             }
-            context->grouplist[group].Ebuscurrent += context->slavelist[slave].Ebuscurrent;
-
          }
       }
 
@@ -1390,25 +1578,38 @@ int nexx_config_overlap_map_group(nexx_contextt *context, void *pIOmap, uint8 gr
       context->grouplist[group].Isegment = 0;
       context->grouplist[group].Ioffset = 0;
 
-      context->grouplist[group].Obytes = soLogAddr;
-      context->grouplist[group].Ibytes = siLogAddr;
+      context->grouplist[group].Obytes = soLogAddr - context->grouplist[group].logstartaddr;
+      context->grouplist[group].Ibytes = siLogAddr - context->grouplist[group].logstartaddr;
       context->grouplist[group].outputs = pIOmap;
       context->grouplist[group].inputs = (uint8 *)pIOmap + context->grouplist[group].Obytes;
 
       /* Move calculated inputs with OBytes offset*/
       for (slave = 1; slave <= *(context->slavecount); slave++)
       {
-         context->slavelist[slave].inputs += context->grouplist[group].Obytes;
+         if (!group || (group == context->slavelist[slave].group))
+         {
+            context->slavelist[slave].inputs += context->grouplist[group].Obytes;
+         }
       }
 
       if (!group)
       {
          context->slavelist[0].outputs = pIOmap;
-         context->slavelist[0].Obytes = soLogAddr; /* store output bytes in master record */
+         context->slavelist[0].Obytes = context->grouplist[group].Obytes; /* store output bytes in master record */
          context->slavelist[0].inputs = (uint8 *)pIOmap + context->slavelist[0].Obytes;
-         context->slavelist[0].Ibytes = siLogAddr;
+         context->slavelist[0].Ibytes = context->grouplist[group].Ibytes;
       }
 
+      if (!fit)
+      {
+         nexx_packeterror(context, 0, 0, 0, 11); /* IO segments of group exhausted */
+         return 0;
+      }
+      nexx_config_group_safeop(context, group);
+      /* without segments of their own LRW is blocked for all slaves */
+      context->grouplist[group].blockLRW = split ? 0 : (uint8)nblock;
+      nexx_select_processdata(context, group, TRUE);
+
       NEX_PRINT("IOmapSize %d\n", context->grouplist[group].Obytes + context->grouplist[group].Ibytes);
 
       return (context->grouplist[group].Obytes + context->grouplist[group].Ibytes);
@@ -1522,6 +1723,10 @@ int nexx_reconfig_slave(nexx_contextt *context, uint16 slave, int timeout)
          {
             context->slavelist[slave].PO2SOconfig(slave);
          }
+         if(context->slavelist[slave].PO2SOconfigx) /* only if registered */
+         {
+            context->slavelist[slave].PO2SOconfigx(context, slave);
+         }
          nexx_FPWRw(context->port, configadr, ECT_REG_ALCTL, htoes(NEX_STATE_SAFE_OP) , timeout); /* set safeop status */
          state = nexx_statecheck(context, slave, NEX_STATE_SAFE_OP, NEX_TIMEOUTSTATE); /* check state change safe-op */
          /* program configured FMMU */
@@ -1653,4 +1858,24 @@ int nex_reconfig_slave(uint16 slave, int timeout)
 {
    return nexx_reconfig_slave(&nexx_context, slave, timeout);
 }
+
+/** Build the topology tree.
+ * @return number of slaves in the tree
+ * @see nexx_topology_build
+ */
+int nex_topology_build(void)
+{
+   return nexx_topology_build(&nexx_context);
+}
+
+/** Walk a subtree of the topology.
+ * @param[in]  root     = root of the subtree, 0 for all slaves
+ * @param[in]  slave    = current slave, root to start
+ * @return next slave of the subtree, 0 at the end
+ * @see nexx_topology_next
+ */
+uint16 nex_topology_next(uint16 root, uint16 slave)
+{
+   return nexx_topology_next(&nexx_context, root, slave);
+}
 #endif
@@ -29,6 +29,8 @@ int nex_config(void *pIOmap);
 int nex_config_overlap(void *pIOmap);
 int nex_recover_slave(uint16 slave, int timeout);
 int nex_reconfig_slave(uint16 slave, int timeout);
+int nex_topology_build(void);
+uint16 nex_topology_next(uint16 root, uint16 slave);
 #endif
 
 int nexx_config_init(nexx_contextt *context);
@@ -36,6 +38,8 @@ int nexx_config_map_group(nexx_contextt *context, void *pIOmap, uint8 group);
 int nexx_config_overlap_map_group(nexx_contextt *context, void *pIOmap, uint8 group);
 int nexx_recover_slave(nexx_contextt *context, uint16 slave, int timeout);
 int nexx_reconfig_slave(nexx_contextt *context, uint16 slave, int timeout);
+int nexx_topology_build(nexx_contextt *context);
+uint16 nexx_topology_next(nexx_contextt *context, uint16 root, uint16 slave);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,929 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Header only C++20 coroutine layer for mailbox and configuration sequences.
+ *
+ * A nex::co::Scheduler runs many nex::co::task coroutines on one thread. A
+ * task suspends on co_await of a mailbox exchange, a register read or write
+ * or a delay. Every Scheduler::poll collects the pending operations of all
+ * tasks, moves them with nexx_mbxwrite_multi, nexx_mbxpoll_multi and
+ * nexx_FP_multi in shared frames and resumes the tasks whose operation is
+ * complete. Per slave the mailbox exchanges are done in the order they were
+ * requested. SDO transfers and state changes are tasks built on these
+ * primitives, so the setup sequence of a slave reads like blocking code while
+ * the sequences of hundreds of slaves run interleaved:
+ *
+ *    nex::co::task<void> setup(nex::co::Scheduler &s, uint16 slave)
+ *    {
+ *       co_await s.sdo_write<uint8>(slave, 0x1c12, 0, 0);
+ *       co_await s.sdo_write<uint16>(slave, 0x1c12, 1, 0x1600);
+ *       co_await s.sdo_write<uint8>(slave, 0x1c12, 0, 1);
+ *       co_await s.state(slave, NEX_STATE_SAFE_OP);
+ *    }
+ *
+ * Errors are returned as nex::result like in ethercat.hpp, they are not pushed
+ * to the error list. The scheduler and its tasks must be used from the thread
+ * that does the other mailbox traffic of the context.
+ */
+
+#ifndef _ethercatcoro_hpp_
+#define _ethercatcoro_hpp_
+
+#if !defined(__cpp_impl_coroutine) && !defined(__cpp_coroutines)
+#error "ethercatcoro.hpp needs C++20 coroutines"
+#endif
+
+#include <algorithm>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <vector>
+
+#include "ethercat.hpp"
+
+namespace nex
+{
+namespace co
+{
+
+namespace detail
+{
+
+/** SDO structure, same layout as in ethercatcoe.c */
+PACKED_BEGIN
+typedef struct PACKED
+{
+   nex_mbxheadert   MbxHeader;
+   uint16          CANOpen;
+   uint8           Command;
+   uint16          Index;
+   uint8           SubIndex;
+   union
+   {
+      uint8   bdata[0x200]; /* variants for easy data access */
+      uint16  wdata[0x100];
+      uint32  ldata[0x80];
+   };
+} sdot;
+PACKED_END
+
+/** CoE emergency, same layout as in ethercatmain.c */
+PACKED_BEGIN
+typedef struct PACKED
+{
+   nex_mbxheadert   MbxHeader;
+   uint16          CANOpen;
+   uint16          ErrorCode;
+   uint8           ErrorReg;
+   uint8           bData;
+   uint16          w1;
+   uint16          w2;
+} emcyt;
+PACKED_END
+
+/** fill header of SDO request, the mailbox counter is set by the scheduler */
+inline void sdo_header(sdot *SDOp, uint16 length)
+{
+   SDOp->MbxHeader.length = htoes(length);
+   SDOp->MbxHeader.address = htoes(0x0000);
+   SDOp->MbxHeader.priority = 0x00;
+   SDOp->MbxHeader.mbxtype = ECT_MBXT_COE;
+   SDOp->CANOpen = htoes(0x000 + (ECT_COES_SDOREQ << 12)); /* number 9bits service upper 4 bits (SDO request) */
+}
+
+inline nex::error sdo_error(uint16 slave, uint16 index, uint8 subindex, nex_err_type etype, int32 code)
+{
+   nex::error err;
+
+   std::memset(&err.detail, 0, sizeof(err.detail));
+   err.code = 0;
+   err.has_detail = true;
+   err.detail.Time = osal_current_time();
+   err.detail.Slave = slave;
+   err.detail.Index = index;
+   err.detail.SubIdx = subindex;
+   err.detail.Etype = etype;
+   err.detail.AbortCode = code;
+   return err;
+}
+
+/** part of the promise that does not depend on the value type */
+struct promise_base
+{
+   /** coroutine awaiting this task, empty for a task started by spawn */
+   std::coroutine_handle<> continuation;
+   std::exception_ptr exception;
+
+   struct final_awaiter
+   {
+      bool await_ready() noexcept { return false; }
+      template <typename P>
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept
+      {
+         std::coroutine_handle<> c = h.promise().continuation;
+         return c ? c : std::noop_coroutine();
+      }
+      void await_resume() noexcept {}
+   };
+
+   std::suspend_always initial_suspend() noexcept { return {}; }
+   final_awaiter final_suspend() noexcept { return {}; }
+   void unhandled_exception() noexcept { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct promise : promise_base
+{
+   std::optional<T> value;
+
+   void return_value(T v) { value.emplace(std::move(v)); }
+   T take()
+   {
+      if (exception)
+      {
+         std::rethrow_exception(exception);
+      }
+      return std::move(*value);
+   }
+};
+
+template <>
+struct promise<void> : promise_base
+{
+   void return_void() noexcept {}
+   void take()
+   {
+      if (exception)
+      {
+         std::rethrow_exception(exception);
+      }
+   }
+};
+
+} // namespace detail
+
+/** coroutine, started by co_await from another task or by Scheduler::spawn */
+template <typename T = void>
+class task
+{
+public:
+   struct promise_type : detail::promise<T>
+   {
+      task get_return_object() noexcept
+      {
+         return task(std::coroutine_handle<promise_type>::from_promise(*this));
+      }
+   };
+
+   task(task &&other) noexcept : h_(other.h_) { other.h_ = nullptr; }
+   task &operator=(task &&other) noexcept
+   {
+      if (this != &other)
+      {
+         if (h_)
+         {
+            h_.destroy();
+         }
+         h_ = other.h_;
+         other.h_ = nullptr;
+      }
+      return *this;
+   }
+   task(const task &) = delete;
+   task &operator=(const task &) = delete;
+   ~task()
+   {
+      if (h_)
+      {
+         h_.destroy();
+      }
+   }
+
+   /** run the task until it completes, the caller is resumed with its value */
+   auto operator co_await() && noexcept
+   {
+      struct awaiter
+      {
+         std::coroutine_handle<promise_type> h;
+
+         bool await_ready() noexcept { return !h || h.done(); }
+         std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept
+         {
+            h.promise().continuation = caller;
+            return h;
+         }
+         T await_resume() { return h.promise().take(); }
+      };
+      return awaiter{ h_ };
+   }
+
+private:
+   explicit task(std::coroutine_handle<promise_type> h) noexcept : h_(h) {}
+
+   std::coroutine_handle<promise_type> h_;
+
+   friend class Scheduler;
+};
+
+/** single threaded scheduler of the tasks working on one context */
+class Scheduler
+{
+   /** pending primitive of a suspended task */
+   struct op
+   {
+      enum kind_t { MBXWRITE, MBXREAD, FPRD, FPWR, DELAY } kind;
+      uint16 slave;
+      uint16 ado;
+      uint16 length;
+      void *data;
+      nex_mbxbuft *req;
+      nex_mbxbuft *resp;
+      /** mailbox counter of the request, kept when the write is repeated */
+      uint8 mbxcnt;
+      int timeout;
+      int wkc;
+      uint32 seq;
+      osal_timert timer;
+      std::coroutine_handle<> h;
+   };
+
+public:
+   explicit Scheduler(nexx_contextt *context) : ctx_(context), seq_(0) {}
+   explicit Scheduler(Master &master) : Scheduler(master.context()) {}
+   Scheduler(const Scheduler &) = delete;
+   Scheduler &operator=(const Scheduler &) = delete;
+   /** tasks not completed yet are destroyed */
+   ~Scheduler()
+   {
+      ops_.clear();
+      for (std::coroutine_handle<task<void>::promise_type> h : tasks_)
+      {
+         h.destroy();
+      }
+   }
+
+   nexx_contextt *context() noexcept { return ctx_; }
+   /** number of tasks not completed yet */
+   std::size_t active() const noexcept { return tasks_.size(); }
+
+   /** start task, it runs up to its first co_await before spawn returns */
+   void spawn(task<void> t)
+   {
+      std::coroutine_handle<task<void>::promise_type> h = t.h_;
+
+      t.h_ = nullptr;
+      tasks_.push_back(h);
+      h.resume();
+      reap();
+   }
+
+   /** Move all pending operations one step and resume the tasks whose operation
+    * completed. Exceptions of spawned tasks are rethrown here.
+    * @return number of operations completed
+    */
+   int poll()
+   {
+      std::vector<op *> ready;
+      std::size_t i;
+
+      expire(ready);
+      mbx_write();
+      mbx_read(ready);
+      fp(NEX_CMD_FPWR, ready);
+      fp(NEX_CMD_FPRD, ready);
+      for (i = 0; i < ready.size(); i++)
+      {
+         ready[i]->h.resume();
+      }
+      reap();
+      return (int)ready.size();
+   }
+
+   /** poll until all tasks are completed
+    * @param[in]  timeout    = Timeout in us
+    * @return true if all tasks completed
+    */
+   bool run(int timeout)
+   {
+      osal_timert timer;
+
+      osal_timer_start(&timer, timeout);
+      while (!tasks_.empty())
+      {
+         if (osal_timer_is_expired(&timer))
+         {
+            return false;
+         }
+         if (!poll())
+         {
+            osal_usleep(50);
+         }
+      }
+      return true;
+   }
+
+   /** awaitable of one primitive, the operation lives in the suspended frame */
+   class awaiter
+   {
+   public:
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> h)
+      {
+         o_.h = h;
+         s_->queue(&o_);
+      }
+      /** working counter, 0 on timeout */
+      int await_resume() const noexcept { return o_.wkc; }
+
+   private:
+      awaiter(Scheduler *s, const op &o) : s_(s), o_(o) {}
+
+      Scheduler *s_;
+      op o_;
+
+      friend class Scheduler;
+   };
+
+   /** Write request to mailbox of slave and wait for the next response. With
+    * req nullptr only the next response is awaited. The mailbox counter of the
+    * request is set here.
+    * @param[in]  slave      = Slave number
+    * @param[in]  req        = request, nullptr to read only
+    * @param[out] resp       = response
+    * @param[in]  timeout    = Timeout in us for the mailbox to get free and for the response
+    */
+   awaiter mbx(uint16 slave, nex_mbxbuft *req, nex_mbxbuft *resp, int timeout = NEX_TIMEOUTRXM)
+   {
+      op o = {};
+
+      o.kind = req ? op::MBXWRITE : op::MBXREAD;
+      o.slave = slave;
+      o.req = req;
+      o.resp = resp;
+      o.timeout = timeout;
+      return awaiter(this, o);
+   }
+   /** configured address read of slave register */
+   awaiter fprd(uint16 slave, uint16 ado, void *data, uint16 length)
+   {
+      op o = {};
+
+      o.kind = op::FPRD;
+      o.slave = slave;
+      o.ado = ado;
+      o.data = data;
+      o.length = length;
+      return awaiter(this, o);
+   }
+   /** configured address write of slave register */
+   awaiter fpwr(uint16 slave, uint16 ado, void *data, uint16 length)
+   {
+      op o = {};
+
+      o.kind = op::FPWR;
+      o.slave = slave;
+      o.ado = ado;
+      o.data = data;
+      o.length = length;
+      return awaiter(this, o);
+   }
+   /** resume after usec, checked once per poll */
+   awaiter delay(int usec)
+   {
+      op o = {};
+
+      o.kind = op::DELAY;
+      o.timeout = usec;
+      return awaiter(this, o);
+   }
+
+   /** Request state of slave and wait for it, like nexx_statecheck. The state and
+    * AL status code of the slave list are updated.
+    * @return state reached, with NEX_STATE_ERROR if the slave refused the request
+    */
+   task<result<uint16>> state(uint16 slave, uint16 reqstate, int timeout = NEX_TIMEOUTSTATE)
+   {
+      uint16 ctl;
+      uint16 stat[3];
+      uint16 rval;
+      osal_timert timer;
+      int wkc;
+
+      ctl = htoes(reqstate);
+      wkc = co_await fpwr(slave, ECT_REG_ALCTL, &ctl, sizeof(ctl));
+      if (wkc <= 0)
+      {
+         co_return nex::error{ wkc, false, nex_errort() };
+      }
+      osal_timer_start(&timer, timeout);
+      do
+      {
+         co_await delay(1000);
+         std::memset(stat, 0, sizeof(stat));
+         /* AL status and AL status code */
+         wkc = co_await fprd(slave, ECT_REG_ALSTAT, stat, sizeof(stat));
+         rval = etohs(stat[0]);
+      } while ((((wkc <= 0) || ((rval & 0x0f) != reqstate)) && !(rval & NEX_STATE_ERROR)) &&
+               !osal_timer_is_expired(&timer));
+      if (wkc <= 0)
+      {
+         co_return nex::error{ wkc, false, nex_errort() };
+      }
+      ctx_->slavelist[slave].state = rval;
+      ctx_->slavelist[slave].ALstatuscode = etohs(stat[2]);
+      co_return rval;
+   }
+
+   /** CoE SDO write, same transfers as nexx_SDOwrite */
+   task<result<void>> sdo_write(uint16 slave, uint16 index, uint8 subindex, span<const uint8> buf,
+                                bool ca = false, int timeout = NEX_TIMEOUTRXM)
+   {
+      nex_mbxbuft req, resp;
+      detail::sdot *SDOp = (detail::sdot *)&req;
+      detail::sdot *aSDOp = (detail::sdot *)&resp;
+      const uint8 *hp = buf.data();
+      int psize = (int)buf.size();
+      int maxdata = ctx_->slavelist[slave].mbx_l - 0x10; /* data section=mailbox size - 6 mbx - 2 CoE - 8 sdo req */
+      int framedatasize;
+      bool notlast;
+      uint8 toggle;
+
+      nex_clearmbx(&req);
+      if ((psize <= 4) && !ca)
+      {
+         detail::sdo_header(SDOp, 0x000a);
+         SDOp->Command = ECT_SDO_DOWN_EXP | (((4 - psize) << 2) & 0x0c); /* expedited SDO download transfer */
+         SDOp->Index = htoes(index);
+         SDOp->SubIndex = subindex;
+         std::memcpy(&SDOp->ldata[0], hp, psize);
+         result<void> r = co_await sdo_exchange(slave, index, subindex, &req, &resp, timeout);
+         if (r && ((aSDOp->Index != SDOp->Index) || (aSDOp->SubIndex != SDOp->SubIndex)))
+         {
+            r = detail::sdo_error(slave, index, subindex, NEX_ERR_TYPE_PACKET_ERROR, 1);
+         }
+         co_return r;
+      }
+      framedatasize = psize;
+      notlast = false;
+      if (framedatasize > maxdata)
+      {
+         framedatasize = maxdata; /* segmented transfer needed */
+         notlast = true;
+      }
+      detail::sdo_header(SDOp, (uint16)(0x0a + framedatasize));
+      SDOp->Command = ca ? ECT_SDO_DOWN_INIT_CA : ECT_SDO_DOWN_INIT;
+      SDOp->Index = htoes(index);
+      SDOp->SubIndex = (ca && (subindex > 1)) ? 1 : subindex;
+      SDOp->ldata[0] = htoel(psize);
+      std::memcpy(&SDOp->ldata[1], hp, framedatasize);
+      hp += framedatasize;
+      psize -= framedatasize;
+      result<void> r = co_await sdo_exchange(slave, index, subindex, &req, &resp, timeout);
+      if (r && ((aSDOp->Index != SDOp->Index) || (aSDOp->SubIndex != SDOp->SubIndex)))
+      {
+         r = detail::sdo_error(slave, index, subindex, NEX_ERR_TYPE_PACKET_ERROR, 1);
+      }
+      maxdata += 7;
+      toggle = 0;
+      /* repeat while segments left */
+      while (r && notlast)
+      {
+         framedatasize = psize;
+         notlast = false;
+         SDOp->Command = 0x01; /* last segment */
+         if (framedatasize > maxdata)
+         {
+            framedatasize = maxdata; /* more segments needed */
+            notlast = true;
+            SDOp->Command = 0x00; /* segments follow */
+         }
+         if (!notlast && (framedatasize < 7))
+         {
+            detail::sdo_header(SDOp, 0x0a); /* minimum size */
+            SDOp->Command = 0x01 + ((7 - framedatasize) << 1); /* last segment reduced octets */
+         }
+         else
+         {
+            detail::sdo_header(SDOp, (uint16)(framedatasize + 3)); /* data + 2 CoE + 1 SDO */
+         }
+         SDOp->Command = SDOp->Command + toggle;
+         std::memcpy(&SDOp->Index, hp, framedatasize);
+         hp += framedatasize;
+         psize -= framedatasize;
+         r = co_await sdo_exchange(slave, index, subindex, &req, &resp, timeout);
+         if (r && ((aSDOp->Command & 0xe0) != 0x20))
+         {
+            r = detail::sdo_error(slave, index, subindex, NEX_ERR_TYPE_PACKET_ERROR, 1);
+         }
+         toggle = toggle ^ 0x10; /* toggle bit for segment request */
+      }
+      co_return r;
+   }
+   /** CoE SDO write of trivially copyable value */
+   template <typename T>
+   task<result<void>> sdo_write(uint16 slave, uint16 index, uint8 subindex, T value, bool ca = false,
+                                int timeout = NEX_TIMEOUTRXM)
+   {
+      static_assert(std::is_trivially_copyable<T>::value, "sdo_write needs a trivially copyable type");
+      co_return co_await sdo_write(slave, index, subindex,
+                                   span<const uint8>((const uint8 *)&value, sizeof(T)), ca, timeout);
+   }
+
+   /** CoE SDO read, same transfers as nexx_SDOread, returns bytes read */
+   task<result<int>> sdo_read(uint16 slave, uint16 index, uint8 subindex, span<uint8> buf, bool ca = false,
+                              int timeout = NEX_TIMEOUTRXM)
+   {
+      nex_mbxbuft req, resp;
+      detail::sdot *SDOp = (detail::sdot *)&req;
+      detail::sdot *aSDOp = (detail::sdot *)&resp;
+      uint8 *hp = buf.data();
+      int psize = (int)buf.size();
+      int bytesize, framedatasize, size;
+      int32 sdolen;
+      bool notlast;
+      uint8 toggle;
+
+      nex_clearmbx(&req);
+      detail::sdo_header(SDOp, 0x000a);
+      SDOp->Command = ca ? ECT_SDO_UP_REQ_CA : ECT_SDO_UP_REQ;
+      SDOp->Index = htoes(index);
+      if (ca && (subindex > 1))
+      {
+         subindex = 1;
+      }
+      SDOp->SubIndex = subindex;
+      SDOp->ldata[0] = 0;
+      result<void> r = co_await sdo_exchange(slave, index, subindex, &req, &resp, timeout);
+      if (!r)
+      {
+         co_return r.error();
+      }
+      if (aSDOp->Index != SDOp->Index)
+      {
+         co_return detail::sdo_error(slave, index, subindex, NEX_ERR_TYPE_PACKET_ERROR, 1);
+      }
+      if (aSDOp->Command & 0x02)
+      {
+         /* expedited frame response */
+         bytesize = 4 - ((aSDOp->Command >> 2) & 0x03);
+         if (psize < bytesize)
+         {
+            co_return detail::sdo_error(slave, index, subindex, NEX_ERR_TYPE_PACKET_ERROR, 3);
+         }
+         std::memcpy(hp, &aSDOp->ldata[0], bytesize);
+         co_return bytesize;
+      }
+      /* normal frame response */
+      sdolen = etohl(aSDOp->ldata[0]);
+      if (sdolen > psize)
+      {
+         co_return detail::sdo_error(slave, index, subindex, NEX_ERR_TYPE_PACKET_ERROR, 3);
+      }
+      framedatasize = etohs(aSDOp->MbxHeader.length) - 10;
+      if (framedatasize >= sdolen)
+      {
+         /* non segmented transfer */
+         std::memcpy(hp, &aSDOp->ldata[1], sdolen);
+         co_return (int)sdolen;
+      }
+      std::memcpy(hp, &aSDOp->ldata[1], framedatasize);
+      hp += framedatasize;
+      size = framedatasize;
+      notlast = true;
+      toggle = 0x00;
+      while (notlast)
+      {
+         detail::sdo_header(SDOp, 0x000a);
+         SDOp->Command = ECT_SDO_SEG_UP_REQ + toggle; /* segment upload request */
+         SDOp->Index = htoes(index);
+         SDOp->SubIndex = subindex;
+         SDOp->ldata[0] = 0;
+         r = co_await sdo_exchange(slave, index, subindex, &req, &resp, timeout);
+         if (!r)
+         {
+            co_return r.error();
+         }
+         if ((aSDOp->Command & 0xe0) != 0x00)
+         {
+            co_return detail::sdo_error(slave, index, subindex, NEX_ERR_TYPE_PACKET_ERROR, 1);
+         }
+         framedatasize = etohs(aSDOp->MbxHeader.length) - 3;
+         if (aSDOp->Command & 0x01)
+         {
+            /* last segment */
+            notlast = false;
+            if (framedatasize == 7)
+            {
+               framedatasize = framedatasize - ((aSDOp->Command & 0x0e) >> 1);
+            }
+         }
+         if ((size + framedatasize) > psize)
+         {
+            co_return detail::sdo_error(slave, index, subindex, NEX_ERR_TYPE_PACKET_ERROR, 3);
+         }
+         std::memcpy(hp, &aSDOp->Index, framedatasize);
+         hp += framedatasize;
+         size += framedatasize;
+         toggle = toggle ^ 0x10; /* toggle bit for segment request */
+      }
+      co_return size;
+   }
+   /** CoE SDO read of trivially copyable value */
+   template <typename T>
+   task<result<T>> sdo_read(uint16 slave, uint16 index, uint8 subindex, bool ca = false,
+                            int timeout = NEX_TIMEOUTRXM)
+   {
+      static_assert(std::is_trivially_copyable<T>::value, "sdo_read needs a trivially copyable type");
+      T value;
+
+      std::memset(&value, 0, sizeof(T));
+      result<int> r = co_await sdo_read(slave, index, subindex, span<uint8>((uint8 *)&value, sizeof(T)),
+                                        ca, timeout);
+      if (!r)
+      {
+         co_return r.error();
+      }
+      co_return value;
+   }
+
+private:
+
+   /* Send SDO request and wait for its response. Emergencies are stored in the
+      emergency queues, other mailbox messages, f.e. stale data of an earlier
+      transfer, are passed to the mbxhook of the emergency list. */
+   task<result<void>> sdo_exchange(uint16 slave, uint16 index, uint8 subindex, nex_mbxbuft *req,
+                                   nex_mbxbuft *resp, int timeout)
+   {
+      detail::sdot *aSDOp = (detail::sdot *)resp;
+      nex_mbxbuft *wr = req;
+      osal_timert timer;
+      int wkc;
+
+      osal_timer_start(&timer, timeout);
+      for (;;)
+      {
+         wkc = co_await mbx(slave, wr, resp, timeout);
+         if (wkc <= 0)
+         {
+            co_return nex::error{ wkc, false, nex_errort() };
+         }
+         wr = nullptr;
+         if (((aSDOp->MbxHeader.mbxtype & 0x0f) == ECT_MBXT_COE) &&
+             ((etohs(aSDOp->CANOpen) >> 12) == ECT_COES_SDORES))
+         {
+            if (aSDOp->Command == ECT_SDO_ABORT)
+            {
+               co_return detail::sdo_error(slave, index, subindex, NEX_ERR_TYPE_SDO_ERROR,
+                                           etohl(aSDOp->ldata[0]));
+            }
+            co_return result<void>();
+         }
+         mbx_other(slave, resp);
+         if (osal_timer_is_expired(&timer))
+         {
+            co_return detail::sdo_error(slave, index, subindex, NEX_ERR_TYPE_PACKET_ERROR, 1);
+         }
+      }
+   }
+
+   /* mailbox message that is no response to the running transfer */
+   void mbx_other(uint16 slave, nex_mbxbuft *mbx)
+   {
+      detail::emcyt *EMp = (detail::emcyt *)mbx;
+      nex_emcylistt *el = ctx_->emcylist;
+      nex_emcyentryt Em;
+
+      if (((EMp->MbxHeader.mbxtype & 0x0f) == ECT_MBXT_COE) &&
+          ((etohs(EMp->CANOpen) >> 12) == ECT_COES_EMERGENCY))
+      {
+         Em.Time = osal_current_time();
+         Em.Slave = slave;
+         Em.ErrorCode = etohs(EMp->ErrorCode);
+         Em.ErrorReg = EMp->ErrorReg;
+         Em.b1 = EMp->bData;
+         Em.w1 = etohs(EMp->w1);
+         Em.w2 = etohs(EMp->w2);
+         nexx_emcy_push(ctx_, &Em);
+      }
+      else if (el && el->mbxhook)
+      {
+         el->mbxhook(slave, mbx, el->mbxarg);
+      }
+   }
+
+   void queue(op *o)
+   {
+      o->seq = seq_++;
+      o->wkc = 0;
+      o->mbxcnt = 0;
+      osal_timer_start(&o->timer, o->timeout);
+      ops_.push_back(o);
+   }
+
+   /* remove op from pending list and add it to the ready list */
+   void complete(op *o, int wkc, std::vector<op *> &ready)
+   {
+      std::size_t i;
+
+      o->wkc = wkc;
+      for (i = 0; i < ops_.size(); i++)
+      {
+         if (ops_[i] == o)
+         {
+            ops_.erase(ops_.begin() + i);
+            break;
+         }
+      }
+      ready.push_back(o);
+   }
+
+   void expire(std::vector<op *> &ready)
+   {
+      std::size_t i;
+      op *o;
+
+      for (i = 0; i < ops_.size();)
+      {
+         o = ops_[i];
+         if (((o->kind == op::DELAY) || (o->kind == op::MBXWRITE) || (o->kind == op::MBXREAD)) &&
+             osal_timer_is_expired(&o->timer))
+         {
+            complete(o, (o->kind == op::DELAY) ? 1 : 0, ready);
+         }
+         else
+         {
+            i++;
+         }
+      }
+   }
+
+   /* slave has a request in its mailbox that is not answered yet */
+   bool mbx_busy(uint16 slave, const op *self) const
+   {
+      for (const op *o : ops_)
+      {
+         if ((o != self) && (o->slave == slave) &&
+             ((o->kind == op::MBXREAD) || ((o->kind == op::MBXWRITE) && ((int32)(o->seq - self->seq) < 0))))
+         {
+            return true;
+         }
+      }
+      return false;
+   }
+
+   void mbx_write()
+   {
+      std::vector<nex_datagramt> lst;
+      std::vector<uint16> sllst;
+      std::vector<op *> olst;
+      nex_mbxheadert *mbxh;
+      nex_slavet *sl;
+      std::size_t i;
+
+      for (op *o : ops_)
+      {
+         if ((o->kind != op::MBXWRITE) || mbx_busy(o->slave, o))
+         {
+            continue;
+         }
+         sl = &ctx_->slavelist[o->slave];
+         mbxh = (nex_mbxheadert *)o->req;
+         if (!o->mbxcnt)
+         {
+            o->mbxcnt = nex_nextmbxcnt(sl->mbx_cnt);
+            sl->mbx_cnt = o->mbxcnt;
+         }
+         mbxh->mbxtype = (mbxh->mbxtype & 0x0f) | (o->mbxcnt << 4);
+         nex_datagramt d = {};
+         d.data = o->req;
+         lst.push_back(d);
+         sllst.push_back(o->slave);
+         olst.push_back(o);
+      }
+      if (lst.empty())
+      {
+         return;
+      }
+      nexx_mbxwrite_multi(ctx_, (int)lst.size(), sllst.data(), lst.data(), NEX_TIMEOUTRET3);
+      for (i = 0; i < olst.size(); i++)
+      {
+         /* after a lost frame the request is probably in the slave, wait for the
+            response, a full mailbox is written again next poll */
+         if ((lst[i].wkc > 0) || (lst[i].wkc == NEX_NOFRAME))
+         {
+            olst[i]->kind = op::MBXREAD;
+            osal_timer_start(&olst[i]->timer, olst[i]->timeout);
+         }
+      }
+   }
+
+   void mbx_read(std::vector<op *> &ready)
+   {
+      std::vector<nex_datagramt> lst;
+      std::vector<uint16> sllst;
+      std::vector<op *> olst;
+      std::size_t i;
+
+      /* oldest read per slave gets the response */
+      for (op *o : ops_)
+      {
+         if ((o->kind != op::MBXREAD) ||
+             std::find(sllst.begin(), sllst.end(), o->slave) != sllst.end())
+         {
+            continue;
+         }
+         nex_clearmbx(o->resp);
+         nex_datagramt d = {};
+         d.data = o->resp;
+         lst.push_back(d);
+         sllst.push_back(o->slave);
+         olst.push_back(o);
+      }
+      if (lst.empty())
+      {
+         return;
+      }
+      nexx_mbxpoll_multi(ctx_, (int)lst.size(), sllst.data(), lst.data(), NEX_TIMEOUTRET3);
+      for (i = 0; i < olst.size(); i++)
+      {
+         if (lst[i].wkc > 0)
+         {
+            complete(olst[i], lst[i].wkc, ready);
+         }
+      }
+   }
+
+   void fp(uint8 cmd, std::vector<op *> &ready)
+   {
+      std::vector<nex_datagramt> lst;
+      std::vector<op *> olst;
+      op::kind_t kind = (cmd == NEX_CMD_FPWR) ? op::FPWR : op::FPRD;
+      std::size_t i;
+
+      for (op *o : ops_)
+      {
+         if (o->kind != kind)
+         {
+            continue;
+         }
+         nex_datagramt d = {};
+         d.configadr = ctx_->slavelist[o->slave].configadr;
+         d.ADO = o->ado;
+         d.length = o->length;
+         d.data = o->data;
+         lst.push_back(d);
+         olst.push_back(o);
+      }
+      if (lst.empty())
+      {
+         return;
+      }
+      nexx_FP_multi(ctx_, cmd, lst.data(), (int)lst.size(), NEX_TIMEOUTRET3);
+      for (i = 0; i < olst.size(); i++)
+      {
+         complete(olst[i], lst[i].wkc, ready);
+      }
+   }
+
+   /* destroy completed tasks, rethrow the first exception */
+   void reap()
+   {
+      std::exception_ptr exception;
+      std::size_t i;
+
+      for (i = 0; i < tasks_.size();)
+      {
+         if (tasks_[i].done())
+         {
+            if (!exception)
+            {
+               exception = tasks_[i].promise().exception;
+            }
+            tasks_[i].destroy();
+            tasks_.erase(tasks_.begin() + i);
+         }
+         else
+         {
+            i++;
+         }
+      }
+      if (exception)
+      {
+         std::rethrow_exception(exception);
+      }
+   }
+
+   nexx_contextt *ctx_;
+   uint32 seq_;
+   std::vector<op *> ops_;
+   std::vector<std::coroutine_handle<task<void>::promise_type>> tasks_;
+};
+
+} // namespace co
+} // namespace nex
+
+#endif
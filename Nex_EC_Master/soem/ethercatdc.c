@@ -8,6 +8,7 @@
  * Distributed Clock EtherCAT functions.
  *
  */
+#include <string.h>
 #include "oshw.h"
 #include "osal.h"
 #include "ethercattype.h"
@@ -23,6 +24,32 @@
 /** 1st sync pulse delay in ns here 100ms */
 #define SyncDelay       ((int32)100000000)
 
+/** DC tuner, wire time of one byte at 100Mbit in ns */
+#define NEX_DCTUNE_BYTETIME      80
+/** DC tuner, preamble, FCS and interframe gap in bytes */
+#define NEX_DCTUNE_FRAMEOVERHEAD 24
+/** DC tuner, default time between frame end and SYNC0 in ns */
+#define NEX_DCTUNE_GUARD         ((int32)1000)
+/** DC tuner, filter constant of running averages */
+#define NEX_DCTUNE_FILTER        16
+/** DC tuner, decay constant of peak values */
+#define NEX_DCTUNE_PEAKDECAY     1024
+/** DC tuner, max send offset change per cycle in ns */
+#define NEX_DCTUNE_MAXSTEP       ((int32)100)
+
+/** bus shift, EtherCAT epoch 2000-01-01 in ns since 1970-01-01 */
+#define NEX_DCBUSSHIFT_EPOCH      ((int64)946684800 * 1000000000)
+/** bus shift, resolution of host timestamps in ns */
+#define NEX_DCBUSSHIFT_RESOLUTION 1000
+/** bus shift, gain divider of offset correction */
+#define NEX_DCBUSSHIFT_GAIN       8
+/** bus shift, filter constant of drift and round trip */
+#define NEX_DCBUSSHIFT_FILTER     64
+/** bus shift, minimal interval in ns between samples for drift update */
+#define NEX_DCBUSSHIFT_MINDT      ((int64)100000)
+/** bus shift, offset in ns above which DC clocks are stepped instead of steered */
+#define NEX_DCBUSSHIFT_MAXADJUST  ((int64)100000)
+
 /**
  * Set DC of slave to fire sync0 at CyclTime interval with CyclShift offset.
  *
@@ -391,7 +418,7 @@ boolean nexx_configdc(nexx_contextt *context)
             if (dt1 > dt3) dt1 = -dt1;
             /* current slave is not the first child of parent */
             /* previous child's delays need to be added */
-            if ((child - parent) > 1)
+            if (context->slavelist[parent].child != child)
             {
                dt2 = nexx_porttime(context, parent,
                         nexx_prevport(context, parent, context->slavelist[i].parentport)) -
@@ -430,6 +457,464 @@ boolean nexx_configdc(nexx_contextt *context)
    return context->slavelist[0].hasdc;
 }
 
+/* wrap a time difference into -cycle/2 .. cycle/2 */
+static int32 nexx_dcwrap(int64 t, int32 cycle)
+{
+   t %= cycle;
+   if (t >= (cycle / 2))
+   {
+      t -= cycle;
+   }
+   else if (t < -(cycle / 2))
+   {
+      t += cycle;
+   }
+   return (int32)t;
+}
+
+/* wrap a phase into 0 .. cycle */
+static int32 nexx_dcphase(int64 t, int32 cycle)
+{
+   t %= cycle;
+   if (t < 0)
+   {
+      t += cycle;
+   }
+   return (int32)t;
+}
+
+/* first slave of group with active SYNC0, 0 if none */
+static uint16 nexx_dctune_syncslave(nexx_contextt *context, uint8 group)
+{
+   uint16 slave;
+
+   slave = context->grouplist[group].DCnext;
+   if (!context->grouplist[group].hasdc)
+   {
+      slave = context->slavelist[0].DCnext;
+   }
+   while (slave > 0)
+   {
+      if (context->slavelist[slave].DCactive &&
+          (!group || (context->slavelist[slave].group == group)))
+      {
+         return slave;
+      }
+      slave = context->slavelist[slave].DCnext;
+   }
+   return 0;
+}
+
+/* wire position in bytes of a logical address in the process data frames of a group */
+static int32 nexx_dctune_wirepos(nex_groupt *grp, uint32 adr)
+{
+   uint32 start;
+   int32 pos;
+   int seg;
+
+   start = grp->logstartaddr;
+   pos = (int32)(ETH_HEADERSIZE + NEX_HEADERSIZE);
+   for (seg = 0; (seg < grp->nsegments - 1) && (adr >= start + grp->IOsegment[seg]); seg++)
+   {
+      start += grp->IOsegment[seg];
+      pos += (int32)grp->IOsegment[seg] + NEX_DCTUNE_FRAMEOVERHEAD +
+         (int32)(ETH_HEADERSIZE + NEX_HEADERSIZE + NEX_WKCSIZE);
+      /* DC datagram after the data of the first segment */
+      if (!seg)
+      {
+         pos += NEX_FIRSTDCDATAGRAM;
+      }
+   }
+   return pos + (int32)(adr - start);
+}
+
+/**
+ * Initialise DC timing tuner for a group. Must be called after nexx_configdc
+ * and process data mapping.
+ *
+ * The tuner places the process data frame and SYNC0 in the cycle so that the
+ * distance between the last access of a DC slave to its process data and
+ * SYNC0, and between SYNC0 and the first access in the next frame, are both
+ * as large as possible. Every DC slave of the group is passed by the frame at
+ * its own propagation delay and finds its data at its own place in the
+ * frames, the earliest and latest of these accesses bound the busy window.
+ *
+ * @param[in]  context        = context struct
+ * @param[out] tune           = tuner state
+ * @param[in]  group          = group of slaves to tune
+ * @param[in]  CyclTime       = DC cycle time in ns
+ * @param[in]  SendOffset     = initial target DC phase of the frame in ns
+ */
+void nexx_dctune_init(nexx_contextt *context, nex_dctunet *tune, uint8 group, uint32 CyclTime, int32 SendOffset)
+{
+   nex_groupt *grp = &context->grouplist[group];
+   nex_slavet *sl;
+   uint16 slave;
+   uint32 adr;
+   int32 bytes, first, last;
+   int f;
+   boolean found = FALSE;
+
+   memset(tune, 0, sizeof(*tune));
+   tune->group = group;
+   tune->cycletime = (int32)CyclTime;
+   tune->guard = NEX_DCTUNE_GUARD;
+   for (slave = 1; slave <= *(context->slavecount); slave++)
+   {
+      sl = &context->slavelist[slave];
+      if (!sl->hasdc || (group && (sl->group != group)))
+      {
+         continue;
+      }
+      if (sl->pdelay > tune->maxpdelay)
+      {
+         tune->maxpdelay = sl->pdelay;
+      }
+      /* window in which the frames pass the process data of this slave */
+      for (f = 0; f < NEX_MAXFMMU; f++)
+      {
+         if (!sl->FMMU[f].LogLength)
+         {
+            continue;
+         }
+         adr = etohl(sl->FMMU[f].LogStart);
+         first = sl->pdelay + nexx_dctune_wirepos(grp, adr) * NEX_DCTUNE_BYTETIME;
+         last = sl->pdelay + (nexx_dctune_wirepos(grp, adr + etohs(sl->FMMU[f].LogLength) - 1) + 1) *
+            NEX_DCTUNE_BYTETIME;
+         if (!found || (first < tune->early))
+         {
+            tune->early = first;
+         }
+         if (!found || (last > tune->late))
+         {
+            tune->late = last;
+         }
+         found = TRUE;
+      }
+   }
+   /* wire time of all segments including ethernet, datagram and DC overhead */
+   bytes = (int32)(grp->Obytes + grp->Ibytes) + NEX_FIRSTDCDATAGRAM;
+   bytes += grp->nsegments *
+      (NEX_DCTUNE_FRAMEOVERHEAD + (int32)(ETH_HEADERSIZE + NEX_HEADERSIZE + NEX_WKCSIZE));
+   tune->frametime = bytes * NEX_DCTUNE_BYTETIME;
+   if (!found)
+   {
+      /* no DC slave with process data, the whole frames at the last slave */
+      tune->early = 0;
+      tune->late = tune->maxpdelay + tune->frametime;
+   }
+   tune->sendoffset = nexx_dcphase(SendOffset, tune->cycletime);
+   tune->sync0shift = nexx_dcphase((int64)tune->sendoffset +
+      ((tune->early + tune->late + tune->cycletime) / 2), tune->cycletime);
+   tune->margin = ((tune->cycletime - (tune->late - tune->early)) / 2) - tune->guard;
+}
+
+/**
+ * Update DC timing tuner with the timing of the last process data cycle. Call
+ * after every successful receive of the process data. Until SYNC0 is active
+ * the tuner adapts sync0shift to the measured frame timing. Once SYNC0 runs
+ * the shift is fixed and sendoffset is moved instead, limited to
+ * NEX_DCTUNE_MAXSTEP per cycle.
+ *
+ * @param[in]  context        = context struct
+ * @param[in,out] tune        = tuner state
+ * @param[in]  rtt            = measured frame round trip time in ns, 0 if unknown
+ * @return target DC phase of the frame at the reference slave in ns
+ */
+int32 nexx_dctune_update(nexx_contextt *context, nex_dctunet *tune, int32 rtt)
+{
+   int32 err, adev, delay, early, late, shift, target, step, slack;
+   uint16 syncslave;
+
+   if (tune->cycletime <= 0)
+   {
+      return tune->sendoffset;
+   }
+   /* deviation of frame arrival at reference slave from the target phase */
+   err = nexx_dcwrap(context->grouplist[tune->group].DCtime - tune->sendoffset, tune->cycletime);
+   if (!tune->samples)
+   {
+      tune->phasemean = err;
+      tune->rtt = rtt;
+   }
+   tune->samples++;
+   tune->phasemean += (err - tune->phasemean) / NEX_DCTUNE_FILTER;
+   adev = err - tune->phasemean;
+   if (adev < 0)
+   {
+      adev = -adev;
+   }
+   tune->phasedev += (adev - tune->phasedev) / NEX_DCTUNE_FILTER;
+   tune->phasepeak -= tune->phasepeak / NEX_DCTUNE_PEAKDECAY;
+   if (adev > tune->phasepeak)
+   {
+      tune->phasepeak = adev;
+   }
+   if (rtt > 0)
+   {
+      tune->rtt += (rtt - tune->rtt) / NEX_DCTUNE_FILTER;
+      tune->rttpeak -= tune->rttpeak / NEX_DCTUNE_PEAKDECAY;
+      if (rtt > tune->rttpeak)
+      {
+         tune->rttpeak = rtt;
+      }
+   }
+
+   /* busy window of the DC slaves, without DC delays the last slave is
+      passed about half a round trip after the first */
+   early = tune->early;
+   late = tune->late;
+   if (!tune->maxpdelay && (tune->rtt > tune->frametime))
+   {
+      late += (tune->rtt - tune->frametime) / 2;
+   }
+   delay = late - early;
+
+   syncslave = nexx_dctune_syncslave(context, tune->group);
+   shift = tune->sync0shift;
+   if (syncslave)
+   {
+      shift = context->slavelist[syncslave].DCshift;
+   }
+   /* frame still passing the slaves at SYNC0, outputs late or inputs too early */
+   slack = nexx_dcphase((int64)shift - tune->sendoffset - err - early + tune->guard, tune->cycletime);
+   if (slack < (delay + (2 * tune->guard)))
+   {
+      tune->lateframes++;
+   }
+
+   /* optimal spot of SYNC0 is halfway between the last access and the first one of the next frame */
+   if (syncslave)
+   {
+      target = nexx_dcphase((int64)shift - tune->phasemean - ((early + late + tune->cycletime) / 2),
+         tune->cycletime);
+      step = nexx_dcwrap((int64)target - tune->sendoffset, tune->cycletime);
+      if (step > NEX_DCTUNE_MAXSTEP)
+      {
+         step = NEX_DCTUNE_MAXSTEP;
+      }
+      else if (step < -NEX_DCTUNE_MAXSTEP)
+      {
+         step = -NEX_DCTUNE_MAXSTEP;
+      }
+      tune->sendoffset = nexx_dcphase((int64)tune->sendoffset + step, tune->cycletime);
+   }
+   else
+   {
+      tune->sync0shift = nexx_dcphase((int64)tune->sendoffset + tune->phasemean +
+         ((early + late + tune->cycletime) / 2), tune->cycletime);
+   }
+   /* jitter bound is largest of recent peak and four times the mean deviation */
+   adev = 4 * tune->phasedev;
+   if (tune->phasepeak > adev)
+   {
+      adev = tune->phasepeak;
+   }
+   tune->margin = ((tune->cycletime - delay) / 2) - adev - tune->guard;
+
+   return tune->sendoffset;
+}
+
+/* default host clock of bus shift, osal time in ns since 1970 */
+static int64 nexx_dcbusshift_osalclock(void)
+{
+   nex_timet t;
+
+   t = osal_current_time();
+   return ((int64)t.sec * 1000000000) + ((int64)t.usec * 1000);
+}
+
+/**
+ * Initialise bus shift mode, DC system time follows the host clock. Must be
+ * called after nexx_configdc. The steering writes are sent in the first
+ * process data frame of the group of the reference slave. The host clock
+ * defaults to the osal time, set bs->hostclock after init when the samples
+ * passed to nexx_dcbusshift_update are taken from another clock.
+ *
+ * @param[in]  context        = context struct
+ * @param[out] bs             = bus shift state
+ * @param[in]  interval       = number of cycles between steering writes to reference clock
+ */
+void nexx_dcbusshift_init(nexx_contextt *context, nex_dcbusshiftt *bs, uint16 interval)
+{
+   memset(bs, 0, sizeof(*bs));
+   bs->refslave = context->slavelist[0].DCnext;
+   bs->interval = interval ? interval : 1;
+   bs->hostclock = nexx_dcbusshift_osalclock;
+   if (bs->refslave)
+   {
+      context->grouplist[context->slavelist[bs->refslave].group].busshift = bs;
+   }
+}
+
+/**
+ * Step the system time offset of all DC slaves by the offset that
+ * nexx_dcbusshift_update found too large to steer. Blocking, call it outside
+ * of the process data cycle when bs->step is set.
+ *
+ * @param[in]  context        = context struct
+ * @param[in,out] bs          = bus shift state
+ * @return workcounter of the offset writes, 0 if no step was pending
+ */
+int nexx_dcbusshift_step(nexx_contextt *context, nex_dcbusshiftt *bs)
+{
+   uint16 slave, slaveh;
+   int64 hrt, delta;
+   int wkc = 0;
+
+   delta = bs->step;
+   if (!delta)
+   {
+      return 0;
+   }
+   slave = context->slavelist[0].DCnext;
+   while (slave > 0)
+   {
+      slaveh = context->slavelist[slave].configadr;
+      hrt = 0;
+      if (nexx_FPRD(context->port, slaveh, ECT_REG_DCSYSOFFSET, sizeof(hrt), &hrt, NEX_TIMEOUTRET) > 0)
+      {
+         hrt = htoell(etohll(hrt) + delta);
+         wkc += nexx_FPWR(context->port, slaveh, ECT_REG_DCSYSOFFSET, sizeof(hrt), &hrt, NEX_TIMEOUTRET);
+      }
+      slave = context->slavelist[slave].DCnext;
+   }
+   if (wkc > 0)
+   {
+      bs->lastdc += delta;
+      bs->offset -= delta;
+      bs->steps++;
+      bs->step = 0;
+   }
+   return wkc;
+}
+
+/**
+ * Update bus shift mode with the last process data cycle and steer the
+ * reference clock towards the host clock. Call after every successful receive
+ * of process data that contained the DC datagram. Host time can be taken from
+ * any clock, f.e. CLOCK_TAI or a PTP clock, as long as both samples and
+ * bs->hostclock use the same one. No frames are sent here.
+ *
+ * The reference clock time carried by the FRMW datagram is compared with the
+ * midpoint of the host send and receive time. Offset and drift are filtered.
+ * Small offsets are corrected by a steering write to the system time register
+ * of the reference slave so its control loop speeds up or slows down. The
+ * write is queued for the next process data frame, which stamps it with the
+ * host clock at the send. Large offsets set bs->step, nexx_dcbusshift_step
+ * then steps the system time offset of all DC slaves.
+ *
+ * @param[in]  context        = context struct
+ * @param[in,out] bs          = bus shift state
+ * @param[in]  hostsend       = host time just before sending the frame in ns since 1970
+ * @param[in]  hostrecv       = host time just after receiving the frame in ns since 1970
+ * @return 1 if a steering write was queued, 0 otherwise
+ */
+int nexx_dcbusshift_update(nexx_contextt *context, nex_dcbusshiftt *bs, int64 hostsend, int64 hostrecv)
+{
+   int64 dctime, host, raw, predicted, residual, dt, t;
+   int32 rtt;
+
+   if (!bs->refslave)
+   {
+      return 0;
+   }
+   dctime = context->grouplist[context->slavelist[bs->refslave].group].DCtime;
+   rtt = (int32)(hostrecv - hostsend);
+   /* host time at the moment the frame passed the reference clock, in DC epoch */
+   host = hostsend + (rtt / 2) - NEX_DCBUSSHIFT_EPOCH;
+   raw = host - dctime;
+   if (!bs->samples || (bs->minrtt <= 0) || (rtt < bs->minrtt))
+   {
+      bs->minrtt = rtt;
+   }
+   else
+   {
+      bs->minrtt += (bs->minrtt / NEX_DCBUSSHIFT_FILTER) + 1;
+   }
+   if (!bs->samples)
+   {
+      bs->offset = raw;
+      bs->drift = 0;
+      bs->bound = (rtt / 2) + NEX_DCBUSSHIFT_RESOLUTION;
+   }
+   else
+   {
+      /* samples with long round trip have a large error, skip them */
+      if (rtt > ((2 * bs->minrtt) + NEX_DCBUSSHIFT_RESOLUTION))
+      {
+         bs->rejected++;
+         return 0;
+      }
+      dt = dctime - bs->lastdc;
+      if (dt <= 0)
+      {
+         return 0;
+      }
+      bs->period = dt;
+      predicted = bs->offset + ((int64)bs->drift * dt) / 1000000000;
+      residual = raw - predicted;
+      bs->offset = predicted + (residual / NEX_DCBUSSHIFT_GAIN);
+      /* drift in ns per s, only on longer intervals to keep rounding low */
+      if (dt >= NEX_DCBUSSHIFT_MINDT)
+      {
+         bs->drift += (int32)(((residual * 1000000000) / dt) / NEX_DCBUSSHIFT_FILTER);
+      }
+      t = (residual < 0) ? -residual : residual;
+      bs->bound = (bs->minrtt / 2) + (int32)(t / 2) + NEX_DCBUSSHIFT_RESOLUTION;
+   }
+   bs->lastdc = dctime;
+   bs->samples++;
+
+   t = (bs->offset < 0) ? -bs->offset : bs->offset;
+   if (t > NEX_DCBUSSHIFT_MAXADJUST)
+   {
+      /* too far off for the slave control loop, step all DC clocks */
+      bs->step = bs->offset;
+      bs->writepending = FALSE;
+   }
+   else if (++bs->count >= bs->interval)
+   {
+      bs->count = 0;
+      bs->step = 0;
+      /* host time at arrival of the write, ahead by the drift expected until the
+         next write, reference slave adjusts its clock speed to the difference */
+      bs->writeahead = (bs->minrtt / 2) - NEX_DCBUSSHIFT_EPOCH +
+         ((int64)bs->drift * bs->period * bs->interval) / 1000000000;
+      bs->writepending = TRUE;
+      return 1;
+   }
+
+   return 0;
+}
+
+/**
+ * Value of a steering write sent now. Called by the process data send when
+ * it adds the write to a frame and when that frame is sent again.
+ *
+ * @param[in]  bs             = bus shift state
+ * @return host time of arrival at the reference slave in DC epoch, little endian
+ */
+int64 nexx_dcbusshift_writetime(nex_dcbusshiftt *bs)
+{
+   return htoell(bs->hostclock() + bs->writeahead);
+}
+
+/**
+ * Convert DC system time to host time with the current bus shift estimate.
+ *
+ * @param[in]  bs             = bus shift state
+ * @param[in]  dctime         = DC system time in ns
+ * @return host time in ns since 1970, error is within bs->bound
+ */
+int64 nexx_dcbusshift_tohost(nex_dcbusshiftt *bs, int64 dctime)
+{
+   int64 offset;
+
+   offset = bs->offset + ((int64)bs->drift * (dctime - bs->lastdc)) / 1000000000;
+   return dctime + offset + NEX_DCBUSSHIFT_EPOCH;
+}
+
 #ifdef NEX_VER1
 void nex_dcsync0(uint16 slave, boolean act, uint32 CyclTime, int32 CyclShift)
 {
@@ -445,4 +930,29 @@ boolean nex_configdc(void)
 {
    return nexx_configdc(&nexx_context);
 }
+
+void nex_dctune_init(nex_dctunet *tune, uint8 group, uint32 CyclTime, int32 SendOffset)
+{
+   nexx_dctune_init(&nexx_context, tune, group, CyclTime, SendOffset);
+}
+
+int32 nex_dctune_update(nex_dctunet *tune, int32 rtt)
+{
+   return nexx_dctune_update(&nexx_context, tune, rtt);
+}
+
+void nex_dcbusshift_init(nex_dcbusshiftt *bs, uint16 interval)
+{
+   nexx_dcbusshift_init(&nexx_context, bs, interval);
+}
+
+int nex_dcbusshift_update(nex_dcbusshiftt *bs, int64 hostsend, int64 hostrecv)
+{
+   return nexx_dcbusshift_update(&nexx_context, bs, hostsend, hostrecv);
+}
+
+int nex_dcbusshift_step(nex_dcbusshiftt *bs)
+{
+   return nexx_dcbusshift_step(&nexx_context, bs);
+}
 #endif
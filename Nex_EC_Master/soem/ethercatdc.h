@@ -16,15 +16,106 @@ extern "C"
 {
 #endif
 
+/** DC timing tuner state, measured frame timing and derived offsets */
+typedef struct
+{
+   /** group the tuner measures */
+   uint8          group;
+   /** DC cycle time in ns */
+   int32          cycletime;
+   /** largest propagation delay of the DC slaves in the group in ns */
+   int32          maxpdelay;
+   /** first access of a DC slave of the group to its process data after the
+       frame start at the reference slave in ns */
+   int32          early;
+   /** last access of a DC slave of the group to its process data in ns */
+   int32          late;
+   /** time the process data frames occupy the wire in ns */
+   int32          frametime;
+   /** time a slave needs between frame end and SYNC0 in ns */
+   int32          guard;
+   /** filtered deviation of frame arrival at reference slave from sendoffset in ns */
+   int32          phasemean;
+   /** filtered absolute deviation of frame arrival in ns */
+   int32          phasedev;
+   /** decaying peak of frame arrival deviation in ns */
+   int32          phasepeak;
+   /** filtered frame round trip time in ns */
+   int32          rtt;
+   /** decaying peak of frame round trip time in ns */
+   int32          rttpeak;
+   /** number of processed samples */
+   uint32         samples;
+   /** number of frames that were still passing the slaves at SYNC0 */
+   uint32         lateframes;
+   /** target DC phase of the frame at the reference slave in ns */
+   int32          sendoffset;
+   /** SYNC0 shift in ns to program with nexx_dcsync0 */
+   int32          sync0shift;
+   /** expected margin between frame and SYNC0 on both sides in ns */
+   int32          margin;
+} nex_dctunet;
+
+/** DC bus shift state, DC system time follows the host clock */
+typedef struct nex_dcbusshift
+{
+   /** reference clock slave */
+   uint16         refslave;
+   /** host clock in ns since 1970, must be the clock of hostsend and hostrecv */
+   int64          (*hostclock)(void);
+   /** time in ns added to the host clock at the send of a steering write */
+   int64          writeahead;
+   /** steering write waits for the next process data frame */
+   boolean        writepending;
+   /** workcounter of the last steering write */
+   uint16         written;
+   /** offset in ns to step the DC clocks by, see nexx_dcbusshift_step */
+   int64          step;
+   /** number of cycles between steering writes */
+   uint16         interval;
+   /** cycles since last steering write */
+   uint16         count;
+   /** filtered host time minus DC time in ns */
+   int64          offset;
+   /** error bound of offset in ns */
+   int32          bound;
+   /** estimated drift of host time against DC time in ns per s */
+   int32          drift;
+   /** shortest recent frame round trip in ns */
+   int32          minrtt;
+   /** DC time of last accepted sample */
+   int64          lastdc;
+   /** DC time between last two accepted samples in ns */
+   int64          period;
+   /** number of accepted samples */
+   uint32         samples;
+   /** number of samples skipped for long round trip */
+   uint32         rejected;
+   /** number of system time offset steps */
+   uint32         steps;
+} nex_dcbusshiftt;
+
 #ifdef NEX_VER1
 boolean nex_configdc();
 void nex_dcsync0(uint16 slave, boolean act, uint32 CyclTime, int32 CyclShift);
 void nex_dcsync01(uint16 slave, boolean act, uint32 CyclTime0, uint32 CyclTime1, int32 CyclShift);
+void nex_dctune_init(nex_dctunet *tune, uint8 group, uint32 CyclTime, int32 SendOffset);
+int32 nex_dctune_update(nex_dctunet *tune, int32 rtt);
+void nex_dcbusshift_init(nex_dcbusshiftt *bs, uint16 interval);
+int nex_dcbusshift_update(nex_dcbusshiftt *bs, int64 hostsend, int64 hostrecv);
+int nex_dcbusshift_step(nex_dcbusshiftt *bs);
 #endif
 
 boolean nexx_configdc(nexx_contextt *context);
 void nexx_dcsync0(nexx_contextt *context, uint16 slave, boolean act, uint32 CyclTime, int32 CyclShift);
 void nexx_dcsync01(nexx_contextt *context, uint16 slave, boolean act, uint32 CyclTime0, uint32 CyclTime1, int32 CyclShift);
+void nexx_dctune_init(nexx_contextt *context, nex_dctunet *tune, uint8 group, uint32 CyclTime, int32 SendOffset);
+int32 nexx_dctune_update(nexx_contextt *context, nex_dctunet *tune, int32 rtt);
+void nexx_dcbusshift_init(nexx_contextt *context, nex_dcbusshiftt *bs, uint16 interval);
+int nexx_dcbusshift_update(nexx_contextt *context, nex_dcbusshiftt *bs, int64 hostsend, int64 hostrecv);
+int nexx_dcbusshift_step(nexx_contextt *context, nex_dcbusshiftt *bs);
+int64 nexx_dcbusshift_writetime(nex_dcbusshiftt *bs);
+int64 nexx_dcbusshift_tohost(nex_dcbusshiftt *bs, int64 dctime);
 
 #ifdef __cplusplus
 }
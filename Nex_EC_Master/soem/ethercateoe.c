@@ -0,0 +1,715 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Ethernet over EtherCAT (EoE) module.
+ *
+ * Ethernet frames are split in fragments that fit in the slave mailbox. All
+ * fragments except the last carry a multiple of 32 bytes. The first fragment
+ * holds the complete frame size, the following ones their offset, both in
+ * 32 byte blocks.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "osal.h"
+#include "oshw.h"
+#include "ethercattype.h"
+#include "ethercatbase.h"
+#include "ethercatmain.h"
+#include "ethercateoe.h"
+
+/** size of EoE header following the mailbox header */
+#define NEX_EOEHSIZE            4
+/** max data in one EoE mailbox */
+#define NEX_MAXEOEDATA          (NEX_MAXMBX - (sizeof(nex_mbxheadert) + NEX_EOEHSIZE))
+
+/** frameinfo1 fields */
+#define NEX_EOE_TYPE_SET(x)     ((uint16)((x) & 0x0f))
+#define NEX_EOE_TYPE_GET(x)     ((x) & 0x0f)
+#define NEX_EOE_PORT_SET(x)     ((uint16)(((x) & 0x0f) << 4))
+#define NEX_EOE_PORT_GET(x)     (((x) >> 4) & 0x0f)
+#define NEX_EOE_LASTFRAGMENT    0x0100
+/** frameinfo2 fields */
+#define NEX_EOE_FRAGNO_SET(x)   ((uint16)((x) & 0x3f))
+#define NEX_EOE_FRAGNO_GET(x)   ((x) & 0x3f)
+#define NEX_EOE_OFFSET_SET(x)   ((uint16)(((x) & 0x3f) << 6))
+#define NEX_EOE_OFFSET_GET(x)   (((x) >> 6) & 0x3f)
+#define NEX_EOE_FRAMENO_SET(x)  ((uint16)(((x) & 0x0f) << 12))
+#define NEX_EOE_FRAMENO_GET(x)  (((x) >> 12) & 0x0f)
+
+/** EoE result codes */
+#define NEX_EOE_RESULT_SUCCESS  0x0000
+
+/** EoE structure.
+ * Used for fragment data, IP parameter requests and responses.
+ */
+PACKED_BEGIN
+typedef struct PACKED
+{
+   nex_mbxheadert MbxHeader;
+   uint16         frameinfo1;
+   union
+   {
+      uint16      frameinfo2;
+      uint16      result;
+   };
+   uint8          data[NEX_MAXEOEDATA];
+} nex_EOEt;
+PACKED_END
+
+/* max fragment data for slave, multiple of 32 bytes */
+static int nexx_EOEmaxdata(nexx_contextt *context, uint16 slave)
+{
+   int maxdata;
+
+   maxdata = context->slavelist[slave].mbx_l - (int)(sizeof(nex_mbxheadert) + NEX_EOEHSIZE);
+   if (maxdata > (int)NEX_MAXEOEDATA)
+   {
+      maxdata = NEX_MAXEOEDATA;
+   }
+   return maxdata & ~0x1f;
+}
+
+/* fill EoE mailbox header */
+static void nexx_EOEheader(nexx_contextt *context, uint16 slave, nex_EOEt *EOEp, uint16 length)
+{
+   uint8 cnt;
+
+   EOEp->MbxHeader.length = htoes(NEX_EOEHSIZE + length);
+   EOEp->MbxHeader.address = htoes(0x0000);
+   EOEp->MbxHeader.priority = 0x00;
+   /* get new mailbox count value */
+   cnt = nex_nextmbxcnt(context->slavelist[slave].mbx_cnt);
+   context->slavelist[slave].mbx_cnt = cnt;
+   EOEp->MbxHeader.mbxtype = ECT_MBXT_EOE + (cnt << 4); /* EoE */
+}
+
+/* build next fragment of tx frame in mailbox, return data size of fragment */
+static int nexx_EOEputfragment(nexx_contextt *context, uint16 slave, uint8 port,
+   nex_EOEfragt *tx, nex_EOEt *EOEp)
+{
+   int maxdata, txlen;
+   uint16 info1, info2;
+
+   maxdata = nexx_EOEmaxdata(context, slave);
+   txlen = tx->size - tx->offset;
+   info1 = NEX_EOE_TYPE_SET(ECT_EOE_FRAGDATA) | NEX_EOE_PORT_SET(port);
+   if (txlen > maxdata)
+   {
+      txlen = maxdata;
+   }
+   else
+   {
+      info1 |= NEX_EOE_LASTFRAGMENT;
+   }
+   info2 = NEX_EOE_FRAGNO_SET(tx->fragno) | NEX_EOE_FRAMENO_SET(tx->frameno);
+   if (!tx->fragno)
+   {
+      /* first fragment holds complete size in 32 byte blocks */
+      info2 |= NEX_EOE_OFFSET_SET((tx->size + 31) >> 5);
+   }
+   else
+   {
+      info2 |= NEX_EOE_OFFSET_SET(tx->offset >> 5);
+   }
+   nexx_EOEheader(context, slave, EOEp, (uint16)txlen);
+   EOEp->frameinfo1 = htoes(info1);
+   EOEp->frameinfo2 = htoes(info2);
+   memcpy(&EOEp->data[0], tx->buf + tx->offset, txlen);
+
+   return txlen;
+}
+
+/* add received fragment to rx frame, return 1 if frame complete, 0 if more
+   fragments follow, -1 on sequence error (frame dropped) */
+static int nexx_EOEgetfragment(nex_EOEt *EOEp, nex_EOEfragt *rx)
+{
+   uint16 info1, info2;
+   int datalen, offset;
+
+   info1 = etohs(EOEp->frameinfo1);
+   info2 = etohs(EOEp->frameinfo2);
+   datalen = etohs(EOEp->MbxHeader.length) - NEX_EOEHSIZE;
+   if (datalen < 0)
+   {
+      rx->size = 0;
+      return -1;
+   }
+   if (!NEX_EOE_FRAGNO_GET(info2))
+   {
+      /* first fragment, start new frame */
+      rx->size = NEX_EOE_OFFSET_GET(info2) << 5;
+      rx->offset = 0;
+      rx->fragno = 0;
+      rx->frameno = (uint8)NEX_EOE_FRAMENO_GET(info2);
+      rx->time = osal_current_time();
+   }
+   else
+   {
+      offset = NEX_EOE_OFFSET_GET(info2) << 5;
+      if (!rx->size ||
+          (NEX_EOE_FRAGNO_GET(info2) != rx->fragno) ||
+          (NEX_EOE_FRAMENO_GET(info2) != rx->frameno) ||
+          (offset != rx->offset))
+      {
+         rx->size = 0;
+         return -1;
+      }
+   }
+   if (((rx->offset + datalen) > rx->bufsize) || ((rx->offset + datalen) > rx->size))
+   {
+      rx->size = 0;
+      return -1;
+   }
+   memcpy(rx->buf + rx->offset, &EOEp->data[0], datalen);
+   rx->offset += datalen;
+   rx->fragno++;
+   if (info1 & NEX_EOE_LASTFRAGMENT)
+   {
+      /* real frame size, first fragment gave it rounded up to 32 bytes */
+      rx->size = rx->offset;
+      return 1;
+   }
+
+   return 0;
+}
+
+/* elapsed time since t in us */
+static uint32 nexx_EOEelapsed(nex_timet *t)
+{
+   nex_timet now, diff;
+
+   now = osal_current_time();
+   osal_time_diff(t, &now, &diff);
+   return (diff.sec * 1000000) + diff.usec;
+}
+
+/** EoE set IP parameters, blocking.
+ *
+ * @param[in]  context        = context struct
+ * @param[in]  slave      = Slave number
+ * @param[in]  port       = EoE port number
+ * @param[in]  ipparam    = IP parameters, fields selected by ipparam->flags
+ * @param[in]  timeout    = Timeout in us, standard is NEX_TIMEOUTRXM
+ * @return Workcounter from last slave response or returned result code
+ */
+int nexx_EOEsetIp(nexx_contextt *context, uint16 slave, uint8 port, nex_EOEipt *ipparam, int timeout)
+{
+   nex_EOEt *EOEp, *aEOEp;
+   nex_mbxbuft MbxIn, MbxOut;
+   uint32 flags;
+   uint8 *d;
+   int wkc;
+
+   nex_clearmbx(&MbxIn);
+   /* Empty slave out mailbox if something is in. Timout set to 0 */
+   wkc = nexx_mbxreceive(context, slave, (nex_mbxbuft *)&MbxIn, 0);
+   nex_clearmbx(&MbxOut);
+   aEOEp = (nex_EOEt *)&MbxIn;
+   EOEp = (nex_EOEt *)&MbxOut;
+   flags = ipparam->flags;
+   d = &EOEp->data[0];
+   /* flags are followed by all fields, including the ones not selected */
+   flags = htoel(flags);
+   memcpy(d, &flags, sizeof(flags));
+   d += sizeof(flags);
+   memcpy(d, ipparam->mac, sizeof(ipparam->mac));
+   d += sizeof(ipparam->mac);
+   memcpy(d, ipparam->ip, sizeof(ipparam->ip));
+   d += sizeof(ipparam->ip);
+   memcpy(d, ipparam->subnet, sizeof(ipparam->subnet));
+   d += sizeof(ipparam->subnet);
+   memcpy(d, ipparam->gateway, sizeof(ipparam->gateway));
+   d += sizeof(ipparam->gateway);
+   memcpy(d, ipparam->dnsip, sizeof(ipparam->dnsip));
+   d += sizeof(ipparam->dnsip);
+   memcpy(d, ipparam->dnsname, sizeof(ipparam->dnsname));
+   d += sizeof(ipparam->dnsname);
+   nexx_EOEheader(context, slave, EOEp, (uint16)(d - &EOEp->data[0]));
+   EOEp->frameinfo1 = htoes(NEX_EOE_TYPE_SET(ECT_EOE_INITREQ) | NEX_EOE_PORT_SET(port) |
+      NEX_EOE_LASTFRAGMENT);
+   EOEp->frameinfo2 = 0;
+   /* send EoE request to slave */
+   wkc = nexx_mbxsend(context, slave, (nex_mbxbuft *)&MbxOut, NEX_TIMEOUTTXM);
+   if (wkc > 0) /* succeeded to place mailbox in slave ? */
+   {
+      /* clean mailboxbuffer */
+      nex_clearmbx(&MbxIn);
+      /* read slave response */
+      wkc = nexx_mbxreceive(context, slave, (nex_mbxbuft *)&MbxIn, timeout);
+      if (wkc > 0) /* succeeded to read slave response ? */
+      {
+         /* slave response should be EoE init response */
+         if (((aEOEp->MbxHeader.mbxtype & 0x0f) == ECT_MBXT_EOE) &&
+             (NEX_EOE_TYPE_GET(etohs(aEOEp->frameinfo1)) == ECT_EOE_INITRESP))
+         {
+            if (etohs(aEOEp->result) != NEX_EOE_RESULT_SUCCESS)
+            {
+               wkc = -NEX_ERR_TYPE_EOE_ERROR;
+            }
+         }
+         else
+         {
+            /* unexpected mailbox received */
+            wkc = -NEX_ERR_TYPE_PACKET_ERROR;
+         }
+      }
+   }
+
+   return wkc;
+}
+
+/** EoE get IP parameters, blocking.
+ *
+ * @param[in]  context        = context struct
+ * @param[in]  slave      = Slave number
+ * @param[in]  port       = EoE port number
+ * @param[out] ipparam    = IP parameters read from slave
+ * @param[in]  timeout    = Timeout in us, standard is NEX_TIMEOUTRXM
+ * @return Workcounter from last slave response or returned result code
+ */
+int nexx_EOEgetIp(nexx_contextt *context, uint16 slave, uint8 port, nex_EOEipt *ipparam, int timeout)
+{
+   nex_EOEt *EOEp, *aEOEp;
+   nex_mbxbuft MbxIn, MbxOut;
+   uint32 flags;
+   uint8 *d;
+   int wkc, datalen;
+
+   nex_clearmbx(&MbxIn);
+   /* Empty slave out mailbox if something is in. Timout set to 0 */
+   wkc = nexx_mbxreceive(context, slave, (nex_mbxbuft *)&MbxIn, 0);
+   nex_clearmbx(&MbxOut);
+   aEOEp = (nex_EOEt *)&MbxIn;
+   EOEp = (nex_EOEt *)&MbxOut;
+   nexx_EOEheader(context, slave, EOEp, 0);
+   EOEp->frameinfo1 = htoes(NEX_EOE_TYPE_SET(ECT_EOE_GETIPREQ) | NEX_EOE_PORT_SET(port) |
+      NEX_EOE_LASTFRAGMENT);
+   EOEp->frameinfo2 = 0;
+   /* send EoE request to slave */
+   wkc = nexx_mbxsend(context, slave, (nex_mbxbuft *)&MbxOut, NEX_TIMEOUTTXM);
+   if (wkc > 0) /* succeeded to place mailbox in slave ? */
+   {
+      /* clean mailboxbuffer */
+      nex_clearmbx(&MbxIn);
+      /* read slave response */
+      wkc = nexx_mbxreceive(context, slave, (nex_mbxbuft *)&MbxIn, timeout);
+      if (wkc > 0) /* succeeded to read slave response ? */
+      {
+         /* slave response should be EoE get IP response */
+         if (((aEOEp->MbxHeader.mbxtype & 0x0f) == ECT_MBXT_EOE) &&
+             (NEX_EOE_TYPE_GET(etohs(aEOEp->frameinfo1)) == ECT_EOE_GETIPRESP))
+         {
+            datalen = etohs(aEOEp->MbxHeader.length) - NEX_EOEHSIZE;
+            memset(ipparam, 0, sizeof(*ipparam));
+            if (datalen >= (int)sizeof(flags))
+            {
+               d = &aEOEp->data[0];
+               memcpy(&flags, d, sizeof(flags));
+               d += sizeof(flags);
+               ipparam->flags = etohl(flags);
+               if (datalen >= (int)(sizeof(flags) + 22))
+               {
+                  memcpy(ipparam->mac, d, sizeof(ipparam->mac));
+                  d += sizeof(ipparam->mac);
+                  memcpy(ipparam->ip, d, sizeof(ipparam->ip));
+                  d += sizeof(ipparam->ip);
+                  memcpy(ipparam->subnet, d, sizeof(ipparam->subnet));
+                  d += sizeof(ipparam->subnet);
+                  memcpy(ipparam->gateway, d, sizeof(ipparam->gateway));
+                  d += sizeof(ipparam->gateway);
+                  memcpy(ipparam->dnsip, d, sizeof(ipparam->dnsip));
+                  d += sizeof(ipparam->dnsip);
+               }
+               if (datalen >= (int)(sizeof(flags) + 22 + NEX_EOE_DNSNAME_LENGTH))
+               {
+                  memcpy(ipparam->dnsname, d, sizeof(ipparam->dnsname));
+               }
+            }
+         }
+         else
+         {
+            /* unexpected mailbox received */
+            wkc = -NEX_ERR_TYPE_PACKET_ERROR;
+         }
+      }
+   }
+
+   return wkc;
+}
+
+/** EoE send ethernet frame, blocking until all fragments are placed in the
+ * slave mailbox.
+ *
+ * @param[in]  context        = context struct
+ * @param[in]  slave      = Slave number
+ * @param[in]  port       = EoE port number
+ * @param[in]  psize      = Size in bytes of frame
+ * @param[in]  p          = Pointer to frame
+ * @param[in]  timeout    = Timeout per fragment in us, standard is NEX_TIMEOUTTXM
+ * @return Workcounter from last fragment
+ */
+int nexx_EOEsend(nexx_contextt *context, uint16 slave, uint8 port, int psize, void *p, int timeout)
+{
+   nex_EOEfragt tx;
+   nex_mbxbuft MbxOut;
+   int wkc, txlen;
+
+   if ((psize <= 0) || (psize > NEX_EOE_MAXFRAME) || !nexx_EOEmaxdata(context, slave))
+   {
+      return 0;
+   }
+   tx.buf = p;
+   tx.bufsize = psize;
+   tx.size = psize;
+   tx.offset = 0;
+   tx.fragno = 0;
+   /* frame number only has to differ between consecutive frames */
+   tx.frameno = nex_nextmbxcnt(context->slavelist[slave].mbx_cnt);
+   do
+   {
+      nex_clearmbx(&MbxOut);
+      txlen = nexx_EOEputfragment(context, slave, port, &tx, (nex_EOEt *)&MbxOut);
+      wkc = nexx_mbxsend(context, slave, (nex_mbxbuft *)&MbxOut, timeout);
+      tx.offset += txlen;
+      tx.fragno++;
+   } while ((wkc > 0) && (tx.offset < tx.size));
+
+   return wkc;
+}
+
+/** EoE receive ethernet frame, blocking until all fragments of one frame are
+ * received. Non EoE mailbox messages received in between are dropped.
+ *
+ * @param[in]  context        = context struct
+ * @param[in]  slave      = Slave number
+ * @param[in]  port       = EoE port number
+ * @param[in,out] psize   = Size in bytes of frame buffer, returns frame size
+ * @param[out] p          = Pointer to frame buffer
+ * @param[in]  timeout    = Timeout per fragment in us, standard is NEX_TIMEOUTRXM
+ * @return Workcounter from last fragment or error
+ */
+int nexx_EOErecv(nexx_contextt *context, uint16 slave, uint8 port, int *psize, void *p, int timeout)
+{
+   nex_EOEfragt rx;
+   nex_mbxbuft MbxIn;
+   nex_EOEt *aEOEp;
+   uint16 info1;
+   int wkc, rval;
+
+   memset(&rx, 0, sizeof(rx));
+   rx.buf = p;
+   rx.bufsize = *psize;
+   aEOEp = (nex_EOEt *)&MbxIn;
+   rval = 0;
+   do
+   {
+      nex_clearmbx(&MbxIn);
+      wkc = nexx_mbxreceive(context, slave, (nex_mbxbuft *)&MbxIn, timeout);
+      if (wkc > 0)
+      {
+         info1 = etohs(aEOEp->frameinfo1);
+         if (((aEOEp->MbxHeader.mbxtype & 0x0f) == ECT_MBXT_EOE) &&
+             (NEX_EOE_TYPE_GET(info1) == ECT_EOE_FRAGDATA) &&
+             (NEX_EOE_PORT_GET(info1) == port))
+         {
+            rval = nexx_EOEgetfragment(aEOEp, &rx);
+            if (rval < 0)
+            {
+               wkc = -NEX_ERR_TYPE_EOE_INVALID_RX_DATA;
+            }
+         }
+      }
+   } while ((wkc > 0) && !rval);
+   *psize = (rval > 0) ? rx.size : 0;
+
+   return wkc;
+}
+
+/** EoE engine init, create a slot for every slave that supports EoE.
+ *
+ * The engine is an alternative to the blocking EoE functions. Frames are
+ * queued per slot and nexx_EOEengine_poll moves at most one fragment per
+ * direction per slot each time a slot is serviced, without waiting for the
+ * slave. This keeps the time spent in each poll bounded, so it can run in
+ * the spare time of the cycle next to the process data. Only one thread may
+ * use the mailboxes of the EoE slaves while the engine is active.
+ *
+ * @param[in]  context        = context struct
+ * @param[out] engine     = engine state
+ * @param[in]  rxhook     = hook called for every received frame, may be NULL
+ * @return number of slots created
+ */
+int nexx_EOEengine_init(nexx_contextt *context, nex_EOEenginet *engine, void *rxhook)
+{
+   uint16 slave;
+   nex_EOEslott *s;
+
+   memset(engine, 0, sizeof(*engine));
+   engine->rxhook = rxhook;
+   for (slave = 1; (slave <= *(context->slavecount)) && (engine->nslot < NEX_EOE_MAXSLOT); slave++)
+   {
+      if ((context->slavelist[slave].mbx_proto & ECT_MBXPROT_EOE) &&
+          nexx_EOEmaxdata(context, slave))
+      {
+         s = &engine->slot[engine->nslot++];
+         s->slave = slave;
+         s->port = 0;
+         s->tx.buf = s->txbuf;
+         s->tx.bufsize = NEX_EOE_MAXFRAME;
+         s->rx.buf = s->rxbuf;
+         s->rx.bufsize = NEX_EOE_MAXFRAME;
+      }
+   }
+
+   return engine->nslot;
+}
+
+/** EoE engine queue frame for transmission, does not block.
+ *
+ * @param[in]  engine     = engine state
+ * @param[in]  slave      = Slave number
+ * @param[in]  port       = EoE port number
+ * @param[in]  psize      = Size in bytes of frame
+ * @param[in]  p          = Pointer to frame, copied into slot
+ * @return 1 if queued, 0 if previous frame of slot is still in transfer, -1 if no slot
+ */
+int nexx_EOEengine_queue(nex_EOEenginet *engine, uint16 slave, uint8 port, int psize, void *p)
+{
+   int i;
+   nex_EOEslott *s;
+
+   if ((psize <= 0) || (psize > NEX_EOE_MAXFRAME))
+   {
+      return -1;
+   }
+   for (i = 0; i < engine->nslot; i++)
+   {
+      s = &engine->slot[i];
+      if (s->slave == slave)
+      {
+         if (s->tx.size)
+         {
+            engine->stat.txbusy++;
+            return 0;
+         }
+         memcpy(s->txbuf, p, psize);
+         s->port = port;
+         s->tx.offset = 0;
+         s->tx.fragno = 0;
+         s->tx.frameno = (uint8)((s->tx.frameno + 1) & 0x0f);
+         s->tx.time = osal_current_time();
+         s->tx.size = psize;
+         return 1;
+      }
+   }
+
+   return -1;
+}
+
+/* take one fragment read from the out mailbox of a slot */
+static void nexx_EOEengine_rx(nex_EOEenginet *engine, nex_EOEslott *s, nex_mbxbuft *mbx)
+{
+   nex_EOEt *EOEp;
+   uint16 info1;
+   uint32 latency;
+   int rval;
+
+   EOEp = (nex_EOEt *)mbx;
+   info1 = etohs(EOEp->frameinfo1);
+   if (((EOEp->MbxHeader.mbxtype & 0x0f) != ECT_MBXT_EOE) ||
+       (NEX_EOE_TYPE_GET(info1) != ECT_EOE_FRAGDATA))
+   {
+      engine->stat.rxforeign++;
+      return;
+   }
+   engine->stat.rxfragments++;
+   rval = nexx_EOEgetfragment(EOEp, &s->rx);
+   if (rval > 0)
+   {
+      latency = nexx_EOEelapsed(&s->rx.time);
+      engine->stat.rxframes++;
+      engine->stat.rxbytes += s->rx.size;
+      engine->stat.rxlatency_sum += latency;
+      if (latency > engine->stat.rxlatency_max)
+      {
+         engine->stat.rxlatency_max = latency;
+      }
+      if (engine->rxhook)
+      {
+         engine->rxhook(s->slave, (uint8)NEX_EOE_PORT_GET(info1), s->rx.buf, s->rx.size);
+      }
+      s->rx.size = 0;
+   }
+   else if (rval < 0)
+   {
+      engine->stat.rxerrors++;
+   }
+}
+
+/* account one fragment written to the in mailbox of a slot */
+static void nexx_EOEengine_tx(nex_EOEenginet *engine, nex_EOEslott *s, int txlen)
+{
+   uint32 latency;
+
+   engine->stat.txfragments++;
+   s->tx.offset += txlen;
+   s->tx.fragno++;
+   if (s->tx.offset >= s->tx.size)
+   {
+      latency = nexx_EOEelapsed(&s->tx.time);
+      engine->stat.txframes++;
+      engine->stat.txbytes += s->tx.size;
+      engine->stat.txlatency_sum += latency;
+      if (latency > engine->stat.txlatency_max)
+      {
+         engine->stat.txlatency_max = latency;
+      }
+      s->tx.size = 0;
+   }
+}
+
+/* one batched round over n slots from engine->next, return number of fragments moved */
+static int nexx_EOEengine_round(nexx_contextt *context, nex_EOEenginet *engine, int n)
+{
+   uint16 slavelst[NEX_EOE_MAXSLOT];
+   nex_datagramt lst[NEX_EOE_MAXSLOT];
+   int txlen[NEX_EOE_MAXSLOT];
+   int slotlst[NEX_EOE_MAXSLOT];
+   nex_EOEslott *s;
+   int i, cnt, moved;
+
+   moved = 0;
+   for (i = 0; i < n; i++)
+   {
+      slotlst[i] = (engine->next + i) % engine->nslot;
+      slavelst[i] = engine->slot[slotlst[i]].slave;
+      lst[i].data = &engine->mbx[i];
+      nex_clearmbx(&engine->mbx[i]);
+   }
+   engine->next = (engine->next + n) % engine->nslot;
+   /* out mailboxes of all slots in as few frames as possible, empty ones give wkc 0 */
+   if (nexx_mbxpoll_multi(context, n, slavelst, lst, NEX_TIMEOUTRET))
+   {
+      for (i = 0; i < n; i++)
+      {
+         if (lst[i].wkc > 0)
+         {
+            nexx_EOEengine_rx(engine, &engine->slot[slotlst[i]], &engine->mbx[i]);
+            moved++;
+         }
+      }
+   }
+   /* next fragment of every slot with a frame to send, a full in mailbox ignores it */
+   cnt = 0;
+   for (i = 0; i < n; i++)
+   {
+      s = &engine->slot[slotlst[i]];
+      if (s->tx.size)
+      {
+         nex_clearmbx(&engine->mbx[cnt]);
+         txlen[cnt] = nexx_EOEputfragment(context, s->slave, s->port, &s->tx, (nex_EOEt *)&engine->mbx[cnt]);
+         slavelst[cnt] = s->slave;
+         slotlst[cnt] = slotlst[i];
+         lst[cnt].data = &engine->mbx[cnt];
+         cnt++;
+      }
+   }
+   if (cnt && nexx_mbxwrite_multi(context, cnt, slavelst, lst, NEX_TIMEOUTRET))
+   {
+      for (i = 0; i < cnt; i++)
+      {
+         if (lst[i].wkc > 0)
+         {
+            nexx_EOEengine_tx(engine, &engine->slot[slotlst[i]], txlen[i]);
+            moved++;
+         }
+      }
+   }
+
+   return moved;
+}
+
+/** EoE engine poll, move queued and received fragments of all slots.
+ *
+ * The slots are serviced in rounds. A round reads the out mailboxes of all
+ * its slots with one packed read and writes the next fragment of every slot
+ * with a pending frame with one packed write, so a round costs about two
+ * frames however many EoE slaves there are. When the fragment budget is
+ * smaller than the slots, a round takes as many slots as the budget allows
+ * and the next call continues with the slots after them. The poll ends when
+ * the budget time or the fragment budget is used, or when a round moved
+ * nothing.
+ *
+ * @param[in]  context        = context struct
+ * @param[in]  engine     = engine state
+ * @param[in]  budget     = max time in us to spend in this call
+ * @param[in]  maxfragments = max number of fragments to move in this call, a
+ *                          round moves up to one fragment per slot in each direction
+ * @return number of fragments moved
+ */
+int nexx_EOEengine_poll(nexx_contextt *context, nex_EOEenginet *engine, int budget, int maxfragments)
+{
+   osal_timert timer;
+   int moved, n, round;
+
+   if (!engine->nslot)
+   {
+      return 0;
+   }
+   osal_timer_start(&timer, budget);
+   moved = 0;
+   do
+   {
+      /* every slot may move a fragment in each direction */
+      n = (maxfragments - moved + 1) / 2;
+      if (n > engine->nslot)
+      {
+         n = engine->nslot;
+      }
+      if (n < 1)
+      {
+         n = 1;
+      }
+      round = nexx_EOEengine_round(context, engine, n);
+      moved += round;
+   } while (round && (moved < maxfragments) && (osal_timer_is_expired(&timer) == FALSE));
+
+   return moved;
+}
+
+#ifdef NEX_VER1
+int nex_EOEsetIp(uint16 slave, uint8 port, nex_EOEipt *ipparam, int timeout)
+{
+   return nexx_EOEsetIp(&nexx_context, slave, port, ipparam, timeout);
+}
+
+int nex_EOEgetIp(uint16 slave, uint8 port, nex_EOEipt *ipparam, int timeout)
+{
+   return nexx_EOEgetIp(&nexx_context, slave, port, ipparam, timeout);
+}
+
+int nex_EOEsend(uint16 slave, uint8 port, int psize, void *p, int timeout)
+{
+   return nexx_EOEsend(&nexx_context, slave, port, psize, p, timeout);
+}
+
+int nex_EOErecv(uint16 slave, uint8 port, int *psize, void *p, int timeout)
+{
+   return nexx_EOErecv(&nexx_context, slave, port, psize, p, timeout);
+}
+
+int nex_EOEengine_init(nex_EOEenginet *engine, void *rxhook)
+{
+   return nexx_EOEengine_init(&nexx_context, engine, rxhook);
+}
+
+int nex_EOEengine_poll(nex_EOEenginet *engine, int budget, int maxfragments)
+{
+   return nexx_EOEengine_poll(&nexx_context, engine, budget, maxfragments);
+}
+#endif
@@ -0,0 +1,141 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Headerfile for ethercateoe.c
+ */
+
+#ifndef _ethercateoe_
+#define _ethercateoe_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** max size of ethernet frame tunneled over EoE */
+#define NEX_EOE_MAXFRAME        1536
+/** max number of EoE ports handled by one engine */
+#define NEX_EOE_MAXSLOT         16
+/** length of DNS name in IP parameters */
+#define NEX_EOE_DNSNAME_LENGTH  32
+
+/** EoE IP parameter flags, which fields are valid */
+#define NEX_EOE_MAC_INCLUDE     0x01
+#define NEX_EOE_IP_INCLUDE      0x02
+#define NEX_EOE_SUBNET_INCLUDE  0x04
+#define NEX_EOE_GATEWAY_INCLUDE 0x08
+#define NEX_EOE_DNSIP_INCLUDE   0x10
+#define NEX_EOE_DNSNAME_INCLUDE 0x20
+
+/** EoE IP parameters, addresses in network byte order */
+typedef struct
+{
+   /** valid fields, see NEX_EOE_*_INCLUDE */
+   uint32  flags;
+   uint8   mac[6];
+   uint8   ip[4];
+   uint8   subnet[4];
+   uint8   gateway[4];
+   uint8   dnsip[4];
+   char    dnsname[NEX_EOE_DNSNAME_LENGTH];
+} nex_EOEipt;
+
+/** EoE fragment state of one direction of one port */
+typedef struct
+{
+   /** frame buffer */
+   uint8   *buf;
+   /** size of frame buffer */
+   int     bufsize;
+   /** frame size, 0 = idle */
+   int     size;
+   /** bytes sent or received so far */
+   int     offset;
+   /** next fragment number */
+   uint8   fragno;
+   /** frame number of current frame */
+   uint8   frameno;
+   /** time frame was queued or first fragment was received */
+   nex_timet time;
+} nex_EOEfragt;
+
+/** EoE engine slot, one port of one EoE slave */
+typedef struct
+{
+   /** slave number */
+   uint16  slave;
+   /** EoE port number */
+   uint8   port;
+   /** transmit state */
+   nex_EOEfragt tx;
+   /** receive state */
+   nex_EOEfragt rx;
+   /** transmit frame storage */
+   uint8   txbuf[NEX_EOE_MAXFRAME];
+   /** receive frame storage */
+   uint8   rxbuf[NEX_EOE_MAXFRAME];
+} nex_EOEslott;
+
+/** EoE engine statistics, latencies in us */
+typedef struct
+{
+   uint32  txframes;
+   uint32  rxframes;
+   uint32  txbytes;
+   uint32  rxbytes;
+   uint32  txfragments;
+   uint32  rxfragments;
+   /** frames rejected by nexx_EOEengine_queue because slot was busy */
+   uint32  txbusy;
+   /** fragments out of sequence, frame dropped */
+   uint32  rxerrors;
+   /** non EoE mailbox messages received and dropped */
+   uint32  rxforeign;
+   uint32  txlatency_sum;
+   uint32  txlatency_max;
+   uint32  rxlatency_sum;
+   uint32  rxlatency_max;
+} nex_EOEstatt;
+
+/** EoE engine, moves fragments of all EoE slaves within an acyclic budget, the
+ * mailboxes of all slaves are read and written with packed datagrams */
+typedef struct
+{
+   /** number of used slots */
+   int     nslot;
+   /** slot to service first on next poll */
+   int     next;
+   /** receive hook, called for every complete frame */
+   int     (*rxhook)(uint16 slave, uint8 port, void *frame, int size);
+   nex_EOEslott slot[NEX_EOE_MAXSLOT];
+   /** mailbox buffers of one round, see nexx_EOEengine_poll */
+   nex_mbxbuft mbx[NEX_EOE_MAXSLOT];
+   nex_EOEstatt stat;
+} nex_EOEenginet;
+
+#ifdef NEX_VER1
+int nex_EOEsetIp(uint16 slave, uint8 port, nex_EOEipt *ipparam, int timeout);
+int nex_EOEgetIp(uint16 slave, uint8 port, nex_EOEipt *ipparam, int timeout);
+int nex_EOEsend(uint16 slave, uint8 port, int psize, void *p, int timeout);
+int nex_EOErecv(uint16 slave, uint8 port, int *psize, void *p, int timeout);
+int nex_EOEengine_init(nex_EOEenginet *engine, void *rxhook);
+int nex_EOEengine_poll(nex_EOEenginet *engine, int budget, int maxfragments);
+#endif
+
+int nexx_EOEsetIp(nexx_contextt *context, uint16 slave, uint8 port, nex_EOEipt *ipparam, int timeout);
+int nexx_EOEgetIp(nexx_contextt *context, uint16 slave, uint8 port, nex_EOEipt *ipparam, int timeout);
+int nexx_EOEsend(nexx_contextt *context, uint16 slave, uint8 port, int psize, void *p, int timeout);
+int nexx_EOErecv(nexx_contextt *context, uint16 slave, uint8 port, int *psize, void *p, int timeout);
+int nexx_EOEengine_init(nexx_contextt *context, nex_EOEenginet *engine, void *rxhook);
+int nexx_EOEengine_queue(nex_EOEenginet *engine, uint16 slave, uint8 port, int psize, void *p);
+int nexx_EOEengine_poll(nexx_contextt *context, nex_EOEenginet *engine, int budget, int maxfragments);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
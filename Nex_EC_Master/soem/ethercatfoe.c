@@ -352,6 +352,817 @@ int nexx_FOEwrite(nexx_contextt *context, uint16 slave, char *filename, uint32 p
    return wkc;
 }
 
+/** Fill FoE mailbox header with data length and new mailbox count.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number.
+ * @param[out] FOEp       = FoE mailbox
+ * @param[in]  opcode     = FoE opcode
+ * @param[in]  datalength = bytes following the FoE header
+ */
+static void nexx_FOEheader(nexx_contextt *context, uint16 slave, nex_FOEt *FOEp, uint8 opcode, uint16 datalength)
+{
+   uint8 cnt;
+
+   FOEp->MbxHeader.length = htoes(0x0006 + datalength);
+   FOEp->MbxHeader.address = htoes(0x0000);
+   FOEp->MbxHeader.priority = 0x00;
+   /* get new mailbox count value */
+   cnt = nex_nextmbxcnt(context->slavelist[slave].mbx_cnt);
+   context->slavelist[slave].mbx_cnt = cnt;
+   FOEp->MbxHeader.mbxtype = ECT_MBXT_FOE + (cnt << 4); /* FoE */
+   FOEp->OpCode = opcode;
+}
+
+/** Prepare FoE read or write request.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number.
+ * @param[out] mbx        = mailbox with request
+ * @param[in]  opcode     = ECT_FOE_READ or ECT_FOE_WRITE
+ * @param[in]  filename   = Filename of file.
+ * @param[in]  password   = password.
+ */
+static void nexx_FOEsetrequest(nexx_contextt *context, uint16 slave, nex_mbxbuft *mbx, uint8 opcode,
+                               char *filename, uint32 password)
+{
+   nex_FOEt *FOEp;
+   uint16 fnsize, maxdata;
+
+   nex_clearmbx(mbx);
+   FOEp = (nex_FOEt *)mbx;
+   fnsize = (uint16)strlen(filename);
+   maxdata = context->slavelist[slave].mbx_l - 12;
+   if (fnsize > maxdata)
+   {
+      fnsize = maxdata;
+   }
+   nexx_FOEheader(context, slave, FOEp, opcode, fnsize);
+   FOEp->Password = htoel(password);
+   /* copy filename in mailbox */
+   memcpy(&FOEp->FileName[0], filename, fnsize);
+}
+
+/** Send FoE read or write request.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number.
+ * @param[in]  opcode     = ECT_FOE_READ or ECT_FOE_WRITE
+ * @param[in]  filename   = Filename of file.
+ * @param[in]  password   = password.
+ * @return Workcounter of mailbox send
+ */
+static int nexx_FOErequest(nexx_contextt *context, uint16 slave, uint8 opcode, char *filename, uint32 password)
+{
+   nex_mbxbuft MbxOut;
+
+   nexx_FOEsetrequest(context, slave, &MbxOut, opcode, filename, password);
+
+   return nexx_mbxsend(context, slave, &MbxOut, NEX_TIMEOUTTXM);
+}
+
+/** Finish FoE stream statistics.
+ *
+ * @param[in]  start      = start time of transfer
+ * @param[out] stat       = statistics
+ */
+static void nexx_FOEstat(nex_timet *start, nex_FOEstatt *stat)
+{
+   nex_timet stop, diff;
+
+   stop = osal_current_time();
+   osal_time_diff(start, &stop, &diff);
+   stat->elapsed = diff.sec * 1000000 + diff.usec;
+   stat->throughput = 0;
+   if (stat->elapsed)
+   {
+      stat->throughput = (uint32)(((int64)stat->bytes * 1000000) / stat->elapsed);
+   }
+}
+
+/** FoE read streamed to hook, blocking. Each data packet is acknowledged before
+ * it is passed to the hook, so the slave prepares the next packet while the hook
+ * stores the data. Packets are detected with nexx_mbxpoll.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number.
+ * @param[in]  filename   = Filename of file to read.
+ * @param[in]  password   = password.
+ * @param[in]  hook       = stores received data, f.e. nexx_FOEstream_fwrite
+ * @param[in]  arg        = user argument of hook
+ * @param[out] stat       = transfer statistics, may be NULL
+ * @param[in]  timeout    = Timeout per mailbox cycle in us, standard is NEX_TIMEOUTRXM
+ * @return Workcounter from last slave response or negative error
+ */
+int nexx_FOEread_stream(nexx_contextt *context, uint16 slave, char *filename, uint32 password,
+                        nex_FOEstreamhookt hook, void *arg, nex_FOEstatt *stat, int timeout)
+{
+   nex_FOEt *FOEp, *aFOEp;
+   nex_mbxbuft MbxIn, MbxOut;
+   nex_FOEstatt lstat;
+   nex_timet start;
+   int wkc;
+   int32 packetnumber, prevpacket = 0;
+   uint16 maxdata, segmentdata;
+   boolean worktodo;
+
+   if (!stat)
+   {
+      stat = &lstat;
+   }
+   memset(stat, 0, sizeof(*stat));
+   start = osal_current_time();
+   nex_clearmbx(&MbxIn);
+   /* Empty slave out mailbox if something is in. Timout set to 0 */
+   wkc = nexx_mbxreceive(context, slave, &MbxIn, 0);
+   nex_clearmbx(&MbxOut);
+   aFOEp = (nex_FOEt *)&MbxIn;
+   FOEp = (nex_FOEt *)&MbxOut;
+   maxdata = context->slavelist[slave].mbx_l - 12;
+   wkc = nexx_FOErequest(context, slave, ECT_FOE_READ, filename, password);
+   if (wkc > 0) /* succeeded to place mailbox in slave ? */
+   {
+      do
+      {
+         worktodo = FALSE;
+         wkc = nexx_mbxpoll(context, slave, &MbxIn, timeout);
+         if (wkc > 0) /* succeeded to read slave response ? */
+         {
+            if (((aFOEp->MbxHeader.mbxtype & 0x0f) == ECT_MBXT_FOE) && (aFOEp->OpCode == ECT_FOE_DATA))
+            {
+               segmentdata = etohs(aFOEp->MbxHeader.length) - 0x0006;
+               packetnumber = etohl(aFOEp->PacketNumber);
+               if ((packetnumber == ++prevpacket) && (segmentdata <= maxdata))
+               {
+                  /* slave consumed the previous ack before sending data, mailbox is free */
+                  nexx_FOEheader(context, slave, FOEp, ECT_FOE_ACK, 0);
+                  FOEp->PacketNumber = htoel(packetnumber);
+                  wkc = nexx_mbxwrite(context, slave, &MbxOut, NEX_TIMEOUTTXM);
+                  if (hook(arg, &aFOEp->Data[0], segmentdata) != segmentdata)
+                  {
+                     wkc = -NEX_ERR_TYPE_FOE_BUF2SMALL;
+                  }
+                  else if (wkc > 0)
+                  {
+                     stat->bytes += segmentdata;
+                     stat->packets++;
+                     worktodo = (segmentdata == maxdata);
+                     if (context->FOEhook)
+                     {
+                        context->FOEhook(slave, packetnumber, stat->bytes);
+                     }
+                  }
+               }
+               else
+               {
+                  /* FoE error */
+                  wkc = -NEX_ERR_TYPE_FOE_PACKETNUMBER;
+               }
+            }
+            else if (((aFOEp->MbxHeader.mbxtype & 0x0f) == ECT_MBXT_FOE) && (aFOEp->OpCode == ECT_FOE_BUSY))
+            {
+               stat->busy++;
+               worktodo = TRUE;
+            }
+            else if (((aFOEp->MbxHeader.mbxtype & 0x0f) == ECT_MBXT_FOE) && (aFOEp->OpCode == ECT_FOE_ERROR))
+            {
+               /* FoE error */
+               wkc = -NEX_ERR_TYPE_FOE_ERROR;
+            }
+            else
+            {
+               /* unexpected mailbox received */
+               wkc = -NEX_ERR_TYPE_PACKET_ERROR;
+            }
+         }
+      } while (worktodo);
+   }
+   nexx_FOEstat(&start, stat);
+
+   return wkc;
+}
+
+/** FoE write streamed from hook, blocking. The next data packet is read from the
+ * hook while the slave processes the current one, and sent as soon as the slave
+ * acknowledges. Acknowledges are detected with nexx_mbxpoll.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number.
+ * @param[in]  filename   = Filename of file to write.
+ * @param[in]  password   = password.
+ * @param[in]  hook       = supplies data to send, f.e. nexx_FOEstream_fread
+ * @param[in]  arg        = user argument of hook
+ * @param[out] stat       = transfer statistics, may be NULL
+ * @param[in]  timeout    = Timeout per mailbox cycle in us, standard is NEX_TIMEOUTRXM
+ * @return Workcounter from last slave response or negative error
+ */
+int nexx_FOEwrite_stream(nexx_contextt *context, uint16 slave, char *filename, uint32 password,
+                         nex_FOEstreamhookt hook, void *arg, nex_FOEstatt *stat, int timeout)
+{
+   nex_FOEt *FOEp[2], *aFOEp;
+   nex_mbxbuft MbxIn, MbxOut[2];
+   nex_FOEstatt lstat;
+   nex_timet start;
+   int wkc;
+   int32 packetnumber, sendpacket = 0;
+   uint16 maxdata;
+   int segmentdata[2];
+   int sent, next;
+   boolean worktodo;
+
+   if (!stat)
+   {
+      stat = &lstat;
+   }
+   memset(stat, 0, sizeof(*stat));
+   start = osal_current_time();
+   nex_clearmbx(&MbxIn);
+   /* Empty slave out mailbox if something is in. Timout set to 0 */
+   wkc = nexx_mbxreceive(context, slave, &MbxIn, 0);
+   aFOEp = (nex_FOEt *)&MbxIn;
+   FOEp[0] = (nex_FOEt *)&MbxOut[0];
+   FOEp[1] = (nex_FOEt *)&MbxOut[1];
+   maxdata = context->slavelist[slave].mbx_l - 12;
+   if (maxdata > NEX_MAXFOEDATA)
+   {
+      maxdata = NEX_MAXFOEDATA;
+   }
+   sent = -1;
+   next = 0;
+   wkc = nexx_FOErequest(context, slave, ECT_FOE_WRITE, filename, password);
+   if (wkc > 0) /* succeeded to place mailbox in slave ? */
+   {
+      /* first packet is read while slave opens file */
+      segmentdata[next] = hook(arg, &FOEp[next]->Data[0], maxdata);
+      do
+      {
+         worktodo = FALSE;
+         if (segmentdata[next] < 0)
+         {
+            wkc = -NEX_ERR_TYPE_FOE_ERROR;
+            break;
+         }
+         wkc = nexx_mbxpoll(context, slave, &MbxIn, timeout);
+         if (wkc > 0) /* succeeded to read slave response ? */
+         {
+            if ((aFOEp->MbxHeader.mbxtype & 0x0f) != ECT_MBXT_FOE)
+            {
+               /* unexpected mailbox received */
+               wkc = -NEX_ERR_TYPE_PACKET_ERROR;
+            }
+            else if (aFOEp->OpCode == ECT_FOE_ACK)
+            {
+               packetnumber = etohl(aFOEp->PacketNumber);
+               if (packetnumber != sendpacket)
+               {
+                  /* FoE error */
+                  wkc = -NEX_ERR_TYPE_FOE_PACKETNUMBER;
+               }
+               else
+               {
+                  if (sent >= 0)
+                  {
+                     stat->bytes += segmentdata[sent];
+                     stat->packets++;
+                  }
+                  if (context->FOEhook)
+                  {
+                     context->FOEhook(slave, packetnumber, stat->bytes);
+                  }
+                  /* EOF is defined as packetsize < full packetsize */
+                  if ((sent < 0) || (segmentdata[sent] == maxdata))
+                  {
+                     sent = next;
+                     next ^= 1;
+                     nexx_FOEheader(context, slave, FOEp[sent], ECT_FOE_DATA, (uint16)segmentdata[sent]);
+                     FOEp[sent]->PacketNumber = htoel(++sendpacket);
+                     /* slave consumed the previous packet before acknowledging it */
+                     wkc = nexx_mbxwrite(context, slave, &MbxOut[sent], NEX_TIMEOUTTXM);
+                     worktodo = (wkc > 0);
+                     /* read next packet while slave processes this one */
+                     if (worktodo && (segmentdata[sent] == maxdata))
+                     {
+                        segmentdata[next] = hook(arg, &FOEp[next]->Data[0], maxdata);
+                     }
+                  }
+               }
+            }
+            else if (aFOEp->OpCode == ECT_FOE_BUSY)
+            {
+               stat->busy++;
+               worktodo = TRUE;
+               /* resend if data has been send before, otherwise ignore */
+               if (sent >= 0)
+               {
+                  nexx_FOEheader(context, slave, FOEp[sent], ECT_FOE_DATA, (uint16)segmentdata[sent]);
+                  wkc = nexx_mbxwrite(context, slave, &MbxOut[sent], NEX_TIMEOUTTXM);
+                  worktodo = (wkc > 0);
+               }
+            }
+            else if (aFOEp->OpCode == ECT_FOE_ERROR)
+            {
+               /* FoE error */
+               if (etohl(aFOEp->ErrorCode) == 0x8001)
+               {
+                  wkc = -NEX_ERR_TYPE_FOE_FILE_NOTFOUND;
+               }
+               else
+               {
+                  wkc = -NEX_ERR_TYPE_FOE_ERROR;
+               }
+            }
+            else
+            {
+               /* unexpected mailbox received */
+               wkc = -NEX_ERR_TYPE_PACKET_ERROR;
+            }
+         }
+      } while (worktodo);
+   }
+   nexx_FOEstat(&start, stat);
+
+   return wkc;
+}
+
+/** FoE stream hook reading from a stdio file.
+ *
+ * @param[in]  arg        = FILE pointer
+ * @param[out] buf        = data buffer
+ * @param[in]  size       = max bytes to read
+ * @return bytes read, -1 on file error
+ */
+int nexx_FOEstream_fread(void *arg, void *buf, int size)
+{
+   size_t n;
+
+   n = fread(buf, 1, size, (FILE *)arg);
+   if ((n < (size_t)size) && ferror((FILE *)arg))
+   {
+      return -1;
+   }
+   return (int)n;
+}
+
+/** FoE stream hook writing to a stdio file.
+ *
+ * @param[in]  arg        = FILE pointer
+ * @param[in]  buf        = data buffer
+ * @param[in]  size       = bytes to write
+ * @return bytes written, -1 on file error
+ */
+int nexx_FOEstream_fwrite(void *arg, void *buf, int size)
+{
+   if (fwrite(buf, 1, size, (FILE *)arg) != (size_t)size)
+   {
+      return -1;
+   }
+   return size;
+}
+
+/** resends of a message after response timeout in FoE mass update */
+#define NEX_FOEMASS_RETRY      2
+/** delay in us when a FoE mass update poll did not move any message */
+#define NEX_FOEMASS_IDLEDELAY  100
+
+/** Initialise FoE mass update.
+ *
+ * @param[out] mass       = FoE mass update
+ * @param[in]  slavelst   = Slave numbers to update
+ * @param[in]  nslave     = number of slaves, max NEX_FOEMASS_MAX
+ * @param[in]  filename   = Filename of file to write.
+ * @param[in]  password   = password.
+ * @param[in]  image      = file data, shared by all slaves
+ * @param[in]  imagesize  = size of file data
+ * @param[in]  timeout    = slave response timeout in us, f.e. NEX_TIMEOUTSTATE
+ * @param[in]  hook       = progress hook, NULL if not used
+ * @return number of slaves
+ */
+int nexx_FOEmass_init(nex_FOEmasst *mass, uint16 *slavelst, int nslave, char *filename, uint32 password,
+                      void *image, uint32 imagesize, int timeout, void *hook)
+{
+   int i;
+
+   memset(mass, 0, sizeof(*mass));
+   if (nslave > NEX_FOEMASS_MAX)
+   {
+      nslave = NEX_FOEMASS_MAX;
+   }
+   mass->nslave = nslave;
+   mass->filename = filename;
+   mass->password = password;
+   mass->image = (uint8 *)image;
+   mass->imagesize = imagesize;
+   mass->timeout = timeout;
+   mass->hook = hook;
+   mass->active = nslave;
+   for (i = 0; i < nslave; i++)
+   {
+      mass->sl[i].slave = slavelst[i];
+      mass->sl[i].phase = NEX_FOEMASS_START;
+      mass->sl[i].retry = NEX_FOEMASS_RETRY;
+   }
+
+   return nslave;
+}
+
+/** Finish FoE mass update of one slave.
+ *
+ * @param[in]  mass       = FoE mass update
+ * @param[in]  sp         = slave state
+ * @param[in]  result     = 1 on success or negative error
+ */
+static void nexx_FOEmass_finish(nex_FOEmasst *mass, nex_FOEmassslavet *sp, int result)
+{
+   sp->phase = NEX_FOEMASS_DONE;
+   sp->result = result;
+   mass->active--;
+   if (mass->hook)
+   {
+      mass->hook(sp->slave, sp->bytes, mass->imagesize, result);
+   }
+}
+
+/** Request AL state of all running slaves of FoE mass update in one frame and
+ * wait until they reached it.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  mass       = FoE mass update
+ * @param[in]  state      = requested state
+ * @param[in]  timeout    = Timeout in us
+ * @return number of slaves in requested state
+ */
+static int nexx_FOEmass_state(nexx_contextt *context, nex_FOEmasst *mass, uint16 state, int timeout)
+{
+   nex_datagramt lst[NEX_FOEMASS_MAX];
+   nex_alstatust alstat[NEX_FOEMASS_MAX];
+   int sli[NEX_FOEMASS_MAX];
+   uint16 alctl;
+   nex_FOEmassslavet *sp;
+   osal_timert timer;
+   int i, n, reached;
+
+   n = 0;
+   alctl = htoes(state);
+   for (i = 0; i < mass->nslave; i++)
+   {
+      sp = &mass->sl[i];
+      if (sp->phase == NEX_FOEMASS_START)
+      {
+         context->slavelist[sp->slave].state = state;
+         lst[n].configadr = context->slavelist[sp->slave].configadr;
+         lst[n].ADO = ECT_REG_ALCTL;
+         lst[n].length = sizeof(alctl);
+         lst[n].data = &alctl;
+         sli[n++] = i;
+      }
+   }
+   nexx_FP_multi(context, NEX_CMD_FPWR, lst, n, NEX_TIMEOUTRET3);
+   osal_timer_start(&timer, timeout);
+   do
+   {
+      for (i = 0; i < n; i++)
+      {
+         lst[i].ADO = ECT_REG_ALSTAT;
+         lst[i].length = sizeof(nex_alstatust);
+         lst[i].data = &alstat[i];
+         memset(&alstat[i], 0, sizeof(nex_alstatust));
+      }
+      nexx_FP_multi(context, NEX_CMD_FPRD, lst, n, NEX_TIMEOUTRET3);
+      reached = 0;
+      for (i = 0; i < n; i++)
+      {
+         sp = &mass->sl[sli[i]];
+         sp->alstate = etohs(alstat[i].alstatus);
+         context->slavelist[sp->slave].ALstatuscode = etohs(alstat[i].alstatuscode);
+         if ((sp->alstate & 0x0f) == state)
+         {
+            reached++;
+         }
+      }
+      if (reached < n)
+      {
+         osal_usleep(1000);
+      }
+   } while ((reached < n) && (osal_timer_is_expired(&timer) == FALSE));
+
+   return reached;
+}
+
+/** Switch all slaves of FoE mass update to BOOT state. State requests, SII reads
+ * of the boot mailbox configuration and the SM programming are done for all
+ * slaves at once. Slaves that do not reach BOOT are finished with an error.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  mass       = FoE mass update
+ * @param[in]  timeout    = state change timeout in us, f.e. NEX_TIMEOUTSTATE * 10
+ * @return number of slaves in BOOT state
+ */
+int nexx_FOEmass_boot(nexx_contextt *context, nex_FOEmasst *mass, int timeout)
+{
+   nex_datagramt lst[NEX_FOEMASS_MAX];
+   nex_smt sm[NEX_FOEMASS_MAX][2];
+   uint32 rxmbx[NEX_FOEMASS_MAX], txmbx[NEX_FOEMASS_MAX];
+   nex_FOEmassslavet *sp;
+   nex_slavet *slave;
+   int i, inboot;
+
+   nexx_FOEmass_state(context, mass, NEX_STATE_INIT, timeout);
+   /* boot mailbox configuration, the EEPROMs of all slaves are read in parallel */
+   for (i = 0; i < mass->nslave; i++)
+   {
+      nexx_readeeprom1(context, mass->sl[i].slave, ECT_SII_BOOTRXMBX);
+   }
+   for (i = 0; i < mass->nslave; i++)
+   {
+      rxmbx[i] = nexx_readeeprom2(context, mass->sl[i].slave, NEX_TIMEOUTEEP);
+   }
+   for (i = 0; i < mass->nslave; i++)
+   {
+      nexx_readeeprom1(context, mass->sl[i].slave, ECT_SII_BOOTTXMBX);
+   }
+   for (i = 0; i < mass->nslave; i++)
+   {
+      txmbx[i] = nexx_readeeprom2(context, mass->sl[i].slave, NEX_TIMEOUTEEP);
+   }
+   for (i = 0; i < mass->nslave; i++)
+   {
+      slave = &context->slavelist[mass->sl[i].slave];
+      if (HI_WORD(rxmbx[i]) && HI_WORD(txmbx[i]))
+      {
+         slave->SM[0].StartAddr = htoes(LO_WORD(rxmbx[i]));
+         slave->SM[0].SMlength = htoes(HI_WORD(rxmbx[i]));
+         slave->mbx_wo = LO_WORD(rxmbx[i]);
+         slave->mbx_l = HI_WORD(rxmbx[i]);
+         slave->SM[1].StartAddr = htoes(LO_WORD(txmbx[i]));
+         slave->SM[1].SMlength = htoes(HI_WORD(txmbx[i]));
+         slave->mbx_ro = LO_WORD(txmbx[i]);
+         slave->mbx_rl = HI_WORD(txmbx[i]);
+      }
+      /* SM0 and SM1 are adjacent, program both with one datagram */
+      sm[i][0] = slave->SM[0];
+      sm[i][1] = slave->SM[1];
+      lst[i].configadr = slave->configadr;
+      lst[i].ADO = ECT_REG_SM0;
+      lst[i].length = sizeof(sm[i]);
+      lst[i].data = &sm[i][0];
+   }
+   nexx_FP_multi(context, NEX_CMD_FPWR, lst, mass->nslave, NEX_TIMEOUTRET3);
+   for (i = 0; i < mass->nslave; i++)
+   {
+      if ((lst[i].wkc <= 0) && (mass->sl[i].phase == NEX_FOEMASS_START))
+      {
+         nexx_FOEmass_finish(mass, &mass->sl[i], -NEX_ERR_TYPE_PACKET_ERROR);
+      }
+   }
+   nexx_FOEmass_state(context, mass, NEX_STATE_BOOT, timeout);
+   inboot = 0;
+   for (i = 0; i < mass->nslave; i++)
+   {
+      sp = &mass->sl[i];
+      if (sp->phase != NEX_FOEMASS_START)
+      {
+         continue;
+      }
+      if ((sp->alstate & 0x0f) == NEX_STATE_BOOT)
+      {
+         inboot++;
+      }
+      else
+      {
+         nexx_FOEmass_finish(mass, sp, -NEX_ERR_TYPE_FOE_ERROR);
+      }
+   }
+
+   return inboot;
+}
+
+/** Handle mailbox received from slave in FoE mass update.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  mass       = FoE mass update
+ * @param[in]  sp         = slave state
+ */
+static void nexx_FOEmass_response(nexx_contextt *context, nex_FOEmasst *mass, nex_FOEmassslavet *sp)
+{
+   nex_FOEt *FOEp, *aFOEp;
+   uint16 maxdata;
+   uint32 left;
+
+   FOEp = (nex_FOEt *)&sp->mbx;
+   aFOEp = (nex_FOEt *)&sp->rx;
+   if ((aFOEp->MbxHeader.mbxtype & 0x0f) != ECT_MBXT_FOE)
+   {
+      /* not for us, keep waiting */
+      return;
+   }
+   maxdata = context->slavelist[sp->slave].mbx_l - 12;
+   if (maxdata > NEX_MAXFOEDATA)
+   {
+      maxdata = NEX_MAXFOEDATA;
+   }
+   switch (aFOEp->OpCode)
+   {
+      case ECT_FOE_ACK:
+      {
+         if ((int32)etohl(aFOEp->PacketNumber) != sp->sendpacket)
+         {
+            nexx_FOEmass_finish(mass, sp, -NEX_ERR_TYPE_FOE_PACKETNUMBER);
+            break;
+         }
+         if (sp->sendpacket)
+         {
+            sp->bytes += sp->segmentdata;
+            /* EOF is defined as packetsize < full packetsize */
+            if (sp->segmentdata < maxdata)
+            {
+               nexx_FOEmass_finish(mass, sp, 1);
+               break;
+            }
+            if (mass->hook)
+            {
+               mass->hook(sp->slave, sp->bytes, mass->imagesize, 0);
+            }
+         }
+         left = mass->imagesize - sp->bytes;
+         sp->segmentdata = (left > maxdata) ? maxdata : (int)left;
+         nexx_FOEheader(context, sp->slave, FOEp, ECT_FOE_DATA, (uint16)sp->segmentdata);
+         FOEp->PacketNumber = htoel(++sp->sendpacket);
+         memcpy(&FOEp->Data[0], mass->image + sp->bytes, sp->segmentdata);
+         sp->retry = NEX_FOEMASS_RETRY;
+         sp->phase = NEX_FOEMASS_SEND;
+         osal_timer_start(&sp->timer, mass->timeout);
+         break;
+      }
+      case ECT_FOE_BUSY:
+      {
+         /* resend if data has been send before, otherwise wait */
+         if (sp->sendpacket)
+         {
+            nexx_FOEheader(context, sp->slave, FOEp, ECT_FOE_DATA, (uint16)sp->segmentdata);
+            sp->phase = NEX_FOEMASS_SEND;
+         }
+         osal_timer_start(&sp->timer, mass->timeout);
+         break;
+      }
+      case ECT_FOE_ERROR:
+      {
+         if (etohl(aFOEp->ErrorCode) == 0x8001)
+         {
+            nexx_FOEmass_finish(mass, sp, -NEX_ERR_TYPE_FOE_FILE_NOTFOUND);
+         }
+         else
+         {
+            nexx_FOEmass_finish(mass, sp, -NEX_ERR_TYPE_FOE_ERROR);
+         }
+         break;
+      }
+      default:
+      {
+         nexx_FOEmass_finish(mass, sp, -NEX_ERR_TYPE_PACKET_ERROR);
+         break;
+      }
+   }
+}
+
+/** Move FoE mass update forward, non blocking. Pending messages of all slaves
+ * are written in shared frames up to maxbytes of mailbox data, then the mailboxes
+ * of all waiting slaves are read in shared frames.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  mass       = FoE mass update
+ * @param[in]  maxbytes   = bandwidth budget, mailbox bytes written per call
+ * @return number of messages moved
+ */
+int nexx_FOEmass_poll(nexx_contextt *context, nex_FOEmasst *mass, int maxbytes)
+{
+   nex_datagramt lst[NEX_FOEMASS_MAX];
+   uint16 sllst[NEX_FOEMASS_MAX];
+   int sli[NEX_FOEMASS_MAX];
+   nex_FOEmassslavet *sp;
+   int i, k, n, bytes, moved;
+
+   moved = 0;
+   n = 0;
+   bytes = 0;
+   for (k = 0; k < mass->nslave; k++)
+   {
+      /* start with a different slave every call to share the budget */
+      i = (mass->next + k) % mass->nslave;
+      sp = &mass->sl[i];
+      if (sp->phase == NEX_FOEMASS_START)
+      {
+         nexx_FOEsetrequest(context, sp->slave, &sp->mbx, ECT_FOE_WRITE, mass->filename, mass->password);
+         sp->phase = NEX_FOEMASS_SEND;
+         osal_timer_start(&sp->timer, mass->timeout);
+      }
+      if (sp->phase != NEX_FOEMASS_SEND)
+      {
+         continue;
+      }
+      if (n && ((bytes + context->slavelist[sp->slave].mbx_l) > maxbytes))
+      {
+         break;
+      }
+      bytes += context->slavelist[sp->slave].mbx_l;
+      sllst[n] = sp->slave;
+      lst[n].data = &sp->mbx;
+      sli[n++] = i;
+   }
+   if (mass->nslave)
+   {
+      mass->next = (mass->next + 1) % mass->nslave;
+   }
+   if (n)
+   {
+      nexx_mbxwrite_multi(context, n, sllst, lst, NEX_TIMEOUTRET3);
+      for (i = 0; i < n; i++)
+      {
+         sp = &mass->sl[sli[i]];
+         if (lst[i].wkc > 0)
+         {
+            sp->phase = NEX_FOEMASS_WAIT;
+            osal_timer_start(&sp->timer, mass->timeout);
+            moved++;
+         }
+         else if (osal_timer_is_expired(&sp->timer))
+         {
+            /* mailbox stays full */
+            nexx_FOEmass_finish(mass, sp, -NEX_ERR_TYPE_MBX_ERROR);
+         }
+      }
+   }
+   n = 0;
+   for (i = 0; i < mass->nslave; i++)
+   {
+      sp = &mass->sl[i];
+      if (sp->phase == NEX_FOEMASS_WAIT)
+      {
+         sllst[n] = sp->slave;
+         lst[n].data = &sp->rx;
+         sli[n++] = i;
+      }
+   }
+   if (n)
+   {
+      nexx_mbxpoll_multi(context, n, sllst, lst, NEX_TIMEOUTRET3);
+      for (i = 0; i < n; i++)
+      {
+         sp = &mass->sl[sli[i]];
+         if (lst[i].wkc > 0)
+         {
+            moved++;
+            nexx_FOEmass_response(context, mass, sp);
+         }
+         else if (osal_timer_is_expired(&sp->timer))
+         {
+            if (sp->retry)
+            {
+               /* resend with same mailbox counter, slave drops it if it was received */
+               sp->retry--;
+               sp->phase = NEX_FOEMASS_SEND;
+               osal_timer_start(&sp->timer, mass->timeout);
+            }
+            else
+            {
+               nexx_FOEmass_finish(mass, sp, -NEX_ERR_TYPE_FOE_ERROR);
+            }
+         }
+      }
+   }
+
+   return moved;
+}
+
+/** Run FoE mass update until all slaves are finished, blocking.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  mass       = FoE mass update
+ * @param[in]  maxbytes   = bandwidth budget, mailbox bytes written per poll
+ * @return number of slaves updated successfully
+ */
+int nexx_FOEmass_run(nexx_contextt *context, nex_FOEmasst *mass, int maxbytes)
+{
+   int i, ok;
+
+   while (mass->active > 0)
+   {
+      if (!nexx_FOEmass_poll(context, mass, maxbytes))
+      {
+         osal_usleep(NEX_FOEMASS_IDLEDELAY);
+      }
+   }
+   ok = 0;
+   for (i = 0; i < mass->nslave; i++)
+   {
+      if (mass->sl[i].result == 1)
+      {
+         ok++;
+      }
+   }
+
+   return ok;
+}
+
 #ifdef NEX_VER1
 int nex_FOEdefinehook(void *hook)
 {
@@ -367,4 +1178,31 @@ int nex_FOEwrite(uint16 slave, char *filename, uint32 password, int psize, void
 {
    return nexx_FOEwrite(&nexx_context, slave, filename, password, psize, p, timeout);
 }
+
+int nex_FOEread_stream(uint16 slave, char *filename, uint32 password, nex_FOEstreamhookt hook, void *arg,
+                       nex_FOEstatt *stat, int timeout)
+{
+   return nexx_FOEread_stream(&nexx_context, slave, filename, password, hook, arg, stat, timeout);
+}
+
+int nex_FOEwrite_stream(uint16 slave, char *filename, uint32 password, nex_FOEstreamhookt hook, void *arg,
+                        nex_FOEstatt *stat, int timeout)
+{
+   return nexx_FOEwrite_stream(&nexx_context, slave, filename, password, hook, arg, stat, timeout);
+}
+
+int nex_FOEmass_boot(nex_FOEmasst *mass, int timeout)
+{
+   return nexx_FOEmass_boot(&nexx_context, mass, timeout);
+}
+
+int nex_FOEmass_poll(nex_FOEmasst *mass, int maxbytes)
+{
+   return nexx_FOEmass_poll(&nexx_context, mass, maxbytes);
+}
+
+int nex_FOEmass_run(nex_FOEmasst *mass, int maxbytes)
+{
+   return nexx_FOEmass_run(&nexx_context, mass, maxbytes);
+}
 #endif
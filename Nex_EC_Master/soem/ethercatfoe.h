@@ -16,15 +16,116 @@ extern "C"
 {
 #endif
 
+/** FoE stream hook, reads next data to send or stores received data.
+ * Returns number of bytes handled, less than size at end of file, <0 to abort.
+ */
+typedef int (*nex_FOEstreamhookt)(void *arg, void *buf, int size);
+
+/** FoE stream transfer statistics */
+typedef struct
+{
+   /** bytes transferred */
+   uint32  bytes;
+   /** data packets transferred */
+   uint32  packets;
+   /** busy responses of slave */
+   uint32  busy;
+   /** mailbox reads without data */
+   uint32  polls;
+   /** duration of transfer in us */
+   uint32  elapsed;
+   /** bytes per second */
+   uint32  throughput;
+} nex_FOEstatt;
+
+/** max number of slaves in one FoE mass update */
+#define NEX_FOEMASS_MAX      64
+
+/** FoE mass update phase of a slave */
+enum
+{
+   /** write request not yet prepared */
+   NEX_FOEMASS_START = 0,
+   /** message ready to be written to slave mailbox */
+   NEX_FOEMASS_SEND,
+   /** waiting for slave response */
+   NEX_FOEMASS_WAIT,
+   /** finished, see result */
+   NEX_FOEMASS_DONE
+};
+
+/** FoE mass update state of one slave */
+typedef struct
+{
+   uint16  slave;
+   /** NEX_FOEMASS_* phase */
+   uint8   phase;
+   /** resends left after response timeout */
+   uint8   retry;
+   /** 0 = running, 1 = success, <0 = negative NEX_ERR_TYPE_* */
+   int     result;
+   /** AL state after nexx_FOEmass_boot */
+   uint16  alstate;
+   int32   sendpacket;
+   /** data bytes in current packet */
+   int     segmentdata;
+   /** bytes acknowledged by slave */
+   uint32  bytes;
+   /** response timeout */
+   osal_timert timer;
+   /** message to write to slave */
+   nex_mbxbuft mbx;
+   /** response of slave */
+   nex_mbxbuft rx;
+} nex_FOEmassslavet;
+
+/** FoE mass update, one image written to many slaves in BOOT state */
+typedef struct
+{
+   int     nslave;
+   char    *filename;
+   uint32  password;
+   /** image shared by all slaves, f.e. a mapped file */
+   uint8   *image;
+   uint32  imagesize;
+   /** response timeout in us */
+   int     timeout;
+   /** progress hook, void hook(uint16 slave, uint32 bytes, uint32 size, int result) */
+   void    (*hook)(uint16 slave, uint32 bytes, uint32 size, int result);
+   /** slaves still running */
+   int     active;
+   /** slave to write first in next poll */
+   int     next;
+   nex_FOEmassslavet sl[NEX_FOEMASS_MAX];
+} nex_FOEmasst;
+
 #ifdef NEX_VER1
 int nex_FOEdefinehook(void *hook);
 int nex_FOEread(uint16 slave, char *filename, uint32 password, int *psize, void *p, int timeout);
 int nex_FOEwrite(uint16 slave, char *filename, uint32 password, int psize, void *p, int timeout);
+int nex_FOEread_stream(uint16 slave, char *filename, uint32 password, nex_FOEstreamhookt hook, void *arg,
+                       nex_FOEstatt *stat, int timeout);
+int nex_FOEwrite_stream(uint16 slave, char *filename, uint32 password, nex_FOEstreamhookt hook, void *arg,
+                        nex_FOEstatt *stat, int timeout);
+int nex_FOEmass_boot(nex_FOEmasst *mass, int timeout);
+int nex_FOEmass_poll(nex_FOEmasst *mass, int maxbytes);
+int nex_FOEmass_run(nex_FOEmasst *mass, int maxbytes);
 #endif
 
 int nexx_FOEdefinehook(nexx_contextt *context, void *hook);
 int nexx_FOEread(nexx_contextt *context, uint16 slave, char *filename, uint32 password, int *psize, void *p, int timeout);
 int nexx_FOEwrite(nexx_contextt *context, uint16 slave, char *filename, uint32 password, int psize, void *p, int timeout);
+int nexx_FOEread_stream(nexx_contextt *context, uint16 slave, char *filename, uint32 password,
+                        nex_FOEstreamhookt hook, void *arg, nex_FOEstatt *stat, int timeout);
+int nexx_FOEwrite_stream(nexx_contextt *context, uint16 slave, char *filename, uint32 password,
+                         nex_FOEstreamhookt hook, void *arg, nex_FOEstatt *stat, int timeout);
+int nexx_FOEstream_fread(void *arg, void *buf, int size);
+int nexx_FOEstream_fwrite(void *arg, void *buf, int size);
+int nexx_FOEmass_init(nex_FOEmasst *mass, uint16 *slavelst, int nslave, char *filename, uint32 password,
+                      void *image, uint32 imagesize, int timeout, void *hook);
+int nexx_FOEmass_boot(nexx_contextt *context, nex_FOEmasst *mass, int timeout);
+int nexx_FOEmass_poll(nexx_contextt *context, nex_FOEmasst *mass, int maxbytes);
+int nexx_FOEmass_run(nexx_contextt *context, nex_FOEmasst *mass, int maxbytes);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,305 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Mailbox gateway module.
+ *
+ * Routes mailbox requests of external tools, f.e. received as EtherCAT
+ * mailbox gateway datagrams on UDP port 0x88A4, to the slaves and their
+ * responses back. The mailbox header address of a request holds the
+ * configured station address of the slave. Towards the slave the gateway
+ * uses the mailbox counter of the master, the response carries the counter
+ * of the client again. Every slave has at most one request in transfer,
+ * requests of different slaves and clients are handled concurrently.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "osal.h"
+#include "oshw.h"
+#include "ethercattype.h"
+#include "ethercatbase.h"
+#include "ethercatmain.h"
+#include "ethercatgw.h"
+
+/** mailbox error structure */
+PACKED_BEGIN
+typedef struct PACKED
+{
+   nex_mbxheadert   MbxHeader;
+   uint16          Type;
+   uint16          Detail;
+} nex_GWmbxerrort;
+PACKED_END
+
+/** Initialise mailbox gateway.
+ *
+ * @param[out] gw         = mailbox gateway
+ * @param[in]  timeout    = slave response timeout in us, f.e. NEX_TIMEOUTRXM
+ * @param[in]  hook       = response hook
+ */
+void nexx_GWinit(nex_GWt *gw, int timeout, void *hook)
+{
+   memset(gw, 0, sizeof(*gw));
+   gw->timeout = timeout;
+   gw->hook = hook;
+}
+
+/** Reject request of client with a mailbox error.
+ *
+ * @param[in]  gw         = mailbox gateway
+ * @param[in]  client     = client handle
+ * @param[in]  mbxh       = header of rejected request
+ * @param[in]  detail     = mailbox error detail
+ */
+static void nexx_GWreject(nex_GWt *gw, int client, nex_mbxheadert *mbxh, uint16 detail)
+{
+   nex_GWmbxerrort err;
+
+   gw->stat.rejected++;
+   if (!gw->hook)
+   {
+      return;
+   }
+   memset(&err, 0, sizeof(err));
+   err.MbxHeader.length = htoes(sizeof(err) - sizeof(nex_mbxheadert));
+   err.MbxHeader.address = mbxh->address;
+   err.MbxHeader.mbxtype = (mbxh->mbxtype & 0xf0) | ECT_MBXT_ERR;
+   err.Type = htoes(0x0001);
+   err.Detail = htoes(detail);
+   gw->hook(client, 0, &err, sizeof(err));
+}
+
+/** Queue mailbox request of client, does not block.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  gw         = mailbox gateway
+ * @param[in]  client     = client handle, passed to the response hook
+ * @param[in]  mbx        = mailbox request starting with the mailbox header
+ * @param[in]  size       = size of request in bytes
+ * @return 1 if queued, 0 if rejected, the hook got a mailbox error
+ */
+int nexx_GWrequest(nexx_contextt *context, nex_GWt *gw, int client, void *mbx, int size)
+{
+   nex_mbxheadert *mbxh;
+   nex_GWrequestt *r;
+   uint16 slave, address;
+   int i;
+
+   mbxh = (nex_mbxheadert *)mbx;
+   if (size < (int)sizeof(nex_mbxheadert))
+   {
+      gw->stat.rejected++;
+      return 0;
+   }
+   address = etohs(mbxh->address);
+   slave = 0;
+   for (i = 1; (i <= *(context->slavecount)) && !slave; i++)
+   {
+      if ((context->slavelist[i].configadr == address) && context->slavelist[i].mbx_l)
+      {
+         slave = (uint16)i;
+      }
+   }
+   if (!slave)
+   {
+      nexx_GWreject(gw, client, mbxh, NEX_GW_MBXERR_INVALIDHEADER);
+      return 0;
+   }
+   if ((size > context->slavelist[slave].mbx_l) ||
+       ((etohs(mbxh->length) + (int)sizeof(nex_mbxheadert)) > size))
+   {
+      nexx_GWreject(gw, client, mbxh, NEX_GW_MBXERR_INVALIDSIZE);
+      return 0;
+   }
+   r = NULL;
+   for (i = 0; (i < NEX_GW_MAXREQ) && !r; i++)
+   {
+      if (gw->req[i].state == NEX_GW_FREE)
+      {
+         r = &gw->req[i];
+      }
+   }
+   if (!r)
+   {
+      nexx_GWreject(gw, client, mbxh, NEX_GW_MBXERR_NOMOREMEMORY);
+      return 0;
+   }
+   nex_clearmbx(&r->mbx);
+   memcpy(&r->mbx, mbx, size);
+   r->slave = slave;
+   r->client = client;
+   r->cnt = (mbxh->mbxtype >> 4) & 0x07;
+   r->mbxcnt = 0;
+   r->seq = gw->seq++;
+   osal_timer_start(&r->timer, gw->timeout);
+   r->state = NEX_GW_QUEUED;
+   gw->stat.requests++;
+
+   return 1;
+}
+
+/** Check if request has to wait for an earlier request to the same slave.
+ *
+ * @param[in]  gw         = mailbox gateway
+ * @param[in]  r          = request
+ * @return TRUE if request has to wait
+ */
+static boolean nexx_GWwaiting(nex_GWt *gw, nex_GWrequestt *r)
+{
+   nex_GWrequestt *o;
+   int i;
+
+   for (i = 0; i < NEX_GW_MAXREQ; i++)
+   {
+      o = &gw->req[i];
+      if ((o != r) && (o->slave == r->slave) &&
+          ((o->state == NEX_GW_SENT) ||
+           ((o->state == NEX_GW_QUEUED) && ((int32)(o->seq - r->seq) < 0))))
+      {
+         return TRUE;
+      }
+   }
+   return FALSE;
+}
+
+/** Move mailbox gateway forward, non blocking. Queued requests are written
+ * to the slaves in shared frames up to maxbytes of mailbox data, then the
+ * mailboxes of all slaves with a request in transfer are read in shared frames
+ * and the responses are passed to the hook. Call it from the thread that does
+ * the other mailbox traffic, f.e. in the spare time of the cycle.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  gw         = mailbox gateway
+ * @param[in]  maxbytes   = bandwidth budget, mailbox bytes written per call
+ * @return number of messages moved
+ */
+int nexx_GWpoll(nexx_contextt *context, nex_GWt *gw, int maxbytes)
+{
+   nex_datagramt lst[NEX_GW_MAXREQ];
+   uint16 sllst[NEX_GW_MAXREQ];
+   int rli[NEX_GW_MAXREQ];
+   nex_GWrequestt *r;
+   nex_mbxheadert *mbxh;
+   nex_slavet *sl;
+   int i, k, n, bytes, moved, size;
+
+   moved = 0;
+   for (i = 0; i < NEX_GW_MAXREQ; i++)
+   {
+      r = &gw->req[i];
+      if ((r->state != NEX_GW_FREE) && osal_timer_is_expired(&r->timer))
+      {
+         r->state = NEX_GW_FREE;
+         gw->stat.timeouts++;
+      }
+   }
+   n = 0;
+   bytes = 0;
+   for (k = 0; k < NEX_GW_MAXREQ; k++)
+   {
+      /* start with a different request every call to share the budget */
+      i = (gw->next + k) % NEX_GW_MAXREQ;
+      r = &gw->req[i];
+      if ((r->state != NEX_GW_QUEUED) || nexx_GWwaiting(gw, r))
+      {
+         continue;
+      }
+      sl = &context->slavelist[r->slave];
+      if (n && ((bytes + sl->mbx_l) > maxbytes))
+      {
+         break;
+      }
+      bytes += sl->mbx_l;
+      /* counter of the master towards the slave, kept when the write is repeated */
+      mbxh = (nex_mbxheadert *)&r->mbx;
+      if (!r->mbxcnt)
+      {
+         r->mbxcnt = nex_nextmbxcnt(sl->mbx_cnt);
+         sl->mbx_cnt = r->mbxcnt;
+      }
+      mbxh->address = htoes(0x0000);
+      mbxh->mbxtype = (mbxh->mbxtype & 0x0f) | (r->mbxcnt << 4);
+      r->state = NEX_GW_SENT;
+      sllst[n] = r->slave;
+      lst[n].data = &r->mbx;
+      rli[n++] = i;
+   }
+   gw->next = (gw->next + 1) % NEX_GW_MAXREQ;
+   if (n)
+   {
+      nexx_mbxwrite_multi(context, n, sllst, lst, NEX_TIMEOUTRET3);
+      for (i = 0; i < n; i++)
+      {
+         r = &gw->req[rli[i]];
+         if ((lst[i].wkc > 0) || (lst[i].wkc == NEX_NOFRAME))
+         {
+            /* after a lost frame the request is probably in the slave, wait for
+               the response, the client repeats the request on a timeout */
+            osal_timer_start(&r->timer, gw->timeout);
+            moved++;
+         }
+         else
+         {
+            /* mailbox still full, try again next poll */
+            r->state = NEX_GW_QUEUED;
+         }
+      }
+   }
+   n = 0;
+   for (i = 0; i < NEX_GW_MAXREQ; i++)
+   {
+      r = &gw->req[i];
+      if (r->state == NEX_GW_SENT)
+      {
+         sllst[n] = r->slave;
+         /* request is not needed anymore, response goes to same buffer */
+         nex_clearmbx(&r->mbx);
+         lst[n].data = &r->mbx;
+         rli[n++] = i;
+      }
+   }
+   if (n)
+   {
+      nexx_mbxpoll_multi(context, n, sllst, lst, NEX_TIMEOUTRET3);
+      for (i = 0; i < n; i++)
+      {
+         r = &gw->req[rli[i]];
+         if (lst[i].wkc > 0)
+         {
+            moved++;
+            mbxh = (nex_mbxheadert *)&r->mbx;
+            mbxh->address = htoes(context->slavelist[r->slave].configadr);
+            mbxh->mbxtype = (mbxh->mbxtype & 0x0f) | (r->cnt << 4);
+            size = etohs(mbxh->length) + sizeof(nex_mbxheadert);
+            if (size > context->slavelist[r->slave].mbx_rl)
+            {
+               size = context->slavelist[r->slave].mbx_rl;
+            }
+            r->state = NEX_GW_FREE;
+            gw->stat.responses++;
+            if (gw->hook)
+            {
+               gw->hook(r->client, r->slave, &r->mbx, size);
+            }
+         }
+      }
+   }
+
+   return moved;
+}
+
+#ifdef NEX_VER1
+int nex_GWrequest(nex_GWt *gw, int client, void *mbx, int size)
+{
+   return nexx_GWrequest(&nexx_context, gw, client, mbx, size);
+}
+
+int nex_GWpoll(nex_GWt *gw, int maxbytes)
+{
+   return nexx_GWpoll(&nexx_context, gw, maxbytes);
+}
+#endif
@@ -0,0 +1,101 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Headerfile for ethercatgw.c
+ */
+
+#ifndef _ethercatgw_
+#define _ethercatgw_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** max number of mailbox gateway requests queued, all clients together */
+#define NEX_GW_MAXREQ         32
+/** UDP port of the EtherCAT mailbox gateway */
+#define NEX_GW_UDPPORT        0x88A4
+/** size of EtherCAT header in front of the mailbox in a gateway datagram */
+#define NEX_GW_HEADERSIZE     2
+/** EtherCAT header type of mailbox gateway datagrams */
+#define NEX_GW_TYPE_MBX       5
+
+/** mailbox error details returned by the gateway */
+#define NEX_GW_MBXERR_INVALIDHEADER  0x0005
+#define NEX_GW_MBXERR_NOMOREMEMORY   0x0007
+#define NEX_GW_MBXERR_INVALIDSIZE    0x0008
+
+/** state of gateway request */
+enum
+{
+   NEX_GW_FREE = 0,
+   NEX_GW_QUEUED,
+   NEX_GW_SENT
+};
+
+/** mailbox gateway request of one client */
+typedef struct
+{
+   /** NEX_GW_FREE, NEX_GW_QUEUED or NEX_GW_SENT */
+   uint8      state;
+   /** mailbox counter of the client, returned in the response */
+   uint8      cnt;
+   /** mailbox counter towards the slave, 0 = not sent yet */
+   uint8      mbxcnt;
+   /** slave number */
+   uint16     slave;
+   /** client handle of the caller, passed to the response hook */
+   int        client;
+   /** arrival order, requests to one slave are served in order */
+   uint32     seq;
+   /** response timeout */
+   osal_timert timer;
+   /** request, replaced by the response */
+   nex_mbxbuft mbx;
+} nex_GWrequestt;
+
+/** mailbox gateway statistics */
+typedef struct
+{
+   uint32     requests;
+   uint32     responses;
+   /** requests rejected with a mailbox error */
+   uint32     rejected;
+   /** requests without slave response */
+   uint32     timeouts;
+} nex_GWstatt;
+
+/** mailbox gateway, routes mailbox requests of external clients to slaves */
+typedef struct
+{
+   /** response timeout in us */
+   int        timeout;
+   /** next arrival number */
+   uint32     seq;
+   /** request to write first on next poll */
+   int        next;
+   /** response hook, called for every response and every rejected request */
+   int        (*hook)(int client, uint16 slave, void *mbx, int size);
+   nex_GWrequestt req[NEX_GW_MAXREQ];
+   nex_GWstatt stat;
+} nex_GWt;
+
+#ifdef NEX_VER1
+int nex_GWrequest(nex_GWt *gw, int client, void *mbx, int size);
+int nex_GWpoll(nex_GWt *gw, int maxbytes);
+#endif
+
+void nexx_GWinit(nex_GWt *gw, int timeout, void *hook);
+int nexx_GWrequest(nexx_contextt *context, nex_GWt *gw, int client, void *mbx, int size);
+int nexx_GWpoll(nexx_contextt *context, nex_GWt *gw, int maxbytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
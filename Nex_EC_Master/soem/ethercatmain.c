@@ -22,10 +22,14 @@
 #include "ethercattype.h"
 #include "ethercatbase.h"
 #include "ethercatmain.h"
+#include "ethercatdc.h"
+#include "ethercatsoe.h"
 
 
 /** delay in us for eeprom ready loop */
 #define NEX_LOCALDELAY  200
+/** time in us a mailbox is polled back to back before NEX_LOCALDELAY is used */
+#define NEX_FASTPOLL    2000
 
 /** record for ethercat eeprom communications */
 PACKED_BEGIN
@@ -37,6 +41,13 @@ typedef struct PACKED
 } nex_eepromt;
 PACKED_END
 
+/** modes of nexx_eeprom_multi */
+#define NEX_EEPMULTI_READ    0
+#define NEX_EEPMULTI_WRITE   1
+#define NEX_EEPMULTI_VERIFY  2
+/** slaves per datagram list of nexx_eeprom_multi, bounds its stack use */
+#define NEX_EEPMULTI_CHUNK   64
+
 /** mailbox error structure */
 PACKED_BEGIN
 typedef struct PACKED
@@ -91,6 +102,10 @@ static nex_PDOdesct      nex_PDOdesc[NEX_MAX_MAPT];
 static nex_eepromSMt     nex_SM;
 /** buffer for EEPROM FMMU data */
 static nex_eepromFMMUt   nex_FMMU;
+/** emergency queues, emergencies are also reported in the error list */
+static nex_emcylistt     nex_emcylist = { TRUE, NULL, NULL, 0, {{0}}, {{0}} };
+/** SoE IDN attribute cache */
+static nex_SoEcachet     nex_SoEcache;
 /** Global variable TRUE if error available in error stack */
 boolean                 EcatError = FALSE;
 
@@ -120,7 +135,9 @@ nexx_contextt  nexx_context = {
     &nex_PDOdesc[0],     // .PDOdesc       =
     &nex_SM,             // .eepSM         =
     &nex_FMMU,           // .eepFMMU       =
-    NULL                // .FOEhook()
+    NULL,               // .FOEhook()
+    &nex_emcylist,       // .emcylist      =
+    &nex_SoEcache        // .SoEcache      =
 };
 #endif
 
@@ -251,6 +268,55 @@ static void nexx_mbxerror(nexx_contextt *context, uint16 Slave,uint16 Detail)
    nexx_pusherror(context, &Ec);
 }
 
+/** Store emergency in queue of slave and call matching subscriptions. For
+ * emergencies read outside nexx_mbxreceive and nexx_mbxpoll_multi, they are
+ * not reported in the error list.
+ * @param[in]  context    = context struct
+ * @param[in]  Em         = emergency
+ */
+void nexx_emcy_push(nexx_contextt *context, nex_emcyentryt *Em)
+{
+   nex_emcylistt *el;
+   nex_emcyqueuet *q;
+   nex_emcysubt *sub;
+   uint16 head, next;
+   int i;
+
+   el = context->emcylist;
+   if (!el)
+   {
+      return;
+   }
+   if (Em->Slave < NEX_MAXSLAVE)
+   {
+      q = &el->queue[Em->Slave];
+      head = q->head;
+      next = (head + 1) & (NEX_MAXEMCY - 1);
+      if (next == q->tail)
+      {
+         /* queue full, keep the oldest as they are usually the cause */
+         q->lost++;
+      }
+      else
+      {
+         q->Emcy[head] = *Em;
+         /* entry must be complete before reader sees new head */
+         OSAL_MB();
+         q->head = next;
+      }
+   }
+   for (i = 0; i < el->nsub; i++)
+   {
+      sub = &el->sub[i];
+      if (sub->hook &&
+          (!sub->slave || (sub->slave == Em->Slave)) &&
+          ((Em->ErrorCode & sub->mask) == sub->code))
+      {
+         sub->hook(Em, sub->arg);
+      }
+   }
+}
+
 /** Report Mailbox Emergency Error
  *
  * @param[in]  context        = context struct
@@ -265,6 +331,7 @@ static void nexx_mbxemergencyerror(nexx_contextt *context, uint16 Slave,uint16 E
     uint8 b1, uint16 w1, uint16 w2)
 {
    nex_errort Ec;
+   nex_emcyentryt Em;
 
    memset(&Ec, 0, sizeof(Ec));
    Ec.Time = osal_current_time();
@@ -277,7 +344,21 @@ static void nexx_mbxemergencyerror(nexx_contextt *context, uint16 Slave,uint16 E
    Ec.b1 = b1;
    Ec.w1 = w1;
    Ec.w2 = w2;
-   nexx_pusherror(context, &Ec);
+   if (context->emcylist)
+   {
+      Em.Time = Ec.Time;
+      Em.Slave = Slave;
+      Em.ErrorCode = ErrorCode;
+      Em.ErrorReg = (uint8)ErrorReg;
+      Em.b1 = b1;
+      Em.w1 = w1;
+      Em.w2 = w2;
+      nexx_emcy_push(context, &Em);
+   }
+   if (!context->emcylist || context->emcylist->toelist)
+   {
+      nexx_pusherror(context, &Ec);
+   }
 }
 
 /** Initialise lib in single NIC mode
@@ -1084,6 +1165,474 @@ int nexx_mbxreceive(nexx_contextt *context, uint16 slave, nex_mbxbuft *mbx, int
    return wkc;
 }
 
+/** Write IN mailbox to slave without checking for an empty mailbox first.
+ * Use when the slave is known to have consumed the previous message, f.e. after
+ * it responded to it. A full mailbox ignores the write, then falls back to
+ * nexx_mbxsend.
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number
+ * @param[out] mbx        = Mailbox data
+ * @param[in]  timeout    = Timeout in us
+ * @return Work counter (>0 is success)
+ */
+int nexx_mbxwrite(nexx_contextt *context, uint16 slave, nex_mbxbuft *mbx, int timeout)
+{
+   uint16 mbxl;
+   int wkc;
+
+   wkc = 0;
+   mbxl = context->slavelist[slave].mbx_l;
+   if ((mbxl > 0) && (mbxl <= NEX_MAXMBX))
+   {
+      wkc = nexx_FPWR(context->port, context->slavelist[slave].configadr,
+                      context->slavelist[slave].mbx_wo, mbxl, mbx, NEX_TIMEOUTRET3);
+      if (wkc <= 0)
+      {
+         wkc = nexx_mbxsend(context, slave, mbx, timeout);
+      }
+   }
+
+   return wkc;
+}
+
+/** Read OUT mailbox from slave by polling the mailbox itself.
+ * The slave only acknowledges reads of a full mailbox, so each poll is a single
+ * datagram that returns the message as soon as it is available. Polls back to back
+ * for NEX_FASTPOLL us, then with NEX_LOCALDELAY in between. Mailbox errors and
+ * emergencies are handled and polling continues. Lost frames are recovered with
+ * a repeat request.
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number
+ * @param[out] mbx        = Mailbox data
+ * @param[in]  timeout    = Timeout in us
+ * @return Work counter (>0 is success)
+ */
+int nexx_mbxpoll(nexx_contextt *context, uint16 slave, nex_mbxbuft *mbx, int timeout)
+{
+   uint16 mbxro, mbxl, configadr;
+   int wkc;
+   nex_mbxheadert *mbxh;
+   nex_emcyt *EMp;
+   nex_mbxerrort *MBXEp;
+   osal_timert timer, fasttimer;
+
+   wkc = 0;
+   configadr = context->slavelist[slave].configadr;
+   mbxl = context->slavelist[slave].mbx_rl;
+   mbxro = context->slavelist[slave].mbx_ro;
+   mbxh = (nex_mbxheadert *)mbx;
+   if ((mbxl > 0) && (mbxl <= NEX_MAXMBX))
+   {
+      osal_timer_start(&timer, timeout);
+      osal_timer_start(&fasttimer, NEX_FASTPOLL);
+      do
+      {
+         wkc = nexx_FPRD(context->port, configadr, mbxro, mbxl, mbx, NEX_TIMEOUTRET);
+         if ((wkc > 0) && ((mbxh->mbxtype & 0x0f) == 0x00)) /* Mailbox error response? */
+         {
+            MBXEp = (nex_mbxerrort *)mbx;
+            nexx_mbxerror(context, slave, etohs(MBXEp->Detail));
+            wkc = 0;
+         }
+         else if ((wkc > 0) && ((mbxh->mbxtype & 0x0f) == 0x03)) /* CoE response? */
+         {
+            EMp = (nex_emcyt *)mbx;
+            if ((etohs(EMp->CANOpen) >> 12) == 0x01) /* Emergency request? */
+            {
+               nexx_mbxemergencyerror(context, slave, etohs(EMp->ErrorCode), EMp->ErrorReg,
+                       EMp->bData, etohs(EMp->w1), etohs(EMp->w2));
+               wkc = 0;
+            }
+         }
+         else if (wkc == NEX_NOFRAME)
+         {
+            /* frame lost, if the mailbox was emptied by it ask slave to repeat */
+            nexx_mbxrepeat(context, slave, timeout);
+         }
+         if ((wkc <= 0) && osal_timer_is_expired(&fasttimer) && (timeout > NEX_LOCALDELAY))
+         {
+            osal_usleep(NEX_LOCALDELAY);
+         }
+      }
+      while ((wkc <= 0) && (osal_timer_is_expired(&timer) == FALSE));
+      if (wkc < 0)
+      {
+         wkc = 0;
+      }
+   }
+
+   return wkc;
+}
+
+/** Ask slave to repeat the OUT mailbox after a frame reading it was lost.
+ * Nothing is done if the mailbox is still full, the frame was lost before it
+ * reached the slave.
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number
+ * @param[in]  timeout    = Timeout in us
+ * @return 1 if repeat was acknowledged by the slave, 0 otherwise
+ */
+int nexx_mbxrepeat(nexx_contextt *context, uint16 slave, int timeout)
+{
+   uint16 configadr;
+   uint16 SMstat;
+   uint8 SMcontr;
+   int wkc;
+   osal_timert timer;
+
+   configadr = context->slavelist[slave].configadr;
+   SMstat = 0;
+   wkc = nexx_FPRD(context->port, configadr, ECT_REG_SM1STAT, sizeof(SMstat), &SMstat, NEX_TIMEOUTRET);
+   SMstat = etohs(SMstat);
+   if ((wkc <= 0) || ((SMstat & 0x08) != 0))
+   {
+      return 0;
+   }
+   osal_timer_start(&timer, timeout);
+   SMstat ^= 0x0200; /* toggle repeat request */
+   SMstat = htoes(SMstat);
+   nexx_FPWR(context->port, configadr, ECT_REG_SM1STAT, sizeof(SMstat), &SMstat, NEX_TIMEOUTRET);
+   SMstat = etohs(SMstat);
+   do /* wait for toggle ack */
+   {
+      wkc = nexx_FPRD(context->port, configadr, ECT_REG_SM1CONTR, sizeof(SMcontr), &SMcontr, NEX_TIMEOUTRET);
+   } while (((wkc <= 0) || ((SMcontr & 0x02) != (HI_BYTE(SMstat) & 0x02))) && (osal_timer_is_expired(&timer) == FALSE));
+
+   return ((wkc > 0) && ((SMcontr & 0x02) == (HI_BYTE(SMstat) & 0x02)));
+}
+
+/** Configured address read or write of many slaves. The datagrams are packed
+ * in as few frames as possible, each datagram keeps its own working counter.
+ * @param[in]  context    = context struct
+ * @param[in]  cmd        = NEX_CMD_FPRD, NEX_CMD_FPWR or NEX_CMD_FPRW
+ * @param[in,out] lst     = datagrams, data read is copied to lst[].data
+ * @param[in]  n          = number of datagrams
+ * @param[in]  timeout    = Timeout per frame in us, f.e. NEX_TIMEOUTRET3
+ * @return number of datagrams with working counter > 0
+ */
+int nexx_FP_multi(nexx_contextt *context, uint8 cmd, nex_datagramt *lst, int n, int timeout)
+{
+   nexx_portt *port;
+   nex_datagramt *dp;
+   int sldatapos[MAX_FPRD_MULTI];
+   int first, cnt, size, i, wkc, done;
+   uint8 idx;
+   uint8 *rx;
+
+   port = context->port;
+   done = 0;
+   first = 0;
+   while (first < n)
+   {
+      /* fill frame with as many datagrams as fit */
+      size = lst[first].length;
+      cnt = 1;
+      while (((first + cnt) < n) && (cnt < MAX_FPRD_MULTI) &&
+             ((size + NEX_HEADERSIZE + NEX_WKCSIZE + lst[first + cnt].length) <= NEX_MAXLRWDATA))
+      {
+         size += NEX_HEADERSIZE + NEX_WKCSIZE + lst[first + cnt].length;
+         cnt++;
+      }
+      idx = nexx_getindex(port);
+      dp = &lst[first];
+      nexx_setupdatagram(port, &(port->txbuf[idx]), cmd, idx, dp->configadr, dp->ADO, dp->length, dp->data);
+      sldatapos[0] = NEX_HEADERSIZE;
+      for (i = 1; i < cnt; i++)
+      {
+         dp = &lst[first + i];
+         sldatapos[i] = nexx_adddatagram(port, &(port->txbuf[idx]), cmd, idx, (i < (cnt - 1)),
+                           dp->configadr, dp->ADO, dp->length, dp->data);
+      }
+      wkc = nexx_srconfirm(port, idx, timeout);
+      rx = &(port->rxbuf[idx][0]);
+      for (i = 0; i < cnt; i++)
+      {
+         dp = &lst[first + i];
+         if (wkc < 0)
+         {
+            dp->wkc = NEX_NOFRAME;
+            continue;
+         }
+         /* working counter follows data of each datagram */
+         dp->wkc = rx[sldatapos[i] + dp->length] + (rx[sldatapos[i] + dp->length + 1] << 8);
+         if (dp->wkc > 0)
+         {
+            if (cmd != NEX_CMD_FPWR)
+            {
+               memcpy(dp->data, &rx[sldatapos[i]], dp->length);
+            }
+            done++;
+         }
+      }
+      nexx_setbufstat(port, idx, NEX_BUF_EMPTY);
+      first += cnt;
+   }
+
+   return done;
+}
+
+/** Write IN mailbox of many slaves, packed in as few frames as possible.
+ * A full mailbox ignores the write, its datagram working counter is 0.
+ * @param[in]  context    = context struct
+ * @param[in]  n          = number of slaves
+ * @param[in]  slavelst   = Slave numbers
+ * @param[in,out] lst     = lst[].data points to mailbox of slave, other fields are set here
+ * @param[in]  timeout    = Timeout per frame in us, f.e. NEX_TIMEOUTRET3
+ * @return number of mailboxes written
+ */
+int nexx_mbxwrite_multi(nexx_contextt *context, int n, uint16 *slavelst, nex_datagramt *lst, int timeout)
+{
+   int i;
+
+   for (i = 0; i < n; i++)
+   {
+      lst[i].configadr = context->slavelist[slavelst[i]].configadr;
+      lst[i].ADO = context->slavelist[slavelst[i]].mbx_wo;
+      lst[i].length = context->slavelist[slavelst[i]].mbx_l;
+   }
+
+   return nexx_FP_multi(context, NEX_CMD_FPWR, lst, n, timeout);
+}
+
+/** Read OUT mailbox of many slaves, packed in as few frames as possible.
+ * Empty mailboxes return working counter 0. Mailbox errors and emergencies are
+ * handled and return working counter 0 as well. Slaves whose mailbox was
+ * emptied by a lost frame are asked to repeat it.
+ * @param[in]  context    = context struct
+ * @param[in]  n          = number of slaves
+ * @param[in]  slavelst   = Slave numbers
+ * @param[in,out] lst     = lst[].data points to mailbox buffer, other fields are set here
+ * @param[in]  timeout    = Timeout per frame in us, f.e. NEX_TIMEOUTRET3
+ * @return number of mailboxes read
+ */
+int nexx_mbxpoll_multi(nexx_contextt *context, int n, uint16 *slavelst, nex_datagramt *lst, int timeout)
+{
+   nex_mbxheadert *mbxh;
+   nex_emcyt *EMp;
+   nex_mbxerrort *MBXEp;
+   int i, done;
+
+   for (i = 0; i < n; i++)
+   {
+      lst[i].configadr = context->slavelist[slavelst[i]].configadr;
+      lst[i].ADO = context->slavelist[slavelst[i]].mbx_ro;
+      lst[i].length = context->slavelist[slavelst[i]].mbx_rl;
+   }
+   done = nexx_FP_multi(context, NEX_CMD_FPRD, lst, n, timeout);
+   for (i = 0; i < n; i++)
+   {
+      mbxh = (nex_mbxheadert *)lst[i].data;
+      if (lst[i].wkc == NEX_NOFRAME)
+      {
+         nexx_mbxrepeat(context, slavelst[i], timeout);
+      }
+      else if ((lst[i].wkc > 0) && ((mbxh->mbxtype & 0x0f) == 0x00)) /* Mailbox error response? */
+      {
+         MBXEp = (nex_mbxerrort *)lst[i].data;
+         nexx_mbxerror(context, slavelst[i], etohs(MBXEp->Detail));
+         lst[i].wkc = 0;
+         done--;
+      }
+      else if ((lst[i].wkc > 0) && ((mbxh->mbxtype & 0x0f) == 0x03)) /* CoE response? */
+      {
+         EMp = (nex_emcyt *)lst[i].data;
+         if ((etohs(EMp->CANOpen) >> 12) == 0x01) /* Emergency request? */
+         {
+            nexx_mbxemergencyerror(context, slavelst[i], etohs(EMp->ErrorCode), EMp->ErrorReg,
+                    EMp->bData, etohs(EMp->w1), etohs(EMp->w2));
+            lst[i].wkc = 0;
+            done--;
+         }
+      }
+   }
+
+   return done;
+}
+
+/** Subscribe to CoE emergencies. The hook is called with every matching
+ * emergency from the thread that received it, f.e. in nexx_mbxreceive or
+ * nexx_emcy_harvest. Subscribe before starting mailbox traffic.
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number, 0 = all slaves
+ * @param[in]  mask       = error code bits to compare, 0 = all error codes
+ * @param[in]  code       = error code bits after mask
+ * @param[in]  hook       = void hook(nex_emcyentryt *emcy, void *arg)
+ * @param[in]  arg        = user argument passed to hook
+ * @return handle >0 if successful, 0 if no free subscription
+ */
+int nexx_emcy_subscribe(nexx_contextt *context, uint16 slave, uint16 mask, uint16 code, void *hook, void *arg)
+{
+   nex_emcylistt *el;
+   int i;
+
+   el = context->emcylist;
+   if (!el || !hook)
+   {
+      return 0;
+   }
+   /* reuse freed entry */
+   for (i = 0; i < el->nsub; i++)
+   {
+      if (!el->sub[i].hook)
+      {
+         break;
+      }
+   }
+   if (i >= NEX_MAXEMCYSUB)
+   {
+      return 0;
+   }
+   el->sub[i].slave = slave;
+   el->sub[i].mask = mask;
+   el->sub[i].code = code & mask;
+   el->sub[i].arg = arg;
+   el->sub[i].hook = hook;
+   if (i >= el->nsub)
+   {
+      el->nsub = i + 1;
+   }
+
+   return i + 1;
+}
+
+/** Remove emergency subscription.
+ * @param[in]  context    = context struct
+ * @param[in]  handle     = handle returned by nexx_emcy_subscribe
+ */
+void nexx_emcy_unsubscribe(nexx_contextt *context, int handle)
+{
+   nex_emcylistt *el;
+
+   el = context->emcylist;
+   if (el && (handle > 0) && (handle <= el->nsub))
+   {
+      el->sub[handle - 1].hook = NULL;
+   }
+}
+
+/** Get oldest emergency from queue of slave. Can be called from another
+ * thread than the one doing the mailbox transfers, but only one reader per
+ * slave is allowed.
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number
+ * @param[out] emcy       = emergency
+ * @return TRUE if an emergency was returned
+ */
+boolean nexx_emcy_pop(nexx_contextt *context, uint16 slave, nex_emcyentryt *emcy)
+{
+   nex_emcyqueuet *q;
+   uint16 tail;
+
+   if (!context->emcylist || (slave >= NEX_MAXSLAVE))
+   {
+      return FALSE;
+   }
+   q = &context->emcylist->queue[slave];
+   tail = q->tail;
+   if (tail == q->head)
+   {
+      return FALSE;
+   }
+   /* entry is complete once head is seen */
+   OSAL_MB();
+   *emcy = q->Emcy[tail];
+   /* entry must be copied before writer can reuse it */
+   OSAL_MB();
+   q->tail = (tail + 1) & (NEX_MAXEMCY - 1);
+
+   return TRUE;
+}
+
+/* read SM1 status of n slaves in one frame */
+static int nexx_SM1STAT_multi(nexx_contextt *context, int n, uint16 *configlst, uint8 *SMstatlst, int timeout)
+{
+   int wkc;
+   uint8 idx;
+   nexx_portt *port;
+   int sldatapos[MAX_FPRD_MULTI];
+   int slcnt;
+
+   port = context->port;
+   idx = nexx_getindex(port);
+   slcnt = 0;
+   nexx_setupdatagram(port, &(port->txbuf[idx]), NEX_CMD_FPRD, idx,
+      *(configlst + slcnt), ECT_REG_SM1STAT, sizeof(uint8), SMstatlst + slcnt);
+   sldatapos[slcnt] = NEX_HEADERSIZE;
+   while (++slcnt < n)
+   {
+      sldatapos[slcnt] = nexx_adddatagram(port, &(port->txbuf[idx]), NEX_CMD_FPRD, idx, (slcnt < (n - 1)),
+                            *(configlst + slcnt), ECT_REG_SM1STAT, sizeof(uint8), SMstatlst + slcnt);
+   }
+   wkc = nexx_srconfirm(port, idx, timeout);
+   if (wkc >= 0)
+   {
+      for (slcnt = 0 ; slcnt < n ; slcnt++)
+      {
+         SMstatlst[slcnt] = port->rxbuf[idx][sldatapos[slcnt]];
+      }
+   }
+   nexx_setbufstat(port, idx, NEX_BUF_EMPTY);
+   return wkc;
+}
+
+/** Harvest emergencies. The read mailbox status of all CoE slaves is checked
+ * with one frame per MAX_FPRD_MULTI slaves, full mailboxes are read so
+ * emergencies reach their queues and subscriptions without waiting for the
+ * next SDO transfer. Only call when no mailbox transfer is in progress.
+ * Other mailbox messages read here are passed to the mbxhook of the
+ * emergency list, without a hook they are dropped.
+ * @param[in]  context    = context struct
+ * @param[in]  timeout    = Timeout per frame in us, f.e. NEX_TIMEOUTRET
+ * @return number of mailboxes read
+ */
+int nexx_emcy_harvest(nexx_contextt *context, int timeout)
+{
+   uint16 slave, fslave, n;
+   uint16 slca[MAX_FPRD_MULTI];
+   uint16 sllst[MAX_FPRD_MULTI];
+   uint8 SMstat[MAX_FPRD_MULTI];
+   nex_mbxbuft MbxIn;
+   int i, cnt;
+
+   cnt = 0;
+   fslave = 1;
+   while (fslave <= *(context->slavecount))
+   {
+      n = 0;
+      for (slave = fslave; (slave <= *(context->slavecount)) && (n < MAX_FPRD_MULTI); slave++)
+      {
+         if (context->slavelist[slave].mbx_rl &&
+             (context->slavelist[slave].mbx_proto & ECT_MBXPROT_COE))
+         {
+            slca[n] = context->slavelist[slave].configadr;
+            sllst[n] = slave;
+            SMstat[n] = 0;
+            n++;
+         }
+      }
+      fslave = slave;
+      if (n && (nexx_SM1STAT_multi(context, n, slca, SMstat, timeout) > 0))
+      {
+         for (i = 0; i < n; i++)
+         {
+            if (SMstat[i] & 0x08) /* read mailbox full */
+            {
+               nex_clearmbx(&MbxIn);
+               /* emergencies are handled inside mailbox receive */
+               if ((nexx_mbxreceive(context, sllst[i], &MbxIn, 0) > 0) &&
+                   context->emcylist && context->emcylist->mbxhook)
+               {
+                  context->emcylist->mbxhook(sllst[i], &MbxIn, context->emcylist->mbxarg);
+               }
+               cnt++;
+            }
+         }
+      }
+   }
+
+   return cnt;
+}
+
 /** Dump complete EEPROM data from slave in buffer.
  * @param[in]  context  = context struct
  * @param[in]  slave    = Slave number
@@ -1614,34 +2163,338 @@ uint32 nexx_readeeprom2(nexx_contextt *context, uint16 slave, int timeout)
    return edat;
 }
 
-/** Push index of segmented LRD/LWR/LRW combination.
- * @param[in]  context        = context struct
- * @param[in] idx         = Used datagram index.
- * @param[in] data        = Pointer to process data segment.
- * @param[in] length      = Length of data segment in bytes.
+/** CRC of the SII configuration area, EEPROM words 0 to 6, stored in word 7.
+ * @param[in] buf         = first 14 bytes of EEPROM
+ * @return CRC
  */
-static void nexx_pushindex(nexx_contextt *context, uint8 idx, void *data, uint16 length)
+uint16 nex_siicrc(uint8 *buf)
 {
-   if(context->idxstack->pushed < NEX_MAXBUF)
-   {
-      context->idxstack->idx[context->idxstack->pushed] = idx;
-      context->idxstack->data[context->idxstack->pushed] = data;
-      context->idxstack->length[context->idxstack->pushed] = length;
-      context->idxstack->pushed++;
-   }
-}
+   int i, j;
+   uint8 crc;
 
-/** Pull index of segmented LRD/LWR/LRW combination.
- * @param[in]  context        = context struct
+   crc = 0xff;
+   for (i = 0; i < 14; i++)
+   {
+      crc ^= buf[i];
+      for (j = 0; j < 8; j++)
+      {
+         if (crc & 0x80)
+         {
+            crc = (crc << 1) ^ 0x07;
+         }
+         else
+         {
+            crc = (crc << 1);
+         }
+      }
+   }
+   return (uint16)crc;
+}
+
+/** Bulk EEPROM transfer of many slaves. The slaves are handled in chunks of
+ * NEX_EEPMULTI_CHUNK. Commands are written to all idle slaves of a chunk in
+ * shared frames, then the status of all busy slaves of the chunk is read in
+ * shared frames, together with the data registers when reading. A slave gets
+ * its next command as soon as its EEPROM is ready, independent of the other
+ * slaves.
+ * @param[in]  context    = context struct
+ * @param[in]  n          = number of slaves, max NEX_MAXSLAVE
+ * @param[in,out] lst     = slaves, buffers and results
+ * @param[in]  start      = first EEPROM word
+ * @param[in]  words      = number of words
+ * @param[in]  mode       = NEX_EEPMULTI_READ, NEX_EEPMULTI_WRITE or NEX_EEPMULTI_VERIFY
+ * @param[in]  timeout    = Timeout per word in us, standard is NEX_TIMEOUTEEP
+ * @return number of slaves that succeeded
+ */
+static int nexx_eeprom_multi(nexx_contextt *context, int n, nex_eeprombulkt *lst, uint16 start,
+                             uint16 words, int mode, int timeout)
+{
+   nex_datagramt dg[NEX_EEPMULTI_CHUNK * 3];
+   int sli[NEX_EEPMULTI_CHUNK * 3];
+   nex_eeprombulkt *l;
+   nex_eepromt *ed;
+   uint16 estat;
+   int i, m, k, first, last, active, ready, bytes, ok;
+
+   active = 0;
+   for (i = 0; i < n; i++)
+   {
+      l = &lst[i];
+      /* slaves that failed to write are not verified */
+      if ((mode == NEX_EEPMULTI_VERIFY) && (l->result < 0))
+      {
+         continue;
+      }
+      l->result = 0;
+      l->done = 0;
+      l->busy = 0;
+      l->retry = 0;
+      l->clear = 0;
+      if (!words)
+      {
+         l->result = 1;
+         continue;
+      }
+      nexx_eeprom2master(context, l->slave);
+      osal_timer_start(&l->timer, timeout);
+      active++;
+   }
+   while (active)
+   {
+      ready = 0;
+      for (first = 0; first < n; first += NEX_EEPMULTI_CHUNK)
+      {
+         last = ((n - first) > NEX_EEPMULTI_CHUNK) ? (first + NEX_EEPMULTI_CHUNK) : n;
+         /* write command to all slaves waiting for one */
+         m = 0;
+         for (i = first; i < last; i++)
+         {
+            l = &lst[i];
+            if ((l->result != 0) || l->busy)
+            {
+               continue;
+            }
+            if (l->clear)
+            {
+               /* clear error bits */
+               ed = (nex_eepromt *)l->clr;
+               ed->comm = htoes(NEX_ECMD_NOP);
+               dg[m].configadr = context->slavelist[l->slave].configadr;
+               dg[m].ADO = ECT_REG_EEPCTL;
+               dg[m].length = sizeof(ed->comm);
+               dg[m].data = l->clr;
+               sli[m++] = -1;
+            }
+            if (mode == NEX_EEPMULTI_WRITE)
+            {
+               memcpy(l->dat, &l->buf[l->done * 2], sizeof(l->dat));
+               dg[m].configadr = context->slavelist[l->slave].configadr;
+               dg[m].ADO = ECT_REG_EEPDAT;
+               dg[m].length = sizeof(l->dat);
+               dg[m].data = l->dat;
+               sli[m++] = -1;
+            }
+            ed = (nex_eepromt *)l->cmd;
+            ed->comm = htoes((mode == NEX_EEPMULTI_WRITE) ? NEX_ECMD_WRITE : NEX_ECMD_READ);
+            ed->addr = htoes(start + l->done);
+            ed->d2 = 0x0000;
+            dg[m].configadr = context->slavelist[l->slave].configadr;
+            dg[m].ADO = ECT_REG_EEPCTL;
+            dg[m].length = sizeof(nex_eepromt);
+            dg[m].data = l->cmd;
+            sli[m++] = i;
+         }
+         if (m)
+         {
+            nexx_FP_multi(context, NEX_CMD_FPWR, dg, m, NEX_TIMEOUTRET3);
+            ok = TRUE;
+            for (k = 0; k < m; k++)
+            {
+               if (sli[k] < 0)
+               {
+                  /* error clear or data write, command follows in the same list */
+                  ok = ok && (dg[k].wkc > 0);
+                  continue;
+               }
+               l = &lst[sli[k]];
+               if (dg[k].wkc > 0)
+               {
+                  l->busy = 1;
+                  l->clear = 0;
+                  /* command without its data, repeat the word once it is done */
+                  l->redo = !ok;
+               }
+               ok = TRUE;
+            }
+         }
+         /* read status of all busy slaves, with data registers when reading */
+         bytes = (mode == NEX_EEPMULTI_WRITE) ? 2 : sizeof(lst->reg);
+         m = 0;
+         for (i = first; i < last; i++)
+         {
+            l = &lst[i];
+            if ((l->result == 0) && l->busy)
+            {
+               dg[m].configadr = context->slavelist[l->slave].configadr;
+               dg[m].ADO = ECT_REG_EEPSTAT;
+               dg[m].length = (uint16)bytes;
+               dg[m].data = l->reg;
+               sli[m++] = i;
+            }
+         }
+         if (m)
+         {
+            nexx_FP_multi(context, NEX_CMD_FPRD, dg, m, NEX_TIMEOUTRET3);
+         }
+         for (k = 0; k < m; k++)
+         {
+            l = &lst[sli[k]];
+            estat = l->reg[0] + (l->reg[1] << 8);
+            if ((dg[k].wkc <= 0) || (estat & NEX_ESTAT_BUSY))
+            {
+               continue;
+            }
+            ready++;
+            l->busy = 0;
+            if (estat & NEX_ESTAT_EMASK) /* error bits are set, f.e. NACK */
+            {
+               l->clear = 1;
+               if (++l->retry > NEX_DEFAULTRETRIES)
+               {
+                  l->result = -1;
+                  active--;
+               }
+               continue;
+            }
+            l->retry = 0;
+            if (mode == NEX_EEPMULTI_WRITE)
+            {
+               if (!l->redo)
+               {
+                  l->done++;
+               }
+            }
+            else
+            {
+               /* 4 or 8 bytes data are returned by one read command */
+               bytes = (estat & NEX_ESTAT_R64) ? 8 : 4;
+               if (bytes > ((words - l->done) * 2))
+               {
+                  bytes = (words - l->done) * 2;
+               }
+               if (mode == NEX_EEPMULTI_READ)
+               {
+                  memcpy(&l->buf[l->done * 2], &l->reg[ECT_REG_EEPDAT - ECT_REG_EEPSTAT], bytes);
+               }
+               else if (memcmp(&l->buf[l->done * 2], &l->reg[ECT_REG_EEPDAT - ECT_REG_EEPSTAT], bytes))
+               {
+                  l->result = -2;
+                  active--;
+                  continue;
+               }
+               l->done += (uint16)(bytes / 2);
+            }
+            if (l->done >= words)
+            {
+               l->result = 1;
+               active--;
+            }
+            else
+            {
+               osal_timer_start(&l->timer, timeout);
+            }
+         }
+      }
+      for (i = 0; i < n; i++)
+      {
+         l = &lst[i];
+         if ((l->result == 0) && osal_timer_is_expired(&l->timer))
+         {
+            l->result = -1;
+            active--;
+         }
+      }
+      /* EEPROM writes take milliseconds, do not flood the segment with polls */
+      if (active && !ready && (mode == NEX_EEPMULTI_WRITE))
+      {
+         osal_usleep(NEX_LOCALDELAY);
+      }
+   }
+   m = 0;
+   for (i = 0; i < n; i++)
+   {
+      if (lst[i].result > 0)
+      {
+         m++;
+      }
+   }
+
+   return m;
+}
+
+/** Read EEPROM words of many slaves at once, bypassing the cache. Read commands
+ * and status polls of all slaves share frames, see nexx_eeprom_multi.
+ * @param[in]  context    = context struct
+ * @param[in]  n          = number of slaves, max NEX_MAXSLAVE
+ * @param[in,out] lst     = lst[].slave and lst[].buf of words * 2 bytes, returns lst[].result
+ * @param[in]  start      = first EEPROM word
+ * @param[in]  words      = number of words
+ * @param[in]  timeout    = Timeout per word in us, standard is NEX_TIMEOUTEEP
+ * @return number of slaves read completely
+ */
+int nexx_readeeprom_multi(nexx_contextt *context, int n, nex_eeprombulkt *lst, uint16 start, uint16 words, int timeout)
+{
+   return nexx_eeprom_multi(context, n, lst, start, words, NEX_EEPMULTI_READ, timeout);
+}
+
+/** Write EEPROM words of many slaves at once. Write commands and status polls
+ * of all slaves share frames, see nexx_eeprom_multi. If the data covers words 0
+ * to 7 the checksum in word 7 is recalculated in the buffer first. With verify
+ * the written words are read back and compared.
+ * @param[in]  context    = context struct
+ * @param[in]  n          = number of slaves, max NEX_MAXSLAVE
+ * @param[in,out] lst     = lst[].slave and lst[].buf of words * 2 bytes, returns lst[].result,
+ *                          1 = OK, -1 = EEPROM error or no response, -2 = verify failed
+ * @param[in]  start      = first EEPROM word
+ * @param[in]  words      = number of words
+ * @param[in]  verify     = TRUE to read back and compare, slaves that fail get result -2
+ * @param[in]  timeout    = Timeout per word in us, standard is NEX_TIMEOUTEEP
+ * @return number of slaves written completely
+ */
+int nexx_writeeeprom_multi(nexx_contextt *context, int n, nex_eeprombulkt *lst, uint16 start, uint16 words,
+                           boolean verify, int timeout)
+{
+   uint16 crc;
+   int i, done;
+
+   if ((start == 0) && (words >= 8))
+   {
+      for (i = 0; i < n; i++)
+      {
+         crc = nex_siicrc(lst[i].buf);
+         lst[i].buf[14] = LO_BYTE(crc);
+         lst[i].buf[15] = HI_BYTE(crc);
+      }
+   }
+   done = nexx_eeprom_multi(context, n, lst, start, words, NEX_EEPMULTI_WRITE, timeout);
+   if (verify && done)
+   {
+      done = nexx_eeprom_multi(context, n, lst, start, words, NEX_EEPMULTI_VERIFY, timeout);
+   }
+
+   return done;
+}
+
+/** Push index of segmented LRD/LWR/LRW combination.
+ * @param[in]  idxstack       = processdata stack of the group
+ * @param[in] idx         = Used datagram index.
+ * @param[in] data        = Pointer to process data segment.
+ * @param[in] length      = Length of data segment in bytes.
+ * @param[in] dataoffset  = Offset of the datagram data in the frame.
+ */
+static void nexx_pushindex(nex_idxstackT *idxstack, uint8 idx, void *data, uint16 length, uint16 dataoffset)
+{
+   if(idxstack->pushed < NEX_MAXBUF)
+   {
+      idxstack->idx[idxstack->pushed] = idx;
+      idxstack->data[idxstack->pushed] = data;
+      idxstack->length[idxstack->pushed] = length;
+      idxstack->dataoffset[idxstack->pushed] = dataoffset;
+      idxstack->pushed++;
+   }
+}
+
+/** Pull index of segmented LRD/LWR/LRW combination.
+ * @param[in]  idxstack       = processdata stack of the group
  * @return Stack location, -1 if stack is empty.
  */
-static int nexx_pullindex(nexx_contextt *context)
+static int nexx_pullindex(nex_idxstackT *idxstack)
 {
    int rval = -1;
-   if(context->idxstack->pulled < context->idxstack->pushed)
+   if(idxstack->pulled < idxstack->pushed)
    {
-      rval = context->idxstack->pulled;
-      context->idxstack->pulled++;
+      rval = idxstack->pulled;
+      idxstack->pulled++;
    }
 
    return rval;
@@ -1650,22 +2503,612 @@ static int nexx_pullindex(nexx_contextt *context)
 /** 
  * Clear the idx stack.
  * 
- * @param context           = context struct
+ * @param idxstack          = processdata stack of the group
+ */
+static void nexx_clearindex(nex_idxstackT *idxstack)  {
+
+   idxstack->pushed = 0;
+   idxstack->pulled = 0;
+
+}
+
+/** Get a frame index for processdata of a group. A group with an index
+ * partition takes the next free index of its own range without a lock, the
+ * partition is only used by the thread that runs the cycle of the group.
+ * Other groups use the shared indexes of the port.
+ * @param[in]  context        = context struct
+ * @param[in]  grp            = group
+ * @return new index.
+ */
+static int nexx_getgroupindex(nexx_contextt *context, nex_groupt *grp)
+{
+   int idx, cnt;
+
+   if (!grp->idxcount)
+   {
+      return nexx_getindex(context->port);
+   }
+   idx = grp->idxnext;
+   cnt = 0;
+   /* like nexx_getindex the next index is used if all are busy */
+   while ((context->port->rxbufstat[idx] != NEX_BUF_EMPTY) && (cnt < grp->idxcount))
+   {
+      idx++;
+      cnt++;
+      if (idx >= (grp->idxfirst + grp->idxcount))
+      {
+         idx = grp->idxfirst;
+      }
+   }
+   grp->idxnext = (uint8)(((idx + 1) < (grp->idxfirst + grp->idxcount)) ? (idx + 1) : grp->idxfirst);
+   nexx_setbufstat(context->port, idx, NEX_BUF_ALLOC);
+
+   return idx;
+}
+
+/** Release a frame index of processdata of a group. An index of a partition
+ * stays owned by the group, see nexx_config_groupindex.
+ * @param[in]  context        = context struct
+ * @param[in]  idx            = index to release
+ */
+static void nexx_releasegroupindex(nexx_contextt *context, int idx)
+{
+   nexx_setbufstat(context->port, idx, NEX_BUF_EMPTY);
+}
+
+/** Store the DC time read by the processdata of a group. A group with an
+ * index partition can cycle in a thread of its own, its DC time is only kept
+ * in the group so groups do not overwrite each other.
+ * @param[in]  context        = context struct
+ * @param[in]  grp            = group
+ * @param[in]  le_DCtime      = DC time as read from the frame
+ */
+static void nexx_setgroupdctime(nexx_contextt *context, nex_groupt *grp, int64 le_DCtime)
+{
+   grp->DCtime = etohll(le_DCtime);
+   if (!grp->idxcount)
+   {
+      *(context->DCtime) = grp->DCtime;
+   }
+}
+
+/** Give a group its own range of frame indexes. The processdata of the group
+ * then uses its own stack and indexes only, so the cycles of different groups
+ * can run in their own threads on the same port. A returning frame is put in
+ * the buffer of its index by whichever thread reads it. Call after
+ * nexx_config_init and before the cycles start, with at least the number of segments of the
+ * group plus one for a retransmit. Leave indexes for mailbox and other
+ * traffic, at least one index stays shared. The DC time of the group is then
+ * only kept in the DCtime of the group, not in the DCtime of the context.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  first          = first index of the range
+ * @param[in]  count          = number of indexes, 0 to return them to the shared indexes
+ * @return 1 if OK, 0 if the range is out of the buffers, overlaps the range
+ * of another group, leaves no shared index or is in use
+ */
+int nexx_config_groupindex(nexx_contextt *context, uint8 group, uint8 first, uint8 count)
+{
+   nex_groupt *grp = &context->grouplist[group];
+   int idx, g, reserved;
+
+   if (count)
+   {
+      if ((first + count) > NEX_MAXBUF)
+      {
+         return 0;
+      }
+      reserved = count;
+      for (g = 0; g < context->maxgroup; g++)
+      {
+         if ((g != group) && context->grouplist[g].idxcount)
+         {
+            if ((first < (context->grouplist[g].idxfirst + context->grouplist[g].idxcount)) &&
+                (context->grouplist[g].idxfirst < (first + count)))
+            {
+               return 0;
+            }
+            reserved += context->grouplist[g].idxcount;
+         }
+      }
+      /* nexx_getindex needs an index that is not reserved */
+      if (reserved >= NEX_MAXBUF)
+      {
+         return 0;
+      }
+      for (idx = first; idx < (first + count); idx++)
+      {
+         if (context->port->rxbufstat[idx] != NEX_BUF_EMPTY)
+         {
+            return 0;
+         }
+      }
+   }
+   /* the new range is valid, a rejected call keeps the old one */
+   for (idx = grp->idxfirst; idx < (grp->idxfirst + grp->idxcount); idx++)
+   {
+      context->port->idxreserved[idx] = FALSE;
+   }
+   grp->idxcount = 0;
+   for (idx = first; idx < (first + count); idx++)
+   {
+      context->port->idxreserved[idx] = TRUE;
+   }
+   grp->idxfirst = first;
+   grp->idxnext = first;
+   grp->idxcount = count;
+
+   return 1;
+}
+
+/** Time since the last processdata send of a group.
+ * @param[in]  grp            = group
+ * @return Time in us.
+ */
+static int32 nexx_since_send(nex_groupt *grp)
+{
+   nex_timet now, diff;
+
+   now = osal_current_time();
+   osal_time_diff(&(grp->rtsendtime), &now, &diff);
+   return (int32)((diff.sec * 1000000) + diff.usec);
+}
+
+/** Add a round trip time to the smoothed round trip time and deviation of a
+ * segment of a group, with gains 1/8 and 1/4.
+ * @param[in]  grp            = group
+ * @param[in]  pos            = stack location of the segment
+ * @param[in]  rtt            = measured time from the send of the group until the
+ *                              segment came back in us
+ */
+static void nexx_rtt_update(nex_groupt *grp, int pos, int32 rtt)
+{
+   int32 err;
+
+   if (!grp->rtsrtt[pos])
+   {
+      grp->rtsrtt[pos] = rtt;
+      grp->rtrttvar[pos] = rtt / 2;
+   }
+   else
+   {
+      err = rtt - grp->rtsrtt[pos];
+      grp->rtsrtt[pos] += err / 8;
+      if (err < 0)
+      {
+         err = -err;
+      }
+      grp->rtrttvar[pos] += (err - grp->rtrttvar[pos]) / 4;
+   }
+   if (grp->rtsrtt[pos] < 1)
+   {
+      grp->rtsrtt[pos] = 1;
+   }
+}
+
+/** Read the frames waiting in the receive queue until the frame with index
+ * idx is among them, so a frame that is only held up behind others is not
+ * taken as lost. Every receive call takes at most one frame off the queue
+ * and no more frames than indexes can be in flight.
+ * @param[in]  port           = port context struct
+ * @param[in]  idx            = index of the frame
+ * @return Work counter or NEX_NOFRAME.
+ */
+static int nexx_drainframes(nexx_portt *port, int idx)
+{
+   int wkc, i;
+
+   wkc = NEX_NOFRAME;
+   for (i = 0; (i < NEX_MAXBUF) && (wkc <= NEX_NOFRAME); i++)
+   {
+      wkc = nexx_waitinframe(port, idx, 0);
+   }
+
+   return wkc;
+}
+
+/** Add the DC datagrams to the first processdata frame of a group. The FRMW
+ * reads the system time of the reference clock. A pending bus shift steering
+ * write follows it if the frame has room, stamped with the host clock now.
+ * @param[in]  context        = context struct
+ * @param[in]  grp            = group
+ * @param[in]  idx            = index of the frame
+ * @return Offset to data of the last datagram added in rx frame.
+ */
+static uint16 nexx_adddcdatagram(nexx_contextt *context, nex_groupt *grp, uint8 idx)
+{
+   nexx_portt *port = context->port;
+   nex_dcbusshiftt *bs = grp->busshift;
+   int64 t;
+
+   grp->DCwO = 0;
+   if (bs && bs->writepending &&
+       ((port->txbuflength[idx] - NEX_ELENGTHSIZE + NEX_FIRSTDCDATAGRAM * 2) <= (ETH_HEADERSIZE + NEX_MAXLRWDATA)))
+   {
+      grp->DCtO = (uint16)nexx_adddatagram(port, &(port->txbuf[idx]), NEX_CMD_FRMW, idx, TRUE,
+                                           context->slavelist[grp->DCnext].configadr,
+                                           ECT_REG_DCSYSTIME, sizeof(int64), &(grp->DCtime));
+      t = nexx_dcbusshift_writetime(bs);
+      grp->DCwO = (uint16)nexx_adddatagram(port, &(port->txbuf[idx]), NEX_CMD_FPWR, idx, FALSE,
+                                           context->slavelist[bs->refslave].configadr,
+                                           ECT_REG_DCSYSTIME, sizeof(t), &t);
+      bs->writepending = FALSE;
+      bs->written = 0;
+      return grp->DCwO;
+   }
+   grp->DCtO = (uint16)nexx_adddatagram(port, &(port->txbuf[idx]), NEX_CMD_FRMW, idx, FALSE,
+                                        context->slavelist[grp->DCnext].configadr,
+                                        ECT_REG_DCSYSTIME, sizeof(int64), &(grp->DCtime));
+   return grp->DCtO;
+}
+
+/** Read the workcounter of the bus shift steering write of a received frame.
+ * @param[in]  context        = context struct
+ * @param[in]  grp            = group
+ * @param[in]  idx            = index of the first processdata frame
+ */
+static void nexx_dcwritewkc(nexx_contextt *context, nex_groupt *grp, int idx)
+{
+   uint16 le_wkc;
+
+   if (grp->DCwO)
+   {
+      memcpy(&le_wkc, &(context->port->rxbuf[idx][grp->DCwO + sizeof(int64)]), NEX_WKCSIZE);
+      grp->busshift->written = etohs(le_wkc);
+   }
+}
+
+/** Send a copy of a transmitted frame with a fresh index. A bus shift
+ * steering write in the copy gets a new stamp of the host clock.
+ * @param[in]  context        = context struct
+ * @param[in]  grp            = group
+ * @param[in]  idx            = index of the transmitted frame
+ * @return Index of the copy.
+ */
+static int nexx_resendframe(nexx_contextt *context, nex_groupt *grp, int idx)
+{
+   nexx_portt *port = context->port;
+   nex_comt *datagramP;
+   uint16 dlength;
+   int idx2, offset;
+   int64 t;
+
+   idx2 = nexx_getgroupindex(context, grp);
+   memcpy(&(port->txbuf[idx2]), &(port->txbuf[idx]), port->txbuflength[idx]);
+   port->txbuflength[idx2] = port->txbuflength[idx];
+   if (grp->DCwO && (idx == grp->idxstack.idx[0]))
+   {
+      t = nexx_dcbusshift_writetime(grp->busshift);
+      memcpy(&(port->txbuf[idx2][ETH_HEADERSIZE + grp->DCwO]), &t, sizeof(t));
+   }
+   /* every datagram in the frame carries the index */
+   offset = ETH_HEADERSIZE;
+   do
+   {
+      datagramP = (nex_comt *)&(port->txbuf[idx2][offset]);
+      datagramP->index = (uint8)idx2;
+      dlength = etohs(datagramP->dlength);
+      offset += NEX_HEADERSIZE + (dlength & 0x07ff);
+   } while (dlength & NEX_DATAGRAMFOLLOWS);
+   nexx_outframe_red(port, idx2);
+
+   return idx2;
+}
+
+/** Wait for the frame of a processdata segment. With retransmission enabled
+ * the frame is due back the smoothed arrival time of its stack location plus
+ * four deviations after the send of the group, so later segments of the
+ * cycle get their own deadline. When it is overdue the frames already in the
+ * receive queue are read first. If it is still missing and the budget of the
+ * group leaves room for another round trip, the segment is sent once more
+ * with a fresh index and the copy is waited for. The stack then holds the
+ * index of the frame that returned for every datagram of the frame, the
+ * other buffer is released.
+ * @param[in]  context        = context struct
+ * @param[in]  grp            = group
+ * @param[in]  pos            = stack location of the segment
+ * @param[in]  timeout        = Timeout in us.
+ * @param[in,out] resent      = incremented if the segment was sent again
+ * @param[out] failed         = incremented if the segment was also lost again
+ * @return Work counter or NEX_NOFRAME.
+ */
+static int nexx_waitsegment(nexx_contextt *context, nex_groupt *grp, int pos, int timeout, int *resent,
+                            int *failed)
+{
+   nexx_portt *port = context->port;
+   int idx, idx2, wkc, i;
+   int32 due, elapsed, wait, left, rtt;
+
+   idx = grp->idxstack.idx[pos];
+   if (!grp->rtbudget)
+   {
+      return nexx_waitinframe(port, idx, timeout);
+   }
+   /* no arrival time measured yet, half of the budget */
+   due = grp->rtsrtt[pos] ? (grp->rtsrtt[pos] + (4 * grp->rtrttvar[pos])) : (grp->rtbudget / 2);
+   if (due < NEX_TIMEOUTRETX)
+   {
+      due = NEX_TIMEOUTRETX;
+   }
+   wait = due - nexx_since_send(grp);
+   if (wait < 0)
+   {
+      wait = 0;
+   }
+   if (wait > timeout)
+   {
+      wait = timeout;
+   }
+   wkc = nexx_waitinframe(port, idx, wait);
+   if (wkc <= NEX_NOFRAME)
+   {
+      wkc = nexx_drainframes(port, idx);
+   }
+   if (wkc > NEX_NOFRAME)
+   {
+      /* arrival after a retransmit in this cycle says little about this location */
+      if (!*resent)
+      {
+         nexx_rtt_update(grp, pos, nexx_since_send(grp));
+      }
+      return wkc;
+   }
+   elapsed = nexx_since_send(grp);
+   /* a copy needs about the time the first segment of the cycle takes */
+   rtt = grp->rtsrtt[0] ? (grp->rtsrtt[0] + (4 * grp->rtrttvar[0])) : due;
+   if ((elapsed + rtt) > grp->rtbudget)
+   {
+      /* no time for another round trip, wait out the timeout */
+      grp->rtstat.skipped++;
+      return nexx_waitinframe(port, idx, timeout - wait);
+   }
+   idx2 = nexx_resendframe(context, grp, idx);
+   grp->rtstat.frames++;
+   (*resent)++;
+   left = grp->rtbudget - elapsed;
+   wkc = nexx_waitinframe(port, idx2, left);
+   if (wkc <= NEX_NOFRAME)
+   {
+      wkc = nexx_drainframes(port, idx2);
+   }
+   if (wkc > NEX_NOFRAME)
+   {
+      nexx_releasegroupindex(context, idx);
+      for (i = pos; (i < grp->idxstack.pushed) && (grp->idxstack.idx[i] == idx); i++)
+      {
+         grp->idxstack.idx[i] = (uint8)idx2;
+      }
+      return wkc;
+   }
+   /* the first frame may have come in late */
+   nexx_releasegroupindex(context, idx2);
+   wkc = nexx_drainframes(port, idx);
+   if (wkc <= NEX_NOFRAME)
+   {
+      grp->rtstat.failed++;
+      (*failed)++;
+   }
+
+   return wkc;
+}
+
+/** Count a received cycle in the retransmission statistics of a group.
+ * @param[in]  grp            = group
+ * @param[in]  resent         = segments sent again in this cycle
+ * @param[in]  failed         = segments sent again and lost again
+ */
+static void nexx_retransmit_count(nex_groupt *grp, int resent, int failed)
+{
+   grp->rtstat.cycles++;
+   if (resent)
+   {
+      grp->rtstat.attempted++;
+      if (!failed)
+      {
+         grp->rtstat.recovered++;
+      }
+   }
+}
+
+/** Enable in-cycle retransmission of lost processdata frames of a group.
+ * The receive expects every segment back within the round trip time measured
+ * in the previous cycles. A segment that is overdue is sent once more with a
+ * fresh index if the budget leaves time for another round trip, so a lost
+ * frame costs a round trip instead of the I/O of the cycle. The copy writes
+ * the same outputs again and reads the inputs and DC time again. Cycles with
+ * a retransmit are counted in rtstat of the group.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  budget         = us after the send by which the receive must be done
+ *                              with a retransmit, 0 to disable
+ */
+void nexx_config_retransmit(nexx_contextt *context, uint8 group, int32 budget)
+{
+   nex_groupt *grp = &context->grouplist[group];
+
+   grp->rtbudget = (budget > 0) ? budget : 0;
+   memset(grp->rtsrtt, 0, sizeof(grp->rtsrtt));
+   memset(grp->rtrttvar, 0, sizeof(grp->rtrttvar));
+   grp->rtsendtime = osal_current_time();
+   memset(&(grp->rtstat), 0, sizeof(grp->rtstat));
+}
+
+#if defined(_MSC_VER)
+#define NEX_PDINLINE __forceinline
+#else
+#define NEX_PDINLINE inline __attribute__((always_inline))
+#endif
+
+/** Transmit processdata of a group that uses LRW in one segment. The booleans
+ * are constant in every caller, so each caller is compiled to its own
+ * straight-line path.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  dc             = add FRMW of DC time to the datagram
+ * @param[in]  overlap        = overlapping IOmap
+ * @return 1
+ */
+static NEX_PDINLINE int nexx_send_lrw(nexx_contextt *context, uint8 group, const boolean dc, const boolean overlap)
+{
+   nex_groupt *grp = &context->grouplist[group];
+   nexx_portt *port = context->port;
+   uint32 LogAdr;
+   int sublength;
+   uint8 *data;
+   uint8 idx;
+
+   LogAdr = grp->logstartaddr;
+   data = grp->outputs;
+   sublength = grp->IOsegment[0];
+   idx = nexx_getgroupindex(context, grp);
+   nexx_setupdatagram(port, &(port->txbuf[idx]), NEX_CMD_LRW, idx, LO_WORD(LogAdr), HI_WORD(LogAdr), sublength, data);
+   if (dc)
+   {
+      grp->DCl = sublength;
+      nexx_adddcdatagram(context, grp, idx);
+   }
+   nexx_outframe_red(port, idx);
+   nexx_pushindex(&(grp->idxstack), idx, overlap ? (data + grp->Obytes) : data, sublength, NEX_HEADERSIZE);
+
+   return 1;
+}
+
+/** Receive processdata of a group sent by nexx_send_lrw, one LRW datagram
+ * and the DC time if the group has DC.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  timeout        = Timeout in us.
+ * @param[in]  dc             = datagram is followed by FRMW of DC time
+ * @return Work counter.
+ */
+static NEX_PDINLINE int nexx_receive_lrw(nexx_contextt *context, uint8 group, int timeout, const boolean dc)
+{
+   nexx_portt *port = context->port;
+   nex_groupt *grp = &context->grouplist[group];
+   nex_idxstackT *stack = &(grp->idxstack);
+   int idx, wkc;
+   int resent = 0, failed = 0;
+   uint16 le_wkc;
+   int64 le_DCtime;
+
+   wkc = nexx_waitsegment(context, grp, 0, timeout, &resent, &failed);
+   idx = stack->idx[0];
+   if (wkc > NEX_NOFRAME)
+   {
+      memcpy(stack->data[0], &(port->rxbuf[idx][NEX_HEADERSIZE]), stack->length[0]);
+      if (dc)
+      {
+         memcpy(&le_wkc, &(port->rxbuf[idx][NEX_HEADERSIZE + grp->DCl]), NEX_WKCSIZE);
+         wkc = etohs(le_wkc);
+         memcpy(&le_DCtime, &(port->rxbuf[idx][grp->DCtO]), sizeof(le_DCtime));
+         nexx_setgroupdctime(context, grp, le_DCtime);
+         nexx_dcwritewkc(context, grp, idx);
+      }
+   }
+   else
+   {
+      wkc = NEX_NOFRAME;
+   }
+   nexx_releasegroupindex(context, idx);
+   nexx_clearindex(&(grp->idxstack));
+   if (grp->rtbudget)
+   {
+      nexx_retransmit_count(grp, resent, failed);
+   }
+
+   return wkc;
+}
+
+static int nexx_send_lrw_plain(nexx_contextt *context, uint8 group)
+{
+   return nexx_send_lrw(context, group, FALSE, FALSE);
+}
+
+static int nexx_send_lrw_dc(nexx_contextt *context, uint8 group)
+{
+   return nexx_send_lrw(context, group, TRUE, FALSE);
+}
+
+static int nexx_send_lrw_overlap(nexx_contextt *context, uint8 group)
+{
+   return nexx_send_lrw(context, group, FALSE, TRUE);
+}
+
+static int nexx_send_lrw_dc_overlap(nexx_contextt *context, uint8 group)
+{
+   return nexx_send_lrw(context, group, TRUE, TRUE);
+}
+
+static int nexx_receive_lrw_plain(nexx_contextt *context, uint8 group, int timeout)
+{
+   return nexx_receive_lrw(context, group, timeout, FALSE);
+}
+
+static int nexx_receive_lrw_dc(nexx_contextt *context, uint8 group, int timeout)
+{
+   return nexx_receive_lrw(context, group, timeout, TRUE);
+}
+
+/** Set the follows flag of a datagram in a frame, before another datagram is
+ * added behind it.
+ * @param[in]  port           = port context struct
+ * @param[in]  idx            = index of the frame
+ * @param[in]  dataoffset     = offset of the datagram data, as in the rx frame
  */
-static void nexx_clearindex(nexx_contextt *context)  {
+static void nexx_datagramfollows(nexx_portt *port, uint8 idx, uint16 dataoffset)
+{
+   nex_comt *datagramP;
 
-   context->idxstack->pushed = 0;
-   context->idxstack->pulled = 0;
+   datagramP = (nex_comt *)&(port->txbuf[idx][ETH_HEADERSIZE + dataoffset - NEX_HEADERSIZE]);
+   datagramP->dlength = htoes(etohs(datagramP->dlength) | NEX_DATAGRAMFOLLOWS);
+}
 
+/** Select the processdata paths of a group. Groups that use LRW with outputs
+ * in a single segment get a send and receive path specialized for DC and the
+ * overlapping IOmap, without per datagram tests. Other groups use the generic
+ * path, which also puts several segments in one frame where they fit. Called
+ * when mapping and again when hasdc or the overlap mode changes. Call it after
+ * changing blockLRW or the segments by hand.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  overlap        = TRUE for nexx_send_overlap_processdata_group
+ */
+void nexx_select_processdata(nexx_contextt *context, uint8 group, boolean overlap)
+{
+   static int (* const sendpath[4])(nexx_contextt *context, uint8 group) =
+   {
+      nexx_send_lrw_plain, nexx_send_lrw_dc, nexx_send_lrw_overlap, nexx_send_lrw_dc_overlap
+   };
+   static int (* const receivepath[2])(nexx_contextt *context, uint8 group, int timeout) =
+   {
+      nexx_receive_lrw_plain, nexx_receive_lrw_dc
+   };
+   nex_groupt *grp = &context->grouplist[group];
+   int path;
+
+   grp->pdsend = NULL;
+   grp->pdreceive = NULL;
+   grp->pdhasdc = grp->hasdc;
+   grp->pdoverlap = overlap;
+   grp->pdvalid = TRUE;
+   /* a segment of slaves with blockLRW or several segments need the generic path */
+   if (!grp->blockLRW && grp->Obytes && (grp->nsegments == 1) && !grp->IOsegmentcmd[0])
+   {
+      path = grp->hasdc ? 1 : 0;
+      grp->pdsend = sendpath[path + (overlap ? 2 : 0)];
+      grp->pdreceive = receivepath[path];
+   }
 }
 
 /** Transmit processdata to slaves.
- * Uses LRW, or LRD/LWR if LRW is not allowed (blockLRW).
+ * Uses LRW, with LWR/LRD for the segments of slaves that block LRW (blockLRW).
+ * LRD/LWR for all slaves if blockLRW of the group is set.
  * Both the input and output processdata are transmitted.
  * The outputs with the actual data, the inputs have a placeholder.
  * The inputs are gathered with the receive processdata function.
  * In contrast to the base LRW function this function is non-blocking.
- * If the processdata does not fit in one datagram, multiple are used.
+ * If the processdata does not fit in one datagram, multiple are used. A
+ * datagram is added to the frame before it if the frame has room for it.
  * In order to recombine the slave response, a stack is used.
  * @param[in]  context        = context struct
  * @param[in]  group          = group number
@@ -1676,13 +3119,30 @@ static int nexx_main_send_processdata(nexx_contextt *context, uint8 group, boole
    uint32 LogAdr;
    uint16 w1, w2;
    int length, sublength;
-   uint8 idx;
+   uint8 idx = 0;
    int wkc;
    uint8* data;
    boolean first=FALSE;
    uint16 currentsegment = 0;
    uint32 iomapinputoffset;
+   uint16 dataoffset, lastoffset = 0;
+   uint8 cmd;
+   boolean opened;
+   nexx_portt *port = context->port;
+   nex_groupt *grp = &context->grouplist[group];
 
+   if (!grp->pdvalid || (grp->pdhasdc != grp->hasdc) || (grp->pdoverlap != use_overlap_io))
+   {
+      nexx_select_processdata(context, group, use_overlap_io);
+   }
+   if (grp->rtbudget)
+   {
+      grp->rtsendtime = osal_current_time();
+   }
+   if (grp->pdsend)
+   {
+      return grp->pdsend(context, group);
+   }
    wkc = 0;
    if(context->grouplist[group].hasdc)
    {
@@ -1731,23 +3191,21 @@ static int nexx_main_send_processdata(nexx_contextt *context, uint8 group, boole
                   sublength = context->grouplist[group].IOsegment[currentsegment++];
                }
                /* get new index */
-               idx = nexx_getindex(context->port);
+               idx = nexx_getgroupindex(context, grp);
                w1 = LO_WORD(LogAdr);
                w2 = HI_WORD(LogAdr);
                nexx_setupdatagram(context->port, &(context->port->txbuf[idx]), NEX_CMD_LRD, idx, w1, w2, sublength, data);
                if(first)
                {
-                  context->DCl = sublength;
+                  grp->DCl = sublength;
                   /* FPRMW in second datagram */
-                  context->DCtO = nexx_adddatagram(context->port, &(context->port->txbuf[idx]), NEX_CMD_FRMW, idx, FALSE,
-                                           context->slavelist[context->grouplist[group].DCnext].configadr,
-                                           ECT_REG_DCSYSTIME, sizeof(int64), context->DCtime);
+                  nexx_adddcdatagram(context, grp, idx);
                   first = FALSE;
                }
                /* send frame */
                nexx_outframe_red(context->port, idx);
                /* push index and data pointer on stack */
-               nexx_pushindex(context, idx, data, sublength);
+               nexx_pushindex(&(grp->idxstack), idx, data, sublength, NEX_HEADERSIZE);
                length -= sublength;
                LogAdr += sublength;
                data += sublength;
@@ -1769,30 +3227,28 @@ static int nexx_main_send_processdata(nexx_contextt *context, uint8 group, boole
                   sublength = length;
                }
                /* get new index */
-               idx = nexx_getindex(context->port);
+               idx = nexx_getgroupindex(context, grp);
                w1 = LO_WORD(LogAdr);
                w2 = HI_WORD(LogAdr);
                nexx_setupdatagram(context->port, &(context->port->txbuf[idx]), NEX_CMD_LWR, idx, w1, w2, sublength, data);
                if(first)
                {
-                  context->DCl = sublength;
+                  grp->DCl = sublength;
                   /* FPRMW in second datagram */
-                  context->DCtO = nexx_adddatagram(context->port, &(context->port->txbuf[idx]), NEX_CMD_FRMW, idx, FALSE,
-                                           context->slavelist[context->grouplist[group].DCnext].configadr,
-                                           ECT_REG_DCSYSTIME, sizeof(int64), context->DCtime);
+                  nexx_adddcdatagram(context, grp, idx);
                   first = FALSE;
                }
                /* send frame */
                nexx_outframe_red(context->port, idx);
                /* push index and data pointer on stack */
-               nexx_pushindex(context, idx, data, sublength);
+               nexx_pushindex(&(grp->idxstack), idx, data, sublength, NEX_HEADERSIZE);
                length -= sublength;
                LogAdr += sublength;
                data += sublength;
             } while (length && (currentsegment < context->grouplist[group].nsegments));
          }
       }
-      /* LRW can be used */
+      /* LRW can be used, LWR and LRD only for the segments of slaves with blockLRW */
       else
       {
          if (context->grouplist[group].Obytes)
@@ -1805,36 +3261,59 @@ static int nexx_main_send_processdata(nexx_contextt *context, uint8 group, boole
             /* Clear offset, don't compensate for overlapping IOmap if we only got inputs */
             iomapinputoffset = 0;
          }
+         opened = FALSE;
          /* segment transfer if needed */
          do
          {
-            sublength = context->grouplist[group].IOsegment[currentsegment++];
-            /* get new index */
-            idx = nexx_getindex(context->port);
+            sublength = context->grouplist[group].IOsegment[currentsegment];
+            cmd = context->grouplist[group].IOsegmentcmd[currentsegment++];
+            if (!cmd)
+            {
+               cmd = NEX_CMD_LRW;
+            }
             w1 = LO_WORD(LogAdr);
             w2 = HI_WORD(LogAdr);
-            nexx_setupdatagram(context->port, &(context->port->txbuf[idx]), NEX_CMD_LRW, idx, w1, w2, sublength, data);
-            if(first)
+            /* add datagram to the open frame if it fits */
+            if (opened && ((port->txbuflength[idx] - NEX_ELENGTHSIZE + sublength) <= (ETH_HEADERSIZE + NEX_MAXLRWDATA)))
+            {
+               nexx_datagramfollows(port, idx, lastoffset);
+               dataoffset = nexx_adddatagram(port, &(port->txbuf[idx]), cmd, idx, FALSE, w1, w2, sublength, data);
+               lastoffset = dataoffset;
+            }
+            else
             {
-               context->DCl = sublength;
-               /* FPRMW in second datagram */
-               context->DCtO = nexx_adddatagram(context->port, &(context->port->txbuf[idx]), NEX_CMD_FRMW, idx, FALSE,
-                                        context->slavelist[context->grouplist[group].DCnext].configadr,
-                                        ECT_REG_DCSYSTIME, sizeof(int64), context->DCtime);
-               first = FALSE;
+               if (opened)
+               {
+                  /* send frame */
+                  nexx_outframe_red(port, idx);
+               }
+               /* get new index */
+               idx = nexx_getgroupindex(context, grp);
+               nexx_setupdatagram(port, &(port->txbuf[idx]), cmd, idx, w1, w2, sublength, data);
+               dataoffset = NEX_HEADERSIZE;
+               lastoffset = dataoffset;
+               if(first)
+               {
+                  grp->DCl = sublength;
+                  /* FPRMW in second datagram */
+                  lastoffset = nexx_adddcdatagram(context, grp, idx);
+                  first = FALSE;
+               }
+               opened = TRUE;
             }
-            /* send frame */
-            nexx_outframe_red(context->port, idx);
             /* push index and data pointer on stack.
              * the iomapinputoffset compensate for where the inputs are stored 
              * in the IOmap if we use an overlapping IOmap. If a regular IOmap
              * is used it should always be 0.
              */
-            nexx_pushindex(context, idx, (data + iomapinputoffset), sublength);      
+            nexx_pushindex(&(grp->idxstack), idx, (cmd == NEX_CMD_LWR) ? data : (data + iomapinputoffset),
+                           sublength, dataoffset);
             length -= sublength;
             LogAdr += sublength;
             data += sublength;
          } while (length && (currentsegment < context->grouplist[group].nsegments));
+         /* send last frame */
+         nexx_outframe_red(port, idx);
       }
    }
 
@@ -1842,7 +3321,7 @@ static int nexx_main_send_processdata(nexx_contextt *context, uint8 group, boole
 }
 
 /** Transmit processdata to slaves.
-* Uses LRW, or LRD/LWR if LRW is not allowed (blockLRW).
+* Uses LRW, with LWR/LRD for the segments of slaves that block LRW (blockLRW).
 * Both the input and output processdata are transmitted in the overlapped IOmap.
 * The outputs with the actual data, the inputs replace the output data in the
 * returning frame. The inputs are gathered with the receive processdata function.
@@ -1859,7 +3338,7 @@ int nexx_send_overlap_processdata_group(nexx_contextt *context, uint8 group)
 }
 
 /** Transmit processdata to slaves.
-* Uses LRW, or LRD/LWR if LRW is not allowed (blockLRW).
+* Uses LRW, with LWR/LRD for the segments of slaves that block LRW (blockLRW).
 * Both the input and output processdata are transmitted.
 * The outputs with the actual data, the inputs have a placeholder.
 * The inputs are gathered with the receive processdata function.
@@ -1879,6 +3358,8 @@ int nexx_send_processdata_group(nexx_contextt *context, uint8 group)
  * Second part from nex_send_processdata().
  * Received datagrams are recombined with the processdata with help from the stack.
  * If a datagram contains input processdata it copies it to the processdata structure.
+ * A frame can hold more than one datagram, the work counter of every datagram
+ * is taken from the datagram itself.
  * @param[in]  context        = context struct
  * @param[in]  group          = group number
  * @param[in]  timeout        = Timeout in us.
@@ -1886,72 +3367,72 @@ int nexx_send_processdata_group(nexx_contextt *context, uint8 group)
  */
 int nexx_receive_processdata_group(nexx_contextt *context, uint8 group, int timeout)
 {
-   int pos, idx;
-   int wkc = 0, wkc2;
+   int pos, idx, offset;
+   int wkc = 0, wkc2 = NEX_NOFRAME;
    uint16 le_wkc = 0;
    int valid_wkc = 0;
    int64 le_DCtime;
-   boolean first = FALSE;
+   int resent = 0, failed = 0;
+   uint8 cmd;
+   nex_groupt *grp = &context->grouplist[group];
 
-   if(context->grouplist[group].hasdc)
+   /* path of the last send, if that was specialized */
+   if (grp->pdreceive && (grp->pdhasdc == grp->hasdc) && (grp->idxstack.pushed > 0))
    {
-      first = TRUE;
+      return grp->pdreceive(context, group, timeout);
    }
    /* get first index */
-   pos = nexx_pullindex(context);
+   pos = nexx_pullindex(&(grp->idxstack));
    /* read the same number of frames as send */
    while (pos >= 0)
    {
-      idx = context->idxstack->idx[pos];
-      wkc2 = nexx_waitinframe(context->port, context->idxstack->idx[pos], timeout);
+      /* wait once for every frame */
+      if ((pos == 0) || (grp->idxstack.idx[pos - 1] != grp->idxstack.idx[pos]))
+      {
+         wkc2 = nexx_waitsegment(context, grp, pos, timeout, &resent, &failed);
+      }
+      idx = grp->idxstack.idx[pos];
       /* check if there is input data in frame */
       if (wkc2 > NEX_NOFRAME)
       {
-         if((context->port->rxbuf[idx][NEX_CMDOFFSET]==NEX_CMD_LRD) || (context->port->rxbuf[idx][NEX_CMDOFFSET]==NEX_CMD_LRW))
+         offset = grp->idxstack.dataoffset[pos];
+         cmd = context->port->rxbuf[idx][offset - NEX_HEADERSIZE + NEX_CMDOFFSET];
+         memcpy(&le_wkc, &(context->port->rxbuf[idx][offset + grp->idxstack.length[pos]]), NEX_WKCSIZE);
+         if((cmd == NEX_CMD_LRD) || (cmd == NEX_CMD_LRW))
          {
-            if(first)
-            {
-               memcpy(context->idxstack->data[pos], &(context->port->rxbuf[idx][NEX_HEADERSIZE]), context->DCl);
-               memcpy(&le_wkc, &(context->port->rxbuf[idx][NEX_HEADERSIZE + context->DCl]), NEX_WKCSIZE);
-               wkc = etohs(le_wkc);
-               memcpy(&le_DCtime, &(context->port->rxbuf[idx][context->DCtO]), sizeof(le_DCtime));
-               *(context->DCtime) = etohll(le_DCtime);
-               first = FALSE;
-            }
-            else
-            {
-               /* copy input data back to process data buffer */
-               memcpy(context->idxstack->data[pos], &(context->port->rxbuf[idx][NEX_HEADERSIZE]), context->idxstack->length[pos]);
-               wkc += wkc2;
-            }
+            /* copy input data back to process data buffer */
+            memcpy(grp->idxstack.data[pos], &(context->port->rxbuf[idx][offset]), grp->idxstack.length[pos]);
+            wkc += etohs(le_wkc);
             valid_wkc = 1;
          }
-         else if(context->port->rxbuf[idx][NEX_CMDOFFSET]==NEX_CMD_LWR)
+         else if(cmd == NEX_CMD_LWR)
          {
-            if(first)
-            {
-               memcpy(&le_wkc, &(context->port->rxbuf[idx][NEX_HEADERSIZE + context->DCl]), NEX_WKCSIZE);
-               /* output WKC counts 2 times when using LRW, emulate the same for LWR */
-               wkc = etohs(le_wkc) * 2;
-               memcpy(&le_DCtime, &(context->port->rxbuf[idx][context->DCtO]), sizeof(le_DCtime));
-               *(context->DCtime) = etohll(le_DCtime);
-               first = FALSE;
-            }
-            else
-            {
-               /* output WKC counts 2 times when using LRW, emulate the same for LWR */
-               wkc += wkc2 * 2;
-            }
+            /* output WKC counts 2 times when using LRW, emulate the same for LWR */
+            wkc += etohs(le_wkc) * 2;
             valid_wkc = 1;
          }
+         /* FRMW of DC time is in the first frame */
+         if(context->grouplist[group].hasdc && (pos == 0))
+         {
+            memcpy(&le_DCtime, &(context->port->rxbuf[idx][grp->DCtO]), sizeof(le_DCtime));
+            nexx_setgroupdctime(context, grp, le_DCtime);
+            nexx_dcwritewkc(context, grp, idx);
+         }
       }
-      /* release buffer */
-      nexx_setbufstat(context->port, idx, NEX_BUF_EMPTY);
       /* get next index */
-      pos = nexx_pullindex(context);
+      pos = nexx_pullindex(&(grp->idxstack));
+      /* release buffer after the last datagram of the frame */
+      if ((pos < 0) || (grp->idxstack.idx[pos] != idx))
+      {
+         nexx_releasegroupindex(context, idx);
+      }
    }
 
-   nexx_clearindex(context);
+   nexx_clearindex(&(grp->idxstack));
+   if (grp->rtbudget)
+   {
+      nexx_retransmit_count(grp, resent, failed);
+   }
 
    /* if no frames has arrived */
    if (valid_wkc == 0)
@@ -2177,6 +3658,124 @@ int nex_mbxreceive(uint16 slave, nex_mbxbuft *mbx, int timeout)
    return nexx_mbxreceive (&nexx_context, slave, mbx, timeout);
 }
 
+/** Write IN mailbox to slave without checking for an empty mailbox first.
+ * @param[in]  slave      = Slave number
+ * @param[out] mbx        = Mailbox data
+ * @param[in]  timeout    = Timeout in us
+ * @return Work counter (>0 is success)
+ * @see nexx_mbxwrite
+ */
+int nex_mbxwrite(uint16 slave, nex_mbxbuft *mbx, int timeout)
+{
+   return nexx_mbxwrite (&nexx_context, slave, mbx, timeout);
+}
+
+/** Read OUT mailbox from slave by polling the mailbox itself.
+ * @param[in]  slave      = Slave number
+ * @param[out] mbx        = Mailbox data
+ * @param[in]  timeout    = Timeout in us
+ * @return Work counter (>0 is success)
+ * @see nexx_mbxpoll
+ */
+int nex_mbxpoll(uint16 slave, nex_mbxbuft *mbx, int timeout)
+{
+   return nexx_mbxpoll (&nexx_context, slave, mbx, timeout);
+}
+
+/** Ask slave to repeat the OUT mailbox after a frame reading it was lost.
+ * @param[in]  slave      = Slave number
+ * @param[in]  timeout    = Timeout in us
+ * @return 1 if repeat was acknowledged by the slave, 0 otherwise
+ * @see nexx_mbxrepeat
+ */
+int nex_mbxrepeat(uint16 slave, int timeout)
+{
+   return nexx_mbxrepeat (&nexx_context, slave, timeout);
+}
+
+/** Configured address read or write of many slaves.
+ * @param[in]  cmd        = NEX_CMD_FPRD, NEX_CMD_FPWR or NEX_CMD_FPRW
+ * @param[in,out] lst     = datagrams, data read is copied to lst[].data
+ * @param[in]  n          = number of datagrams
+ * @param[in]  timeout    = Timeout per frame in us, f.e. NEX_TIMEOUTRET3
+ * @return number of datagrams with working counter > 0
+ * @see nexx_FP_multi
+ */
+int nex_FP_multi(uint8 cmd, nex_datagramt *lst, int n, int timeout)
+{
+   return nexx_FP_multi (&nexx_context, cmd, lst, n, timeout);
+}
+
+/** Write IN mailbox of many slaves.
+ * @param[in]  n          = number of slaves
+ * @param[in]  slavelst   = Slave numbers
+ * @param[in,out] lst     = lst[].data points to mailbox of slave
+ * @param[in]  timeout    = Timeout per frame in us
+ * @return number of mailboxes written
+ * @see nexx_mbxwrite_multi
+ */
+int nex_mbxwrite_multi(int n, uint16 *slavelst, nex_datagramt *lst, int timeout)
+{
+   return nexx_mbxwrite_multi (&nexx_context, n, slavelst, lst, timeout);
+}
+
+/** Read OUT mailbox of many slaves.
+ * @param[in]  n          = number of slaves
+ * @param[in]  slavelst   = Slave numbers
+ * @param[in,out] lst     = lst[].data points to mailbox buffer
+ * @param[in]  timeout    = Timeout per frame in us
+ * @return number of mailboxes read
+ * @see nexx_mbxpoll_multi
+ */
+int nex_mbxpoll_multi(int n, uint16 *slavelst, nex_datagramt *lst, int timeout)
+{
+   return nexx_mbxpoll_multi (&nexx_context, n, slavelst, lst, timeout);
+}
+
+/** Subscribe to CoE emergencies.
+ * @param[in]  slave      = Slave number, 0 = all slaves
+ * @param[in]  mask       = error code bits to compare, 0 = all error codes
+ * @param[in]  code       = error code bits after mask
+ * @param[in]  hook       = void hook(nex_emcyentryt *emcy, void *arg)
+ * @param[in]  arg        = user argument passed to hook
+ * @return handle >0 if successful, 0 if no free subscription
+ * @see nexx_emcy_subscribe
+ */
+int nex_emcy_subscribe(uint16 slave, uint16 mask, uint16 code, void *hook, void *arg)
+{
+   return nexx_emcy_subscribe (&nexx_context, slave, mask, code, hook, arg);
+}
+
+/** Remove emergency subscription.
+ * @param[in]  handle     = handle returned by nex_emcy_subscribe
+ * @see nexx_emcy_unsubscribe
+ */
+void nex_emcy_unsubscribe(int handle)
+{
+   nexx_emcy_unsubscribe (&nexx_context, handle);
+}
+
+/** Get oldest emergency from queue of slave.
+ * @param[in]  slave      = Slave number
+ * @param[out] emcy       = emergency
+ * @return TRUE if an emergency was returned
+ * @see nexx_emcy_pop
+ */
+boolean nex_emcy_pop(uint16 slave, nex_emcyentryt *emcy)
+{
+   return nexx_emcy_pop (&nexx_context, slave, emcy);
+}
+
+/** Harvest emergencies from all full read mailboxes.
+ * @param[in]  timeout    = Timeout per frame in us, f.e. NEX_TIMEOUTRET
+ * @return number of mailboxes read
+ * @see nexx_emcy_harvest
+ */
+int nex_emcy_harvest(int timeout)
+{
+   return nexx_emcy_harvest (&nexx_context, timeout);
+}
+
 /** Dump complete EEPROM data from slave in buffer.
  * @param[in]  slave    = Slave number
  * @param[out] esibuf   = EEPROM data buffer, make sure it is big enough.
@@ -2309,8 +3908,37 @@ uint32 nex_readeeprom2(uint16 slave, int timeout)
    return nexx_readeeprom2 (&nexx_context, slave, timeout);
 }
 
+/** Read EEPROM words of many slaves at once, bypassing the cache.
+ * @param[in]  n          = number of slaves, max NEX_MAXSLAVE
+ * @param[in,out] lst     = lst[].slave and lst[].buf of words * 2 bytes, returns lst[].result
+ * @param[in]  start      = first EEPROM word
+ * @param[in]  words      = number of words
+ * @param[in]  timeout    = Timeout per word in us, standard is NEX_TIMEOUTEEP
+ * @return number of slaves read completely
+ * @see nexx_readeeprom_multi
+ */
+int nex_readeeprom_multi(int n, nex_eeprombulkt *lst, uint16 start, uint16 words, int timeout)
+{
+   return nexx_readeeprom_multi(&nexx_context, n, lst, start, words, timeout);
+}
+
+/** Write EEPROM words of many slaves at once.
+ * @param[in]  n          = number of slaves, max NEX_MAXSLAVE
+ * @param[in,out] lst     = lst[].slave and lst[].buf of words * 2 bytes, returns lst[].result
+ * @param[in]  start      = first EEPROM word
+ * @param[in]  words      = number of words
+ * @param[in]  verify     = TRUE to read back and compare
+ * @param[in]  timeout    = Timeout per word in us, standard is NEX_TIMEOUTEEP
+ * @return number of slaves written completely
+ * @see nexx_writeeeprom_multi
+ */
+int nex_writeeeprom_multi(int n, nex_eeprombulkt *lst, uint16 start, uint16 words, boolean verify, int timeout)
+{
+   return nexx_writeeeprom_multi(&nexx_context, n, lst, start, words, verify, timeout);
+}
+
 /** Transmit processdata to slaves.
- * Uses LRW, or LRD/LWR if LRW is not allowed (blockLRW).
+ * Uses LRW, with LWR/LRD for the segments of slaves that block LRW (blockLRW).
  * Both the input and output processdata are transmitted.
  * The outputs with the actual data, the inputs have a placeholder.
  * The inputs are gathered with the receive processdata function.
@@ -2327,7 +3955,7 @@ int nex_send_processdata_group(uint8 group)
 }
 
 /** Transmit processdata to slaves.
-* Uses LRW, or LRD/LWR if LRW is not allowed (blockLRW).
+* Uses LRW, with LWR/LRD for the segments of slaves that block LRW (blockLRW).
 * Both the input and output processdata are transmitted in the overlapped IOmap.
 * The outputs with the actual data, the inputs replace the output data in the
 * returning frame. The inputs are gathered with the receive processdata function.
@@ -2344,6 +3972,39 @@ int nex_send_overlap_processdata_group(uint8 group)
    return nexx_send_overlap_processdata_group(&nexx_context, group);
 }
 
+/** Select the processdata paths of a group.
+ * @param[in]  group          = group number
+ * @param[in]  overlap        = TRUE for nex_send_overlap_processdata_group
+ * @see nexx_select_processdata
+ */
+void nex_select_processdata(uint8 group, boolean overlap)
+{
+   nexx_select_processdata(&nexx_context, group, overlap);
+}
+
+/** Enable in-cycle retransmission of lost processdata frames of a group.
+ * @param[in]  group          = group number
+ * @param[in]  budget         = us after the send by which the receive must be done
+ *                              with a retransmit, 0 to disable
+ * @see nexx_config_retransmit
+ */
+void nex_config_retransmit(uint8 group, int32 budget)
+{
+   nexx_config_retransmit(&nexx_context, group, budget);
+}
+
+/** Give a group its own range of frame indexes.
+ * @param[in]  group          = group number
+ * @param[in]  first          = first index of the range
+ * @param[in]  count          = number of indexes, 0 to return them to the shared indexes
+ * @return 1 if OK
+ * @see nexx_config_groupindex
+ */
+int nex_config_groupindex(uint8 group, uint8 first, uint8 count)
+{
+   return nexx_config_groupindex(&nexx_context, group, first, count);
+}
+
 /** Receive processdata from slaves.
  * Second part from nex_send_processdata().
  * Received datagrams are recombined with the processdata with help from the stack.
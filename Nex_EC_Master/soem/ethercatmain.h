@@ -19,12 +19,18 @@ extern "C"
 
 /** max. entries in EtherCAT error list */
 #define NEX_MAXELIST       64
+/** max. length of readable error string of error list */
+#define NEX_MAXESTRING     256
 /** max. length of readable name in slavelist and Object Description List */
 #define NEX_MAXNAME        40
-/** max. number of slaves in array */
+/** max. number of slaves in array, may be set at build time */
+#ifndef NEX_MAXSLAVE
 #define NEX_MAXSLAVE       200
-/** max. number of groups */
+#endif
+/** max. number of groups, may be set at build time */
+#ifndef NEX_MAXGROUP
 #define NEX_MAXGROUP       2
+#endif
 /** max. number of IO segments per group */
 #define NEX_MAXIOSEGMENTS  64
 /** max. mailbox size */
@@ -100,6 +106,8 @@ PACKED_END
 
 #define NEX_SMENABLEMASK      0xfffeffff
 
+struct nexx_context;
+
 /** for list of ethercat slaves detected */
 typedef struct nex_slave
 {
@@ -117,6 +125,10 @@ typedef struct nex_slave
    uint32           eep_id;
    /** revision from EEprom */
    uint32           eep_rev;
+   /** first slave with the same manufacturer, ID and revision, 0 if none before */
+   uint16           sameid;
+   /** next slave with the same manufacturer, ID and revision, 0 if none */
+   uint16           nextid;
    /** Interface type */
    uint16           Itype;
    /** Device type */
@@ -179,6 +191,12 @@ typedef struct nex_slave
    uint8            parentport;
    /** port number on this slave the parent is connected to **/
    uint8            entryport;
+   /** first child in the topology tree, 0 if none */
+   uint16           child;
+   /** next child of the same parent, 0 if none */
+   uint16           sibling;
+   /** number of slaves between this slave and the master */
+   uint16           depth;
    /** DC receivetimes on port A */
    int32            DCrtA;
    /** DC receivetimes on port B */
@@ -227,10 +245,41 @@ typedef struct nex_slave
    boolean          islost;
    /** registered configuration function PO->SO */
    int              (*PO2SOconfig)(uint16 slave);
+   /** registered configuration function PO->SO with context, called after PO2SOconfig */
+   int              (*PO2SOconfigx)(struct nexx_context *context, uint16 slave);
    /** readable name */
    char             name[NEX_MAXNAME + 1];
 } nex_slavet;
 
+/** stack structure to store segmented LRD/LWR/LRW constructs */
+typedef struct nex_idxstack
+{
+   uint8   pushed;
+   uint8   pulled;
+   uint8   idx[NEX_MAXBUF];
+   void    *data[NEX_MAXBUF];
+   uint16  length[NEX_MAXBUF];
+   /** offset of the datagram data in the frame, frames can hold more than one */
+   uint16  dataoffset[NEX_MAXBUF];
+} nex_idxstackT;
+
+/** statistics of in-cycle retransmission of process data frames */
+typedef struct
+{
+   /** cycles received with retransmission enabled */
+   uint32           cycles;
+   /** cycles with at least one segment retransmitted */
+   uint32           attempted;
+   /** cycles in which every retransmitted segment returned */
+   uint32           recovered;
+   /** segments retransmitted */
+   uint32           frames;
+   /** segments lost even after the retransmit */
+   uint32           failed;
+   /** overdue segments not retransmitted, too little budget left */
+   uint32           skipped;
+} nex_retransmitstatt;
+
 /** for list of ethercat slave groups */
 typedef struct nex_group
 {
@@ -250,7 +299,8 @@ typedef struct nex_group
    uint16           DCnext;
    /** E-bus current */
    int16            Ebuscurrent;
-   /** if >0 block use of LRW in processdata */
+   /** if >0 block use of LRW in processdata of the whole group, set by mapping
+    * only if the slaves with blockLRW could not get segments of their own */
    uint8            blockLRW;
    /** IO segegments used */
    uint16           nsegments;
@@ -266,6 +316,41 @@ typedef struct nex_group
    boolean          docheckstate;
    /** IO segmentation list. Datagrams must not break SM in two. */
    uint32           IOsegment[NEX_MAXIOSEGMENTS];
+   /** command of each IO segment, 0 for LRW, NEX_CMD_LWR for outputs and
+    * NEX_CMD_LRD for inputs of slaves with blockLRW */
+   uint8            IOsegmentcmd[NEX_MAXIOSEGMENTS];
+   /** process data paths specialized for this mapping, NULL for the generic path */
+   int              (*pdsend)(struct nexx_context *context, uint8 group);
+   int              (*pdreceive)(struct nexx_context *context, uint8 group, int timeout);
+   /** hasdc and overlap the paths were selected for */
+   boolean          pdvalid;
+   boolean          pdhasdc;
+   boolean          pdoverlap;
+   /** us after the send until which a lost segment may be sent again, 0 = off */
+   int32            rtbudget;
+   /** smoothed time from the send until each stack location is back and its
+    * mean deviation in us */
+   int32            rtsrtt[NEX_MAXBUF];
+   int32            rtrttvar[NEX_MAXBUF];
+   /** time of the last send */
+   nex_timet        rtsendtime;
+   nex_retransmitstatt rtstat;
+   /** processdata stack of this group */
+   nex_idxstackT    idxstack;
+   /** frame indexes owned by this group, idxcount = 0 to use the shared indexes */
+   uint8            idxfirst;
+   uint8            idxcount;
+   uint8            idxnext;
+   /** DC system time of the reference slave read by the last processdata cycle */
+   int64            DCtime;
+   /** position of DC datagram in process data packet */
+   uint16           DCtO;
+   /** length of DC datagram */
+   uint16           DCl;
+   /** position of DC steering write in process data packet, 0 = none */
+   uint16           DCwO;
+   /** bus shift state of the reference clock in this group, NULL = none */
+   struct nex_dcbusshift *busshift;
 } nex_groupt;
 
 /** SII FMMU structure */
@@ -328,15 +413,49 @@ typedef struct PACKED nex_alstatus
 } nex_alstatust;
 PACKED_END
 
-/** stack structure to store segmented LRD/LWR/LRW constructs */
-typedef struct nex_idxstack
+/** one datagram of a transfer to many configured slaves, see nexx_FP_multi */
+typedef struct nex_datagram
 {
-   uint8   pushed;
-   uint8   pulled;
-   uint8   idx[NEX_MAXBUF];
-   void    *data[NEX_MAXBUF];
-   uint16  length[NEX_MAXBUF];
-} nex_idxstackT;
+   /** configured station address */
+   uint16  configadr;
+   /** register or memory address in slave */
+   uint16  ADO;
+   /** length of data */
+   uint16  length;
+   /** data to write, or buffer for data read */
+   void    *data;
+   /** working counter of datagram, NEX_NOFRAME if its frame was lost */
+   int     wkc;
+} nex_datagramt;
+
+/** bulk EEPROM transfer of one slave, see nexx_readeeprom_multi */
+typedef struct nex_eeprombulk
+{
+   /** slave number */
+   uint16  slave;
+   /** data of the transferred words, 2 bytes per word */
+   uint8   *buf;
+   /** 0 = running, 1 = OK, -1 = EEPROM error or no response, -2 = verify failed */
+   int     result;
+   /** words transferred */
+   uint16  done;
+   /** internal, command written and EEPROM busy */
+   uint8   busy;
+   /** internal, command went out without its data, repeat word */
+   uint8   redo;
+   /** internal, error bits must be cleared before next command */
+   uint8   clear;
+   /** internal, retries of current word */
+   uint8   retry;
+   /** internal, timeout of current word */
+   osal_timert timer;
+   /** internal, command, data and error clear written to slave */
+   uint8   cmd[6];
+   uint8   dat[2];
+   uint8   clr[2];
+   /** internal, status, address and data registers read from slave */
+   uint8   reg[14];
+} nex_eeprombulkt;
 
 /** ringbuf for error storage */
 typedef struct nex_ering
@@ -344,6 +463,8 @@ typedef struct nex_ering
    int16     head;
    int16     tail;
    nex_errort Error[NEX_MAXELIST + 1];
+   /** text of last error taken by nexx_elist2string */
+   char      estring[NEX_MAXESTRING];
 } nex_eringt;
 
 /** SyncManager Communication Type structure for CA */
@@ -376,6 +497,73 @@ typedef struct PACKED nex_PDOdesc
 } nex_PDOdesct;
 PACKED_END
 
+/** max number of queued emergencies per slave, must be a power of 2 */
+#define NEX_MAXEMCY        8
+/** max number of emergency subscriptions */
+#define NEX_MAXEMCYSUB     8
+
+/** CoE emergency with time of reception */
+typedef struct nex_emcyentry
+{
+   /** time the emergency was received */
+   nex_timet  Time;
+   /** slave that sent the emergency */
+   uint16     Slave;
+   /** CoE error code */
+   uint16     ErrorCode;
+   /** CoE error register */
+   uint8      ErrorReg;
+   /** manufacturer specific data */
+   uint8      b1;
+   uint16     w1;
+   uint16     w2;
+} nex_emcyentryt;
+
+/** emergency queue of one slave. Lock free for one writer, the thread doing
+ *  the mailbox transfers, and one reader.
+ */
+typedef struct nex_emcyqueue
+{
+   /** next entry to write, only changed by writer */
+   volatile uint16 head;
+   /** next entry to read, only changed by reader */
+   volatile uint16 tail;
+   /** number of emergencies lost because the queue was full */
+   volatile uint32 lost;
+   nex_emcyentryt  Emcy[NEX_MAXEMCY];
+} nex_emcyqueuet;
+
+/** emergency subscription, match is (ErrorCode & mask) == code */
+typedef struct nex_emcysub
+{
+   /** slave to match, 0 = all slaves */
+   uint16  slave;
+   /** error code bits to compare, 0 = all error codes */
+   uint16  mask;
+   /** error code bits after mask */
+   uint16  code;
+   /** hook, called in the thread that received the emergency */
+   void    (*hook)(nex_emcyentryt *emcy, void *arg);
+   /** user argument for hook */
+   void    *arg;
+} nex_emcysubt;
+
+/** emergency queues and subscriptions of a context */
+typedef struct nex_emcylist
+{
+   /** TRUE = also report emergencies in the error list */
+   boolean        toelist;
+   /** called with the other mailbox messages read by nexx_emcy_harvest,
+    *  NULL = they are dropped */
+   void           (*mbxhook)(uint16 slave, nex_mbxbuft *mbx, void *arg);
+   /** user argument for mbxhook */
+   void           *mbxarg;
+   /** number of subscriptions in use */
+   int            nsub;
+   nex_emcysubt   sub[NEX_MAXEMCYSUB];
+   nex_emcyqueuet queue[NEX_MAXSLAVE];
+} nex_emcylistt;
+
 /** Context structure , referenced by all ecx functions*/
 typedef struct nexx_context
 {
@@ -399,13 +587,13 @@ typedef struct nexx_context
    uint16         esislave;
    /** internal, reference to error list */
    nex_eringt      *elist;
-   /** internal, reference to processdata stack buffer info */
+   /** internal, reference to processdata stack buffer info, unused since every group has its own */
    nex_idxstackT   *idxstack;
    /** reference to ecaterror state */
    boolean        *ecaterror;
-   /** internal, position of DC datagram in process data packet */
+   /** internal, unused, the DC datagram position is kept per group */
    uint16         DCtO;
-   /** internal, length of DC datagram */
+   /** internal, unused, the DC datagram length is kept per group */
    uint16         DCl;
    /** reference to last DC time from slaves */
    int64          *DCtime;
@@ -421,6 +609,10 @@ typedef struct nexx_context
    nex_eepromFMMUt *eepFMMU;
    /** registered FoE hook */
    int            (*FOEhook)(uint16 slave, int packetnumber, int datasize);
+   /** emergency queues and subscriptions, NULL = emergencies only in error list */
+   nex_emcylistt   *emcylist;
+   /** SoE IDN attribute cache, NULL = attributes are read from every slave */
+   struct nex_SoEcache *SoEcache;
 } nexx_contextt;
 
 #ifdef NEX_VER1
@@ -455,6 +647,16 @@ uint16 nex_statecheck(uint16 slave, uint16 reqstate, int timeout);
 int nex_mbxempty(uint16 slave, int timeout);
 int nex_mbxsend(uint16 slave,nex_mbxbuft *mbx, int timeout);
 int nex_mbxreceive(uint16 slave, nex_mbxbuft *mbx, int timeout);
+int nex_mbxwrite(uint16 slave, nex_mbxbuft *mbx, int timeout);
+int nex_mbxpoll(uint16 slave, nex_mbxbuft *mbx, int timeout);
+int nex_mbxrepeat(uint16 slave, int timeout);
+int nex_FP_multi(uint8 cmd, nex_datagramt *lst, int n, int timeout);
+int nex_mbxwrite_multi(int n, uint16 *slavelst, nex_datagramt *lst, int timeout);
+int nex_mbxpoll_multi(int n, uint16 *slavelst, nex_datagramt *lst, int timeout);
+int nex_emcy_subscribe(uint16 slave, uint16 mask, uint16 code, void *hook, void *arg);
+void nex_emcy_unsubscribe(int handle);
+boolean nex_emcy_pop(uint16 slave, nex_emcyentryt *emcy);
+int nex_emcy_harvest(int timeout);
 void nex_esidump(uint16 slave, uint8 *esibuf);
 uint32 nex_readeeprom(uint16 slave, uint16 eeproma, int timeout);
 int nex_writeeeprom(uint16 slave, uint16 eeproma, uint16 data, int timeout);
@@ -466,18 +668,24 @@ uint64 nex_readeepromFP(uint16 configadr, uint16 eeproma, int timeout);
 int nex_writeeepromFP(uint16 configadr, uint16 eeproma, uint16 data, int timeout);
 void nex_readeeprom1(uint16 slave, uint16 eeproma);
 uint32 nex_readeeprom2(uint16 slave, int timeout);
+int nex_readeeprom_multi(int n, nex_eeprombulkt *lst, uint16 start, uint16 words, int timeout);
+int nex_writeeeprom_multi(int n, nex_eeprombulkt *lst, uint16 start, uint16 words, boolean verify, int timeout);
 int nex_send_processdata_group(uint8 group);
 int nex_send_overlap_processdata_group(uint8 group);
 int nex_receive_processdata_group(uint8 group, int timeout);
 int nex_send_processdata(void);
 int nex_send_overlap_processdata(void);
 int nex_receive_processdata(int timeout);
+void nex_select_processdata(uint8 group, boolean overlap);
+void nex_config_retransmit(uint8 group, int32 budget);
+int nex_config_groupindex(uint8 group, uint8 first, uint8 count);
 #endif
 
 nex_adaptert * nex_find_adapters(void);
 void nex_free_adapters(nex_adaptert * adapter);
 uint8 nex_nextmbxcnt(uint8 cnt);
 void nex_clearmbx(nex_mbxbuft *Mbx);
+uint16 nex_siicrc(uint8 *buf);
 void nexx_pusherror(nexx_contextt *context, const nex_errort *Ec);
 boolean nexx_poperror(nexx_contextt *context, nex_errort *Ec);
 boolean nexx_iserror(nexx_contextt *context);
@@ -498,6 +706,17 @@ uint16 nexx_statecheck(nexx_contextt *context, uint16 slave, uint16 reqstate, in
 int nexx_mbxempty(nexx_contextt *context, uint16 slave, int timeout);
 int nexx_mbxsend(nexx_contextt *context, uint16 slave,nex_mbxbuft *mbx, int timeout);
 int nexx_mbxreceive(nexx_contextt *context, uint16 slave, nex_mbxbuft *mbx, int timeout);
+int nexx_mbxwrite(nexx_contextt *context, uint16 slave, nex_mbxbuft *mbx, int timeout);
+int nexx_mbxpoll(nexx_contextt *context, uint16 slave, nex_mbxbuft *mbx, int timeout);
+int nexx_mbxrepeat(nexx_contextt *context, uint16 slave, int timeout);
+int nexx_FP_multi(nexx_contextt *context, uint8 cmd, nex_datagramt *lst, int n, int timeout);
+int nexx_mbxwrite_multi(nexx_contextt *context, int n, uint16 *slavelst, nex_datagramt *lst, int timeout);
+int nexx_mbxpoll_multi(nexx_contextt *context, int n, uint16 *slavelst, nex_datagramt *lst, int timeout);
+int nexx_emcy_subscribe(nexx_contextt *context, uint16 slave, uint16 mask, uint16 code, void *hook, void *arg);
+void nexx_emcy_unsubscribe(nexx_contextt *context, int handle);
+boolean nexx_emcy_pop(nexx_contextt *context, uint16 slave, nex_emcyentryt *emcy);
+int nexx_emcy_harvest(nexx_contextt *context, int timeout);
+void nexx_emcy_push(nexx_contextt *context, nex_emcyentryt *Em);
 void nexx_esidump(nexx_contextt *context, uint16 slave, uint8 *esibuf);
 uint32 nexx_readeeprom(nexx_contextt *context, uint16 slave, uint16 eeproma, int timeout);
 int nexx_writeeeprom(nexx_contextt *context, uint16 slave, uint16 eeproma, uint16 data, int timeout);
@@ -509,11 +728,19 @@ uint64 nexx_readeepromFP(nexx_contextt *context, uint16 configadr, uint16 eeprom
 int nexx_writeeepromFP(nexx_contextt *context, uint16 configadr, uint16 eeproma, uint16 data, int timeout);
 void nexx_readeeprom1(nexx_contextt *context, uint16 slave, uint16 eeproma);
 uint32 nexx_readeeprom2(nexx_contextt *context, uint16 slave, int timeout);
+int nexx_readeeprom_multi(nexx_contextt *context, int n, nex_eeprombulkt *lst, uint16 start, uint16 words,
+                          int timeout);
+int nexx_writeeeprom_multi(nexx_contextt *context, int n, nex_eeprombulkt *lst, uint16 start, uint16 words,
+                           boolean verify, int timeout);
+int nexx_send_processdata_group(nexx_contextt *context, uint8 group);
 int nexx_send_overlap_processdata_group(nexx_contextt *context, uint8 group);
 int nexx_receive_processdata_group(nexx_contextt *context, uint8 group, int timeout);
 int nexx_send_processdata(nexx_contextt *context);
 int nexx_send_overlap_processdata(nexx_contextt *context);
 int nexx_receive_processdata(nexx_contextt *context, int timeout);
+void nexx_select_processdata(nexx_contextt *context, uint8 group, boolean overlap);
+void nexx_config_retransmit(nexx_contextt *context, uint8 group, int32 budget);
+int nexx_config_groupindex(nexx_contextt *context, uint8 group, uint8 first, uint8 count);
 
 #ifdef __cplusplus
 }
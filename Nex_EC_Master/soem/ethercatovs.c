@@ -0,0 +1,551 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Oversampling module.
+ *
+ * Oversampling slaves deliver an array of samples per cycle, the channels
+ * interleaved, and count the arrays they produce. nexx_ovs_process splits
+ * the array into continuous per channel buffers and stamps every sample with
+ * its DC time, derived from the DC time of the frame and the SYNC0 events of
+ * the slave. Missed cycles are found by the counter and flagged or filled.
+ * The common layouts of 2 or 4 channels of 16 bit and 2 channels of 32 bit
+ * are split with SSE2 or NEON when the target has it.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "osal.h"
+#include "oshw.h"
+#include "ethercattype.h"
+#include "ethercatbase.h"
+#include "ethercatmain.h"
+#include "ethercatovs.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define NEX_OVS_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define NEX_OVS_NEON
+#include <arm_neon.h>
+#endif
+
+/** Initialise demultiplexer and divide memory into the buffers.
+ *
+ * @param[out] ovs        = demultiplexer
+ * @param[in]  config     = oversampling field
+ * @param[in]  mem        = memory for buffers, 8 byte aligned
+ * @param[in]  memsize    = bytes of mem
+ * @return samples per channel buffer, 0 if config or memory is invalid
+ */
+int nexx_ovs_init(nex_ovst *ovs, const nex_ovsconfigt *config, void *mem, uint32 memsize)
+{
+   uint8 *p;
+   uint32 n;
+   int c;
+
+   memset(ovs, 0, sizeof(*ovs));
+   if (!config->nchannel || (config->nchannel > NEX_OVS_MAXCHANNEL) || !config->nsample ||
+       ((config->samplesize != 1) && (config->samplesize != 2) && (config->samplesize != 4)))
+   {
+      return 0;
+   }
+   ovs->config = *config;
+   /* time stamp, flag and sample of every channel */
+   n = memsize / (sizeof(int64) + 1 + (config->nchannel * config->samplesize));
+   while (n & (n - 1))
+   {
+      n &= n - 1;
+   }
+   if (n < config->nsample)
+   {
+      return 0;
+   }
+   ovs->bufsamples = n;
+   p = (uint8 *)mem;
+   ovs->time = (int64 *)p;
+   p += n * sizeof(int64);
+   for (c = 0; c < config->nchannel; c++)
+   {
+      ovs->buf[c] = p;
+      p += n * config->samplesize;
+   }
+   ovs->flag = p;
+
+   return (int)n;
+}
+
+/** Resolve the field in the process image, call it after the process data is
+ * mapped and before the first nexx_ovs_process.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  ovs        = demultiplexer
+ * @return 1 if OK, 0 if the field is outside of the inputs or has no sample time
+ */
+int nexx_ovs_start(nexx_contextt *context, nex_ovst *ovs)
+{
+   nex_ovsconfigt *cf;
+   nex_slavet *sl;
+   uint32 bytes;
+
+   cf = &ovs->config;
+   if ((cf->slave < 1) || (cf->slave > *(context->slavecount)))
+   {
+      return 0;
+   }
+   sl = &context->slavelist[cf->slave];
+   bytes = cf->offset + ((uint32)cf->nsample * cf->nchannel * cf->samplesize);
+   if (!sl->inputs || sl->Istartbit || (bytes > sl->Ibytes) ||
+       ((cf->counteroffset >= 0) && ((uint32)(cf->counteroffset + cf->countersize) > sl->Ibytes)))
+   {
+      return 0;
+   }
+   ovs->period = cf->sampletime ? cf->sampletime : sl->DCcycle;
+   ovs->shift = sl->DCshift;
+   if (ovs->period <= 0)
+   {
+      return 0;
+   }
+   ovs->src = sl->inputs + cf->offset;
+   ovs->counter = (cf->counteroffset >= 0) ? sl->inputs + cf->counteroffset : NULL;
+   ovs->head = 0;
+   ovs->tail = 0;
+   ovs->hascounter = FALSE;
+   ovs->nextflag = 0;
+   memset(&ovs->stat, 0, sizeof(ovs->stat));
+
+   return 1;
+}
+
+/** Split interleaved samples into the channel buffers.
+ *
+ * @param[in]  src        = first interleaved sample
+ * @param[in]  dst        = channel buffers
+ * @param[in]  pos        = first sample in channel buffers
+ * @param[in]  n          = samples per channel
+ * @param[in]  nch        = channels
+ * @param[in]  size       = bytes per sample
+ */
+static void nexx_ovs_split(const uint8 *src, uint8 * const *dst, uint32 pos, int n, int nch, int size)
+{
+   int i, c;
+
+   i = 0;
+   if (nch == 1)
+   {
+      memcpy(dst[0] + (pos * size), src, n * size);
+      return;
+   }
+   if ((size == 2) && (nch == 2))
+   {
+      int16 *d0 = (int16 *)dst[0] + pos, *d1 = (int16 *)dst[1] + pos;
+#if defined(NEX_OVS_SSE2)
+      for (; (i + 8) <= n; i += 8)
+      {
+         __m128i a = _mm_loadu_si128((const __m128i *)(src + (i * 4)));
+         __m128i b = _mm_loadu_si128((const __m128i *)(src + (i * 4) + 16));
+         /* low halves of the 32 bit pairs are channel 0, high halves channel 1 */
+         __m128i e = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16),
+                                     _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+         __m128i o = _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16));
+         _mm_storeu_si128((__m128i *)(d0 + i), e);
+         _mm_storeu_si128((__m128i *)(d1 + i), o);
+      }
+#elif defined(NEX_OVS_NEON)
+      for (; (i + 8) <= n; i += 8)
+      {
+         int16x8x2_t v = vld2q_s16((const int16_t *)(src + (i * 4)));
+         vst1q_s16(d0 + i, v.val[0]);
+         vst1q_s16(d1 + i, v.val[1]);
+      }
+#endif
+      for (; i < n; i++)
+      {
+         memcpy(d0 + i, src + (i * 4), 2);
+         memcpy(d1 + i, src + (i * 4) + 2, 2);
+      }
+      return;
+   }
+   if ((size == 2) && (nch == 4))
+   {
+      int16 *d0 = (int16 *)dst[0] + pos, *d1 = (int16 *)dst[1] + pos;
+      int16 *d2 = (int16 *)dst[2] + pos, *d3 = (int16 *)dst[3] + pos;
+#if defined(NEX_OVS_SSE2)
+      for (; (i + 4) <= n; i += 4)
+      {
+         __m128i a = _mm_loadu_si128((const __m128i *)(src + (i * 8)));
+         __m128i b = _mm_loadu_si128((const __m128i *)(src + (i * 8) + 16));
+         /* two interleaving steps give channels 0 and 1 in lo, 2 and 3 in hi */
+         __m128i l = _mm_unpacklo_epi16(a, b);
+         __m128i h = _mm_unpackhi_epi16(a, b);
+         __m128i lo = _mm_unpacklo_epi16(l, h);
+         __m128i hi = _mm_unpackhi_epi16(l, h);
+         _mm_storel_epi64((__m128i *)(d0 + i), lo);
+         _mm_storel_epi64((__m128i *)(d1 + i), _mm_srli_si128(lo, 8));
+         _mm_storel_epi64((__m128i *)(d2 + i), hi);
+         _mm_storel_epi64((__m128i *)(d3 + i), _mm_srli_si128(hi, 8));
+      }
+#elif defined(NEX_OVS_NEON)
+      for (; (i + 8) <= n; i += 8)
+      {
+         int16x8x4_t v = vld4q_s16((const int16_t *)(src + (i * 8)));
+         vst1q_s16(d0 + i, v.val[0]);
+         vst1q_s16(d1 + i, v.val[1]);
+         vst1q_s16(d2 + i, v.val[2]);
+         vst1q_s16(d3 + i, v.val[3]);
+      }
+#endif
+      for (; i < n; i++)
+      {
+         memcpy(d0 + i, src + (i * 8), 2);
+         memcpy(d1 + i, src + (i * 8) + 2, 2);
+         memcpy(d2 + i, src + (i * 8) + 4, 2);
+         memcpy(d3 + i, src + (i * 8) + 6, 2);
+      }
+      return;
+   }
+   if ((size == 4) && (nch == 2))
+   {
+      int32 *d0 = (int32 *)dst[0] + pos, *d1 = (int32 *)dst[1] + pos;
+#if defined(NEX_OVS_SSE2)
+      for (; (i + 4) <= n; i += 4)
+      {
+         __m128i a = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(src + (i * 8))), 0xd8);
+         __m128i b = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(src + (i * 8) + 16)), 0xd8);
+         _mm_storeu_si128((__m128i *)(d0 + i), _mm_unpacklo_epi64(a, b));
+         _mm_storeu_si128((__m128i *)(d1 + i), _mm_unpackhi_epi64(a, b));
+      }
+#elif defined(NEX_OVS_NEON)
+      for (; (i + 4) <= n; i += 4)
+      {
+         int32x4x2_t v = vld2q_s32((const int32_t *)(src + (i * 8)));
+         vst1q_s32(d0 + i, v.val[0]);
+         vst1q_s32(d1 + i, v.val[1]);
+      }
+#endif
+      for (; i < n; i++)
+      {
+         memcpy(d0 + i, src + (i * 8), 4);
+         memcpy(d1 + i, src + (i * 8) + 4, 4);
+      }
+      return;
+   }
+   for (; i < n; i++)
+   {
+      for (c = 0; c < nch; c++)
+      {
+         memcpy(dst[c] + ((pos + i) * size), src, size);
+         src += size;
+      }
+   }
+}
+
+/** Add samples with time stamps to the buffers, n fits in the free space.
+ *
+ * @param[in]  ovs        = demultiplexer
+ * @param[in]  src        = interleaved samples, NULL to repeat the last sample
+ * @param[in]  n          = samples per channel
+ * @param[in]  t0         = time of first sample
+ * @param[in]  flag       = flag of all samples
+ */
+static void nexx_ovs_add(nex_ovst *ovs, const uint8 *src, int n, int64 t0, uint8 flag)
+{
+   nex_ovsconfigt *cf;
+   uint32 mask, pos, last;
+   int i, c, part;
+
+   cf = &ovs->config;
+   mask = ovs->bufsamples - 1;
+   pos = ovs->head & mask;
+   if (src)
+   {
+      /* split in two parts where the buffers wrap */
+      part = ((pos + n) > ovs->bufsamples) ? (int)(ovs->bufsamples - pos) : n;
+      nexx_ovs_split(src, ovs->buf, pos, part, cf->nchannel, cf->samplesize);
+      if (part < n)
+      {
+         nexx_ovs_split(src + (part * cf->nchannel * cf->samplesize), ovs->buf, 0, n - part,
+                        cf->nchannel, cf->samplesize);
+      }
+   }
+   else
+   {
+      last = (ovs->head - 1) & mask;
+      for (i = 0; i < n; i++)
+      {
+         for (c = 0; c < cf->nchannel; c++)
+         {
+            memcpy(ovs->buf[c] + (((pos + i) & mask) * cf->samplesize),
+                   ovs->buf[c] + (last * cf->samplesize), cf->samplesize);
+         }
+      }
+   }
+   for (i = 0; i < n; i++)
+   {
+      ovs->time[(pos + i) & mask] = t0 + ((int64)i * ovs->period);
+      ovs->flag[(pos + i) & mask] = flag;
+   }
+   /* the gap flag goes to the first real sample, not to filled ones */
+   if (src)
+   {
+      ovs->flag[pos] |= ovs->nextflag;
+      ovs->nextflag = 0;
+   }
+   OSAL_MB();
+   ovs->head += n;
+   ovs->stat.samples += n;
+}
+
+/** Demultiplex the oversampling field of the last received process data.
+ * Call it from the cyclic thread after receiving the process data, it does
+ * not block. Samples are lost if the buffers are full.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  ovs        = demultiplexer
+ * @return samples per channel added
+ */
+int nexx_ovs_process(nexx_contextt *context, nex_ovst *ovs)
+{
+   nex_ovsconfigt *cf;
+   uint16 counter, mask;
+   uint32 missed, fill, space;
+   int64 dctime, tlast, t0;
+   int n, added;
+
+   cf = &ovs->config;
+   n = cf->nsample;
+   missed = 0;
+   if (ovs->counter)
+   {
+      counter = ovs->counter[0];
+      mask = 0xff;
+      if (cf->countersize > 1)
+      {
+         counter |= (uint16)(ovs->counter[1] << 8);
+         mask = 0xffff;
+      }
+      if (ovs->hascounter)
+      {
+         if (counter == ovs->lastcounter)
+         {
+            ovs->stat.repeated++;
+            return 0;
+         }
+         missed = (uint16)((counter - ovs->lastcounter) & mask) - 1;
+      }
+      ovs->lastcounter = counter;
+      ovs->hascounter = TRUE;
+   }
+   ovs->stat.cycles++;
+   /* last sample was taken at the last SYNC0 event before the frame */
+   dctime = context->grouplist[context->slavelist[cf->slave].group].DCtime;
+   tlast = dctime - ((dctime - ovs->shift) % ovs->period) + cf->timeoffset;
+   t0 = tlast - ((int64)(n - 1) * ovs->period);
+   added = 0;
+   if (missed)
+   {
+      ovs->stat.missed += missed;
+      ovs->nextflag = NEX_OVS_FLAG_GAP;
+      /* the last sample stays in the buffers after it is read */
+      if ((cf->gap == NEX_OVS_GAP_HOLD) && ovs->stat.samples)
+      {
+         fill = missed * n;
+         space = ovs->bufsamples - (ovs->head - ovs->tail);
+         if (space >= (uint32)n)
+         {
+            space -= n;
+         }
+         else
+         {
+            space = 0;
+         }
+         if (fill > space)
+         {
+            ovs->stat.overflow += fill - space;
+            fill = space;
+         }
+         if (fill)
+         {
+            nexx_ovs_add(ovs, NULL, (int)fill, t0 - ((int64)fill * ovs->period),
+                         NEX_OVS_FLAG_FILLED);
+            added += fill;
+         }
+      }
+   }
+   if ((ovs->bufsamples - (ovs->head - ovs->tail)) < (uint32)n)
+   {
+      ovs->stat.overflow += n;
+      ovs->nextflag = NEX_OVS_FLAG_GAP;
+      return added;
+   }
+   nexx_ovs_add(ovs, ovs->src, n, t0, 0);
+
+   return added + n;
+}
+
+/** Samples per channel ready to read.
+ *
+ * @param[in]  ovs        = demultiplexer
+ * @return samples
+ */
+int nexx_ovs_available(nex_ovst *ovs)
+{
+   return (int)(ovs->head - ovs->tail);
+}
+
+/** Take samples from the buffers, call it from one thread other than the
+ * cyclic one.
+ *
+ * @param[in]  ovs        = demultiplexer
+ * @param[out] data       = array per channel, NULL entries are skipped
+ * @param[out] time       = DC time per sample in ns, or NULL
+ * @param[out] flag       = NEX_OVS_FLAG_ bits per sample, or NULL
+ * @param[in]  max        = max samples per channel
+ * @return samples per channel taken
+ */
+int nexx_ovs_read(nex_ovst *ovs, void *data[], int64 *time, uint8 *flag, int max)
+{
+   uint32 head, tail, pos, mask;
+   int n, part, c, size;
+
+   head = ovs->head;
+   OSAL_MB();
+   tail = ovs->tail;
+   n = (int)(head - tail);
+   if (n > max)
+   {
+      n = max;
+   }
+   if (n <= 0)
+   {
+      return 0;
+   }
+   mask = ovs->bufsamples - 1;
+   pos = tail & mask;
+   part = ((pos + n) > ovs->bufsamples) ? (int)(ovs->bufsamples - pos) : n;
+   size = ovs->config.samplesize;
+   for (c = 0; c < ovs->config.nchannel; c++)
+   {
+      if (data && data[c])
+      {
+         memcpy(data[c], ovs->buf[c] + (pos * size), part * size);
+         memcpy((uint8 *)data[c] + (part * size), ovs->buf[c], (n - part) * size);
+      }
+   }
+   if (time)
+   {
+      memcpy(time, ovs->time + pos, part * sizeof(int64));
+      memcpy(time + part, ovs->time, (n - part) * sizeof(int64));
+   }
+   if (flag)
+   {
+      memcpy(flag, ovs->flag + pos, part);
+      memcpy(flag + part, ovs->flag, n - part);
+   }
+   OSAL_MB();
+   ovs->tail = tail + n;
+
+   return n;
+}
+
+/** Value of sample in a channel array taken by nexx_ovs_read.
+ *
+ * @param[in]  ovs        = demultiplexer
+ * @param[in]  data       = channel array
+ * @param[in]  i          = sample
+ * @return value
+ */
+int32 nexx_ovs_value(const nex_ovst *ovs, const void *data, int i)
+{
+   const uint8 *p;
+   uint16 v16;
+   uint32 v32;
+
+   switch (ovs->config.samplesize)
+   {
+      case 1:
+         p = (const uint8 *)data + i;
+         return ovs->config.sign ? (int32)(int8)*p : (int32)*p;
+      case 2:
+         memcpy(&v16, (const uint8 *)data + (i * 2), 2);
+         v16 = etohs(v16);
+         return ovs->config.sign ? (int32)(int16)v16 : (int32)v16;
+      default:
+         memcpy(&v32, (const uint8 *)data + (i * 4), 4);
+         return (int32)etohl(v32);
+   }
+}
+
+/** Resample a channel to a fixed period by linear interpolation. The state
+ * carries the last sample, so consecutive reads give a continuous output.
+ *
+ * @param[in]  ovs        = demultiplexer
+ * @param[in,out] rs      = resampling state, period set by the user
+ * @param[in]  data       = channel array taken by nexx_ovs_read
+ * @param[in]  time       = time stamps taken by nexx_ovs_read
+ * @param[in]  n          = samples in data
+ * @param[out] out        = resampled values
+ * @param[out] outtime    = time of resampled values, or NULL
+ * @param[in]  max        = size of out, values beyond it are skipped
+ * @return values in out
+ */
+int nexx_ovs_resample(const nex_ovst *ovs, nex_ovsresamplet *rs, const void *data, const int64 *time, int n,
+                      double *out, int64 *outtime, int max)
+{
+   double v;
+   int i, cnt;
+
+   cnt = 0;
+   if (rs->period <= 0)
+   {
+      return 0;
+   }
+   for (i = 0; i < n; i++)
+   {
+      v = (double)nexx_ovs_value(ovs, data, i);
+      if (!rs->haslast)
+      {
+         if (!rs->next)
+         {
+            rs->next = time[i];
+         }
+      }
+      else if (time[i] > rs->lasttime)
+      {
+         while ((rs->next <= time[i]) && (cnt < max))
+         {
+            if (rs->next >= rs->lasttime)
+            {
+               out[cnt] = rs->lastvalue + ((v - rs->lastvalue) * (double)(rs->next - rs->lasttime) /
+                                           (double)(time[i] - rs->lasttime));
+               if (outtime)
+               {
+                  outtime[cnt] = rs->next;
+               }
+               cnt++;
+            }
+            rs->next += rs->period;
+         }
+      }
+      rs->lasttime = time[i];
+      rs->lastvalue = v;
+      rs->haslast = TRUE;
+   }
+
+   return cnt;
+}
+
+#ifdef NEX_VER1
+int nex_ovs_start(nex_ovst *ovs)
+{
+   return nexx_ovs_start(&nexx_context, ovs);
+}
+
+int nex_ovs_process(nex_ovst *ovs)
+{
+   return nexx_ovs_process(&nexx_context, ovs);
+}
+#endif
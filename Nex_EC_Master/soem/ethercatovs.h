@@ -0,0 +1,144 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Headerfile for ethercatovs.c
+ */
+
+#ifndef _ethercatovs_
+#define _ethercatovs_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** max interleaved channels of an oversampling field */
+#define NEX_OVS_MAXCHANNEL    16
+
+/** handling of missed cycles */
+enum
+{
+   /** only flag the first sample after the gap */
+   NEX_OVS_GAP_FLAG = 0,
+   /** fill the gap with the last sample of every channel, the first sample
+    *  after the filled ones is flagged */
+   NEX_OVS_GAP_HOLD
+};
+
+/** sample flags */
+enum
+{
+   /** cycles were missed before this sample */
+   NEX_OVS_FLAG_GAP = 0x01,
+   /** sample is filled in for a missed cycle */
+   NEX_OVS_FLAG_FILLED = 0x02
+};
+
+/** Oversampling field in the inputs of a slave. The field is an array of
+ * nsample samples of nchannel interleaved channels, optionally with a cycle
+ * counter that the slave increments for each new array.
+ */
+typedef struct
+{
+   uint16  slave;
+   /** byte offset of the sample array in the inputs of the slave */
+   uint16  offset;
+   /** bytes per sample, 1, 2 or 4 */
+   uint8   samplesize;
+   /** TRUE if samples are signed */
+   boolean sign;
+   /** interleaved channels */
+   uint8   nchannel;
+   /** samples per channel per cycle */
+   uint16  nsample;
+   /** byte offset of the cycle counter in the inputs, -1 without counter */
+   int32   counteroffset;
+   /** bytes of counter, 1 or 2 */
+   uint8   countersize;
+   /** sample period in ns, 0 for the SYNC0 cycle of the slave */
+   int32   sampletime;
+   /** ns from the SYNC0 event to the sampling, f.e. the conversion time */
+   int32   timeoffset;
+   /** NEX_OVS_GAP_FLAG or NEX_OVS_GAP_HOLD */
+   uint8   gap;
+} nex_ovsconfigt;
+
+/** oversampling statistics */
+typedef struct
+{
+   /** arrays demultiplexed */
+   uint32  cycles;
+   /** samples per channel added */
+   uint32  samples;
+   /** cycles the slave counted that the master did not see */
+   uint32  missed;
+   /** cycles with an unchanged counter */
+   uint32  repeated;
+   /** samples per channel lost because the buffers were full */
+   uint32  overflow;
+} nex_ovsstatt;
+
+/** Demultiplexer of an oversampling field. The cyclic thread adds the samples
+ * of every cycle to continuous per channel buffers with a DC time stamp per
+ * sample, another thread takes them with nexx_ovs_read.
+ */
+typedef struct
+{
+   nex_ovsconfigt config;
+   /** sample array and counter in the process image, set by nexx_ovs_start */
+   uint8   *src;
+   uint8   *counter;
+   /** sample period and SYNC0 shift in ns, set by nexx_ovs_start */
+   int32   period;
+   int32   shift;
+   /** samples per channel buffer, power of two */
+   uint32  bufsamples;
+   uint8   *buf[NEX_OVS_MAXCHANNEL];
+   int64   *time;
+   uint8   *flag;
+   /** samples added, written by the cyclic thread only */
+   volatile uint32 head;
+   /** samples taken, written by the reading thread only */
+   volatile uint32 tail;
+   uint16  lastcounter;
+   boolean hascounter;
+   /** flag of next sample */
+   uint8   nextflag;
+   nex_ovsstatt stat;
+} nex_ovst;
+
+/** State of linear resampling of a channel to a fixed period */
+typedef struct
+{
+   /** time of next output sample in ns, 0 to start at the first input */
+   int64   next;
+   /** output period in ns */
+   int64   period;
+   int64   lasttime;
+   double  lastvalue;
+   boolean haslast;
+} nex_ovsresamplet;
+
+#ifdef NEX_VER1
+int nex_ovs_start(nex_ovst *ovs);
+int nex_ovs_process(nex_ovst *ovs);
+#endif
+
+int nexx_ovs_init(nex_ovst *ovs, const nex_ovsconfigt *config, void *mem, uint32 memsize);
+int nexx_ovs_start(nexx_contextt *context, nex_ovst *ovs);
+int nexx_ovs_process(nexx_contextt *context, nex_ovst *ovs);
+int nexx_ovs_available(nex_ovst *ovs);
+int nexx_ovs_read(nex_ovst *ovs, void *data[], int64 *time, uint8 *flag, int max);
+int32 nexx_ovs_value(const nex_ovst *ovs, const void *data, int i);
+int nexx_ovs_resample(const nex_ovst *ovs, nex_ovsresamplet *rs, const void *data, const int64 *time, int n,
+                      double *out, int64 *outtime, int max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -55,8 +55,6 @@ typedef struct
    char                errordescription[NEX_MAXERRORNAME + 1];
 } nex_mbxerrorlist_t;
 
-char estring[NEX_MAXERRORNAME];
-
 /** SDO error list definition */
 const nex_sdoerrorlist_t nex_sdoerrorlist[] = {
    {0x00000000, "No error" },
@@ -308,48 +306,48 @@ char* nexx_elist2string(nexx_contextt *context)
       {
          case NEX_ERR_TYPE_SDO_ERROR:
          {
-            sprintf(estring, "%s SDO slave:%d index:%4.4x.%2.2x error:%8.8x %s\n",
+            sprintf(context->elist->estring, "%s SDO slave:%d index:%4.4x.%2.2x error:%8.8x %s\n",
                     timestr, Ec.Slave, Ec.Index, Ec.SubIdx, (unsigned)Ec.AbortCode, nex_sdoerror2string(Ec.AbortCode));
             break;
          }
          case NEX_ERR_TYPE_EMERGENCY:
          {
-            sprintf(estring, "%s EMERGENCY slave:%d error:%4.4x\n",
+            sprintf(context->elist->estring, "%s EMERGENCY slave:%d error:%4.4x\n",
                     timestr, Ec.Slave, Ec.ErrorCode);
             break;
          }
          case NEX_ERR_TYPE_PACKET_ERROR:
          {
-            sprintf(estring, "%s PACKET slave:%d index:%4.4x.%2.2x error:%d\n",
+            sprintf(context->elist->estring, "%s PACKET slave:%d index:%4.4x.%2.2x error:%d\n",
                     timestr, Ec.Slave, Ec.Index, Ec.SubIdx, Ec.ErrorCode);
             break;
          }
          case NEX_ERR_TYPE_SDOINFO_ERROR:
          {
-            sprintf(estring, "%s SDO slave:%d index:%4.4x.%2.2x error:%8.8x %s\n",
+            sprintf(context->elist->estring, "%s SDO slave:%d index:%4.4x.%2.2x error:%8.8x %s\n",
                     timestr, Ec.Slave, Ec.Index, Ec.SubIdx, (unsigned)Ec.AbortCode, nex_sdoerror2string(Ec.AbortCode));
             break;
          }
          case NEX_ERR_TYPE_SOE_ERROR:
          {
-            sprintf(estring, "%s SoE slave:%d IDN:%4.4x error:%4.4x %s\n",
+            sprintf(context->elist->estring, "%s SoE slave:%d IDN:%4.4x error:%4.4x %s\n",
                     timestr, Ec.Slave, Ec.Index, (unsigned)Ec.AbortCode, nex_soeerror2string(Ec.ErrorCode));
             break;
          }
          case NEX_ERR_TYPE_MBX_ERROR:
          {
-            sprintf(estring, "%s MBX slave:%d error:%4.4x %s\n",
+            sprintf(context->elist->estring, "%s MBX slave:%d error:%4.4x %s\n",
                     timestr, Ec.Slave, Ec.ErrorCode, nex_mbxerror2string(Ec.ErrorCode));
             break;
          }
          default:
          {
-            sprintf(estring, "%s error:%8.8x\n",
+            sprintf(context->elist->estring, "%s error:%8.8x\n",
                     timestr, (unsigned)Ec.AbortCode);
             break;
          }
       }
-      return (char*) estring;
+      return (char*) context->elist->estring;
    }
    else
    {
@@ -0,0 +1,695 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Process image recorder module.
+ *
+ * Records selected bits of the process image at cycle rate. Channels are byte
+ * ranges of the inputs or outputs of a slave or single PDO entries, found by
+ * object index and subindex in the PDO mapping of the slave. In the cyclic
+ * thread nexx_rec_sample copies the channels and the DC time as one record to
+ * a ring, its time is bounded by the number of channels and is measured. A
+ * persisting thread moves the records with nexx_rec_flush to a user hook, f.e.
+ * writing a file. Records are optionally compressed against the previous
+ * record. With a trigger only the records around it are kept.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "osal.h"
+#include "oshw.h"
+#include "ethercattype.h"
+#include "ethercatbase.h"
+#include "ethercatmain.h"
+#include "ethercatcoe.h"
+#include "ethercatrec.h"
+
+/** bytes of hook buffer of nexx_rec_flush */
+#define NEX_REC_BUFSIZE       8192
+
+/** Initialise recorder.
+ *
+ * @param[out] rec        = recorder
+ * @param[in]  ring       = memory for the ring of records
+ * @param[in]  ringsize   = bytes of ring
+ * @param[in]  compress   = TRUE to compress records
+ */
+void nexx_rec_init(nex_rect *rec, void *ring, uint32 ringsize, boolean compress)
+{
+   memset(rec, 0, sizeof(*rec));
+   rec->ring = ring;
+   rec->ringsize = ringsize;
+   rec->compress = compress;
+   rec->recsize = NEX_REC_HEADSIZE;
+}
+
+/** Add channel.
+ *
+ * @param[in]  rec        = recorder
+ * @param[in]  ch         = channel
+ * @return channel number, -1 if too many channels or data
+ */
+static int nexx_rec_addchannel(nex_rect *rec, nex_recchannelt *ch)
+{
+   int bytes;
+
+   bytes = (ch->bits + 7) >> 3;
+   if ((rec->nchannel >= NEX_REC_MAXCHANNEL) || !bytes ||
+       ((rec->recsize + bytes) > (NEX_REC_HEADSIZE + NEX_REC_MAXDATA)))
+   {
+      return -1;
+   }
+   ch->recoffset = rec->recsize;
+   rec->recsize += (uint16)bytes;
+   rec->channel[rec->nchannel] = *ch;
+
+   return rec->nchannel++;
+}
+
+/** Add byte range of inputs or outputs of slave as channel.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  rec        = recorder
+ * @param[in]  slave      = Slave number
+ * @param[in]  dir        = NEX_REC_OUTPUTS or NEX_REC_INPUTS
+ * @param[in]  byteoffset = first byte of range
+ * @param[in]  bytes      = bytes of range
+ * @return channel number, -1 if too many channels or data
+ */
+int nexx_rec_addrange(nexx_contextt *context, nex_rect *rec, uint16 slave, uint8 dir, uint32 byteoffset, uint32 bytes)
+{
+   nex_recchannelt ch;
+
+   if ((slave < 1) || (slave > *(context->slavecount)) || (bytes > NEX_REC_MAXDATA))
+   {
+      return -1;
+   }
+   memset(&ch, 0, sizeof(ch));
+   ch.slave = slave;
+   ch.dir = dir;
+   ch.bitoffset = byteoffset * 8;
+   ch.bits = (uint16)(bytes * 8);
+
+   return nexx_rec_addchannel(rec, &ch);
+}
+
+/** Find PDO entry in the PDO mapping of slave, read with CoE.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number
+ * @param[in,out] ch      = channel, index and subindex of entry in, rest out
+ * @return TRUE if found
+ */
+static boolean nexx_rec_findpdo(nexx_contextt *context, uint16 slave, nex_recchannelt *ch)
+{
+   uint16 assign, pdo;
+   uint8 npdo, nentry;
+   uint32 entry, bitoffset;
+   int dir, p, e, size;
+
+   for (dir = NEX_REC_OUTPUTS; dir <= NEX_REC_INPUTS; dir++)
+   {
+      assign = (dir == NEX_REC_OUTPUTS) ? ECT_SDO_RXPDOASSIGN : ECT_SDO_TXPDOASSIGN;
+      npdo = 0;
+      size = sizeof(npdo);
+      if (nexx_SDOread(context, slave, assign, 0x00, FALSE, &size, &npdo, NEX_TIMEOUTRXM) <= 0)
+      {
+         continue;
+      }
+      bitoffset = 0;
+      for (p = 1; p <= npdo; p++)
+      {
+         pdo = 0;
+         size = sizeof(pdo);
+         nexx_SDOread(context, slave, assign, (uint8)p, FALSE, &size, &pdo, NEX_TIMEOUTRXM);
+         pdo = etohs(pdo);
+         nentry = 0;
+         size = sizeof(nentry);
+         if (!pdo || (nexx_SDOread(context, slave, pdo, 0x00, FALSE, &size, &nentry, NEX_TIMEOUTRXM) <= 0))
+         {
+            continue;
+         }
+         for (e = 1; e <= nentry; e++)
+         {
+            entry = 0;
+            size = sizeof(entry);
+            nexx_SDOread(context, slave, pdo, (uint8)e, FALSE, &size, &entry, NEX_TIMEOUTRXM);
+            entry = etohl(entry);
+            if (((entry >> 16) == ch->index) && (((entry >> 8) & 0xff) == ch->subindex))
+            {
+               ch->dir = (uint8)dir;
+               ch->bitoffset = bitoffset;
+               ch->bits = (uint16)(entry & 0xff);
+               return TRUE;
+            }
+            /* gaps have index 0 and take bits as well */
+            bitoffset += entry & 0xff;
+         }
+      }
+   }
+
+   return FALSE;
+}
+
+/** Add PDO entry of slave as channel. Reads the PDO mapping with CoE, call it
+ * in PRE-OP or SAFE-OP.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  rec        = recorder
+ * @param[in]  slave      = Slave number
+ * @param[in]  index      = object index of PDO entry
+ * @param[in]  subindex   = object subindex of PDO entry
+ * @return channel number, -1 if not mapped or too many channels
+ */
+int nexx_rec_addpdo(nexx_contextt *context, nex_rect *rec, uint16 slave, uint16 index, uint8 subindex)
+{
+   nex_recchannelt ch;
+
+   if ((slave < 1) || (slave > *(context->slavecount)) ||
+       !(context->slavelist[slave].mbx_proto & ECT_MBXPROT_COE))
+   {
+      return -1;
+   }
+   memset(&ch, 0, sizeof(ch));
+   ch.slave = slave;
+   ch.index = index;
+   ch.subindex = subindex;
+   if (!nexx_rec_findpdo(context, slave, &ch))
+   {
+      return -1;
+   }
+
+   return nexx_rec_addchannel(rec, &ch);
+}
+
+/** Set trigger, only records around it are persisted. The trigger is armed
+ * again after the post trigger records are persisted.
+ *
+ * @param[in]  rec        = recorder
+ * @param[in]  channel    = channel compared, max 64 bits
+ * @param[in]  type       = NEX_REC_TRIG_RISING, _FALLING, _CHANGE, _MASK or _NONE
+ * @param[in]  level      = level of RISING, FALLING and MASK
+ * @param[in]  mask       = mask of MASK
+ * @param[in]  sign       = TRUE if channel is signed
+ * @param[in]  pre        = records before trigger, less than records in ring
+ * @param[in]  post       = records after trigger
+ * @return 1 if OK, 0 if channel does not exist
+ */
+int nexx_rec_trigger(nex_rect *rec, int channel, uint8 type, int64 level, uint64 mask, boolean sign,
+                     uint32 pre, uint32 post)
+{
+   if ((type != NEX_REC_TRIG_NONE) &&
+       ((channel < 0) || (channel >= rec->nchannel) || (rec->channel[channel].bits > 64)))
+   {
+      return 0;
+   }
+   rec->trigtype = type;
+   rec->trigchannel = (uint8)channel;
+   rec->triglevel = level;
+   rec->trigmask = mask;
+   rec->trigsigned = sign;
+   rec->pre = pre;
+   rec->post = post;
+
+   return 1;
+}
+
+/** Resolve channels in the process image and size the ring, call it after
+ * the process data is mapped and before the first nexx_rec_sample.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  rec        = recorder
+ * @return records in ring, 0 if a channel is outside of the process data
+ */
+int nexx_rec_start(nexx_contextt *context, nex_rect *rec)
+{
+   nex_recchannelt *ch;
+   nex_slavet *sl;
+   uint32 bit;
+   int i;
+
+   for (i = 0; i < rec->nchannel; i++)
+   {
+      ch = &rec->channel[i];
+      sl = &context->slavelist[ch->slave];
+      if (ch->dir == NEX_REC_OUTPUTS)
+      {
+         if (!sl->outputs || ((ch->bitoffset + ch->bits) > sl->Obits))
+         {
+            return 0;
+         }
+         bit = sl->Ostartbit + ch->bitoffset;
+         ch->src = sl->outputs + (bit >> 3);
+      }
+      else
+      {
+         if (!sl->inputs || ((ch->bitoffset + ch->bits) > sl->Ibits))
+         {
+            return 0;
+         }
+         bit = sl->Istartbit + ch->bitoffset;
+         ch->src = sl->inputs + (bit >> 3);
+      }
+      ch->startbit = (uint8)(bit & 7);
+   }
+   /* power of two, the ring index stays continuous when head wraps */
+   rec->nrec = rec->ringsize / rec->recsize;
+   while (rec->nrec & (rec->nrec - 1))
+   {
+      rec->nrec &= rec->nrec - 1;
+   }
+   if (rec->pre >= rec->nrec)
+   {
+      rec->pre = rec->nrec ? rec->nrec - 1 : 0;
+   }
+   rec->head = 0;
+   rec->tail = 0;
+   rec->trigpending = 0;
+   rec->capturing = FALSE;
+   rec->hasvalue = FALSE;
+   memset(&rec->stat, 0, sizeof(rec->stat));
+
+   return (int)rec->nrec;
+}
+
+/** Value of channel in record.
+ *
+ * @param[in]  rec        = record
+ * @param[in]  recoffset  = byte offset of channel in record
+ * @param[in]  bits       = bits of channel, max 64
+ * @param[in]  sign       = TRUE if channel is signed
+ * @return value
+ */
+int64 nexx_rec_value(const uint8 *rec, uint16 recoffset, uint16 bits, boolean sign)
+{
+   uint64 v;
+   int i, bytes;
+
+   if (bits > 64)
+   {
+      bits = 64;
+   }
+   bytes = (bits + 7) >> 3;
+   v = 0;
+   for (i = bytes - 1; i >= 0; i--)
+   {
+      v = (v << 8) | rec[recoffset + i];
+   }
+   if (sign && (bits < 64) && (v & ((uint64)1 << (bits - 1))))
+   {
+      v |= ~(((uint64)1 << bits) - 1);
+   }
+
+   return (int64)v;
+}
+
+/** Copy bits of channel to record, aligned to bit 0.
+ *
+ * @param[out] dst        = channel data in record
+ * @param[in]  ch         = channel
+ */
+static void nexx_rec_copybits(uint8 *dst, const nex_recchannelt *ch)
+{
+   const uint8 *src;
+   int i, bytes, shift;
+
+   src = ch->src;
+   bytes = (ch->bits + 7) >> 3;
+   shift = ch->startbit;
+   if (!shift)
+   {
+      memcpy(dst, src, bytes);
+   }
+   else
+   {
+      for (i = 0; i < bytes; i++)
+      {
+         dst[i] = (uint8)(src[i] >> shift);
+         /* only read next byte if bits of it are used */
+         if (((i * 8) + 8 - shift) < ch->bits)
+         {
+            dst[i] |= (uint8)(src[i + 1] << (8 - shift));
+         }
+      }
+   }
+   if (ch->bits & 7)
+   {
+      dst[bytes - 1] &= (uint8)((1 << (ch->bits & 7)) - 1);
+   }
+}
+
+/** Check trigger condition.
+ *
+ * @param[in]  rec        = recorder
+ * @param[in]  r          = new record
+ * @return TRUE if trigger fired
+ */
+static boolean nexx_rec_checktrigger(nex_rect *rec, const uint8 *r)
+{
+   nex_recchannelt *ch;
+   int64 v, last, level;
+   boolean fire;
+
+   ch = &rec->channel[rec->trigchannel];
+   v = nexx_rec_value(r, ch->recoffset, ch->bits, rec->trigsigned);
+   last = rec->lastvalue;
+   level = rec->triglevel;
+   fire = FALSE;
+   if (rec->hasvalue)
+   {
+      switch (rec->trigtype)
+      {
+         case NEX_REC_TRIG_RISING:
+            fire = (last <= level) && (v > level);
+            break;
+         case NEX_REC_TRIG_FALLING:
+            fire = (last >= level) && (v < level);
+            break;
+         case NEX_REC_TRIG_CHANGE:
+            fire = (v != last);
+            break;
+         case NEX_REC_TRIG_MASK:
+            fire = (((uint64)v & rec->trigmask) == (uint64)level) &&
+                   (((uint64)last & rec->trigmask) != (uint64)level);
+            break;
+         default:
+            break;
+      }
+   }
+   rec->lastvalue = v;
+   rec->hasvalue = TRUE;
+
+   return fire;
+}
+
+/** Add record of process image to ring. Call it from the cyclic thread after
+ * receiving the process data, it does not block. The record is lost if the
+ * ring is full.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  rec        = recorder
+ */
+void nexx_rec_sample(nexx_contextt *context, nex_rect *rec)
+{
+   nex_timet t0, t1, diff;
+   uint32 head, seq;
+   int64 dctime;
+   uint8 *r;
+   uint16 slave;
+   int i;
+
+   t0 = osal_current_time();
+   head = rec->head;
+   seq = rec->stat.samples++;
+   if ((head - rec->tail) >= rec->nrec)
+   {
+      rec->stat.dropped++;
+      return;
+   }
+   r = rec->ring + ((head & (rec->nrec - 1)) * rec->recsize);
+   seq = htoel(seq);
+   memcpy(r, &seq, sizeof(seq));
+   /* DC time of the group of the recorded slaves */
+   slave = rec->nchannel ? rec->channel[0].slave : 0;
+   dctime = htoell(context->grouplist[context->slavelist[slave].group].DCtime);
+   memcpy(r + 4, &dctime, sizeof(dctime));
+   for (i = 0; i < rec->nchannel; i++)
+   {
+      nexx_rec_copybits(r + rec->channel[i].recoffset, &rec->channel[i]);
+   }
+   if (rec->trigtype && nexx_rec_checktrigger(rec, r) && !rec->trigpending)
+   {
+      rec->trigpos = head;
+      rec->stat.triggers++;
+      OSAL_MB();
+      rec->trigpending = 1;
+   }
+   OSAL_MB();
+   rec->head = head + 1;
+   t1 = osal_current_time();
+   osal_time_diff(&t0, &t1, &diff);
+   diff.usec += diff.sec * 1000000;
+   rec->stat.sumus += diff.usec;
+   if (diff.usec > rec->stat.maxus)
+   {
+      rec->stat.maxus = diff.usec;
+   }
+}
+
+/** Persist file header and channel descriptions, call it after nexx_rec_start.
+ *
+ * @param[in]  rec        = recorder
+ * @param[in]  hook       = persisting hook
+ * @param[in]  arg        = user argument of hook
+ * @return bytes persisted, < 0 if the hook failed
+ */
+int nexx_rec_header(nex_rect *rec, nex_rechookt hook, void *arg)
+{
+   nex_recfileheadert fh;
+   nex_recfilechannelt fc;
+   int i, size;
+
+   fh.magic = htoel(NEX_REC_MAGIC);
+   fh.version = htoes(NEX_REC_VERSION);
+   fh.compress = rec->compress;
+   fh.nchannel = (uint8)rec->nchannel;
+   fh.recsize = htoes(rec->recsize);
+   size = hook(arg, &fh, sizeof(fh));
+   for (i = 0; (i < rec->nchannel) && (size >= 0); i++)
+   {
+      fc.slave = htoes(rec->channel[i].slave);
+      fc.dir = rec->channel[i].dir;
+      fc.index = htoes(rec->channel[i].index);
+      fc.subindex = rec->channel[i].subindex;
+      fc.bitoffset = htoel(rec->channel[i].bitoffset);
+      fc.bits = htoes(rec->channel[i].bits);
+      fc.recoffset = htoes(rec->channel[i].recoffset);
+      if (hook(arg, &fc, sizeof(fc)) < 0)
+      {
+         return -1;
+      }
+      size += sizeof(fc);
+   }
+   /* first record is compressed against zeros */
+   memset(rec->prev, 0, sizeof(rec->prev));
+
+   return size;
+}
+
+/** Compress record against the previous one. The difference is stored as
+ * runs of unchanged bytes and runs of changed bytes XOR previous, behind the
+ * length of the compressed record.
+ *
+ * @param[in]  r          = record
+ * @param[in,out] prev    = previous record, replaced by r
+ * @param[in]  size       = bytes of record
+ * @param[out] out        = compressed record, max 2 * size + 2 bytes
+ * @return bytes of compressed record
+ */
+static int nexx_rec_encode(const uint8 *r, uint8 *prev, int size, uint8 *out)
+{
+   int i, o, lit, run;
+   uint16 len;
+
+   i = 0;
+   o = 2;
+   while (i < size)
+   {
+      if (r[i] == prev[i])
+      {
+         for (run = 0; (i < size) && (r[i] == prev[i]) && (run < 128); run++, i++);
+         out[o++] = (uint8)(0x80 | (run - 1));
+      }
+      else
+      {
+         lit = o++;
+         for (run = 0; (i < size) && (r[i] != prev[i]) && (run < 128); run++, i++)
+         {
+            out[o++] = r[i] ^ prev[i];
+         }
+         out[lit] = (uint8)(run - 1);
+      }
+   }
+   memcpy(prev, r, size);
+   len = htoes((uint16)(o - 2));
+   memcpy(out, &len, sizeof(len));
+
+   return o;
+}
+
+/** Decode compressed record of a recording.
+ *
+ * @param[in]  in         = compressed record
+ * @param[in]  insize     = bytes available at in
+ * @param[in,out] rec     = previous record, replaced by the decoded record
+ * @param[in]  recsize    = bytes of record
+ * @return bytes of compressed record used, -1 if it is invalid
+ */
+int nexx_rec_decode(const uint8 *in, int insize, uint8 *rec, int recsize)
+{
+   uint16 len;
+   int i, o, run;
+
+   if (insize < 2)
+   {
+      return -1;
+   }
+   memcpy(&len, in, sizeof(len));
+   len = etohs(len);
+   if ((len + 2) > insize)
+   {
+      return -1;
+   }
+   i = 0;
+   o = 2;
+   while ((o < (len + 2)) && (i <= recsize))
+   {
+      run = (in[o] & 0x7f) + 1;
+      if ((i + run) > recsize)
+      {
+         return -1;
+      }
+      if (in[o++] & 0x80)
+      {
+         i += run;
+      }
+      else
+      {
+         if ((o + run) > (len + 2))
+         {
+            return -1;
+         }
+         while (run--)
+         {
+            rec[i++] ^= in[o++];
+         }
+      }
+   }
+
+   return (i == recsize) ? (len + 2) : -1;
+}
+
+/** Persist records of ring, call it from a thread other than the cyclic one.
+ * Without a trigger all records are persisted. With a trigger the records
+ * before it are discarded, except for the pre trigger records.
+ *
+ * @param[in]  rec        = recorder
+ * @param[in]  hook       = persisting hook
+ * @param[in]  arg        = user argument of hook
+ * @return records persisted, < 0 if the hook failed
+ */
+int nexx_rec_flush(nex_rect *rec, nex_rechookt hook, void *arg)
+{
+   uint8 buf[NEX_REC_BUFSIZE];
+   uint8 *r;
+   uint32 head, tail, pos;
+   int n, used, size, max;
+
+   head = rec->head;
+   OSAL_MB();
+   tail = rec->tail;
+   n = 0;
+   used = 0;
+   max = rec->compress ? ((2 * rec->recsize) + 2) : rec->recsize;
+   while (tail != head)
+   {
+      if (rec->trigtype)
+      {
+         if (!rec->capturing)
+         {
+            if (!rec->trigpending)
+            {
+               /* waiting for the trigger, keep pre trigger records only */
+               if ((head - tail) > rec->pre)
+               {
+                  rec->stat.discarded += (head - tail) - rec->pre;
+                  tail = head - rec->pre;
+               }
+               break;
+            }
+            pos = rec->trigpos;
+            if ((pos - tail) > rec->pre)
+            {
+               rec->stat.discarded += (pos - tail) - rec->pre;
+               tail = pos - rec->pre;
+            }
+            rec->capturing = TRUE;
+            rec->capend = pos + rec->post + 1;
+         }
+         if (tail == rec->capend)
+         {
+            /* capture complete, arm trigger again */
+            rec->capturing = FALSE;
+            OSAL_MB();
+            rec->trigpending = 0;
+            continue;
+         }
+      }
+      if ((used + max) > NEX_REC_BUFSIZE)
+      {
+         if (hook(arg, buf, used) < 0)
+         {
+            return -1;
+         }
+         rec->stat.bytes += used;
+         used = 0;
+      }
+      r = rec->ring + ((tail & (rec->nrec - 1)) * rec->recsize);
+      if (rec->compress)
+      {
+         size = nexx_rec_encode(r, rec->prev, rec->recsize, buf + used);
+      }
+      else
+      {
+         size = rec->recsize;
+         memcpy(buf + used, r, size);
+      }
+      used += size;
+      tail++;
+      n++;
+   }
+   if (rec->capturing && (tail == rec->capend))
+   {
+      rec->capturing = FALSE;
+      OSAL_MB();
+      rec->trigpending = 0;
+   }
+   OSAL_MB();
+   rec->tail = tail;
+   if (used)
+   {
+      if (hook(arg, buf, used) < 0)
+      {
+         return -1;
+      }
+      rec->stat.bytes += used;
+   }
+   rec->stat.written += n;
+
+   return n;
+}
+
+#ifdef NEX_VER1
+int nex_rec_addrange(nex_rect *rec, uint16 slave, uint8 dir, uint32 byteoffset, uint32 bytes)
+{
+   return nexx_rec_addrange(&nexx_context, rec, slave, dir, byteoffset, bytes);
+}
+
+int nex_rec_addpdo(nex_rect *rec, uint16 slave, uint16 index, uint8 subindex)
+{
+   return nexx_rec_addpdo(&nexx_context, rec, slave, index, subindex);
+}
+
+int nex_rec_start(nex_rect *rec)
+{
+   return nexx_rec_start(&nexx_context, rec);
+}
+
+void nex_rec_sample(nex_rect *rec)
+{
+   nexx_rec_sample(&nexx_context, rec);
+}
+#endif
@@ -0,0 +1,190 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Headerfile for ethercatrec.c
+ */
+
+#ifndef _ethercatrec_
+#define _ethercatrec_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** "NEXR", start of recording */
+#define NEX_REC_MAGIC         0x5258454e
+#define NEX_REC_VERSION       1
+/** max number of recorded channels */
+#define NEX_REC_MAXCHANNEL    64
+/** max bytes of channel data per record */
+#define NEX_REC_MAXDATA       1024
+/** bytes of record header, sample number and DC time */
+#define NEX_REC_HEADSIZE      12
+
+/** channel source */
+enum
+{
+   NEX_REC_OUTPUTS = 0,
+   NEX_REC_INPUTS = 1
+};
+
+/** trigger condition */
+enum
+{
+   /** no trigger, everything is recorded */
+   NEX_REC_TRIG_NONE = 0,
+   /** value gets above level */
+   NEX_REC_TRIG_RISING,
+   /** value gets below level */
+   NEX_REC_TRIG_FALLING,
+   /** value changes */
+   NEX_REC_TRIG_CHANGE,
+   /** value and mask equals level */
+   NEX_REC_TRIG_MASK
+};
+
+/** Recording hook, persists data.
+ * @param[in]  arg   = user argument
+ * @param[in]  buf   = data
+ * @param[in]  size  = bytes
+ * @return bytes written, < 0 on error
+ */
+typedef int (*nex_rechookt)(void *arg, const void *buf, int size);
+
+/** recorded bits of the inputs or outputs of a slave */
+typedef struct
+{
+   uint16  slave;
+   /** NEX_REC_OUTPUTS or NEX_REC_INPUTS */
+   uint8   dir;
+   /** PDO entry, 0 for a range */
+   uint16  index;
+   uint8   subindex;
+   /** bit offset from start of inputs or outputs of slave */
+   uint32  bitoffset;
+   uint16  bits;
+   /** byte offset of data in record */
+   uint16  recoffset;
+   /** first byte and bit of data in the process image, set by nexx_rec_start */
+   uint8   *src;
+   uint8   startbit;
+} nex_recchannelt;
+
+/** Channel description in the file header */
+PACKED_BEGIN
+typedef struct PACKED
+{
+   uint16  slave;
+   uint8   dir;
+   uint16  index;
+   uint8   subindex;
+   uint32  bitoffset;
+   uint16  bits;
+   uint16  recoffset;
+} nex_recfilechannelt;
+PACKED_END
+
+/** File header, followed by the channel descriptions */
+PACKED_BEGIN
+typedef struct PACKED
+{
+   uint32  magic;
+   uint16  version;
+   /** TRUE if records are compressed */
+   uint8   compress;
+   uint8   nchannel;
+   /** bytes of uncompressed record, header included */
+   uint16  recsize;
+} nex_recfileheadert;
+PACKED_END
+
+/** recorder statistics */
+typedef struct
+{
+   /** records sampled */
+   uint32  samples;
+   /** records lost because the ring was full */
+   uint32  dropped;
+   /** records persisted */
+   uint32  written;
+   /** records discarded while waiting for the trigger */
+   uint32  discarded;
+   uint32  triggers;
+   /** bytes persisted */
+   uint64  bytes;
+   /** longest and total time of nexx_rec_sample in us */
+   uint32  maxus;
+   uint64  sumus;
+} nex_recstatt;
+
+/** Recorder of the process image. The cyclic thread adds a record per cycle to
+ * a ring, another thread persists the records with nexx_rec_flush.
+ */
+typedef struct
+{
+   nex_recchannelt channel[NEX_REC_MAXCHANNEL];
+   int     nchannel;
+   /** bytes of record, header included */
+   uint16  recsize;
+   boolean compress;
+   /** ring of records, supplied by the user */
+   uint8   *ring;
+   uint32  ringsize;
+   /** records in ring, power of two */
+   uint32  nrec;
+   /** records added, written by the cyclic thread only */
+   volatile uint32 head;
+   /** records removed, written by the persisting thread only */
+   volatile uint32 tail;
+   /** trigger condition */
+   uint8   trigtype;
+   uint8   trigchannel;
+   boolean trigsigned;
+   int64   triglevel;
+   uint64  trigmask;
+   /** records kept before and after the trigger */
+   uint32  pre;
+   uint32  post;
+   /** set by the cyclic thread when the trigger fires, cleared after the capture */
+   volatile uint32 trigpending;
+   /** record number of trigger */
+   volatile uint32 trigpos;
+   /** capture in progress, last record of capture */
+   boolean capturing;
+   uint32  capend;
+   int64   lastvalue;
+   boolean hasvalue;
+   /** previous record, base of compression */
+   uint8   prev[NEX_REC_HEADSIZE + NEX_REC_MAXDATA];
+   nex_recstatt stat;
+} nex_rect;
+
+#ifdef NEX_VER1
+int nex_rec_addrange(nex_rect *rec, uint16 slave, uint8 dir, uint32 byteoffset, uint32 bytes);
+int nex_rec_addpdo(nex_rect *rec, uint16 slave, uint16 index, uint8 subindex);
+int nex_rec_start(nex_rect *rec);
+void nex_rec_sample(nex_rect *rec);
+#endif
+
+void nexx_rec_init(nex_rect *rec, void *ring, uint32 ringsize, boolean compress);
+int nexx_rec_addrange(nexx_contextt *context, nex_rect *rec, uint16 slave, uint8 dir, uint32 byteoffset, uint32 bytes);
+int nexx_rec_addpdo(nexx_contextt *context, nex_rect *rec, uint16 slave, uint16 index, uint8 subindex);
+int nexx_rec_trigger(nex_rect *rec, int channel, uint8 type, int64 level, uint64 mask, boolean sign,
+                     uint32 pre, uint32 post);
+int nexx_rec_start(nexx_contextt *context, nex_rect *rec);
+void nexx_rec_sample(nexx_contextt *context, nex_rect *rec);
+int nexx_rec_header(nex_rect *rec, nex_rechookt hook, void *arg);
+int nexx_rec_flush(nex_rect *rec, nex_rechookt hook, void *arg);
+int nexx_rec_decode(const uint8 *in, int insize, uint8 *rec, int recsize);
+int64 nexx_rec_value(const uint8 *rec, uint16 recoffset, uint16 bits, boolean sign);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
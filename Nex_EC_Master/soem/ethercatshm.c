@@ -0,0 +1,525 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Shared memory process image module.
+ *
+ * Lets a master daemon share its process image with other processes. The
+ * cyclic thread of the daemon applies the queued output writes of the clients
+ * with nexx_shm_outputs before sending and publishes the image with
+ * nexx_shm_publish after receiving. Another thread of the daemon executes
+ * SDO and state commands of the clients with nexx_shm_service, so a slow
+ * command never delays the cycle. Clients only use the nex_shmclient
+ * functions on the mapped memory, they do not need a context or the NIC and
+ * do no system calls. Every queue has one producer and one consumer, a
+ * client that stops or crashes blocks nothing but its own queues.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "osal.h"
+#include "oshw.h"
+#include "ethercattype.h"
+#include "ethercatbase.h"
+#include "ethercatmain.h"
+#include "ethercatcoe.h"
+#include "ethercatshm.h"
+
+/** Copy status of slaves to shared memory.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  shm        = shared memory
+ */
+static void nexx_shm_slavestatus(nexx_contextt *context, nex_shmt *shm)
+{
+   nex_slavet *sl;
+   nex_shmslavet *ss;
+   int i;
+
+   shm->sseq++;
+   OSAL_MB();
+   for (i = 0; (i <= shm->slavecount) && (i < NEX_MAXSLAVE); i++)
+   {
+      sl = &context->slavelist[i];
+      ss = &shm->slave[i];
+      ss->state = sl->state;
+      ss->ALstatuscode = sl->ALstatuscode;
+      ss->islost = sl->islost;
+   }
+   OSAL_MB();
+   shm->sseq++;
+}
+
+/** Initialise shared memory of daemon after the group is mapped.
+ *
+ * @param[in]  context    = context struct
+ * @param[out] shm        = shared memory, mapped by the daemon
+ * @param[in]  size       = size of shared memory in bytes
+ * @param[in]  group      = group shared
+ * @return 1 if OK, 0 if shared memory is too small
+ */
+int nexx_shm_init(nexx_contextt *context, nex_shmt *shm, uint32 size, uint8 group)
+{
+   nex_groupt *grp;
+   nex_slavet *sl;
+   nex_shmslavet *ss;
+   int i;
+
+   grp = &context->grouplist[group];
+   if (size < NEX_SHM_SIZE(grp->Obytes, grp->Ibytes))
+   {
+      return 0;
+   }
+   memset(shm, 0, NEX_SHM_SIZE(grp->Obytes, grp->Ibytes));
+   shm->size = size;
+   shm->Obytes = grp->Obytes;
+   shm->Ibytes = grp->Ibytes;
+   shm->expectedwkc = (grp->outputsWKC * 2) + grp->inputsWKC;
+   shm->slavecount = *(context->slavecount);
+   for (i = 0; (i <= shm->slavecount) && (i < NEX_MAXSLAVE); i++)
+   {
+      sl = &context->slavelist[i];
+      ss = &shm->slave[i];
+      ss->configadr = sl->configadr;
+      ss->eep_man = sl->eep_man;
+      ss->eep_id = sl->eep_id;
+      memcpy(ss->name, sl->name, sizeof(ss->name) - 1);
+      ss->name[sizeof(ss->name) - 1] = '\0';
+      /* slaves of other groups are not in the image */
+      if (i && (sl->group == group))
+      {
+         if (sl->outputs)
+         {
+            ss->Ooffset = (uint32)(sl->outputs - grp->outputs);
+            ss->Ostartbit = sl->Ostartbit;
+            ss->Obits = sl->Obits;
+         }
+         if (sl->inputs)
+         {
+            ss->Ioffset = grp->Obytes + (uint32)(sl->inputs - grp->inputs);
+            ss->Istartbit = sl->Istartbit;
+            ss->Ibits = sl->Ibits;
+         }
+      }
+   }
+   nexx_shm_slavestatus(context, shm);
+   shm->version = NEX_SHM_VERSION;
+   OSAL_MB();
+   /* clients attach only after the magic is set */
+   shm->magic = NEX_SHM_MAGIC;
+
+   return 1;
+}
+
+/** Apply queued output writes of all clients to the group outputs. Call it
+ * from the cyclic thread before sending the process data.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  shm        = shared memory
+ * @param[in]  group      = group shared
+ * @return number of writes applied
+ */
+int nexx_shm_outputs(nexx_contextt *context, nex_shmt *shm, uint8 group)
+{
+   nex_shmoutqt *q;
+   nex_shmwritet w;
+   uint8 *out;
+   uint32 Obytes, head, tail, i;
+   int c, done;
+
+   out = context->grouplist[group].outputs;
+   Obytes = context->grouplist[group].Obytes;
+   done = 0;
+   for (c = 0; c < NEX_SHM_MAXCLIENT; c++)
+   {
+      q = &shm->client[c].outq;
+      tail = q->tail;
+      head = q->head;
+      /* a client can write anything, never apply more than a full queue */
+      if ((head - tail) > NEX_SHM_OUTQ)
+      {
+         head = tail + NEX_SHM_OUTQ;
+      }
+      OSAL_MB();
+      for (; tail != head; tail++)
+      {
+         /* check and apply a copy, the client can change the entry meanwhile */
+         w = q->entry[tail & (NEX_SHM_OUTQ - 1)];
+         if ((w.length <= NEX_SHM_MAXWRITE) && (w.length <= Obytes) && (w.offset <= (Obytes - w.length)))
+         {
+            for (i = 0; i < w.length; i++)
+            {
+               out[w.offset + i] = (out[w.offset + i] & ~w.mask[i]) | (w.data[i] & w.mask[i]);
+            }
+            done++;
+         }
+      }
+      OSAL_MB();
+      q->tail = tail;
+   }
+
+   return done;
+}
+
+/** Publish process image of group. Call it from the cyclic thread after
+ * receiving the process data.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  shm        = shared memory
+ * @param[in]  group      = group shared
+ * @param[in]  wkc        = working counter of the cycle
+ */
+void nexx_shm_publish(nexx_contextt *context, nex_shmt *shm, uint8 group, int wkc)
+{
+   nex_groupt *grp;
+   uint8 *image;
+
+   grp = &context->grouplist[group];
+   image = NEX_SHM_IMAGE(shm);
+   /* odd sequence while updating, readers retry */
+   shm->seq++;
+   OSAL_MB();
+   /* sizes of the group, a client can overwrite those in shared memory */
+   memcpy(image, grp->outputs, grp->Obytes);
+   memcpy(image + grp->Obytes, grp->inputs, grp->Ibytes);
+   shm->wkc = wkc;
+   shm->dctime = grp->DCtime;
+   shm->cycle++;
+   OSAL_MB();
+   shm->seq++;
+}
+
+/** Execute command of client.
+ *
+ * @param[in]  context    = context struct
+ * @param[in,out] cmd     = command, replaced by the response
+ */
+static void nexx_shm_execute(nexx_contextt *context, nex_shmcmdt *cmd)
+{
+   int16 mark;
+   int size, i;
+
+   mark = context->elist->head;
+   cmd->abortcode = 0;
+   if (cmd->slave > *(context->slavecount))
+   {
+      cmd->wkc = 0;
+      return;
+   }
+   switch (cmd->cmd)
+   {
+      case NEX_SHM_SDOREAD:
+         size = sizeof(cmd->data);
+         cmd->wkc = nexx_SDOread(context, cmd->slave, cmd->index, cmd->subindex, cmd->CA, &size,
+                                 cmd->data, NEX_TIMEOUTRXM);
+         cmd->size = (cmd->wkc > 0) ? size : 0;
+         break;
+      case NEX_SHM_SDOWRITE:
+         if ((cmd->size < 0) || (cmd->size > (int32)sizeof(cmd->data)))
+         {
+            cmd->wkc = 0;
+            break;
+         }
+         cmd->wkc = nexx_SDOwrite(context, cmd->slave, cmd->index, cmd->subindex, cmd->CA, cmd->size,
+                                  cmd->data, NEX_TIMEOUTRXM);
+         break;
+      case NEX_SHM_STATE:
+         context->slavelist[cmd->slave].state = cmd->state;
+         cmd->wkc = nexx_writestate(context, cmd->slave);
+         if (cmd->wkc > 0)
+         {
+            cmd->state = nexx_statecheck(context, cmd->slave, cmd->state, NEX_TIMEOUTSTATE);
+         }
+         break;
+      default:
+         cmd->wkc = 0;
+         break;
+   }
+   /* abort code of first SDO error of this command */
+   for (i = mark; i != context->elist->head; i = (i + 1) % (NEX_MAXELIST + 1))
+   {
+      if (context->elist->Error[i].Etype == NEX_ERR_TYPE_SDO_ERROR)
+      {
+         cmd->abortcode = context->elist->Error[i].AbortCode;
+         break;
+      }
+   }
+}
+
+/** Execute commands of clients and publish slave status. Executes at most one
+ * command per client, the SDO and state commands block. Call it from a thread
+ * of the daemon other than the cyclic one.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  shm        = shared memory
+ * @return number of commands executed
+ */
+int nexx_shm_service(nexx_contextt *context, nex_shmt *shm)
+{
+   nex_shmclientt *cl;
+   nex_shmcmdt cmd;
+   uint32 tail, head;
+   int c, done;
+
+   done = 0;
+   for (c = 0; c < NEX_SHM_MAXCLIENT; c++)
+   {
+      cl = &shm->client[c];
+      tail = cl->cmdq.tail;
+      if (tail == cl->cmdq.head)
+      {
+         continue;
+      }
+      /* response queue full, the client does not read its responses */
+      head = cl->rspq.head;
+      if ((head - cl->rspq.tail) >= NEX_SHM_CMDQ)
+      {
+         continue;
+      }
+      OSAL_MB();
+      /* execute a copy, the client can change the entry meanwhile */
+      cmd = cl->cmdq.entry[tail & (NEX_SHM_CMDQ - 1)];
+      OSAL_MB();
+      cl->cmdq.tail = tail + 1;
+      /* queued by an earlier client with the same number */
+      if ((int32)(tail - cl->cmdstart) < 0)
+      {
+         continue;
+      }
+      nexx_shm_execute(context, &cmd);
+      if ((int32)(tail - cl->cmdstart) < 0)
+      {
+         continue;
+      }
+      cl->rspq.entry[head & (NEX_SHM_CMDQ - 1)] = cmd;
+      OSAL_MB();
+      cl->rspq.head = head + 1;
+      done++;
+   }
+   nexx_shm_slavestatus(context, shm);
+
+   return done;
+}
+
+/** Attach client process to shared memory of daemon. Commands and responses
+ * of an earlier client with the same number are dropped. A client that
+ * crashed did not detach, its number is taken over.
+ *
+ * @param[in]  shm        = shared memory, mapped by the client
+ * @param[in]  client     = client number, 0 to NEX_SHM_MAXCLIENT - 1, unique per process
+ * @return 1 if attached, 2 if attached in place of a client that did not
+ * detach, 0 if memory not initialised or of another version
+ */
+int nex_shmclient_attach(nex_shmt *shm, int client)
+{
+   nex_shmclientt *cl;
+   int rval;
+
+   if ((shm->magic != NEX_SHM_MAGIC) || (shm->version != NEX_SHM_VERSION) ||
+       (client < 0) || (client >= NEX_SHM_MAXCLIENT))
+   {
+      return 0;
+   }
+   OSAL_MB();
+   cl = &shm->client[client];
+   rval = cl->attached ? 2 : 1;
+   cl->attached = 1;
+   cl->cmdstart = cl->cmdq.head;
+   OSAL_MB();
+   cl->rspq.tail = cl->rspq.head;
+
+   return rval;
+}
+
+/** Detach client process.
+ *
+ * @param[in]  shm        = shared memory
+ * @param[in]  client     = client number
+ */
+void nex_shmclient_detach(nex_shmt *shm, int client)
+{
+   if ((client >= 0) && (client < NEX_SHM_MAXCLIENT))
+   {
+      shm->client[client].attached = 0;
+   }
+}
+
+/** Read consistent part of process image, outputs start at offset 0, inputs
+ * at offset Obytes. Does not block the daemon, retries while it updates.
+ *
+ * @param[in]  shm        = shared memory
+ * @param[in]  offset     = byte offset in process image
+ * @param[in]  length     = bytes to read
+ * @param[out] buf        = data read
+ * @param[out] cycle      = cycle of data, NULL if not needed
+ * @return TRUE if OK, FALSE if outside of the process image
+ */
+boolean nex_shmclient_read(nex_shmt *shm, uint32 offset, uint32 length, void *buf, uint32 *cycle)
+{
+   uint32 seq, cyc;
+
+   if ((length > (shm->Obytes + shm->Ibytes)) || (offset > (shm->Obytes + shm->Ibytes - length)))
+   {
+      return FALSE;
+   }
+   do
+   {
+      seq = shm->seq;
+      OSAL_MB();
+      memcpy(buf, NEX_SHM_IMAGE(shm) + offset, length);
+      cyc = shm->cycle;
+      OSAL_MB();
+   } while ((seq & 1) || (seq != shm->seq));
+   if (cycle)
+   {
+      *cycle = cyc;
+   }
+
+   return TRUE;
+}
+
+/** Queue masked write of outputs, applied by the daemon in the next cycle.
+ *
+ * @param[in]  shm        = shared memory
+ * @param[in]  client     = client number
+ * @param[in]  offset     = byte offset in process image
+ * @param[in]  length     = bytes to write, max NEX_SHM_MAXWRITE
+ * @param[in]  data       = data to write
+ * @param[in]  mask       = bits to write, NULL = all bits
+ * @return TRUE if queued, FALSE if queue full or outside of outputs
+ */
+boolean nex_shmclient_write(nex_shmt *shm, int client, uint32 offset, uint32 length, const void *data, const void *mask)
+{
+   nex_shmoutqt *q;
+   nex_shmwritet *w;
+   uint32 head;
+
+   if ((length > NEX_SHM_MAXWRITE) || (length > shm->Obytes) || (offset > (shm->Obytes - length)))
+   {
+      return FALSE;
+   }
+   q = &shm->client[client].outq;
+   head = q->head;
+   if ((head - q->tail) >= NEX_SHM_OUTQ)
+   {
+      return FALSE;
+   }
+   w = &q->entry[head & (NEX_SHM_OUTQ - 1)];
+   w->offset = offset;
+   w->length = (uint8)length;
+   memcpy(w->data, data, length);
+   if (mask)
+   {
+      memcpy(w->mask, mask, length);
+   }
+   else
+   {
+      memset(w->mask, 0xff, length);
+   }
+   OSAL_MB();
+   q->head = head + 1;
+
+   return TRUE;
+}
+
+/** Read consistent status of slave.
+ *
+ * @param[in]  shm        = shared memory
+ * @param[in]  slave      = slave number
+ * @param[out] status     = status of slave
+ * @return TRUE if OK, FALSE if slave does not exist
+ */
+boolean nex_shmclient_slave(nex_shmt *shm, uint16 slave, nex_shmslavet *status)
+{
+   uint32 seq;
+
+   if ((slave > shm->slavecount) || (slave >= NEX_MAXSLAVE))
+   {
+      return FALSE;
+   }
+   do
+   {
+      seq = shm->sseq;
+      OSAL_MB();
+      *status = shm->slave[slave];
+      OSAL_MB();
+   } while ((seq & 1) || (seq != shm->sseq));
+
+   return TRUE;
+}
+
+/** Queue command for the daemon.
+ *
+ * @param[in]  shm        = shared memory
+ * @param[in]  client     = client number
+ * @param[in]  cmd        = command
+ * @return TRUE if queued, FALSE if queue full
+ */
+boolean nex_shmclient_request(nex_shmt *shm, int client, nex_shmcmdt *cmd)
+{
+   nex_shmcmdqt *q;
+   uint32 head;
+
+   q = &shm->client[client].cmdq;
+   head = q->head;
+   if ((head - q->tail) >= NEX_SHM_CMDQ)
+   {
+      return FALSE;
+   }
+   q->entry[head & (NEX_SHM_CMDQ - 1)] = *cmd;
+   OSAL_MB();
+   q->head = head + 1;
+
+   return TRUE;
+}
+
+/** Get next response of the daemon, does not block.
+ *
+ * @param[in]  shm        = shared memory
+ * @param[in]  client     = client number
+ * @param[out] rsp        = response with the id of its command
+ * @return TRUE if a response was returned
+ */
+boolean nex_shmclient_response(nex_shmt *shm, int client, nex_shmcmdt *rsp)
+{
+   nex_shmcmdqt *q;
+   uint32 tail;
+
+   q = &shm->client[client].rspq;
+   tail = q->tail;
+   if (tail == q->head)
+   {
+      return FALSE;
+   }
+   OSAL_MB();
+   *rsp = q->entry[tail & (NEX_SHM_CMDQ - 1)];
+   OSAL_MB();
+   q->tail = tail + 1;
+
+   return TRUE;
+}
+
+#ifdef NEX_VER1
+int nex_shm_init(nex_shmt *shm, uint32 size, uint8 group)
+{
+   return nexx_shm_init(&nexx_context, shm, size, group);
+}
+
+int nex_shm_outputs(nex_shmt *shm, uint8 group)
+{
+   return nexx_shm_outputs(&nexx_context, shm, group);
+}
+
+void nex_shm_publish(nex_shmt *shm, uint8 group, int wkc)
+{
+   nexx_shm_publish(&nexx_context, shm, group, wkc);
+}
+
+int nex_shm_service(nex_shmt *shm)
+{
+   return nexx_shm_service(&nexx_context, shm);
+}
+#endif
@@ -0,0 +1,183 @@
+/*
+ * Licensed under the GNU General Public License version 2 with exceptions. See
+ * LICENSE file in the project root for full license information
+ */
+
+/** \file
+ * \brief
+ * Headerfile for ethercatshm.c
+ */
+
+#ifndef _ethercatshm_
+#define _ethercatshm_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** "NEXS", marks initialised shared memory */
+#define NEX_SHM_MAGIC         0x5358454e
+/** layout version, clients of another version are refused */
+#define NEX_SHM_VERSION       2
+/** max number of client processes */
+#define NEX_SHM_MAXCLIENT     8
+/** entries of output write queue per client, power of 2 */
+#define NEX_SHM_OUTQ          256
+/** entries of command and response queue per client, power of 2 */
+#define NEX_SHM_CMDQ          16
+/** max bytes of one output write */
+#define NEX_SHM_MAXWRITE      8
+/** max data bytes of one command */
+#define NEX_SHM_MAXDATA       512
+
+/** commands of clients, executed by nexx_shm_service */
+enum
+{
+   NEX_SHM_SDOREAD = 1,
+   NEX_SHM_SDOWRITE,
+   /** request state of slave, slave 0 = all slaves */
+   NEX_SHM_STATE
+};
+
+/** status of one slave, published by the daemon */
+typedef struct
+{
+   uint16  state;
+   uint16  ALstatuscode;
+   uint16  configadr;
+   boolean islost;
+   uint32  eep_man;
+   uint32  eep_id;
+   /** byte offset of outputs in process image, bit offset and size in bits */
+   uint32  Ooffset;
+   uint8   Ostartbit;
+   uint16  Obits;
+   /** byte offset of inputs in process image, bit offset and size in bits */
+   uint32  Ioffset;
+   uint8   Istartbit;
+   uint16  Ibits;
+   char    name[NEX_MAXNAME + 1];
+} nex_shmslavet;
+
+/** masked write of outputs */
+typedef struct
+{
+   /** byte offset in process image */
+   uint32  offset;
+   uint8   length;
+   uint8   data[NEX_SHM_MAXWRITE];
+   /** bits of data to write */
+   uint8   mask[NEX_SHM_MAXWRITE];
+} nex_shmwritet;
+
+/** acyclic command of client, returned as response with the result */
+typedef struct
+{
+   /** chosen by the client, returned in the response */
+   uint32  id;
+   /** NEX_SHM_SDOREAD, NEX_SHM_SDOWRITE or NEX_SHM_STATE */
+   uint8   cmd;
+   boolean CA;
+   uint16  slave;
+   uint16  index;
+   uint8   subindex;
+   /** requested state of NEX_SHM_STATE, state reached in the response */
+   uint16  state;
+   /** bytes of data, bytes read in the response */
+   int32   size;
+   /** working counter of the response, <= 0 if the command failed */
+   int32   wkc;
+   /** SDO abort code of the response, 0 if none */
+   int32   abortcode;
+   uint8   data[NEX_SHM_MAXDATA];
+} nex_shmcmdt;
+
+/** output write queue, one producer and one consumer */
+typedef struct
+{
+   volatile uint32 head;
+   volatile uint32 tail;
+   nex_shmwritet   entry[NEX_SHM_OUTQ];
+} nex_shmoutqt;
+
+/** command queue, one producer and one consumer */
+typedef struct
+{
+   volatile uint32 head;
+   volatile uint32 tail;
+   nex_shmcmdt     entry[NEX_SHM_CMDQ];
+} nex_shmcmdqt;
+
+/** queues of one client process */
+typedef struct
+{
+   /** set while a client is attached */
+   volatile uint32 attached;
+   /** command queue position at attach, earlier commands are dropped */
+   volatile uint32 cmdstart;
+   /** client to daemon */
+   nex_shmoutqt    outq;
+   nex_shmcmdqt    cmdq;
+   /** daemon to client */
+   nex_shmcmdqt    rspq;
+} nex_shmclientt;
+
+/** Shared memory of master daemon. The process image follows this header, the
+ * outputs of the group first, then its inputs. Image and slave status are
+ * published with a sequence counter, odd while the daemon updates it, so
+ * readers never block the cyclic loop. Clients never write the image, they
+ * queue their output writes.
+ */
+typedef struct
+{
+   uint32  magic;
+   uint32  version;
+   /** total size in bytes, header and process image */
+   uint32  size;
+   uint32  Obytes;
+   uint32  Ibytes;
+   int32   expectedwkc;
+   int32   slavecount;
+   /** sequence counter of process image */
+   volatile uint32 seq;
+   /** cycles published, stops when the daemon is gone */
+   volatile uint32 cycle;
+   volatile int32  wkc;
+   volatile int64  dctime;
+   /** sequence counter of slave status */
+   volatile uint32 sseq;
+   nex_shmslavet   slave[NEX_MAXSLAVE];
+   nex_shmclientt  client[NEX_SHM_MAXCLIENT];
+} nex_shmt;
+
+/** process image of shared memory */
+#define NEX_SHM_IMAGE(shm)    ((uint8 *)(shm) + sizeof(nex_shmt))
+/** bytes of shared memory needed for a process image */
+#define NEX_SHM_SIZE(Obytes, Ibytes) (sizeof(nex_shmt) + (Obytes) + (Ibytes))
+
+#ifdef NEX_VER1
+int nex_shm_init(nex_shmt *shm, uint32 size, uint8 group);
+int nex_shm_outputs(nex_shmt *shm, uint8 group);
+void nex_shm_publish(nex_shmt *shm, uint8 group, int wkc);
+int nex_shm_service(nex_shmt *shm);
+#endif
+
+int nexx_shm_init(nexx_contextt *context, nex_shmt *shm, uint32 size, uint8 group);
+int nexx_shm_outputs(nexx_contextt *context, nex_shmt *shm, uint8 group);
+void nexx_shm_publish(nexx_contextt *context, nex_shmt *shm, uint8 group, int wkc);
+int nexx_shm_service(nexx_contextt *context, nex_shmt *shm);
+
+int nex_shmclient_attach(nex_shmt *shm, int client);
+void nex_shmclient_detach(nex_shmt *shm, int client);
+boolean nex_shmclient_read(nex_shmt *shm, uint32 offset, uint32 length, void *buf, uint32 *cycle);
+boolean nex_shmclient_write(nex_shmt *shm, int client, uint32 offset, uint32 length, const void *data, const void *mask);
+boolean nex_shmclient_slave(nex_shmt *shm, uint16 slave, nex_shmslavet *status);
+boolean nex_shmclient_request(nex_shmt *shm, int client, nex_shmcmdt *cmd);
+boolean nex_shmclient_response(nex_shmt *shm, int client, nex_shmcmdt *rsp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -18,6 +18,10 @@
 #include "ethercatsoe.h"
 
 #define NEX_SOE_MAX_DRIVES 8
+/** max requests placed in slave mailbox before the first response is read */
+#define NEX_SOE_PIPELINE   2
+/** delay in us when a pipelined read did not move any message */
+#define NEX_SOE_IDLEDELAY  100
 
 /** SoE (Servo over EtherCAT) mailbox structure */
 PACKED_BEGIN
@@ -59,6 +63,38 @@ void nexx_SoEerror(nexx_contextt *context, uint16 Slave, uint16 idn, uint16 Erro
    nexx_pusherror(context, &Ec);
 }
 
+/** Build SoE read request.
+ *
+ * @param[in]  context       = context struct
+ * @param[in]  slave         = Slave number
+ * @param[in]  driveNo       = Drive number in slave
+ * @param[in]  elementflags  = Flags to select what properties of IDN are to be transfered.
+ * @param[in]  idn           = IDN.
+ * @param[out] mbx           = mailbox with request
+ */
+static void nexx_SoEreadrequest(nexx_contextt *context, uint16 slave, uint8 driveNo, uint8 elementflags,
+                                uint16 idn, nex_mbxbuft *mbx)
+{
+   nex_SoEt *SoEp;
+   uint8 cnt;
+
+   nex_clearmbx(mbx);
+   SoEp = (nex_SoEt *)mbx;
+   SoEp->MbxHeader.length = htoes(sizeof(nex_SoEt) - sizeof(nex_mbxheadert));
+   SoEp->MbxHeader.address = htoes(0x0000);
+   SoEp->MbxHeader.priority = 0x00;
+   /* get new mailbox count value, used as session handle */
+   cnt = nex_nextmbxcnt(context->slavelist[slave].mbx_cnt);
+   context->slavelist[slave].mbx_cnt = cnt;
+   SoEp->MbxHeader.mbxtype = ECT_MBXT_SOE + (cnt << 4); /* SoE */
+   SoEp->opCode = ECT_SOE_READREQ;
+   SoEp->incomplete = 0;
+   SoEp->error = 0;
+   SoEp->driveNo = driveNo;
+   SoEp->elementflags = elementflags;
+   SoEp->idn = htoes(idn);
+}
+
 /** SoE read, blocking.
  *
  * The IDN object of the selected slave and DriveNo is read. If a response
@@ -77,35 +113,20 @@ void nexx_SoEerror(nexx_contextt *context, uint16 Slave, uint16 idn, uint16 Erro
  */
 int nexx_SoEread(nexx_contextt *context, uint16 slave, uint8 driveNo, uint8 elementflags, uint16 idn, int *psize, void *p, int timeout)
 {
-   nex_SoEt *SoEp, *aSoEp;
+   nex_SoEt *aSoEp;
    uint16 totalsize, framedatasize;
    int wkc;
    uint8 *bp;
    uint8 *mp;
    uint16 *errorcode;
    nex_mbxbuft MbxIn, MbxOut;
-   uint8 cnt;
    boolean NotLast;
 
    nex_clearmbx(&MbxIn);
    /* Empty slave out mailbox if something is in. Timeout set to 0 */
    wkc = nexx_mbxreceive(context, slave, (nex_mbxbuft *)&MbxIn, 0);
-   nex_clearmbx(&MbxOut);
    aSoEp = (nex_SoEt *)&MbxIn;
-   SoEp = (nex_SoEt *)&MbxOut;
-   SoEp->MbxHeader.length = htoes(sizeof(nex_SoEt) - sizeof(nex_mbxheadert));
-   SoEp->MbxHeader.address = htoes(0x0000);
-   SoEp->MbxHeader.priority = 0x00;
-   /* get new mailbox count value, used as session handle */
-   cnt = nex_nextmbxcnt(context->slavelist[slave].mbx_cnt);
-   context->slavelist[slave].mbx_cnt = cnt;
-   SoEp->MbxHeader.mbxtype = ECT_MBXT_SOE + (cnt << 4); /* SoE */
-   SoEp->opCode = ECT_SOE_READREQ;
-   SoEp->incomplete = 0;
-   SoEp->error = 0;
-   SoEp->driveNo = driveNo;
-   SoEp->elementflags = elementflags;
-   SoEp->idn = htoes(idn);
+   nexx_SoEreadrequest(context, slave, driveNo, elementflags, idn, &MbxOut);
    totalsize = 0;
    bp = p;
    mp = (uint8 *)&MbxIn + sizeof(nex_SoEt);
@@ -297,11 +318,215 @@ int nexx_SoEwrite(nexx_contextt *context, uint16 slave, uint8 driveNo, uint8 ele
    return wkc;
 }
 
+/** Initialise SoE IDN attribute cache.
+ *
+ * @param[out] cache      = SoE attribute cache
+ */
+void nexx_SoEcache_init(nex_SoEcachet *cache)
+{
+   memset(cache, 0, sizeof(*cache));
+}
+
+/** Find identity of slave in SoE attribute cache, add it if not found.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number
+ * @return index of identity or -1 if no cache or cache is full.
+ */
+static int nexx_SoEcache_type(nexx_contextt *context, uint16 slave)
+{
+   nex_SoEcachet *cache;
+   nex_SoEcachetypet *type;
+   nex_slavet *sl;
+   int i;
+
+   cache = context->SoEcache;
+   if (!cache)
+   {
+      return -1;
+   }
+   sl = &context->slavelist[slave];
+   for (i = 0; i < cache->ntype; i++)
+   {
+      type = &cache->type[i];
+      if ((type->eep_man == sl->eep_man) && (type->eep_id == sl->eep_id) && (type->eep_rev == sl->eep_rev))
+      {
+         return i;
+      }
+   }
+   if (cache->ntype >= NEX_SOECACHE_MAXTYPE)
+   {
+      return -1;
+   }
+   type = &cache->type[cache->ntype];
+   memset(type, 0, sizeof(*type));
+   type->eep_man = sl->eep_man;
+   type->eep_id = sl->eep_id;
+   type->eep_rev = sl->eep_rev;
+   return cache->ntype++;
+}
+
+/** Find attribute of IDN in SoE attribute cache.
+ *
+ * @param[in]  cache      = SoE attribute cache
+ * @param[in]  type       = index of identity
+ * @param[in]  driveNo    = Drive number in slave
+ * @param[in]  idn        = IDN
+ * @return cached attribute or NULL if not found.
+ */
+static nex_SoEcacheidnt *nexx_SoEcache_lookup(nex_SoEcachet *cache, int type, uint8 driveNo, uint16 idn)
+{
+   int i;
+
+   for (i = 0; i < cache->nidn; i++)
+   {
+      if ((cache->idn[i].type == type) && (cache->idn[i].driveNo == driveNo) && (cache->idn[i].idn == idn))
+      {
+         return &cache->idn[i];
+      }
+   }
+   return NULL;
+}
+
+/** SoE read attributes of many IDNs of one drive.
+ *
+ * Attributes of identical slaves are taken from the SoE attribute cache of the
+ * context. The others are read pipelined, the next request is placed in the slave
+ * mailbox while the slave is still working on the previous one. IDNs the pipeline
+ * could not read are read again with nexx_SoEread.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number
+ * @param[in]  driveNo    = Drive number in slave
+ * @param[in]  n          = number of IDNs
+ * @param[in]  idn        = IDNs
+ * @param[out] attribute  = attribute of each IDN
+ * @param[out] valid      = TRUE for each IDN with attribute read
+ * @return number of attributes read
+ */
+int nexx_readIDNattributes(nexx_contextt *context, uint16 slave, uint8 driveNo, int n, uint16 *idn,
+                           nex_SoEattributet *attribute, int *valid)
+{
+   nex_SoEcachet *cache;
+   nex_SoEcacheidnt *entry;
+   nex_SoEt *aSoEp;
+   nex_mbxbuft MbxIn, MbxOut;
+   nex_datagramt lst;
+   osal_timert timer;
+   int out[NEX_SOE_PIPELINE];
+   int type, i, k, next, nout, moved, psize, nvalid, wkc;
+
+   cache = context->SoEcache;
+   type = nexx_SoEcache_type(context, slave);
+   nvalid = 0;
+   for (i = 0; i < n; i++)
+   {
+      valid[i] = FALSE;
+      entry = (type >= 0) ? nexx_SoEcache_lookup(cache, type, driveNo, idn[i]) : NULL;
+      if (entry)
+      {
+         attribute[i] = entry->attribute;
+         valid[i] = TRUE;
+         nvalid++;
+         cache->hits++;
+      }
+   }
+   aSoEp = (nex_SoEt *)&MbxIn;
+   next = 0;
+   nout = 0;
+   osal_timer_start(&timer, NEX_TIMEOUTRXM);
+   while (osal_timer_is_expired(&timer) == FALSE)
+   {
+      moved = 0;
+      while ((next < n) && valid[next])
+      {
+         next++;
+      }
+      if ((next < n) && (nout < NEX_SOE_PIPELINE))
+      {
+         /* a full mailbox ignores the write, it is tried again next round */
+         nexx_SoEreadrequest(context, slave, driveNo, NEX_SOE_ATTRIBUTE_B, idn[next], &MbxOut);
+         lst.data = &MbxOut;
+         nexx_mbxwrite_multi(context, 1, &slave, &lst, NEX_TIMEOUTRET3);
+         if (lst.wkc > 0)
+         {
+            out[nout++] = next++;
+            moved++;
+         }
+      }
+      if (!nout)
+      {
+         break;
+      }
+      nex_clearmbx(&MbxIn);
+      lst.data = &MbxIn;
+      nexx_mbxpoll_multi(context, 1, &slave, &lst, NEX_TIMEOUTRET3);
+      if ((lst.wkc > 0) && ((aSoEp->MbxHeader.mbxtype & 0x0f) == ECT_MBXT_SOE) &&
+          (aSoEp->opCode == ECT_SOE_READRES) && (aSoEp->driveNo == driveNo))
+      {
+         moved++;
+         /* responses come in order of the requests, the oldest one is answered */
+         i = out[0];
+         nout--;
+         for (k = 0; k < nout; k++)
+         {
+            out[k] = out[k + 1];
+         }
+         if ((aSoEp->error == 0) && (etohs(aSoEp->idn) == idn[i]) &&
+             ((etohs(aSoEp->MbxHeader.length) + sizeof(nex_mbxheadert)) >= (sizeof(nex_SoEt) + sizeof(nex_SoEattributet))))
+         {
+            memcpy(&attribute[i], (uint8 *)&MbxIn + sizeof(nex_SoEt), sizeof(nex_SoEattributet));
+            valid[i] = TRUE;
+            nvalid++;
+            if (cache)
+            {
+               cache->misses++;
+            }
+            if ((type >= 0) && (cache->nidn < NEX_SOECACHE_MAXIDN))
+            {
+               entry = &cache->idn[cache->nidn++];
+               entry->type = (uint8)type;
+               entry->driveNo = driveNo;
+               entry->idn = idn[i];
+               entry->attribute = attribute[i];
+            }
+         }
+      }
+      if (moved)
+      {
+         osal_timer_start(&timer, NEX_TIMEOUTRXM);
+      }
+      else
+      {
+         osal_usleep(NEX_SOE_IDLEDELAY);
+      }
+   }
+   /* errors and lost responses, read one by one to report them */
+   for (i = 0; i < n; i++)
+   {
+      if (!valid[i])
+      {
+         psize = sizeof(nex_SoEattributet);
+         wkc = nexx_SoEread(context, slave, driveNo, NEX_SOE_ATTRIBUTE_B, idn[i], &psize, &attribute[i], NEX_TIMEOUTRXM);
+         if (wkc > 0)
+         {
+            valid[i] = TRUE;
+            nvalid++;
+         }
+      }
+   }
+
+   return nvalid;
+}
+
 /** SoE read AT and MTD mapping.
  *
  * SoE has standard indexes defined for mapping. This function
  * tries to read them and collect a full input and output mapping size
- * of designated slave.
+ * of designated slave. Attributes of the mapped IDNs are read with
+ * nexx_readIDNattributes. Drive numbers that did not answer on the first
+ * slave of an identity are skipped on identical slaves, the mapping of the
+ * drives that did is read for every slave.
  *
  * @param[in]  context = context struct
  * @param[in]  slave   = Slave number
@@ -315,53 +540,76 @@ int nexx_readIDNmap(nexx_contextt *context, uint16 slave, int *Osize, int *Isize
    int   wkc;
    int psize;
    int driveNr;
+   int type;
    uint16 entries, itemcount;
    nex_SoEmappingt     SoEmapping;
-   nex_SoEattributet   SoEattribute;
+   nex_SoEattributet   SoEattribute[NEX_SOE_MAXMAPPING];
+   uint16              idn[NEX_SOE_MAXMAPPING];
+   int                 valid[NEX_SOE_MAXMAPPING];
+   nex_SoEcachetypet   *cachetype;
 
    *Isize = 0;
    *Osize = 0;
+   type = nexx_SoEcache_type(context, slave);
+   cachetype = (type >= 0) ? &context->SoEcache->type[type] : NULL;
    for(driveNr = 0; driveNr < NEX_SOE_MAX_DRIVES; driveNr++)
    {
+      if (cachetype && cachetype->probed && !(cachetype->drives & (1 << driveNr)))
+      {
+         continue;
+      }
       psize = sizeof(SoEmapping);
       /* read output mapping via SoE */
       wkc = nexx_SoEread(context, slave, driveNr, NEX_SOE_VALUE_B, NEX_IDN_MDTCONFIG, &psize, &SoEmapping, NEX_TIMEOUTRXM);
+      /* the drive answered, its mapping is read for every slave of the type */
+      if (cachetype && (wkc > 0))
+      {
+         cachetype->drives |= (uint8)(1 << driveNr);
+      }
       if ((wkc > 0) && (psize >= 4) && ((entries = etohs(SoEmapping.currentlength) / 2) > 0) && (entries <= NEX_SOE_MAXMAPPING))
       {
          /* command word (uint16) is always mapped but not in list */
          *Osize = 16;
+         /* read attribute of each IDN in mapping list */
+         memcpy(idn, SoEmapping.idn, entries * sizeof(uint16));
+         nexx_readIDNattributes(context, slave, driveNr, entries, idn, SoEattribute, valid);
          for (itemcount = 0 ; itemcount < entries ; itemcount++)
          {
-            psize = sizeof(SoEattribute);
-            /* read attribute of each IDN in mapping list */
-            wkc = nexx_SoEread(context, slave, driveNr, NEX_SOE_ATTRIBUTE_B, SoEmapping.idn[itemcount], &psize, &SoEattribute, NEX_TIMEOUTRXM);
-            if ((wkc > 0) && (!SoEattribute.list))
+            if (valid[itemcount] && (!SoEattribute[itemcount].list))
             {
                /* length : 0 = 8bit, 1 = 16bit .... */
-               *Osize += (int)8 << SoEattribute.length;
+               *Osize += (int)8 << SoEattribute[itemcount].length;
             }
          }
       }
       psize = sizeof(SoEmapping);
       /* read input mapping via SoE */
       wkc = nexx_SoEread(context, slave, driveNr, NEX_SOE_VALUE_B, NEX_IDN_ATCONFIG, &psize, &SoEmapping, NEX_TIMEOUTRXM);
+      if (cachetype && (wkc > 0))
+      {
+         cachetype->drives |= (uint8)(1 << driveNr);
+      }
       if ((wkc > 0) && (psize >= 4) && ((entries = etohs(SoEmapping.currentlength) / 2) > 0) && (entries <= NEX_SOE_MAXMAPPING))
       {
          /* status word (uint16) is always mapped but not in list */
          *Isize = 16;
+         /* read attribute of each IDN in mapping list */
+         memcpy(idn, SoEmapping.idn, entries * sizeof(uint16));
+         nexx_readIDNattributes(context, slave, driveNr, entries, idn, SoEattribute, valid);
          for (itemcount = 0 ; itemcount < entries ; itemcount++)
          {
-            psize = sizeof(SoEattribute);
-            /* read attribute of each IDN in mapping list */
-            wkc = nexx_SoEread(context, slave, driveNr, NEX_SOE_ATTRIBUTE_B, SoEmapping.idn[itemcount], &psize, &SoEattribute, NEX_TIMEOUTRXM);
-            if ((wkc > 0) && (!SoEattribute.list))
+            if (valid[itemcount] && (!SoEattribute[itemcount].list))
             {
                /* length : 0 = 8bit, 1 = 16bit .... */
-               *Isize += (int)8 << SoEattribute.length;
+               *Isize += (int)8 << SoEattribute[itemcount].length;
             }
          }
       }
    }
+   if (cachetype)
+   {
+      cachetype->probed = TRUE;
+   }
 
    /* found some I/O bits ? */
    if ((*Isize > 0) || (*Osize > 0))
@@ -386,4 +634,9 @@ int nex_readIDNmap(uint16 slave, int *Osize, int *Isize)
 {
    return nexx_readIDNmap(&nexx_context, slave, Osize, Isize);
 }
+
+int nex_readIDNattributes(uint16 slave, uint8 driveNo, int n, uint16 *idn, nex_SoEattributet *attribute, int *valid)
+{
+   return nexx_readIDNattributes(&nexx_context, slave, driveNo, n, idn, attribute, valid);
+}
 #endif
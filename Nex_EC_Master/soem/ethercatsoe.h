@@ -113,15 +113,61 @@ typedef struct PACKED
 } nex_SoEattributet;
 PACKED_END
 
+/** max number of distinct slave identities in SoE attribute cache */
+#define NEX_SOECACHE_MAXTYPE  8
+/** max number of cached IDN attributes, all identities together */
+#define NEX_SOECACHE_MAXIDN   256
+
+/** cached attribute of one IDN of one drive */
+typedef struct
+{
+   /** index in type list */
+   uint8      type;
+   uint8      driveNo;
+   uint16     idn;
+   nex_SoEattributet attribute;
+} nex_SoEcacheidnt;
+
+/** SoE slave identity in attribute cache */
+typedef struct
+{
+   /** identity from SII */
+   uint32     eep_man;
+   uint32     eep_id;
+   uint32     eep_rev;
+   /** TRUE if drives of identity have been probed */
+   uint8      probed;
+   /** drives that answered the MDT or AT mapping read, bit per drive number */
+   uint8      drives;
+} nex_SoEcachetypet;
+
+/** SoE IDN attribute cache, shared by all slaves with identical identity */
+typedef struct nex_SoEcache
+{
+   /** number of used identities */
+   int        ntype;
+   nex_SoEcachetypet type[NEX_SOECACHE_MAXTYPE];
+   /** number of used IDN entries */
+   int        nidn;
+   nex_SoEcacheidnt idn[NEX_SOECACHE_MAXIDN];
+   /** statistics, attributes found in cache and attributes read from slave */
+   uint32     hits;
+   uint32     misses;
+} nex_SoEcachet;
+
 #ifdef NEX_VER1
 int nex_SoEread(uint16 slave, uint8 driveNo, uint8 elementflags, uint16 idn, int *psize, void *p, int timeout);
 int nex_SoEwrite(uint16 slave, uint8 driveNo, uint8 elementflags, uint16 idn, int psize, void *p, int timeout);
 int nex_readIDNmap(uint16 slave, int *Osize, int *Isize);
+int nex_readIDNattributes(uint16 slave, uint8 driveNo, int n, uint16 *idn, nex_SoEattributet *attribute, int *valid);
 #endif
 
 int nexx_SoEread(nexx_contextt *context, uint16 slave, uint8 driveNo, uint8 elementflags, uint16 idn, int *psize, void *p, int timeout);
 int nexx_SoEwrite(nexx_contextt *context, uint16 slave, uint8 driveNo, uint8 elementflags, uint16 idn, int psize, void *p, int timeout);
 int nexx_readIDNmap(nexx_contextt *context, uint16 slave, int *Osize, int *Isize);
+int nexx_readIDNattributes(nexx_contextt *context, uint16 slave, uint8 driveNo, int n, uint16 *idn,
+                           nex_SoEattributet *attribute, int *valid);
+void nexx_SoEcache_init(nex_SoEcachet *cache);
 
 #ifdef __cplusplus
 }
@@ -55,6 +55,8 @@ extern "C"
 #define NEX_TIMEOUTRET      2000
 /** timeout value in us for safe data transfer, max. triple retry */
 #define NEX_TIMEOUTRET3     (NEX_TIMEOUTRET * 3)
+/** minimum wait in us before a processdata frame is overdue for retransmission */
+#define NEX_TIMEOUTRETX     50
 /** timeout value in us for return "safe" variant (f.e. wireless) */
 #define NEX_TIMEOUTSAFE     20000
 /** timeout value in us for EEPROM access */
@@ -365,6 +367,21 @@ enum
    ECT_FOE_BUSY
 };
 
+/** EoE frame types */
+enum
+{
+   ECT_EOE_FRAGDATA       = 0x00,
+   ECT_EOE_INITRESP_TS,
+   ECT_EOE_INITREQ,
+   ECT_EOE_INITRESP,
+   ECT_EOE_SETFILTERREQ,
+   ECT_EOE_SETFILTERRESP,
+   ECT_EOE_GETIPREQ,
+   ECT_EOE_GETIPRESP,
+   ECT_EOE_GETFILTERREQ,
+   ECT_EOE_GETFILTERRESP
+};
+
 /** SoE opcodes */
 enum
 {
@@ -459,7 +476,9 @@ typedef enum
    NEX_ERR_TYPE_FOE_PACKETNUMBER  = 7,
    NEX_ERR_TYPE_SOE_ERROR         = 8,
    NEX_ERR_TYPE_MBX_ERROR         = 9,
-   NEX_ERR_TYPE_FOE_FILE_NOTFOUND = 10
+   NEX_ERR_TYPE_FOE_FILE_NOTFOUND = 10,
+   NEX_ERR_TYPE_EOE_ERROR         = 11,
+   NEX_ERR_TYPE_EOE_INVALID_RX_DATA = 12
 } nex_err_type;
 
 /** Struct to retrieve errors. */
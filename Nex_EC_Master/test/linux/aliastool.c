@@ -177,53 +177,13 @@ int output_intelhex(char *fname, int length)
 
 int eeprom_read(int slave, int start, int length)
 {
-   int i, wkc, ainc = 4;
-   uint16 estat, aiadr;
-   uint32 b4;
-   uint64 b8;
-   uint8 eepctl;
+   nex_eeprombulkt b;
 
-   if((ec_slavecount >= slave) && (slave > 0) && ((start + length) <= MAXBUF))
+   if((nex_slavecount >= slave) && (slave > 0) && ((start + length) <= MAXBUF))
    {
-      aiadr = 1 - slave;
-      eepctl = 2;
-      wkc = ec_APWR(aiadr, ECT_REG_EEPCFG, sizeof(eepctl), &eepctl , EC_TIMEOUTRET); /* force Eeprom from PDI */
-      eepctl = 0;
-      wkc = ec_APWR(aiadr, ECT_REG_EEPCFG, sizeof(eepctl), &eepctl , EC_TIMEOUTRET); /* set Eeprom to master */
-
-      estat = 0x0000;
-      aiadr = 1 - slave;
-      wkc=ec_APRD(aiadr, ECT_REG_EEPSTAT, sizeof(estat), &estat, EC_TIMEOUTRET); /* read eeprom status */
-      estat = etohs(estat);
-      if (estat & EC_ESTAT_R64)
-      {
-         ainc = 8;
-         for (i = start ; i < (start + length) ; i+=ainc)
-         {
-            b8 = ec_readeepromAP(aiadr, i >> 1 , EC_TIMEOUTEEP);
-            ebuf[i] = b8;
-            ebuf[i+1] = b8 >> 8;
-            ebuf[i+2] = b8 >> 16;
-            ebuf[i+3] = b8 >> 24;
-            ebuf[i+4] = b8 >> 32;
-            ebuf[i+5] = b8 >> 40;
-            ebuf[i+6] = b8 >> 48;
-            ebuf[i+7] = b8 >> 56;
-         }
-      }
-      else
-      {
-         for (i = start ; i < (start + length) ; i+=ainc)
-         {
-            b4 = ec_readeepromAP(aiadr, i >> 1 , EC_TIMEOUTEEP);
-            ebuf[i] = b4;
-            ebuf[i+1] = b4 >> 8;
-            ebuf[i+2] = b4 >> 16;
-            ebuf[i+3] = b4 >> 24;
-         }
-      }
-
-      return 1;
+      b.slave = slave;
+      b.buf = &ebuf[start];
+      return nex_readeeprom_multi(1, &b, start >> 1, (length + 1) >> 1, NEX_TIMEOUTEEP);
    }
 
    return 0;
@@ -231,33 +191,13 @@ int eeprom_read(int slave, int start, int length)
 
 int eeprom_write(int slave, int start, int length)
 {
-   int i, wkc, dc = 0;
-   uint16 aiadr, *wbuf;
-   uint8 eepctl;
-   int ret;
+   nex_eeprombulkt b;
 
-   if((ec_slavecount >= slave) && (slave > 0) && ((start + length) <= MAXBUF))
+   if((nex_slavecount >= slave) && (slave > 0) && ((start + length) <= MAXBUF))
    {
-      aiadr = 1 - slave;
-      eepctl = 2;
-      wkc = ec_APWR(aiadr, ECT_REG_EEPCFG, sizeof(eepctl), &eepctl , EC_TIMEOUTRET); /* force Eeprom from PDI */
-      eepctl = 0;
-      wkc = ec_APWR(aiadr, ECT_REG_EEPCFG, sizeof(eepctl), &eepctl , EC_TIMEOUTRET); /* set Eeprom to master */
-
-      aiadr = 1 - slave;
-      wbuf = (uint16 *)&ebuf[0];
-      for (i = start ; i < (start + length) ; i+=2)
-      {
-         ret = ec_writeeepromAP(aiadr, i >> 1 , *(wbuf + (i >> 1)), EC_TIMEOUTEEP);
-         if (++dc >= 100)
-         {
-            dc = 0;
-            printf(".");
-            fflush(stdout);
-         }
-      }
-
-      return 1;
+      b.slave = slave;
+      b.buf = &ebuf[start];
+      return nex_writeeeprom_multi(1, &b, start >> 1, (length + 1) >> 1, TRUE, NEX_TIMEOUTEEP);
    }
 
    return 0;
@@ -265,22 +205,17 @@ int eeprom_write(int slave, int start, int length)
 
 int eeprom_writealias(int slave, int alias)
 {
-   int i, wkc, dc = 0;
-   uint16 aiadr, *wbuf;
-   uint8 eepctl;
-   int ret;
+   nex_eeprombulkt b;
+   uint16 *wbuf;
 
-   if((ec_slavecount >= slave) && (slave > 0) && (alias <= 0xffff))
+   if((nex_slavecount >= slave) && (slave > 0) && (alias <= 0xffff) && eeprom_read(slave, 0, 16))
    {
-      aiadr = 1 - slave;
-      eepctl = 2;
-      wkc = ec_APWR(aiadr, ECT_REG_EEPCFG, sizeof(eepctl), &eepctl , EC_TIMEOUTRET); /* force Eeprom from PDI */
-      eepctl = 0;
-      wkc = ec_APWR(aiadr, ECT_REG_EEPCFG, sizeof(eepctl), &eepctl , EC_TIMEOUTRET); /* set Eeprom to master */
-
-      ret = ec_writeeepromAP(aiadr, 0x04 , alias, EC_TIMEOUTEEP);
-
-      return ret;
+      wbuf = (uint16 *)&ebuf[0];
+      *(wbuf + 0x04) = htoes(alias);
+      b.slave = slave;
+      b.buf = &ebuf[0];
+      /* words 0 to 7, the checksum in word 7 is recalculated */
+      return nex_writeeeprom_multi(1, &b, 0, 8, TRUE, NEX_TIMEOUTEEP);
    }
 
    return 0;
@@ -288,22 +223,19 @@ int eeprom_writealias(int slave, int alias)
 
 void eepromtool(char *ifname, int slave, int mode, char *fname)
 {
-   int w, rc = 0, estart, esize;
+   int rc = 0, estart, esize;
    uint16 *wbuf;
 
    /* initialise SOEM, bind socket to ifname */
-   if (ec_init(ifname))
+   if (nex_init(ifname))
    {
-      printf("ec_init on %s succeeded.\n",ifname);
+      printf("nex_init on %s succeeded.\n",ifname);
 
-      w = 0x0000;
-       wkc = ec_BRD(0x0000, ECT_REG_TYPE, sizeof(w), &w, EC_TIMEOUTSAFE);      /* detect number of slaves */
-       if (wkc > 0)
-       {
-         ec_slavecount = wkc;
-
-         printf("%d slaves found.\n",ec_slavecount);
-         if((ec_slavecount >= slave) && (slave > 0))
+      /* configured station addresses are needed for the bulk transfers */
+      if (nex_config_init() > 0)
+      {
+         printf("%d slaves found.\n",nex_slavecount);
+         if((nex_slavecount >= slave) && (slave > 0))
          {
             if ((mode == MODE_INFO) || (mode == MODE_READBIN) || (mode == MODE_READINTEL))
             {
@@ -368,7 +300,7 @@ void eepromtool(char *ifname, int slave, int mode, char *fname)
             if (mode == MODE_WRITEALIAS)
 			{
 			  if(eeprom_writealias(slave, alias))
-			    printf("Alias %4.4X written successfully to slave %d\n");
+			    printf("Alias %4.4X written successfully to slave %d\n", alias, slave);
 			  else
                 printf("Alias not written\n");
 			}
@@ -380,7 +312,7 @@ void eepromtool(char *ifname, int slave, int mode, char *fname)
          printf("No slaves found!\n");
       printf("End, close socket\n");
       /* stop SOEM, close socket */
-      ec_close();
+      nex_close();
    }
    else
       printf("No socket connection on %s\nExcecute as root\n",ifname);
@@ -404,7 +336,7 @@ int main(int argc, char *argv[])
         if ((strncmp(argv[3], "-walias", sizeof("-walias")) == 0))
 	    {
 	       mode = MODE_WRITEALIAS;
-		   alias = atoi(argv(4));
+		   alias = atoi(argv[4]);
 	    }
       }
       /* start tool */
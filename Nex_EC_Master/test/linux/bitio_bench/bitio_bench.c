@@ -0,0 +1,188 @@
+/** \file
+ * \brief Example code for Simple Open EtherCAT master
+ *
+ * Usage : bitio_bench [iterations]
+ * iterations per measurement, default 20000
+ *
+ * Benchmark of the bit I/O plan. Builds a process image of 100 digital slaves
+ * without a network, bit packed like nex_config_map does, with 1k to 10k I/O
+ * points. Compares nexx_bitio_expand and nexx_bitio_pack with extracting and
+ * setting every bit with shifts and masks, and checks that both agree.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "ethercat.h"
+
+#define NSLAVE    100
+#define MAXPOINTS 10000
+
+uint8 IOmap[MAXPOINTS / 8 + NSLAVE];
+uint8 inref[MAXPOINTS], in[MAXPOINTS];
+uint8 out[MAXPOINTS];
+uint8 outref[sizeof(IOmap)], saved[sizeof(IOmap)];
+nex_slavet slavelist[NSLAVE + 1];
+int slavecount = NSLAVE;
+nex_bitiot plan;
+
+/* outputs then inputs, bit packed, every 5th slave starts at a byte */
+void layout(int points)
+{
+   uint32 bit, w;
+   int slave, dir;
+
+   memset(slavelist, 0, sizeof(slavelist));
+   bit = 0;
+   for (dir = 0; dir < 2; dir++)
+   {
+      for (slave = 1; slave <= NSLAVE; slave++)
+      {
+         w = (points / 2 / NSLAVE) + ((slave & 1) ? 3 : -3);
+         if (!(slave % 5))
+         {
+            bit = (bit + 7) & ~7;
+         }
+         if (dir == 0)
+         {
+            slavelist[slave].outputs = IOmap + (bit >> 3);
+            slavelist[slave].Ostartbit = (uint8)(bit & 7);
+            slavelist[slave].Obits = (uint16)w;
+         }
+         else
+         {
+            slavelist[slave].inputs = IOmap + (bit >> 3);
+            slavelist[slave].Istartbit = (uint8)(bit & 7);
+            slavelist[slave].Ibits = (uint16)w;
+         }
+         bit += w;
+      }
+   }
+}
+
+/* bit by bit with shifts and masks */
+void naive_expand(void)
+{
+   nex_slavet *sl;
+   int slave, b, n, i = 0;
+
+   for (slave = 1; slave <= NSLAVE; slave++)
+   {
+      sl = &slavelist[slave];
+      for (b = 0; b < sl->Ibits; b++)
+      {
+         n = sl->Istartbit + b;
+         inref[i++] = (sl->inputs[n >> 3] >> (n & 7)) & 1;
+      }
+   }
+}
+
+void naive_pack(void)
+{
+   nex_slavet *sl;
+   int slave, b, n, i = 0;
+
+   for (slave = 1; slave <= NSLAVE; slave++)
+   {
+      sl = &slavelist[slave];
+      for (b = 0; b < sl->Obits; b++)
+      {
+         n = sl->Ostartbit + b;
+         if (out[i++])
+         {
+            sl->outputs[n >> 3] |= (uint8)(1 << (n & 7));
+         }
+         else
+         {
+            sl->outputs[n >> 3] &= (uint8)~(1 << (n & 7));
+         }
+      }
+   }
+}
+
+double measure(void (*fn)(void), int iterations)
+{
+   nex_timet t0, t1, diff;
+   int i;
+
+   t0 = osal_current_time();
+   for (i = 0; i < iterations; i++)
+   {
+      fn();
+   }
+   t1 = osal_current_time();
+   osal_time_diff(&t0, &t1, &diff);
+   return ((diff.sec * 1e9) + (diff.usec * 1e3)) / iterations;
+}
+
+void plan_expand(void)
+{
+   nexx_bitio_expand(&plan, in);
+}
+
+void plan_pack(void)
+{
+   nexx_bitio_pack(&plan, out);
+}
+
+void bitio_bench(int iterations)
+{
+   static const int pointlist[] = {1000, 2000, 5000, 10000};
+   nexx_contextt context;
+   double tne, tnp, tpe, tpp;
+   uint32 i;
+   int p, points, ok;
+
+   memset(&context, 0, sizeof(context));
+   context.slavelist = slavelist;
+   context.slavecount = &slavecount;
+   printf("Kernel %s\n", nexx_bitio_kernel());
+   printf("points  runs  naive expand  plan expand  naive pack  plan pack  (ns per cycle)\n");
+   for (p = 0; p < (int)(sizeof(pointlist) / sizeof(pointlist[0])); p++)
+   {
+      points = pointlist[p];
+      layout(points);
+      nexx_bitio_compile(&context, &plan, 0, 0);
+      for (i = 0; i < sizeof(IOmap); i++)
+      {
+         IOmap[i] = (uint8)rand();
+      }
+      for (i = 0; i < plan.noutputs; i++)
+      {
+         out[i] = (uint8)((rand() & 1) * (rand() & 0xff));
+      }
+      /* same result bit by bit and with the plan */
+      naive_expand();
+      nexx_bitio_expand(&plan, in);
+      ok = !memcmp(in, inref, plan.ninputs);
+      memcpy(saved, IOmap, sizeof(IOmap));
+      naive_pack();
+      memcpy(outref, IOmap, sizeof(IOmap));
+      memcpy(IOmap, saved, sizeof(IOmap));
+      nexx_bitio_pack(&plan, out);
+      ok = ok && !memcmp(outref, IOmap, sizeof(IOmap));
+      tne = measure(naive_expand, iterations);
+      tpe = measure(plan_expand, iterations);
+      tnp = measure(naive_pack, iterations);
+      tpp = measure(plan_pack, iterations);
+      printf("%6d  %4d  %12.0f  %11.0f  %10.0f  %9.0f  %s\n", plan.ninputs + plan.noutputs,
+         plan.nirun + plan.norun, tne, tpe, tnp, tpp, ok ? "OK" : "MISMATCH");
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   int iterations = 20000;
+
+   printf("SOEM (Simple Open EtherCAT Master)\nBit I/O benchmark\n");
+
+   if (argc > 1)
+   {
+      iterations = atoi(argv[1]);
+   }
+   bitio_bench(iterations);
+
+   printf("End program\n");
+   return (0);
+}
@@ -3,7 +3,7 @@
  *
  * Usage : eepromtool ifname slave OPTION fname|alias
  * ifname is NIC interface, f.e. eth0
- * slave = slave number in EtherCAT order 1..n
+ * slave = slave number in EtherCAT order 1..n, or first-last for a range
  * -r      read EEPROM, output binary format
  * -ri     read EEPROM, output Intel Hex format
  * -w      write EEPROM, input binary format
@@ -36,44 +36,23 @@
 #define MAXSLENGTH        256
 
 uint8 ebuf[MAXBUF];
+/* EEPROM data per slave, allocated for a range of slaves */
+uint8 *sbuf[NEX_MAXSLAVE];
+uint8 sdone[NEX_MAXSLAVE];
+nex_eeprombulkt blst[NEX_MAXSLAVE];
+int lastslave;
 uint8 ob;
 uint16 ow;
 int os;
 int slave;
 int alias;
-ec_timet tstart,tend, tdif;
+nex_timet tstart,tend, tdif;
 int wkc;
 int mode;
 char sline[MAXSLENGTH];
 
 #define IHEXLENGTH 0x20
 
-void calc_crc(uint8 *crc, uint8 b)
-{
-   int j;
-   *crc ^= b;
-   for(j = 0; j <= 7 ; j++ )
-   {
-     if(*crc & 0x80)
-        *crc = (*crc << 1) ^ 0x07;
-     else
-        *crc = (*crc << 1);
-   }
-}
-
-uint16 SIIcrc(uint8 *buf)
-{
-   int i;
-   uint8 crc;
-
-   crc = 0xff;
-   for( i = 0 ; i <= 13 ; i++ )
-   {
-      calc_crc(&crc , *(buf++));
-   }
-   return (uint16)crc;
-}
-
 int input_bin(char *fname, int *length)
 {
    FILE *fp;
@@ -199,167 +178,207 @@ int output_intelhex(char *fname, int length)
    return 1;
 }
 
-int eeprom_read(int slave, int start, int length)
+int eeprom_read(int first, int last, int start, int length)
 {
-   int i, ainc = 4;
-   uint16 estat, aiadr;
-   uint32 b4;
-   uint64 b8;
-   uint8 eepctl;
+   int i, n;
 
-   if((ec_slavecount >= slave) && (slave > 0) && ((start + length) <= MAXBUF))
+   if((nex_slavecount >= last) && (first > 0) && (first <= last) && ((start + length) <= MAXBUF))
    {
-      aiadr = 1 - slave;
-      eepctl = 2;
-      ec_APWR(aiadr, ECT_REG_EEPCFG, sizeof(eepctl), &eepctl , EC_TIMEOUTRET); /* force Eeprom from PDI */
-      eepctl = 0;
-      ec_APWR(aiadr, ECT_REG_EEPCFG, sizeof(eepctl), &eepctl , EC_TIMEOUTRET); /* set Eeprom to master */
-
-      estat = 0x0000;
-      aiadr = 1 - slave;
-      ec_APRD(aiadr, ECT_REG_EEPSTAT, sizeof(estat), &estat, EC_TIMEOUTRET); /* read eeprom status */
-      estat = etohs(estat);
-      if (estat & EC_ESTAT_R64)
-      {
-         ainc = 8;
-         for (i = start ; i < (start + length) ; i+=ainc)
-         {
-            b8 = ec_readeepromAP(aiadr, i >> 1 , EC_TIMEOUTEEP);
-            ebuf[i] = b8 & 0xFF;
-            ebuf[i+1] = (b8 >> 8) & 0xFF;
-            ebuf[i+2] = (b8 >> 16) & 0xFF;
-            ebuf[i+3] = (b8 >> 24) & 0xFF;
-            ebuf[i+4] = (b8 >> 32) & 0xFF;
-            ebuf[i+5] = (b8 >> 40) & 0xFF;
-            ebuf[i+6] = (b8 >> 48) & 0xFF;
-            ebuf[i+7] = (b8 >> 56) & 0xFF;
-         }
-      }
-      else
+      n = 0;
+      for (i = first ; i <= last ; i++)
       {
-         for (i = start ; i < (start + length) ; i+=ainc)
-         {
-            b4 = ec_readeepromAP(aiadr, i >> 1 , EC_TIMEOUTEEP) & 0xFFFFFFFF;
-            ebuf[i] = b4 & 0xFF;
-            ebuf[i+1] = (b4 >> 8) & 0xFF;
-            ebuf[i+2] = (b4 >> 16) & 0xFF;
-            ebuf[i+3] = (b4 >> 24) & 0xFF;
-         }
+         blst[n].slave = i;
+         blst[n].buf = &sbuf[i][start];
+         n++;
       }
-
-      return 1;
+      return (nex_readeeprom_multi(n, blst, start >> 1, (length + 1) >> 1, NEX_TIMEOUTEEP) == n);
    }
 
    return 0;
 }
 
-int eeprom_write(int slave, int start, int length)
+int eeprom_write(int first, int last, int start, int length)
 {
-   int i, dc = 0;
-   uint16 aiadr, *wbuf;
-   uint8 eepctl;
+   int i, n;
 
-   if((ec_slavecount >= slave) && (slave > 0) && ((start + length) <= MAXBUF))
+   if((nex_slavecount >= last) && (first > 0) && (first <= last) && ((start + length) <= MAXBUF))
    {
-      aiadr = 1 - slave;
-      eepctl = 2;
-      ec_APWR(aiadr, ECT_REG_EEPCFG, sizeof(eepctl), &eepctl , EC_TIMEOUTRET); /* force Eeprom from PDI */
-      eepctl = 0;
-      ec_APWR(aiadr, ECT_REG_EEPCFG, sizeof(eepctl), &eepctl , EC_TIMEOUTRET); /* set Eeprom to master */
-
-      aiadr = 1 - slave;
-      wbuf = (uint16 *)&ebuf[0];
-      for (i = start ; i < (start + length) ; i+=2)
+      n = 0;
+      for (i = first ; i <= last ; i++)
       {
-         ec_writeeepromAP(aiadr, i >> 1 , *(wbuf + (i >> 1)), EC_TIMEOUTEEP);
-         if (++dc >= 100)
-         {
-            dc = 0;
-            printf(".");
-            fflush(stdout);
-         }
+         blst[n].slave = i;
+         blst[n].buf = &ebuf[start];
+         n++;
       }
-
-      return 1;
+      /* checksum is recalculated by the master when the image covers it */
+      return (nex_writeeeprom_multi(n, blst, start >> 1, (length + 1) >> 1, TRUE, NEX_TIMEOUTEEP) == n);
    }
 
    return 0;
 }
 
-int eeprom_writealias(int slave, int alias, uint16 crc)
+int eeprom_writealias(int first, int last, int alias)
 {
-   uint16 aiadr;
-   uint8 eepctl;
-   int ret;
+   int i, n;
+   uint16 *wbuf;
 
-   if((ec_slavecount >= slave) && (slave > 0) && (alias <= 0xffff))
+   if((nex_slavecount >= last) && (first > 0) && (first <= last) && ((alias + last - first) <= 0xffff))
    {
-      aiadr = 1 - slave;
-      eepctl = 2;
-      ec_APWR(aiadr, ECT_REG_EEPCFG, sizeof(eepctl), &eepctl , EC_TIMEOUTRET); /* force Eeprom from PDI */
-      eepctl = 0;
-      ec_APWR(aiadr, ECT_REG_EEPCFG, sizeof(eepctl), &eepctl , EC_TIMEOUTRET); /* set Eeprom to master */
-
-      ret = ec_writeeepromAP(aiadr, 0x04 , alias, EC_TIMEOUTEEP);
-      if (ret)
-        ret = ec_writeeepromAP(aiadr, 0x07 , crc, EC_TIMEOUTEEP);
-
-      return ret;
+      n = 0;
+      for (i = first ; i <= last ; i++)
+      {
+         /* consecutive aliases for a range of slaves */
+         wbuf = (uint16 *)&sbuf[i][0];
+         *(wbuf + 0x04) = htoes(alias + i - first);
+         blst[n].slave = i;
+         blst[n].buf = &sbuf[i][0];
+         n++;
+      }
+      /* write words 0 to 7, the checksum in word 7 is recalculated */
+      return (nex_writeeeprom_multi(n, blst, 0, CRCBUF >> 1, TRUE, NEX_TIMEOUTEEP) == n);
    }
 
    return 0;
 }
 
-void eepromtool(char *ifname, int slave, int mode, char *fname)
+void printresult(int first, int last)
 {
-   int w, rc = 0, estart, esize;
+   int i;
+
+   for (i = first ; i <= last ; i++)
+   {
+      if (blst[i - first].result < 0)
+      {
+         printf(" Slave %d failed%s\n", i, (blst[i - first].result == -2) ? ", verify error" : "");
+      }
+   }
+}
+
+void eepromtool(char *ifname, int first, int last, int mode, char *fname)
+{
+   int i, rc = 0, estart, esize, rsize;
    uint16 *wbuf;
+   char name[MAXSLENGTH];
 
    /* initialise SOEM, bind socket to ifname */
-   if (ec_init(ifname))
+   if (nex_init(ifname))
    {
-      printf("ec_init on %s succeeded.\n",ifname);
+      printf("nex_init on %s succeeded.\n",ifname);
 
-      w = 0x0000;
-       wkc = ec_BRD(0x0000, ECT_REG_TYPE, sizeof(w), &w, EC_TIMEOUTSAFE);      /* detect number of slaves */
-       if (wkc > 0)
-       {
-         ec_slavecount = wkc;
-
-         printf("%d slaves found.\n",ec_slavecount);
-         if((ec_slavecount >= slave) && (slave > 0))
+      /* configured station addresses are needed for the bulk transfers */
+      if (nex_config_init() > 0)
+      {
+         printf("%d slaves found.\n",nex_slavecount);
+         if((nex_slavecount >= last) && (first > 0) && (first <= last) && (last < NEX_MAXSLAVE))
          {
+            for (i = first ; i <= last ; i++)
+            {
+               sbuf[i] = calloc(1, MINBUF);
+               sdone[i] = 0;
+            }
             if ((mode == MODE_INFO) || (mode == MODE_READBIN) || (mode == MODE_READINTEL))
             {
                tstart = osal_current_time();
-               eeprom_read(slave, 0x0000, MINBUF); // read first 128 bytes
-
-               wbuf = (uint16 *)&ebuf[0];
-               printf("Slave %d data\n", slave);
-               printf(" PDI Control      : %4.4X\n",*(wbuf + 0x00));
-               printf(" PDI Config       : %4.4X\n",*(wbuf + 0x01));
-               printf(" Config Alias     : %4.4X\n",*(wbuf + 0x04));
-               printf(" Checksum         : %4.4X\n",*(wbuf + 0x07));
-               printf("   calculated     : %4.4X\n",SIIcrc(&ebuf[0]));
-               printf(" Vendor ID        : %8.8X\n",*(uint32 *)(wbuf + 0x08));
-               printf(" Product Code     : %8.8X\n",*(uint32 *)(wbuf + 0x0A));
-               printf(" Revision Number  : %8.8X\n",*(uint32 *)(wbuf + 0x0C));
-               printf(" Serial Number    : %8.8X\n",*(uint32 *)(wbuf + 0x0E));
-               printf(" Mailbox Protocol : %4.4X\n",*(wbuf + 0x1C));
-               esize = (*(wbuf + 0x3E) + 1) * 128;
-               if (esize > MAXBUF) esize = MAXBUF;
-               printf(" Size             : %4.4X = %d bytes\n",*(wbuf + 0x3E), esize);
-               printf(" Version          : %4.4X\n",*(wbuf + 0x3F));
+               if (!eeprom_read(first, last, 0x0000, MINBUF)) // read first 128 bytes
+               {
+                  printresult(first, last);
+               }
+               for (i = first ; i <= last ; i++)
+               {
+                  wbuf = (uint16 *)&sbuf[i][0];
+                  if (first == last)
+                  {
+                     printf("Slave %d data\n", i);
+                     printf(" PDI Control      : %4.4X\n",*(wbuf + 0x00));
+                     printf(" PDI Config       : %4.4X\n",*(wbuf + 0x01));
+                     printf(" Config Alias     : %4.4X\n",*(wbuf + 0x04));
+                     printf(" Checksum         : %4.4X\n",*(wbuf + 0x07));
+                     printf("   calculated     : %4.4X\n",nex_siicrc(&sbuf[i][0]));
+                     printf(" Vendor ID        : %8.8X\n",*(uint32 *)(wbuf + 0x08));
+                     printf(" Product Code     : %8.8X\n",*(uint32 *)(wbuf + 0x0A));
+                     printf(" Revision Number  : %8.8X\n",*(uint32 *)(wbuf + 0x0C));
+                     printf(" Serial Number    : %8.8X\n",*(uint32 *)(wbuf + 0x0E));
+                     printf(" Mailbox Protocol : %4.4X\n",*(wbuf + 0x1C));
+                     esize = (*(wbuf + 0x3E) + 1) * 128;
+                     if (esize > MAXBUF) esize = MAXBUF;
+                     printf(" Size             : %4.4X = %d bytes\n",*(wbuf + 0x3E), esize);
+                     printf(" Version          : %4.4X\n",*(wbuf + 0x3F));
+                  }
+                  else
+                  {
+                     printf("Slave %3d alias %4.4X vendor %8.8X product %8.8X rev %8.8X serial %8.8X size %d crc %s\n",
+                        i, *(wbuf + 0x04), *(uint32 *)(wbuf + 0x08), *(uint32 *)(wbuf + 0x0A),
+                        *(uint32 *)(wbuf + 0x0C), *(uint32 *)(wbuf + 0x0E), (*(wbuf + 0x3E) + 1) * 128,
+                        (*(wbuf + 0x07) == nex_siicrc(&sbuf[i][0])) ? "OK" : "wrong");
+                  }
+               }
             }
             if ((mode == MODE_READBIN) || (mode == MODE_READINTEL))
             {
-               if (esize > MINBUF)
-                  eeprom_read(slave, MINBUF, esize - MINBUF); // read reminder
+               /* read the remainder of all slaves with equal EEPROM size together */
+               do
+               {
+                  rsize = 0;
+                  for (i = first ; i <= last ; i++)
+                  {
+                     wbuf = (uint16 *)&sbuf[i][0];
+                     esize = (*(wbuf + 0x3E) + 1) * 128;
+                     if (esize > MAXBUF) esize = MAXBUF;
+                     if ((esize > rsize) && (!sdone[i]))
+                     {
+                        rsize = esize;
+                     }
+                  }
+                  if (rsize)
+                  {
+                     rc = 0;
+                     for (i = first ; i <= last ; i++)
+                     {
+                        wbuf = (uint16 *)&sbuf[i][0];
+                        esize = (*(wbuf + 0x3E) + 1) * 128;
+                        if (esize > MAXBUF) esize = MAXBUF;
+                        if ((esize == rsize) && (!sdone[i]))
+                        {
+                           if (rsize > MINBUF)
+                           {
+                              sbuf[i] = realloc(sbuf[i], rsize);
+                              blst[rc].slave = i;
+                              blst[rc].buf = &sbuf[i][MINBUF];
+                              rc++;
+                           }
+                           sdone[i] = 1;
+                        }
+                     }
+                     if (rc && (nex_readeeprom_multi(rc, blst, MINBUF >> 1, (rsize - MINBUF) >> 1, NEX_TIMEOUTEEP) != rc))
+                     {
+                        for (i = 0 ; i < rc ; i++)
+                        {
+                           if (blst[i].result < 0)
+                           {
+                              printf(" Slave %d failed\n", blst[i].slave);
+                           }
+                        }
+                     }
+                  }
+               }
+               while (rsize);
 
                tend = osal_current_time();
                osal_time_diff(&tstart, &tend, &tdif);
-               if (mode == MODE_READINTEL) output_intelhex(fname, esize);
-               if (mode == MODE_READBIN)   output_bin(fname, esize);
+               for (i = first ; i <= last ; i++)
+               {
+                  wbuf = (uint16 *)&sbuf[i][0];
+                  esize = (*(wbuf + 0x3E) + 1) * 128;
+                  if (esize > MAXBUF) esize = MAXBUF;
+                  memcpy(ebuf, &sbuf[i][0], esize);
+                  /* one file per slave for a range */
+                  if (first == last)
+                     snprintf(name, sizeof(name), "%s", fname);
+                  else
+                     snprintf(name, sizeof(name), "%s.%d", fname, i);
+                  if (mode == MODE_READINTEL) output_intelhex(name, esize);
+                  if (mode == MODE_READBIN)   output_bin(name, esize);
+               }
 
                printf("\nTotal EEPROM read time :%ldms\n", (tdif.usec+(tdif.sec*1000000L)) / 1000);
             }
@@ -372,7 +391,7 @@ void eepromtool(char *ifname, int slave, int mode, char *fname)
                if (rc > 0)
                {
                   wbuf = (uint16 *)&ebuf[0];
-                  printf("Slave %d\n", slave);
+                  printf("Slave %d..%d\n", first, last);
                   printf(" Vendor ID        : %8.8X\n",*(uint32 *)(wbuf + 0x08));
                   printf(" Product Code     : %8.8X\n",*(uint32 *)(wbuf + 0x0A));
                   printf(" Revision Number  : %8.8X\n",*(uint32 *)(wbuf + 0x0C));
@@ -381,7 +400,15 @@ void eepromtool(char *ifname, int slave, int mode, char *fname)
                   printf("Busy");
                   fflush(stdout);
                   tstart = osal_current_time();
-                  eeprom_write(slave, estart, esize);
+                  if (eeprom_write(first, last, estart, esize))
+                  {
+                     printf("\nWritten and verified\n");
+                  }
+                  else
+                  {
+                     printf("\n");
+                     printresult(first, last);
+                  }
                   tend = osal_current_time();
                   osal_time_diff(&tstart, &tend, &tdif);
 
@@ -392,24 +419,29 @@ void eepromtool(char *ifname, int slave, int mode, char *fname)
             }
             if (mode == MODE_WRITEALIAS)
             {
-               if( eeprom_read(slave, 0x0000, CRCBUF) ) // read first 14 bytes
+               if( eeprom_read(first, last, 0x0000, CRCBUF) ) // read first 14 bytes
                {
-                  wbuf = (uint16 *)&ebuf[0];
-                  *(wbuf + 0x04) = alias;
-                  if(eeprom_writealias(slave, alias, SIIcrc(&ebuf[0])))
+                  if(eeprom_writealias(first, last, alias))
                   {
-                     printf("Alias %4.4X written successfully to slave %d\n", alias, slave);
+                     printf("Alias %4.4X written successfully to slave %d..%d\n", alias, first, last);
                   }
                   else
                   {
                      printf("Alias not written\n");
+                     printresult(first, last);
                   }
                }
                else
                {
-                  printf("Could not read slave EEPROM");
+                  printf("Could not read slave EEPROM\n");
+                  printresult(first, last);
                }
             }
+            for (i = first ; i <= last ; i++)
+            {
+               free(sbuf[i]);
+               sbuf[i] = NULL;
+            }
          }
          else
          {
@@ -422,7 +454,7 @@ void eepromtool(char *ifname, int slave, int mode, char *fname)
       }
       printf("End, close socket\n");
       /* stop SOEM, close socket */
-      ec_close();
+      nex_close();
    }
    else
    {
@@ -438,6 +470,9 @@ int main(int argc, char *argv[])
    if (argc > 3)
    {
       slave = atoi(argv[2]);
+      lastslave = slave;
+      if (strchr(argv[2], '-'))
+         lastslave = atoi(strchr(argv[2], '-') + 1);
       if ((strncmp(argv[3], "-i", sizeof("-i")) == 0))   mode = MODE_INFO;
       if (argc > 4)
       {
@@ -452,19 +487,20 @@ int main(int argc, char *argv[])
          }
       }
       /* start tool */
-      eepromtool(argv[1],slave,mode,argv[4]);
+      eepromtool(argv[1],slave,lastslave,mode,argv[4]);
    }
    else
    {
       printf("Usage: eepromtool ifname slave OPTION fname|alias\n");
       printf("ifname = eth0 for example\n");
       printf("slave = slave number in EtherCAT order 1..n\n");
+      printf("        or first-last for a range of slaves, handled in parallel\n");
       printf("    -i      display EEPROM information\n");
-      printf("    -walias write slave alias\n");
-      printf("    -r      read EEPROM, output binary format\n");
-      printf("    -ri     read EEPROM, output Intel Hex format\n");
-      printf("    -w      write EEPROM, input binary format\n");
-      printf("    -wi     write EEPROM, input Intel Hex format\n");
+      printf("    -walias write slave alias, consecutive aliases for a range\n");
+      printf("    -r      read EEPROM, output binary format, fname.slave for a range\n");
+      printf("    -ri     read EEPROM, output Intel Hex format, fname.slave for a range\n");
+      printf("    -w      write EEPROM, input binary format, verified after write\n");
+      printf("    -wi     write EEPROM, input Intel Hex format, verified after write\n");
    }
 
    printf("End program\n");
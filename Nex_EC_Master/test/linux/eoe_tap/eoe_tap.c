@@ -0,0 +1,179 @@
+/** \file
+ * \brief Example code for Simple Open EtherCAT master
+ *
+ * Usage : eoe_tap [ifname] [budget]
+ * ifname is NIC interface, f.e. eth0
+ * budget is max time in us spent on EoE per 1ms loop, default 200
+ *
+ * Bridges every EoE slave to a TAP interface named eoe<slave>. Configure
+ * the TAP interface and the slave IP (f.e. with nex_EOEsetIp) in the same
+ * subnet to reach web servers or TFTP in the slaves. Throughput and latency
+ * of the EoE engine are printed every second.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+
+#include "ethercat.h"
+
+nex_EOEenginet engine;
+int tapfd[NEX_EOE_MAXSLOT];
+uint8 tapframe[NEX_EOE_MAXFRAME];
+
+/* open TAP device, return file descriptor or -1 */
+int tap_open(char *name)
+{
+   struct ifreq ifr;
+   int fd;
+
+   fd = open("/dev/net/tun", O_RDWR);
+   if (fd < 0)
+   {
+      return -1;
+   }
+   memset(&ifr, 0, sizeof(ifr));
+   ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+   strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+   if (ioctl(fd, TUNSETIFF, &ifr) < 0)
+   {
+      close(fd);
+      return -1;
+   }
+   return fd;
+}
+
+/* frame received from slave, pass to TAP of slot */
+int eoe_rx(uint16 slave, uint8 port, void *frame, int size)
+{
+   int i;
+
+   (void)port;                  /* Not used */
+   for (i = 0; i < engine.nslot; i++)
+   {
+      if ((engine.slot[i].slave == slave) && (tapfd[i] >= 0))
+      {
+         return (int)write(tapfd[i], frame, size);
+      }
+   }
+   return 0;
+}
+
+void print_stats(nex_EOEstatt *st, nex_EOEstatt *prev)
+{
+   uint32 txf, rxf;
+
+   txf = st->txframes - prev->txframes;
+   rxf = st->rxframes - prev->rxframes;
+   printf("tx %5u frames %7.1f kB/s lat %6u/%6u us | rx %5u frames %7.1f kB/s lat %6u/%6u us | busy %u err %u\n",
+      txf, (st->txbytes - prev->txbytes) / 1000.0,
+      txf ? (st->txlatency_sum - prev->txlatency_sum) / txf : 0, st->txlatency_max,
+      rxf, (st->rxbytes - prev->rxbytes) / 1000.0,
+      rxf ? (st->rxlatency_sum - prev->rxlatency_sum) / rxf : 0, st->rxlatency_max,
+      st->txbusy, st->rxerrors);
+   *prev = *st;
+   st->txlatency_max = 0;
+   st->rxlatency_max = 0;
+}
+
+void eoe_tap(char *ifname, int budget)
+{
+   struct pollfd pfd[NEX_EOE_MAXSLOT];
+   int pslot[NEX_EOE_MAXSLOT];
+   nex_EOEstatt prev;
+   osal_timert stattimer;
+   char tapname[IFNAMSIZ];
+   int i, n, np;
+
+   if (!nex_init(ifname))
+   {
+      printf("No socket connection on %s\nExcecute as root\n", ifname);
+      return;
+   }
+   if (nex_config_init() <= 0)
+   {
+      printf("No slaves found!\n");
+      nex_close();
+      return;
+   }
+   /* EoE works from PRE-OP, cyclic process data is not needed */
+   nex_statecheck(0, NEX_STATE_PRE_OP, NEX_TIMEOUTSTATE);
+   if (!nex_EOEengine_init(&engine, &eoe_rx))
+   {
+      printf("No EoE slaves found!\n");
+      nex_close();
+      return;
+   }
+   for (i = 0; i < engine.nslot; i++)
+   {
+      sprintf(tapname, "eoe%d", engine.slot[i].slave);
+      tapfd[i] = tap_open(tapname);
+      printf("Slave %d %s -> %s %s\n", engine.slot[i].slave,
+         nex_slave[engine.slot[i].slave].name, tapname, (tapfd[i] >= 0) ? "" : "failed");
+   }
+   memset(&prev, 0, sizeof(prev));
+   osal_timer_start(&stattimer, 1000000);
+   while (1)
+   {
+      /* only read TAP of slots that can take a new frame */
+      np = 0;
+      for (i = 0; i < engine.nslot; i++)
+      {
+         if ((tapfd[i] >= 0) && !engine.slot[i].tx.size)
+         {
+            pfd[np].fd = tapfd[i];
+            pfd[np].events = POLLIN;
+            pslot[np++] = i;
+         }
+      }
+      if (poll(pfd, np, 1) > 0)
+      {
+         for (i = 0; i < np; i++)
+         {
+            if (pfd[i].revents & POLLIN)
+            {
+               n = (int)read(pfd[i].fd, tapframe, sizeof(tapframe));
+               if (n > 0)
+               {
+                  nexx_EOEengine_queue(&engine, engine.slot[pslot[i]].slave, 0, n, tapframe);
+               }
+            }
+         }
+      }
+      nex_EOEengine_poll(&engine, budget, 64);
+      if (osal_timer_is_expired(&stattimer))
+      {
+         print_stats(&engine.stat, &prev);
+         osal_timer_start(&stattimer, 1000000);
+      }
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   int budget = 200;
+
+   printf("SOEM (Simple Open EtherCAT Master)\nEoE TAP bridge\n");
+
+   if (argc > 1)
+   {
+      if (argc > 2)
+      {
+         budget = atoi(argv[2]);
+      }
+      eoe_tap(argv[1], budget);
+   }
+   else
+   {
+      printf("Usage: eoe_tap ifname [budget]\nifname = eth0 for example\nbudget = us per loop for EoE\n");
+   }
+
+   printf("End program\n");
+   return (0);
+}
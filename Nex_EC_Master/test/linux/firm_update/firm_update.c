@@ -3,7 +3,8 @@
  *
  * Usage: firm_update ifname1 slave fname
  * ifname is NIC interface, f.e. eth0
- * slave = slave number in EtherCAT order 1..n
+ * slave = slave number in EtherCAT order 1..n, or range first-last to
+ *         update many slaves in parallel
  * fname = binary file to store in slave
  * CAUTION! Using the wrong file can result in a bricked slave!
  *
@@ -16,94 +17,117 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 
 #include "ethercat.h"
 
-#define FWBUFSIZE (8 * 1024 * 1024)
-
 uint8 ob;
 uint16 ow;
 uint32 data;
 char filename[256];
-char filebuffer[FWBUFSIZE]; // 8MB buffer
+uint8 *filemap;
 int filesize;
+int fileoffset;
 int j;
-uint16 argslave;
+uint16 argslave, arglast;
+nex_FOEstatt foestat;
+nex_FOEmasst foemass;
+int lastdecile[NEX_MAXSLAVE];
 
+/* map file in memory, no copy of the image is made */
 int input_bin(char *fname, int *length)
 {
-    FILE *fp;
-
-	int cc = 0, c;
+	struct stat st;
+	int fd;
 
-    fp = fopen(fname, "rb");
-    if(fp == NULL)
-        return 0;
-	while (((c = fgetc(fp)) != EOF) && (cc < FWBUFSIZE))
-		filebuffer[cc++] = (uint8)c;
-	*length = cc;
-	fclose(fp);
+	fd = open(fname, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	if ((fstat(fd, &st) < 0) || (st.st_size == 0))
+	{
+		close(fd);
+		return 0;
+	}
+	filemap = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (filemap == MAP_FAILED)
+		return 0;
+	madvise(filemap, st.st_size, MADV_SEQUENTIAL);
+	*length = (int)st.st_size;
+	fileoffset = 0;
 	return 1;
 }
 
+/* FoE stream hook, next part of mapped file */
+int file_source(void *arg, void *buf, int size)
+{
+	(void)arg;
+	if (size > filesize - fileoffset)
+		size = filesize - fileoffset;
+	memcpy(buf, filemap + fileoffset, size);
+	fileoffset += size;
+	return size;
+}
 
 void boottest(char *ifname, uint16 slave, char *filename)
 {
 	printf("Starting firmware update example\n");
 
 	/* initialise SOEM, bind socket to ifname */
-	if (ec_init(ifname))
+	if (nex_init(ifname))
 	{
-		printf("ec_init on %s succeeded.\n",ifname);
+		printf("nex_init on %s succeeded.\n",ifname);
 		/* find and auto-config slaves */
 
 
-	    if ( ec_config_init(FALSE) > 0 )
+	    if ( nex_config_init() > 0 )
 		{
-			printf("%d slaves found and configured.\n",ec_slavecount);
+			printf("%d slaves found and configured.\n",nex_slavecount);
 
 			printf("Request init state for slave %d\n", slave);
-			ec_slave[slave].state = EC_STATE_INIT;
-			ec_writestate(slave);
+			nex_slave[slave].state = NEX_STATE_INIT;
+			nex_writestate(slave);
 
 			/* wait for slave to reach INIT state */
-			ec_statecheck(slave, EC_STATE_INIT,  EC_TIMEOUTSTATE * 4);
+			nex_statecheck(slave, NEX_STATE_INIT,  NEX_TIMEOUTSTATE * 4);
 			printf("Slave %d state to INIT.\n", slave);
 
 			/* read BOOT mailbox data, master -> slave */
-			data = ec_readeeprom(slave, ECT_SII_BOOTRXMBX, EC_TIMEOUTEEP);
-			ec_slave[slave].SM[0].StartAddr = (uint16)LO_WORD(data);
-            		ec_slave[slave].SM[0].SMlength = (uint16)HI_WORD(data);
+			data = nex_readeeprom(slave, ECT_SII_BOOTRXMBX, NEX_TIMEOUTEEP);
+			nex_slave[slave].SM[0].StartAddr = (uint16)LO_WORD(data);
+            		nex_slave[slave].SM[0].SMlength = (uint16)HI_WORD(data);
 			/* store boot write mailbox address */
-			ec_slave[slave].mbx_wo = (uint16)LO_WORD(data);
+			nex_slave[slave].mbx_wo = (uint16)LO_WORD(data);
 			/* store boot write mailbox size */
-			ec_slave[slave].mbx_l = (uint16)HI_WORD(data);
+			nex_slave[slave].mbx_l = (uint16)HI_WORD(data);
 
 			/* read BOOT mailbox data, slave -> master */
-			data = ec_readeeprom(slave, ECT_SII_BOOTTXMBX, EC_TIMEOUTEEP);
-			ec_slave[slave].SM[1].StartAddr = (uint16)LO_WORD(data);
-                        ec_slave[slave].SM[1].SMlength = (uint16)HI_WORD(data);
+			data = nex_readeeprom(slave, ECT_SII_BOOTTXMBX, NEX_TIMEOUTEEP);
+			nex_slave[slave].SM[1].StartAddr = (uint16)LO_WORD(data);
+                        nex_slave[slave].SM[1].SMlength = (uint16)HI_WORD(data);
 			/* store boot read mailbox address */
-			ec_slave[slave].mbx_ro = (uint16)LO_WORD(data);
+			nex_slave[slave].mbx_ro = (uint16)LO_WORD(data);
 			/* store boot read mailbox size */
-			ec_slave[slave].mbx_rl = (uint16)HI_WORD(data);
+			nex_slave[slave].mbx_rl = (uint16)HI_WORD(data);
 
-			printf(" SM0 A:%4.4x L:%4d F:%8.8x\n", ec_slave[slave].SM[0].StartAddr, ec_slave[slave].SM[0].SMlength,
-			    (int)ec_slave[slave].SM[0].SMflags);
-			printf(" SM1 A:%4.4x L:%4d F:%8.8x\n", ec_slave[slave].SM[1].StartAddr, ec_slave[slave].SM[1].SMlength,
-			    (int)ec_slave[slave].SM[1].SMflags);
+			printf(" SM0 A:%4.4x L:%4d F:%8.8x\n", nex_slave[slave].SM[0].StartAddr, nex_slave[slave].SM[0].SMlength,
+			    (int)nex_slave[slave].SM[0].SMflags);
+			printf(" SM1 A:%4.4x L:%4d F:%8.8x\n", nex_slave[slave].SM[1].StartAddr, nex_slave[slave].SM[1].SMlength,
+			    (int)nex_slave[slave].SM[1].SMflags);
 			/* program SM0 mailbox in for slave */
-			ec_FPWR (ec_slave[slave].configadr, ECT_REG_SM0, sizeof(ec_smt), &ec_slave[slave].SM[0], EC_TIMEOUTRET);
+			nex_FPWR (nex_slave[slave].configadr, ECT_REG_SM0, sizeof(nex_smt), &nex_slave[slave].SM[0], NEX_TIMEOUTRET);
 			/* program SM1 mailbox out for slave */
-			ec_FPWR (ec_slave[slave].configadr, ECT_REG_SM1, sizeof(ec_smt), &ec_slave[slave].SM[1], EC_TIMEOUTRET);
+			nex_FPWR (nex_slave[slave].configadr, ECT_REG_SM1, sizeof(nex_smt), &nex_slave[slave].SM[1], NEX_TIMEOUTRET);
 
 			printf("Request BOOT state for slave %d\n", slave);
-			ec_slave[slave].state = EC_STATE_BOOT;
-			ec_writestate(slave);
+			nex_slave[slave].state = NEX_STATE_BOOT;
+			nex_writestate(slave);
 
 			/* wait for slave to reach BOOT state */
-			if (ec_statecheck(slave, EC_STATE_BOOT,  EC_TIMEOUTSTATE * 10) == EC_STATE_BOOT)
+			if (nex_statecheck(slave, NEX_STATE_BOOT,  NEX_TIMEOUTSTATE * 10) == NEX_STATE_BOOT)
 			{
 				printf("Slave %d state to BOOT.\n", slave);
 
@@ -111,11 +135,14 @@ void boottest(char *ifname, uint16 slave, char *filename)
 				{
 					printf("File read OK, %d bytes.\n",filesize);
 					printf("FoE write....");
-					j = ec_FOEwrite(slave, filename, 0, filesize , &filebuffer, EC_TIMEOUTSTATE);
+					j = nex_FOEwrite_stream(slave, filename, 0, file_source, NULL, &foestat, NEX_TIMEOUTSTATE);
 					printf("result %d.\n",j);
+					printf("%u bytes in %u packets, %u ms, %u bytes/s\n", foestat.bytes, foestat.packets,
+						foestat.elapsed / 1000, foestat.throughput);
+					munmap(filemap, filesize);
 					printf("Request init state for slave %d\n", slave);
-					ec_slave[slave].state = EC_STATE_INIT;
-					ec_writestate(slave);
+					nex_slave[slave].state = NEX_STATE_INIT;
+					nex_writestate(slave);
 				}
 				else
 				    printf("File not read OK.\n");
@@ -128,7 +155,80 @@ void boottest(char *ifname, uint16 slave, char *filename)
 		}
 		printf("End firmware update example, close socket\n");
 		/* stop SOEM, close socket */
-		ec_close();
+		nex_close();
+	}
+	else
+	{
+		printf("No socket connection on %s\nExcecute as root\n",ifname);
+	}
+}
+
+/* FoE mass update hook, progress of one slave */
+void mass_progress(uint16 slave, uint32 bytes, uint32 size, int result)
+{
+	if (result)
+		printf("Slave %d done, result %d, %u bytes.\n", slave, result, bytes);
+	else if (size && ((int)(bytes * 10 / size) != lastdecile[slave]))
+	{
+		lastdecile[slave] = bytes * 10 / size;
+		printf("Slave %d %d%%\n", slave, lastdecile[slave] * 10);
+	}
+}
+
+void masstest(char *ifname, uint16 first, uint16 last, char *filename)
+{
+	uint16 slavelst[NEX_FOEMASS_MAX];
+	int nslave, inboot, ok;
+	nex_timet tstart, tend, tdif;
+
+	printf("Starting firmware mass update example\n");
+
+	if (nex_init(ifname))
+	{
+		printf("nex_init on %s succeeded.\n",ifname);
+		if (nex_config_init() > 0)
+		{
+			printf("%d slaves found and configured.\n",nex_slavecount);
+			if ((first < 1) || (first > last) || (last > nex_slavecount) ||
+			    ((last - first) >= NEX_FOEMASS_MAX))
+			{
+				printf("Invalid slave range %d-%d, use first-last within 1-%d, at most %d slaves\n",
+					first, last, nex_slavecount, NEX_FOEMASS_MAX);
+			}
+			else
+			{
+				if (input_bin(filename, &filesize))
+				{
+					printf("File read OK, %d bytes.\n",filesize);
+					nslave = 0;
+					while ((first <= last) && (nslave < NEX_FOEMASS_MAX))
+						slavelst[nslave++] = first++;
+					nexx_FOEmass_init(&foemass, slavelst, nslave, filename, 0, filemap, filesize,
+						NEX_TIMEOUTSTATE, mass_progress);
+					tstart = osal_current_time();
+					inboot = nex_FOEmass_boot(&foemass, NEX_TIMEOUTSTATE * 10);
+					printf("%d of %d slaves in BOOT state.\n", inboot, nslave);
+					/* one full mailbox frame per poll */
+					ok = nex_FOEmass_run(&foemass, NEX_MAXLRWDATA);
+					tend = osal_current_time();
+					osal_time_diff(&tstart, &tend, &tdif);
+					printf("%d of %d slaves updated in %d ms.\n", ok, nslave,
+						(int)(tdif.sec * 1000 + tdif.usec / 1000));
+					munmap(filemap, filesize);
+					printf("Request init state for all slaves\n");
+					nex_slave[0].state = NEX_STATE_INIT;
+					nex_writestate(0);
+				}
+				else
+					printf("File not read OK.\n");
+			}
+		}
+		else
+		{
+			printf("No slaves found!\n");
+		}
+		printf("End firmware mass update example, close socket\n");
+		nex_close();
 	}
 	else
 	{
@@ -143,13 +243,20 @@ int main(int argc, char *argv[])
 	if (argc > 3)
 	{
 		argslave = atoi(argv[2]);
-		boottest(argv[1], argslave, argv[3]);
+		if (strchr(argv[2], '-'))
+		{
+			arglast = atoi(strchr(argv[2], '-') + 1);
+			masstest(argv[1], argslave, arglast, argv[3]);
+		}
+		else
+			boottest(argv[1], argslave, argv[3]);
 	}
 	else
 	{
 		printf("Usage: firm_update ifname1 slave fname\n");
 		printf("ifname = eth0 for example\n");
 		printf("slave = slave number in EtherCAT order 1..n\n");
+		printf("        or first-last to update a range of slaves in parallel\n");
 		printf("fname = binary file to store in slave\n");
 		printf("CAUTION! Using the wrong file can result in a bricked slave!\n");
 	}
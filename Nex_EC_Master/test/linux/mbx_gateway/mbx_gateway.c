@@ -0,0 +1,238 @@
+/** \file
+ * \brief Example code for Simple Open EtherCAT master
+ *
+ * Usage : mbx_gateway [ifname] [address] [budget]
+ * ifname is NIC interface, f.e. eth0
+ * address is the local address the gateway listens on, default 127.0.0.1
+ * budget is max mailbox bytes written per 1ms cycle, default 512
+ *
+ * EtherCAT mailbox gateway on UDP port 0x88A4. Engineering tools send
+ * mailbox requests addressed to the configured station address of a slave
+ * while the master keeps the slaves in OP with a 1ms process data cycle.
+ * Gateway statistics are printed every second.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "ethercat.h"
+
+#define MAXCLIENT 16
+
+char IOmap[4096];
+nex_GWt gw;
+int sock;
+struct sockaddr_in client[MAXCLIENT];
+uint32 clientuse[MAXCLIENT];
+uint32 usecount;
+int nclient;
+uint8 udpbuf[NEX_GW_HEADERSIZE + NEX_MAXMBX];
+
+/* client has a request in the gateway that is not answered yet */
+int client_busy(int handle)
+{
+   int i;
+
+   for (i = 0; i < NEX_GW_MAXREQ; i++)
+   {
+      if ((gw.req[i].state != NEX_GW_FREE) && (gw.req[i].client == handle))
+      {
+         return 1;
+      }
+   }
+   return 0;
+}
+
+/* find client by address, add it if new. If the table is full the least
+   recently used idle client is replaced, -1 if all clients wait for a response */
+int client_handle(struct sockaddr_in *addr)
+{
+   int i, oldest;
+
+   for (i = 0; i < nclient; i++)
+   {
+      if ((client[i].sin_addr.s_addr == addr->sin_addr.s_addr) && (client[i].sin_port == addr->sin_port))
+      {
+         clientuse[i] = ++usecount;
+         return i;
+      }
+   }
+   if (nclient < MAXCLIENT)
+   {
+      i = nclient++;
+   }
+   else
+   {
+      oldest = -1;
+      for (i = 0; i < MAXCLIENT; i++)
+      {
+         if (!client_busy(i) && ((oldest < 0) || ((int32)(clientuse[i] - clientuse[oldest]) < 0)))
+         {
+            oldest = i;
+         }
+      }
+      if (oldest < 0)
+      {
+         return -1;
+      }
+      i = oldest;
+   }
+   client[i] = *addr;
+   clientuse[i] = ++usecount;
+   return i;
+}
+
+/* response from slave, send to client with EtherCAT header in front */
+int gw_response(int handle, uint16 slave, void *mbx, int size)
+{
+   uint8 buf[NEX_GW_HEADERSIZE + NEX_MAXMBX];
+   uint16 hdr;
+
+   (void)slave;                 /* Not used */
+   hdr = htoes((uint16)((size & 0x07ff) | (NEX_GW_TYPE_MBX << 12)));
+   memcpy(buf, &hdr, NEX_GW_HEADERSIZE);
+   memcpy(buf + NEX_GW_HEADERSIZE, mbx, size);
+   return (int)sendto(sock, buf, NEX_GW_HEADERSIZE + size, 0,
+      (struct sockaddr *)&client[handle], sizeof(client[handle]));
+}
+
+/* read all pending gateway datagrams and queue them */
+void gw_receive(void)
+{
+   struct sockaddr_in addr;
+   socklen_t addrlen;
+   uint16 hdr;
+   int n, handle;
+
+   while (1)
+   {
+      addrlen = sizeof(addr);
+      n = (int)recvfrom(sock, udpbuf, sizeof(udpbuf), 0, (struct sockaddr *)&addr, &addrlen);
+      if (n <= 0)
+      {
+         return;
+      }
+      if (n < NEX_GW_HEADERSIZE)
+      {
+         continue;
+      }
+      memcpy(&hdr, udpbuf, NEX_GW_HEADERSIZE);
+      hdr = etohs(hdr);
+      if (((hdr >> 12) != NEX_GW_TYPE_MBX) || ((hdr & 0x07ff) != (n - NEX_GW_HEADERSIZE)))
+      {
+         continue;
+      }
+      /* no client entry free, the client repeats the request after its timeout */
+      handle = client_handle(&addr);
+      if (handle >= 0)
+      {
+         nex_GWrequest(&gw, handle, udpbuf + NEX_GW_HEADERSIZE, n - NEX_GW_HEADERSIZE);
+      }
+   }
+}
+
+void mbx_gateway(char *ifname, char *address, int budget)
+{
+   struct sockaddr_in addr;
+   osal_timert cycletimer, stattimer;
+   nex_GWstatt prev;
+   int i;
+
+   sock = socket(AF_INET, SOCK_DGRAM, 0);
+   memset(&addr, 0, sizeof(addr));
+   addr.sin_family = AF_INET;
+   addr.sin_port = htons(NEX_GW_UDPPORT);
+   addr.sin_addr.s_addr = inet_addr(address);
+   if ((sock < 0) || (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0))
+   {
+      printf("Can not bind UDP port %d on %s\n", NEX_GW_UDPPORT, address);
+      return;
+   }
+   fcntl(sock, F_SETFL, O_NONBLOCK);
+   if (!nex_init(ifname))
+   {
+      printf("No socket connection on %s\nExcecute as root\n", ifname);
+      close(sock);
+      return;
+   }
+   if (nex_config_init() <= 0)
+   {
+      printf("No slaves found!\n");
+      nex_close();
+      close(sock);
+      return;
+   }
+   nex_config_map(&IOmap);
+   nex_statecheck(0, NEX_STATE_SAFE_OP, NEX_TIMEOUTSTATE * 4);
+   for (i = 1; i <= nex_slavecount; i++)
+   {
+      if (nex_slave[i].mbx_l)
+      {
+         printf("Slave %d %s station address 0x%4.4x\n", i, nex_slave[i].name, nex_slave[i].configadr);
+      }
+   }
+   nex_send_processdata();
+   nex_receive_processdata(NEX_TIMEOUTRET);
+   nex_slave[0].state = NEX_STATE_OPERATIONAL;
+   nex_writestate(0);
+   nexx_GWinit(&gw, NEX_TIMEOUTRXM, &gw_response);
+   printf("Mailbox gateway on %s:%d\n", address, NEX_GW_UDPPORT);
+   memset(&prev, 0, sizeof(prev));
+   osal_timer_start(&stattimer, 1000000);
+   while (1)
+   {
+      osal_timer_start(&cycletimer, 1000);
+      nex_send_processdata();
+      nex_receive_processdata(NEX_TIMEOUTRET);
+      /* gateway traffic in the spare time of the cycle, limited by budget */
+      gw_receive();
+      nex_GWpoll(&gw, budget);
+      if (osal_timer_is_expired(&stattimer))
+      {
+         printf("requests %u responses %u rejected %u timeouts %u\n",
+            gw.stat.requests - prev.requests, gw.stat.responses - prev.responses,
+            gw.stat.rejected - prev.rejected, gw.stat.timeouts - prev.timeouts);
+         prev = gw.stat;
+         osal_timer_start(&stattimer, 1000000);
+      }
+      while (osal_timer_is_expired(&cycletimer) == FALSE)
+      {
+         osal_usleep(50);
+      }
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   char *address = "127.0.0.1";
+   int budget = 512;
+
+   printf("SOEM (Simple Open EtherCAT Master)\nMailbox gateway\n");
+
+   if (argc > 1)
+   {
+      if (argc > 2)
+      {
+         address = argv[2];
+      }
+      if (argc > 3)
+      {
+         budget = atoi(argv[3]);
+      }
+      mbx_gateway(argv[1], address, budget);
+   }
+   else
+   {
+      printf("Usage: mbx_gateway ifname [address] [budget]\nifname = eth0 for example\n"
+             "address = local address to listen on, default 127.0.0.1\nbudget = mailbox bytes per cycle\n");
+   }
+
+   printf("End program\n");
+   return (0);
+}
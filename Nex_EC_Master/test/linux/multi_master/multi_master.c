@@ -0,0 +1,228 @@
+/** \file
+ * \brief Example code for Simple Open EtherCAT master
+ *
+ * Usage : multi_master seconds ifname1 [ifname2 ...]
+ * seconds is the run time of the cyclic part
+ * ifnameN is NIC interface, f.e. eth0, one master per NIC
+ *
+ * Runs one independent master context per NIC, each in a thread of its own.
+ * Configuration, mapping, DC setup and the 1ms process data cycle of all
+ * masters run at the same time, as a stress test for shared state. Each
+ * master counts its cycles, working counter errors and lost frames. The exit
+ * code is 1 if a master failed to configure or had more than MAXERRORS per
+ * 1000 cycles of working counter errors and lost frames together.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "ethercat.h"
+
+#define MAXMASTER 8
+/** allowed working counter errors and lost frames per 1000 cycles */
+#define MAXERRORS 1
+
+/** everything a context refers to, one per master */
+typedef struct
+{
+   nexx_contextt    context;
+   nexx_portt       port;
+   nex_slavet       slave[NEX_MAXSLAVE];
+   int              slavecount;
+   nex_groupt       group[NEX_MAXGROUP];
+   uint8            esibuf[NEX_MAXEEPBUF];
+   uint32           esimap[NEX_MAXEEPBITMAP];
+   nex_eringt       elist;
+   nex_idxstackT    idxstack;
+   boolean          ecaterror;
+   int64            DCtime;
+   nex_SMcommtypet  SMcommtype[NEX_MAX_MAPT];
+   nex_PDOassignt   PDOassign[NEX_MAX_MAPT];
+   nex_PDOdesct     PDOdesc[NEX_MAX_MAPT];
+   nex_eepromSMt    eepSM;
+   nex_eepromFMMUt  eepFMMU;
+   nex_emcylistt    emcylist;
+   nex_SoEcachet    SoEcache;
+   uint8            IOmap[4096];
+   /* test state */
+   char             *ifname;
+   int              seconds;
+   volatile int     running;
+   int              result;
+   uint32           cycles;
+   uint32           wkcerrors;
+   uint32           noframes;
+} mastert;
+
+mastert *master[MAXMASTER];
+OSAL_THREAD_HANDLE threadh[MAXMASTER];
+
+mastert *master_create(char *ifname, int seconds)
+{
+   mastert *m;
+
+   m = calloc(1, sizeof(mastert));
+   if (!m)
+   {
+      return NULL;
+   }
+   m->context.port = &m->port;
+   m->context.slavelist = &m->slave[0];
+   m->context.slavecount = &m->slavecount;
+   m->context.maxslave = NEX_MAXSLAVE;
+   m->context.grouplist = &m->group[0];
+   m->context.maxgroup = NEX_MAXGROUP;
+   m->context.esibuf = &m->esibuf[0];
+   m->context.esimap = &m->esimap[0];
+   m->context.elist = &m->elist;
+   m->context.idxstack = &m->idxstack;
+   m->context.ecaterror = &m->ecaterror;
+   m->context.DCtime = &m->DCtime;
+   m->context.SMcommtype = &m->SMcommtype[0];
+   m->context.PDOassign = &m->PDOassign[0];
+   m->context.PDOdesc = &m->PDOdesc[0];
+   m->context.eepSM = &m->eepSM;
+   m->context.eepFMMU = &m->eepFMMU;
+   m->emcylist.toelist = TRUE;
+   m->context.emcylist = &m->emcylist;
+   m->context.SoEcache = &m->SoEcache;
+   m->ifname = ifname;
+   m->seconds = seconds;
+   return m;
+}
+
+OSAL_THREAD_FUNC master_thread(void *param)
+{
+   mastert *m;
+   nexx_contextt *c;
+   osal_timert cycletimer, runtimer;
+   int expectedWKC, wkc;
+
+   m = param;
+   c = &m->context;
+   m->result = 0;
+   if (nexx_init(c, m->ifname) <= 0)
+   {
+      m->result = -1;
+      m->running = 0;
+      return;
+   }
+   if (nexx_config_init(c) > 0)
+   {
+      nexx_config_map_group(c, &m->IOmap, 0);
+      nexx_configdc(c);
+      nexx_statecheck(c, 0, NEX_STATE_SAFE_OP, NEX_TIMEOUTSTATE * 4);
+      expectedWKC = (m->group[0].outputsWKC * 2) + m->group[0].inputsWKC;
+      nexx_send_processdata(c);
+      nexx_receive_processdata(c, NEX_TIMEOUTRET);
+      m->slave[0].state = NEX_STATE_OPERATIONAL;
+      nexx_writestate(c, 0);
+      osal_timer_start(&runtimer, m->seconds * 1000000);
+      while (!osal_timer_is_expired(&runtimer))
+      {
+         osal_timer_start(&cycletimer, 1000);
+         nexx_send_processdata(c);
+         wkc = nexx_receive_processdata(c, NEX_TIMEOUTRET);
+         m->cycles++;
+         if (wkc == NEX_NOFRAME)
+         {
+            m->noframes++;
+         }
+         else if (wkc < expectedWKC)
+         {
+            m->wkcerrors++;
+         }
+         while (!osal_timer_is_expired(&cycletimer))
+         {
+            osal_usleep(50);
+         }
+      }
+      m->slave[0].state = NEX_STATE_INIT;
+      nexx_writestate(c, 0);
+      m->result = 1;
+   }
+   nexx_close(c);
+   m->running = 0;
+}
+
+/* returns number of masters that failed */
+int multi_master(int n, char **ifname, int seconds)
+{
+   int i, busy, failed;
+
+   for (i = 0; i < n; i++)
+   {
+      master[i] = master_create(ifname[i], seconds);
+      if (!master[i])
+      {
+         printf("Out of memory\n");
+         return n;
+      }
+   }
+   /* all masters configure and cycle at the same time */
+   for (i = 0; i < n; i++)
+   {
+      master[i]->running = 1;
+      osal_thread_create(&threadh[i], 128000, &master_thread, master[i]);
+   }
+   do
+   {
+      osal_usleep(100000);
+      busy = 0;
+      for (i = 0; i < n; i++)
+      {
+         busy |= master[i]->running;
+      }
+   } while (busy);
+   failed = 0;
+   for (i = 0; i < n; i++)
+   {
+      if (master[i]->result < 0)
+      {
+         printf("Master %d on %s: no socket connection, execute as root\n", i, master[i]->ifname);
+         failed++;
+      }
+      else if (!master[i]->result)
+      {
+         printf("Master %d on %s: no slaves found\n", i, master[i]->ifname);
+         failed++;
+      }
+      else
+      {
+         printf("Master %d on %s: %d slaves, cycles %u, wkc errors %u, lost frames %u\n", i, master[i]->ifname,
+            master[i]->slavecount, master[i]->cycles, master[i]->wkcerrors, master[i]->noframes);
+         if (((uint64)(master[i]->wkcerrors + master[i]->noframes) * 1000) >
+             ((uint64)master[i]->cycles * MAXERRORS))
+         {
+            printf("Master %d on %s: more than %d errors per 1000 cycles\n", i, master[i]->ifname, MAXERRORS);
+            failed++;
+         }
+      }
+      while (master[i]->ecaterror)
+      {
+         printf(" %s", nexx_elist2string(&master[i]->context));
+      }
+      free(master[i]);
+   }
+   return failed;
+}
+
+int main(int argc, char *argv[])
+{
+   int failed = 0;
+
+   printf("SOEM (Simple Open EtherCAT Master)\nMultiple masters\n");
+
+   if ((argc > 2) && ((argc - 2) <= MAXMASTER))
+   {
+      failed = multi_master(argc - 2, &argv[2], atoi(argv[1]));
+   }
+   else
+   {
+      printf("Usage: multi_master seconds ifname1 [ifname2 ...]\nifname = eth0 for example, max %d\n", MAXMASTER);
+   }
+
+   printf("End program\n");
+   return failed ? 1 : 0;
+}
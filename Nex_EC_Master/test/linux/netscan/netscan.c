@@ -0,0 +1,637 @@
+/** \file
+ * \brief Network scan tool for Simple Open EtherCAT master
+ *
+ * Usage : netscan ifname [-od] [-odcache file] [-o file]
+ * ifname is NIC interface, f.e. eth0
+ * -od            add the CoE object dictionary of every slave identity
+ * -odcache file  load object dictionaries from file and save them after the scan
+ * -o file        write to file instead of stdout
+ *
+ * Writes a JSON description of the network for tooling: identity, topology,
+ * SM and FMMU configuration, PDO entries with their IOmap offsets, DC delays
+ * and optionally the object dictionary. PDO entries and object dictionary are
+ * discovered once per slave identity, distinct identities are discovered in
+ * parallel. The output contains no timestamps, two scans of the same network
+ * give identical files and can be compared with diff.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "ethercat.h"
+
+#define MAXIOMAP       131072
+#define MAXTYPE        128
+#define MAXENTRY       512
+#define MAXTHREAD      8
+#define ODPOOLSIZE     65536
+
+#define SRC_NONE       0
+#define SRC_COE        1
+#define SRC_SII        2
+
+/** PDO entry of slave identity */
+typedef struct
+{
+   /** 0 = outputs (RxPDO), 1 = inputs (TxPDO) */
+   uint8  dir;
+   uint8  sm;
+   uint16 pdo;
+   uint16 index;
+   uint8  subidx;
+   uint8  bitlen;
+   /** bit position in outputs or inputs of slave */
+   int    bitoffset;
+   uint16 dtype;
+   char   name[NEX_MAXNAME + 1];
+} entryt;
+
+/** discovery result shared by all slaves with equal identity */
+typedef struct
+{
+   uint32 man;
+   uint32 id;
+   uint32 rev;
+   /** first slave of identity, used for discovery */
+   uint16 slave;
+   int    source;
+   int    nentry;
+   entryt entry[MAXENTRY];
+   volatile int running;
+} typet;
+
+char IOmap[MAXIOMAP];
+typet types[MAXTYPE];
+int ntype;
+uint16 slavetype[NEX_MAXSLAVE];
+OSAL_THREAD_HANDLE threadh[MAXTHREAD];
+typet *threadt[MAXTHREAD];
+nex_ODcachet odcache;
+nex_ODcacheOEt *odpool;
+boolean printOD = FALSE;
+char *odfile = NULL;
+FILE *out;
+
+/* write string as JSON string literal */
+void json_string(const char *s)
+{
+   fputc('"', out);
+   while (*s)
+   {
+      if ((*s == '"') || (*s == '\\'))
+      {
+         fprintf(out, "\\%c", *s);
+      }
+      else if ((uint8)*s < 0x20)
+      {
+         fprintf(out, "\\u%4.4x", (uint8)*s);
+      }
+      else
+      {
+         fputc(*s, out);
+      }
+      s++;
+   }
+   fputc('"', out);
+}
+
+/* find identity of slave, add it if new */
+int find_type(uint16 slave)
+{
+   int i;
+
+   for (i = 0; i < ntype; i++)
+   {
+      if ((types[i].man == nex_slave[slave].eep_man) &&
+          (types[i].id == nex_slave[slave].eep_id) &&
+          (types[i].rev == nex_slave[slave].eep_rev))
+      {
+         return i;
+      }
+   }
+   if (ntype >= MAXTYPE)
+   {
+      return -1;
+   }
+   i = ntype++;
+   memset(&types[i], 0, sizeof(typet));
+   types[i].man = nex_slave[slave].eep_man;
+   types[i].id = nex_slave[slave].eep_id;
+   types[i].rev = nex_slave[slave].eep_rev;
+   types[i].slave = slave;
+   return i;
+}
+
+void add_entry(typet *t, uint8 dir, uint8 sm, uint16 pdo, uint32 map, int *bitoffset)
+{
+   entryt *e;
+
+   if (t->nentry >= MAXENTRY)
+   {
+      return;
+   }
+   e = &t->entry[t->nentry++];
+   memset(e, 0, sizeof(entryt));
+   e->dir = dir;
+   e->sm = sm;
+   e->pdo = pdo;
+   e->index = (uint16)(map >> 16);
+   e->subidx = (uint8)((map >> 8) & 0xff);
+   e->bitlen = (uint8)(map & 0xff);
+   e->bitoffset = *bitoffset;
+   *bitoffset += e->bitlen;
+}
+
+/* read array object with complete access, or subindex by subindex if the slave
+   has no complete access, returns number of elements */
+int read_array(uint16 slave, uint16 index, int esize, uint32 *val, int max)
+{
+   uint8 buf[2 + 4 * 255];
+   uint16 w;
+   uint32 l;
+   uint8 n;
+   int rdl, i, wkc;
+
+   n = 0;
+   if (nex_slave[slave].CoEdetails & ECT_COEDET_SDOCA)
+   {
+      rdl = 2 + (esize * 255);
+      memset(buf, 0, sizeof(buf));
+      wkc = nex_SDOread(slave, index, 0x00, TRUE, &rdl, buf, NEX_TIMEOUTRXM);
+      if ((wkc > 0) && (rdl >= 1))
+      {
+         /* subindex 0 is followed by one padding byte */
+         n = buf[0];
+         if (n > max) n = max;
+         for (i = 0; (i < n) && ((2 + ((i + 1) * esize)) <= rdl); i++)
+         {
+            if (esize == 2)
+            {
+               memcpy(&w, &buf[2 + (i * 2)], 2);
+               val[i] = etohs(w);
+            }
+            else
+            {
+               memcpy(&l, &buf[2 + (i * 4)], 4);
+               val[i] = etohl(l);
+            }
+         }
+         return i;
+      }
+   }
+   rdl = sizeof(n);
+   if ((nex_SDOread(slave, index, 0x00, FALSE, &rdl, &n, NEX_TIMEOUTRXM) <= 0) || !n)
+   {
+      return 0;
+   }
+   if (n > max) n = max;
+   for (i = 0; i < n; i++)
+   {
+      l = 0;
+      rdl = esize;
+      if (nex_SDOread(slave, index, (uint8)(i + 1), FALSE, &rdl, &l, NEX_TIMEOUTRXM) <= 0)
+      {
+         break;
+      }
+      val[i] = (esize == 2) ? etohs((uint16)l) : etohl(l);
+   }
+   return i;
+}
+
+/* PDO entries from PDO assign and PDO mapping objects */
+void scan_coe(typet *t)
+{
+   uint32 pdo[255], map[255];
+   uint8 nSM, tSM, iSM;
+   int rdl, bitoffset[2], npdo, nmap, i, j;
+
+   bitoffset[0] = 0;
+   bitoffset[1] = 0;
+   rdl = sizeof(nSM); nSM = 0;
+   if ((nex_SDOread(t->slave, ECT_SDO_SMCOMMTYPE, 0x00, FALSE, &rdl, &nSM, NEX_TIMEOUTRXM) <= 0) || (nSM <= 2))
+   {
+      return;
+   }
+   if (nSM > NEX_MAXSM) nSM = NEX_MAXSM;
+   for (iSM = 2; iSM < nSM; iSM++)
+   {
+      rdl = sizeof(tSM); tSM = 0;
+      nex_SDOread(t->slave, ECT_SDO_SMCOMMTYPE, iSM + 1, FALSE, &rdl, &tSM, NEX_TIMEOUTRXM);
+      /* same correction for type 0..3 slaves as the configuration does */
+      if (nex_slave[t->slave].SMtype[iSM])
+      {
+         tSM = nex_slave[t->slave].SMtype[iSM];
+      }
+      if ((tSM != 3) && (tSM != 4))
+      {
+         continue;
+      }
+      npdo = read_array(t->slave, ECT_SDO_PDOASSIGN + iSM, 2, pdo, 255);
+      for (i = 0; i < npdo; i++)
+      {
+         if (!pdo[i])
+         {
+            continue;
+         }
+         nmap = read_array(t->slave, (uint16)pdo[i], 4, map, 255);
+         for (j = 0; j < nmap; j++)
+         {
+            add_entry(t, tSM - 3, iSM, (uint16)pdo[i], map[j], &bitoffset[tSM - 3]);
+         }
+      }
+   }
+   t->source = SRC_COE;
+}
+
+/* PDO entries from SII, SII access is not shared between threads */
+void scan_sii(typet *t)
+{
+   uint16 a, w, c, e, er, len, pdo;
+   uint8 sm, dir, name, eectl;
+   uint32 map;
+   int bitoffset;
+   entryt *en;
+
+   eectl = nex_slave[t->slave].eep_pdi;
+   for (dir = 0; dir < 2; dir++)
+   {
+      bitoffset = 0;
+      /* ECT_SII_PDO is TxPDO (inputs), ECT_SII_PDO + 1 is RxPDO (outputs) */
+      a = nex_siifind(t->slave, ECT_SII_PDO + 1 - dir);
+      if (a <= 0)
+      {
+         continue;
+      }
+      w = nex_siigetbyte(t->slave, a++);
+      w += (nex_siigetbyte(t->slave, a++) << 8);
+      len = w;
+      c = 1;
+      while (c < len)
+      {
+         pdo = nex_siigetbyte(t->slave, a++);
+         pdo += (nex_siigetbyte(t->slave, a++) << 8);
+         e = nex_siigetbyte(t->slave, a++);
+         sm = nex_siigetbyte(t->slave, a++);
+         a += 4;
+         c += 4;
+         for (er = 0; er < e; er++)
+         {
+            map = nex_siigetbyte(t->slave, a++);
+            map += nex_siigetbyte(t->slave, a++) << 8;
+            map = (map << 16) + (nex_siigetbyte(t->slave, a++) << 8);
+            name = nex_siigetbyte(t->slave, a++);
+            w = nex_siigetbyte(t->slave, a++);
+            map += nex_siigetbyte(t->slave, a++);
+            a += 2;
+            c += 4;
+            /* PDO deactivated if SM is 0xff or out of range */
+            if ((sm < NEX_MAXSM) && (t->nentry < MAXENTRY))
+            {
+               add_entry(t, dir, sm, pdo, map, &bitoffset);
+               en = &t->entry[t->nentry - 1];
+               en->dtype = w;
+               if (name)
+               {
+                  nex_siistring(en->name, t->slave, name);
+               }
+            }
+         }
+      }
+   }
+   if (eectl) nex_eeprom2pdi(t->slave); /* if eeprom control was previously pdi then restore */
+   t->source = SRC_SII;
+}
+
+OSAL_THREAD_FUNC scan_thread(void *param)
+{
+   typet *t;
+
+   t = param;
+   scan_coe(t);
+   t->running = 0;
+}
+
+/* discover PDO entries of every identity, CoE slaves in parallel threads */
+void scan_types(void)
+{
+   int i, thrn, busy;
+
+   for (thrn = 0; thrn < MAXTHREAD; thrn++)
+   {
+      threadt[thrn] = NULL;
+   }
+   for (i = 0; i < ntype; i++)
+   {
+      if (!(nex_slave[types[i].slave].mbx_proto & ECT_MBXPROT_COE))
+      {
+         continue;
+      }
+      do
+      {
+         for (thrn = 0; (thrn < MAXTHREAD) && threadt[thrn] && threadt[thrn]->running; thrn++);
+         if (thrn >= MAXTHREAD)
+         {
+            osal_usleep(1000);
+         }
+      } while (thrn >= MAXTHREAD);
+      threadt[thrn] = &types[i];
+      types[i].running = 1;
+      osal_thread_create(&threadh[thrn], 128000, &scan_thread, &types[i]);
+   }
+   do
+   {
+      busy = 0;
+      for (thrn = 0; thrn < MAXTHREAD; thrn++)
+      {
+         if (threadt[thrn] && threadt[thrn]->running)
+         {
+            busy = 1;
+         }
+      }
+      if (busy)
+      {
+         osal_usleep(1000);
+      }
+   } while (busy);
+   /* identities without CoE mapping fall back to SII */
+   for (i = 0; i < ntype; i++)
+   {
+      if (!types[i].nentry)
+      {
+         scan_sii(&types[i]);
+      }
+   }
+}
+
+/* name and data type of CoE entries from the object dictionary cache */
+void name_entries(typet *t)
+{
+   nex_ODcachetypet *od;
+   nex_ODcacheOEt *oe;
+   entryt *e;
+   int i, j;
+
+   od = nexx_ODcache_find(&nexx_context, &odcache, t->slave);
+   if (!od || (od->state != NEX_ODCACHE_OE) || (t->source != SRC_COE))
+   {
+      return;
+   }
+   for (i = 0; i < t->nentry; i++)
+   {
+      e = &t->entry[i];
+      for (j = 0; j < od->ODlist.Entries; j++)
+      {
+         if ((od->ODlist.Index[j] == e->index) && (e->subidx <= od->ODlist.MaxSub[j]))
+         {
+            oe = &odcache.OEpool[od->OEoffset[j] + e->subidx];
+            if (oe->Valid)
+            {
+               e->dtype = oe->DataType;
+               strcpy(e->name, oe->Name);
+            }
+         }
+      }
+   }
+}
+
+void print_od(typet *t)
+{
+   nex_ODcachetypet *od;
+   nex_ODcacheOEt *oe;
+   int j, s, first;
+
+   od = nexx_ODcache_find(&nexx_context, &odcache, t->slave);
+   if (!od)
+   {
+      fprintf(out, ", \"od\": null");
+      return;
+   }
+   fprintf(out, ",\n      \"od\": [");
+   for (j = 0; j < od->ODlist.Entries; j++)
+   {
+      fprintf(out, "%s\n        {\"index\": %d, \"datatype\": %d, \"objectcode\": %d, \"maxsub\": %d, \"name\": ",
+         j ? "," : "", od->ODlist.Index[j], od->ODlist.DataType[j], od->ODlist.ObjectCode[j], od->ODlist.MaxSub[j]);
+      json_string(od->ODlist.Name[j]);
+      if (od->state == NEX_ODCACHE_OE)
+      {
+         fprintf(out, ", \"entries\": [");
+         first = 1;
+         for (s = 0; s <= od->ODlist.MaxSub[j]; s++)
+         {
+            oe = &odcache.OEpool[od->OEoffset[j] + s];
+            if (oe->Valid)
+            {
+               fprintf(out, "%s{\"sub\": %d, \"datatype\": %d, \"bitlength\": %d, \"access\": %d, \"name\": ",
+                  first ? "" : ", ", s, oe->DataType, oe->BitLength, oe->ObjAccess);
+               json_string(oe->Name);
+               fprintf(out, "}");
+               first = 0;
+            }
+         }
+         fprintf(out, "]");
+      }
+      fprintf(out, "}");
+   }
+   fprintf(out, "\n      ]");
+}
+
+void print_slave(uint16 slave)
+{
+   nex_slavet *sl;
+   typet *t;
+   entryt *e;
+   int i, first, offset[2], startbit[2], bit;
+
+   sl = &nex_slave[slave];
+   fprintf(out, "    {\"slave\": %d, \"name\": ", slave);
+   json_string(sl->name);
+   fprintf(out, ", \"identity\": %d, \"man\": %u, \"id\": %u, \"rev\": %u,\n",
+      slavetype[slave], sl->eep_man, sl->eep_id, sl->eep_rev);
+   fprintf(out, "      \"configadr\": %d, \"aliasadr\": %d, \"state\": %d, \"alstatuscode\": %d, \"group\": %d,\n",
+      sl->configadr, sl->aliasadr, sl->state, sl->ALstatuscode, sl->group);
+   fprintf(out, "      \"topology\": {\"parent\": %d, \"parentport\": %d, \"entryport\": %d, \"links\": %d, \"activeports\": %d, \"ptype\": %d},\n",
+      sl->parent, sl->parentport, sl->entryport, sl->topology, sl->activeports, sl->ptype);
+   fprintf(out, "      \"dc\": {\"hasdc\": %s, \"delay\": %d, \"next\": %d, \"previous\": %d},\n",
+      sl->hasdc ? "true" : "false", sl->pdelay, sl->DCnext, sl->DCprevious);
+   fprintf(out, "      \"mailbox\": {\"write\": %d, \"read\": %d, \"protocols\": %d, \"coe\": %d, \"foe\": %d, \"eoe\": %d, \"soe\": %d},\n",
+      sl->mbx_l, sl->mbx_rl, sl->mbx_proto, sl->CoEdetails, sl->FoEdetails, sl->EoEdetails, sl->SoEdetails);
+   fprintf(out, "      \"ebuscurrent\": %d, \"blocklrw\": %d,\n", sl->Ebuscurrent, sl->blockLRW);
+   fprintf(out, "      \"sm\": [");
+   first = 1;
+   for (i = 0; i < NEX_MAXSM; i++)
+   {
+      if (sl->SM[i].StartAddr > 0)
+      {
+         fprintf(out, "%s{\"sm\": %d, \"start\": %d, \"length\": %d, \"flags\": %u, \"type\": %d}",
+            first ? "" : ", ", i, etohs(sl->SM[i].StartAddr), etohs(sl->SM[i].SMlength),
+            etohl(sl->SM[i].SMflags), sl->SMtype[i]);
+         first = 0;
+      }
+   }
+   fprintf(out, "],\n      \"fmmu\": [");
+   for (i = 0; i < sl->FMMUunused; i++)
+   {
+      fprintf(out, "%s{\"fmmu\": %d, \"logstart\": %u, \"loglength\": %d, \"logstartbit\": %d, \"logendbit\": %d, "
+         "\"physstart\": %d, \"physstartbit\": %d, \"type\": %d, \"active\": %d}",
+         i ? ", " : "", i, etohl(sl->FMMU[i].LogStart), etohs(sl->FMMU[i].LogLength), sl->FMMU[i].LogStartbit,
+         sl->FMMU[i].LogEndbit, etohs(sl->FMMU[i].PhysStart), sl->FMMU[i].PhysStartBit,
+         sl->FMMU[i].FMMUtype, sl->FMMU[i].FMMUactive);
+   }
+   offset[0] = sl->outputs ? (int)(sl->outputs - (uint8 *)&IOmap[0]) : -1;
+   startbit[0] = sl->Ostartbit;
+   offset[1] = sl->inputs ? (int)(sl->inputs - (uint8 *)&IOmap[0]) : -1;
+   startbit[1] = sl->Istartbit;
+   fprintf(out, "],\n      \"outputs\": {\"offset\": %d, \"startbit\": %d, \"bits\": %d},\n",
+      offset[0], startbit[0], sl->Obits);
+   fprintf(out, "      \"inputs\": {\"offset\": %d, \"startbit\": %d, \"bits\": %d},\n",
+      offset[1], startbit[1], sl->Ibits);
+   t = &types[slavetype[slave]];
+   fprintf(out, "      \"pdo\": {\"source\": \"%s\", \"entries\": [",
+      (t->source == SRC_COE) ? "coe" : ((t->source == SRC_SII) ? "sii" : "none"));
+   first = 1;
+   for (i = 0; i < t->nentry; i++)
+   {
+      e = &t->entry[i];
+      /* skip fillers */
+      if (!e->index && !e->subidx)
+      {
+         continue;
+      }
+      bit = startbit[e->dir] + e->bitoffset;
+      fprintf(out, "%s\n        {\"dir\": \"%s\", \"sm\": %d, \"pdo\": %d, \"index\": %d, \"sub\": %d, \"bitlength\": %d, "
+         "\"offset\": %d, \"bit\": %d, \"datatype\": %d, \"name\": ",
+         first ? "" : ",", e->dir ? "in" : "out", e->sm, e->pdo, e->index, e->subidx, e->bitlen,
+         (offset[e->dir] < 0) ? -1 : offset[e->dir] + (bit >> 3), bit & 7, e->dtype);
+      json_string(e->name);
+      fprintf(out, "}");
+      first = 0;
+   }
+   fprintf(out, "%s]}}", first ? "" : "\n      ");
+}
+
+void netscan(char *ifname, char *fname)
+{
+   nex_timet tstart, tend, tdif;
+   int i;
+
+   /* initialise SOEM, bind socket to ifname */
+   if (!nex_init(ifname))
+   {
+      fprintf(stderr, "No socket connection on %s\nExcecute as root\n", ifname);
+      return;
+   }
+   tstart = osal_current_time();
+   if (nex_config_init() <= 0)
+   {
+      fprintf(stderr, "No slaves found!\n");
+      nex_close();
+      return;
+   }
+   /* slaves of equal identity copy the mapping of the first one */
+   nex_config_map(&IOmap);
+   nex_configdc();
+   nex_readstate();
+   ntype = 0;
+   for (i = 1; i <= nex_slavecount; i++)
+   {
+      slavetype[i] = find_type(i);
+   }
+   scan_types();
+   if (printOD)
+   {
+      odpool = calloc(ODPOOLSIZE, sizeof(nex_ODcacheOEt));
+      nexx_ODcache_init(&odcache, odpool, ODPOOLSIZE);
+      if (odfile && (nexx_ODcache_load(&odcache, odfile) > 0))
+      {
+         fprintf(stderr, "Object dictionaries loaded from %s\n", odfile);
+      }
+      /* one slave of every identity, requests of all slaves in parallel */
+      nex_ODcache_fetch(&odcache, TRUE);
+      for (i = 0; i < ntype; i++)
+      {
+         name_entries(&types[i]);
+      }
+      if (odfile)
+      {
+         nexx_ODcache_save(&odcache, odfile);
+      }
+   }
+   tend = osal_current_time();
+   osal_time_diff(&tstart, &tend, &tdif);
+   while (EcatError) fprintf(stderr, "%s", nex_elist2string());
+
+   out = stdout;
+   if (fname && ((out = fopen(fname, "w")) == NULL))
+   {
+      fprintf(stderr, "Can not open %s\n", fname);
+      out = stdout;
+   }
+   fprintf(out, "{\n  \"slavecount\": %d,\n", nex_slavecount);
+   fprintf(out, "  \"iomap\": {\"outputs\": %u, \"inputs\": %u, \"outputswkc\": %d, \"inputswkc\": %d},\n",
+      nex_group[0].Obytes, nex_group[0].Ibytes, nex_group[0].outputsWKC, nex_group[0].inputsWKC);
+   fprintf(out, "  \"identities\": [");
+   for (i = 0; i < ntype; i++)
+   {
+      fprintf(out, "%s\n    {\"identity\": %d, \"man\": %u, \"id\": %u, \"rev\": %u, \"name\": ",
+         i ? "," : "", i, types[i].man, types[i].id, types[i].rev);
+      json_string(nex_slave[types[i].slave].name);
+      if (printOD)
+      {
+         print_od(&types[i]);
+      }
+      fprintf(out, "}");
+   }
+   fprintf(out, "\n  ],\n  \"slaves\": [\n");
+   for (i = 1; i <= nex_slavecount; i++)
+   {
+      print_slave(i);
+      fprintf(out, "%s\n", (i < nex_slavecount) ? "," : "");
+   }
+   fprintf(out, "  ]\n}\n");
+   if (out != stdout)
+   {
+      fclose(out);
+   }
+   fprintf(stderr, "%d slaves, %d identities, scan time %dms\n",
+      nex_slavecount, ntype, (int)((tdif.sec * 1000) + (tdif.usec / 1000)));
+   if (printOD)
+   {
+      fprintf(stderr, "OD cache hits %u misses %u requests %u\n", odcache.hits, odcache.misses, odcache.requests);
+      free(odpool);
+   }
+   nex_close();
+}
+
+int main(int argc, char *argv[])
+{
+   char *fname = NULL;
+   int i;
+
+   fprintf(stderr, "SOEM (Simple Open EtherCAT Master)\nNetwork scan\n");
+
+   if (argc > 1)
+   {
+      for (i = 2; i < argc; i++)
+      {
+         if (strncmp(argv[i], "-od", sizeof("-od")) == 0) printOD = TRUE;
+         if ((strncmp(argv[i], "-odcache", sizeof("-odcache")) == 0) && (i + 1 < argc))
+         {
+            printOD = TRUE;
+            odfile = argv[++i];
+         }
+         else if ((strncmp(argv[i], "-o", sizeof("-o")) == 0) && (i + 1 < argc)) fname = argv[++i];
+      }
+      netscan(argv[1], fname);
+   }
+   else
+   {
+      fprintf(stderr, "Usage: netscan ifname [options]\nifname = eth0 for example\nOptions :\n"
+         " -od : add object dictionary of every slave identity\n"
+         " -odcache file : load and save object dictionaries in file\n"
+         " -o file : write JSON to file instead of stdout\n");
+   }
+
+   fprintf(stderr, "End program\n");
+   return (0);
+}
@@ -0,0 +1,160 @@
+/** \file
+ * \brief Example code for Simple Open EtherCAT master
+ *
+ * Usage : nexd ifname [name] [cycletime]
+ * ifname is NIC interface, f.e. eth0
+ * name is the name of the shared memory, default nexd
+ * cycletime is the process data cycle in us, default 1000
+ *
+ * Master daemon. Owns the NIC, brings all slaves to OP and runs the process
+ * data cycle in a realtime thread. The process image and the slave status are
+ * published in shared memory, client processes queue output writes and SDO or
+ * state commands there, see nexd_client. A client that hangs or crashes does
+ * not stop the cycle. Stop the daemon with Ctrl-C.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <signal.h>
+
+#include "ethercat.h"
+
+char IOmap[4096];
+osal_shmt shmmap;
+nex_shmt *shm;
+OSAL_THREAD_HANDLE cyclethread;
+volatile int running;
+volatile uint32 overruns;
+int cycletime;
+
+void stop(int sig)
+{
+   (void)sig;                   /* Not used */
+   running = 0;
+}
+
+/* realtime part, only process data and the shared memory image */
+OSAL_THREAD_FUNC_RT nexd_cycle(void *ptr)
+{
+   osal_timert cycletimer;
+   int wkc;
+
+   (void)ptr;                   /* Not used */
+   while (running)
+   {
+      osal_timer_start(&cycletimer, cycletime);
+      nex_shm_outputs(shm, 0);
+      nex_send_processdata();
+      wkc = nex_receive_processdata(NEX_TIMEOUTRET);
+      nex_shm_publish(shm, 0, wkc);
+      if (osal_timer_is_expired(&cycletimer))
+      {
+         overruns++;
+      }
+      while (osal_timer_is_expired(&cycletimer) == FALSE)
+      {
+         osal_usleep(50);
+      }
+   }
+}
+
+void nexd(char *ifname, char *name)
+{
+   osal_timert statetimer, stattimer;
+   uint32 lastcycle;
+   int size;
+
+   if (!nex_init(ifname))
+   {
+      printf("No socket connection on %s\nExcecute as root\n", ifname);
+      return;
+   }
+   if (nex_config_init() <= 0)
+   {
+      printf("No slaves found!\n");
+      nex_close();
+      return;
+   }
+   size = nex_config_map(&IOmap);
+   nex_configdc();
+   nex_statecheck(0, NEX_STATE_SAFE_OP, NEX_TIMEOUTSTATE * 4);
+   printf("%d slaves, %d bytes outputs, %d bytes inputs\n", nex_slavecount, nex_group[0].Obytes, nex_group[0].Ibytes);
+   size = NEX_SHM_SIZE(nex_group[0].Obytes, nex_group[0].Ibytes);
+   shm = osal_shm_create(&shmmap, name, size);
+   if (!shm)
+   {
+      printf("Can not create shared memory %s\n", name);
+      nex_close();
+      return;
+   }
+   nex_shm_init(shm, size, 0);
+   running = 1;
+   signal(SIGINT, stop);
+   signal(SIGTERM, stop);
+   osal_thread_create_rt(&cyclethread, 128000, &nexd_cycle, NULL);
+   nex_slave[0].state = NEX_STATE_OPERATIONAL;
+   nex_writestate(0);
+   nex_statecheck(0, NEX_STATE_OPERATIONAL, NEX_TIMEOUTSTATE);
+   printf("Shared memory %s, %d bytes\n", name, size);
+   lastcycle = 0;
+   osal_timer_start(&statetimer, 100000);
+   osal_timer_start(&stattimer, 1000000);
+   /* commands of clients and slave status outside of the realtime thread */
+   while (running)
+   {
+      if (!nex_shm_service(shm))
+      {
+         osal_usleep(1000);
+      }
+      if (osal_timer_is_expired(&statetimer))
+      {
+         nex_readstate();
+         osal_timer_start(&statetimer, 100000);
+      }
+      if (osal_timer_is_expired(&stattimer))
+      {
+         printf("cycles %u wkc %d of %d overruns %u\n", shm->cycle - lastcycle, shm->wkc, shm->expectedwkc, overruns);
+         lastcycle = shm->cycle;
+         osal_timer_start(&stattimer, 1000000);
+      }
+      while (EcatError)
+      {
+         printf("%s", nex_elist2string());
+      }
+   }
+   osal_usleep(cycletime * 2);
+   nex_slave[0].state = NEX_STATE_INIT;
+   nex_writestate(0);
+   osal_shm_close(&shmmap);
+   nex_close();
+}
+
+int main(int argc, char *argv[])
+{
+   char *name = "nexd";
+
+   printf("SOEM (Simple Open EtherCAT Master)\nMaster daemon\n");
+
+   if (argc > 1)
+   {
+      cycletime = 1000;
+      if (argc > 2)
+      {
+         name = argv[2];
+      }
+      if (argc > 3)
+      {
+         cycletime = atoi(argv[3]);
+      }
+      nexd(argv[1], name);
+   }
+   else
+   {
+      printf("Usage: nexd ifname [name] [cycletime]\nifname = eth0 for example\n"
+             "name = shared memory name, default nexd\ncycletime = cycle in us, default 1000\n");
+   }
+
+   printf("End program\n");
+   return (0);
+}
@@ -0,0 +1,145 @@
+/** \file
+ * \brief Example code for Simple Open EtherCAT master
+ *
+ * Usage : nexd_client [name] [client]
+ * name is the name of the shared memory of nexd, default nexd
+ * client is the client number, 0 to 7, unique per process, default 0
+ *
+ * Client of the master daemon. Prints the slaves, reads the device type of
+ * every CoE slave with a command to the daemon, then counts the first output
+ * byte up for 5 seconds and prints the first input bytes. Uses the shared
+ * memory only, no NIC and no context.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "ethercat.h"
+
+#define SHOWBYTES 8
+
+osal_shmt shmmap;
+nex_shmt *shm;
+int client;
+
+/* send command to daemon and wait for its response */
+int command(nex_shmcmdt *cmd, int timeout)
+{
+   static uint32 id;
+   nex_shmcmdt rsp;
+   osal_timert timer;
+
+   cmd->id = ++id;
+   if (!nex_shmclient_request(shm, client, cmd))
+   {
+      return 0;
+   }
+   osal_timer_start(&timer, timeout);
+   while (!osal_timer_is_expired(&timer))
+   {
+      while (nex_shmclient_response(shm, client, &rsp))
+      {
+         if (rsp.id == cmd->id)
+         {
+            *cmd = rsp;
+            return 1;
+         }
+      }
+      osal_usleep(1000);
+   }
+   return 0;
+}
+
+void nexd_client(char *name)
+{
+   nex_shmslavet sl;
+   nex_shmcmdt cmd;
+   osal_timert runtimer, cycletimer;
+   uint8 in[SHOWBYTES], out;
+   uint32 cycle, n;
+   uint32 devtype;
+   int i, rval;
+
+   shm = osal_shm_open(&shmmap, name);
+   if (!shm)
+   {
+      printf("Shared memory %s not found, is nexd running?\n", name);
+      return;
+   }
+   rval = nex_shmclient_attach(shm, client);
+   if (!rval)
+   {
+      printf("Shared memory %s is not of nexd\n", name);
+      osal_shm_close(&shmmap);
+      return;
+   }
+   if (rval == 2)
+   {
+      printf("Client %d did not detach, taken over\n", client);
+   }
+   printf("%d slaves, %u bytes outputs, %u bytes inputs\n", shm->slavecount, shm->Obytes, shm->Ibytes);
+   for (i = 1; i <= shm->slavecount; i++)
+   {
+      nex_shmclient_slave(shm, (uint16)i, &sl);
+      printf("Slave %d %s state 0x%2.2x outputs %u.%d %d bits inputs %u.%d %d bits", i, sl.name, sl.state,
+         sl.Ooffset, sl.Ostartbit, sl.Obits, sl.Ioffset, sl.Istartbit, sl.Ibits);
+      memset(&cmd, 0, sizeof(cmd));
+      cmd.cmd = NEX_SHM_SDOREAD;
+      cmd.slave = (uint16)i;
+      cmd.index = 0x1000;
+      if (command(&cmd, NEX_TIMEOUTRXM * 2) && (cmd.wkc > 0) && (cmd.size == sizeof(devtype)))
+      {
+         memcpy(&devtype, cmd.data, sizeof(devtype));
+         printf(" device type 0x%8.8x", etohl(devtype));
+      }
+      printf("\n");
+   }
+   out = 0;
+   n = (shm->Ibytes < SHOWBYTES) ? shm->Ibytes : SHOWBYTES;
+   osal_timer_start(&runtimer, 5000000);
+   while (!osal_timer_is_expired(&runtimer))
+   {
+      osal_timer_start(&cycletimer, 100000);
+      if (shm->Obytes)
+      {
+         nex_shmclient_write(shm, client, 0, 1, &out, NULL);
+         out++;
+      }
+      nex_shmclient_read(shm, shm->Obytes, n, in, &cycle);
+      printf("cycle %u wkc %d inputs", cycle, shm->wkc);
+      for (i = 0; i < (int)n; i++)
+      {
+         printf(" %2.2x", in[i]);
+      }
+      printf("\r");
+      fflush(stdout);
+      while (!osal_timer_is_expired(&cycletimer))
+      {
+         osal_usleep(1000);
+      }
+   }
+   printf("\n");
+   nex_shmclient_detach(shm, client);
+   osal_shm_close(&shmmap);
+}
+
+int main(int argc, char *argv[])
+{
+   char *name = "nexd";
+
+   printf("SOEM (Simple Open EtherCAT Master)\nMaster daemon client\n");
+
+   if (argc > 1)
+   {
+      name = argv[1];
+   }
+   if (argc > 2)
+   {
+      client = atoi(argv[2]);
+   }
+   nexd_client(name);
+
+   printf("End program\n");
+   return (0);
+}
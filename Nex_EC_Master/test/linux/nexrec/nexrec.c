@@ -0,0 +1,380 @@
+/** \file
+ * \brief Example code for Simple Open EtherCAT master
+ *
+ * Usage : nexrec ifname file [options]
+ * ifname is NIC interface, f.e. eth0
+ * file is the recording written
+ * -r slave:i|o:offset:bytes records a byte range of the inputs or outputs
+ * -p slave:index:subindex records a mapped PDO entry, f.e. -p 1:0x6000:1
+ * -T channel:rising|falling|change:level:pre:post records around a trigger
+ * -z compresses the records
+ * -c cycletime in us, default 1000
+ * -s seconds recorded, default 10
+ *
+ * Usage : nexrec -d file
+ * prints a recording as CSV
+ *
+ * Process image recorder. Runs the process data cycle in a realtime thread
+ * that adds a record of the selected channels and the DC time per cycle to a
+ * ring. The main thread persists the ring to a memory mapped file.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ethercat.h"
+
+/** file grows in steps of this size */
+#define MAPCHUNK  (16 * 1024 * 1024)
+#define RINGSIZE  (4 * 1024 * 1024)
+
+typedef struct
+{
+   int     fd;
+   uint8   *base;
+   size_t  mapsize;
+   size_t  pos;
+} mapfilet;
+
+char IOmap[4096];
+uint8 ring[RINGSIZE];
+nex_rect rec;
+OSAL_THREAD_HANDLE cyclethread;
+volatile int running;
+int cycletime = 1000;
+
+void stop(int sig)
+{
+   (void)sig;                   /* Not used */
+   running = 0;
+}
+
+/* recorder hook, appends to the memory mapped file */
+int mapwrite(void *arg, const void *buf, int size)
+{
+   mapfilet *mf = (mapfilet *)arg;
+   size_t newsize;
+
+   if ((mf->pos + size) > mf->mapsize)
+   {
+      newsize = mf->mapsize + MAPCHUNK;
+      if (mf->base)
+      {
+         munmap(mf->base, mf->mapsize);
+         mf->base = NULL;
+      }
+      if (ftruncate(mf->fd, newsize) < 0)
+      {
+         return -1;
+      }
+      mf->base = mmap(NULL, newsize, PROT_READ | PROT_WRITE, MAP_SHARED, mf->fd, 0);
+      if (mf->base == MAP_FAILED)
+      {
+         mf->base = NULL;
+         return -1;
+      }
+      mf->mapsize = newsize;
+   }
+   memcpy(mf->base + mf->pos, buf, size);
+   mf->pos += size;
+   return size;
+}
+
+OSAL_THREAD_FUNC_RT nexrec_cycle(void *ptr)
+{
+   osal_timert cycletimer;
+
+   (void)ptr;                   /* Not used */
+   while (running)
+   {
+      osal_timer_start(&cycletimer, cycletime);
+      nex_send_processdata();
+      nex_receive_processdata(NEX_TIMEOUTRET);
+      nex_rec_sample(&rec);
+      while (osal_timer_is_expired(&cycletimer) == FALSE)
+      {
+         osal_usleep(50);
+      }
+   }
+}
+
+/* add channels and trigger of the command line */
+int channels(int argc, char *argv[])
+{
+   char dir, type[16];
+   int i, slave, index, subindex, offset, bytes, channel, pre, post, trig;
+   long long level;
+
+   for (i = 3; i < argc; i++)
+   {
+      if (!strcmp(argv[i], "-r") && (++i < argc))
+      {
+         if ((sscanf(argv[i], "%d:%c:%i:%i", &slave, &dir, &offset, &bytes) != 4) ||
+             (nex_rec_addrange(&rec, (uint16)slave, (dir == 'o') ? NEX_REC_OUTPUTS : NEX_REC_INPUTS,
+                               (uint32)offset, (uint32)bytes) < 0))
+         {
+            printf("Invalid range %s\n", argv[i]);
+            return 0;
+         }
+      }
+      else if (!strcmp(argv[i], "-p") && (++i < argc))
+      {
+         if ((sscanf(argv[i], "%d:%i:%i", &slave, &index, &subindex) != 3) ||
+             (nex_rec_addpdo(&rec, (uint16)slave, (uint16)index, (uint8)subindex) < 0))
+         {
+            printf("PDO entry %s not mapped\n", argv[i]);
+            return 0;
+         }
+      }
+   }
+   /* trigger after all channels exist */
+   for (i = 3; i < argc; i++)
+   {
+      if (!strcmp(argv[i], "-T") && (++i < argc))
+      {
+         if (sscanf(argv[i], "%d:%15[a-z]:%lli:%d:%d", &channel, type, &level, &pre, &post) != 5)
+         {
+            printf("Invalid trigger %s\n", argv[i]);
+            return 0;
+         }
+         trig = NEX_REC_TRIG_CHANGE;
+         if (!strcmp(type, "rising"))
+         {
+            trig = NEX_REC_TRIG_RISING;
+         }
+         else if (!strcmp(type, "falling"))
+         {
+            trig = NEX_REC_TRIG_FALLING;
+         }
+         if (!nexx_rec_trigger(&rec, channel, (uint8)trig, level, 0, FALSE, (uint32)pre, (uint32)post))
+         {
+            printf("Invalid trigger channel %d\n", channel);
+            return 0;
+         }
+      }
+   }
+   return 1;
+}
+
+void nexrec(char *ifname, char *filename, int argc, char *argv[])
+{
+   osal_timert runtimer, stattimer;
+   mapfilet mf;
+   boolean compress = FALSE;
+   int i, seconds = 10;
+
+   for (i = 3; i < argc; i++)
+   {
+      if (!strcmp(argv[i], "-z"))
+      {
+         compress = TRUE;
+      }
+      else if (!strcmp(argv[i], "-c") && (i + 1 < argc))
+      {
+         cycletime = atoi(argv[++i]);
+      }
+      else if (!strcmp(argv[i], "-s") && (i + 1 < argc))
+      {
+         seconds = atoi(argv[++i]);
+      }
+   }
+   if (!nex_init(ifname))
+   {
+      printf("No socket connection on %s\nExcecute as root\n", ifname);
+      return;
+   }
+   if (nex_config_init() <= 0)
+   {
+      printf("No slaves found!\n");
+      nex_close();
+      return;
+   }
+   nex_config_map(&IOmap);
+   nex_configdc();
+   nex_statecheck(0, NEX_STATE_SAFE_OP, NEX_TIMEOUTSTATE * 4);
+   nexx_rec_init(&rec, ring, sizeof(ring), compress);
+   if (!channels(argc, argv) || !rec.nchannel || (nex_rec_start(&rec) <= 0))
+   {
+      printf("No channels recorded\n");
+      nex_close();
+      return;
+   }
+   memset(&mf, 0, sizeof(mf));
+   mf.fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+   if (mf.fd < 0)
+   {
+      printf("Can not create %s\n", filename);
+      nex_close();
+      return;
+   }
+   nexx_rec_header(&rec, mapwrite, &mf);
+   printf("%d channels, %d bytes per record, %u records in ring\n", rec.nchannel, rec.recsize, rec.nrec);
+   running = 1;
+   signal(SIGINT, stop);
+   osal_thread_create_rt(&cyclethread, 128000, &nexrec_cycle, NULL);
+   nex_slave[0].state = NEX_STATE_OPERATIONAL;
+   nex_writestate(0);
+   nex_statecheck(0, NEX_STATE_OPERATIONAL, NEX_TIMEOUTSTATE);
+   osal_timer_start(&runtimer, seconds * 1000000);
+   osal_timer_start(&stattimer, 1000000);
+   while (running && !osal_timer_is_expired(&runtimer))
+   {
+      if (nexx_rec_flush(&rec, mapwrite, &mf) < 0)
+      {
+         printf("Write error\n");
+         break;
+      }
+      if (osal_timer_is_expired(&stattimer))
+      {
+         printf("samples %u written %u dropped %u triggers %u sample max %u us avg %.2f us\n",
+            rec.stat.samples, rec.stat.written, rec.stat.dropped, rec.stat.triggers, rec.stat.maxus,
+            rec.stat.samples ? (double)rec.stat.sumus / rec.stat.samples : 0.0);
+         osal_timer_start(&stattimer, 1000000);
+      }
+      while (EcatError)
+      {
+         printf("%s", nex_elist2string());
+      }
+      osal_usleep(10000);
+   }
+   running = 0;
+   osal_usleep(cycletime * 2);
+   nexx_rec_flush(&rec, mapwrite, &mf);
+   printf("%u records, %lu bytes in %s\n", rec.stat.written, (unsigned long)mf.pos, filename);
+   if (mf.base)
+   {
+      munmap(mf.base, mf.mapsize);
+   }
+   if (ftruncate(mf.fd, mf.pos) < 0)
+   {
+      printf("Can not truncate %s\n", filename);
+   }
+   close(mf.fd);
+   nex_slave[0].state = NEX_STATE_INIT;
+   nex_writestate(0);
+   nex_close();
+}
+
+/* print recording as CSV */
+void nexrec_dump(char *filename)
+{
+   nex_recfileheadert fh;
+   nex_recfilechannelt *fc;
+   struct stat st;
+   uint8 *base, *p, r[NEX_REC_HEADSIZE + NEX_REC_MAXDATA];
+   uint32 seq;
+   int64 dctime;
+   size_t size;
+   int fd, i, used, recsize;
+
+   fd = open(filename, O_RDONLY);
+   if ((fd < 0) || (fstat(fd, &st) < 0) || (st.st_size < (off_t)sizeof(fh)))
+   {
+      printf("Can not read %s\n", filename);
+      return;
+   }
+   size = st.st_size;
+   base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (base == MAP_FAILED)
+   {
+      return;
+   }
+   memcpy(&fh, base, sizeof(fh));
+   recsize = etohs(fh.recsize);
+   if ((etohl(fh.magic) != NEX_REC_MAGIC) || (recsize > (int)sizeof(r)) ||
+       (size < sizeof(fh) + fh.nchannel * sizeof(nex_recfilechannelt)))
+   {
+      printf("%s is no recording\n", filename);
+      munmap(base, size);
+      return;
+   }
+   fc = (nex_recfilechannelt *)(base + sizeof(fh));
+   printf("sample,dctime");
+   for (i = 0; i < fh.nchannel; i++)
+   {
+      if (fc[i].index)
+      {
+         printf(",%d:%4.4x:%2.2x", etohs(fc[i].slave), etohs(fc[i].index), fc[i].subindex);
+      }
+      else
+      {
+         printf(",%d:%c:%u", etohs(fc[i].slave), fc[i].dir == NEX_REC_OUTPUTS ? 'o' : 'i', etohl(fc[i].bitoffset) / 8);
+      }
+   }
+   printf("\n");
+   p = (uint8 *)(fc + fh.nchannel);
+   memset(r, 0, sizeof(r));
+   while (p < base + size)
+   {
+      if (fh.compress)
+      {
+         used = nexx_rec_decode(p, (int)(base + size - p), r, recsize);
+      }
+      else
+      {
+         used = ((base + size - p) >= recsize) ? recsize : -1;
+         if (used > 0)
+         {
+            memcpy(r, p, recsize);
+         }
+      }
+      if (used < 0)
+      {
+         printf("Truncated record\n");
+         break;
+      }
+      p += used;
+      memcpy(&seq, r, sizeof(seq));
+      memcpy(&dctime, r + 4, sizeof(dctime));
+      printf("%u,%lld", etohl(seq), (long long)etohll(dctime));
+      for (i = 0; i < fh.nchannel; i++)
+      {
+         if (etohs(fc[i].bits) <= 64)
+         {
+            printf(",%lld", (long long)nexx_rec_value(r, etohs(fc[i].recoffset), etohs(fc[i].bits), FALSE));
+         }
+         else
+         {
+            printf(",");
+         }
+      }
+      printf("\n");
+   }
+   munmap(base, size);
+}
+
+int main(int argc, char *argv[])
+{
+   if ((argc > 2) && !strcmp(argv[1], "-d"))
+   {
+      nexrec_dump(argv[2]);
+      return (0);
+   }
+
+   printf("SOEM (Simple Open EtherCAT Master)\nProcess image recorder\n");
+
+   if (argc > 2)
+   {
+      nexrec(argv[1], argv[2], argc, argv);
+   }
+   else
+   {
+      printf("Usage: nexrec ifname file [options]\nifname = eth0 for example\n"
+             "-r slave:i|o:offset:bytes = record byte range of inputs or outputs\n"
+             "-p slave:index:subindex = record mapped PDO entry\n"
+             "-T channel:rising|falling|change:level:pre:post = record around trigger\n"
+             "-z = compress records\n-c cycletime = cycle in us, default 1000\n"
+             "-s seconds = recording time, default 10\n"
+             "Usage: nexrec -d file\nprints recording as CSV\n");
+   }
+
+   printf("End program\n");
+   return (0);
+}
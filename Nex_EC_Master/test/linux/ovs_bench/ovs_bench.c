@@ -0,0 +1,258 @@
+/** \file
+ * \brief Example code for Simple Open EtherCAT master
+ *
+ * Usage : ovs_bench [iterations]
+ * iterations per measurement, default 20000
+ *
+ * Check and benchmark of the oversampling demultiplexer without a network.
+ * Feeds random sample arrays of 2 channels of 16 bit, 4 channels of 16 bit
+ * and 2 channels of 32 bit through nexx_ovs_process, with sample counts that
+ * leave a tail for the scalar loop and buffers that wrap, and compares the
+ * channel buffers and time stamps with a plain scalar split. Counter gaps are
+ * checked with NEX_OVS_GAP_FLAG and NEX_OVS_GAP_HOLD. The split is timed
+ * against the scalar one.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "ethercat.h"
+
+#define CYCLE      1000000
+#define BUFSAMPLES 512
+#define MAXSAMPLE  100
+#define MAXBYTES   (MAXSAMPLE * NEX_OVS_MAXCHANNEL * 4)
+
+uint8 inputs[2 + MAXBYTES];
+uint64 mem[(BUFSAMPLES * (sizeof(int64) + 1 + (NEX_OVS_MAXCHANNEL * 4))) / 8];
+uint8 chdata[NEX_OVS_MAXCHANNEL][BUFSAMPLES * 4];
+uint8 refdata[NEX_OVS_MAXCHANNEL][MAXSAMPLE * 4];
+int64 stamp[BUFSAMPLES];
+uint8 flag[BUFSAMPLES];
+nex_slavet slavelist[2];
+nex_groupt grouplist[1];
+int slavecount = 1;
+nexx_contextt context;
+nex_ovst ovs;
+int failures;
+
+void check(int ok, const char *what, int nch, int size, int nsample)
+{
+   if (!ok)
+   {
+      printf("  FAIL: %s, %d x %d bit, %d samples\n", what, nch, size * 8, nsample);
+      failures++;
+   }
+}
+
+/* channel by channel, byte copies */
+void scalar_split(const uint8 *src, int n, int nch, int size)
+{
+   int i, c;
+
+   for (i = 0; i < n; i++)
+   {
+      for (c = 0; c < nch; c++)
+      {
+         memcpy(refdata[c] + (i * size), src + (((i * nch) + c) * size), size);
+      }
+   }
+}
+
+int setup(int nch, int size, int nsample, uint8 gap)
+{
+   nex_ovsconfigt cf;
+
+   memset(&context, 0, sizeof(context));
+   memset(slavelist, 0, sizeof(slavelist));
+   memset(grouplist, 0, sizeof(grouplist));
+   context.slavelist = slavelist;
+   context.slavecount = &slavecount;
+   context.grouplist = grouplist;
+   slavelist[1].inputs = inputs;
+   slavelist[1].Ibytes = 2 + (nsample * nch * size);
+   slavelist[1].DCcycle = CYCLE;
+   memset(&cf, 0, sizeof(cf));
+   cf.slave = 1;
+   cf.offset = 2;
+   cf.samplesize = (uint8)size;
+   cf.sign = TRUE;
+   cf.nchannel = (uint8)nch;
+   cf.nsample = (uint16)nsample;
+   cf.counteroffset = 0;
+   cf.countersize = 1;
+   cf.sampletime = CYCLE / nsample;
+   cf.gap = gap;
+   return nexx_ovs_init(&ovs, &cf, mem, (uint32)(BUFSAMPLES * (sizeof(int64) + 1 + (nch * size)))) &&
+          nexx_ovs_start(&context, &ovs);
+}
+
+/* new sample array with counter, the frame arrives 300 us after the last SYNC0 */
+void newcycle(int cyc, int nch, int size, int nsample)
+{
+   int i;
+
+   inputs[0] = (uint8)cyc;
+   for (i = 0; i < nsample * nch * size; i++)
+   {
+      inputs[2 + i] = (uint8)rand();
+   }
+   grouplist[0].DCtime = ((int64)cyc * CYCLE) + 300000;
+}
+
+/* time of the last sample before the frame */
+int64 lastsample(int nsample)
+{
+   int64 dctime = grouplist[0].DCtime;
+
+   return dctime - (dctime % (CYCLE / nsample));
+}
+
+int readall(void)
+{
+   void *data[NEX_OVS_MAXCHANNEL];
+   int c;
+
+   for (c = 0; c < NEX_OVS_MAXCHANNEL; c++)
+   {
+      data[c] = chdata[c];
+   }
+   return nexx_ovs_read(&ovs, data, stamp, flag, BUFSAMPLES);
+}
+
+/* split of every cycle equals the scalar split, buffers wrap */
+void splitcheck(int nch, int size, int nsample)
+{
+   int cyc, c, i, n, ok, tok;
+
+   check(setup(nch, size, nsample, NEX_OVS_GAP_FLAG), "setup", nch, size, nsample);
+   ok = tok = 1;
+   for (cyc = 1; cyc <= 50; cyc++)
+   {
+      newcycle(cyc, nch, size, nsample);
+      n = nexx_ovs_process(&context, &ovs);
+      ok = ok && (n == nsample);
+      scalar_split(inputs + 2, nsample, nch, size);
+      n = readall();
+      ok = ok && (n == nsample);
+      for (c = 0; c < nch; c++)
+      {
+         ok = ok && !memcmp(chdata[c], refdata[c], nsample * size);
+      }
+      for (i = 0; i < nsample; i++)
+      {
+         tok = tok && (stamp[i] == lastsample(nsample) - ((int64)(nsample - 1 - i) * (CYCLE / nsample))) &&
+               !flag[i];
+      }
+   }
+   check(ok, "split differs from scalar split", nch, size, nsample);
+   check(tok, "time stamps", nch, size, nsample);
+}
+
+/* two cycles missed, flagged only or filled with the last sample */
+void gapcheck(int nch, int size, int nsample, uint8 gap)
+{
+   uint8 last[NEX_OVS_MAXCHANNEL][4];
+   int c, i, n, fill, ok;
+
+   check(setup(nch, size, nsample, gap), "setup", nch, size, nsample);
+   newcycle(1, nch, size, nsample);
+   nexx_ovs_process(&context, &ovs);
+   readall();
+   for (c = 0; c < nch; c++)
+   {
+      memcpy(last[c], chdata[c] + ((nsample - 1) * size), size);
+   }
+   newcycle(4, nch, size, nsample);
+   n = nexx_ovs_process(&context, &ovs);
+   fill = (gap == NEX_OVS_GAP_HOLD) ? 2 * nsample : 0;
+   check(n == fill + nsample, "samples added after gap", nch, size, nsample);
+   check(ovs.stat.missed == 2, "missed cycles counted", nch, size, nsample);
+   scalar_split(inputs + 2, nsample, nch, size);
+   n = readall();
+   ok = (n == fill + nsample);
+   for (i = 0; ok && (i < n); i++)
+   {
+      ok = (stamp[i] == lastsample(nsample) - ((int64)(n - 1 - i) * (CYCLE / nsample))) &&
+           (flag[i] == ((i < fill) ? NEX_OVS_FLAG_FILLED : (i == fill) ? NEX_OVS_FLAG_GAP : 0));
+      for (c = 0; ok && (c < nch); c++)
+      {
+         ok = !memcmp(chdata[c] + (i * size), (i < fill) ? last[c] : refdata[c] + ((i - fill) * size), size);
+      }
+   }
+   check(ok, (gap == NEX_OVS_GAP_HOLD) ? "hold gap" : "flag gap", nch, size, nsample);
+}
+
+double measure(int nch, int size, int nsample, int iterations, int scalar)
+{
+   nex_timet t0, t1, diff;
+   int i;
+
+   setup(nch, size, nsample, NEX_OVS_GAP_FLAG);
+   newcycle(1, nch, size, nsample);
+   t0 = osal_current_time();
+   for (i = 0; i < iterations; i++)
+   {
+      if (scalar)
+      {
+         scalar_split(inputs + 2, nsample, nch, size);
+      }
+      else
+      {
+         /* new counter every cycle, the reader keeps the buffers free */
+         inputs[0]++;
+         nexx_ovs_process(&context, &ovs);
+         ovs.tail = ovs.head;
+      }
+   }
+   t1 = osal_current_time();
+   osal_time_diff(&t0, &t1, &diff);
+   return ((diff.sec * 1e9) + (diff.usec * 1e3)) / iterations;
+}
+
+void ovs_bench(int iterations)
+{
+   static const int layout[][2] = {{2, 2}, {4, 2}, {2, 4}};
+   static const int samples[] = {8, 37, 100};
+   int l, s, nch, size;
+
+#if defined(__SSE2__)
+   printf("Kernel SSE2\n");
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+   printf("Kernel NEON\n");
+#else
+   printf("Kernel scalar\n");
+#endif
+   printf("layout     samples  scalar split  nexx_ovs_process  (ns per cycle)\n");
+   for (l = 0; l < (int)(sizeof(layout) / sizeof(layout[0])); l++)
+   {
+      nch = layout[l][0];
+      size = layout[l][1];
+      for (s = 0; s < (int)(sizeof(samples) / sizeof(samples[0])); s++)
+      {
+         splitcheck(nch, size, samples[s]);
+         gapcheck(nch, size, samples[s], NEX_OVS_GAP_FLAG);
+         gapcheck(nch, size, samples[s], NEX_OVS_GAP_HOLD);
+         printf("%d x %2d bit  %7d  %12.0f  %16.0f\n", nch, size * 8, samples[s],
+            measure(nch, size, samples[s], iterations, 1), measure(nch, size, samples[s], iterations, 0));
+      }
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   int iterations = 20000;
+
+   printf("SOEM (Simple Open EtherCAT Master)\nOversampling benchmark\n");
+
+   if (argc > 1)
+   {
+      iterations = atoi(argv[1]);
+   }
+   ovs_bench(iterations);
+
+   printf("%s\n", failures ? "FAIL" : "OK");
+   printf("End program\n");
+   return failures ? 1 : 0;
+}
@@ -0,0 +1,245 @@
+/** \file
+ * \brief Example code for Simple Open EtherCAT master
+ *
+ * Usage : pd_bench ifname [cycles]
+ * ifname is NIC interface, f.e. eth0
+ * cycles measured per path, default 10000
+ *
+ * Benchmark of the specialized process data paths. Runs the process data of
+ * all slaves with the generic path and with the path selected by
+ * nex_select_processdata, and counts instructions, branches and branch misses
+ * of send and receive in user space with the perf counters of linux. The
+ * receive is counted after the frames have returned, so waiting is not
+ * counted. Needs kernel.perf_event_paranoid <= 2. Without hardware counters,
+ * f.e. in a virtual machine, the task clock in ns is counted instead.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "ethercat.h"
+
+#define NCOUNTER 3
+
+char IOmap[4096];
+int fd[NCOUNTER];
+/** counters open, NCOUNTER hardware counters or the task clock */
+int ncounter;
+
+int counters_open(void)
+{
+   static const uint64 config[NCOUNTER] =
+   {
+      PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES
+   };
+   struct perf_event_attr pe;
+   int i;
+
+   for (i = 0; i < NCOUNTER; i++)
+   {
+      memset(&pe, 0, sizeof(pe));
+      pe.type = PERF_TYPE_HARDWARE;
+      pe.size = sizeof(pe);
+      pe.config = config[i];
+      pe.disabled = 1;
+      pe.exclude_kernel = 1;
+      pe.exclude_hv = 1;
+      fd[i] = (int)syscall(__NR_perf_event_open, &pe, 0, -1, -1, 0);
+      if (fd[i] < 0)
+      {
+         break;
+      }
+   }
+   if (i == NCOUNTER)
+   {
+      ncounter = NCOUNTER;
+      return 1;
+   }
+   printf("No hardware perf counters: %s, counting the task clock\n", strerror(errno));
+   while (i > 0)
+   {
+      close(fd[--i]);
+   }
+   memset(&pe, 0, sizeof(pe));
+   pe.type = PERF_TYPE_SOFTWARE;
+   pe.size = sizeof(pe);
+   pe.config = PERF_COUNT_SW_TASK_CLOCK;
+   pe.disabled = 1;
+   pe.exclude_kernel = 1;
+   pe.exclude_hv = 1;
+   fd[0] = (int)syscall(__NR_perf_event_open, &pe, 0, -1, -1, 0);
+   ncounter = (fd[0] < 0) ? 0 : 1;
+   return ncounter;
+}
+
+void counters_start(void)
+{
+   int i;
+
+   for (i = 0; i < ncounter; i++)
+   {
+      ioctl(fd[i], PERF_EVENT_IOC_ENABLE, 0);
+   }
+}
+
+void counters_stop(void)
+{
+   int i;
+
+   for (i = 0; i < ncounter; i++)
+   {
+      ioctl(fd[i], PERF_EVENT_IOC_DISABLE, 0);
+   }
+}
+
+void counters_read(uint64 *value)
+{
+   int i;
+
+   for (i = 0; i < ncounter; i++)
+   {
+      if (read(fd[i], &value[i], sizeof(value[i])) != sizeof(value[i]))
+      {
+         value[i] = 0;
+      }
+      ioctl(fd[i], PERF_EVENT_IOC_RESET, 0);
+   }
+}
+
+/* count send and receive of a number of cycles */
+int measure(int cycles, uint64 *send, uint64 *receive)
+{
+   uint64 value[NCOUNTER];
+   int i, c, wkc, lost = 0;
+
+   for (i = 0; i < NCOUNTER; i++)
+   {
+      send[i] = 0;
+      receive[i] = 0;
+   }
+   for (c = 0; c < cycles; c++)
+   {
+      counters_read(value);
+      counters_start();
+      nex_send_processdata();
+      counters_stop();
+      counters_read(value);
+      for (i = 0; i < ncounter; i++)
+      {
+         send[i] += value[i];
+      }
+      /* let the frames return, the wait is not counted */
+      osal_usleep(500);
+      counters_start();
+      wkc = nex_receive_processdata(NEX_TIMEOUTRET);
+      counters_stop();
+      counters_read(value);
+      for (i = 0; i < ncounter; i++)
+      {
+         receive[i] += value[i];
+      }
+      if (wkc < (nex_group[0].outputsWKC * 2) + nex_group[0].inputsWKC)
+      {
+         lost++;
+      }
+   }
+   return lost;
+}
+
+void print(const char *name, uint64 *v, int cycles)
+{
+   if (ncounter == NCOUNTER)
+   {
+      printf("%-12s %14.1f %10.1f %14.2f\n", name, (double)v[0] / cycles, (double)v[1] / cycles,
+         (double)v[2] / cycles);
+   }
+   else
+   {
+      printf("%-12s %14.1f\n", name, (double)v[0] / cycles);
+   }
+}
+
+void pd_bench(char *ifname, int cycles)
+{
+   uint64 gsend[NCOUNTER], greceive[NCOUNTER], ssend[NCOUNTER], sreceive[NCOUNTER];
+   int glost, slost;
+
+   if (!counters_open())
+   {
+      printf("No perf counters, check kernel.perf_event_paranoid\n");
+      return;
+   }
+   if (!nex_init(ifname))
+   {
+      printf("No socket connection on %s\nExcecute as root\n", ifname);
+      return;
+   }
+   if (nex_config_init() <= 0)
+   {
+      printf("No slaves found!\n");
+      nex_close();
+      return;
+   }
+   nex_config_map(&IOmap);
+   nex_configdc();
+   nex_statecheck(0, NEX_STATE_SAFE_OP, NEX_TIMEOUTSTATE * 4);
+   printf("%d slaves, %d bytes outputs, %d bytes inputs, %d segments, DC %s, LRW %s\n", nex_slavecount,
+      nex_group[0].Obytes, nex_group[0].Ibytes, nex_group[0].nsegments, nex_group[0].hasdc ? "yes" : "no",
+      nex_group[0].blockLRW ? "blocked" : "yes");
+
+   /* generic path */
+   nex_select_processdata(0, FALSE);
+   nex_group[0].pdsend = NULL;
+   nex_group[0].pdreceive = NULL;
+   measure(100, gsend, greceive);
+   glost = measure(cycles, gsend, greceive);
+   /* specialized path */
+   nex_select_processdata(0, FALSE);
+   if (!nex_group[0].pdsend)
+   {
+      printf("No specialized path for this mapping\n");
+   }
+   measure(100, ssend, sreceive);
+   slost = measure(cycles, ssend, sreceive);
+
+   if (ncounter == NCOUNTER)
+   {
+      printf("per cycle     instructions   branches  branch misses\n");
+   }
+   else
+   {
+      printf("per cycle    task clock ns\n");
+   }
+   print("generic tx", gsend, cycles);
+   print("special tx", ssend, cycles);
+   print("generic rx", greceive, cycles);
+   print("special rx", sreceive, cycles);
+   printf("cycles %d, low wkc generic %d specialized %d\n", cycles, glost, slost);
+   nex_slave[0].state = NEX_STATE_INIT;
+   nex_writestate(0);
+   nex_close();
+}
+
+int main(int argc, char *argv[])
+{
+   printf("SOEM (Simple Open EtherCAT Master)\nProcess data path benchmark\n");
+
+   if (argc > 1)
+   {
+      pd_bench(argv[1], (argc > 2) ? atoi(argv[2]) : 10000);
+   }
+   else
+   {
+      printf("Usage: pd_bench ifname [cycles]\nifname = eth0 for example\n"
+             "cycles = cycles measured per path, default 10000\n");
+   }
+
+   printf("End program\n");
+   return (0);
+}
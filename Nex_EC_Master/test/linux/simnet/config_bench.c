@@ -0,0 +1,214 @@
+/** \file
+ * \brief Configuration benchmark on a simulated segment
+ *
+ * Usage : config_bench
+ *
+ * Times nex_config_init on simulated segments of 250 to 2000 slaves with
+ * random junctions, once with 8 slave types and once with a type per slave.
+ * The parent of every slave must match the backward search config_init used
+ * before the topology tree, and sameid must match the forward identity scan
+ * of nexx_lookup_prev_sii before the identity index. Both old searches are
+ * timed next to the new ones. Nested junctions, the worst case of the
+ * backward search, are timed without a segment.
+ *
+ * Needs NEX_MAXSLAVE of 2001 or more, see CMakeLists.txt.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ethercat.h"
+#include "simnet.h"
+
+#define MAXN     2000
+
+static uint16 parent[NEX_MAXSLAVE];
+static int failures;
+
+static void check(boolean ok, const char *what)
+{
+   if (!ok)
+   {
+      printf("  FAIL: %s\n", what);
+      failures++;
+   }
+}
+
+static double now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (ts.tv_sec * 1e3) + (ts.tv_nsec * 1e-6);
+}
+
+/* parent search of config_init before the topology tree */
+static void old_parent(void)
+{
+   int slave, slavec, topoc;
+   uint8 t;
+
+   for (slave = 1; slave <= nex_slavecount; slave++)
+   {
+      parent[slave] = 0;
+      if (slave > 1)
+      {
+         topoc = 0;
+         slavec = slave - 1;
+         do
+         {
+            t = nex_slave[slavec].topology;
+            if (t == 1)
+            {
+               topoc--; /* endpoint found */
+            }
+            if (t == 3)
+            {
+               topoc++; /* split found */
+            }
+            if (t == 4)
+            {
+               topoc += 2; /* cross split found */
+            }
+            if (((topoc >= 0) && (t > 1)) || (slavec == 1)) /* parent found */
+            {
+               parent[slave] = (uint16)slavec;
+               slavec = 1;
+            }
+            slavec--;
+         } while (slavec > 0);
+      }
+   }
+}
+
+/* identity scan of nexx_lookup_prev_sii before the identity index */
+static uint16 old_sameid(int slave)
+{
+   int i = 1;
+
+   while (((nex_slave[i].eep_man != nex_slave[slave].eep_man) ||
+           (nex_slave[i].eep_id != nex_slave[slave].eep_id) ||
+           (nex_slave[i].eep_rev != nex_slave[slave].eep_rev)) && (i < slave))
+   {
+      i++;
+   }
+   return (i < slave) ? (uint16)i : 0;
+}
+
+/* ports with link of a slave in a random tree, mostly lines */
+static int randomlinks(int i, int n)
+{
+   int r = rand() % 10;
+
+   if (i == (n - 1))
+   {
+      return 1;
+   }
+   return (r < 6) ? 2 : (r < 8) ? 1 : (r < 9) ? 3 : 4;
+}
+
+static void configbench(int n, boolean unique)
+{
+   double t0, t1, t2, t3, t4;
+   uint32 frames;
+   int i, wkc, pdiff, sdiff;
+
+   simnet_init(n);
+   for (i = 0; i < n; i++)
+   {
+      simnet_identity(i, 0x2, 0x1000 + (unique ? i : (i % 8)), 0x10000 + (i % 3));
+      simnet_links(i, randomlinks(i, n));
+   }
+   frames = simnet_frames;
+   t0 = now();
+   wkc = nex_config_init();
+   t1 = now();
+   frames = simnet_frames - frames;
+   check(wkc == n, "all slaves found");
+   old_parent();
+   t2 = now();
+   pdiff = 0;
+   for (i = 1; i <= nex_slavecount; i++)
+   {
+      pdiff += (nex_slave[i].parent != parent[i]);
+   }
+   sdiff = 0;
+   t3 = now();
+   for (i = 1; i <= nex_slavecount; i++)
+   {
+      sdiff += (old_sameid(i) != nex_slave[i].sameid);
+   }
+   t4 = now();
+   check(!pdiff, "parents match the backward search");
+   check(!sdiff, "sameid matches the identity scan");
+   t2 -= t1;
+   t1 -= t0;
+   t0 = now();
+   nex_topology_build();
+   printf("%5d  %-6s  %8.1f  %7.2f  %6u  %10.3f  %9.3f  %10.3f\n", n, unique ? "unique" : "8",
+      t1, t1 * 1e3 / n, frames, t2, now() - t0, t4 - t3);
+}
+
+/* n/2 junctions followed by their ends, every backward search walks to the first slave */
+static void nestedbench(int n)
+{
+   double t0, t1, t2;
+   int k, pdiff;
+
+   nex_slavecount = n;
+   for (k = 1; k <= n; k++)
+   {
+      memset(&nex_slave[k], 0, sizeof(nex_slave[k]));
+      nex_slave[k].topology = (k <= n / 2) ? 3 : 1;
+   }
+   t0 = now();
+   old_parent();
+   t1 = now();
+   nex_topology_build();
+   t2 = now();
+   pdiff = 0;
+   for (k = 1; k <= n; k++)
+   {
+      pdiff += (nex_slave[k].parent != parent[k]);
+   }
+   check(!pdiff, "parents of nested junctions match the backward search");
+   printf("%5d  %14.3f  %9.3f\n", n, t1 - t0, t2 - t1);
+}
+
+int main(void)
+{
+   int n, u;
+
+   printf("SOEM (Simple Open EtherCAT Master)\nConfiguration benchmark on a simulated segment\n");
+
+   if (MAXN >= NEX_MAXSLAVE)
+   {
+      printf("Build with NEX_MAXSLAVE > %d\n", MAXN);
+      return 1;
+   }
+   if (!nex_init("simnet"))
+   {
+      printf("No socket connection\n");
+      return 1;
+   }
+   printf("                config_init             parents ms          sameid ms\n");
+   printf("slaves types        ms  us/slave  frames   old search   new tree  old scan\n");
+   for (u = 0; u < 2; u++)
+   {
+      for (n = 250; n <= MAXN; n *= 2)
+      {
+         configbench(n, (boolean)u);
+      }
+   }
+   printf("nested junctions, parents ms\nslaves     old search   new tree\n");
+   for (n = 500; n <= MAXN; n *= 2)
+   {
+      nestedbench(n);
+   }
+   nex_close();
+
+   printf("%s\n", failures ? "FAIL" : "OK");
+   return failures ? 1 : 0;
+}
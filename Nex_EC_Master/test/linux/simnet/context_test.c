@@ -0,0 +1,264 @@
+/** \file
+ * \brief Parallel context test on simulated segments
+ *
+ * Usage : context_test [contexts]
+ * contexts run at the same time, default 4
+ *
+ * Every context gets a simulated segment of its own with a different number of
+ * slaves and process data size, and runs configuration, mapping and the
+ * process data cycle in a thread of its own. The first slave of a segment
+ * answers an SDO read with the number of its segment. Every context must find
+ * its own slaves, get the outputs and inputs of its own segment in every cycle
+ * and read its own segment number, and the default segment "simnet" must see
+ * no frame.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "ethercat.h"
+#include "simnet.h"
+
+/** start of outputs and inputs in the ESC memory of the simulated slaves */
+#define OUTADR   0x1400
+#define INADR    0x1C00
+#define MAXCONTEXT (SIMNET_MAXSEGMENT - 1)
+#define CYCLES   2000
+/** object that holds the segment number */
+#define SEGINDEX 0x2000
+
+/** everything a context refers to, one per segment */
+typedef struct
+{
+   nexx_contextt    context;
+   nexx_portt       port;
+   nex_slavet       slave[NEX_MAXSLAVE];
+   int              slavecount;
+   nex_groupt       group[NEX_MAXGROUP];
+   uint8            esibuf[NEX_MAXEEPBUF];
+   uint32           esimap[NEX_MAXEEPBITMAP];
+   nex_eringt       elist;
+   nex_idxstackT    idxstack;
+   boolean          ecaterror;
+   int64            DCtime;
+   nex_SMcommtypet  SMcommtype[NEX_MAX_MAPT];
+   nex_PDOassignt   PDOassign[NEX_MAX_MAPT];
+   nex_PDOdesct     PDOdesc[NEX_MAX_MAPT];
+   nex_eepromSMt    eepSM;
+   nex_eepromFMMUt  eepFMMU;
+   nex_emcylistt    emcylist;
+   uint8            IOmap[4096];
+   /* test state */
+   simnet_segmentt  *segment;
+   int              number;
+   int              slaves;
+   int              bytes;
+   int              found;
+   int              baddata;
+   int              badsdo;
+} mastert;
+
+static mastert *master[MAXCONTEXT];
+static int failures;
+
+static void check(boolean ok, const char *what)
+{
+   if (!ok)
+   {
+      printf("  FAIL: %s\n", what);
+      failures++;
+   }
+}
+
+static mastert *master_create(int number)
+{
+   mastert *m;
+   char ifname[SIMNET_MAXNAME + 1];
+
+   m = (mastert *)calloc(1, sizeof(mastert));
+   if (!m)
+   {
+      return NULL;
+   }
+   m->context.port = &m->port;
+   m->context.slavelist = &m->slave[0];
+   m->context.slavecount = &m->slavecount;
+   m->context.maxslave = NEX_MAXSLAVE;
+   m->context.grouplist = &m->group[0];
+   m->context.maxgroup = NEX_MAXGROUP;
+   m->context.esibuf = &m->esibuf[0];
+   m->context.esimap = &m->esimap[0];
+   m->context.elist = &m->elist;
+   m->context.idxstack = &m->idxstack;
+   m->context.ecaterror = &m->ecaterror;
+   m->context.DCtime = &m->DCtime;
+   m->context.SMcommtype = &m->SMcommtype[0];
+   m->context.PDOassign = &m->PDOassign[0];
+   m->context.PDOdesc = &m->PDOdesc[0];
+   m->context.eepSM = &m->eepSM;
+   m->context.eepFMMU = &m->eepFMMU;
+   m->emcylist.toelist = TRUE;
+   m->context.emcylist = &m->emcylist;
+   m->number = number;
+   m->slaves = 2 + number;
+   m->bytes = 4 * number;
+   snprintf(ifname, sizeof(ifname), "simnet%d", number);
+   m->segment = simnet_create(ifname, m->slaves);
+   if (!m->segment)
+   {
+      free(m);
+      return NULL;
+   }
+   return m;
+}
+
+/* SDO server of the first slave of a segment, the segment number in SEGINDEX */
+static void sdoslave(simnet_slavet *slave, const uint8 *in, uint8 *out, boolean *respond)
+{
+   int k;
+
+   if (((in[5] & 0x0f) != ECT_MBXT_COE) || ((in[7] >> 4) != ECT_COES_SDOREQ) || (in[8] != ECT_SDO_UP_REQ))
+   {
+      return;
+   }
+   memset(out, 0, 16);
+   out[0] = 10;
+   out[5] = in[5];                     /* type and counter */
+   out[7] = ECT_COES_SDORES << 4;
+   out[8] = 0x4f;                      /* expedited upload of 1 byte */
+   memcpy(out + 9, in + 9, 3);
+   for (k = 0; k < MAXCONTEXT; k++)
+   {
+      if (master[k] && (master[k]->segment->slave == slave))
+      {
+         out[12] = (uint8)master[k]->number;
+      }
+   }
+   *respond = TRUE;
+}
+
+/* set the process data of a slave as if it had been read from its PDO objects */
+static void setslave(nex_slavet *s, int bytes)
+{
+   s->configindex = 1;
+   s->Obits = (uint16)(bytes * 8);
+   s->Ibits = (uint16)(bytes * 8);
+   s->Obytes = (uint32)bytes;
+   s->Ibytes = (uint32)bytes;
+   s->SM[2].StartAddr = htoes(OUTADR);
+   s->SM[2].SMlength = htoes((uint16)bytes);
+   s->SMtype[2] = 3;
+   s->SM[3].StartAddr = htoes(INADR);
+   s->SM[3].SMlength = htoes((uint16)bytes);
+   s->SMtype[3] = 4;
+}
+
+/* configuration and cycles of one context, the process data carries the segment and cycle number */
+static void *master_thread(void *param)
+{
+   mastert *m = (mastert *)param;
+   nexx_contextt *c = &m->context;
+   simnet_slavet *sim = m->segment->slave;
+   nex_slavet *s;
+   uint8 value;
+   int cyc, k, wkc, expected, size;
+
+   if (nexx_init(c, m->segment->ifname) <= 0)
+   {
+      return NULL;
+   }
+   m->found = nexx_config_init(c);
+   nexx_statecheck(c, 0, NEX_STATE_PRE_OP, NEX_TIMEOUTSTATE);
+   for (k = 1; k <= m->slavecount; k++)
+   {
+      setslave(&m->slave[k], m->bytes);
+   }
+   nexx_config_map_group(c, m->IOmap, 0);
+   expected = (m->group[0].outputsWKC * 2) + m->group[0].inputsWKC;
+   for (cyc = 0; cyc < CYCLES; cyc++)
+   {
+      for (k = 1; k <= m->slavecount; k++)
+      {
+         s = &m->slave[k];
+         memset(s->outputs, (uint8)((m->number << 4) + cyc + k), s->Obytes);
+         memset(sim[k - 1].mem + INADR, (uint8)((m->number << 4) + (cyc * 3) + k), s->Ibytes);
+      }
+      nexx_send_processdata(c);
+      wkc = nexx_receive_processdata(c, NEX_TIMEOUTRET);
+      m->baddata += (wkc != expected);
+      for (k = 1; k <= m->slavecount; k++)
+      {
+         s = &m->slave[k];
+         m->baddata += (sim[k - 1].mem[OUTADR + s->Obytes - 1] != (uint8)((m->number << 4) + cyc + k)) ||
+                       (s->inputs[s->Ibytes - 1] != (uint8)((m->number << 4) + (cyc * 3) + k));
+      }
+      if (!(cyc % 100))
+      {
+         value = 0;
+         size = sizeof(value);
+         wkc = nexx_SDOread(c, 1, SEGINDEX, 0, FALSE, &size, &value, NEX_TIMEOUTRXM);
+         m->badsdo += (wkc <= 0) || (value != (uint8)m->number);
+      }
+   }
+   nexx_close(c);
+   return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+   pthread_t thread[MAXCONTEXT];
+   int n, i, created;
+   uint32 frames;
+
+   printf("SOEM (Simple Open EtherCAT Master)\nParallel context test on simulated segments\n");
+
+   n = (argc > 1) ? atoi(argv[1]) : 4;
+   if ((n < 1) || (n > MAXCONTEXT))
+   {
+      printf("Contexts must be 1 to %d\n", MAXCONTEXT);
+      return 1;
+   }
+   created = 0;
+   for (i = 0; i < n; i++)
+   {
+      master[i] = master_create(i + 1);
+      if (!master[i])
+      {
+         break;
+      }
+      simnetx_init(master[i]->segment, master[i]->slaves);
+      simnetx_mailbox(master[i]->segment, 0, ECT_MBXPROT_COE, sdoslave);
+      created++;
+   }
+   check(created == n, "segments created");
+   check(!simnet_create("simnet1", 1), "segment name used once");
+   check(!simnet_create("simnet", 1), "name of the default segment in use");
+   frames = simnet_frames;
+   for (i = 0; i < created; i++)
+   {
+      pthread_create(&thread[i], NULL, master_thread, master[i]);
+   }
+   for (i = 0; i < created; i++)
+   {
+      pthread_join(thread[i], NULL);
+   }
+   printf("context  slaves  bytes  frames\n");
+   for (i = 0; i < created; i++)
+   {
+      printf("%7d  %6d  %5d  %6u\n", master[i]->number, master[i]->found, master[i]->bytes,
+         *master[i]->segment->frames);
+   }
+   for (i = 0; i < created; i++)
+   {
+      check(master[i]->found == master[i]->slaves, "context found the slaves of its segment");
+      check(!master[i]->baddata, "context exchanged the process data of its segment");
+      check(!master[i]->badsdo, "context read the number of its segment");
+      check(*master[i]->segment->frames >= CYCLES, "frames counted by the segment of the context");
+   }
+   check(simnet_frames == frames, "no frames on the default segment");
+
+   printf("%s\n", failures ? "FAIL" : "OK");
+   return failures ? 1 : 0;
+}
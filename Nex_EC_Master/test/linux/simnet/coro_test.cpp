@@ -0,0 +1,169 @@
+/** \file
+ * \brief Coroutine scheduler test on a simulated segment
+ *
+ * Usage : coro_test
+ *
+ * Runs the setup sequence documented in ethercatcoro.hpp on all slaves of a
+ * simulated segment at once with one nex::co::Scheduler. The simulated slaves
+ * answer expedited SDO downloads and log every write, the writes of each slave
+ * must arrive in the order of its sequence and all slaves must reach SAFE_OP.
+ * The sequences of all slaves share their frames. A slave that answers with a
+ * CoE emergency instead of an SDO response must fail its transfer and leave
+ * the emergency in its queue.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ethercatcoro.hpp"
+#include "simnet.h"
+
+/** slaves in the segment */
+#define SLAVES   32
+/** SDO writes logged per slave */
+#define MAXLOG   8
+/** index that is answered with an emergency */
+#define EMCYINDEX 0x1c13
+#define EMCYCODE  0x8210
+
+/** one logged SDO write */
+typedef struct
+{
+   uint16 index;
+   uint8  subindex;
+   uint32 value;
+} sdologt;
+
+static sdologt sdolog[SLAVES][MAXLOG];
+static int nsdolog[SLAVES];
+static bool setupok[SLAVES + 1];
+static int failures;
+
+static void check(bool ok, const char *what)
+{
+   if (!ok)
+   {
+      printf("  FAIL: %s\n", what);
+      failures++;
+   }
+}
+
+/* CoE application of a simulated slave, expedited downloads are logged */
+static void sdoslave(simnet_slavet *slave, const uint8 *in, uint8 *out, boolean *respond)
+{
+   uint16 index = (uint16)(in[9] | (in[10] << 8));
+   uint8 subindex = in[11];
+   sdologt *l;
+
+   if (((in[5] & 0x0f) != ECT_MBXT_COE) || ((in[7] >> 4) != ECT_COES_SDOREQ) || (in[8] & 0xe0) != 0x20)
+   {
+      return;
+   }
+   memset(out, 0, 16);
+   out[0] = 10;                        /* mailbox length */
+   out[5] = in[5];                     /* type and counter */
+   if (index == EMCYINDEX)
+   {
+      out[7] = ECT_COES_EMERGENCY << 4;
+      out[8] = EMCYCODE & 0xff;
+      out[9] = EMCYCODE >> 8;
+      out[10] = 0x01;                  /* error register */
+   }
+   else
+   {
+      out[7] = ECT_COES_SDORES << 4;
+      out[8] = 0x60;                   /* download response */
+      memcpy(out + 9, in + 9, 3);
+      if (nsdolog[slave->position] < MAXLOG)
+      {
+         l = &sdolog[slave->position][nsdolog[slave->position]++];
+         l->index = index;
+         l->subindex = subindex;
+         l->value = (uint32)in[12] | ((uint32)in[13] << 8) | ((uint32)in[14] << 16) | ((uint32)in[15] << 24);
+      }
+   }
+   *respond = TRUE;
+}
+
+/* setup sequence from ethercatcoro.hpp */
+static nex::co::task<void> setup(nex::co::Scheduler &s, uint16 slave)
+{
+   bool ok = true;
+
+   ok = ok && (bool)co_await s.sdo_write<uint8>(slave, 0x1c12, 0, 0);
+   ok = ok && (bool)co_await s.sdo_write<uint16>(slave, 0x1c12, 1, 0x1600);
+   ok = ok && (bool)co_await s.sdo_write<uint8>(slave, 0x1c12, 0, 1);
+   ok = ok && (bool)co_await s.state(slave, NEX_STATE_SAFE_OP);
+   setupok[slave] = ok;
+}
+
+static nex::co::task<void> emcy(nex::co::Scheduler &s, uint16 slave, bool *failed)
+{
+   nex::result<void> r = co_await s.sdo_write<uint8>(slave, EMCYINDEX, 0, 0, false, 20000);
+
+   *failed = !r;
+}
+
+static bool logged(int position, int n, uint16 index, uint8 subindex, uint32 value)
+{
+   const sdologt *l = &sdolog[position][n];
+
+   return (n < nsdolog[position]) && (l->index == index) && (l->subindex == subindex) && (l->value == value);
+}
+
+int main(void)
+{
+   nex_emcyentryt em;
+   uint32 frames;
+   bool inorder = true, safeop = true, allok = true, failed = false;
+   int k;
+
+   printf("SOEM (Simple Open EtherCAT Master)\nCoroutine scheduler test on a simulated segment\n");
+
+   if (!nex_init("simnet"))
+   {
+      printf("No socket connection\n");
+      return 1;
+   }
+   simnet_init(SLAVES);
+   for (k = 0; k < SLAVES; k++)
+   {
+      simnet_mailbox(k, ECT_MBXPROT_COE, sdoslave);
+   }
+   check(nex_config_init() == SLAVES, "slaves found");
+   check(nex_statecheck(0, NEX_STATE_PRE_OP, NEX_TIMEOUTSTATE) == NEX_STATE_PRE_OP, "slaves in PRE_OP");
+
+   nex::co::Scheduler s(&nexx_context);
+   frames = simnet_frames;
+   for (k = 1; k <= SLAVES; k++)
+   {
+      s.spawn(setup(s, (uint16)k));
+   }
+   check(s.run(5000000), "all setup tasks completed");
+   frames = simnet_frames - frames;
+   for (k = 1; k <= SLAVES; k++)
+   {
+      allok = allok && setupok[k];
+      inorder = inorder && (nsdolog[k - 1] == 3) && logged(k - 1, 0, 0x1c12, 0, 0) &&
+                logged(k - 1, 1, 0x1c12, 1, 0x1600) && logged(k - 1, 2, 0x1c12, 0, 1);
+      safeop = safeop && ((nex_slave[k].state & 0x0f) == NEX_STATE_SAFE_OP);
+   }
+   printf("%d slaves set up with %u frames\n", SLAVES, frames);
+   check(allok, "every sequence succeeded");
+   check(inorder, "SDO writes in order of the sequence");
+   check(safeop, "all slaves in SAFE_OP");
+   /* three SDO transfers and a state change each would take hundreds of frames one slave at a time */
+   check(frames < (uint32)(SLAVES * 6), "sequences share frames");
+
+   while (nex_emcy_pop(2, &em))
+   {
+   }
+   s.spawn(emcy(s, 2, &failed));
+   check(s.run(1000000), "emergency task completed");
+   check(failed, "transfer answered by emergency fails");
+   check(nex_emcy_pop(2, &em) && (em.ErrorCode == EMCYCODE) && (em.ErrorReg == 0x01), "emergency queued");
+   nex_close();
+
+   printf("%s\n", failures ? "FAIL" : "OK");
+   return failures ? 1 : 0;
+}
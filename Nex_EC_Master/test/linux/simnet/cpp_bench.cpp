@@ -0,0 +1,236 @@
+/** \file
+ * \brief C++ layer benchmark on a simulated segment
+ *
+ * Usage : cpp_bench [cycles]
+ * cycles measured per path, default 10000
+ *
+ * Maps the same simulated segment once with nex_config_map_group on the
+ * global context and once with nex::Master::config_map on a master of its
+ * own, for one and for several segments. Both must give the same IOmap size,
+ * the same offsets of every slave in the IOmap and the same working counter,
+ * and the outputs and inputs must arrive. nex_send_processdata and
+ * nex_receive_processdata are timed next to nex::Group::send and receive like
+ * in pdpath_bench: the send with frames that are lost before the simulated
+ * slaves, the receive after the frames have returned. The best of several
+ * blocks is reported.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ethercat.hpp"
+#include "simnet.h"
+
+/** start of outputs and inputs in the ESC memory of the simulated slaves */
+#define OUTADR   0x1400
+#define INADR    0x1C00
+/** cycles timed together */
+#define BLOCK    1000
+#define MAXSLAVES 64
+
+static uint8 IOmapC[16 * 1024];
+static uint8 IOmapX[16 * 1024];
+static int failures;
+
+static void check(bool ok, const char *what)
+{
+   if (!ok)
+   {
+      printf("  FAIL: %s\n", what);
+      failures++;
+   }
+}
+
+static double now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (ts.tv_sec * 1e9) + ts.tv_nsec;
+}
+
+/* set the process data of a slave as if it had been read from its PDO objects */
+static void setslave(nex_slavet *s, int bytes)
+{
+   s->configindex = 1;
+   s->Obits = (uint16)(bytes * 8);
+   s->Ibits = (uint16)(bytes * 8);
+   s->Obytes = (uint32)bytes;
+   s->Ibytes = (uint32)bytes;
+   s->SM[2].StartAddr = htoes(OUTADR);
+   s->SM[2].SMlength = htoes((uint16)bytes);
+   s->SMtype[2] = 3;
+   s->SM[3].StartAddr = htoes(INADR);
+   s->SM[3].SMlength = htoes((uint16)bytes);
+   s->SMtype[3] = 4;
+}
+
+/* every slave gets the cycle number in its outputs and inputs */
+static void setdata(nex_slavet *slave, int slaves, int cyc)
+{
+   int k;
+
+   for (k = 1; k <= slaves; k++)
+   {
+      memset(slave[k].outputs, (uint8)(cyc + k), slave[k].Obytes);
+      memset(simnet_slave[k - 1].mem + INADR, (uint8)(cyc * 3 + k), slave[k].Ibytes);
+   }
+}
+
+/* TRUE if the outputs and inputs of every slave carry the cycle number */
+static bool gotdata(nex_slavet *slave, int slaves, int cyc)
+{
+   int k;
+   bool ok = true;
+
+   for (k = 1; k <= slaves; k++)
+   {
+      ok = ok && (simnet_slave[k - 1].mem[OUTADR + slave[k].Obytes - 1] == (uint8)(cyc + k)) &&
+           (slave[k].inputs[slave[k].Ibytes - 1] == (uint8)(cyc * 3 + k));
+   }
+   return ok;
+}
+
+/* ns per cycle of send and receive of BLOCK cycles, C path without group */
+static bool block(nex_slavet *slave, int slaves, nex::Group *g, int wkc, double *tx, double *rx)
+{
+   double ttx = 0, trx = 0, t0;
+   bool ok = true;
+   int c;
+
+   /* send without the simulated slaves, the frames are lost before them */
+   for (c = 0; c < BLOCK; c++)
+   {
+      simnet_dropbefore = 1000;
+      t0 = now();
+      if (g)
+      {
+         g->send();
+      }
+      else
+      {
+         nex_send_processdata();
+      }
+      ttx += now() - t0;
+      if (g)
+      {
+         g->receive(0);
+      }
+      else
+      {
+         nex_receive_processdata(0);
+      }
+   }
+   simnet_dropbefore = 0;
+   /* receive of frames that have returned */
+   for (c = 0; c < BLOCK; c++)
+   {
+      setdata(slave, slaves, c);
+      if (g)
+      {
+         g->send();
+         t0 = now();
+         ok = (g->receive() == wkc) && ok;
+      }
+      else
+      {
+         nex_send_processdata();
+         t0 = now();
+         ok = (nex_receive_processdata(NEX_TIMEOUTRET) == wkc) && ok;
+      }
+      trx += now() - t0;
+      ok = gotdata(slave, slaves, c) && ok;
+   }
+   *tx = ttx / BLOCK;
+   *rx = trx / BLOCK;
+   return ok;
+}
+
+static void best(double *v, double t)
+{
+   if (t < *v)
+   {
+      *v = t;
+   }
+}
+
+/* the paths take turns block by block and the best block of each counts, so
+   that other load of the host is left out */
+static void bench(int slaves, int bytes, int cycles)
+{
+   double ctx = 1e12, crx = 1e12, xtx = 1e12, xrx = 1e12, tx, rx;
+   bool cok = true, xok = true, same = true;
+   int k, b, size, wkc;
+
+   /* C path on the global context */
+   simnet_init(slaves);
+   check(nex_config_init() == slaves, "slaves found by the C path");
+   for (k = 1; k <= slaves; k++)
+   {
+      setslave(&nex_slave[k], bytes);
+   }
+   size = nex_config_map_group(IOmapC, 0);
+   wkc = (nex_group[0].outputsWKC * 2) + nex_group[0].inputsWKC;
+
+   /* the same slaves with a master of its own, they keep the same FMMUs */
+   nex::result<nex::Port> port = nex::Port::open("simnet");
+   if (!port)
+   {
+      check(false, "port of the master opened");
+      return;
+   }
+   nex::Master m(std::move(*port));
+   check(m.config_init().value_or(0) == slaves, "slaves found by the master");
+   for (k = 1; k <= slaves; k++)
+   {
+      setslave(&m.slave((uint16)k), bytes);
+   }
+   check(m.config_map(nex::span<uint8>(IOmapX, sizeof(IOmapX))).value_or(-1) == size, "same IOmap size");
+   for (k = 1; k <= slaves; k++)
+   {
+      same = same && ((m.slave((uint16)k).outputs - IOmapX) == (nex_slave[k].outputs - IOmapC)) &&
+             ((m.slave((uint16)k).inputs - IOmapX) == (nex_slave[k].inputs - IOmapC));
+   }
+   check(same, "same offsets of all slaves");
+   nex::Group g = m.group(0);
+   check(g.expected_wkc() == wkc, "same working counter");
+
+   for (b = 0; b < (cycles + BLOCK - 1) / BLOCK; b++)
+   {
+      cok = block(nex_slave, slaves, nullptr, wkc, &tx, &rx) && cok;
+      best(&ctx, tx);
+      best(&crx, rx);
+      xok = block(&m.slave(0), slaves, &g, wkc, &tx, &rx) && xok;
+      best(&xtx, tx);
+      best(&xrx, rx);
+   }
+   check(cok, "C path exchanged process data");
+   check(xok, "master exchanged process data");
+   printf("%2d x %4d  %d  %6d  %8.0f %8.0f  %8.0f %8.0f\n", slaves, bytes, nex_group[0].nsegments, size,
+      ctx, xtx, crx, xrx);
+}
+
+int main(int argc, char *argv[])
+{
+   int cycles = (argc > 1) ? atoi(argv[1]) : 10000;
+
+   printf("SOEM (Simple Open EtherCAT Master)\nC++ layer benchmark on a simulated segment\n");
+
+   cycles = (cycles < BLOCK) ? BLOCK : cycles;
+   if (!nex_init("simnet"))
+   {
+      printf("No socket connection\n");
+      return 1;
+   }
+   printf("                         tx ns per cycle    rx ns per cycle\n");
+   printf("slaves    seg  IOmap          C      C++         C      C++\n");
+   bench(8, 16, cycles);
+   bench(MAXSLAVES, 16, cycles);
+   bench(MAXSLAVES, 64, cycles);
+   nex_close();
+
+   printf("%s\n", failures ? "FAIL" : "OK");
+   return failures ? 1 : 0;
+}
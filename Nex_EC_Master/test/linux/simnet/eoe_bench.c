@@ -0,0 +1,155 @@
+/** \file
+ * \brief EoE engine benchmark on a simulated segment
+ *
+ * Usage : eoe_bench
+ *
+ * Every simulated slave has an EoE mailbox that echoes each fragment it gets.
+ * The EoE engine sends frames to all slaves at once and every echoed frame is
+ * checked against the frame that was sent. The run is done twice, once with a
+ * fragment budget that services one slave per round, the way the engine did
+ * before the mailboxes were packed, and once with all slaves in each round.
+ * EtherCAT frames per EoE frame, throughput and latencies are reported.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ethercat.h"
+#include "simnet.h"
+
+/** EoE slaves */
+#define SLAVES   8
+/** frames sent to every slave per run */
+#define FRAMES   200
+/** size of an EoE frame, a full Ethernet frame takes four fragments */
+#define FSIZE    1514
+
+static nex_EOEenginet engine;
+static int rxcount[SLAVES + 1];
+static int failures;
+
+static void check(boolean ok, const char *what)
+{
+   if (!ok)
+   {
+      printf("  FAIL: %s\n", what);
+      failures++;
+   }
+}
+
+/* frame number seq of a slave, every frame has a pattern of its own */
+static void makeframe(uint8 *frame, uint16 slave, int seq)
+{
+   int i;
+
+   for (i = 0; i < FSIZE; i++)
+   {
+      frame[i] = (uint8)((slave * 31) + (seq * 7) + i);
+   }
+}
+
+/* EoE slave application, a fragment is echoed back unchanged */
+static void echo(simnet_slavet *slave, const uint8 *in, uint8 *out, boolean *respond)
+{
+   (void)slave;                 /* Not used */
+   memcpy(out, in, SIMNET_MBXSIZE);
+   *respond = TRUE;
+}
+
+static int rxhook(uint16 slave, uint8 port, void *frame, int size)
+{
+   uint8 expect[FSIZE];
+
+   (void)port;                  /* Not used */
+   if ((slave < 1) || (slave > SLAVES))
+   {
+      failures++;
+      return 0;
+   }
+   makeframe(expect, slave, rxcount[slave]++);
+   if ((size != FSIZE) || memcmp(frame, expect, FSIZE))
+   {
+      printf("  frame %d of slave %d wrong, size %d\n", rxcount[slave] - 1, slave, size);
+      failures++;
+   }
+
+   return 1;
+}
+
+/* send FRAMES frames to every slave and wait for all echoes */
+static void run(int maxfragments)
+{
+   uint8 frame[FSIZE];
+   int txcount[SLAVES + 1];
+   int k, done, polls;
+   uint32 frames;
+   nex_timet start, end, diff;
+   double us;
+
+   nex_EOEengine_init(&engine, rxhook);
+   memset(txcount, 0, sizeof(txcount));
+   memset(rxcount, 0, sizeof(rxcount));
+   frames = simnet_frames;
+   polls = 0;
+   start = osal_current_time();
+   do
+   {
+      done = 0;
+      for (k = 1; k <= SLAVES; k++)
+      {
+         if (txcount[k] < FRAMES)
+         {
+            makeframe(frame, (uint16)k, txcount[k]);
+            if (nexx_EOEengine_queue(&engine, (uint16)k, 0, FSIZE, frame) == 1)
+            {
+               txcount[k]++;
+            }
+         }
+         if (rxcount[k] >= FRAMES)
+         {
+            done++;
+         }
+      }
+      nex_EOEengine_poll(&engine, 1000, maxfragments);
+   } while ((done < SLAVES) && (++polls < 100 * FRAMES * SLAVES));
+   end = osal_current_time();
+   osal_time_diff(&start, &end, &diff);
+   us = (diff.sec * 1000000.0) + diff.usec;
+   frames = simnet_frames - frames;
+   check(done == SLAVES, "all frames echoed");
+   check(engine.stat.rxerrors == 0, "no fragment out of sequence");
+   check(engine.stat.rxframes == (uint32)(FRAMES * SLAVES), "every frame received once");
+   printf("%2d fragments per poll: %u EtherCAT frames, %.2f per EoE frame, %.1f Mbit/s,"
+          " latency tx %u/%u rx %u/%u us avg/max\n",
+          maxfragments, frames, (double)frames / (FRAMES * SLAVES),
+          (us > 0) ? (2.0 * 8 * FSIZE * FRAMES * SLAVES) / us : 0.0,
+          engine.stat.txlatency_sum / engine.stat.txframes, engine.stat.txlatency_max,
+          engine.stat.rxlatency_sum / engine.stat.rxframes, engine.stat.rxlatency_max);
+}
+
+int main(void)
+{
+   int k;
+
+   printf("SOEM (Simple Open EtherCAT Master)\nEoE engine benchmark on a simulated segment\n");
+
+   if (!nex_init("simnet"))
+   {
+      printf("No socket connection\n");
+      return 1;
+   }
+   simnet_init(SLAVES);
+   for (k = 0; k < SLAVES; k++)
+   {
+      simnet_mailbox(k, ECT_MBXPROT_EOE, echo);
+   }
+   check(nex_config_init() == SLAVES, "slaves found");
+   check(nex_statecheck(0, NEX_STATE_PRE_OP, NEX_TIMEOUTSTATE) == NEX_STATE_PRE_OP, "slaves in PRE_OP");
+   run(2);
+   check(engine.nslot == SLAVES, "a slot for every slave");
+   run(2 * SLAVES);
+   nex_close();
+
+   printf("%s\n", failures ? "FAIL" : "OK");
+   return failures ? 1 : 0;
+}
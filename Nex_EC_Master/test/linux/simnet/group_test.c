@@ -0,0 +1,212 @@
+/** \file
+ * \brief Group index partition test on a simulated segment
+ *
+ * Usage : group_test
+ *
+ * Maps two groups and gives each a range of frame indexes with
+ * nex_config_groupindex. Ranges that overlap, leave the port without a shared
+ * index or do not fit are refused and the group keeps its range. The cycles
+ * of both groups then run in threads of their own on the same port while the
+ * main thread reads registers and takes shared indexes, every group must get
+ * its outputs and inputs and no shared index may be one of a range. With all
+ * shared indexes busy and a range index in flight nex_getindex must still
+ * stay out of the ranges. Re-init returns the ranges.
+ *
+ * Group 0 maps all slaves, groups 1 and 2 need NEX_MAXGROUP of 3 or more,
+ * see CMakeLists.txt.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "ethercat.h"
+#include "simnet.h"
+
+/** start of outputs and inputs in the ESC memory of the simulated slaves */
+#define OUTADR   0x1400
+#define INADR    0x1C00
+/** slaves, the first half in group 1, the others in group 2 */
+#define SLAVES   8
+/** process data bytes per slave of group 1 and 2, group 2 needs several frames */
+#define BYTES1   32
+#define BYTES2   400
+#define CYCLES   2000
+/** index ranges of group 1 and 2 */
+#define FIRST1   1
+#define COUNT1   3
+#define FIRST2   4
+#define COUNT2   4
+
+static uint8 IOmap1[4 * 1024];
+static uint8 IOmap2[4 * 1024];
+/** group threads done */
+static int finished;
+static int failures;
+
+static void check(boolean ok, const char *what)
+{
+   if (!ok)
+   {
+      printf("  FAIL: %s\n", what);
+      failures++;
+   }
+}
+
+/* set the process data of a slave as if it had been read from its PDO objects */
+static void setslave(int k, uint8 group, int bytes)
+{
+   nex_slavet *s = &nex_slave[k];
+
+   s->group = group;
+   s->configindex = 1;
+   s->Obits = (uint16)(bytes * 8);
+   s->Ibits = (uint16)(bytes * 8);
+   s->Obytes = (uint32)bytes;
+   s->Ibytes = (uint32)bytes;
+   s->SM[2].StartAddr = htoes(OUTADR);
+   s->SM[2].SMlength = htoes((uint16)bytes);
+   s->SMtype[2] = 3;
+   s->SM[3].StartAddr = htoes(INADR);
+   s->SM[3].SMlength = htoes((uint16)bytes);
+   s->SMtype[3] = 4;
+}
+
+static boolean inrange(int idx)
+{
+   return ((idx >= FIRST1) && (idx < (FIRST1 + COUNT1))) || ((idx >= FIRST2) && (idx < (FIRST2 + COUNT2)));
+}
+
+static boolean ranges(void)
+{
+   int idx;
+   boolean ok = TRUE;
+
+   for (idx = 0; idx < NEX_MAXBUF; idx++)
+   {
+      ok = ok && ((nexx_port.idxreserved[idx] != 0) == inrange(idx));
+   }
+   return ok;
+}
+
+/* cycles of one group, the process data of every slave carries the cycle number */
+static void *groupcycle(void *param)
+{
+   uint8 group = (uint8)(size_t)param;
+   nex_groupt *grp = &nex_group[group];
+   nex_slavet *s;
+   int cyc, k, wkc, bad = 0;
+
+   for (cyc = 0; cyc < CYCLES; cyc++)
+   {
+      for (k = 1; k <= nex_slavecount; k++)
+      {
+         s = &nex_slave[k];
+         if (s->group == group)
+         {
+            memset(s->outputs, (uint8)(cyc + k), s->Obytes);
+            memset(simnet_slave[k - 1].mem + INADR, (uint8)(cyc * 3 + k), s->Ibytes);
+         }
+      }
+      nex_send_processdata_group(group);
+      wkc = nex_receive_processdata_group(group, NEX_TIMEOUTRET);
+      if (wkc != ((grp->outputsWKC * 2) + grp->inputsWKC))
+      {
+         bad++;
+         continue;
+      }
+      for (k = 1; k <= nex_slavecount; k++)
+      {
+         s = &nex_slave[k];
+         if ((s->group == group) &&
+             ((simnet_slave[k - 1].mem[OUTADR + s->Obytes - 1] != (uint8)(cyc + k)) ||
+              (s->inputs[s->Ibytes - 1] != (uint8)(cyc * 3 + k))))
+         {
+            bad++;
+         }
+      }
+   }
+   __atomic_fetch_add(&finished, 1, __ATOMIC_RELEASE);
+   return (void *)(size_t)bad;
+}
+
+int main(void)
+{
+   pthread_t thread1, thread2;
+   void *bad1, *bad2;
+   uint16 alstat;
+   int k, idx, n, shared, inside, wkcerrors;
+   boolean keep;
+
+   printf("SOEM (Simple Open EtherCAT Master)\nGroup index partition test on a simulated segment\n");
+
+   if (!nex_init("simnet"))
+   {
+      printf("No socket connection\n");
+      return 1;
+   }
+   simnet_init(SLAVES);
+   check(nex_config_init() == SLAVES, "slaves found");
+   for (k = 1; k <= SLAVES; k++)
+   {
+      setslave(k, (k <= (SLAVES / 2)) ? 1 : 2, (k <= (SLAVES / 2)) ? BYTES1 : BYTES2);
+   }
+   check(nex_config_map_group(IOmap1, 1) > 0, "group 1 mapped");
+   check(nex_config_map_group(IOmap2, 2) > 0, "group 2 mapped");
+   check(nex_group[2].nsegments > 1, "group 2 needs more than one frame");
+
+   check(nex_config_groupindex(1, FIRST1, COUNT1) == 1, "range of group 1");
+   check(nex_config_groupindex(2, FIRST1 + 2, COUNT2) == 0, "overlapping range refused");
+   check(nex_config_groupindex(2, FIRST2, NEX_MAXBUF - COUNT1) == 0, "range without shared index refused");
+   check(nex_config_groupindex(1, NEX_MAXBUF - 1, COUNT1) == 0, "range out of the buffers refused");
+   keep = (nex_group[1].idxfirst == FIRST1) && (nex_group[1].idxcount == COUNT1);
+   check(keep, "refused call keeps the range");
+   check(nex_config_groupindex(2, FIRST2, COUNT2) == 1, "range of group 2");
+   check(ranges(), "ranges reserved in the port");
+
+   /* both groups cycle in threads of their own, shared traffic meanwhile */
+   pthread_create(&thread1, NULL, groupcycle, (void *)(size_t)1);
+   pthread_create(&thread2, NULL, groupcycle, (void *)(size_t)2);
+   shared = inside = wkcerrors = 0;
+   while (__atomic_load_n(&finished, __ATOMIC_ACQUIRE) < 2)
+   {
+      idx = nex_getindex();
+      inside += inrange(idx);
+      nex_setbufstat(idx, NEX_BUF_EMPTY);
+      if (!(shared % 100))
+      {
+         wkcerrors += (nex_FPRD(nex_slave[1 + (shared / 100) % SLAVES].configadr, ECT_REG_ALSTAT, sizeof(alstat),
+                                &alstat, NEX_TIMEOUTRET) != 1);
+      }
+      shared++;
+   }
+   pthread_join(thread1, &bad1);
+   pthread_join(thread2, &bad2);
+   printf("%d cycles per group, %d shared indexes taken\n", CYCLES, shared);
+   check(!bad1, "group 1 exchanged process data in its thread");
+   check(!bad2, "group 2 exchanged process data in its thread");
+   check(!inside, "shared indexes outside the ranges");
+   check(!wkcerrors, "register reads beside the cycles");
+
+   /* a range index in flight and all shared indexes busy */
+   nex_setbufstat(FIRST2 + 1, NEX_BUF_TX);
+   inside = 0;
+   for (n = 0; n < (2 * NEX_MAXBUF); n++)
+   {
+      inside += inrange(nex_getindex());
+   }
+   check(!inside, "busy shared indexes are reused, range indexes are not");
+   for (idx = 0; idx < NEX_MAXBUF; idx++)
+   {
+      nex_setbufstat(idx, NEX_BUF_EMPTY);
+   }
+
+   check(nex_config_groupindex(1, 0, 0) && !nexx_port.idxreserved[FIRST1] && !nex_group[1].idxcount,
+         "range of group 1 returned");
+   nex_config_init();
+   check(!nexx_port.idxreserved[FIRST2] && !nex_group[2].idxcount, "re-init returns the ranges");
+   nex_close();
+
+   printf("%s\n", failures ? "FAIL" : "OK");
+   return failures ? 1 : 0;
+}
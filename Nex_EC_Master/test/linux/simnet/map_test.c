@@ -0,0 +1,303 @@
+/** \file
+ * \brief Mapping test on a simulated segment
+ *
+ * Usage : map_test
+ *
+ * Maps groups with slaves that have blockLRW set next to slaves that do not,
+ * with nex_config_map_group and nex_config_overlap_map_group, and checks the
+ * IO segments and their commands. A few cycles are run to check that outputs
+ * and inputs arrive and that no LRW reaches a blocked slave. Groups that need
+ * more IO segments than there are must fail to map with an error.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ethercat.h"
+#include "simnet.h"
+
+/** start of outputs and inputs in the ESC memory of the simulated slaves */
+#define OUTADR   0x1400
+#define INADR    0x1800
+
+static uint8 IOmap[128 * 1024];
+static int failures;
+
+static void check(boolean ok, const char *what)
+{
+   if (!ok)
+   {
+      printf("  FAIL: %s\n", what);
+      failures++;
+   }
+}
+
+static int getbit(const uint8 *p, int startbit, int k)
+{
+   int b = startbit + k;
+
+   return (p[b / 8] >> (b & 7)) & 1;
+}
+
+static void setbit(uint8 *p, int startbit, int k, int v)
+{
+   int b = startbit + k;
+
+   if (v)
+   {
+      p[b / 8] |= (uint8)(1 << (b & 7));
+   }
+   else
+   {
+      p[b / 8] &= (uint8)~(1 << (b & 7));
+   }
+}
+
+/* set the process data of a slave as if it had been read from its PDO objects */
+static void setslave(int k, int obits, int ibits, boolean block)
+{
+   nex_slavet *s = &nex_slave[k];
+
+   s->configindex = 1;
+   s->Obits = (uint16)obits;
+   s->Ibits = (uint16)ibits;
+   s->Obytes = (obits > 7) ? (uint32)((obits + 7) / 8) : 0;
+   s->Ibytes = (ibits > 7) ? (uint32)((ibits + 7) / 8) : 0;
+   s->SM[2].StartAddr = htoes(OUTADR);
+   s->SM[2].SMlength = htoes((uint16)((obits + 7) / 8));
+   s->SMtype[2] = obits ? 3 : 0;
+   s->SM[3].StartAddr = htoes(INADR);
+   s->SM[3].SMlength = htoes((uint16)((ibits + 7) / 8));
+   s->SMtype[3] = ibits ? 4 : 0;
+   s->blockLRW = block ? 1 : 0;
+   simnet_slave[k - 1].nolrw = block;
+}
+
+static int configure(int slavecount)
+{
+   nex_errort ec;
+
+   simnet_init(slavecount);
+   while (nex_poperror(&ec))
+   {
+   }
+   memset(IOmap, 0, sizeof(IOmap));
+   return nex_config_init();
+}
+
+/* order of the segment commands, blockLRW outputs, shared, blockLRW inputs */
+static int cmdrank(uint8 cmd, boolean overlap)
+{
+   if (cmd == NEX_CMD_LRD)
+   {
+      return 2;
+   }
+   if (cmd == NEX_CMD_LWR)
+   {
+      return overlap ? 1 : 0;
+   }
+   return overlap ? 0 : 1;
+}
+
+static void printsegments(const nex_groupt *grp)
+{
+   int i;
+
+   printf("  segments:");
+   for (i = 0; i < grp->nsegments; i++)
+   {
+      printf(" %s%d", (grp->IOsegmentcmd[i] == NEX_CMD_LWR) ? "W" :
+                      (grp->IOsegmentcmd[i] == NEX_CMD_LRD) ? "R" : "", grp->IOsegment[i]);
+   }
+   printf("\n");
+}
+
+static boolean cycle(boolean overlap, int cyc)
+{
+   nex_slavet *s;
+   int k, b, wkc, expected;
+   boolean ok = TRUE;
+
+   for (k = 1; k <= nex_slavecount; k++)
+   {
+      s = &nex_slave[k];
+      for (b = 0; b < s->Obits; b++)
+      {
+         setbit(s->outputs, s->Ostartbit, b, ((b * 7 + k + cyc) % 3) == 0);
+      }
+      for (b = 0; b < s->Ibits; b++)
+      {
+         setbit(simnet_slave[k - 1].mem + INADR, 0, b, ((b * 5 + k + cyc) % 4) == 0);
+      }
+   }
+   if (overlap)
+   {
+      nex_send_overlap_processdata();
+   }
+   else
+   {
+      nex_send_processdata();
+   }
+   wkc = nex_receive_processdata(NEX_TIMEOUTRET);
+   expected = (nex_group[0].outputsWKC * 2) + nex_group[0].inputsWKC;
+   if (wkc != expected)
+   {
+      printf("  wkc %d expected %d\n", wkc, expected);
+      ok = FALSE;
+   }
+   for (k = 1; k <= nex_slavecount; k++)
+   {
+      s = &nex_slave[k];
+      for (b = 0; b < s->Obits; b++)
+      {
+         if (getbit(simnet_slave[k - 1].mem + OUTADR, 0, b) != (((b * 7 + k + cyc) % 3) == 0))
+         {
+            printf("  outputs of slave %d wrong\n", k);
+            ok = FALSE;
+            break;
+         }
+      }
+      for (b = 0; b < s->Ibits; b++)
+      {
+         if (getbit(s->inputs, s->Istartbit, b) != (((b * 5 + k + cyc) % 4) == 0))
+         {
+            printf("  inputs of slave %d wrong\n", k);
+            ok = FALSE;
+            break;
+         }
+      }
+   }
+
+   return ok;
+}
+
+/* blockLRW slaves between slaves with bit and byte sized process data */
+static void mixedtest(boolean overlap)
+{
+   nex_groupt *grp = &nex_group[0];
+   int k, obits, ibits, size, cyc, sum, rank, lastrank;
+   boolean ordered = TRUE, fits = TRUE;
+
+   printf("mixed group, %s map\n", overlap ? "overlap" : "standard");
+   check(configure(12) == 12, "12 slaves found");
+   for (k = 1; k <= nex_slavecount; k++)
+   {
+      obits = (k % 3 == 0) ? 4 : (k % 3 == 1) ? 16 : 200 * 8;
+      ibits = (k % 4 == 0) ? 2 : (k % 4 == 1) ? 32 : 100 * 8;
+      setslave(k, (k == 5) ? 0 : obits, (k == 6) ? 0 : ibits, (k % 7) == 3);
+   }
+   size = overlap ? nex_config_overlap_map_group(IOmap, 0) : nex_config_map_group(IOmap, 0);
+   printsegments(grp);
+   check(size > 0, "group mapped");
+   check(grp->blockLRW == 0, "blockLRW slaves in segments of their own");
+   sum = 0;
+   lastrank = 0;
+   for (k = 0; k < grp->nsegments; k++)
+   {
+      sum += grp->IOsegment[k];
+      if (grp->IOsegment[k] > (NEX_MAXLRWDATA - NEX_FIRSTDCDATAGRAM))
+      {
+         fits = FALSE;
+      }
+      rank = cmdrank(grp->IOsegmentcmd[k], overlap);
+      if (rank < lastrank)
+      {
+         ordered = FALSE;
+      }
+      lastrank = rank;
+   }
+   check(fits, "segments fit in a frame");
+   check(ordered, "segment commands in order");
+   check(grp->IOsegmentcmd[0] == NEX_CMD_LWR || overlap, "first segment writes the blockLRW outputs");
+   check(grp->IOsegmentcmd[grp->nsegments - 1] == NEX_CMD_LRD, "last segment reads the blockLRW inputs");
+   /* with overlap the IOmap holds outputs and inputs of the shared segments apart */
+   check(overlap ? ((sum <= size) && (sum >= (int)grp->Obytes) && (sum >= (int)grp->Ibytes)) : (sum == size),
+         "segments cover the IOmap");
+   for (cyc = 0; cyc < 3; cyc++)
+   {
+      check(cycle(overlap, cyc), "process data exchanged");
+   }
+   check(simnet_lrwblocked == 0, "no LRW to a blockLRW slave");
+}
+
+/* more segments than the group has */
+static void overflowtest(void)
+{
+   nex_errort ec;
+   int k, size;
+   boolean found = FALSE;
+
+   printf("segments exhausted\n");
+   configure(NEX_MAXIOSEGMENTS + 16);
+   for (k = 1; k <= nex_slavecount; k++)
+   {
+      setslave(k, 1000 * 8, 0, FALSE);
+   }
+   size = nex_config_map_group(IOmap, 0);
+   check(size == 0, "map fails");
+   while (nex_poperror(&ec))
+   {
+      if ((ec.Etype == NEX_ERR_TYPE_PACKET_ERROR) && (ec.ErrorCode == 11))
+      {
+         found = TRUE;
+      }
+   }
+   check(found, "segments exhausted error");
+}
+
+/* a blockLRW slave that only fits in the last segment shared with LRW */
+static void fallbacktest(int inbytes)
+{
+   nex_errort ec;
+   int k, size;
+   boolean found = FALSE;
+
+   printf("blockLRW inputs of %d bytes after all segments\n", inbytes);
+   configure(NEX_MAXIOSEGMENTS);
+   for (k = 1; k < nex_slavecount; k++)
+   {
+      setslave(k, 1000 * 8, 0, FALSE);
+   }
+   setslave(nex_slavecount, 8 * 8, inbytes * 8, TRUE);
+   size = nex_config_map_group(IOmap, 0);
+   while (nex_poperror(&ec))
+   {
+      if ((ec.Etype == NEX_ERR_TYPE_PACKET_ERROR) && (ec.ErrorCode == 11))
+      {
+         found = TRUE;
+      }
+   }
+   if ((1000 + inbytes) <= (NEX_MAXLRWDATA - NEX_FIRSTDCDATAGRAM))
+   {
+      printsegments(&nex_group[0]);
+      check(size > 0, "group mapped");
+      check(nex_group[0].nsegments == NEX_MAXIOSEGMENTS, "all segments used");
+      check(nex_group[0].blockLRW != 0, "LRW blocked for the group");
+      check(!found, "no error");
+   }
+   else
+   {
+      check(size == 0, "map fails");
+      check(found, "segments exhausted error");
+   }
+}
+
+int main(void)
+{
+   printf("SOEM (Simple Open EtherCAT Master)\nMapping test on a simulated segment\n");
+
+   if (!nex_init("simnet"))
+   {
+      printf("No socket connection\n");
+      return 1;
+   }
+   mixedtest(FALSE);
+   mixedtest(TRUE);
+   overflowtest();
+   fallbacktest(100);
+   fallbacktest(600);
+   nex_close();
+
+   printf("%s\n", failures ? "FAIL" : "OK");
+   return failures ? 1 : 0;
+}
@@ -0,0 +1,231 @@
+/** \file
+ * \brief Process data path benchmark on a simulated segment
+ *
+ * Usage : pdpath_bench [cycles]
+ * cycles measured per path, default 10000
+ *
+ * Runs the process data of a simulated segment with the generic path and with
+ * the path selected by nex_select_processdata, for one and for several
+ * segments, with and without DC and with the standard and the overlapping
+ * IOmap. Both paths must give the same working counter and the same outputs
+ * and inputs. Groups of several segments must keep the generic path, it was
+ * faster than a specialized one that sent a frame per segment. Send and receive are timed apart: the send with frames that are
+ * lost before the simulated slaves, so the slaves are not timed, the receive
+ * after the frames have returned. Works where pd_bench has no hardware
+ * counters, f.e. in a virtual machine.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ethercat.h"
+#include "simnet.h"
+
+/** start of outputs and inputs in the ESC memory of the simulated slaves */
+#define OUTADR   0x1400
+#define INADR    0x1C00
+/** cycles timed together */
+#define BLOCK    1000
+
+static uint8 IOmap[32 * 1024];
+static int failures;
+
+static void check(boolean ok, const char *what)
+{
+   if (!ok)
+   {
+      printf("  FAIL: %s\n", what);
+      failures++;
+   }
+}
+
+static int64 now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((int64)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+/* set the process data of a slave as if it had been read from its PDO objects */
+static void setslave(int k, int obytes, int ibytes)
+{
+   nex_slavet *s = &nex_slave[k];
+
+   s->configindex = 1;
+   s->Obits = (uint16)(obytes * 8);
+   s->Ibits = (uint16)(ibytes * 8);
+   s->Obytes = (uint32)obytes;
+   s->Ibytes = (uint32)ibytes;
+   s->SM[2].StartAddr = htoes(OUTADR);
+   s->SM[2].SMlength = htoes((uint16)obytes);
+   s->SMtype[2] = 3;
+   s->SM[3].StartAddr = htoes(INADR);
+   s->SM[3].SMlength = htoes((uint16)ibytes);
+   s->SMtype[3] = 4;
+}
+
+/* one cycle, outputs and inputs carry the cycle number, send and receive timed */
+static boolean cycle(int cyc, boolean overlap, int64 *tx, int64 *rx)
+{
+   nex_slavet *s;
+   int64 t0, t1, t2;
+   int k, wkc;
+   boolean ok;
+
+   for (k = 1; k <= nex_slavecount; k++)
+   {
+      s = &nex_slave[k];
+      memset(s->outputs, (uint8)(cyc + k), s->Obytes);
+      memset(simnet_slave[k - 1].mem + INADR, (uint8)(cyc * 3 + k), s->Ibytes);
+   }
+   t0 = now();
+   if (overlap)
+   {
+      nex_send_overlap_processdata();
+   }
+   else
+   {
+      nex_send_processdata();
+   }
+   t1 = now();
+   wkc = nex_receive_processdata(NEX_TIMEOUTRET);
+   t2 = now();
+   *tx += t1 - t0;
+   *rx += t2 - t1;
+   ok = (wkc == (nex_group[0].outputsWKC * 2) + nex_group[0].inputsWKC);
+   for (k = 1; k <= nex_slavecount; k++)
+   {
+      s = &nex_slave[k];
+      ok = ok && (simnet_slave[k - 1].mem[OUTADR + s->Obytes - 1] == (uint8)(cyc + k)) &&
+           (s->inputs[s->Ibytes - 1] == (uint8)(cyc * 3 + k));
+   }
+   return ok;
+}
+
+/* ns per cycle of send and receive of BLOCK cycles of the current path */
+static boolean block(boolean overlap, double *tx, double *rx)
+{
+   int64 ttx, trx, t0;
+   boolean ok = TRUE;
+   int c;
+
+   /* send without the simulated slaves, the frames are lost before them */
+   ttx = 0;
+   for (c = 0; c < BLOCK; c++)
+   {
+      simnet_dropbefore = 1000;
+      t0 = now();
+      if (overlap)
+      {
+         nex_send_overlap_processdata();
+      }
+      else
+      {
+         nex_send_processdata();
+      }
+      ttx += now() - t0;
+      nex_receive_processdata(0);
+   }
+   simnet_dropbefore = 0;
+   t0 = 0;
+   trx = 0;
+   for (c = 0; c < BLOCK; c++)
+   {
+      ok = cycle(c, overlap, &t0, &trx) && ok;
+   }
+   *tx = (double)ttx / BLOCK;
+   *rx = (double)trx / BLOCK;
+   return ok;
+}
+
+static void best(double *v, double t)
+{
+   if (t < *v)
+   {
+      *v = t;
+   }
+}
+
+/* the paths take turns block by block and the best block of each counts, so
+   that other load of the host is left out */
+static void bench(int slaves, int bytes, boolean dc, boolean overlap, int cycles)
+{
+   double gtx, grx, stx, srx, tx, rx;
+   boolean gok = TRUE, sok = TRUE, special;
+   int k, b;
+
+   simnet_init(slaves);
+   check(nex_config_init() == slaves, "slaves found");
+   for (k = 1; k <= nex_slavecount; k++)
+   {
+      setslave(k, bytes, bytes);
+   }
+   check((overlap ? nex_config_overlap_map_group(IOmap, 0) : nex_config_map_group(IOmap, 0)) > 0, "group mapped");
+   nex_group[0].hasdc = dc;
+   nex_select_processdata(0, overlap);
+   special = (nex_group[0].pdsend && nex_group[0].pdreceive);
+   check(special == (nex_group[0].nsegments == 1), "specialized path for one segment only");
+   gtx = grx = stx = srx = 1e12;
+   for (b = 0; b < (cycles + BLOCK - 1) / BLOCK; b++)
+   {
+      /* generic path */
+      nex_select_processdata(0, overlap);
+      nex_group[0].pdsend = NULL;
+      nex_group[0].pdreceive = NULL;
+      gok = block(overlap, &tx, &rx) && gok;
+      best(&gtx, tx);
+      best(&grx, rx);
+      /* specialized path */
+      nex_select_processdata(0, overlap);
+      if (special)
+      {
+         sok = block(overlap, &tx, &rx) && sok;
+         best(&stx, tx);
+         best(&srx, rx);
+      }
+   }
+   check(gok, "generic path exchanged process data");
+   check(sok, "specialized path exchanged process data");
+   printf("%2d x %4d  %d  %-3s %-7s  %8.0f", slaves, bytes, nex_group[0].nsegments,
+      dc ? "yes" : "no", overlap ? "overlap" : "normal", gtx);
+   if (special)
+   {
+      printf(" %8.0f  %8.0f %8.0f\n", stx, grx, srx);
+   }
+   else
+   {
+      printf(" %8s  %8.0f %8s\n", "-", grx, "-");
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   int cycles = 10000;
+
+   printf("SOEM (Simple Open EtherCAT Master)\nProcess data path benchmark on a simulated segment\n");
+
+   if (argc > 1)
+   {
+      cycles = atoi(argv[1]);
+   }
+   if (!nex_init("simnet"))
+   {
+      printf("No socket connection\n");
+      return 1;
+   }
+   printf("                          tx ns per cycle    rx ns per cycle\n");
+   printf("slaves     seg DC  IOmap     generic  special   generic  special\n");
+   bench(8, 32, FALSE, FALSE, cycles);
+   bench(8, 32, TRUE, FALSE, cycles);
+   bench(8, 32, TRUE, TRUE, cycles);
+   bench(4, 1200, FALSE, FALSE, cycles);
+   bench(4, 1200, TRUE, FALSE, cycles);
+   bench(4, 1200, TRUE, TRUE, cycles);
+   nex_close();
+
+   printf("%s\n", failures ? "FAIL" : "OK");
+   return failures ? 1 : 0;
+}
@@ -0,0 +1,187 @@
+/** \file
+ * \brief Retransmission test on a simulated segment
+ *
+ * Usage : rt_test
+ *
+ * Maps a group whose process data needs several frames and enables in-cycle
+ * retransmission. After the arrival times of the segments are learned, one
+ * segment of a cycle is lost at every stack location in turn and must come
+ * back as a copy within the cycle. A segment that is lost together with its
+ * copy must be counted as failed and leave no frame buffer behind.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ethercat.h"
+#include "simnet.h"
+
+/** start of outputs and inputs in the ESC memory of the simulated slaves */
+#define OUTADR   0x1400
+#define INADR    0x1C00
+/** slaves and output bytes per slave, one frame per slave */
+#define SLAVES   4
+#define OBYTES   1200
+/** retransmission budget in us */
+#define BUDGET   50000
+
+static uint8 IOmap[16 * 1024];
+static int failures;
+
+static void check(boolean ok, const char *what)
+{
+   if (!ok)
+   {
+      printf("  FAIL: %s\n", what);
+      failures++;
+   }
+}
+
+/* set the process data of a slave as if it had been read from its PDO objects */
+static void setslave(int k, int obytes, int ibytes)
+{
+   nex_slavet *s = &nex_slave[k];
+
+   s->configindex = 1;
+   s->Obits = (uint16)(obytes * 8);
+   s->Ibits = (uint16)(ibytes * 8);
+   s->Obytes = (uint32)obytes;
+   s->Ibytes = (uint32)ibytes;
+   s->SM[2].StartAddr = htoes(OUTADR);
+   s->SM[2].SMlength = htoes((uint16)obytes);
+   s->SMtype[2] = 3;
+   s->SM[3].StartAddr = htoes(INADR);
+   s->SM[3].SMlength = htoes((uint16)ibytes);
+   s->SMtype[3] = 4;
+}
+
+/* one cycle, the process data of every slave carries the cycle number */
+static boolean cycle(int cyc)
+{
+   nex_slavet *s;
+   int k, wkc, expected;
+   boolean ok = TRUE;
+
+   for (k = 1; k <= nex_slavecount; k++)
+   {
+      s = &nex_slave[k];
+      memset(s->outputs, (uint8)(cyc + k), s->Obytes);
+      memset(simnet_slave[k - 1].mem + INADR, (uint8)(cyc * 3 + k), s->Ibytes);
+   }
+   nex_send_processdata();
+   wkc = nex_receive_processdata(BUDGET);
+   expected = (nex_group[0].outputsWKC * 2) + nex_group[0].inputsWKC;
+   if (wkc != expected)
+   {
+      ok = FALSE;
+   }
+   for (k = 1; k <= nex_slavecount; k++)
+   {
+      s = &nex_slave[k];
+      if ((simnet_slave[k - 1].mem[OUTADR + OBYTES - 1] != (uint8)(cyc + k)) ||
+          (s->inputs[s->Ibytes - 1] != (uint8)(cyc * 3 + k)))
+      {
+         ok = FALSE;
+      }
+   }
+
+   return ok;
+}
+
+/* no frame buffer may be left in use after a cycle */
+static boolean released(void)
+{
+   int i;
+
+   for (i = 0; i < NEX_MAXBUF; i++)
+   {
+      if (nexx_port.rxbufstat[i] != NEX_BUF_EMPTY)
+      {
+         return FALSE;
+      }
+   }
+
+   return TRUE;
+}
+
+int main(void)
+{
+   nex_groupt *grp = &nex_group[0];
+   nex_retransmitstatt before;
+   int k, cyc, pos;
+   boolean learned;
+   char what[80];
+
+   printf("SOEM (Simple Open EtherCAT Master)\nRetransmission test on a simulated segment\n");
+
+   if (!nex_init("simnet"))
+   {
+      printf("No socket connection\n");
+      return 1;
+   }
+   simnet_init(SLAVES);
+   check(nex_config_init() == SLAVES, "slaves found");
+   for (k = 1; k <= nex_slavecount; k++)
+   {
+      setslave(k, OBYTES, 2);
+   }
+   check(nex_config_map_group(IOmap, 0) > 0, "group mapped");
+   check(grp->nsegments == SLAVES, "one segment per slave");
+   nex_config_retransmit(0, BUDGET);
+   simnet_latency = 200;
+
+   /* learn the arrival time of every segment */
+   for (cyc = 0; cyc < 100; cyc++)
+   {
+      check(cycle(cyc), "process data exchanged");
+   }
+   learned = TRUE;
+   for (pos = 0; pos < SLAVES; pos++)
+   {
+      if ((grp->rtsrtt[pos] < simnet_latency) || (pos && (grp->rtsrtt[pos] < grp->rtsrtt[pos - 1] / 2)))
+      {
+         learned = FALSE;
+      }
+   }
+   printf("arrival times:");
+   for (pos = 0; pos < SLAVES; pos++)
+   {
+      printf(" %d+-%d", grp->rtsrtt[pos], grp->rtrttvar[pos]);
+   }
+   printf(" us\n");
+   check(learned, "arrival time of every segment learned");
+   /* a late frame may be sent again on a loaded host, but never lost */
+   check(grp->rtstat.recovered == grp->rtstat.attempted, "no segment lost without loss");
+
+   /* lose one segment, the copy brings the process data back in the cycle */
+   for (pos = 0; pos < SLAVES; pos++)
+   {
+      before = grp->rtstat;
+      simnet_dropframe[0] = simnet_frames + 1 + pos;
+      sprintf(what, "segment %d recovered", pos);
+      check(cycle(100 + pos), what);
+      check(grp->rtstat.frames >= before.frames + 1, "copy sent");
+      check(grp->rtstat.recovered == before.recovered + 1, "cycle counted as recovered");
+      check(grp->rtstat.failed == before.failed, "nothing failed");
+      check(released(), "buffers released");
+      check(cycle(110 + pos), "next cycle");
+   }
+
+   /* lose a segment and its copy */
+   before = grp->rtstat;
+   simnet_dropframe[0] = simnet_frames + 2;
+   simnet_dropframe[1] = simnet_frames + SLAVES + 1;
+   check(!cycle(200), "cycle with lost segment incomplete");
+   check(grp->rtstat.frames >= before.frames + 1, "copy sent");
+   check(grp->rtstat.failed == before.failed + 1, "segment counted as failed");
+   check(grp->rtstat.recovered == before.recovered, "cycle not recovered");
+   check(released(), "buffers released");
+   check(cycle(201), "next cycle");
+   printf("cycles %u attempted %u recovered %u frames %u failed %u skipped %u\n",
+          grp->rtstat.cycles, grp->rtstat.attempted, grp->rtstat.recovered,
+          grp->rtstat.frames, grp->rtstat.failed, grp->rtstat.skipped);
+   nex_close();
+
+   printf("%s\n", failures ? "FAIL" : "OK");
+   return failures ? 1 : 0;
+}
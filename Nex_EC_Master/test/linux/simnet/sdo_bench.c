@@ -0,0 +1,274 @@
+/** \file
+ * \brief Segmented SDO benchmark on a simulated segment
+ *
+ * Usage : sdo_bench [size]
+ * size of the object in bytes, default 200000
+ *
+ * A simulated slave with a 512 byte mailbox serves one large object with
+ * segmented SDO transfers. The object is read with nex_SDOread,
+ * nex_SDOread_direct and nex_SDOread_stream and written with nex_SDOwrite and
+ * nex_SDOwrite_stream. Every transfer must move the whole object unchanged.
+ * Frames, segments, segments read in place and MB/s are reported, once without
+ * and once with a frame latency, where the frames a transfer needs decide its
+ * throughput.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ethercat.h"
+#include "simnet.h"
+
+#define OBJINDEX 0x2000
+#define MAXSIZE  (1024 * 1024)
+/** data bytes in the response to an upload request and in an upload segment */
+#define INITDATA (SIMNET_MBXSIZE - 16)
+#define SEGDATA  (SIMNET_MBXSIZE - 9)
+
+/** object of the simulated slave and the segment the transfer is at */
+static uint8 object[MAXSIZE];
+static int objsize;
+static int objoffset;
+/** buffer of the master */
+static uint8 buffer[MAXSIZE];
+static int failures;
+
+static void check(boolean ok, const char *what)
+{
+   if (!ok)
+   {
+      printf("  FAIL: %s\n", what);
+      failures++;
+   }
+}
+
+static double now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + (ts.tv_nsec * 1e-9);
+}
+
+static void putl(uint8 *p, uint32 v)
+{
+   p[0] = (uint8)v;
+   p[1] = (uint8)(v >> 8);
+   p[2] = (uint8)(v >> 16);
+   p[3] = (uint8)(v >> 24);
+}
+
+/* SDO server of the simulated slave, one object with segmented upload and download */
+static void sdoslave(simnet_slavet *slave, const uint8 *in, uint8 *out, boolean *respond)
+{
+   uint8 cmd = in[8];
+   int length = in[0] | (in[1] << 8);
+   int n;
+
+   (void)slave;                  /* Not used */
+   if (((in[5] & 0x0f) != ECT_MBXT_COE) || ((in[7] >> 4) != ECT_COES_SDOREQ))
+   {
+      return;
+   }
+   memset(out, 0, 16);
+   out[5] = in[5];                     /* type and counter */
+   out[7] = ECT_COES_SDORES << 4;
+   if ((cmd == ECT_SDO_UP_REQ) || (cmd == ECT_SDO_UP_REQ_CA))
+   {
+      n = (objsize < INITDATA) ? objsize : INITDATA;
+      out[0] = (uint8)(10 + n);
+      out[1] = (uint8)((10 + n) >> 8);
+      out[8] = 0x41;                   /* normal upload with size */
+      memcpy(out + 9, in + 9, 3);
+      putl(out + 12, (uint32)objsize);
+      memcpy(out + 16, object, n);
+      objoffset = n;
+   }
+   else if ((cmd & 0xe0) == ECT_SDO_SEG_UP_REQ)
+   {
+      n = objsize - objoffset;
+      n = (n < SEGDATA) ? n : SEGDATA;
+      out[8] = (uint8)((cmd & 0x10) | ((objoffset + n) == objsize));
+      if (n < 7)
+      {
+         out[0] = 10;
+         out[8] |= (uint8)((7 - n) << 1);
+      }
+      else
+      {
+         out[0] = (uint8)(n + 3);
+         out[1] = (uint8)((n + 3) >> 8);
+      }
+      memcpy(out + 9, object + objoffset, n);
+      objoffset += n;
+   }
+   else if ((cmd == ECT_SDO_DOWN_INIT) || (cmd == ECT_SDO_DOWN_INIT_CA))
+   {
+      objsize = in[12] | (in[13] << 8) | (in[14] << 16) | (in[15] << 24);
+      n = length - 10;
+      memcpy(object, in + 16, n);
+      objoffset = n;
+      out[0] = 10;
+      out[8] = 0x60;                   /* download response */
+      memcpy(out + 9, in + 9, 3);
+   }
+   else if ((cmd & 0xe0) == 0x00)
+   {
+      n = ((cmd & 0x01) && (length == 10)) ? (7 - ((cmd >> 1) & 0x07)) : (length - 3);
+      if ((objoffset + n) <= MAXSIZE)
+      {
+         memcpy(object + objoffset, in + 9, n);
+         objoffset += n;
+      }
+      out[0] = 10;
+      out[8] = (uint8)(0x20 | (cmd & 0x10)); /* segment download response */
+   }
+   else
+   {
+      return;
+   }
+   *respond = TRUE;
+}
+
+/* stores received segments */
+static int storehook(void *arg, void *buf, int size)
+{
+   int *offset = (int *)arg;
+
+   memcpy(buffer + *offset, buf, size);
+   *offset += size;
+   return size;
+}
+
+/* supplies segments to send */
+static int supplyhook(void *arg, void *buf, int size)
+{
+   int *offset = (int *)arg;
+
+   memcpy(buf, buffer + *offset, size);
+   *offset += size;
+   return size;
+}
+
+static void pattern(uint8 *p, int size, int seed)
+{
+   int i;
+
+   for (i = 0; i < size; i++)
+   {
+      p[i] = (uint8)((i * 7) + (i >> 8) + seed);
+   }
+}
+
+static void report(const char *name, int size, uint32 frames, double t, nex_SDOstatt *stat)
+{
+   if (stat)
+   {
+      printf("%-18s %7u %8u %8u %9.2f\n", name, frames, stat->segments, stat->inplace, size / t / 1e6);
+   }
+   else
+   {
+      printf("%-18s %7u %8s %8s %9.2f\n", name, frames, "-", "-", size / t / 1e6);
+   }
+}
+
+static void bench(int size, int32 latency)
+{
+   nex_SDOstatt stat;
+   uint32 frames;
+   double t;
+   int psize, offset, wkc;
+
+   simnet_latency = latency;
+   printf("latency %d us        frames segments  inplace      MB/s\n", latency);
+
+   /* uploads */
+   objsize = size;
+   pattern(object, size, 1);
+   memset(buffer, 0, size);
+   psize = MAXSIZE;
+   frames = simnet_frames;
+   t = now();
+   wkc = nex_SDOread(1, OBJINDEX, 0, FALSE, &psize, buffer, NEX_TIMEOUTRXM);
+   t = now() - t;
+   check((wkc > 0) && (psize == size) && !memcmp(buffer, object, size), "SDOread of the object");
+   report("SDOread", size, simnet_frames - frames, t, NULL);
+
+   memset(buffer, 0, size);
+   psize = MAXSIZE;
+   frames = simnet_frames;
+   t = now();
+   wkc = nex_SDOread_direct(1, OBJINDEX, 0, FALSE, &psize, buffer, &stat, NEX_TIMEOUTRXM);
+   t = now() - t;
+   check((wkc > 0) && (psize == size) && !memcmp(buffer, object, size), "SDOread_direct of the object");
+   check(stat.inplace > 0, "segments read in place");
+   report("SDOread_direct", size, simnet_frames - frames, t, &stat);
+
+   memset(buffer, 0, size);
+   offset = 0;
+   frames = simnet_frames;
+   t = now();
+   wkc = nex_SDOread_stream(1, OBJINDEX, 0, FALSE, storehook, &offset, &stat, NEX_TIMEOUTRXM);
+   t = now() - t;
+   check((wkc > 0) && (offset == size) && !memcmp(buffer, object, size), "SDOread_stream of the object");
+   report("SDOread_stream", size, simnet_frames - frames, t, &stat);
+
+   /* downloads */
+   pattern(buffer, size, 2);
+   memset(object, 0, size);
+   objsize = 0;
+   frames = simnet_frames;
+   t = now();
+   wkc = nex_SDOwrite(1, OBJINDEX, 0, FALSE, size, buffer, NEX_TIMEOUTRXM);
+   t = now() - t;
+   check((wkc > 0) && (objsize == size) && (objoffset == size) && !memcmp(buffer, object, size),
+         "SDOwrite of the object");
+   report("SDOwrite", size, simnet_frames - frames, t, NULL);
+
+   pattern(buffer, size, 3);
+   memset(object, 0, size);
+   objsize = 0;
+   offset = 0;
+   frames = simnet_frames;
+   t = now();
+   wkc = nex_SDOwrite_stream(1, OBJINDEX, 0, FALSE, size, supplyhook, &offset, &stat, NEX_TIMEOUTRXM);
+   t = now() - t;
+   check((wkc > 0) && (objsize == size) && (objoffset == size) && !memcmp(buffer, object, size),
+         "SDOwrite_stream of the object");
+   report("SDOwrite_stream", size, simnet_frames - frames, t, &stat);
+}
+
+int main(int argc, char *argv[])
+{
+   int size = 200000;
+
+   printf("SOEM (Simple Open EtherCAT Master)\nSegmented SDO benchmark on a simulated segment\n");
+
+   if (argc > 1)
+   {
+      size = atoi(argv[1]);
+   }
+   if ((size <= INITDATA) || (size > MAXSIZE))
+   {
+      printf("Size must be %d to %d bytes\n", INITDATA + 1, MAXSIZE);
+      return 1;
+   }
+   if (!nex_init("simnet"))
+   {
+      printf("No socket connection\n");
+      return 1;
+   }
+   simnet_init(1);
+   simnet_mailbox(0, ECT_MBXPROT_COE, sdoslave);
+   check(nex_config_init() == 1, "slave found");
+   check(nex_statecheck(0, NEX_STATE_PRE_OP, NEX_TIMEOUTSTATE) == NEX_STATE_PRE_OP, "slave in PRE_OP");
+   printf("object of %d bytes, %d byte mailbox\n", size, SIMNET_MBXSIZE);
+   bench(size, 0);
+   bench(size, 50);
+   nex_close();
+
+   printf("%s\n", failures ? "FAIL" : "OK");
+   return failures ? 1 : 0;
+}
@@ -0,0 +1,273 @@
+/** \file
+ * \brief SDO poll list test on a simulated segment
+ *
+ * Usage : sdopoll_test
+ *
+ * Two simulated slaves serve polled objects, the first with Complete Access.
+ * Consecutive subindexes of an object on the first slave must be merged into
+ * one Complete Access upload, the second slave must be read entry by entry.
+ * An object whose Complete Access response does not fit in a mailbox must be
+ * read once with Complete Access and entry by entry from then on, and an
+ * unknown object must publish its abort code. While the main thread polls, a
+ * reader thread reads the cached values with nexx_SDOpoll_get. The server
+ * fills every byte of a value with the same count, so a torn read shows as a
+ * value with different bytes.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "ethercat.h"
+#include "simnet.h"
+
+/** object read with Complete Access, 4 subindexes of 4 bytes */
+#define CAINDEX    0x6000
+#define CASUBS     4
+/** object with 100 subindexes of 8 bytes, too large for one mailbox */
+#define BIGINDEX   0x6100
+#define BIGSUBS    100
+#define BIGREAD    3
+/** single entry and unknown object */
+#define ONEINDEX   0x6200
+#define ONESUB     5
+#define BADINDEX   0x6300
+#define ABORTCODE  0x06020000
+#define PERIOD     1000
+#define RUNTIME    300000
+
+static nex_SDOpollt poll;
+/** requests seen by the server per slave, with Complete Access and per object */
+static int careq[2][3];
+static int plainreq[2][3];
+/** counts filled into the values */
+static uint8 serial[2];
+/** reader thread stops */
+static int stop;
+static int failures;
+
+static void check(boolean ok, const char *what)
+{
+   if (!ok)
+   {
+      printf("  FAIL: %s\n", what);
+      failures++;
+   }
+}
+
+static void putl(uint8 *p, uint32 v)
+{
+   p[0] = (uint8)v;
+   p[1] = (uint8)(v >> 8);
+   p[2] = (uint8)(v >> 16);
+   p[3] = (uint8)(v >> 24);
+}
+
+static int object(uint16 index)
+{
+   return (index == CAINDEX) ? 0 : (index == BIGINDEX) ? 1 : 2;
+}
+
+/* size of a subindex of an object, 0 if it does not exist */
+static int subsize(uint16 index, uint8 subindex)
+{
+   if (index == CAINDEX)
+   {
+      return ((subindex >= 1) && (subindex <= CASUBS)) ? 4 : 0;
+   }
+   if (index == BIGINDEX)
+   {
+      return ((subindex >= 1) && (subindex <= BIGSUBS)) ? 8 : 0;
+   }
+   return ((index == ONEINDEX) && (subindex == ONESUB)) ? 2 : 0;
+}
+
+/* SDO upload server of the simulated slaves */
+static void sdoslave(simnet_slavet *slave, const uint8 *in, uint8 *out, boolean *respond)
+{
+   uint16 index = (uint16)(in[9] | (in[10] << 8));
+   uint8 subindex = in[11];
+   uint8 cmd = in[8];
+   int pos = slave->position;
+   int n, size, s;
+
+   if (((in[5] & 0x0f) != ECT_MBXT_COE) || ((in[7] >> 4) != ECT_COES_SDOREQ) ||
+       ((cmd != ECT_SDO_UP_REQ) && (cmd != ECT_SDO_UP_REQ_CA)))
+   {
+      return;
+   }
+   memset(out, 0, 16);
+   out[5] = in[5];                     /* type and counter */
+   out[7] = ECT_COES_SDORES << 4;
+   memcpy(out + 9, in + 9, 3);
+   *respond = TRUE;
+   size = subsize(index, subindex);
+   if (!size)
+   {
+      out[0] = 10;
+      out[8] = ECT_SDO_ABORT;
+      putl(out + 12, ABORTCODE);
+      return;
+   }
+   serial[pos]++;
+   if (cmd == ECT_SDO_UP_REQ_CA)
+   {
+      careq[pos][object(index)]++;
+      /* all subindexes from the requested one on, cut at the mailbox */
+      size = 0;
+      for (s = subindex; subsize(index, (uint8)s); s++)
+      {
+         size += subsize(index, (uint8)s);
+      }
+      n = (size < (SIMNET_MBXSIZE - 16)) ? size : (SIMNET_MBXSIZE - 16);
+      out[0] = (uint8)(10 + n);
+      out[1] = (uint8)((10 + n) >> 8);
+      out[8] = 0x41;                   /* normal upload with size */
+      putl(out + 12, (uint32)size);
+      memset(out + 16, serial[pos], n);
+      return;
+   }
+   plainreq[pos][object(index)]++;
+   if (size <= 4)
+   {
+      out[0] = 10;
+      out[8] = (uint8)(0x43 | ((4 - size) << 2)); /* expedited upload */
+      memset(out + 12, serial[pos], size);
+   }
+   else
+   {
+      out[0] = (uint8)(10 + size);
+      out[8] = 0x41;
+      putl(out + 12, (uint32)size);
+      memset(out + 16, serial[pos], size);
+   }
+}
+
+/* reads all cached values until stopped, counts values with different bytes */
+static void *reader(void *param)
+{
+   uint8 v[NEX_SDOPOLL_MAXDATA];
+   nex_timet t;
+   int *torn = (int *)param;
+   int h, i, length, reads = 0;
+
+   while (!__atomic_load_n(&stop, __ATOMIC_ACQUIRE))
+   {
+      for (h = 0; h < poll.nentry; h++)
+      {
+         length = nexx_SDOpoll_get(&poll, h, v, &t);
+         for (i = 1; i < length; i++)
+         {
+            *torn += (v[i] != v[0]);
+         }
+         if (length && (length != poll.entry[h].size))
+         {
+            (*torn)++;
+         }
+         reads++;
+      }
+   }
+   return (void *)(size_t)reads;
+}
+
+int main(void)
+{
+   pthread_t thread;
+   void *reads;
+   nex_timet start, now, diff;
+   uint8 v[NEX_SDOPOLL_MAXDATA];
+   int ca[CASUBS], big[BIGREAD], two[2], one, bad;
+   int h, k, ntx, torn = 0;
+   boolean ok;
+
+   printf("SOEM (Simple Open EtherCAT Master)\nSDO poll list test on a simulated segment\n");
+
+   if (!nex_init("simnet"))
+   {
+      printf("No socket connection\n");
+      return 1;
+   }
+   simnet_init(2);
+   simnet_mailbox(0, ECT_MBXPROT_COE, sdoslave);
+   simnet_mailbox(1, ECT_MBXPROT_COE, sdoslave);
+   check(nex_config_init() == 2, "slaves found");
+   check(nex_statecheck(0, NEX_STATE_PRE_OP, NEX_TIMEOUTSTATE) == NEX_STATE_PRE_OP, "slaves in PRE_OP");
+   /* the simulated SII has no general category, set as if read from it */
+   nex_slave[1].CoEdetails |= ECT_COEDET_SDOCA;
+   nex_slave[2].CoEdetails &= (uint8)~ECT_COEDET_SDOCA;
+
+   nexx_SDOpoll_init(&poll, NEX_TIMEOUTRXM);
+   for (k = 1; k <= CASUBS; k++)
+   {
+      ca[k - 1] = nexx_SDOpoll_add(&poll, 1, CAINDEX, (uint8)k, 4, PERIOD);
+   }
+   for (k = 1; k <= BIGREAD; k++)
+   {
+      big[k - 1] = nexx_SDOpoll_add(&poll, 1, BIGINDEX, (uint8)k, 8, PERIOD);
+   }
+   one = nexx_SDOpoll_add(&poll, 1, ONEINDEX, ONESUB, 2, PERIOD);
+   bad = nexx_SDOpoll_add(&poll, 1, BADINDEX, 1, 4, PERIOD);
+   two[0] = nexx_SDOpoll_add(&poll, 2, CAINDEX, 1, 4, PERIOD);
+   two[1] = nexx_SDOpoll_add(&poll, 2, CAINDEX, 2, 4, PERIOD);
+   check(nexx_SDOpoll_add(&poll, 1, CAINDEX, 1, NEX_SDOPOLL_MAXDATA + 1, PERIOD) < 0, "oversized entry refused");
+   ntx = nex_SDOpoll_start(&poll);
+   /* slave 1: CA object, large object, single entry, unknown object, slave 2: two entries */
+   check(ntx == 6, "consecutive subindexes merged into one transaction");
+   check(nexx_SDOpoll_get(&poll, ca[0], v, NULL) == 0, "no value before the first read");
+
+   pthread_create(&thread, NULL, reader, &torn);
+   start = osal_current_time();
+   do
+   {
+      nex_SDOpoll(&poll, NEX_SDOPOLL_MAXREQ);
+      now = osal_current_time();
+      osal_time_diff(&start, &now, &diff);
+   } while ((diff.sec * 1000000 + diff.usec) < RUNTIME);
+   __atomic_store_n(&stop, 1, __ATOMIC_RELEASE);
+   pthread_join(thread, &reads);
+   printf("requests %u  responses %u  careads %u  aborts %u  timeouts %u  errors %u  late %u\n",
+      poll.stat.requests, poll.stat.responses, poll.stat.careads, poll.stat.aborts, poll.stat.timeouts,
+      poll.stat.errors, poll.stat.late);
+   printf("%d values read beside the poller\n", (int)(size_t)reads);
+
+   /* Complete Access merging */
+   ok = (careq[0][0] > 1) && !plainreq[0][0];
+   for (k = 0; k < CASUBS; k++)
+   {
+      /* the last request may still be in transfer */
+      ok = ok && ((poll.entry[ca[k]].updates + 1) >= (uint32)careq[0][0]) &&
+           (poll.entry[ca[k]].updates <= (uint32)careq[0][0]) &&
+           (nexx_SDOpoll_get(&poll, ca[k], v, NULL) == 4);
+   }
+   check(ok, "object read with one Complete Access upload for all subindexes");
+   check(!careq[1][0] && (plainreq[1][0] > 2) && (poll.entry[two[0]].updates > 0) &&
+         (poll.entry[two[1]].updates > 0), "slave without Complete Access read entry by entry");
+   check(poll.stat.careads >= (uint32)careq[0][0], "Complete Access reads counted");
+
+   /* fallback of the object that does not fit in a mailbox */
+   check(careq[0][1] == 1, "large object read with Complete Access only once");
+   check(poll.stat.errors >= 1, "response larger than a mailbox counted");
+   ok = plainreq[0][1] >= BIGREAD;
+   for (k = 0; k < BIGREAD; k++)
+   {
+      ok = ok && (poll.entry[big[k]].updates > 0) && (nexx_SDOpoll_get(&poll, big[k], v, NULL) == 8);
+   }
+   check(ok, "large object read entry by entry after the fallback");
+
+   check((poll.entry[one].updates > 0) && (nexx_SDOpoll_get(&poll, one, v, NULL) == 2), "single entry read");
+   check((poll.entry[bad].abortcode == ABORTCODE) && !poll.entry[bad].updates && (poll.stat.aborts > 0),
+         "abort code of unknown object published");
+   check(!poll.stat.timeouts, "no requests timed out");
+
+   /* seqlock reads */
+   check((size_t)reads > 0, "values read beside the poller");
+   check(!torn, "no torn values read");
+   for (h = 0; h < poll.nentry; h++)
+   {
+      check(!(poll.entry[h].seq & 1), "sequence even after the poller stopped");
+   }
+   nex_close();
+
+   printf("%s\n", failures ? "FAIL" : "OK");
+   return failures ? 1 : 0;
+}
@@ -0,0 +1,959 @@
+/** \file
+ * \brief
+ * Simulated EtherCAT segment, replaces the NIC driver for tests without a
+ * network.
+ *
+ * A frame is processed by all simulated slaves when it is sent and is then put
+ * in the receive queue of its segment. It can be received the latency of the
+ * segment after the send. Receiving works like the NIC driver: a frame of
+ * another index is put in the buffer of its index, so frames can be waited for
+ * in any order. Like the NIC driver it may be used by several threads, one
+ * frame of a segment is handled at a time. The segment is chosen by the
+ * interface name in nexx_setupnic and kept in the sockhandle of the port.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "osal.h"
+#include "oshw.h"
+#include "simnet.h"
+
+/** frames in flight */
+#define SIMNET_MAXQUEUE    (2 * NEX_MAXBUF)
+
+/** frame in the receive queue */
+typedef struct
+{
+   int     idx;
+   int     length;
+   int64   arrival;
+   nex_bufT data;
+} simnet_framet;
+
+/** primary source mac address */
+const uint16 priMAC[3] = { 0x0101, 0x0101, 0x0101 };
+/** secondary source mac address */
+const uint16 secMAC[3] = { 0x0404, 0x0404, 0x0404 };
+
+/** receive queue and slaves in progress of a segment */
+typedef struct simnet_net
+{
+   /** frames and slaves are used by one thread at a time */
+   pthread_mutex_t lock;
+   simnet_framet  queue[SIMNET_MAXQUEUE];
+   int            queuehead;
+   int            queuecount;
+   /** slaves with an EEPROM command, AL request or mailbox in progress */
+   uint16         *active;
+   boolean        *isactive;
+   int            nactive;
+} simnet_nett;
+
+/** everything a segment made by simnet_create refers to */
+typedef struct
+{
+   simnet_segmentt segment;
+   simnet_nett    net;
+   int            slavecount;
+   int            dropbefore;
+   int            dropafter;
+   uint32         dropframe[SIMNET_MAXDROP];
+   int32          latency;
+   uint32         frames;
+   uint32         datagrams;
+   uint32         lrwblocked;
+} simnet_storaget;
+
+simnet_slavet simnet_slave[SIMNET_MAXSLAVE];
+int simnet_slavecount;
+int simnet_dropbefore;
+int simnet_dropafter;
+uint32 simnet_dropframe[SIMNET_MAXDROP];
+int32 simnet_latency;
+uint32 simnet_frames;
+uint32 simnet_datagrams;
+uint32 simnet_lrwblocked;
+
+static uint16 simnet_active[SIMNET_MAXSLAVE];
+static boolean simnet_isactive[SIMNET_MAXSLAVE];
+static simnet_nett simnet_net0 =
+{
+   PTHREAD_MUTEX_INITIALIZER, { { 0 } }, 0, 0, &simnet_active[0], &simnet_isactive[0], 0
+};
+
+simnet_segmentt simnet_segment =
+{
+   "simnet",
+   &simnet_slave[0],
+   SIMNET_MAXSLAVE,
+   &simnet_slavecount,
+   &simnet_dropbefore,
+   &simnet_dropafter,
+   &simnet_dropframe[0],
+   &simnet_latency,
+   &simnet_frames,
+   &simnet_datagrams,
+   &simnet_lrwblocked,
+   &simnet_net0
+};
+
+/** segments by interface name, the index is kept in the sockhandle of a port */
+static pthread_mutex_t simnet_listlock = PTHREAD_MUTEX_INITIALIZER;
+static simnet_segmentt *simnet_list[SIMNET_MAXSEGMENT] = { &simnet_segment };
+static int simnet_nsegment = 1;
+
+static int64 simnet_now(void)
+{
+   nex_timet t;
+
+   t = osal_current_time();
+   return ((int64)t.sec * 1000000) + t.usec;
+}
+
+static uint16 simnet_getw(const uint8 *p)
+{
+   return (uint16)(p[0] | (p[1] << 8));
+}
+
+static uint32 simnet_getl(const uint8 *p)
+{
+   return (uint32)p[0] | ((uint32)p[1] << 8) | ((uint32)p[2] << 16) | ((uint32)p[3] << 24);
+}
+
+static void simnet_putw(uint8 *p, uint16 w)
+{
+   p[0] = (uint8)(w & 0xff);
+   p[1] = (uint8)(w >> 8);
+}
+
+static void simnet_activate(simnet_nett *net, simnet_slavet *s)
+{
+   if (!net->isactive[s->position])
+   {
+      net->isactive[s->position] = TRUE;
+      net->active[net->nactive++] = s->position;
+   }
+}
+
+/** Make a further segment, opened by a master with ifname. The segment
+ * has no slaves until simnetx_init.
+ * @param[in] ifname    = interface name
+ * @param[in] maxslave  = maximum number of slaves
+ * @return segment, NULL if the name is in use or no segment is left
+ */
+simnet_segmentt *simnet_create(const char *ifname, int maxslave)
+{
+   simnet_storaget *st;
+   simnet_segmentt *seg;
+   int i;
+
+   pthread_mutex_lock(&simnet_listlock);
+   for (i = 0; i < simnet_nsegment; i++)
+   {
+      if (!strcmp(simnet_list[i]->ifname, ifname))
+      {
+         pthread_mutex_unlock(&simnet_listlock);
+         return NULL;
+      }
+   }
+   st = (simnet_nsegment < SIMNET_MAXSEGMENT) ? (simnet_storaget *)calloc(1, sizeof(simnet_storaget)) : NULL;
+   if (!st)
+   {
+      pthread_mutex_unlock(&simnet_listlock);
+      return NULL;
+   }
+   seg = &st->segment;
+   strncpy(seg->ifname, ifname, SIMNET_MAXNAME);
+   seg->slave = (simnet_slavet *)calloc(maxslave, sizeof(simnet_slavet));
+   seg->maxslave = maxslave;
+   seg->slavecount = &st->slavecount;
+   seg->dropbefore = &st->dropbefore;
+   seg->dropafter = &st->dropafter;
+   seg->dropframe = &st->dropframe[0];
+   seg->latency = &st->latency;
+   seg->frames = &st->frames;
+   seg->datagrams = &st->datagrams;
+   seg->lrwblocked = &st->lrwblocked;
+   pthread_mutex_init(&st->net.lock, NULL);
+   st->net.active = (uint16 *)calloc(maxslave, sizeof(uint16));
+   st->net.isactive = (boolean *)calloc(maxslave, sizeof(boolean));
+   seg->net = &st->net;
+   simnet_list[simnet_nsegment++] = seg;
+   pthread_mutex_unlock(&simnet_listlock);
+
+   return seg;
+}
+
+/** Reset the segment to slavecount slaves in INIT with a blank SII, linked in
+ * a line. The receive queue and all counters are cleared.
+ * @param[in] segment     = segment
+ * @param[in] slavecount  = number of slaves
+ */
+void simnetx_init(simnet_segmentt *segment, int slavecount)
+{
+   simnet_nett *net = segment->net;
+   simnet_slavet *s;
+   int i;
+
+   if (slavecount > segment->maxslave)
+   {
+      slavecount = segment->maxslave;
+   }
+   *segment->slavecount = slavecount;
+   for (i = 0; i < slavecount; i++)
+   {
+      s = &segment->slave[i];
+      if (!s->mem)
+      {
+         s->mem = (uint8 *)malloc(SIMNET_MEMSIZE);
+         /* room for an 8 byte read at the last address */
+         s->eeprom = (uint8 *)malloc(SIMNET_EEPSIZE + 8);
+      }
+      memset(s->mem, 0, SIMNET_MEMSIZE);
+      /* erased EEPROM, empty header and no categories */
+      memset(s->eeprom, 0xff, SIMNET_EEPSIZE + 8);
+      memset(s->eeprom, 0, 0x80);
+      s->position = (uint16)i;
+      s->eepdelay = 1;
+      s->eepread64 = FALSE;
+      s->eepbusy = 0;
+      s->eeperror = FALSE;
+      s->alpending = 0;
+      s->mbxoutfull = FALSE;
+      s->mbxinfull = FALSE;
+      s->mbxdelay = 0;
+      s->mbxcountdown = 0;
+      s->mbxhook = NULL;
+      s->nolrw = FALSE;
+      s->user = NULL;
+      s->mem[ECT_REG_ALSTAT] = NEX_STATE_INIT;
+      net->isactive[i] = FALSE;
+      simnetx_links(segment, i, (i < (slavecount - 1)) ? 2 : 1);
+   }
+   net->nactive = 0;
+   net->queuehead = 0;
+   net->queuecount = 0;
+   *segment->dropbefore = 0;
+   *segment->dropafter = 0;
+   memset(segment->dropframe, 0, SIMNET_MAXDROP * sizeof(uint32));
+   *segment->latency = 0;
+   *segment->frames = 0;
+   *segment->datagrams = 0;
+   *segment->lrwblocked = 0;
+}
+
+/** Set the identity in the SII of a slave.
+ * @param[in] segment   = segment
+ * @param[in] position  = slave position
+ * @param[in] man       = manufacturer
+ * @param[in] id        = product code
+ * @param[in] rev       = revision
+ */
+void simnetx_identity(simnet_segmentt *segment, int position, uint32 man, uint32 id, uint32 rev)
+{
+   uint8 *e = segment->slave[position].eeprom;
+
+   memcpy(e + (ECT_SII_MANUF * 2), &man, sizeof(man));
+   memcpy(e + (ECT_SII_ID * 2), &id, sizeof(id));
+   memcpy(e + (ECT_SII_REV * 2), &rev, sizeof(rev));
+}
+
+/** Set the number of ports of a slave with link and communication, 1 for the
+ * end of a line, 3 or 4 for a junction.
+ * @param[in] segment   = segment
+ * @param[in] position  = slave position
+ * @param[in] links     = ports with link
+ */
+void simnetx_links(simnet_segmentt *segment, int position, int links)
+{
+   uint16 dl = 0;
+   int p;
+
+   for (p = 0; p < links; p++)
+   {
+      dl |= (uint16)(0x0200 << (2 * p));
+   }
+   simnet_putw(segment->slave[position].mem + ECT_REG_DLSTAT, dl);
+}
+
+/** Give a slave a mailbox in the SII. The response to a written mailbox is
+ * made by hook.
+ * @param[in] segment   = segment
+ * @param[in] position  = slave position
+ * @param[in] protocols = ECT_MBXPROT_ bits
+ * @param[in] hook      = mailbox application
+ */
+void simnetx_mailbox(simnet_segmentt *segment, int position, uint16 protocols, simnet_mbxhookt hook)
+{
+   uint8 *e = segment->slave[position].eeprom;
+
+   simnet_putw(e + (ECT_SII_RXMBXADR * 2), SIMNET_MBXOUT);
+   simnet_putw(e + (ECT_SII_MBXSIZE * 2), SIMNET_MBXSIZE);
+   simnet_putw(e + (ECT_SII_TXMBXADR * 2), SIMNET_MBXIN);
+   simnet_putw(e + ((ECT_SII_TXMBXADR + 1) * 2), SIMNET_MBXSIZE);
+   simnet_putw(e + (ECT_SII_MBXPROTO * 2), protocols);
+   segment->slave[position].mbxhook = hook;
+}
+
+/** Set the DC system time register of a slave.
+ * @param[in] segment   = segment
+ * @param[in] position  = slave position
+ * @param[in] time      = system time in ns
+ */
+void simnetx_setdc(simnet_segmentt *segment, int position, int64 time)
+{
+   memcpy(segment->slave[position].mem + ECT_REG_DCSYSTIME, &time, sizeof(time));
+}
+
+/* advance EEPROM, AL state and mailbox application of the slaves by one frame */
+static void simnet_tick(simnet_segmentt *seg)
+{
+   simnet_nett *net = seg->net;
+   simnet_slavet *s;
+   boolean respond;
+   int i, n;
+
+   for (i = 0; i < net->nactive; i++)
+   {
+      s = &seg->slave[net->active[i]];
+      if (s->eepbusy && !--s->eepbusy && !s->eeperror)
+      {
+         if (s->eepcmd == NEX_ECMD_READ)
+         {
+            memcpy(s->mem + ECT_REG_EEPDAT, s->eeprom + ((2 * s->eepadr) % SIMNET_EEPSIZE), 8);
+         }
+         else if (s->eepcmd == NEX_ECMD_WRITE)
+         {
+            memcpy(s->eeprom + ((2 * s->eepadr) % SIMNET_EEPSIZE), s->mem + ECT_REG_EEPDAT, 2);
+         }
+      }
+      if (s->alpending && !--s->alpending)
+      {
+         s->mem[ECT_REG_ALSTAT] = (uint8)(s->alrequest & 0x0f);
+         s->mem[ECT_REG_ALSTAT + 1] = 0;
+      }
+      if (s->mbxoutfull && s->mbxhook && !s->mbxinfull)
+      {
+         if (s->mbxcountdown > 0)
+         {
+            s->mbxcountdown--;
+         }
+         else
+         {
+            respond = FALSE;
+            s->mbxoutfull = FALSE;
+            s->mbxhook(s, s->mbxout, s->mem + simnet_getw(s->mem + ECT_REG_SM1), &respond);
+            s->mbxinfull = respond;
+         }
+      }
+   }
+   /* keep the slaves that still have something to do */
+   n = 0;
+   for (i = 0; i < net->nactive; i++)
+   {
+      s = &seg->slave[net->active[i]];
+      if (s->eepbusy || s->alpending || (s->mbxoutfull && s->mbxhook))
+      {
+         net->active[n++] = net->active[i];
+      }
+      else
+      {
+         net->isactive[s->position] = FALSE;
+      }
+   }
+   net->nactive = n;
+}
+
+/* physical access of a datagram to one slave, returns the work counter increment */
+static int simnet_access(simnet_segmentt *seg, simnet_slavet *s, uint8 cmd, uint16 ado, uint16 length, uint8 *data)
+{
+   boolean rd, wr;
+   uint16 mbxout, mbxoutl, mbxin, mbxinl, stat, c;
+   int i;
+
+   rd = (cmd == NEX_CMD_APRD) || (cmd == NEX_CMD_FPRD) || (cmd == NEX_CMD_BRD) || (cmd == NEX_CMD_APRW) ||
+        (cmd == NEX_CMD_FPRW) || (cmd == NEX_CMD_BRW) || (cmd == NEX_CMD_FRMW) || (cmd == NEX_CMD_ARMW);
+   wr = (cmd == NEX_CMD_APWR) || (cmd == NEX_CMD_FPWR) || (cmd == NEX_CMD_BWR) || (cmd == NEX_CMD_APRW) ||
+        (cmd == NEX_CMD_FPRW) || (cmd == NEX_CMD_BRW);
+   if (((uint32)ado + length) > SIMNET_MEMSIZE)
+   {
+      return 0;
+   }
+   mbxout = simnet_getw(s->mem + ECT_REG_SM0);
+   mbxoutl = simnet_getw(s->mem + ECT_REG_SM0 + 2);
+   mbxin = simnet_getw(s->mem + ECT_REG_SM1);
+   mbxinl = simnet_getw(s->mem + ECT_REG_SM1 + 2);
+   /* mailbox written by the master */
+   if (mbxoutl && (ado == mbxout))
+   {
+      if (!wr || s->mbxoutfull || (length > SIMNET_MBXSIZE))
+      {
+         return 0;
+      }
+      memcpy(s->mbxout, data, length);
+      s->mbxoutfull = TRUE;
+      s->mbxcountdown = s->mbxdelay;
+      simnet_activate(seg->net, s);
+      return 1;
+   }
+   /* mailbox read by the master */
+   if (mbxinl && (ado == mbxin))
+   {
+      if (!rd || !s->mbxinfull)
+      {
+         return 0;
+      }
+      memcpy(data, s->mem + ado, length);
+      s->mbxinfull = FALSE;
+      return 1;
+   }
+   if (rd)
+   {
+      stat = (uint16)((s->eepbusy ? NEX_ESTAT_BUSY : 0) | (s->eeperror ? NEX_ESTAT_NACK : 0) |
+                      (s->eepread64 ? NEX_ESTAT_R64 : 0));
+      simnet_putw(s->mem + ECT_REG_EEPSTAT, stat);
+      s->mem[ECT_REG_SM0STAT] = s->mbxoutfull ? 0x08 : 0;
+      s->mem[ECT_REG_SM1STAT] = s->mbxinfull ? 0x08 : 0;
+      if (cmd == NEX_CMD_BRD)
+      {
+         for (i = 0; i < length; i++)
+         {
+            data[i] |= s->mem[ado + i];
+         }
+      }
+      else
+      {
+         memcpy(data, s->mem + ado, length);
+      }
+   }
+   if (wr)
+   {
+      if (ado == ECT_REG_ALCTL)
+      {
+         s->alrequest = simnet_getw(data);
+         s->alpending = 2;
+         simnet_activate(seg->net, s);
+         return rd ? 3 : 1;
+      }
+      /* mailbox repeat request, the last response is offered again */
+      if ((ado == ECT_REG_SM1STAT) && (length == 2))
+      {
+         if ((data[1] ^ s->mem[ECT_REG_SM1ACT]) & 0x02)
+         {
+            s->mem[ECT_REG_SM1ACT] = data[1];
+            s->mbxinfull = TRUE;
+            s->mem[ECT_REG_SM1CONTR] = (uint8)((s->mem[ECT_REG_SM1CONTR] & ~0x02) | (data[1] & 0x02));
+         }
+         return 1;
+      }
+      if ((ado == ECT_REG_EEPCTL) && (length >= 2))
+      {
+         c = simnet_getw(data);
+         if (!c)
+         {
+            s->eeperror = FALSE;
+            return 1;
+         }
+         if (s->eepbusy || s->eeperror)
+         {
+            return 1;
+         }
+         s->eepcmd = c;
+         s->eepadr = (length >= 4) ? simnet_getw(data + 2) : simnet_getw(s->mem + ECT_REG_EEPADR);
+         s->eepbusy = (c == NEX_ECMD_WRITE) ? (s->eepdelay * 5) + 1 : s->eepdelay + 1;
+         simnet_activate(seg->net, s);
+         return 1;
+      }
+      memcpy(s->mem + ado, data, length);
+   }
+
+   return (rd && wr) ? 3 : 1;
+}
+
+/* logical access of a datagram to one slave through its FMMUs */
+static int simnet_logical(simnet_segmentt *seg, simnet_slavet *s, uint8 cmd, uint32 adr, uint16 length, uint8 *data)
+{
+   uint8 *m, *dp;
+   uint32 ls, b, b0, b1, pb;
+   uint16 ll;
+   boolean r = FALSE, w = FALSE;
+   int f, db;
+
+   for (f = 0; f < NEX_MAXFMMU; f++)
+   {
+      m = s->mem + ECT_REG_FMMU0 + (f * sizeof(nex_fmmut));
+      if (!m[12])
+      {
+         continue;
+      }
+      ls = simnet_getl(m);
+      ll = simnet_getw(m + 4);
+      if (((ls + ll) <= adr) || (ls >= (adr + length)))
+      {
+         continue;
+      }
+      if (s->nolrw && (cmd == NEX_CMD_LRW))
+      {
+         (*seg->lrwblocked)++;
+      }
+      b0 = (ls * 8) + m[6];
+      b1 = ((ls + ll - 1) * 8) + m[7];
+      for (b = b0; b <= b1; b++)
+      {
+         if ((b < (adr * 8)) || (b >= ((adr + length) * 8)))
+         {
+            continue;
+         }
+         pb = (simnet_getw(m + 8) * 8) + m[10] + (b - b0);
+         dp = &data[(b / 8) - adr];
+         db = b & 7;
+         /* FMMU type 2 writes outputs, type 1 reads inputs */
+         if ((m[11] == 2) && (cmd != NEX_CMD_LRD))
+         {
+            if ((*dp >> db) & 1)
+            {
+               s->mem[pb / 8] |= (uint8)(1 << (pb & 7));
+            }
+            else
+            {
+               s->mem[pb / 8] &= (uint8)~(1 << (pb & 7));
+            }
+            w = TRUE;
+         }
+         if ((m[11] == 1) && (cmd != NEX_CMD_LWR))
+         {
+            if ((s->mem[pb / 8] >> (pb & 7)) & 1)
+            {
+               *dp |= (uint8)(1 << db);
+            }
+            else
+            {
+               *dp &= (uint8)~(1 << db);
+            }
+            r = TRUE;
+         }
+      }
+   }
+
+   return (r ? 1 : 0) + (w ? ((cmd == NEX_CMD_LRW) ? 2 : 1) : 0);
+}
+
+static simnet_slavet *simnet_byaddress(simnet_segmentt *seg, uint16 adr)
+{
+   int i;
+
+   /* the master numbers the slaves from NEX_NODEOFFSET + 1 */
+   i = (int)adr - NEX_NODEOFFSET - 1;
+   if ((i >= 0) && (i < *seg->slavecount) && (simnet_getw(seg->slave[i].mem + ECT_REG_STADR) == adr))
+   {
+      return &seg->slave[i];
+   }
+   for (i = 0; i < *seg->slavecount; i++)
+   {
+      if (simnet_getw(seg->slave[i].mem + ECT_REG_STADR) == adr)
+      {
+         return &seg->slave[i];
+      }
+   }
+   return NULL;
+}
+
+/* pass a frame through all slaves */
+static void simnet_process(simnet_segmentt *seg, uint8 *frame)
+{
+   simnet_slavet *s;
+   uint8 *p, *data, cmd;
+   uint16 adp, ado, dlength, wkc;
+   boolean more;
+   int i;
+
+   p = frame + ETH_HEADERSIZE + 2;
+   do
+   {
+      cmd = p[0];
+      adp = simnet_getw(p + 2);
+      ado = simnet_getw(p + 4);
+      dlength = simnet_getw(p + 6);
+      more = (dlength & NEX_DATAGRAMFOLLOWS) ? TRUE : FALSE;
+      dlength &= 0x07ff;
+      /* NEX_HEADERSIZE includes the frame length in front of the first datagram */
+      data = p + (NEX_HEADERSIZE - NEX_ELENGTHSIZE);
+      wkc = simnet_getw(data + dlength);
+      (*seg->datagrams)++;
+      switch (cmd)
+      {
+         case NEX_CMD_FPRD:
+         case NEX_CMD_FPWR:
+         case NEX_CMD_FPRW:
+         case NEX_CMD_FRMW:
+            s = simnet_byaddress(seg, adp);
+            if (s)
+            {
+               wkc += simnet_access(seg, s, cmd, ado, dlength, data);
+            }
+            break;
+         case NEX_CMD_APRD:
+         case NEX_CMD_APWR:
+         case NEX_CMD_APRW:
+            /* every slave increments the address, the slave that sees 0 is addressed */
+            for (i = 0; i < *seg->slavecount; i++)
+            {
+               if ((uint16)(adp + i) == 0)
+               {
+                  wkc += simnet_access(seg, &seg->slave[i], cmd, ado, dlength, data);
+               }
+            }
+            adp = (uint16)(adp + *seg->slavecount);
+            break;
+         case NEX_CMD_BRD:
+         case NEX_CMD_BWR:
+            for (i = 0; i < *seg->slavecount; i++)
+            {
+               wkc += simnet_access(seg, &seg->slave[i], cmd, ado, dlength, data);
+            }
+            adp = (uint16)(adp + *seg->slavecount);
+            break;
+         case NEX_CMD_LRD:
+         case NEX_CMD_LWR:
+         case NEX_CMD_LRW:
+            for (i = 0; i < *seg->slavecount; i++)
+            {
+               wkc += simnet_logical(seg, &seg->slave[i], cmd, adp | ((uint32)ado << 16), dlength, data);
+            }
+            break;
+         default:
+            break;
+      }
+      simnet_putw(data + dlength, wkc);
+      simnet_putw(p + 2, adp);
+      p = data + dlength + NEX_WKCSIZE;
+   } while (more);
+   simnet_tick(seg);
+}
+
+/* segment a port has opened */
+static simnet_segmentt *simnet_port(nexx_portt *port)
+{
+   return simnet_list[port->sockhandle];
+}
+
+int nexx_setupnic(nexx_portt *port, const char *ifname, int secondary)
+{
+   int i, n;
+
+   if (secondary)
+   {
+      return 0;
+   }
+   pthread_mutex_lock(&simnet_listlock);
+   for (n = 0; (n < simnet_nsegment) && strcmp(simnet_list[n]->ifname, ifname); n++)
+   {
+   }
+   pthread_mutex_unlock(&simnet_listlock);
+   if (n >= simnet_nsegment)
+   {
+      return 0;
+   }
+   port->sockhandle = n;
+   port->lastidx = 0;
+   port->redstate = 0;
+   port->redport = NULL;
+   for (i = 0; i < NEX_MAXBUF; i++)
+   {
+      nex_setupheader(&(port->txbuf[i]));
+      port->rxbufstat[i] = NEX_BUF_EMPTY;
+   }
+   nex_setupheader(&(port->txbuf2));
+
+   return 1;
+}
+
+int nexx_closenic(nexx_portt *port)
+{
+   (void)port;
+   return 0;
+}
+
+void nex_setupheader(void *p)
+{
+   nex_etherheadert *bp;
+
+   bp = p;
+   bp->da0 = oshw_htons(0xffff);
+   bp->da1 = oshw_htons(0xffff);
+   bp->da2 = oshw_htons(0xffff);
+   bp->sa0 = oshw_htons(priMAC[0]);
+   bp->sa1 = oshw_htons(priMAC[1]);
+   bp->sa2 = oshw_htons(priMAC[2]);
+   bp->etype = oshw_htons(ETH_P_ECAT);
+}
+
+int nexx_getindex(nexx_portt *port)
+{
+   simnet_nett *net = simnet_port(port)->net;
+   int idx;
+   int cnt;
+
+   pthread_mutex_lock(&net->lock);
+   idx = port->lastidx + 1;
+   if (idx >= NEX_MAXBUF)
+   {
+      idx = 0;
+   }
+   cnt = 0;
+   while (((port->rxbufstat[idx] != NEX_BUF_EMPTY) || port->idxreserved[idx]) && (cnt < NEX_MAXBUF))
+   {
+      idx++;
+      cnt++;
+      if (idx >= NEX_MAXBUF)
+      {
+         idx = 0;
+      }
+   }
+   /* all busy, reuse an index but not one of a group partition like the NIC driver */
+   while (port->idxreserved[idx])
+   {
+      idx++;
+      if (idx >= NEX_MAXBUF)
+      {
+         idx = 0;
+      }
+   }
+   port->rxbufstat[idx] = NEX_BUF_ALLOC;
+   port->lastidx = idx;
+   pthread_mutex_unlock(&net->lock);
+
+   return idx;
+}
+
+void nexx_setbufstat(nexx_portt *port, int idx, int bufstat)
+{
+   simnet_nett *net = simnet_port(port)->net;
+
+   pthread_mutex_lock(&net->lock);
+   port->rxbufstat[idx] = bufstat;
+   pthread_mutex_unlock(&net->lock);
+}
+
+/* frame number in the list of single frames to drop */
+static boolean simnet_isdropped(simnet_segmentt *seg, uint32 frame)
+{
+   int i;
+
+   for (i = 0; i < SIMNET_MAXDROP; i++)
+   {
+      if (seg->dropframe[i] == frame)
+      {
+         seg->dropframe[i] = 0;
+         return TRUE;
+      }
+   }
+
+   return FALSE;
+}
+
+/* pass a frame through the slaves and queue it for the receive */
+static int simnet_outframe(simnet_segmentt *seg, nexx_portt *port, int idx)
+{
+   simnet_nett *net = seg->net;
+   simnet_framet *f;
+
+   port->rxbufstat[idx] = NEX_BUF_TX;
+   (*seg->frames)++;
+   if ((*seg->dropbefore > 0) || simnet_isdropped(seg, *seg->frames))
+   {
+      if (*seg->dropbefore > 0)
+      {
+         (*seg->dropbefore)--;
+      }
+      simnet_tick(seg);
+      return port->txbuflength[idx];
+   }
+   if (net->queuecount >= SIMNET_MAXQUEUE)
+   {
+      printf("simnet: receive queue of %s full\n", seg->ifname);
+      exit(1);
+   }
+   f = &net->queue[(net->queuehead + net->queuecount) % SIMNET_MAXQUEUE];
+   memcpy(&(f->data), &(port->txbuf[idx]), port->txbuflength[idx]);
+   simnet_process(seg, f->data);
+   if (*seg->dropafter > 0)
+   {
+      (*seg->dropafter)--;
+      return port->txbuflength[idx];
+   }
+   f->idx = idx;
+   f->length = port->txbuflength[idx];
+   f->arrival = simnet_now() + *seg->latency;
+   net->queuecount++;
+
+   return port->txbuflength[idx];
+}
+
+int nexx_outframe(nexx_portt *port, int idx, int stacknumber)
+{
+   simnet_segmentt *seg;
+   int rval;
+
+   if (stacknumber)
+   {
+      return -1;
+   }
+   seg = simnet_port(port);
+   pthread_mutex_lock(&seg->net->lock);
+   rval = simnet_outframe(seg, port, idx);
+   pthread_mutex_unlock(&seg->net->lock);
+
+   return rval;
+}
+
+int nexx_outframe_red(nexx_portt *port, int idx)
+{
+   return nexx_outframe(port, idx, 0);
+}
+
+/* non blocking receive, reads at most one frame from the queue like the NIC driver */
+static int simnet_inframe(simnet_nett *net, nexx_portt *port, int idx)
+{
+   simnet_framet *f;
+   uint8 *rxbuf;
+   uint16 l;
+   int rval = NEX_NOFRAME;
+
+   rxbuf = port->rxbuf[idx];
+   if (port->rxbufstat[idx] == NEX_BUF_RCVD)
+   {
+      l = (uint16)(rxbuf[0] + ((rxbuf[1] & 0x0f) << 8));
+      port->rxbufstat[idx] = NEX_BUF_COMPLETE;
+      return rxbuf[l] + (rxbuf[l + 1] << 8);
+   }
+   if (net->queuecount && (net->queue[net->queuehead].arrival <= simnet_now()))
+   {
+      f = &net->queue[net->queuehead];
+      net->queuehead = (net->queuehead + 1) % SIMNET_MAXQUEUE;
+      net->queuecount--;
+      rval = NEX_OTHERFRAME;
+      if (f->idx == idx)
+      {
+         memcpy(rxbuf, &(f->data[ETH_HEADERSIZE]), f->length - ETH_HEADERSIZE);
+         l = (uint16)(rxbuf[0] + ((rxbuf[1] & 0x0f) << 8));
+         rval = rxbuf[l] + (rxbuf[l + 1] << 8);
+         port->rxbufstat[idx] = NEX_BUF_COMPLETE;
+      }
+      else if (port->rxbufstat[f->idx] == NEX_BUF_TX)
+      {
+         memcpy(port->rxbuf[f->idx], &(f->data[ETH_HEADERSIZE]), f->length - ETH_HEADERSIZE);
+         port->rxbufstat[f->idx] = NEX_BUF_RCVD;
+      }
+   }
+
+   return rval;
+}
+
+int nexx_waitinframe(nexx_portt *port, int idx, int timeout)
+{
+   simnet_nett *net = simnet_port(port)->net;
+   osal_timert timer;
+   int wkc;
+
+   osal_timer_start(&timer, timeout);
+   do
+   {
+      pthread_mutex_lock(&net->lock);
+      wkc = simnet_inframe(net, port, idx);
+      pthread_mutex_unlock(&net->lock);
+   } while ((wkc <= NEX_NOFRAME) && !osal_timer_is_expired(&timer));
+
+   return wkc;
+}
+
+int nexx_srconfirm(nexx_portt *port, int idx, int timeout)
+{
+   osal_timert timer;
+   int wkc;
+
+   osal_timer_start(&timer, timeout);
+   do
+   {
+      nexx_outframe(port, idx, 0);
+      wkc = nexx_waitinframe(port, idx, (timeout < NEX_TIMEOUTRET) ? timeout : NEX_TIMEOUTRET);
+   } while ((wkc <= NEX_NOFRAME) && !osal_timer_is_expired(&timer));
+   if (wkc <= NEX_NOFRAME)
+   {
+      nexx_setbufstat(port, idx, NEX_BUF_EMPTY);
+   }
+
+   return wkc;
+}
+
+void simnet_init(int slavecount)
+{
+   simnetx_init(&simnet_segment, slavecount);
+}
+
+void simnet_identity(int position, uint32 man, uint32 id, uint32 rev)
+{
+   simnetx_identity(&simnet_segment, position, man, id, rev);
+}
+
+void simnet_links(int position, int links)
+{
+   simnetx_links(&simnet_segment, position, links);
+}
+
+void simnet_mailbox(int position, uint16 protocols, simnet_mbxhookt hook)
+{
+   simnetx_mailbox(&simnet_segment, position, protocols, hook);
+}
+
+void simnet_setdc(int position, int64 time)
+{
+   simnetx_setdc(&simnet_segment, position, time);
+}
+
+#ifdef NEX_VER1
+
+int nex_setupnic(const char *ifname, int secondary)
+{
+   return nexx_setupnic(&nexx_port, ifname, secondary);
+}
+
+int nex_closenic(void)
+{
+   return nexx_closenic(&nexx_port);
+}
+
+int nex_getindex(void)
+{
+   return nexx_getindex(&nexx_port);
+}
+
+void nex_setbufstat(int idx, int bufstat)
+{
+   nexx_setbufstat(&nexx_port, idx, bufstat);
+}
+
+int nex_outframe(int idx, int stacknumber)
+{
+   return nexx_outframe(&nexx_port, idx, stacknumber);
+}
+
+int nex_outframe_red(int idx)
+{
+   return nexx_outframe_red(&nexx_port, idx);
+}
+
+int nex_waitinframe(int idx, int timeout)
+{
+   return nexx_waitinframe(&nexx_port, idx, timeout);
+}
+
+int nex_srconfirm(int idx, int timeout)
+{
+   return nexx_srconfirm(&nexx_port, idx, timeout);
+}
+
+#endif
@@ -0,0 +1,150 @@
+/** \file
+ * \brief
+ * Headerfile for simnet.c
+ *
+ * Simulated EtherCAT segment for tests without a network. simnet.c takes the
+ * place of the NIC driver: frames sent by the master pass the simulated slaves
+ * in order and come back through a receive queue, like the frames of a real
+ * NIC. The slaves emulate the registers the master uses, the SII EEPROM, the
+ * AL state machine, the mailbox sync managers and the FMMUs of the process
+ * data.
+ *
+ * Every simulated segment is selected by the interface name the master opens,
+ * so several contexts can run on segments of their own. The globals below are
+ * the segment "simnet", further segments are made with simnet_create.
+ */
+
+#ifndef _simneth_
+#define _simneth_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "ethercat.h"
+
+/** max. number of simulated slaves */
+#define SIMNET_MAXSLAVE    2100
+/** size of ESC memory of a simulated slave */
+#define SIMNET_MEMSIZE     0x10000
+/** size of SII EEPROM of a simulated slave in bytes */
+#define SIMNET_EEPSIZE     4096
+/** start and size of the mailbox areas set by simnet_mailbox */
+#define SIMNET_MBXOUT      0x1000
+#define SIMNET_MBXIN       0x1200
+#define SIMNET_MBXSIZE     512
+/** max. number of single frames to drop */
+#define SIMNET_MAXDROP     4
+/** max. number of simulated segments, including "simnet" */
+#define SIMNET_MAXSEGMENT  16
+/** max. length of the interface name of a segment */
+#define SIMNET_MAXNAME     31
+
+typedef struct simnet_slave simnet_slavet;
+
+/** Mailbox application of a simulated slave. Called with the mailbox the
+ * master wrote, writes the response to out and sets respond if there is one.
+ */
+typedef void (*simnet_mbxhookt)(simnet_slavet *slave, const uint8 *in, uint8 *out, boolean *respond);
+
+struct simnet_slave
+{
+   /** position in the segment, 0 is the first slave */
+   uint16  position;
+   /** ESC memory, registers and process data RAM */
+   uint8   *mem;
+   /** SII EEPROM */
+   uint8   *eeprom;
+   /** frames until an EEPROM command is done, write commands take five times longer */
+   int     eepdelay;
+   /** 8 byte EEPROM reads */
+   boolean eepread64;
+   int     eepbusy;
+   boolean eeperror;
+   uint16  eepcmd;
+   uint16  eepadr;
+   /** frames until a requested AL state is reached */
+   int     alpending;
+   uint16  alrequest;
+   /** mailbox written by the master and not yet processed */
+   boolean mbxoutfull;
+   /** response ready to be read by the master */
+   boolean mbxinfull;
+   /** frames until the application takes a written mailbox */
+   int     mbxdelay;
+   int     mbxcountdown;
+   uint8   mbxout[SIMNET_MBXSIZE];
+   simnet_mbxhookt mbxhook;
+   /** LRW is counted in simnet_lrwblocked instead of executed normally */
+   boolean nolrw;
+   /** free for the mailbox application */
+   void    *user;
+};
+
+struct simnet_net;
+
+/** Simulated segment, referenced by all simnetx functions. Like the context of
+ * the master it refers to the state, for the segment "simnet" the globals.
+ */
+typedef struct simnet_segment
+{
+   /** interface name that opens the segment */
+   char           ifname[SIMNET_MAXNAME + 1];
+   /** slaves of the segment */
+   simnet_slavet  *slave;
+   /** maximum number of slaves */
+   int            maxslave;
+   int            *slavecount;
+   /** see simnet_dropbefore */
+   int            *dropbefore;
+   /** see simnet_dropafter */
+   int            *dropafter;
+   /** SIMNET_MAXDROP frame numbers, see simnet_dropframe */
+   uint32         *dropframe;
+   /** see simnet_latency */
+   int32          *latency;
+   uint32         *frames;
+   uint32         *datagrams;
+   uint32         *lrwblocked;
+   /** internal, receive queue, slaves in progress and lock */
+   struct simnet_net *net;
+} simnet_segmentt;
+
+/** the segment "simnet" */
+extern simnet_segmentt simnet_segment;
+extern simnet_slavet simnet_slave[SIMNET_MAXSLAVE];
+extern int simnet_slavecount;
+/** frames lost before they reach the first slave */
+extern int simnet_dropbefore;
+/** frames lost after the last slave, the slaves have processed them */
+extern int simnet_dropafter;
+/** numbers of single frames, counted like simnet_frames, lost before the
+ * first slave, 0 = unused */
+extern uint32 simnet_dropframe[SIMNET_MAXDROP];
+/** us from the send of a frame until it can be received */
+extern int32 simnet_latency;
+/** frames and datagrams seen by the slaves */
+extern uint32 simnet_frames;
+extern uint32 simnet_datagrams;
+/** logical datagrams that touched a slave with nolrw set and used LRW */
+extern uint32 simnet_lrwblocked;
+
+void simnet_init(int slavecount);
+void simnet_identity(int position, uint32 man, uint32 id, uint32 rev);
+void simnet_links(int position, int links);
+void simnet_mailbox(int position, uint16 protocols, simnet_mbxhookt hook);
+void simnet_setdc(int position, int64 time);
+
+simnet_segmentt *simnet_create(const char *ifname, int maxslave);
+void simnetx_init(simnet_segmentt *segment, int slavecount);
+void simnetx_identity(simnet_segmentt *segment, int position, uint32 man, uint32 id, uint32 rev);
+void simnetx_links(simnet_segmentt *segment, int position, int links);
+void simnetx_mailbox(simnet_segmentt *segment, int position, uint16 protocols, simnet_mbxhookt hook);
+void simnetx_setdc(simnet_segmentt *segment, int position, int64 time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
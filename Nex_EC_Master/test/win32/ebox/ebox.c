@@ -75,6 +75,7 @@ uint8 ob3;
 pthread_cond_t  cond  = PTHREAD_COND_INITIALIZER;
 pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 int64 integral=0;
+nex_dctunet dctune;
 uint32 cyclecount;
 in_EBOX_streamt  *in_EBOX;
 out_EBOX_streamt *out_EBOX;
@@ -109,67 +110,67 @@ void eboxtest(char *ifname)
    printf("Starting E/BOX test\n");
 
    /* initialise SOEM, bind socket to ifname */
-   if (ec_init(ifname))
+   if (nex_init(ifname))
    {
-      printf("ec_init on %s succeeded.\n",ifname);
+      printf("nex_init on %s succeeded.\n",ifname);
       /* find and auto-config slaves */
-      if ( ec_config_init(FALSE) > 0 )
+      if ( nex_config_init() > 0 )
       {
-         printf("%d slaves found and configured.\n",ec_slavecount);
+         printf("%d slaves found and configured.\n",nex_slavecount);
 
          // check if first slave is an E/BOX
-         if (( ec_slavecount >= 1 ) &&
-             (strcmp(ec_slave[1].name,"E/BOX") == 0))
+         if (( nex_slavecount >= 1 ) &&
+             (strcmp(nex_slave[1].name,"E/BOX") == 0))
          {
             // reprogram PDO mapping to set slave in stream mode
             // this can only be done in pre-OP state
             os=sizeof(ob2); ob2 = 0x1601;
-            ec_SDOwrite(1,0x1c12,01,FALSE,os,&ob2,EC_TIMEOUTRXM);
+            nex_SDOwrite(1,0x1c12,01,FALSE,os,&ob2,NEX_TIMEOUTRXM);
             os=sizeof(ob2); ob2 = 0x1a01;
-            ec_SDOwrite(1,0x1c13,01,FALSE,os,&ob2,EC_TIMEOUTRXM);
+            nex_SDOwrite(1,0x1c13,01,FALSE,os,&ob2,NEX_TIMEOUTRXM);
          }
 
-         ec_config_map(&IOmap);
+         nex_config_map(&IOmap);
 
-         ec_configdc();
+         nex_configdc();
 
          /* wait for all slaves to reach SAFE_OP state */
-         ec_statecheck(0, EC_STATE_SAFE_OP,  EC_TIMEOUTSTATE);
+         nex_statecheck(0, NEX_STATE_SAFE_OP,  NEX_TIMEOUTSTATE);
 
          /* configure DC options for every DC capable slave found in the list */
-         printf("DC capable : %d\n",ec_configdc());
+         printf("DC capable : %d\n",nex_configdc());
 
          /* check configuration */
-         if (( ec_slavecount >= 1 ) &&
-             (strcmp(ec_slave[1].name,"E/BOX") == 0)
+         if (( nex_slavecount >= 1 ) &&
+             (strcmp(nex_slave[1].name,"E/BOX") == 0)
             )
          {
             printf("E/BOX found.\n");
 
             /* connect struct pointers to slave I/O pointers */
-            in_EBOX = (in_EBOX_streamt*) ec_slave[1].inputs;
-            out_EBOX = (out_EBOX_streamt*) ec_slave[1].outputs;
+            in_EBOX = (in_EBOX_streamt*) nex_slave[1].inputs;
+            out_EBOX = (out_EBOX_streamt*) nex_slave[1].outputs;
 
-            /* read indevidual slave state and store in ec_slave[] */
-            ec_readstate();
-            for(cnt = 1; cnt <= ec_slavecount ; cnt++)
+            /* read indevidual slave state and store in nex_slave[] */
+            nex_readstate();
+            for(cnt = 1; cnt <= nex_slavecount ; cnt++)
             {
                printf("Slave:%d Name:%s Output size:%3dbits Input size:%3dbits State:%2d delay:%d.%d\n",
-                     cnt, ec_slave[cnt].name, ec_slave[cnt].Obits, ec_slave[cnt].Ibits,
-                     ec_slave[cnt].state, (int)ec_slave[cnt].pdelay, ec_slave[cnt].hasdc);
+                     cnt, nex_slave[cnt].name, nex_slave[cnt].Obits, nex_slave[cnt].Ibits,
+                     nex_slave[cnt].state, (int)nex_slave[cnt].pdelay, nex_slave[cnt].hasdc);
             }
             printf("Request operational state for all slaves\n");
 
             /* send one processdata cycle to init SM in slaves */
-            ec_send_processdata();
-            ec_receive_processdata(EC_TIMEOUTRET);
+            nex_send_processdata();
+            nex_receive_processdata(NEX_TIMEOUTRET);
 
-            ec_slave[0].state = EC_STATE_OPERATIONAL;
+            nex_slave[0].state = NEX_STATE_OPERATIONAL;
             /* request OP state for all slaves */
-            ec_writestate(0);
+            nex_writestate(0);
             /* wait for all slaves to reach OP state */
-            ec_statecheck(0, EC_STATE_OPERATIONAL,  EC_TIMEOUTSTATE);
-            if (ec_slave[0].state == EC_STATE_OPERATIONAL )
+            nex_statecheck(0, NEX_STATE_OPERATIONAL,  NEX_TIMEOUTSTATE);
+            if (nex_slave[0].state == NEX_STATE_OPERATIONAL )
             {
                printf("Operational state reached for all slaves.\n");
                ain[0] = 0;
@@ -177,15 +178,15 @@ void eboxtest(char *ifname)
                ainc = 0;
                dorun = 1;
                usleep(100000); // wait for linux to sync on DC
-               ec_dcsync0(1, TRUE, SYNC0TIME, 0); // SYNC0 on slave 1
+               nex_dcsync0(1, TRUE, SYNC0TIME, 0); // SYNC0 on slave 1
                /* acyclic loop 20ms */
                for(i = 1; i <= 200; i++)
                {
                   /* read DC difference register for slave 2 */
-   //               ec_FPRD(ec_slave[1].configadr, ECT_REG_DCSYSDIFF, sizeof(DCdiff), &DCdiff, EC_TIMEOUTRET);
+   //               nex_FPRD(nex_slave[1].configadr, ECT_REG_DCSYSDIFF, sizeof(DCdiff), &DCdiff, NEX_TIMEOUTRET);
    //               if(DCdiff<0) { DCdiff = - (int32)((uint32)DCdiff & 0x7ffffff); }
                   printf("PD cycle %5d DCtime %12lld Cnt:%3d Data: %6d %6d %6d %6d %6d %6d %6d %6d \n",
-                        cyclecount, ec_DCtime, in_EBOX->counter, in_EBOX->stream[0], in_EBOX->stream[1],
+                        cyclecount, nex_DCtime, in_EBOX->counter, in_EBOX->stream[0], in_EBOX->stream[1],
                          in_EBOX->stream[2], in_EBOX->stream[3], in_EBOX->stream[4], in_EBOX->stream[5],
                          in_EBOX->stream[98], in_EBOX->stream[99]);
                   usleep(20000);
@@ -202,27 +203,27 @@ void eboxtest(char *ifname)
          {
             printf("E/BOX not found in slave configuration.\n");
          }
-         ec_dcsync0(1, FALSE, 8000, 0); // SYNC0 off
+         nex_dcsync0(1, FALSE, 8000, 0); // SYNC0 off
          printf("Request safe operational state for all slaves\n");
-         ec_slave[0].state = EC_STATE_SAFE_OP;
+         nex_slave[0].state = NEX_STATE_SAFE_OP;
          /* request SAFE_OP state for all slaves */
-         ec_writestate(0);
+         nex_writestate(0);
          /* wait for all slaves to reach state */
-         ec_statecheck(0, EC_STATE_SAFE_OP,  EC_TIMEOUTSTATE);
-         ec_slave[0].state = EC_STATE_PRE_OP;
+         nex_statecheck(0, NEX_STATE_SAFE_OP,  NEX_TIMEOUTSTATE);
+         nex_slave[0].state = NEX_STATE_PRE_OP;
          /* request SAFE_OP state for all slaves */
-         ec_writestate(0);
+         nex_writestate(0);
          /* wait for all slaves to reach state */
-         ec_statecheck(0, EC_STATE_PRE_OP,  EC_TIMEOUTSTATE);
-         if (( ec_slavecount >= 1 ) &&
-             (strcmp(ec_slave[1].name,"E/BOX") == 0))
+         nex_statecheck(0, NEX_STATE_PRE_OP,  NEX_TIMEOUTSTATE);
+         if (( nex_slavecount >= 1 ) &&
+             (strcmp(nex_slave[1].name,"E/BOX") == 0))
          {
             // restore PDO to standard mode
             // this can only be done is pre-op state
             os=sizeof(ob2); ob2 = 0x1600;
-            ec_SDOwrite(1,0x1c12,01,FALSE,os,&ob2,EC_TIMEOUTRXM);
+            nex_SDOwrite(1,0x1c12,01,FALSE,os,&ob2,NEX_TIMEOUTRXM);
             os=sizeof(ob2); ob2 = 0x1a00;
-            ec_SDOwrite(1,0x1c13,01,FALSE,os,&ob2,EC_TIMEOUTRXM);
+            nex_SDOwrite(1,0x1c13,01,FALSE,os,&ob2,NEX_TIMEOUTRXM);
          }
          printf("Streampos %d\n", streampos);
          output_cvs("stream.txt", streampos);
@@ -233,7 +234,7 @@ void eboxtest(char *ifname)
       }
       printf("End E/BOX, close socket\n");
       /* stop SOEM, close socket */
-      ec_close();
+      nex_close();
    }
    else
    {
@@ -259,11 +260,11 @@ void add_timespec(struct timespec *ts, int64 addtime)
 }
 
 /* PI calculation to get linux time synced to DC time */
-void ec_sync(int64 reftime, int64 cycletime , int64 *offsettime)
+void nex_sync(int64 reftime, int64 cycletime , int64 sendoffset, int64 *offsettime)
 {
    int64 delta;
-   /* set linux sync point 50us later than DC sync, just as example */
-   delta = (reftime - 50000) % cycletime;
+   /* set linux sync point sendoffset later than DC sync, sendoffset from DC tuner */
+   delta = (reftime - sendoffset) % cycletime;
    if(delta> (cycletime /2)) { delta= delta - cycletime; }
    if(delta>0){ integral++; }
    if(delta<0){ integral--; }
@@ -280,6 +281,8 @@ void ecatthread( void *ptr )
    int i;
    int pcounter = 0;
    int64 cycletime;
+   int32 rtt;
+   struct timeval tr;
 
    rc = pthread_mutex_lock(&mutex);
    rc =  gettimeofday(&tp, NULL);
@@ -301,9 +304,11 @@ void ecatthread( void *ptr )
       {
          rc =  gettimeofday(&tp, NULL);
 
-         ec_send_processdata();
+         nex_send_processdata();
 
-         ec_receive_processdata(EC_TIMEOUTRET);
+         nex_receive_processdata(NEX_TIMEOUTRET);
+         gettimeofday(&tr, NULL);
+         rtt = (int32)(((tr.tv_sec - tp.tv_sec) * 1000000 + (tr.tv_usec - tp.tv_usec)) * 1000);
 
          cyclecount++;
 
@@ -331,8 +336,14 @@ void ecatthread( void *ptr )
             pcounter = in_EBOX->counter;
          }
 
+         /* update frame timing statistics and tuned send offset, start 50us after DC sync */
+         if (!dctune.cycletime)
+         {
+            nex_dctune_init(&dctune, 0, (uint32)cycletime, 50000);
+         }
+         nex_dctune_update(&dctune, rtt);
          /* calulate toff to get linux time and DC synced */
-         ec_sync(ec_DCtime, cycletime, &toff);
+         nex_sync(nex_DCtime, cycletime, dctune.sendoffset, &toff);
       }
    }
 }
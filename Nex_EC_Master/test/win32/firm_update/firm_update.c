@@ -20,90 +20,84 @@
 
 #include "ethercat.h"
 
-#define FWBUFSIZE (8 * 1024 * 1024)
-
 uint8 ob;
 uint16 ow;
 uint32 data;
 char filename[256];
-char filebuffer[FWBUFSIZE]; // 8MB buffer
+FILE *filefp;
 int filesize;
 int j;
 uint16 argslave;
+nex_FOEstatt foestat;
 
+/* open file, it is streamed to the slave without loading it in memory */
 int input_bin(char *fname, int *length)
 {
-    FILE *fp;
-
-	int cc = 0, c;
-
-    fp = fopen(fname, "rb");
-    if(fp == NULL)
-        return 0;
-	while (((c = fgetc(fp)) != EOF) && (cc < FWBUFSIZE))
-		filebuffer[cc++] = (uint8)c;
-	*length = cc;
-	fclose(fp);
+	filefp = fopen(fname, "rb");
+	if(filefp == NULL)
+		return 0;
+	fseek(filefp, 0, SEEK_END);
+	*length = (int)ftell(filefp);
+	fseek(filefp, 0, SEEK_SET);
 	return 1;
 }
 
-
 void boottest(char *ifname, uint16 slave, char *filename)
 {
 	printf("Starting firmware update example\n");
 
 	/* initialise SOEM, bind socket to ifname */
-	if (ec_init(ifname))
+	if (nex_init(ifname))
 	{
-		printf("ec_init on %s succeeded.\n",ifname);
+		printf("nex_init on %s succeeded.\n",ifname);
 		/* find and auto-config slaves */
 
 
-	    if ( ec_config_init(FALSE) > 0 )
+	    if ( nex_config_init() > 0 )
 		{
-			printf("%d slaves found and configured.\n",ec_slavecount);
+			printf("%d slaves found and configured.\n",nex_slavecount);
 
 			printf("Request init state for slave %d\n", slave);
-			ec_slave[slave].state = EC_STATE_INIT;
-			ec_writestate(slave);
+			nex_slave[slave].state = NEX_STATE_INIT;
+			nex_writestate(slave);
 
 			/* wait for slave to reach INIT state */
-			ec_statecheck(slave, EC_STATE_INIT,  EC_TIMEOUTSTATE * 4);
+			nex_statecheck(slave, NEX_STATE_INIT,  NEX_TIMEOUTSTATE * 4);
 			printf("Slave %d state to INIT.\n", slave);
 
 			/* read BOOT mailbox data, master -> slave */
-			data = ec_readeeprom(slave, ECT_SII_BOOTRXMBX, EC_TIMEOUTEEP);
-			ec_slave[slave].SM[0].StartAddr = (uint16)LO_WORD(data);
-            		ec_slave[slave].SM[0].SMlength = (uint16)HI_WORD(data);
+			data = nex_readeeprom(slave, ECT_SII_BOOTRXMBX, NEX_TIMEOUTEEP);
+			nex_slave[slave].SM[0].StartAddr = (uint16)LO_WORD(data);
+            		nex_slave[slave].SM[0].SMlength = (uint16)HI_WORD(data);
 			/* store boot write mailbox address */
-			ec_slave[slave].mbx_wo = (uint16)LO_WORD(data);
+			nex_slave[slave].mbx_wo = (uint16)LO_WORD(data);
 			/* store boot write mailbox size */
-			ec_slave[slave].mbx_l = (uint16)HI_WORD(data);
+			nex_slave[slave].mbx_l = (uint16)HI_WORD(data);
 
 			/* read BOOT mailbox data, slave -> master */
-			data = ec_readeeprom(slave, ECT_SII_BOOTTXMBX, EC_TIMEOUTEEP);
-			ec_slave[slave].SM[1].StartAddr = (uint16)LO_WORD(data);
-                        ec_slave[slave].SM[1].SMlength = (uint16)HI_WORD(data);
+			data = nex_readeeprom(slave, ECT_SII_BOOTTXMBX, NEX_TIMEOUTEEP);
+			nex_slave[slave].SM[1].StartAddr = (uint16)LO_WORD(data);
+                        nex_slave[slave].SM[1].SMlength = (uint16)HI_WORD(data);
 			/* store boot read mailbox address */
-			ec_slave[slave].mbx_ro = (uint16)LO_WORD(data);
+			nex_slave[slave].mbx_ro = (uint16)LO_WORD(data);
 			/* store boot read mailbox size */
-			ec_slave[slave].mbx_rl = (uint16)HI_WORD(data);
+			nex_slave[slave].mbx_rl = (uint16)HI_WORD(data);
 
-			printf(" SM0 A:%4.4x L:%4d F:%8.8x\n", ec_slave[slave].SM[0].StartAddr, ec_slave[slave].SM[0].SMlength,
-			    (int)ec_slave[slave].SM[0].SMflags);
-			printf(" SM1 A:%4.4x L:%4d F:%8.8x\n", ec_slave[slave].SM[1].StartAddr, ec_slave[slave].SM[1].SMlength,
-			    (int)ec_slave[slave].SM[1].SMflags);
+			printf(" SM0 A:%4.4x L:%4d F:%8.8x\n", nex_slave[slave].SM[0].StartAddr, nex_slave[slave].SM[0].SMlength,
+			    (int)nex_slave[slave].SM[0].SMflags);
+			printf(" SM1 A:%4.4x L:%4d F:%8.8x\n", nex_slave[slave].SM[1].StartAddr, nex_slave[slave].SM[1].SMlength,
+			    (int)nex_slave[slave].SM[1].SMflags);
 			/* program SM0 mailbox in for slave */
-			ec_FPWR (ec_slave[slave].configadr, ECT_REG_SM0, sizeof(ec_smt), &ec_slave[slave].SM[0], EC_TIMEOUTRET);
+			nex_FPWR (nex_slave[slave].configadr, ECT_REG_SM0, sizeof(nex_smt), &nex_slave[slave].SM[0], NEX_TIMEOUTRET);
 			/* program SM1 mailbox out for slave */
-			ec_FPWR (ec_slave[slave].configadr, ECT_REG_SM1, sizeof(ec_smt), &ec_slave[slave].SM[1], EC_TIMEOUTRET);
+			nex_FPWR (nex_slave[slave].configadr, ECT_REG_SM1, sizeof(nex_smt), &nex_slave[slave].SM[1], NEX_TIMEOUTRET);
 
 			printf("Request BOOT state for slave %d\n", slave);
-			ec_slave[slave].state = EC_STATE_BOOT;
-			ec_writestate(slave);
+			nex_slave[slave].state = NEX_STATE_BOOT;
+			nex_writestate(slave);
 
 			/* wait for slave to reach BOOT state */
-			if (ec_statecheck(slave, EC_STATE_BOOT,  EC_TIMEOUTSTATE * 10) == EC_STATE_BOOT)
+			if (nex_statecheck(slave, NEX_STATE_BOOT,  NEX_TIMEOUTSTATE * 10) == NEX_STATE_BOOT)
 			{
 				printf("Slave %d state to BOOT.\n", slave);
 
@@ -111,11 +105,14 @@ void boottest(char *ifname, uint16 slave, char *filename)
 				{
 					printf("File read OK, %d bytes.\n",filesize);
 					printf("FoE write....");
-					j = ec_FOEwrite(slave, filename, 0, filesize , &filebuffer, EC_TIMEOUTSTATE);
+					j = nex_FOEwrite_stream(slave, filename, 0, nexx_FOEstream_fread, filefp, &foestat, NEX_TIMEOUTSTATE);
 					printf("result %d.\n",j);
+					printf("%u bytes in %u packets, %u ms, %u bytes/s\n", foestat.bytes, foestat.packets,
+						foestat.elapsed / 1000, foestat.throughput);
+					fclose(filefp);
 					printf("Request init state for slave %d\n", slave);
-					ec_slave[slave].state = EC_STATE_INIT;
-					ec_writestate(slave);
+					nex_slave[slave].state = NEX_STATE_INIT;
+					nex_writestate(slave);
 				}
 				else
 				    printf("File not read OK.\n");
@@ -128,7 +125,7 @@ void boottest(char *ifname, uint16 slave, char *filename)
 		}
 		printf("End firmware update example, close socket\n");
 		/* stop SOEM, close socket */
-		ec_close();
+		nex_close();
 	}
 	else
 	{